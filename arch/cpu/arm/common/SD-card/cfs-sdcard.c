@@ -65,13 +65,14 @@ cfs_open (const char *name, int flags)
   return fd;
 }
 
-void
+int
 cfs_close(int fd)
 {
   File *file = get_file(fd);
-  if (!file) return;
+  if (!file) return -1;
   file_fclose(file);
   fs_flushFs(efs_sdcard_get_fs());
+  return 0;
 }
 
 int
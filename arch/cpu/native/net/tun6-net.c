@@ -65,6 +65,19 @@
 #include "net/netstack.h"
 #include "net/packetbuf.h"
 
+/*
+ * The largest number of packets read from the tun device each time it is
+ * readable. Under load, draining the device queue in one wakeup saves a
+ * pass through the main loop for every packet. The packets are handed to
+ * uIP one at a time, so events posted while handling a batch must fit in
+ * the event queue of the process module.
+ */
+#ifdef TUN6_NET_CONF_BATCH_SIZE
+#define TUN6_NET_BATCH_SIZE TUN6_NET_CONF_BATCH_SIZE
+#else
+#define TUN6_NET_BATCH_SIZE 16
+#endif
+
 static const char *config_ipaddr = "fd00::1/64";
 /* Allocate some bytes in RAM and copy the string */
 static char config_tundev[IFNAMSIZ + 1] = "tun0";
@@ -219,6 +232,11 @@ tun_init()
 
   LOG_INFO("Tun open:%d\n", tunfd);
 
+  /* Reads stop at an empty device queue instead of blocking */
+  if(fcntl(tunfd, F_SETFL, fcntl(tunfd, F_GETFL) | O_NONBLOCK) == -1) {
+    err(1, "tun_init: fcntl");
+  }
+
   select_set_callback(tunfd, &tun_select_callback);
 
   fprintf(stderr, "opened %s device ``/dev/%s''\n",
@@ -237,6 +255,11 @@ tun_output(uint8_t *data, int len)
 {
   /* fprintf(stderr, "*** Writing to tun...%d\n", len); */
   if(tunfd != -1 && write(tunfd, data, len) != len) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      /* The device queue is full, drop the packet */
+      LOG_WARN("tun_output: queue full, dropping %d bytes\n", len);
+      return -1;
+    }
     err(1, "serial_to_tun: write");
     return -1;
   }
@@ -254,6 +277,10 @@ tun_input(unsigned char *data, int maxlen)
   }
 
   if((size = read(tunfd, data, maxlen)) == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      /* No more packets queued */
+      return 0;
+    }
     err(1, "tun_input: read");
   }
   return size;
@@ -290,6 +317,7 @@ static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
   int size;
+  int count;
 
   if(tunfd == -1) {
     /* tun is not open */
@@ -299,10 +327,16 @@ handle_fd(fd_set *rset, fd_set *wset)
   LOG_INFO("Tun6-handle FD\n");
 
   if(FD_ISSET(tunfd, rset)) {
-    size = tun_input(uip_buf, sizeof(uip_buf));
-    LOG_DBG("TUN data incoming read:%d\n", size);
-    uip_len = size;
-    tcpip_input();
+    /* Drain the device queue, a batch of packets at most */
+    for(count = 0; count < TUN6_NET_BATCH_SIZE; count++) {
+      size = tun_input(uip_buf, sizeof(uip_buf));
+      if(size <= 0) {
+        break;
+      }
+      LOG_DBG("TUN data incoming read:%d\n", size);
+      uip_len = size;
+      tcpip_input();
+    }
   }
 }
 #endif /*  __CYGWIN_ */
@@ -78,10 +78,11 @@ cfs_open(const char *n, int f)
   }
 }
 /*---------------------------------------------------------------------------*/
-void
+int
 cfs_close(int f)
 {
   file.flag = FLAG_FILE_CLOSED;
+  return 0;
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -54,7 +54,11 @@
 #define COFFEE_LOG_DIVISOR		4
 #define COFFEE_LOG_SIZE			8192
 #define COFFEE_LOG_TABLE_LIMIT		256
+#ifdef COFFEE_CONF_MICRO_LOGS
+#define COFFEE_MICRO_LOGS		COFFEE_CONF_MICRO_LOGS
+#else
 #define COFFEE_MICRO_LOGS		0
+#endif
 
 #define COFFEE_WRITE(buf, size, offset)				\
 		xmem_pwrite((char *)(buf), (size), COFFEE_START + (offset))
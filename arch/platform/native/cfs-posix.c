@@ -67,10 +67,10 @@ cfs_open(const char *n, int f)
   return -1;
 }
 /*---------------------------------------------------------------------------*/
-void
+int
 cfs_close(int f)
 {
-  close(f);
+  return close(f);
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -45,6 +45,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdlib.h>
 #include <sys/select.h>
 #include <errno.h>
 
@@ -52,6 +53,10 @@
 #include "net/wpcap-drv.h"
 #endif /* __CYGWIN__ */
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif /* __linux__ */
+
 #include "contiki.h"
 #include "net/netstack.h"
 
@@ -81,8 +86,8 @@
  */
 
 /*
- * Defines the maximum number of file descriptors monitored by the platform
- * main loop.
+ * Defines the initial size of the table of file descriptors monitored by
+ * the platform main loop. The table grows as needed, up to FD_SETSIZE.
  */
 #ifdef SELECT_CONF_MAX
 #define SELECT_MAX SELECT_CONF_MAX
@@ -91,8 +96,10 @@
 #endif
 
 /*
- * Defines the timeout (in msec) of the select operation if no monitored file
- * descriptors becomes ready.
+ * Defines the longest time (in msec) that the platform main loop waits for
+ * a monitored file descriptor to become ready. The loop wakes up earlier
+ * when the next event timer expires. The bound is for the code that polls
+ * timers without an event timer.
  */
 #ifdef SELECT_CONF_TIMEOUT
 #define SELECT_TIMEOUT SELECT_CONF_TIMEOUT
@@ -108,11 +115,41 @@
 #else
 #define SELECT_STDIN 1
 #endif
+
+/*
+ * Waits for the monitored file descriptors with epoll(7) instead of
+ * select(2). The file descriptors are registered with the kernel once,
+ * and only the ready ones are handled. Linux only.
+ */
+#ifdef SELECT_CONF_EPOLL
+#define SELECT_EPOLL SELECT_CONF_EPOLL
+#elif defined(__linux__)
+#define SELECT_EPOLL 1
+#else
+#define SELECT_EPOLL 0
+#endif
 /** @} */
 /*---------------------------------------------------------------------------*/
 
-static const struct select_callback *select_callback[SELECT_MAX];
-static int select_max = 0;
+struct select_entry {
+  const struct select_callback *callback;
+#if SELECT_EPOLL
+  /* The events that the file descriptor is registered for */
+  uint32_t events;
+  /* Set for a file that epoll cannot monitor, such as a regular file.
+     Such a file is always ready, as with select(). */
+  uint8_t always_ready;
+#endif /* SELECT_EPOLL */
+};
+
+static struct select_entry *select_table;
+static int select_size;
+static int select_max = -1;
+
+#if SELECT_EPOLL
+#define EPOLL_EVENTS 16
+static int epoll_fd = -1;
+#endif /* SELECT_EPOLL */
 
 #ifdef PLATFORM_CONF_MAC_ADDR
 static uint8_t mac_addr[] = PLATFORM_CONF_MAC_ADDR;
@@ -124,33 +161,62 @@ static uint8_t mac_addr[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
 int
 select_set_callback(int fd, const struct select_callback *callback)
 {
-  int i;
-  if(fd >= 0 && fd < SELECT_MAX) {
-    /* Check that the callback functions are set */
-    if(callback != NULL &&
-       (callback->set_fd == NULL || callback->handle_fd == NULL)) {
-      callback = NULL;
+  struct select_entry *table;
+  int size;
+
+  if(fd < 0 || fd >= FD_SETSIZE) {
+    return 0;
+  }
+
+  /* Check that the callback functions are set */
+  if(callback != NULL &&
+     (callback->set_fd == NULL || callback->handle_fd == NULL)) {
+    callback = NULL;
+  }
+
+  if(fd >= select_size) {
+    if(callback == NULL) {
+      return 1;
+    }
+    size = select_size > 0 ? select_size : SELECT_MAX;
+    while(size <= fd) {
+      size *= 2;
+    }
+    if(size > FD_SETSIZE) {
+      size = FD_SETSIZE;
+    }
+    table = realloc(select_table, size * sizeof(struct select_entry));
+    if(table == NULL) {
+      return 0;
     }
+    memset(&table[select_size], 0,
+           (size - select_size) * sizeof(struct select_entry));
+    select_table = table;
+    select_size = size;
+  }
 
-    select_callback[fd] = callback;
+#if SELECT_EPOLL
+  if(select_table[fd].events != 0 && !select_table[fd].always_ready) {
+    /* Fails if the file descriptor has been closed, which removed it */
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+  }
+  select_table[fd].events = 0;
+  select_table[fd].always_ready = 0;
+#endif /* SELECT_EPOLL */
 
-    /* Update fd max */
-    if(callback != NULL) {
-      if(fd > select_max) {
-        select_max = fd;
-      }
-    } else {
-      select_max = 0;
-      for(i = SELECT_MAX - 1; i > 0; i--) {
-        if(select_callback[i] != NULL) {
-          select_max = i;
-          break;
-        }
-      }
+  select_table[fd].callback = callback;
+
+  /* Update fd max */
+  if(callback != NULL) {
+    if(fd > select_max) {
+      select_max = fd;
+    }
+  } else if(fd == select_max) {
+    while(select_max >= 0 && select_table[select_max].callback == NULL) {
+      select_max--;
     }
-    return 1;
   }
-  return 0;
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
 #if SELECT_STDIN
@@ -171,9 +237,15 @@ static void
 stdin_handle_fd(fd_set *rset, fd_set *wset)
 {
   char c;
+  ssize_t len;
+
   if(FD_ISSET(STDIN_FILENO, rset)) {
-    if(read(STDIN_FILENO, &c, 1) > 0) {
+    len = read(STDIN_FILENO, &c, 1);
+    if(len > 0) {
       input_handler(c);
+    } else if(len == 0) {
+      /* Stop monitoring the input at its end, where it is always ready */
+      select_set_callback(STDIN_FILENO, NULL);
     }
   }
 }
@@ -286,6 +358,176 @@ platform_init_stage_three()
   setvbuf(stdout, (char *)NULL, _IONBF, 0);
 }
 /*---------------------------------------------------------------------------*/
+/* Returns the time in msec until the next event timer expires */
+static int
+select_timeout(void)
+{
+  clock_time_t now, next;
+
+  if(etimer_pending()) {
+    now = clock_time();
+    next = etimer_next_expiration_time();
+    if((long)(next - now) <= 0) {
+      return 0;
+    }
+    if(next - now < (clock_time_t)SELECT_TIMEOUT * CLOCK_SECOND / 1000) {
+      return ((next - now) * 1000 + CLOCK_SECOND - 1) / CLOCK_SECOND;
+    }
+  }
+  return SELECT_TIMEOUT;
+}
+/*---------------------------------------------------------------------------*/
+#if SELECT_EPOLL
+/* Registers the events that the callback of a file descriptor asks for */
+static void
+epoll_update(int fd, uint32_t events)
+{
+  struct select_entry *entry = &select_table[fd];
+  struct epoll_event ev;
+  int op;
+
+  if(events == entry->events) {
+    return;
+  }
+
+  if(!entry->always_ready) {
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    op = entry->events == 0 ? EPOLL_CTL_ADD :
+      events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+    if(epoll_ctl(epoll_fd, op, fd, &ev) < 0) {
+      if(errno == ENOENT && op == EPOLL_CTL_MOD) {
+        /* The file descriptor has been closed and opened again */
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+      } else if(errno == EPERM) {
+        entry->always_ready = 1;
+      } else if(op != EPOLL_CTL_DEL) {
+        perror("epoll_ctl");
+        return;
+      }
+    }
+  }
+  entry->events = events;
+}
+/*---------------------------------------------------------------------------*/
+static void
+platform_wait(int timeout)
+{
+  struct epoll_event events[EPOLL_EVENTS];
+  fd_set fdr;
+  fd_set fdw;
+  uint32_t wanted;
+  int ready;
+  int fd;
+  int i;
+
+  if(epoll_fd < 0) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(epoll_fd < 0) {
+      perror("epoll_create1");
+      exit(1);
+    }
+  }
+
+  /* The callbacks tell which events they wait for at the moment */
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  for(fd = 0; fd <= select_max; fd++) {
+    wanted = 0;
+    if(select_table[fd].callback != NULL &&
+       select_table[fd].callback->set_fd(&fdr, &fdw)) {
+      wanted = (FD_ISSET(fd, &fdr) ? EPOLLIN : 0) |
+        (FD_ISSET(fd, &fdw) ? EPOLLOUT : 0);
+    }
+    epoll_update(fd, wanted);
+    if(wanted != 0 && select_table[fd].always_ready) {
+      timeout = 0;
+    }
+  }
+
+  ready = epoll_wait(epoll_fd, events, EPOLL_EVENTS, timeout);
+  if(ready < 0) {
+    if(errno != EINTR) {
+      perror("epoll_wait");
+    }
+    ready = 0;
+  }
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  for(i = 0; i < ready; i++) {
+    fd = events[i].data.fd;
+    wanted = select_table[fd].events;
+    if((wanted & EPOLLIN) &&
+       (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+      FD_SET(fd, &fdr);
+    }
+    if((wanted & EPOLLOUT) &&
+       (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR))) {
+      FD_SET(fd, &fdw);
+    }
+  }
+  for(fd = 0; fd <= select_max; fd++) {
+    if(select_table[fd].always_ready) {
+      if(select_table[fd].events & EPOLLIN) {
+        FD_SET(fd, &fdr);
+      }
+      if(select_table[fd].events & EPOLLOUT) {
+        FD_SET(fd, &fdw);
+      }
+    }
+  }
+
+  /* Only the callbacks of the ready file descriptors are called */
+  for(fd = 0; fd <= select_max; fd++) {
+    if(select_table[fd].callback != NULL &&
+       (FD_ISSET(fd, &fdr) || FD_ISSET(fd, &fdw))) {
+      select_table[fd].callback->handle_fd(&fdr, &fdw);
+    }
+  }
+}
+#else /* SELECT_EPOLL */
+/*---------------------------------------------------------------------------*/
+static void
+platform_wait(int timeout)
+{
+  fd_set fdr;
+  fd_set fdw;
+  int maxfd;
+  int i;
+  int retval;
+  struct timeval tv;
+
+  tv.tv_sec = timeout / 1000;
+  tv.tv_usec = (timeout % 1000) * 1000;
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  maxfd = 0;
+  for(i = 0; i <= select_max; i++) {
+    if(select_table[i].callback != NULL &&
+       select_table[i].callback->set_fd(&fdr, &fdw)) {
+      maxfd = i;
+    }
+  }
+
+  retval = select(maxfd + 1, &fdr, &fdw, NULL, &tv);
+  if(retval < 0) {
+    if(errno != EINTR) {
+      perror("select");
+    }
+  } else if(retval > 0) {
+    /* timeout => retval == 0 */
+    for(i = 0; i <= maxfd; i++) {
+      if(select_table[i].callback != NULL) {
+        select_table[i].callback->handle_fd(&fdr, &fdw);
+      }
+    }
+  }
+}
+#endif /* SELECT_EPOLL */
+/*---------------------------------------------------------------------------*/
 void
 platform_main_loop()
 {
@@ -293,39 +535,11 @@ platform_main_loop()
   select_set_callback(STDIN_FILENO, &stdin_fd);
 #endif /* SELECT_STDIN */
   while(1) {
-    fd_set fdr;
-    fd_set fdw;
-    int maxfd;
-    int i;
-    int retval;
-    struct timeval tv;
-
-    retval = process_run();
-
-    tv.tv_sec = retval ? 0 : SELECT_TIMEOUT / 1000;
-    tv.tv_usec = retval ? 1 : (SELECT_TIMEOUT * 1000) % 1000000;
-
-    FD_ZERO(&fdr);
-    FD_ZERO(&fdw);
-    maxfd = 0;
-    for(i = 0; i <= select_max; i++) {
-      if(select_callback[i] != NULL && select_callback[i]->set_fd(&fdr, &fdw)) {
-        maxfd = i;
-      }
-    }
-
-    retval = select(maxfd + 1, &fdr, &fdw, NULL, &tv);
-    if(retval < 0) {
-      if(errno != EINTR) {
-        perror("select");
-      }
-    } else if(retval > 0) {
-      /* timeout => retval == 0 */
-      for(i = 0; i <= maxfd; i++) {
-        if(select_callback[i] != NULL) {
-          select_callback[i]->handle_fd(&fdr, &fdw);
-        }
-      }
+    /* Do not wait while there are events to process */
+    if(process_run()) {
+      platform_wait(0);
+    } else {
+      platform_wait(select_timeout());
     }
 
     etimer_request_poll();
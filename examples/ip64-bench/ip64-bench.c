@@ -0,0 +1,566 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Benchmark of the NAT64 translation of ip64. The program
+ *         translates UDP and TCP packets of a growing number of concurrent
+ *         flows, and then of growing sizes, in both directions. It replays
+ *         a set of prepared packets to measure the time of a translation.
+ *         It checks the addresses,
+ *         ports and checksums of every translated packet, the per-flow
+ *         counters and the expiry of the flows.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "ip64/ip64.h"
+#include "ip64/ip64-addrmap.h"
+#include "net/ipv6/ip64-addr.h"
+#include "lib/list.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define BENCH_MAX_FLOWS   1024
+#define BENCH_PACKETS     100000
+#define BENCH_PAYLOAD     32
+#define BENCH_MAX_PAYLOAD 1024
+#define BENCH_REPLAY      64
+#define BENCH_FIRST_PORT  30000
+#define BENCH_SERVER_PORT 5683
+/* Longer than a turn of the wheel set in project-conf.h */
+#define BENCH_LONG_LIFETIME (CLOCK_SECOND * 5 / 2)
+
+#define IPV6_HDRLEN 40
+#define IPV4_HDRLEN 20
+#define UDP_HDRLEN  8
+#define TCP_HDRLEN  20
+#define PROTO_TCP   6
+#define PROTO_UDP   17
+/*---------------------------------------------------------------------------*/
+PROCESS(ip64_bench_process, "ip64 benchmark");
+AUTOSTART_PROCESSES(&ip64_bench_process);
+/*---------------------------------------------------------------------------*/
+static const uint16_t steps[] = { 16, 64, 256, BENCH_MAX_FLOWS };
+static const uint16_t sizes[] = { BENCH_PAYLOAD, 256, BENCH_MAX_PAYLOAD };
+
+struct flow {
+  uip_ip6addr_t addr;
+  uint16_t port;
+  uint16_t mapped_port;
+  uint8_t proto;
+  uint32_t packets;
+  uint32_t bytes;
+};
+
+static struct flow flows[BENCH_MAX_FLOWS];
+static uint16_t active;
+static uip_ip4addr_t hostaddr;
+static uip_ip4addr_t server;
+static uint8_t packet[UIP_BUFSIZE];
+static uint8_t result[UIP_BUFSIZE];
+static uint16_t payload_len = BENCH_PAYLOAD;
+/* Corrupt the payload of the next packet after its checksum */
+static uint8_t corrupt;
+static uint8_t replay[BENCH_REPLAY][UIP_BUFSIZE];
+static uint16_t replay_len[BENCH_REPLAY];
+static struct flow *replay_flow[BENCH_REPLAY];
+static unsigned long errors;
+static uint32_t random_state = 1;
+/*---------------------------------------------------------------------------*/
+static unsigned
+next_random(void)
+{
+  random_state = random_state * 1103515245UL + 12345;
+  return (unsigned)(random_state >> 16);
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+sum16(uint32_t sum, const uint8_t *data, uint16_t len)
+{
+  uint16_t i;
+
+  for(i = 0; i + 1 < len; i += 2) {
+    sum += (data[i] << 8) | data[i + 1];
+  }
+  if(len & 1) {
+    sum += data[len - 1] << 8;
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+fold(uint32_t sum)
+{
+  while(sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return (uint16_t)sum;
+}
+/*---------------------------------------------------------------------------*/
+/* The TCP or UDP checksum over an IPv6 or IPv4 pseudo header */
+static uint16_t
+transport_checksum(uint8_t proto, const uint8_t *addrs, uint8_t addrs_len,
+                   const uint8_t *transport, uint16_t len)
+{
+  uint32_t sum;
+
+  sum = sum16(0, addrs, addrs_len) + proto + len;
+  return fold(sum16(sum, transport, len));
+}
+/*---------------------------------------------------------------------------*/
+static void
+set16(uint8_t *p, uint16_t value)
+{
+  p[0] = value >> 8;
+  p[1] = value & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get16(const uint8_t *p)
+{
+  return (p[0] << 8) | p[1];
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+header_len(uint8_t proto)
+{
+  return proto == PROTO_TCP ? TCP_HDRLEN : UDP_HDRLEN;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+checksum_field(uint8_t proto, uint8_t *transport)
+{
+  return proto == PROTO_TCP ? &transport[16] : &transport[6];
+}
+/*---------------------------------------------------------------------------*/
+/* Fills a transport header and payload, with a zero checksum */
+static uint16_t
+fill_transport(uint8_t proto, uint8_t *transport,
+               uint16_t srcport, uint16_t destport, uint8_t seed)
+{
+  uint16_t i, len;
+
+  len = header_len(proto);
+  memset(transport, 0, len);
+  set16(&transport[0], srcport);
+  set16(&transport[2], destport);
+  if(proto == PROTO_TCP) {
+    set16(&transport[4], seed);
+    transport[12] = (TCP_HDRLEN / 4) << 4;
+    /* ACK */
+    transport[13] = 0x10;
+    set16(&transport[14], 1024);
+  } else {
+    set16(&transport[4], UDP_HDRLEN + payload_len);
+  }
+  for(i = 0; i < payload_len; i++) {
+    transport[len + i] = seed + i;
+  }
+  return len + payload_len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_checksum(uint8_t proto, const uint8_t *addrs, uint8_t addrs_len,
+             uint8_t *transport, uint16_t len)
+{
+  set16(checksum_field(proto, transport),
+        ~transport_checksum(proto, addrs, addrs_len, transport, len));
+  if(corrupt) {
+    transport[len - 1] ^= 0x01;
+    corrupt = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* An IPv6 packet from a flow to the server on the IPv4 network */
+static uint16_t
+make_ipv6_packet(const struct flow *f, uint8_t seed)
+{
+  uip_ip6addr_t dest;
+  uint8_t *transport = &packet[IPV6_HDRLEN];
+  uint16_t len;
+
+  ip64_addr_4to6(&server, &dest);
+  memset(packet, 0, IPV6_HDRLEN);
+  len = fill_transport(f->proto, transport, f->port, BENCH_SERVER_PORT, seed);
+  packet[0] = 0x60;
+  set16(&packet[4], len);
+  packet[6] = f->proto;
+  packet[7] = 64;
+  memcpy(&packet[8], &f->addr, sizeof(uip_ip6addr_t));
+  memcpy(&packet[24], &dest, sizeof(uip_ip6addr_t));
+  set_checksum(f->proto, &packet[8], 32, transport, len);
+  return IPV6_HDRLEN + len;
+}
+/*---------------------------------------------------------------------------*/
+/* The IPv4 reply of the server to a mapped port */
+static uint16_t
+make_ipv4_packet(const struct flow *f, uint8_t seed)
+{
+  uint8_t *transport = &packet[IPV4_HDRLEN];
+  uint16_t len;
+
+  memset(packet, 0, IPV4_HDRLEN);
+  len = fill_transport(f->proto, transport,
+                       BENCH_SERVER_PORT, f->mapped_port, seed);
+  packet[0] = 0x45;
+  set16(&packet[2], IPV4_HDRLEN + len);
+  packet[8] = 64;
+  packet[9] = f->proto;
+  memcpy(&packet[12], &server, sizeof(uip_ip4addr_t));
+  memcpy(&packet[16], &hostaddr, sizeof(uip_ip4addr_t));
+  set16(&packet[10], ~fold(sum16(0, packet, IPV4_HDRLEN)));
+  set_checksum(f->proto, &packet[12], 8, transport, len);
+  return IPV4_HDRLEN + len;
+}
+/*---------------------------------------------------------------------------*/
+/* Translates the IPv6 packet of a flow to IPv4 and checks the result */
+static int
+check_6to4(struct flow *f, uint16_t len)
+{
+  uint16_t transport_len;
+  int ipv4len;
+  uint8_t *transport = &result[IPV4_HDRLEN];
+
+  transport_len = len - IPV6_HDRLEN;
+  ipv4len = ip64_6to4(packet, len, result);
+  if(ipv4len != IPV4_HDRLEN + transport_len) {
+    return ipv4len;
+  }
+  if(fold(sum16(0, result, IPV4_HDRLEN)) != 0xffff ||
+     transport_checksum(f->proto, &result[12], 8,
+                        transport, transport_len) != 0xffff) {
+    return -1;
+  }
+  if(memcmp(&result[12], &hostaddr, sizeof(uip_ip4addr_t)) != 0 ||
+     memcmp(&result[16], &server, sizeof(uip_ip4addr_t)) != 0 ||
+     get16(&transport[2]) != BENCH_SERVER_PORT) {
+    printf("6to4 of port %u: bad addresses\n", f->port);
+    errors++;
+  }
+  if(f->mapped_port == 0) {
+    f->mapped_port = get16(&transport[0]);
+  } else if(get16(&transport[0]) != f->mapped_port) {
+    printf("6to4 of port %u: mapped port %u, expected %u\n",
+           f->port, get16(&transport[0]), f->mapped_port);
+    errors++;
+  }
+  f->packets++;
+  f->bytes += len;
+  return ipv4len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+flow_6to4(struct flow *f)
+{
+  return check_6to4(f, make_ipv6_packet(f, next_random()));
+}
+/*---------------------------------------------------------------------------*/
+/* Translates the IPv4 reply to a flow to IPv6 and checks the result */
+static int
+check_4to6(struct flow *f, uint16_t len)
+{
+  uint16_t transport_len;
+  int ipv6len;
+  uint8_t *transport = &result[IPV6_HDRLEN];
+
+  transport_len = len - IPV4_HDRLEN;
+  ipv6len = ip64_4to6(packet, len, result);
+  if(ipv6len != IPV6_HDRLEN + transport_len) {
+    return ipv6len;
+  }
+  if(transport_checksum(f->proto, &result[8], 32,
+                        transport, transport_len) != 0xffff) {
+    return -1;
+  }
+  if(memcmp(&result[24], &f->addr, sizeof(uip_ip6addr_t)) != 0 ||
+     get16(&transport[2]) != f->port) {
+    printf("4to6 of port %u: bad destination\n", f->mapped_port);
+    errors++;
+  }
+  return ipv6len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+flow_4to6(struct flow *f)
+{
+  return check_4to6(f, make_ipv4_packet(f, next_random()));
+}
+/*---------------------------------------------------------------------------*/
+/* Translates a packet of a flow in each direction and checks that they
+   are translated with a good checksum */
+static void
+translate(struct flow *f)
+{
+  if(flow_6to4(f) <= 0) {
+    printf("6to4 of port %u failed\n", f->port);
+    errors++;
+  }
+  if(flow_4to6(f) <= 0) {
+    printf("4to6 of port %u failed\n", f->mapped_port);
+    errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_flows(void)
+{
+  uint16_t i;
+
+  for(i = 0; i < BENCH_MAX_FLOWS; i++) {
+    uip_ip6addr(&flows[i].addr, 0xfd00, 0, 0, 0, 0, 0, i >> 4, i & 0x0f);
+    flows[i].port = BENCH_FIRST_PORT + i % 7;
+    flows[i].proto = (i & 1) ? PROTO_TCP : PROTO_UDP;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the counters of each mapping match the flow */
+static void
+check_counters(void)
+{
+  struct ip64_addrmap_entry *m;
+  uint16_t i, found = 0;
+
+  for(m = ip64_addrmap_list(); m != NULL; m = list_item_next(m)) {
+    for(i = 0; i < active; i++) {
+      if(flows[i].mapped_port == m->mapped_port) {
+        break;
+      }
+    }
+    if(i == active) {
+      printf("Unknown mapping of port %u\n", m->mapped_port);
+      errors++;
+      continue;
+    }
+    found++;
+    if(m->ip6to4 != flows[i].packets || m->ip6to4_bytes != flows[i].bytes) {
+      printf("Mapping of port %u counted %lu packets %lu bytes,"
+             " expected %lu %lu\n", m->mapped_port,
+             (unsigned long)m->ip6to4, (unsigned long)m->ip6to4_bytes,
+             (unsigned long)flows[i].packets, (unsigned long)flows[i].bytes);
+      errors++;
+    }
+  }
+  if(found != active) {
+    printf("%u mappings, expected %u\n", found, active);
+    errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Prepares packets of random flows to replay, with a make function */
+static void
+prepare_replay(uint16_t (*make)(const struct flow *f, uint8_t seed))
+{
+  uint16_t r;
+
+  for(r = 0; r < BENCH_REPLAY; r++) {
+    replay_flow[r] = &flows[next_random() % active];
+    replay_len[r] = make(replay_flow[r], next_random());
+    memcpy(replay[r], packet, replay_len[r]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Replays the prepared packets through a translation and returns the mean
+   time, and then checks the translation of each packet */
+static unsigned long
+replay_packets(int (*translate)(const uint8_t *, const uint16_t, uint8_t *),
+               int (*check)(struct flow *f, uint16_t len),
+               uint8_t ip6to4)
+{
+  clock_time_t start;
+  unsigned long i, ns;
+  uint16_t r;
+
+  start = clock_time();
+  for(i = 0; i < BENCH_PACKETS; i++) {
+    r = i % BENCH_REPLAY;
+    if(translate(replay[r], replay_len[r], result) <= 0) {
+      errors++;
+    }
+    if(ip6to4) {
+      replay_flow[r]->packets++;
+      replay_flow[r]->bytes += replay_len[r];
+    }
+  }
+  ns = (unsigned long)(clock_time() - start) *
+    (1000000000UL / CLOCK_SECOND) / BENCH_PACKETS;
+
+  for(r = 0; r < BENCH_REPLAY; r++) {
+    memcpy(packet, replay[r], replay_len[r]);
+    if(check(replay_flow[r], replay_len[r]) <= 0) {
+      printf("Translation of a packet of port %u failed\n",
+             replay_flow[r]->port);
+      errors++;
+    }
+  }
+  return ns;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_step(void)
+{
+  unsigned long ns_6to4, ns_4to6;
+
+  prepare_replay(make_ipv6_packet);
+  ns_6to4 = replay_packets(ip64_6to4, check_6to4, 1);
+  prepare_replay(make_ipv4_packet);
+  ns_4to6 = replay_packets(ip64_4to6, check_4to6, 0);
+
+  check_counters();
+
+  printf("%4u flows, %4u byte payloads: 6to4 %5lu ns, 4to6 %5lu ns\n",
+         active, payload_len, ns_6to4, ns_4to6);
+}
+/*---------------------------------------------------------------------------*/
+/* A corrupted packet is dropped, or translated with a bad checksum */
+static void
+check_corrupted(void)
+{
+  int expected;
+  uint8_t i;
+
+  expected = IP64_VERIFY_CHECKSUM ? 0 : -1;
+  for(i = 0; i < 2; i++) {
+    corrupt = 1;
+    if(flow_6to4(&flows[i]) != expected) {
+      printf("Corrupted 6to4 packet of port %u not detected\n",
+             flows[i].port);
+      errors++;
+    }
+    corrupt = 1;
+    if(flow_4to6(&flows[i]) != expected) {
+      printf("Corrupted 4to6 packet of port %u not detected\n",
+             flows[i].mapped_port);
+      errors++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ip64_bench_process, ev, data)
+{
+  static struct etimer et;
+  static uint8_t step;
+  static uint16_t i;
+  static uint16_t long_port;
+  static uint8_t long_proto;
+  static clock_time_t long_start;
+  struct ip64_addrmap_entry *m;
+  uip_ip4addr_t netmask;
+
+  PROCESS_BEGIN();
+
+  uip_ipaddr(&hostaddr, 10, 0, 0, 2);
+  uip_ipaddr(&netmask, 255, 255, 255, 0);
+  uip_ipaddr(&server, 192, 0, 2, 1);
+  ip64_set_ipv4_address(&hostaddr, &netmask);
+  ip64_addrmap_init();
+  init_flows();
+
+  printf("ip64 benchmark: %u packets per direction and step\n",
+         BENCH_PACKETS);
+
+  for(step = 0; step < sizeof(steps) / sizeof(steps[0]); step++) {
+    while(active < steps[step]) {
+      translate(&flows[active++]);
+    }
+    run_step();
+    /* Let the other processes run between the steps */
+    PROCESS_PAUSE();
+  }
+  for(step = 1; step < sizeof(sizes) / sizeof(sizes[0]); step++) {
+    payload_len = sizes[step];
+    run_step();
+    PROCESS_PAUSE();
+  }
+  payload_len = BENCH_PAYLOAD;
+  check_corrupted();
+
+  /* Half of the flows expire, the others stay */
+  for(m = ip64_addrmap_list(); m != NULL; m = list_item_next(m)) {
+    if(m->mapped_port & 1) {
+      ip64_addrmap_set_lifetime(m, CLOCK_SECOND / 2);
+    }
+  }
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  for(i = 0; i < active; i++) {
+    if(ip64_addrmap_lookup_port(flows[i].mapped_port, flows[i].proto) !=
+       NULL && (flows[i].mapped_port & 1)) {
+      printf("Mapping of port %u did not expire\n", flows[i].mapped_port);
+      errors++;
+    }
+  }
+  printf("%u flows after expiry\n", ip64_addrmap_count());
+  for(i = 0; i < active; i++) {
+    if(flows[i].mapped_port & 1) {
+      flows[i].mapped_port = 0;
+    }
+    translate(&flows[i]);
+  }
+  if(ip64_addrmap_count() != active) {
+    printf("%u mappings after the new flows, expected %u\n",
+           ip64_addrmap_count(), active);
+    errors++;
+  }
+
+  /* A full table recycles the oldest recyclable mapping */
+  m = ip64_addrmap_list();
+  ip64_addrmap_set_recycleble(m);
+  flows[0].port++;
+  flows[0].mapped_port = 0;
+  translate(&flows[0]);
+  if(ip64_addrmap_count() != active) {
+    printf("%u mappings after recycling, expected %u\n",
+           ip64_addrmap_count(), active);
+    errors++;
+  }
+
+  /* A lifetime longer than a turn of the wheel expires on time, not on
+     a later turn. The lookups turn the wheel, as traffic would. */
+  m = ip64_addrmap_list();
+  long_port = m->mapped_port;
+  long_proto = m->protocol;
+  ip64_addrmap_set_lifetime(m, BENCH_LONG_LIFETIME);
+  long_start = clock_time();
+  do {
+    etimer_set(&et, CLOCK_SECOND / 4);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  } while(ip64_addrmap_lookup_port(long_port, long_proto) != NULL &&
+          clock_time() - long_start < BENCH_LONG_LIFETIME + CLOCK_SECOND / 2);
+  if(ip64_addrmap_lookup_port(long_port, long_proto) != NULL) {
+    printf("Mapping of port %u with a long lifetime did not expire\n",
+           long_port);
+    errors++;
+  }
+
+  printf("ip64 benchmark finished, errors %lu\n", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+/*---------------------------------------------------------------------------*/
+/* Room for all the flows of the benchmark */
+#ifndef IP64_ADDRMAP_CONF_ENTRIES
+#define IP64_ADDRMAP_CONF_ENTRIES   1024
+#endif
+
+#ifndef IP64_ADDRMAP_CONF_HASH_SIZE
+#define IP64_ADDRMAP_CONF_HASH_SIZE 256
+#endif
+
+/* A wheel that turns in 2 s, shorter than the long lifetime of the
+   benchmark */
+#ifndef IP64_ADDRMAP_CONF_WHEEL_SLOTS
+#define IP64_ADDRMAP_CONF_WHEEL_SLOTS 4
+#endif
+
+#ifndef IP64_ADDRMAP_CONF_WHEEL_TICK
+#define IP64_ADDRMAP_CONF_WHEEL_TICK (CLOCK_SECOND / 2)
+#endif
+/*---------------------------------------------------------------------------*/
+#endif /* PROJECT_CONF_H_ */
@@ -0,0 +1,380 @@
+#!/usr/bin/env python3
+#
+# Exercises the LWM2M composite operations of the native example node:
+# Read-Composite in SenML CBOR and SenML JSON, a blockwise Read-Composite,
+# Write-Composite and Observe-Composite. It also checks that the pmax
+# attribute of Write-Attributes gives periodic notifications.
+#
+# The client speaks plain CoAP over UDP and has its own minimal CBOR
+# codec, so that it does not depend on any CoAP or CBOR package.
+#
+# Options:
+#   --host H          address of the node (default fd00::302:304:506:708)
+#   --port P          CoAP port of the node (default 5683)
+#   --observe-time S  seconds to wait for a notification (default 25)
+#
+import argparse
+import json
+import random
+import socket
+import struct
+import sys
+import time
+
+SENML_JSON = 110
+SENML_CBOR = 112
+
+GET = 1
+PUT = 3
+FETCH = 5
+IPATCH = 7
+
+OPTION_OBSERVE = 6
+OPTION_URI_PATH = 11
+OPTION_CONTENT_FORMAT = 12
+OPTION_URI_QUERY = 15
+OPTION_ACCEPT = 17
+OPTION_BLOCK2 = 23
+
+BLOCK_SIZE = 64
+
+
+def cbor_head(major, value):
+    if value < 24:
+        return bytes([(major << 5) | value])
+    if value < 0x100:
+        return bytes([(major << 5) | 24, value])
+    if value < 0x10000:
+        return bytes([(major << 5) | 25]) + struct.pack('>H', value)
+    return bytes([(major << 5) | 26]) + struct.pack('>I', value)
+
+
+def cbor_encode(item):
+    if isinstance(item, bool):
+        return bytes([0xF5 if item else 0xF4])
+    if isinstance(item, int):
+        if item >= 0:
+            return cbor_head(0, item)
+        return cbor_head(1, -1 - item)
+    if isinstance(item, float):
+        return bytes([0xFB]) + struct.pack('>d', item)
+    if isinstance(item, bytes):
+        return cbor_head(2, len(item)) + item
+    if isinstance(item, str):
+        data = item.encode()
+        return cbor_head(3, len(data)) + data
+    if isinstance(item, list):
+        return cbor_head(4, len(item)) + b''.join(cbor_encode(i)
+                                                   for i in item)
+    if isinstance(item, dict):
+        return cbor_head(5, len(item)) + b''.join(
+            cbor_encode(k) + cbor_encode(v) for k, v in item.items())
+    raise ValueError("can not encode %r" % (item,))
+
+
+def cbor_decode(data, pos=0):
+    """Decodes one item. Returns (item, pos)."""
+    initial = data[pos]
+    pos += 1
+    major = initial >> 5
+    info = initial & 0x1F
+    if major == 7:
+        if info == 20:
+            return False, pos
+        if info == 21:
+            return True, pos
+        if info == 25:
+            half = struct.unpack('>H', data[pos:pos + 2])[0]
+            exponent = (half >> 10) & 0x1F
+            mantissa = half & 0x3FF
+            if exponent == 0:
+                value = mantissa * 2.0 ** -24
+            else:
+                value = (mantissa + 1024) * 2.0 ** (exponent - 25)
+            return (-value if half & 0x8000 else value), pos + 2
+        if info == 26:
+            return struct.unpack('>f', data[pos:pos + 4])[0], pos + 4
+        if info == 27:
+            return struct.unpack('>d', data[pos:pos + 8])[0], pos + 8
+        raise ValueError("simple value %u" % info)
+    if info == 31:
+        # Indefinite length array or map
+        items = []
+        while data[pos] != 0xFF:
+            item, pos = cbor_decode(data, pos)
+            items.append(item)
+        pos += 1
+        if major == 5:
+            return dict(zip(items[::2], items[1::2])), pos
+        return items, pos
+    if info < 24:
+        value = info
+    else:
+        size = 1 << (info - 24)
+        value = int.from_bytes(data[pos:pos + size], 'big')
+        pos += size
+    if major == 0:
+        return value, pos
+    if major == 1:
+        return -1 - value, pos
+    if major == 2:
+        return bytes(data[pos:pos + value]), pos + value
+    if major == 3:
+        return data[pos:pos + value].decode(), pos + value
+    if major == 4:
+        items = []
+        for _ in range(value):
+            item, pos = cbor_decode(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        items = {}
+        for _ in range(value):
+            key, pos = cbor_decode(data, pos)
+            items[key], pos = cbor_decode(data, pos)
+        return items, pos
+    raise ValueError("major type %u" % major)
+
+
+# SenML labels in CBOR
+CBOR_LABELS = {-2: 'bn', 0: 'n', 2: 'v', 3: 'vs', 4: 'vb', 8: 'vd'}
+CBOR_KEYS = {name: label for label, name in CBOR_LABELS.items()}
+
+
+def senml_encode(records, content_format):
+    if content_format == SENML_JSON:
+        return json.dumps(records).encode()
+    return cbor_encode([{CBOR_KEYS[k]: v for k, v in r.items()}
+                        for r in records])
+
+
+def senml_decode(payload, content_format):
+    """Returns the records as a dictionary of resolved name to value."""
+    if content_format == SENML_JSON:
+        records = json.loads(payload.decode())
+    else:
+        records, pos = cbor_decode(payload)
+        if pos != len(payload):
+            raise ValueError("%u trailing bytes" % (len(payload) - pos))
+        records = [{CBOR_LABELS.get(k, k): v for k, v in r.items()}
+                   for r in records]
+    values = {}
+    base = ''
+    for record in records:
+        base = record.get('bn', base)
+        for label in ('v', 'vs', 'vb', 'vd'):
+            if label in record:
+                values[base + record.get('n', '')] = record[label]
+    return values
+
+
+class Message:
+    def __init__(self, data):
+        self.type = (data[0] >> 4) & 0x03
+        token_len = data[0] & 0x0F
+        self.code = data[1]
+        self.mid = struct.unpack('>H', data[2:4])[0]
+        self.token = bytes(data[4:4 + token_len])
+        self.options = {}
+        self.payload = b''
+        pos = 4 + token_len
+        number = 0
+        while pos < len(data):
+            if data[pos] == 0xFF:
+                self.payload = bytes(data[pos + 1:])
+                break
+            delta = data[pos] >> 4
+            length = data[pos] & 0x0F
+            pos += 1
+            if delta == 13:
+                delta = data[pos] + 13
+                pos += 1
+            elif delta == 14:
+                delta = struct.unpack('>H', data[pos:pos + 2])[0] + 269
+                pos += 2
+            if length == 13:
+                length = data[pos] + 13
+                pos += 1
+            elif length == 14:
+                length = struct.unpack('>H', data[pos:pos + 2])[0] + 269
+                pos += 2
+            number += delta
+            self.options[number] = int.from_bytes(data[pos:pos + length],
+                                                  'big')
+            pos += length
+
+    def code_string(self):
+        return "%u.%02u" % (self.code >> 5, self.code & 0x1F)
+
+
+def uint_option(value):
+    return value.to_bytes((value.bit_length() + 7) // 8, 'big')
+
+
+class Client:
+    def __init__(self, host, port):
+        self.sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        self.address = (host, port)
+        self.mid = random.randint(0, 0xFFFF)
+        self.errors = 0
+
+    def check(self, name, ok, detail=''):
+        print("%-28s %s %s" % (name, "OK" if ok else "FAIL", detail),
+              flush=True)
+        if not ok:
+            self.errors += 1
+
+    def send(self, code, token, options, payload):
+        self.mid = (self.mid + 1) & 0xFFFF
+        data = bytes([0x40 | len(token), code]) + \
+            struct.pack('>H', self.mid) + token
+        number = 0
+        for option, values in sorted(options.items()):
+            # Repeated options, such as Uri-Path, are given as lists
+            if not isinstance(values, list):
+                values = [values]
+            for value in values:
+                delta = option - number
+                number = option
+                data += bytes([(delta << 4) | len(value)]) + value
+        if payload:
+            data += b'\xff' + payload
+        self.sock.sendto(data, self.address)
+
+    def receive(self, token, timeout):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            self.sock.settimeout(max(deadline - time.time(), 0.01))
+            try:
+                data, _ = self.sock.recvfrom(2048)
+            except socket.timeout:
+                break
+            message = Message(data)
+            if message.type == 0:
+                # Acknowledge confirmable notifications
+                self.sock.sendto(bytes([0x60, 0]) + data[2:4], self.address)
+            if message.token == token:
+                return message
+        return None
+
+    def request(self, code, options, payload, token=None, timeout=5):
+        token = token or struct.pack('>I', random.getrandbits(32))
+        for _ in range(3):
+            self.send(code, token, options, payload)
+            response = self.receive(token, timeout)
+            if response:
+                return response
+        return None
+
+    def fetch(self, paths, content_format, observe=None):
+        """A blockwise Read-Composite. Returns (response, payload, blocks)."""
+        payload = senml_encode([{'n': p} for p in paths], content_format)
+        token = struct.pack('>I', random.getrandbits(32))
+        body = b''
+        blocks = 0
+        first = None
+        while True:
+            options = {OPTION_CONTENT_FORMAT: uint_option(content_format),
+                       OPTION_ACCEPT: uint_option(content_format),
+                       OPTION_BLOCK2: uint_option((blocks << 4) | 2)}
+            if observe is not None and blocks == 0:
+                options[OPTION_OBSERVE] = uint_option(observe)
+            response = self.request(FETCH, options, payload, token)
+            if response is None or response.code != 0x45:
+                return response, None, blocks
+            first = first or response
+            body += response.payload
+            blocks += 1
+            if not response.options.get(OPTION_BLOCK2, 0) & 0x08:
+                return first, body, blocks
+
+
+def read_composite(client, content_format, name):
+    paths = ['/3/0/0', '/3303/0/5700']
+    response, payload, _ = client.fetch(paths, content_format)
+    if payload is None:
+        client.check(name, False, response and response.code_string())
+        return
+    values = senml_decode(payload, content_format)
+    client.check(name, sorted(values) == paths and
+                 isinstance(values['/3/0/0'], str) and
+                 isinstance(values['/3303/0/5700'], (int, float)),
+                 repr(values))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--host', default='fd00::302:304:506:708')
+    parser.add_argument('--port', type=int, default=5683)
+    parser.add_argument('--observe-time', type=float, default=25)
+    args = parser.parse_args()
+
+    client = Client(args.host, args.port)
+
+    read_composite(client, SENML_CBOR, "read-composite-cbor")
+    read_composite(client, SENML_JSON, "read-composite-json")
+
+    # A whole object instance does not fit one block
+    response, payload, blocks = client.fetch(['/3/0'], SENML_CBOR)
+    values = senml_decode(payload, SENML_CBOR) if payload else {}
+    client.check("read-composite-blockwise",
+                 blocks > 1 and '/3/0/0' in values and '/3/0/1' in values,
+                 "%u blocks %u values" % (blocks, len(values)))
+
+    # Write-Composite of the device time
+    payload = senml_encode([{'bn': '/3/0/', 'n': '13', 'v': 1000000}],
+                           SENML_CBOR)
+    response = client.request(IPATCH, {
+        OPTION_CONTENT_FORMAT: uint_option(SENML_CBOR)}, payload)
+    ok = response is not None and response.code == 0x44
+    response, payload, _ = client.fetch(['/3/0/13'], SENML_CBOR)
+    values = senml_decode(payload, SENML_CBOR) if payload else {}
+    client.check("write-composite",
+                 ok and 1000000 <= values.get('/3/0/13', 0) < 1000010,
+                 repr(values))
+
+    payload = senml_encode([{'n': '/3/0/13/0', 'v': 1}], SENML_JSON)
+    response = client.request(IPATCH, {
+        OPTION_CONTENT_FORMAT: uint_option(SENML_JSON)}, payload)
+    client.check("write-composite-instance",
+                 response is not None and response.code == 0xA1,
+                 response and response.code_string())
+
+    # Write-Attributes: the device time never notifies by itself, so all its
+    # notifications come from pmax
+    path = [b'3', b'0', b'13']
+    response = client.request(PUT, {OPTION_URI_PATH: path,
+                                     OPTION_URI_QUERY: [b'pmax=1']}, b'')
+    ok = response is not None and response.code == 0x44
+    response = client.request(GET, {OPTION_OBSERVE: b'',
+                                    OPTION_URI_PATH: path,
+                                    OPTION_ACCEPT: uint_option(SENML_JSON)},
+                              b'')
+    ok = ok and response is not None and OPTION_OBSERVE in response.options
+    notifications = 0
+    deadline = time.time() + 3.5
+    while ok and time.time() < deadline:
+        if client.receive(response.token, deadline - time.time()):
+            notifications += 1
+    client.check("observe-pmax", ok and notifications >= 2,
+                 "%u notifications" % notifications)
+
+    # Observe-Composite: the temperature changes every ten seconds
+    paths = ['/3303/0/5700', '/3/0/0']
+    response, payload, _ = client.fetch(paths, SENML_CBOR, observe=0)
+    ok = payload is not None and OPTION_OBSERVE in response.options
+    notification = None
+    if ok:
+        notification = client.receive(response.token, args.observe_time)
+    values = {}
+    if notification is not None and notification.code == 0x45:
+        values = senml_decode(notification.payload, SENML_CBOR)
+    client.check("observe-composite",
+                 ok and sorted(values) == sorted(paths) and
+                 OPTION_OBSERVE in notification.options, repr(values))
+
+    print("Composite client finished, errors %u" % client.errors, flush=True)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+#
+# A stand-in for a LWM2M server, for testing the Queue Mode notifications
+# of the native example node. It accepts the registration and the
+# updates of one client. After the registration it observes
+# /3303/0/5700 and the composite of the temperature value, minimum and
+# maximum. It also accepts LWM2M Send reports on /dp.
+#
+# A summary is printed when it exits. "max-per-wake" is the largest number
+# of notifications and reports received within one second of an update.
+#
+# Options:
+#   --port P          UDP port to listen on (default 5683)
+#   --duration S      exit after S seconds (default: run until SIGTERM)
+#
+import argparse
+import importlib.util
+import os
+import select
+import signal
+import socket
+import struct
+import sys
+import time
+
+# The CoAP and SenML helpers of the composite client
+spec = importlib.util.spec_from_file_location(
+    'composite_client',
+    os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                 'composite-client.py'))
+client = importlib.util.module_from_spec(spec)
+spec.loader.exec_module(client)
+
+POST = 2
+OPTION_LOCATION_PATH = 8
+
+COMPOSITE_PATHS = ['/3303/0/5700', '/3303/0/5601', '/3303/0/5602']
+
+
+class Stats:
+    def __init__(self):
+        self.registrations = 0
+        self.updates = 0
+        self.notifications = 0
+        self.composite = 0
+        self.sends = 0
+        self.send_records = 0
+        self.max_per_wake = 0
+        self.wake_count = 0
+
+    def summary(self):
+        return ("registrations %u updates %u notifications %u composite %u "
+                "sends %u send-records %u max-per-wake %u" %
+                (self.registrations, self.updates, self.notifications,
+                 self.composite, self.sends, self.send_records,
+                 self.max_per_wake))
+
+
+def uri_path(data):
+    """Returns the Uri-Path of a request, which Message does not keep."""
+    token_len = data[0] & 0x0F
+    pos = 4 + token_len
+    number = 0
+    path = []
+    while pos < len(data) and data[pos] != 0xFF:
+        delta = data[pos] >> 4
+        length = data[pos] & 0x0F
+        pos += 1
+        if delta == 13:
+            delta = data[pos] + 13
+            pos += 1
+        elif delta == 14:
+            delta = struct.unpack('>H', data[pos:pos + 2])[0] + 269
+            pos += 2
+        if length == 13:
+            length = data[pos] + 13
+            pos += 1
+        elif length == 14:
+            length = struct.unpack('>H', data[pos:pos + 2])[0] + 269
+            pos += 2
+        number += delta
+        if number == client.OPTION_URI_PATH:
+            path.append(data[pos:pos + length].decode())
+        pos += length
+    return '/'.join(path)
+
+
+class Server:
+    def __init__(self, port, stats):
+        self.sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind(('::', port))
+        self.stats = stats
+        self.mid = 0x1000
+        self.observe_token = b'ob'
+        self.composite_token = b'co'
+        self.wake_time = 0
+
+    def reply(self, address, message, code, options=b'', payload=b''):
+        data = bytes([0x60 | len(message.token), code]) + \
+            struct.pack('>H', message.mid) + message.token + options
+        if payload:
+            data += b'\xff' + payload
+        self.sock.sendto(data, address)
+
+    def request(self, address, code, token, options, payload=b''):
+        self.mid = (self.mid + 1) & 0xFFFF
+        data = bytes([0x40 | len(token), code]) + \
+            struct.pack('>H', self.mid) + token
+        number = 0
+        for option, values in options:
+            for value in values:
+                data += bytes([((option - number) << 4) | len(value)]) + value
+                number = option
+        if payload:
+            data += b'\xff' + payload
+        self.sock.sendto(data, address)
+
+    def observe(self, address):
+        """Observes a resource and a composite while the client is awake."""
+        path = [s.encode() for s in '3303/0/5700'.split('/')]
+        self.request(address, client.GET, self.observe_token,
+                     [(client.OPTION_OBSERVE, [b'']),
+                      (client.OPTION_URI_PATH, path)])
+        payload = client.senml_encode([{'n': p} for p in COMPOSITE_PATHS],
+                                      client.SENML_CBOR)
+        cbor = client.uint_option(client.SENML_CBOR)
+        self.request(address, client.FETCH, self.composite_token,
+                     [(client.OPTION_OBSERVE, [b'']),
+                      (client.OPTION_CONTENT_FORMAT, [cbor]),
+                      (client.OPTION_ACCEPT, [cbor])], payload)
+
+    def count_wake(self):
+        if time.time() - self.wake_time < 1.0:
+            self.stats.wake_count += 1
+            self.stats.max_per_wake = max(self.stats.max_per_wake,
+                                          self.stats.wake_count)
+
+    def handle(self, data, address):
+        message = client.Message(data)
+        if message.code == POST:
+            path = uri_path(data)
+            if path == 'rd':
+                self.stats.registrations += 1
+                self.reply(address, message, 0x41,
+                           bytes([0x82]) + b'rd' + bytes([0x02]) + b'x1')
+                self.observe(address)
+            elif path.startswith('rd/'):
+                self.stats.updates += 1
+                self.wake_time = time.time()
+                self.stats.wake_count = 0
+                self.reply(address, message, 0x44)
+            elif path == 'dp':
+                self.stats.sends += 1
+                self.count_wake()
+                values = client.senml_decode(message.payload,
+                                             message.options.get(
+                                                 client.OPTION_CONTENT_FORMAT,
+                                                 client.SENML_CBOR))
+                self.stats.send_records += len(values)
+                print("Send: %r" % values, flush=True)
+                self.reply(address, message, 0x44)
+            else:
+                self.reply(address, message, 0x84)
+        elif message.code == 0x45 and client.OPTION_OBSERVE in message.options:
+            if message.type == 0:
+                # An empty acknowledgement of a confirmable notification
+                self.sock.sendto(bytes([0x60, 0]) +
+                                 struct.pack('>H', message.mid), address)
+            elif message.type == 2:
+                # The response to the registration of the observation
+                return
+            if message.token == self.observe_token:
+                self.stats.notifications += 1
+                self.count_wake()
+            elif message.token == self.composite_token:
+                self.stats.composite += 1
+                self.count_wake()
+                print("Composite: %r" %
+                      client.senml_decode(message.payload,
+                                          client.SENML_CBOR), flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--port', type=int, default=5683)
+    parser.add_argument('--duration', type=float, default=0)
+    args = parser.parse_args()
+
+    stats = Stats()
+
+    def finish(*unused):
+        print("Server stand-in: " + stats.summary(), flush=True)
+        sys.exit(0)
+
+    signal.signal(signal.SIGTERM, finish)
+    signal.signal(signal.SIGINT, finish)
+
+    server = Server(args.port, stats)
+    deadline = time.time() + args.duration if args.duration else None
+    while deadline is None or time.time() < deadline:
+        readable, _, _ = select.select([server.sock], [], [], 0.1)
+        if readable:
+            data, address = server.sock.recvfrom(2048)
+            server.handle(data, address)
+    finish()
+
+
+if __name__ == '__main__':
+    main()
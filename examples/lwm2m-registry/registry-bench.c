@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Benchmark of the object instance registry of the LWM2M engine.
+ *         The program registers a growing number of object instances and
+ *         measures the time of a read request and of the generation of the
+ *         registration payload. It checks the response of every request
+ *         and the links of the registration payload.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "coap-engine.h"
+#include "lwm2m-engine.h"
+#include "lwm2m-object.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define BENCH_MAX_INSTANCES 1024
+#define BENCH_OBJECTS       4
+#define BENCH_FIRST_OBJECT  10240
+#define BENCH_REQUESTS      100000
+#define BENCH_RD_ROUNDS     1000
+#define BENCH_RD_BLOCK_SIZE 64
+/*---------------------------------------------------------------------------*/
+PROCESS(registry_bench_process, "LWM2M registry benchmark");
+AUTOSTART_PROCESSES(&registry_bench_process);
+/*---------------------------------------------------------------------------*/
+static const uint16_t steps[] = { 16, 64, 256, BENCH_MAX_INSTANCES };
+
+static const lwm2m_resource_id_t resources[] = { RO(0) };
+static lwm2m_object_instance_t instances[BENCH_MAX_INSTANCES];
+static uint16_t order[BENCH_MAX_INSTANCES];
+static uint16_t registered;
+static char rd_payload[BENCH_MAX_INSTANCES * 16];
+static unsigned long errors;
+static uint32_t random_state = 1;
+/*---------------------------------------------------------------------------*/
+static unsigned
+next_random(void)
+{
+  random_state = random_state * 1103515245UL + 12345;
+  return (unsigned)(random_state >> 16);
+}
+/*---------------------------------------------------------------------------*/
+static lwm2m_status_t
+instance_callback(lwm2m_object_instance_t *object, lwm2m_context_t *ctx)
+{
+  if(ctx->operation != LWM2M_OP_READ || ctx->resource_id != 0) {
+    return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+  }
+  lwm2m_object_write_int(ctx, object->object_id * 10000L + object->instance_id);
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_instances(void)
+{
+  lwm2m_object_instance_t *instance;
+  uint16_t i, j, tmp;
+
+  for(i = 0; i < BENCH_MAX_INSTANCES; i++) {
+    instance = &instances[i];
+    instance->object_id = BENCH_FIRST_OBJECT + i % BENCH_OBJECTS;
+    instance->instance_id = i / BENCH_OBJECTS;
+    instance->resource_ids = resources;
+    instance->resource_count = sizeof(resources) / sizeof(lwm2m_resource_id_t);
+    instance->callback = instance_callback;
+    order[i] = i;
+  }
+
+  /* Register the instances in a random order */
+  for(i = BENCH_MAX_INSTANCES - 1; i > 0; i--) {
+    j = next_random() % (i + 1);
+    tmp = order[i];
+    order[i] = order[j];
+    order[j] = tmp;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Reads resource 0 of a registered instance through the CoAP handlers */
+static void
+read_instance(const lwm2m_object_instance_t *instance)
+{
+  static uint8_t buffer[COAP_MAX_BLOCK_SIZE];
+  coap_message_t request[1];
+  coap_message_t response[1];
+  char path[24];
+  char expected[12];
+  int32_t offset = 0;
+  int len;
+
+  len = snprintf(path, sizeof(path), "%u/%u/0",
+                 instance->object_id, instance->instance_id);
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_header_uri_path(request, path);
+  coap_set_header_accept(request, TEXT_PLAIN);
+  coap_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, 0);
+
+  if(coap_call_handlers(request, response, buffer, sizeof(buffer),
+                        &offset) == COAP_HANDLER_STATUS_CONTINUE ||
+     response->code != CONTENT_2_05) {
+    printf("Read of %s failed\n", path);
+    errors++;
+    return;
+  }
+  len = snprintf(expected, sizeof(expected), "%ld",
+                 instance->object_id * 10000L + instance->instance_id);
+  if(response->payload_len != len ||
+     memcmp(response->payload, expected, len) != 0) {
+    printf("Read of %s returned %.*s\n", path,
+           (int)response->payload_len, (char *)response->payload);
+    errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Generates the registration payload block by block */
+static int
+generate_rd_payload(void)
+{
+  lwm2m_buffer_t outbuf;
+  int block = 0;
+  int len = 0;
+  int more;
+
+  do {
+    outbuf.buffer = (uint8_t *)&rd_payload[len];
+    outbuf.size = BENCH_RD_BLOCK_SIZE;
+    outbuf.len = 0;
+    more = lwm2m_engine_set_rd_data(&outbuf, block++);
+    len += outbuf.len;
+  } while(more && len + BENCH_RD_BLOCK_SIZE < sizeof(rd_payload));
+  rd_payload[len] = '\0';
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks that the payload has a link to each registered instance, in order */
+static void
+check_rd_payload(void)
+{
+  const char *p;
+  unsigned long key, last_key = 0;
+  unsigned object_id, instance_id;
+  uint16_t links = 0;
+
+  generate_rd_payload();
+  for(p = rd_payload; *p != '\0'; p = strchr(p, ',') ? strchr(p, ',') + 1 : "") {
+    if(sscanf(p, "</%u/%u>", &object_id, &instance_id) != 2) {
+      printf("Bad link in registration payload: %.16s\n", p);
+      errors++;
+      return;
+    }
+    key = object_id * 65536UL + instance_id;
+    if(links > 0 && key <= last_key) {
+      printf("Link </%u/%u> out of order\n", object_id, instance_id);
+      errors++;
+    }
+    last_key = key;
+    links++;
+  }
+  if(links != registered) {
+    printf("Registration payload has %u links, expected %u\n",
+           links, registered);
+    errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+elapsed_us(clock_time_t start, unsigned long count)
+{
+  return (unsigned long)(clock_time() - start) * (1000000UL / CLOCK_SECOND) /
+    count;
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_step(void)
+{
+  clock_time_t start;
+  unsigned long i;
+  unsigned long request_ns, generate_us, cached_us;
+  int len = 0;
+
+  start = clock_time();
+  for(i = 0; i < BENCH_REQUESTS; i++) {
+    read_instance(&instances[order[next_random() % registered]]);
+  }
+  request_ns = elapsed_us(start, BENCH_REQUESTS / 1000);
+
+  start = clock_time();
+  for(i = 0; i < BENCH_RD_ROUNDS; i++) {
+    lwm2m_engine_clear_rd_data();
+    len = generate_rd_payload();
+  }
+  generate_us = elapsed_us(start, BENCH_RD_ROUNDS);
+
+  start = clock_time();
+  for(i = 0; i < BENCH_RD_ROUNDS; i++) {
+    generate_rd_payload();
+  }
+  cached_us = elapsed_us(start, BENCH_RD_ROUNDS);
+
+  check_rd_payload();
+
+  printf("%4u instances: read %5lu ns, registration payload %5u bytes"
+         " generated %6lu us cached %5lu us\n",
+         registered, request_ns, len, generate_us, cached_us);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(registry_bench_process, ev, data)
+{
+  static uint8_t step;
+  static uint16_t i;
+
+  PROCESS_BEGIN();
+
+  lwm2m_engine_init();
+  init_instances();
+
+  printf("LWM2M registry benchmark: %u requests, %u registrations per step\n",
+         BENCH_REQUESTS, BENCH_RD_ROUNDS);
+
+  for(step = 0; step < sizeof(steps) / sizeof(steps[0]); step++) {
+    while(registered < steps[step]) {
+      if(!lwm2m_engine_add_object(&instances[order[registered]])) {
+        printf("Could not register instance %u\n", order[registered]);
+        errors++;
+      }
+      registered++;
+    }
+    run_step();
+    /* Let the other processes run between the steps */
+    PROCESS_PAUSE();
+  }
+
+  /* A removed instance is gone from the requests and the payload */
+  lwm2m_engine_remove_object(&instances[order[0]]);
+  registered--;
+  if(lwm2m_engine_has_instance(instances[order[0]].object_id,
+                               instances[order[0]].instance_id)) {
+    printf("Removed instance is still registered\n");
+    errors++;
+  }
+  check_rd_payload();
+  for(i = 1; i < registered; i++) {
+    read_instance(&instances[order[i]]);
+  }
+
+  printf("LWM2M registry benchmark finished, errors %lu\n", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
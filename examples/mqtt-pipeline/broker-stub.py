@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+#
+# A stand-in for an MQTT broker, for testing the MQTT engine without a full
+# broker. It serves one client at a time, answers CONNECT, PUBLISH (QoS 0, 1
+# and 2), PUBREL, SUBSCRIBE and PINGREQ, and drops the received messages. A summary is printed when it exits.
+#
+# With --publish-size, each SUBSCRIBE is answered with a QoS 0 PUBLISH of
+# that many bytes on the subscribed topic. Byte i of its payload is i % 251.
+#
+# Options:
+#   --port P          TCP port to listen on (default 1883)
+#   --ack-delay MS    delay the acknowledgements of each read by MS
+#                     milliseconds
+#   --drop-at N       close the connection, without acknowledging it, when
+#                     the Nth PUBLISH arrives
+#   --ack-limit N     stop acknowledging after N PUBLISH messages
+#   --duration S      exit after S seconds (default: run until SIGTERM)
+#   --publish-size N  publish N bytes to each subscriber
+#
+import argparse
+import select
+import signal
+import socket
+import struct
+import sys
+import time
+
+
+class Stats:
+    def __init__(self):
+        self.connections = 0
+        self.publishes = 0
+        self.duplicates = 0
+        self.reads = 0
+        self.max_per_read = 0
+        self.payloads = set()
+
+    def summary(self):
+        return ("connections %u publishes %u unique %u duplicates %u "
+                "reads %u max-per-read %u" %
+                (self.connections, self.publishes, len(self.payloads),
+                 self.duplicates, self.reads, self.max_per_read))
+
+
+def decode_length(buf, pos):
+    """Decodes a Variable Byte Integer. Returns (value, pos) or None."""
+    value = 0
+    shift = 0
+    while pos < len(buf):
+        byte = buf[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte & 0x80 == 0:
+            return value, pos
+        shift += 7
+    return None
+
+
+def encode_length(value):
+    """Encodes a Variable Byte Integer."""
+    out = b''
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out += bytes([byte | 0x80])
+        else:
+            return out + bytes([byte])
+
+
+def ack(packet_type, mid, version):
+    if version == 5:
+        # Reason Code "Success" and no properties
+        return bytes([packet_type, 4, mid >> 8, mid & 0xFF, 0, 0])
+    return bytes([packet_type, 2, mid >> 8, mid & 0xFF])
+
+
+class Session:
+    def __init__(self, sock, args, stats):
+        self.sock = sock
+        self.args = args
+        self.stats = stats
+        self.buf = b''
+        self.version = 4
+
+    def handle_publish(self, flags, body):
+        qos = (flags >> 1) & 0x03
+        topic_len = (body[0] << 8) | body[1]
+        pos = 2 + topic_len
+        mid = 0
+        if qos > 0:
+            mid = (body[pos] << 8) | body[pos + 1]
+            pos += 2
+        if self.version == 5:
+            props_len, pos = decode_length(body, pos)
+            pos += props_len
+        payload = bytes(body[pos:])
+
+        self.stats.publishes += 1
+        if flags & 0x08:
+            self.stats.duplicates += 1
+        self.stats.payloads.add(payload)
+
+        if self.stats.publishes == self.args.drop_at:
+            return None
+        if self.args.ack_limit and self.stats.publishes > self.args.ack_limit:
+            return b''
+        if qos == 1:
+            return ack(0x40, mid, self.version)
+        if qos == 2:
+            return ack(0x50, mid, self.version)
+        return b''
+
+    def handle_packet(self, fhdr, body):
+        packet_type = fhdr & 0xF0
+        if packet_type == 0x10:
+            # CONNECT: the protocol level follows the protocol name
+            name_len = (body[0] << 8) | body[1]
+            self.version = body[2 + name_len]
+            if self.version == 5:
+                return bytes([0x20, 3, 0, 0, 0])
+            return bytes([0x20, 2, 0, 0])
+        if packet_type == 0x30:
+            return self.handle_publish(fhdr & 0x0F, body)
+        if packet_type == 0x60:
+            mid = (body[0] << 8) | body[1]
+            return ack(0x70, mid, self.version)
+        if packet_type == 0x80:
+            mid = (body[0] << 8) | body[1]
+            if self.version == 5:
+                reply = bytes([0x90, 4, mid >> 8, mid & 0xFF, 0, 0])
+            else:
+                reply = bytes([0x90, 3, mid >> 8, mid & 0xFF, 0])
+            if self.args.publish_size:
+                reply += self.publish(body)
+            return reply
+        if packet_type == 0xC0:
+            return bytes([0xD0, 0])
+        if packet_type == 0xE0:
+            return None
+        return b''
+
+    def publish(self, subscribe_body):
+        """Builds a PUBLISH on the first topic of a SUBSCRIBE."""
+        pos = 2
+        if self.version == 5:
+            props_len, pos = decode_length(subscribe_body, pos)
+            pos += props_len
+        topic_len = (subscribe_body[pos] << 8) | subscribe_body[pos + 1]
+        topic = bytes(subscribe_body[pos:pos + 2 + topic_len])
+        vhdr = topic + (b'\x00' if self.version == 5 else b'')
+        payload = bytes(i % 251 for i in range(self.args.publish_size))
+        return (bytes([0x30]) + encode_length(len(vhdr) + len(payload)) +
+                vhdr + payload)
+
+    def handle_read(self, data):
+        """Handles the data of one read. Returns False to close."""
+        self.buf += data
+        self.stats.reads += 1
+        replies = b''
+        publishes = 0
+        while len(self.buf) >= 2:
+            decoded = decode_length(self.buf, 1)
+            if decoded is None:
+                break
+            length, pos = decoded
+            if len(self.buf) < pos + length:
+                break
+            fhdr = self.buf[0]
+            body = self.buf[pos:pos + length]
+            self.buf = self.buf[pos + length:]
+            if fhdr & 0xF0 == 0x30:
+                publishes += 1
+            reply = self.handle_packet(fhdr, body)
+            if reply is None:
+                return False
+            replies += reply
+        self.stats.max_per_read = max(self.stats.max_per_read, publishes)
+        if replies:
+            if self.args.ack_delay:
+                time.sleep(self.args.ack_delay / 1000.0)
+            self.sock.sendall(replies)
+        return True
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--port', type=int, default=1883)
+    parser.add_argument('--ack-delay', type=int, default=0)
+    parser.add_argument('--drop-at', type=int, default=0)
+    parser.add_argument('--ack-limit', type=int, default=0)
+    parser.add_argument('--duration', type=float, default=0)
+    parser.add_argument('--publish-size', type=int, default=0)
+    args = parser.parse_args()
+
+    stats = Stats()
+    session = None
+
+    def finish(*unused):
+        if session:
+            session.sock.close()
+        print("Broker stand-in: " + stats.summary(), flush=True)
+        sys.exit(0)
+
+    signal.signal(signal.SIGTERM, finish)
+    signal.signal(signal.SIGINT, finish)
+
+    server = socket.socket(socket.AF_INET6, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('::', args.port))
+    server.listen(1)
+
+    deadline = time.time() + args.duration if args.duration else None
+    while deadline is None or time.time() < deadline:
+        sockets = [server] + ([session.sock] if session else [])
+        readable, _, _ = select.select(sockets, [], [], 0.1)
+        if server in readable:
+            sock, _ = server.accept()
+            # Reset the connection on close. The node picks the same local
+            # port after a restart, which must not match a closing socket.
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER,
+                            struct.pack('ii', 1, 0))
+            if session:
+                session.sock.close()
+            session = Session(sock, args, stats)
+            stats.connections += 1
+        elif session and session.sock in readable:
+            try:
+                data = session.sock.recv(4096)
+            except OSError:
+                data = b''
+            if not data or not session.handle_read(data):
+                session.sock.close()
+                session = None
+    finish()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Publishes a burst of QoS 1 and QoS 2 messages as fast as the
+ *         outgoing queue of the MQTT engine accepts them, and reports the
+ *         time until all of them have been acknowledged. Messages that
+ *         were left unacknowledged by a previous run are restored from the
+ *         file system and acknowledged as well.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "mqtt.h"
+#include "mqtt-prop.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_PIPELINE_CONF_BROKER_IP_ADDR
+#define BROKER_IP_ADDR MQTT_PIPELINE_CONF_BROKER_IP_ADDR
+#else
+#define BROKER_IP_ADDR "fd00::1"
+#endif
+
+#ifdef MQTT_PIPELINE_CONF_BROKER_PORT
+#define BROKER_PORT MQTT_PIPELINE_CONF_BROKER_PORT
+#else
+#define BROKER_PORT 1883
+#endif
+
+#ifdef MQTT_PIPELINE_CONF_COUNT
+#define PUBLISH_COUNT MQTT_PIPELINE_CONF_COUNT
+#else
+#define PUBLISH_COUNT 40
+#endif
+
+#define CLIENT_ID        "pipeline"
+#define TOPIC            "pipeline/data"
+#define KEEP_ALIVE       60
+#define MAX_SEGMENT_SIZE 512
+#define ACK_TIMEOUT      (CLOCK_SECOND * 20)
+/*---------------------------------------------------------------------------*/
+PROCESS(mqtt_pipeline_process, "MQTT pipeline");
+AUTOSTART_PROCESSES(&mqtt_pipeline_process);
+/*---------------------------------------------------------------------------*/
+static struct mqtt_connection conn;
+static char payload[32];
+static unsigned published;
+static unsigned restored;
+static unsigned acked;
+static unsigned errors;
+/* One bit per message ID, to detect duplicate acknowledgements */
+static uint8_t acked_mids[65536 / 8];
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  uint16_t mid;
+
+  switch(event) {
+  case MQTT_EVENT_CONNECTED:
+    printf("Connected to the broker\n");
+    break;
+  case MQTT_EVENT_DISCONNECTED:
+    printf("Disconnected from the broker\n");
+    break;
+  case MQTT_EVENT_PUBACK:
+    mid = *(uint16_t *)data;
+    if(acked_mids[mid / 8] & (1 << (mid % 8))) {
+      printf("Duplicate acknowledgement of message %u\n", mid);
+      errors++;
+    }
+    acked_mids[mid / 8] |= 1 << (mid % 8);
+    acked++;
+    break;
+  default:
+    printf("MQTT event %u\n", event);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_pipeline_process, ev, data)
+{
+  static struct etimer et;
+  static clock_time_t start;
+  mqtt_status_t status;
+
+  PROCESS_BEGIN();
+
+  mqtt_register(&conn, &mqtt_pipeline_process, CLIENT_ID, mqtt_event,
+                MAX_SEGMENT_SIZE);
+  restored = conn.out_queue.count;
+  printf("Restored %u messages\n", restored);
+
+#if MQTT_5
+  mqtt_connect(&conn, BROKER_IP_ADDR, BROKER_PORT, KEEP_ALIVE,
+               MQTT_CLEAN_SESSION_OFF, MQTT_PROP_LIST_NONE);
+#else
+  mqtt_connect(&conn, BROKER_IP_ADDR, BROKER_PORT, KEEP_ALIVE,
+               MQTT_CLEAN_SESSION_OFF);
+#endif
+
+  while(!mqtt_connected(&conn)) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  start = clock_time();
+  while(published < PUBLISH_COUNT) {
+    snprintf(payload, sizeof(payload), "message %u", published);
+#if MQTT_5
+    status = mqtt_publish(&conn, NULL, TOPIC, (uint8_t *)payload,
+                          strlen(payload),
+                          published % 4 == 3 ? MQTT_QOS_LEVEL_2 : MQTT_QOS_LEVEL_1,
+                          MQTT_RETAIN_OFF, 0, MQTT_TOPIC_ALIAS_OFF,
+                          MQTT_PROP_LIST_NONE);
+#else
+    status = mqtt_publish(&conn, NULL, TOPIC, (uint8_t *)payload,
+                          strlen(payload),
+                          published % 4 == 3 ? MQTT_QOS_LEVEL_2 : MQTT_QOS_LEVEL_1,
+                          MQTT_RETAIN_OFF);
+#endif
+    if(status == MQTT_STATUS_OK) {
+      published++;
+    } else {
+      /* Wait for room in the queue or for the connection to come back */
+      PROCESS_WAIT_EVENT();
+    }
+  }
+
+  etimer_set(&et, ACK_TIMEOUT);
+  while(acked < published + restored && !etimer_expired(&et)) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  if(acked != published + restored) {
+    printf("Got %u acknowledgements, expected %u\n",
+           acked, published + restored);
+    errors++;
+  }
+
+  printf("Published %u messages in %lu ms, %u acknowledged\n",
+         published, (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND),
+         acked);
+  printf("MQTT pipeline finished, errors %u\n", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+#
+# A stand-in for an MQTT-SN gateway, for testing the MQTT-SN client without a
+# gateway and a broker. It serves any number of clients, keeps their topic
+# IDs and subscriptions, and drops the published messages. A summary is
+# printed when it exits.
+#
+# When a client goes to sleep, a message is buffered for each of its
+# subscriptions, and it is delivered when the client wakes up.
+#
+# Options:
+#   --port P        UDP port to listen on (default 1884)
+#   --drop-every N  do not acknowledge every Nth QoS 1 PUBLISH, so that the
+#                   client retransmits it
+#   --duration S    exit after S seconds (default: run until SIGTERM)
+#
+import argparse
+import select
+import signal
+import socket
+import struct
+import sys
+import time
+
+CONNECT = 0x04
+CONNACK = 0x05
+REGISTER = 0x0A
+REGACK = 0x0B
+PUBLISH = 0x0C
+PUBACK = 0x0D
+SUBSCRIBE = 0x12
+SUBACK = 0x13
+UNSUBSCRIBE = 0x14
+UNSUBACK = 0x15
+PINGREQ = 0x16
+PINGRESP = 0x17
+DISCONNECT = 0x18
+
+TOPIC_NORMAL = 0
+TOPIC_PREDEFINED = 1
+TOPIC_SHORT = 2
+
+RC_ACCEPTED = 0
+RC_INVALID_TOPIC_ID = 2
+
+# Predefined topic IDs, shared with the clients
+PREDEFINED = {1: 'nodes/status'}
+
+
+class Stats:
+    def __init__(self):
+        self.counters = {}
+
+    def add(self, name):
+        self.counters[name] = self.counters.get(name, 0) + 1
+
+    def summary(self):
+        names = ['connects', 'registers', 'subscribes', 'publishes',
+                 'qos-1', 'qos0', 'qos1', 'duplicates', 'dropped', 'sleeps',
+                 'wakes', 'buffered', 'disconnects']
+        return ' '.join('%s %u' % (n, self.counters.get(n, 0)) for n in names)
+
+
+def message(msg_type, body):
+    length = len(body) + 2
+    if length <= 255:
+        return bytes([length, msg_type]) + body
+    return bytes([1]) + struct.pack('>H', length + 2) + bytes([msg_type]) + body
+
+
+class Client:
+    def __init__(self):
+        self.topics = {}        # name -> topic ID
+        self.subscriptions = []  # (flags, topic ID)
+        self.asleep = False
+        self.buffered = []
+        self.mid = 0
+
+    def topic_id(self, name):
+        if name not in self.topics:
+            self.topics[name] = len(self.topics) + 100
+        return self.topics[name]
+
+    def next_mid(self):
+        self.mid = self.mid % 0xFFFF + 1
+        return self.mid
+
+
+class Gateway:
+    def __init__(self, sock, args):
+        self.sock = sock
+        self.args = args
+        self.stats = Stats()
+        self.clients = {}
+        self.qos1 = 0
+
+    def send(self, addr, msg_type, body):
+        self.sock.sendto(message(msg_type, body), addr)
+
+    def handle(self, data, addr):
+        if len(data) >= 4 and data[0] == 1:
+            length = struct.unpack('>H', data[1:3])[0]
+            header = 3
+        else:
+            length = data[0]
+            header = 1
+        if length > len(data) or length < header + 1:
+            return
+        msg_type = data[header]
+        body = data[header + 1:length]
+        client = self.clients.setdefault(addr, Client())
+
+        if msg_type == CONNECT:
+            self.stats.add('connects')
+            if body[0] & 0x04:
+                client.topics = {}
+                client.subscriptions = []
+            client.asleep = False
+            self.send(addr, CONNACK, bytes([RC_ACCEPTED]))
+        elif msg_type == REGISTER:
+            self.stats.add('registers')
+            mid = body[2:4]
+            topic_id = client.topic_id(body[4:].decode())
+            self.send(addr, REGACK,
+                      struct.pack('>H', topic_id) + mid + bytes([RC_ACCEPTED]))
+        elif msg_type == PUBLISH:
+            self.handle_publish(client, addr, body)
+        elif msg_type == SUBSCRIBE:
+            self.stats.add('subscribes')
+            flags = body[0]
+            mid = body[1:3]
+            if flags & 0x03 == TOPIC_NORMAL:
+                topic_id = client.topic_id(body[3:].decode())
+            else:
+                topic_id = struct.unpack('>H', body[3:5])[0]
+            client.subscriptions.append((flags & 0x63, topic_id))
+            reply_id = 0 if flags & 0x03 == TOPIC_SHORT else topic_id
+            self.send(addr, SUBACK, bytes([flags & 0x60]) +
+                      struct.pack('>H', reply_id) + mid + bytes([RC_ACCEPTED]))
+        elif msg_type == UNSUBSCRIBE:
+            self.send(addr, UNSUBACK, body[1:3])
+        elif msg_type == PINGREQ:
+            if body and client.asleep:
+                # A sleeping client is awake: deliver the buffered messages
+                self.stats.add('wakes')
+                for flags, topic_id, payload in client.buffered:
+                    mid = client.next_mid() if flags & 0x60 else 0
+                    self.send(addr, PUBLISH, bytes([flags]) +
+                              struct.pack('>HH', topic_id, mid) + payload)
+                client.buffered = []
+            self.send(addr, PINGRESP, b'')
+        elif msg_type == DISCONNECT:
+            if len(body) >= 2:
+                self.stats.add('sleeps')
+                client.asleep = True
+                for flags, topic_id in client.subscriptions:
+                    self.stats.add('buffered')
+                    client.buffered.append((flags, topic_id,
+                                            b'buffered while asleep'))
+            else:
+                self.stats.add('disconnects')
+            self.send(addr, DISCONNECT, b'')
+
+    def handle_publish(self, client, addr, body):
+        flags = body[0]
+        topic_id, mid = struct.unpack('>HH', body[1:5])
+        qos = (flags >> 5) & 0x03
+        self.stats.add('publishes')
+        self.stats.add({0: 'qos0', 1: 'qos1', 3: 'qos-1'}.get(qos, 'qos2'))
+        if flags & 0x80:
+            self.stats.add('duplicates')
+
+        known = (flags & 0x03 != TOPIC_NORMAL or
+                 topic_id in client.topics.values())
+        if flags & 0x03 == TOPIC_PREDEFINED and topic_id not in PREDEFINED:
+            known = False
+
+        if qos == 1:
+            self.qos1 += 1
+            if (self.args.drop_every and not flags & 0x80 and
+                    self.qos1 % self.args.drop_every == 0):
+                self.stats.add('dropped')
+                return
+        if qos == 1 or (qos == 0 and not known):
+            rc = RC_ACCEPTED if known else RC_INVALID_TOPIC_ID
+            self.send(addr, PUBACK,
+                      struct.pack('>HH', topic_id, mid) + bytes([rc]))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--port', type=int, default=1884)
+    parser.add_argument('--drop-every', type=int, default=0)
+    parser.add_argument('--duration', type=float, default=0)
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(('::', args.port))
+    gateway = Gateway(sock, args)
+
+    def finish(*unused):
+        print("Gateway stand-in: " + gateway.stats.summary(), flush=True)
+        sys.exit(0)
+
+    signal.signal(signal.SIGTERM, finish)
+    signal.signal(signal.SIGINT, finish)
+
+    deadline = time.time() + args.duration if args.duration else None
+    while deadline is None or time.time() < deadline:
+        readable, _, _ = select.select([sock], [], [], 0.1)
+        if readable:
+            data, addr = sock.recvfrom(2048)
+            gateway.handle(data, addr[:2])
+    finish()
+
+
+if __name__ == '__main__':
+    main()
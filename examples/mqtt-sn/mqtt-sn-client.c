@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         An MQTT-SN client that goes through the features of the MQTT-SN
+ *         engine: it registers a topic, subscribes, publishes with QoS -1, 0
+ *         and 1, sleeps while the gateway buffers a message for it, and
+ *         wakes up to get the message. It prints the traffic it has caused,
+ *         and the simple-energest module prints the Energest summary.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "mqtt-sn.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_SN_CLIENT_CONF_GATEWAY_IP_ADDR
+#define GATEWAY_IP_ADDR MQTT_SN_CLIENT_CONF_GATEWAY_IP_ADDR
+#else
+#define GATEWAY_IP_ADDR "fd00::1"
+#endif
+
+#ifdef MQTT_SN_CLIENT_CONF_PUBLISH_COUNT
+#define PUBLISH_COUNT MQTT_SN_CLIENT_CONF_PUBLISH_COUNT
+#else
+#define PUBLISH_COUNT 10
+#endif
+
+#define CLIENT_ID        "sn-client"
+#define DATA_TOPIC       "sensors/temperature"
+#define CONFIG_TOPIC     "config/sn-client"
+#define SHORT_TOPIC      "al"
+#define PREDEFINED_TOPIC 1
+#define KEEP_ALIVE       60
+#define SLEEP_DURATION   10
+#define EVENT_TIMEOUT    (CLOCK_SECOND * 10)
+/*---------------------------------------------------------------------------*/
+PROCESS(mqtt_sn_client_process, "MQTT-SN client");
+AUTOSTART_PROCESSES(&mqtt_sn_client_process);
+/*---------------------------------------------------------------------------*/
+static struct mqtt_sn_connection conn;
+static mqtt_sn_event_t last_event;
+static uint8_t got_event;
+static unsigned acked;
+static unsigned received;
+static unsigned errors;
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_sn_event(struct mqtt_sn_connection *m, mqtt_sn_event_t event, void *data)
+{
+  struct mqtt_sn_message *msg;
+  struct mqtt_sn_puback_event *puback;
+
+  switch(event) {
+  case MQTT_SN_EVENT_PUBLISH:
+    msg = data;
+    printf("Received '%.*s' on topic '%s'\n", msg->payload_chunk_length,
+           (const char *)msg->payload_chunk, msg->topic);
+    received++;
+    return;
+  case MQTT_SN_EVENT_PUBACK:
+    puback = data;
+    if(puback->return_code != MQTT_SN_RC_ACCEPTED) {
+      printf("Message %u rejected, return code %u\n",
+             puback->mid, puback->return_code);
+      errors++;
+    }
+    acked++;
+    break;
+  case MQTT_SN_EVENT_REGACK:
+    printf("Registered topic ID %u\n",
+           ((struct mqtt_sn_regack_event *)data)->topic_id);
+    break;
+  case MQTT_SN_EVENT_SUBACK:
+    printf("Subscribed, success %u\n",
+           ((struct mqtt_sn_suback_event *)data)->success);
+    break;
+  default:
+    printf("MQTT-SN event %u\n", event);
+    break;
+  }
+
+  last_event = event;
+  got_event = 1;
+  process_poll(&mqtt_sn_client_process);
+}
+/*---------------------------------------------------------------------------*/
+/* Waits for an event, or for the timeout */
+#define WAIT_FOR(event) do {                                    \
+    etimer_set(&et, EVENT_TIMEOUT);                             \
+    got_event = 0;                                              \
+    PROCESS_WAIT_UNTIL((got_event && last_event == (event)) ||  \
+                       etimer_expired(&et));                    \
+    if(!got_event || last_event != (event)) {                   \
+      printf("Did not get event %u\n", (event));                \
+      errors++;                                                 \
+    }                                                           \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_sn_client_process, ev, data)
+{
+  static struct etimer et;
+  static uint16_t topic_id;
+  static unsigned i;
+  static char payload[32];
+
+  PROCESS_BEGIN();
+
+  mqtt_sn_register(&conn, &mqtt_sn_client_process, CLIENT_ID, mqtt_sn_event,
+                   0);
+
+  /* Let the network interface come up */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_UNTIL(etimer_expired(&et));
+
+  /* QoS -1 needs no connection */
+  mqtt_sn_set_gateway(&conn, GATEWAY_IP_ADDR, MQTT_SN_DEFAULT_PORT);
+  snprintf(payload, sizeof(payload), "node started");
+  mqtt_sn_publish(&conn, NULL, PREDEFINED_TOPIC,
+                  MQTT_SN_TOPIC_TYPE_PREDEFINED, (uint8_t *)payload,
+                  strlen(payload), MQTT_SN_QOS_LEVEL_MINUS_1,
+                  MQTT_SN_RETAIN_OFF);
+
+  mqtt_sn_connect(&conn, GATEWAY_IP_ADDR, MQTT_SN_DEFAULT_PORT, KEEP_ALIVE,
+                  MQTT_SN_CLEAN_SESSION_ON);
+  WAIT_FOR(MQTT_SN_EVENT_CONNECTED);
+
+  mqtt_sn_register_topic(&conn, NULL, DATA_TOPIC);
+  WAIT_FOR(MQTT_SN_EVENT_REGACK);
+  topic_id = mqtt_sn_topic_id(&conn, DATA_TOPIC);
+
+  mqtt_sn_subscribe(&conn, NULL, CONFIG_TOPIC, MQTT_SN_QOS_LEVEL_1);
+  WAIT_FOR(MQTT_SN_EVENT_SUBACK);
+
+  for(i = 0; i < PUBLISH_COUNT; i++) {
+    snprintf(payload, sizeof(payload), "reading %u", i);
+    mqtt_sn_publish(&conn, NULL, topic_id, MQTT_SN_TOPIC_TYPE_NORMAL,
+                    (uint8_t *)payload, strlen(payload),
+                    MQTT_SN_QOS_LEVEL_1, MQTT_SN_RETAIN_OFF);
+    WAIT_FOR(MQTT_SN_EVENT_PUBACK);
+  }
+
+  snprintf(payload, sizeof(payload), "alarm");
+  mqtt_sn_publish(&conn, NULL, MQTT_SN_SHORT_TOPIC_ID(SHORT_TOPIC),
+                  MQTT_SN_TOPIC_TYPE_SHORT, (uint8_t *)payload,
+                  strlen(payload), MQTT_SN_QOS_LEVEL_0, MQTT_SN_RETAIN_OFF);
+
+  /* The gateway buffers messages to the client while it sleeps */
+  mqtt_sn_sleep(&conn, SLEEP_DURATION);
+  WAIT_FOR(MQTT_SN_EVENT_ASLEEP);
+
+  etimer_set(&et, CLOCK_SECOND * 2);
+  PROCESS_WAIT_UNTIL(etimer_expired(&et));
+
+  mqtt_sn_wake(&conn);
+  WAIT_FOR(MQTT_SN_EVENT_ASLEEP);
+
+  if(received == 0) {
+    printf("No buffered message after waking up\n");
+    errors++;
+  }
+
+  /* Become active again and leave */
+  mqtt_sn_connect(&conn, GATEWAY_IP_ADDR, MQTT_SN_DEFAULT_PORT, KEEP_ALIVE,
+                  MQTT_SN_CLEAN_SESSION_OFF);
+  WAIT_FOR(MQTT_SN_EVENT_CONNECTED);
+  mqtt_sn_disconnect(&conn);
+  WAIT_FOR(MQTT_SN_EVENT_DISCONNECTED);
+
+  if(acked != PUBLISH_COUNT) {
+    printf("Got %u acknowledgements, expected %u\n", acked, PUBLISH_COUNT);
+    errors++;
+  }
+
+  printf("Traffic: sent %lu datagrams (%lu bytes), received %lu datagrams "
+         "(%lu bytes), %u retransmissions\n",
+         (unsigned long)conn.stats.tx_datagrams,
+         (unsigned long)conn.stats.tx_bytes,
+         (unsigned long)conn.stats.rx_datagrams,
+         (unsigned long)conn.stats.rx_bytes,
+         conn.stats.retransmissions);
+  printf("MQTT-SN client finished, errors %u\n", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Subscribes to a topic with a long name and checks a large message
+ *         published on it. The payload is received in chunks that point into
+ *         the TCP input buffer; each chunk is checked against the expected
+ *         payload pattern and its offset in the message.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "mqtt.h"
+#include "mqtt-prop.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#ifdef MQTT_STREAM_CONF_BROKER_IP_ADDR
+#define BROKER_IP_ADDR MQTT_STREAM_CONF_BROKER_IP_ADDR
+#else
+#define BROKER_IP_ADDR "fd00::1"
+#endif
+
+#ifdef MQTT_STREAM_CONF_BROKER_PORT
+#define BROKER_PORT MQTT_STREAM_CONF_BROKER_PORT
+#else
+#define BROKER_PORT 1883
+#endif
+
+#define CLIENT_ID        "stream"
+/* Longer than the default MQTT_MAX_TOPIC_LENGTH */
+#define TOPIC            "stream/config/with/a/topic/name/that/does/not/fit/" \
+                         "in/the/topic/buffer/of/the/engine"
+#define KEEP_ALIVE       60
+#define MAX_SEGMENT_SIZE 512
+#define RECEIVE_TIMEOUT  (CLOCK_SECOND * 20)
+/*---------------------------------------------------------------------------*/
+PROCESS(mqtt_stream_process, "MQTT stream");
+AUTOSTART_PROCESSES(&mqtt_stream_process);
+/*---------------------------------------------------------------------------*/
+static struct mqtt_connection conn;
+static uint32_t received;
+static unsigned chunks;
+static unsigned errors;
+static uint8_t done;
+/*---------------------------------------------------------------------------*/
+static void
+check_message(struct mqtt_message *msg)
+{
+  uint16_t i;
+
+  if(msg->first_chunk) {
+    printf("Receiving %lu bytes on topic '%s' (%u characters)\n",
+           (unsigned long)msg->payload_length, msg->topic, msg->topic_length);
+    if(msg->topic_length != strlen(TOPIC) ||
+       strlen(msg->topic) != MIN(strlen(TOPIC), MQTT_MAX_TOPIC_LENGTH) ||
+       strncmp(msg->topic, TOPIC, strlen(msg->topic)) != 0) {
+      printf("Unexpected topic\n");
+      errors++;
+    }
+  }
+
+  if(msg->payload_offset != received ||
+     msg->payload_offset + msg->payload_chunk_length + msg->payload_left !=
+     msg->payload_length) {
+    printf("Chunk at offset %lu, expected %lu\n",
+           (unsigned long)msg->payload_offset, (unsigned long)received);
+    errors++;
+  }
+
+  for(i = 0; i < msg->payload_chunk_length; i++) {
+    if(msg->payload_chunk[i] != (msg->payload_offset + i) % 251) {
+      printf("Unexpected byte at offset %lu\n",
+             (unsigned long)(msg->payload_offset + i));
+      errors++;
+      break;
+    }
+  }
+
+  received += msg->payload_chunk_length;
+  chunks++;
+
+  if(msg->payload_left == 0) {
+    done = 1;
+    process_poll(&mqtt_stream_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
+{
+  switch(event) {
+  case MQTT_EVENT_CONNECTED:
+    printf("Connected to the broker\n");
+    break;
+  case MQTT_EVENT_DISCONNECTED:
+    printf("Disconnected from the broker\n");
+    break;
+  case MQTT_EVENT_SUBACK:
+    printf("Subscribed\n");
+    break;
+  case MQTT_EVENT_PUBLISH:
+    check_message(data);
+    break;
+  default:
+    printf("MQTT event %u\n", event);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(mqtt_stream_process, ev, data)
+{
+  static struct etimer et;
+  static clock_time_t start;
+  mqtt_status_t status;
+
+  PROCESS_BEGIN();
+
+  mqtt_register(&conn, &mqtt_stream_process, CLIENT_ID, mqtt_event,
+                MAX_SEGMENT_SIZE);
+
+#if MQTT_5
+  mqtt_connect(&conn, BROKER_IP_ADDR, BROKER_PORT, KEEP_ALIVE,
+               MQTT_CLEAN_SESSION_ON, MQTT_PROP_LIST_NONE);
+#else
+  mqtt_connect(&conn, BROKER_IP_ADDR, BROKER_PORT, KEEP_ALIVE,
+               MQTT_CLEAN_SESSION_ON);
+#endif
+
+  while(!mqtt_connected(&conn)) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  do {
+#if MQTT_5
+    status = mqtt_subscribe(&conn, NULL, TOPIC, MQTT_QOS_LEVEL_0,
+                            MQTT_NL_OFF, MQTT_RAP_OFF, MQTT_RET_H_SEND_ALL,
+                            MQTT_PROP_LIST_NONE);
+#else
+    status = mqtt_subscribe(&conn, NULL, TOPIC, MQTT_QOS_LEVEL_0);
+#endif
+    if(status != MQTT_STATUS_OK) {
+      PROCESS_WAIT_EVENT();
+    }
+  } while(status != MQTT_STATUS_OK);
+
+  start = clock_time();
+  etimer_set(&et, RECEIVE_TIMEOUT);
+  while(!done && !etimer_expired(&et)) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  if(!done) {
+    printf("Got %lu bytes before the timeout\n", (unsigned long)received);
+    errors++;
+  }
+
+  printf("Received %lu bytes in %u chunks in %lu ms\n",
+         (unsigned long)received, chunks,
+         (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND));
+  printf("MQTT stream finished, errors %u\n", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+#
+# A stand-in for a DNS server, for testing the resolver of the native
+# example node. It answers A and AAAA questions from a fixed zone. Names
+# outside the zone get a "name error" with an SOA record, and names of the
+# zone without a record of the asked type get an empty answer with an SOA
+# record.
+#
+# A summary of the received questions is printed when it exits. Each
+# question is also printed, so that the repeated questions for a name can
+# be counted.
+#
+# Options:
+#   --port P          UDP port to listen on (default 10053)
+#   --duration S      exit after S seconds (default: run until SIGTERM)
+#
+import argparse
+import ipaddress
+import select
+import signal
+import socket
+import struct
+import sys
+import time
+
+TYPE_A = 1
+TYPE_SOA = 6
+TYPE_AAAA = 28
+
+# name: {type: (address, ttl)}
+ZONE = {
+    'broker.example': {TYPE_AAAA: ('fd00::10', 300)},
+    'short.example': {TYPE_AAAA: ('fd00::11', 2)},
+    'legacy.example': {TYPE_A: ('10.0.0.12', 300)},
+    'dual.example': {TYPE_AAAA: ('fd00::13', 300), TYPE_A: ('10.0.0.13', 300)},
+    'nodata.example': {},
+}
+for n in range(8):
+    ZONE['host%u.example' % n] = {TYPE_AAAA: ('fd00::1%02x' % n, 300)}
+
+# The MINIMUM field of the SOA record limits the negative caching time
+SOA_TTL = 3600
+SOA_MINIMUM = 60
+
+
+def encode_name(name):
+    return b''.join(bytes([len(label)]) + label.encode()
+                    for label in name.split('.')) + b'\x00'
+
+
+def soa_record():
+    rdata = encode_name('ns.example') + encode_name('admin.example') + \
+        struct.pack('>IIIII', 1, 3600, 600, 86400, SOA_MINIMUM)
+    return encode_name('example') + \
+        struct.pack('>HHIH', TYPE_SOA, 1, SOA_TTL, len(rdata)) + rdata
+
+
+def parse_question(data):
+    """Returns (id, name, type) of a query, or None."""
+    if len(data) < 12:
+        return None
+    qid, flags, qdcount = struct.unpack('>HHH', data[:6])
+    if flags & 0x8000 or qdcount != 1:
+        return None
+    pos = 12
+    labels = []
+    while pos < len(data) and data[pos] != 0:
+        length = data[pos]
+        labels.append(data[pos + 1:pos + 1 + length].decode())
+        pos += 1 + length
+    qtype, qclass = struct.unpack('>HH', data[pos + 1:pos + 5])
+    return qid, '.'.join(labels).lower(), qtype, data[12:pos + 5]
+
+
+def answer(query):
+    qid, name, qtype, question = query
+    rcode = 0
+    answers = []
+    authority = []
+    if name not in ZONE:
+        rcode = 3
+        authority.append(soa_record())
+    elif qtype in ZONE[name]:
+        address, ttl = ZONE[name][qtype]
+        rdata = ipaddress.ip_address(address).packed
+        # The name of the answer points to the name of the question
+        answers.append(struct.pack('>HHHIH', 0xC00C, qtype, 1, ttl,
+                                   len(rdata)) + rdata)
+    else:
+        authority.append(soa_record())
+    return struct.pack('>HHHHHH', qid, 0x8180 | rcode, 1, len(answers),
+                       len(authority), 0) + question + \
+        b''.join(answers) + b''.join(authority)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--port', type=int, default=10053)
+    parser.add_argument('--duration', type=float, default=0)
+    args = parser.parse_args()
+
+    counts = {TYPE_A: 0, TYPE_AAAA: 0}
+
+    def finish(*unused):
+        print("DNS stand-in: questions %u A %u AAAA %u" %
+              (sum(counts.values()), counts[TYPE_A], counts[TYPE_AAAA]),
+              flush=True)
+        sys.exit(0)
+
+    signal.signal(signal.SIGTERM, finish)
+    signal.signal(signal.SIGINT, finish)
+
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(('::', args.port))
+
+    deadline = time.time() + args.duration if args.duration else None
+    while deadline is None or time.time() < deadline:
+        readable, _, _ = select.select([sock], [], [], 0.1)
+        if readable:
+            data, address = sock.recvfrom(2048)
+            query = parse_question(data)
+            if query is None:
+                continue
+            counts[query[2]] = counts.get(query[2], 0) + 1
+            print("Question: %s %s" %
+                  (query[1], {TYPE_A: 'A', TYPE_AAAA: 'AAAA'}.get(
+                      query[2], str(query[2]))), flush=True)
+            sock.sendto(answer(query), address)
+    finish()
+
+
+if __name__ == '__main__':
+    main()
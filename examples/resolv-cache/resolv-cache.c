@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Test of the cache of the DNS resolver. The node resolves a set of
+ *         names at once through the DNS stand-in on the host, and checks
+ *         the cached addresses, the negative answers, the expiration of
+ *         the records and the replacement of the least recently used
+ *         names. The statistics of the resolver are printed at the end.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "resolv.h"
+#include "net/ipv6/uiplib.h"
+#include "net/ipv6/uip-nameserver.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define NAMESERVER   "fd00::1"
+#define MAX_WAIT     (CLOCK_SECOND * 5)
+#define HOSTS        6
+/*---------------------------------------------------------------------------*/
+PROCESS(resolv_cache_process, "Resolver cache test");
+AUTOSTART_PROCESSES(&resolv_cache_process);
+/*---------------------------------------------------------------------------*/
+struct expected_name {
+  const char *name;
+  resolv_status_t status;
+  const char *address;
+};
+
+static const struct expected_name zone[] = {
+  { "broker.example", RESOLV_STATUS_CACHED, "fd00::10" },
+  { "short.example", RESOLV_STATUS_CACHED, "fd00::11" },
+#if RESOLV_CONF_SUPPORTS_A_RECORDS
+  { "legacy.example", RESOLV_STATUS_CACHED, "64:ff9b::a00:c" },
+#else
+  { "legacy.example", RESOLV_STATUS_NOT_FOUND, NULL },
+#endif
+  { "dual.example", RESOLV_STATUS_CACHED, "fd00::13" },
+  { "missing.example", RESOLV_STATUS_NOT_FOUND, NULL },
+  { "nodata.example", RESOLV_STATUS_NOT_FOUND, NULL },
+};
+#define ZONE_SIZE (sizeof(zone) / sizeof(zone[0]))
+
+static char hosts[HOSTS][16];
+static struct etimer timer;
+static unsigned long errors;
+/*---------------------------------------------------------------------------*/
+static void
+check_name(const char *name, resolv_status_t status, const char *address)
+{
+  resolv_status_t ret;
+  uip_ipaddr_t *ipaddr = NULL;
+  uip_ipaddr_t expected;
+  char buf[UIPLIB_IPV6_MAX_STR_LEN];
+
+  ret = resolv_lookup(name, &ipaddr);
+  if(ret != status) {
+    printf("%s: status %u, expected %u\n", name, ret, status);
+    errors++;
+    return;
+  }
+  if(address != NULL) {
+    uiplib_ipaddrconv(address, &expected);
+    if(!uip_ipaddr_cmp(ipaddr, &expected)) {
+      uiplib_ipaddr_snprint(buf, sizeof(buf), ipaddr);
+      printf("%s: address %s, expected %s\n", name, buf, address);
+      errors++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_resolving(const char *name)
+{
+  return resolv_lookup(name, NULL) == RESOLV_STATUS_RESOLVING;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_stats(void)
+{
+  struct resolv_stats stats;
+
+  resolv_get_stats(&stats);
+  printf("Lookups: hits %lu misses %lu\n",
+         (unsigned long)stats.lookup_hits, (unsigned long)stats.lookup_misses);
+  printf("Queries: %lu, cache hits %lu negative hits %lu joined %lu"
+         " evictions %lu\n",
+         (unsigned long)stats.queries, (unsigned long)stats.cache_hits,
+         (unsigned long)stats.negative_hits, (unsigned long)stats.joined,
+         (unsigned long)stats.evictions);
+  printf("Questions: %lu, answers %lu failures %lu\n",
+         (unsigned long)stats.questions, (unsigned long)stats.answers,
+         (unsigned long)stats.failures);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(resolv_cache_process, ev, data)
+{
+  static uint8_t i;
+  static clock_time_t start;
+  static struct resolv_stats stats;
+  static uint32_t questions;
+  uip_ipaddr_t nameserver;
+
+  PROCESS_BEGIN();
+
+  /* Let the tun interface come up */
+  etimer_set(&timer, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+
+  uiplib_ipaddrconv(NAMESERVER, &nameserver);
+  uip_nameserver_update(&nameserver, UIP_NAMESERVER_INFINITE_LIFETIME);
+
+  /* The names are resolved at once. The second query of the first name
+     joins the first one. */
+  start = clock_time();
+  for(i = 0; i < ZONE_SIZE; i++) {
+    resolv_query(zone[i].name);
+  }
+  resolv_query(zone[0].name);
+
+  etimer_set(&timer, MAX_WAIT);
+  for(i = 0; i < ZONE_SIZE; i++) {
+    while(is_resolving(zone[i].name) && !etimer_expired(&timer)) {
+      PROCESS_WAIT_EVENT_UNTIL(ev == resolv_event_found ||
+                               etimer_expired(&timer));
+    }
+  }
+  printf("Resolved %u names in %lu ms\n", (unsigned)ZONE_SIZE,
+         (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND));
+
+  for(i = 0; i < ZONE_SIZE; i++) {
+    check_name(zone[i].name, zone[i].status, zone[i].address);
+  }
+
+  /* Answers that arrived together may still have their events queued.
+     Let them be delivered first, so that they are not taken for the
+     events of the cached answers below. */
+  PROCESS_PAUSE();
+
+  /* The cached answers are reported without asking the server */
+  resolv_get_stats(&stats);
+  resolv_query("broker.example");
+  PROCESS_WAIT_EVENT_UNTIL(ev == resolv_event_found);
+  resolv_query("missing.example");
+  PROCESS_WAIT_EVENT_UNTIL(ev == resolv_event_found);
+  if(strcmp(data, "missing.example") != 0) {
+    printf("Unexpected event for %s\n", (char *)data);
+    errors++;
+  }
+  check_name("broker.example", RESOLV_STATUS_CACHED, "fd00::10");
+  check_name("missing.example", RESOLV_STATUS_NOT_FOUND, NULL);
+  questions = stats.questions;
+  resolv_get_stats(&stats);
+  if(stats.questions != questions) {
+    printf("Cached names were asked again\n");
+    errors++;
+  }
+
+  /* The record of short.example has a TTL of two seconds */
+  etimer_set(&timer, CLOCK_SECOND * 3);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+  check_name("short.example", RESOLV_STATUS_EXPIRED, NULL);
+  resolv_query("short.example");
+  etimer_set(&timer, MAX_WAIT);
+  while(is_resolving("short.example") && !etimer_expired(&timer)) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == resolv_event_found ||
+                             etimer_expired(&timer));
+  }
+  check_name("short.example", RESOLV_STATUS_CACHED, "fd00::11");
+
+  /* New names replace the least recently used ones. The broker name
+     was just used, so it stays in the cache. */
+  check_name("broker.example", RESOLV_STATUS_CACHED, "fd00::10");
+  for(i = 0; i < HOSTS; i++) {
+    snprintf(hosts[i], sizeof(hosts[i]), "host%u.example", i);
+    resolv_query(hosts[i]);
+  }
+  etimer_set(&timer, MAX_WAIT);
+  for(i = 0; i < HOSTS; i++) {
+    while(is_resolving(hosts[i]) && !etimer_expired(&timer)) {
+      PROCESS_WAIT_EVENT_UNTIL(ev == resolv_event_found ||
+                               etimer_expired(&timer));
+    }
+    if(resolv_lookup(hosts[i], NULL) != RESOLV_STATUS_CACHED) {
+      printf("%s was not resolved\n", hosts[i]);
+      errors++;
+    }
+  }
+  check_name("broker.example", RESOLV_STATUS_CACHED, "fd00::10");
+
+  print_stats();
+  resolv_get_stats(&stats);
+  if(stats.cache_hits != 1 || stats.negative_hits != 1 ||
+     stats.joined != 1 || stats.evictions != HOSTS - 2) {
+    printf("Unexpected statistics\n");
+    errors++;
+  }
+
+  printf("Resolver cache test finished, errors %lu\n", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         RPL Classic DAO benchmark, in storing mode. The node joins a DAG
+ *         through the DIOs of a made-up parent, and is the parent of
+ *         children with made-up subtrees. Then, for every topology change
+ *         (a new DAG version), the children register the targets of their
+ *         subtree again, at random times within a DAO delay. The parent
+ *         acknowledges all the DAOs the node forwards.
+ *
+ *         The benchmark reports the DAOs and DAO ACKs the node receives
+ *         and sends for each topology change, and checks that every target
+ *         reaches the parent and every DAO of a child is acknowledged,
+ *         once. Without DAO aggregation, the children send a DAO per
+ *         target; with it, a DAO for all the targets of their subtree.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/routing/rpl-classic/rpl.h"
+#include "net/routing/rpl-classic/rpl-private.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/packetbuf.h"
+#include "net/link-stats.h"
+#include "net/mac/mac.h"
+#include "net/routing/routing.h"
+#include "lib/random.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define CHILDREN   8
+#define TARGETS    (CHILDREN * (CHILDREN + 1) / 2)
+#define ROUNDS     3
+#define DAO_SPREAD (2 * CLOCK_SECOND)
+#define TICK       (CLOCK_SECOND / 50)
+#define TIMEOUT    (20 * CLOCK_SECOND)
+/*---------------------------------------------------------------------------*/
+PROCESS(rpl_dao_bench_process, "RPL DAO benchmark");
+AUTOSTART_PROCESSES(&rpl_dao_bench_process);
+/*---------------------------------------------------------------------------*/
+/* A DAO that a child sends within the DAO delay */
+struct child_dao {
+  clock_time_t time;
+  uint8_t child;
+  uint8_t first;
+  uint8_t count;
+  uint8_t sent;
+};
+
+static rpl_dio_t dio;
+static linkaddr_t parent_lladdr;
+static uip_ipaddr_t parent_ipaddr;
+static linkaddr_t child_lladdrs[CHILDREN];
+static uip_ipaddr_t child_ipaddrs[CHILDREN];
+static uint8_t child_seqnos[CHILDREN];
+static struct child_dao daos[TARGETS];
+static int dao_count;
+static unsigned parent_acks;
+/*---------------------------------------------------------------------------*/
+static void
+init_dio(void)
+{
+  dio.instance_id = RPL_DEFAULT_INSTANCE;
+  dio.ocp = RPL_OF_OCP;
+  dio.mop = RPL_MOP_STORING_NO_MULTICAST;
+  dio.grounded = 1;
+  dio.version = 240;
+  dio.dtsn = 240;
+  dio.dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+  dio.dag_intmin = RPL_DIO_INTERVAL_MIN;
+  dio.dag_redund = RPL_DIO_REDUNDANCY;
+  dio.default_lifetime = RPL_DEFAULT_LIFETIME;
+  dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+  dio.dag_max_rankinc = RPL_MAX_RANKINC;
+  dio.dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+  dio.rank = RPL_MIN_HOPRANKINC;
+  dio.mc.type = RPL_DAG_MC_NONE;
+  uip_ip6addr(&dio.dag_id, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+  uip_ip6addr(&dio.prefix_info.prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+  dio.prefix_info.length = 64;
+  dio.prefix_info.flags = UIP_ND6_RA_FLAG_AUTONOMOUS;
+  dio.prefix_info.lifetime = 0xffffffff;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init_neighbor(linkaddr_t *lladdr, uip_ipaddr_t *ipaddr, uint8_t id)
+{
+  memset(lladdr, 0, sizeof(*lladdr));
+  lladdr->u8[0] = 0x02;
+  lladdr->u8[LINKADDR_SIZE - 1] = id;
+  uip_ip6addr(ipaddr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(ipaddr, (uip_lladdr_t *)lladdr);
+}
+/*---------------------------------------------------------------------------*/
+/* Target k of the subtree of child c; child c has c + 1 targets */
+static void
+target_addr(uip_ipaddr_t *addr, int c, int k)
+{
+  uip_ip6addr(addr, 0xfd00, 0, 0, 0, 0x200, 0, c + 1, k + 1);
+}
+/*---------------------------------------------------------------------------*/
+/* Hand an RPL message from a neighbor to the stack, as the radio would */
+static void
+input_rpl(const uip_ipaddr_t *from, const linkaddr_t *lladdr, uint8_t code,
+          int payload_len)
+{
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = 64;
+  uipbuf_set_len_field(UIP_IP_BUF, UIP_ICMPH_LEN + payload_len);
+  uip_ipaddr_copy(&UIP_IP_BUF->srcipaddr, from);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr,
+                  &uip_ds6_get_link_local(-1)->ipaddr);
+  UIP_ICMP_BUF->type = ICMP6_RPL;
+  UIP_ICMP_BUF->icode = code;
+  UIP_ICMP_BUF->icmpchksum = 0;
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + payload_len;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  packetbuf_clear();
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, lladdr);
+  tcpip_input();
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_dao(struct child_dao *dao)
+{
+  unsigned char *buffer;
+  uip_ipaddr_t target;
+  int pos;
+  int k;
+
+  uipbuf_clear();
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+  buffer[pos++] = RPL_DEFAULT_INSTANCE;
+  buffer[pos++] = RPL_DAO_K_FLAG;
+  buffer[pos++] = 0;
+  RPL_LOLLIPOP_INCREMENT(child_seqnos[dao->child]);
+  buffer[pos++] = child_seqnos[dao->child];
+  for(k = dao->first; k < dao->first + dao->count; k++) {
+    target_addr(&target, dao->child, k);
+    buffer[pos++] = RPL_OPTION_TARGET;
+    buffer[pos++] = 2 + sizeof(target);
+    buffer[pos++] = 0;
+    buffer[pos++] = sizeof(target) * CHAR_BIT;
+    memcpy(buffer + pos, &target, sizeof(target));
+    pos += sizeof(target);
+  }
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = 4;
+  buffer[pos++] = 0;
+  buffer[pos++] = 0;
+  buffer[pos++] = 0;
+  buffer[pos++] = RPL_DEFAULT_LIFETIME;
+
+  input_rpl(&child_ipaddrs[dao->child], &child_lladdrs[dao->child],
+            RPL_CODE_DAO, pos);
+  dao->sent = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_dao_ack(uint8_t sequence)
+{
+  unsigned char *buffer;
+
+  uipbuf_clear();
+  buffer = UIP_ICMP_PAYLOAD;
+  buffer[0] = RPL_DEFAULT_INSTANCE;
+  buffer[1] = 0;
+  buffer[2] = sequence;
+  buffer[3] = RPL_DAO_ACK_UNCONDITIONAL_ACCEPT;
+  input_rpl(&parent_ipaddr, &parent_lladdr, RPL_CODE_DAO_ACK, 4);
+}
+/*---------------------------------------------------------------------------*/
+/* The DAOs of the children after a topology change */
+static void
+plan_daos(clock_time_t start)
+{
+  int c;
+  int k;
+
+  dao_count = 0;
+  for(c = 0; c < CHILDREN; c++) {
+    for(k = 0; k < c + 1; k++) {
+      if(!RPL_WITH_DAO_AGGREGATION || k % RPL_DAO_AGGREGATION_MAX_TARGETS == 0) {
+        daos[dao_count].time = start + random_rand() % DAO_SPREAD;
+        daos[dao_count].child = c;
+        daos[dao_count].first = k;
+        daos[dao_count].count = 0;
+        daos[dao_count].sent = 0;
+        dao_count++;
+      }
+      daos[dao_count - 1].count++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Send the DAOs that are due, and acknowledge what the node forwarded.
+ * Returns the routes that are still to be forwarded or acknowledged. */
+static int
+step(clock_time_t now)
+{
+  rpl_instance_t *instance;
+  uip_ds6_route_t *r;
+  int busy;
+  int i;
+
+  for(i = 0; i < dao_count; i++) {
+    if(!daos[i].sent && daos[i].time <= now) {
+      send_dao(&daos[i]);
+    }
+  }
+
+  instance = rpl_get_default_instance();
+  if(!ctimer_expired(&instance->dao_retransmit_timer)) {
+    send_dao_ack(instance->my_dao_seqno);
+  }
+
+  busy = 0;
+  r = uip_ds6_route_head();
+  while(r != NULL) {
+    if(RPL_ROUTE_IS_DAO_PENDING(r)) {
+      /* Acknowledges all the routes with this sequence number */
+      send_dao_ack(r->state.dao_seqno_out);
+      parent_acks++;
+      if(!RPL_ROUTE_IS_DAO_PENDING(r)) {
+        r = uip_ds6_route_head();
+        continue;
+      }
+    }
+    if(RPL_ROUTE_IS_DAO_PENDING(r) || RPL_ROUTE_IS_DAO_FWD(r)) {
+      busy++;
+    }
+    r = uip_ds6_route_next(r);
+  }
+
+  for(i = 0; i < dao_count; i++) {
+    busy += !daos[i].sent;
+  }
+  return busy;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_dao_bench_process, ev, data)
+{
+  static struct etimer et;
+  static rpl_stats_t before;
+  static clock_time_t start;
+  static unsigned long packets;
+  static unsigned long elapsed;
+  static int unacked;
+  static int lost;
+  static int round;
+  static int i;
+
+  PROCESS_BEGIN();
+
+  /* Let the stack start */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  random_init(1);
+  init_dio();
+  init_neighbor(&parent_lladdr, &parent_ipaddr, 0xff);
+  uip_ds6_nbr_add(&parent_ipaddr, (uip_lladdr_t *)&parent_lladdr, 1,
+                  NBR_REACHABLE, NBR_TABLE_REASON_UNDEFINED, NULL);
+  link_stats_packet_sent(&parent_lladdr, MAC_TX_OK, 1);
+  for(i = 0; i < CHILDREN; i++) {
+    init_neighbor(&child_lladdrs[i], &child_ipaddrs[i], i + 1);
+  }
+  rpl_process_dio(&parent_ipaddr, &dio);
+  printf("RPL DAO bench: %u children, %u targets, aggregation %u, joined %u\n",
+         CHILDREN, TARGETS, RPL_WITH_DAO_AGGREGATION,
+         NETSTACK_ROUTING.node_has_joined());
+
+  packets = 0;
+  elapsed = 0;
+  unacked = 0;
+  lost = 0;
+  for(round = 0; round < ROUNDS; round++) {
+    /* A new DAG version: everybody registers again */
+    dio.version++;
+    rpl_process_dio(&parent_ipaddr, &dio);
+
+    before = rpl_stats;
+    parent_acks = 0;
+    start = clock_time();
+    plan_daos(start);
+    while(step(clock_time()) > 0 && clock_time() - start < TIMEOUT) {
+      etimer_set(&et, TICK);
+      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    }
+
+    printf("RPL DAO bench: round %d, received %u DAOs, forwarded %u DAOs with %u targets, "
+           "received %u DAO ACKs, sent %u, %lu ms\n", round,
+           rpl_stats.daos_received - before.daos_received,
+           rpl_stats.daos_forwarded - before.daos_forwarded,
+           rpl_stats.dao_targets_forwarded - before.dao_targets_forwarded,
+           parent_acks, rpl_stats.dao_acks_sent - before.dao_acks_sent,
+           (unsigned long)(clock_time() - start) * 1000 / CLOCK_SECOND);
+
+    packets += (rpl_stats.daos_received - before.daos_received)
+      + (rpl_stats.daos_forwarded - before.daos_forwarded)
+      + parent_acks + (rpl_stats.dao_acks_sent - before.dao_acks_sent);
+    elapsed += clock_time() - start;
+    unacked += dao_count - (rpl_stats.dao_acks_sent - before.dao_acks_sent);
+    lost += TARGETS - (rpl_stats.dao_targets_forwarded - before.dao_targets_forwarded);
+  }
+
+  printf("RPL DAO bench: routes %u/%u, unacked %d, lost %d\n",
+         uip_ds6_route_num_routes(), TARGETS, unacked, lost);
+  printf("RPL DAO bench: %lu control packets and %lu ms per topology change\n",
+         packets / ROUNDS, elapsed * 1000 / CLOCK_SECOND / ROUNDS);
+  printf("RPL DAO bench: done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
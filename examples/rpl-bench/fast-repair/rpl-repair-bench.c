@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         RPL Lite fast repair benchmark. The node joins through the DIOs
+ *         of two made-up parents, and runs over CSMA and 6LoWPAN. The
+ *         radio of the benchmark acknowledges the unicast frames to a
+ *         parent as long as it is alive. After the DAO of the node was
+ *         acknowledged, the preferred parent dies while packets to the
+ *         root are queued for it.
+ *
+ *         The benchmark checks that the node switches to the backup parent
+ *         after RPL_FAST_REPAIR_NOACKS packets without ACK, that the
+ *         packets still queued are moved to the backup parent, except the
+ *         one whose compressed header depends on the old receiver, and
+ *         that the backup parent gets them. It prints the time to switch
+ *         and the time to the DAO ACK through the backup parent.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ipv6/simple-udp.h"
+#include "net/link-stats.h"
+#include "net/mac/mac.h"
+#include "net/mac/framer/frame802154.h"
+#include "net/routing/routing.h"
+#include "dev/radio.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define UDP_PORT       5678
+#define PACKETS_BEFORE RPL_FAST_REPAIR_NOACKS /* Packets to the root before... */
+#define PACKETS_AFTER  3     /* ...and after the one to the parent */
+#define MAX_WAIT       (10 * CLOCK_SECOND)
+/*---------------------------------------------------------------------------*/
+PROCESS(rpl_repair_bench_process, "RPL fast repair benchmark");
+AUTOSTART_PROCESSES(&rpl_repair_bench_process);
+/*---------------------------------------------------------------------------*/
+static rpl_dio_t dio;
+static linkaddr_t lladdrs[2];
+static uip_ipaddr_t ipaddrs[2];
+static struct simple_udp_connection udp_conn;
+static int failures;
+
+/* The radio of the benchmark: the parents that are alive, the unicast
+ * frames sent to each parent and the frames it acknowledged */
+static uint8_t alive[2];
+static uint16_t frames[2];
+static uint16_t acked[2];
+static uint8_t tx_frame[127];
+static uint16_t tx_len;
+static uint8_t ack_dsn;
+static uint8_t ack_pending;
+/*---------------------------------------------------------------------------*/
+static int
+radio_init(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_prepare(const void *payload, unsigned short payload_len)
+{
+  tx_len = MIN(payload_len, sizeof(tx_frame));
+  memcpy(tx_frame, payload, tx_len);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_transmit(unsigned short transmit_len)
+{
+  frame802154_t frame;
+  linkaddr_t dest;
+  int i;
+
+  if(frame802154_parse(tx_frame, tx_len, &frame) == 0) {
+    return RADIO_TX_ERR;
+  }
+  frame802154_extract_linkaddr(&frame, NULL, &dest);
+  for(i = 0; i < 2; i++) {
+    if(linkaddr_cmp(&dest, &lladdrs[i])) {
+      frames[i]++;
+      if(alive[i]) {
+        acked[i]++;
+        ack_dsn = frame.seq;
+        ack_pending = 1;
+      }
+    }
+  }
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_send(const void *payload, unsigned short payload_len)
+{
+  radio_prepare(payload, payload_len);
+  return radio_transmit(payload_len);
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the ACK of the last frame */
+static int
+radio_read(void *buf, unsigned short buf_len)
+{
+  uint8_t *ack = buf;
+
+  if(!ack_pending || buf_len < 3) {
+    return 0;
+  }
+  ack_pending = 0;
+  ack[0] = FRAME802154_ACKFRAME;
+  ack[1] = 0;
+  ack[2] = ack_dsn;
+  return 3;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_channel_clear(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_receiving_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_pending_packet(void)
+{
+  return ack_pending;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_off(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_get_value(radio_param_t param, radio_value_t *value)
+{
+  if(param == RADIO_CONST_MAX_PAYLOAD_LEN) {
+    *value = sizeof(tx_frame);
+    return RADIO_RESULT_OK;
+  }
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_set_value(radio_param_t param, radio_value_t value)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+radio_set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver bench_radio_driver =
+{
+  radio_init,
+  radio_prepare,
+  radio_transmit,
+  radio_send,
+  radio_read,
+  radio_channel_clear,
+  radio_receiving_packet,
+  radio_pending_packet,
+  radio_on,
+  radio_off,
+  radio_get_value,
+  radio_set_value,
+  radio_get_object,
+  radio_set_object
+};
+/*---------------------------------------------------------------------------*/
+static void
+init_dio(void)
+{
+  memset(&dio, 0, sizeof(dio));
+  dio.instance_id = RPL_DEFAULT_INSTANCE;
+  dio.ocp = RPL_OCP_MRHOF;
+  dio.mop = RPL_MOP_NON_STORING;
+  dio.grounded = 1;
+  dio.version = 240;
+  dio.dtsn = 240;
+  dio.dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+  dio.dag_intmin = RPL_DIO_INTERVAL_MIN;
+  dio.dag_redund = RPL_DIO_REDUNDANCY;
+  dio.default_lifetime = RPL_DEFAULT_LIFETIME;
+  dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+  dio.dag_max_rankinc = RPL_MAX_RANKINC;
+  dio.dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+  dio.mc.type = RPL_DAG_MC_NONE;
+  uip_ip6addr(&dio.dag_id, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+  uip_ip6addr(&dio.prefix_info.prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+  dio.prefix_info.length = 64;
+  dio.prefix_info.flags = UIP_ND6_RA_FLAG_AUTONOMOUS;
+  dio.prefix_info.lifetime = 0xffffffff;
+}
+/*---------------------------------------------------------------------------*/
+/* Parent 0 is one hop from the root. Parent 1, the backup, is two hops
+ * from the root, over a worse link. */
+static void
+add_parents(void)
+{
+  int i;
+
+  init_dio();
+  for(i = 0; i < 2; i++) {
+    memset(&lladdrs[i], 0, sizeof(lladdrs[i]));
+    lladdrs[i].u8[0] = 0x02;
+    lladdrs[i].u8[LINKADDR_SIZE - 1] = 0xa0 + i;
+    uip_ip6addr(&ipaddrs[i], 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(&ipaddrs[i], (uip_lladdr_t *)&lladdrs[i]);
+    uip_ds6_nbr_add(&ipaddrs[i], (uip_lladdr_t *)&lladdrs[i], 1,
+                    NBR_REACHABLE, NBR_TABLE_REASON_UNDEFINED, NULL);
+    link_stats_packet_sent(&lladdrs[i], MAC_TX_OK, 1 + 4 * i);
+    alive[i] = 1;
+    dio.rank = (1 + i) * RPL_MIN_HOPRANKINC;
+    rpl_process_dio(&ipaddrs[i], &dio);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+check(const char *what, int ok)
+{
+  printf("RPL repair bench: %s %s\n", what, ok ? "ok" : "FAILED");
+  failures += !ok;
+}
+/*---------------------------------------------------------------------------*/
+static int
+parent_is(int parent)
+{
+  return curr_instance.dag.preferred_parent != NULL
+    && uip_ipaddr_cmp(rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent),
+                      &ipaddrs[parent]);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_repair_bench_process, ev, data)
+{
+  static struct etimer et;
+  static clock_time_t start;
+  static uint8_t dao_seqno;
+  static struct rpl_neighbor_stats stats;
+  static uint16_t acked_before;
+  static uint8_t payload[16];
+  int i;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, NULL);
+
+  /* Let the stack start */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  add_parents();
+  check("joined through parent 0",
+        NETSTACK_ROUTING.node_has_joined() && parent_is(0));
+  check("parent 1 is the backup",
+        rpl_neighbor_get_backup(0) != NULL
+        && uip_ipaddr_cmp(rpl_neighbor_get_ipaddr(rpl_neighbor_get_backup(0)),
+                          &ipaddrs[1]));
+
+  /* Acknowledge our first DAO, as the root would */
+  dao_seqno = curr_instance.dag.dao_last_seqno;
+  start = clock_time();
+  while(curr_instance.dag.dao_last_seqno == dao_seqno
+        && clock_time() - start < MAX_WAIT) {
+    etimer_set(&et, CLOCK_SECOND / 10);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+  dao_seqno = curr_instance.dag.dao_last_seqno;
+  rpl_process_dao_ack(dao_seqno, RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+  check("DAO through parent 0 acknowledged",
+        curr_instance.dag.state == DAG_REACHABLE && acked[0] > 0);
+
+  /* Parent 0 dies, with packets to the root and one packet to parent 0
+   * itself queued for it */
+  rpl_neighbor_reset_stats();
+  alive[0] = 0;
+  acked_before = acked[1];
+  for(i = 0; i < PACKETS_BEFORE + 1 + PACKETS_AFTER; i++) {
+    payload[0] = i;
+    simple_udp_sendto(&udp_conn, payload, sizeof(payload),
+                      i == PACKETS_BEFORE ? &ipaddrs[0] : &dio.dag_id);
+  }
+
+  start = clock_time();
+  do {
+    etimer_set(&et, CLOCK_SECOND / 10);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    rpl_neighbor_get_stats(&stats);
+  } while(stats.repairs == 0 && clock_time() - start < MAX_WAIT);
+
+  check("switched to parent 1", parent_is(1) && stats.repairs == 1);
+  printf("RPL repair bench: requeued %u packets\n", stats.requeued);
+  check("packets to the root requeued", stats.requeued == PACKETS_AFTER);
+
+  /* Acknowledge the DAO through the new parent */
+  start = clock_time();
+  while(curr_instance.dag.dao_last_seqno == dao_seqno
+        && clock_time() - start < MAX_WAIT) {
+    etimer_set(&et, CLOCK_SECOND / 10);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+  rpl_process_dao_ack(curr_instance.dag.dao_last_seqno,
+                      RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+  rpl_neighbor_get_stats(&stats);
+  check("requeued packets and DAO acknowledged by parent 1",
+        acked[1] - acked_before >= PACKETS_AFTER + 1);
+  check("DAO through parent 1 acknowledged", stats.acked_repairs == 1);
+
+  printf("RPL repair bench: switch after %lu ms, DAO ACK after %lu ms\n",
+         (unsigned long)stats.switch_time, (unsigned long)stats.ack_time);
+  printf("RPL repair bench: %d failures\n", failures);
+  printf("RPL repair bench: done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         RPL Lite multi-instance benchmark. The node joins the default
+ *         instance, with MRHOF, and a second instance, with OF0, through
+ *         the DIOs of two made-up parents. Each parent is the better one
+ *         in one of the instances. Packets with a given DSCP are mapped to
+ *         the second instance, and packets with a given flow label back to
+ *         the default instance.
+ *
+ *         The benchmark checks the objective function and the preferred
+ *         parent of each instance, and, for packets sent and forwarded by
+ *         the node, the instance of their RPL hop-by-hop option and their
+ *         next hop. It then leaves the second instance, and checks that
+ *         the default instance keeps its parent, route and address.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/link-stats.h"
+#include "net/mac/mac.h"
+#include "net/routing/routing.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define ALARM_INSTANCE 0x02
+#define ALARM_DSCP     46     /* Expedited Forwarding */
+#define BULK_FLOW      0x12345
+/*---------------------------------------------------------------------------*/
+PROCESS(rpl_instance_bench_process, "RPL multi-instance benchmark");
+AUTOSTART_PROCESSES(&rpl_instance_bench_process);
+/*---------------------------------------------------------------------------*/
+static rpl_dio_t dio;
+static linkaddr_t lladdrs[2];
+static uip_ipaddr_t ipaddrs[2];
+static int failures;
+/*---------------------------------------------------------------------------*/
+static void
+init_dio(uint8_t instance_id, rpl_ocp_t ocp)
+{
+  memset(&dio, 0, sizeof(dio));
+  dio.instance_id = instance_id;
+  dio.ocp = ocp;
+  dio.mop = RPL_MOP_NON_STORING;
+  dio.grounded = 1;
+  dio.version = 240;
+  dio.dtsn = 240;
+  dio.dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+  dio.dag_intmin = RPL_DIO_INTERVAL_MIN;
+  dio.dag_redund = RPL_DIO_REDUNDANCY;
+  dio.default_lifetime = RPL_DEFAULT_LIFETIME;
+  dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+  dio.dag_max_rankinc = RPL_MAX_RANKINC;
+  dio.dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+  dio.mc.type = RPL_DAG_MC_NONE;
+  uip_ip6addr(&dio.dag_id, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+  uip_ip6addr(&dio.prefix_info.prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+  dio.prefix_info.length = 64;
+  dio.prefix_info.flags = UIP_ND6_RA_FLAG_AUTONOMOUS;
+  dio.prefix_info.lifetime = 0xffffffff;
+}
+/*---------------------------------------------------------------------------*/
+/* A DIO from parent i, at a given number of hops from the root */
+static void
+send_dio(int i, int hops)
+{
+  dio.rank = hops * RPL_MIN_HOPRANKINC;
+  rpl_process_dio(&ipaddrs[i], &dio);
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_parents(void)
+{
+  int i;
+
+  for(i = 0; i < 2; i++) {
+    memset(&lladdrs[i], 0, sizeof(lladdrs[i]));
+    lladdrs[i].u8[0] = 0x02;
+    lladdrs[i].u8[LINKADDR_SIZE - 1] = 0xa0 + i;
+    uip_ip6addr(&ipaddrs[i], 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(&ipaddrs[i], (uip_lladdr_t *)&lladdrs[i]);
+    uip_ds6_nbr_add(&ipaddrs[i], (uip_lladdr_t *)&lladdrs[i], 1,
+                    NBR_REACHABLE, NBR_TABLE_REASON_UNDEFINED, NULL);
+    link_stats_packet_sent(&lladdrs[i], MAC_TX_OK, 1);
+  }
+
+  /* Parent 0 is one hop from the root in the default instance, and
+   * parent 1 in the alarm instance */
+  init_dio(RPL_DEFAULT_INSTANCE, RPL_OCP_MRHOF);
+  send_dio(0, 1);
+  send_dio(1, 3);
+  init_dio(ALARM_INSTANCE, RPL_OCP_OF0);
+  send_dio(0, 3);
+  send_dio(1, 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+check(const char *what, int ok)
+{
+  printf("RPL instance bench: %s %s\n", what, ok ? "ok" : "FAILED");
+  failures += !ok;
+}
+/*---------------------------------------------------------------------------*/
+/* The parent of an instance is a given made-up parent, and its OF has a
+ * given OCP. The neighbors of the instance are looked up while it is the
+ * current one. */
+static int
+instance_is(uint8_t instance_id, rpl_ocp_t ocp, int parent)
+{
+  rpl_instance_t *instance = rpl_instance_get(instance_id);
+  rpl_instance_t *prev;
+  int ret;
+
+  if(instance == NULL) {
+    return 0;
+  }
+  prev = rpl_instance_set_current(instance);
+  ret = curr_instance.of->ocp == ocp
+    && curr_instance.dag.preferred_parent != NULL
+    && uip_ipaddr_cmp(rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent),
+                      &ipaddrs[parent]);
+  rpl_instance_set_current(prev);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+/* A UDP packet to the root, as the application would hand it to
+ * tcpip_ipv6_output */
+static void
+build_packet(uint8_t dscp, uint32_t flow_label)
+{
+  uint8_t tc = dscp << 2;
+
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60 | (tc >> 4);
+  UIP_IP_BUF->tcflow = (tc << 4) | ((flow_label >> 16) & 0x0f);
+  UIP_IP_BUF->flow = UIP_HTONS(flow_label & 0xffff);
+  UIP_IP_BUF->proto = UIP_PROTO_UDP;
+  UIP_IP_BUF->ttl = uip_ds6_if.cur_hop_limit;
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &dio.dag_id);
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &dio.dag_id);
+  memset(UIP_IP_PAYLOAD(0), 0, UIP_UDPH_LEN + 4);
+  uip_len = UIP_IPUDPH_LEN + 4;
+  uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
+}
+/*---------------------------------------------------------------------------*/
+/* Updates the RPL headers and finds the next hop as tcpip_ipv6_output
+ * does. Returns the instance of the hop-by-hop option, or -1. */
+static int
+route_packet(uip_ipaddr_t *nexthop)
+{
+  struct uip_ext_hdr_opt_rpl *rpl_opt;
+  uip_ds6_defrt_t *defrt;
+
+  if(!NETSTACK_ROUTING.ext_header_update()) {
+    return -1;
+  }
+  if(!NETSTACK_ROUTING.ext_header_srh_get_next_hop(nexthop)) {
+    defrt = uip_ds6_defrt_head();
+    if(defrt == NULL) {
+      return -1;
+    }
+    uip_ipaddr_copy(nexthop, &defrt->ipaddr);
+  }
+  rpl_opt = (struct uip_ext_hdr_opt_rpl *)UIP_IP_PAYLOAD(2);
+  if(UIP_IP_BUF->proto != UIP_PROTO_HBHO
+     || rpl_opt->opt_type != UIP_EXT_HDR_OPT_RPL) {
+    return -1;
+  }
+  return rpl_opt->instance;
+}
+/*---------------------------------------------------------------------------*/
+/* A packet goes through a given instance, to a given made-up parent */
+static int
+routed_through(uint8_t instance_id, int parent)
+{
+  uip_ipaddr_t nexthop;
+
+  return route_packet(&nexthop) == instance_id
+    && uip_ipaddr_cmp(&nexthop, &ipaddrs[parent]);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_instance_bench_process, ev, data)
+{
+  static struct etimer et;
+  static uip_ipaddr_t nexthop;
+  rpl_instance_t *prev;
+
+  PROCESS_BEGIN();
+
+  /* Let the stack start */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  add_parents();
+  printf("RPL instance bench: %u instances, joined %u\n",
+         RPL_MAX_INSTANCES, NETSTACK_ROUTING.node_has_joined());
+
+  check("default instance, MRHOF, parent 0",
+        instance_is(RPL_DEFAULT_INSTANCE, RPL_OCP_MRHOF, 0));
+  check("alarm instance, OF0, parent 1",
+        instance_is(ALARM_INSTANCE, RPL_OCP_OF0, 1));
+
+  check("map DSCP", rpl_instance_map_dscp(ALARM_DSCP, ALARM_INSTANCE));
+  check("map flow label",
+        rpl_instance_map_flow_label(BULK_FLOW, RPL_DEFAULT_INSTANCE));
+
+  build_packet(0, 0);
+  check("best effort packet through default instance",
+        routed_through(RPL_DEFAULT_INSTANCE, 0));
+  build_packet(ALARM_DSCP, 0);
+  check("EF packet through alarm instance",
+        routed_through(ALARM_INSTANCE, 1));
+  build_packet(ALARM_DSCP, BULK_FLOW);
+  check("EF packet of bulk flow through default instance",
+        routed_through(RPL_DEFAULT_INSTANCE, 0));
+
+  /* A packet of the alarm instance from a child keeps its instance,
+   * whatever its DSCP */
+  build_packet(ALARM_DSCP, 0);
+  route_packet(&nexthop);
+  uip_ip6addr(&UIP_IP_BUF->srcipaddr, 0xfd00, 0, 0, 0, 0x200, 0, 0, 1);
+  UIP_IP_BUF->ttl--;
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  check("forwarded packet through alarm instance",
+        routed_through(ALARM_INSTANCE, 1));
+
+  /* Leave the alarm instance */
+  prev = rpl_instance_set_current(rpl_instance_get(ALARM_INSTANCE));
+  rpl_dag_leave();
+  rpl_instance_set_current(prev);
+
+  check("left alarm instance", rpl_instance_get(ALARM_INSTANCE) == NULL);
+  check("default instance kept",
+        instance_is(RPL_DEFAULT_INSTANCE, RPL_OCP_MRHOF, 0)
+        && NETSTACK_ROUTING.node_has_joined()
+        && uip_ds6_get_global(ADDR_PREFERRED) != NULL);
+  build_packet(ALARM_DSCP, 0);
+  check("EF packet through default instance",
+        routed_through(RPL_DEFAULT_INSTANCE, 0));
+
+  printf("RPL instance bench: %d failures\n", failures);
+  printf("RPL instance bench: done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         RPL Lite parent selection benchmark. The node joins a DAG through
+ *         the DIOs of many neighbors, then updates the link statistics or
+ *         the rank of a random neighbor and selects the best parent, many
+ *         times. It checks that the cached rank through each neighbor is
+ *         the one the OF computes, and that the selected parent has the
+ *         path cost of the one found by asking the OF about all neighbors.
+ *
+ *         It then reports the time per selection after a link update,
+ *         with the cache and when the OF is asked about all neighbors.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/link-stats.h"
+#include "net/mac/mac.h"
+#include "net/routing/routing.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+#define NEIGHBORS   48
+#define ROUNDS      20000
+#define TIME_ROUNDS 200000
+#define INSTANCE_ID 0x1e
+/*---------------------------------------------------------------------------*/
+PROCESS(rpl_parent_bench_process, "RPL parent selection benchmark");
+AUTOSTART_PROCESSES(&rpl_parent_bench_process);
+/*---------------------------------------------------------------------------*/
+static rpl_dio_t dio;
+static linkaddr_t lladdrs[NEIGHBORS];
+static uip_ipaddr_t ipaddrs[NEIGHBORS];
+/*---------------------------------------------------------------------------*/
+static void
+init_dio(void)
+{
+  dio.instance_id = INSTANCE_ID;
+  dio.ocp = RPL_OF_OCP;
+  dio.mop = RPL_MOP_NON_STORING;
+  dio.grounded = 1;
+  dio.version = 240;
+  dio.dtsn = 240;
+  dio.dag_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
+  dio.dag_intmin = RPL_DIO_INTERVAL_MIN;
+  dio.dag_redund = RPL_DIO_REDUNDANCY;
+  dio.default_lifetime = RPL_DEFAULT_LIFETIME;
+  dio.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
+  dio.dag_max_rankinc = RPL_MAX_RANKINC;
+  dio.dag_min_hoprankinc = RPL_MIN_HOPRANKINC;
+  dio.mc.type = RPL_DAG_MC_NONE;
+  uip_ip6addr(&dio.dag_id, 0xfd00, 0, 0, 0, 0, 0, 0, 1);
+  uip_ip6addr(&dio.prefix_info.prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+  dio.prefix_info.length = 64;
+  dio.prefix_info.flags = UIP_ND6_RA_FLAG_AUTONOMOUS;
+  dio.prefix_info.lifetime = 0xffffffff;
+}
+/*---------------------------------------------------------------------------*/
+/* A DIO from neighbor i, at one to four hops from the root */
+static void
+send_dio(int i, int hops)
+{
+  dio.rank = hops * RPL_MIN_HOPRANKINC;
+  rpl_process_dio(&ipaddrs[i], &dio);
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_neighbors(void)
+{
+  int i;
+
+  for(i = 0; i < NEIGHBORS; i++) {
+    memset(&lladdrs[i], 0, sizeof(lladdrs[i]));
+    lladdrs[i].u8[0] = 0x02;
+    lladdrs[i].u8[LINKADDR_SIZE - 1] = i + 1;
+    uip_ip6addr(&ipaddrs[i], 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+    uip_ds6_set_addr_iid(&ipaddrs[i], (uip_lladdr_t *)&lladdrs[i]);
+    uip_ds6_nbr_add(&ipaddrs[i], (uip_lladdr_t *)&lladdrs[i], 1,
+                    NBR_REACHABLE, NBR_TABLE_REASON_UNDEFINED, NULL);
+    link_stats_packet_sent(&lladdrs[i], MAC_TX_OK, 1 + i % 3);
+    send_dio(i, 1 + i % 4);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* A packet to a random neighbor */
+static void
+send_packet(void)
+{
+  int i = random_rand() % NEIGHBORS;
+  int status = random_rand() % 16 == 0 ? MAC_TX_NOACK : MAC_TX_OK;
+  int numtx = 1 + random_rand() % 3;
+
+  link_stats_packet_sent(&lladdrs[i], status, numtx);
+  rpl_link_callback(&lladdrs[i], status, numtx);
+}
+/*---------------------------------------------------------------------------*/
+/* A packet to a random neighbor, or a DIO with a new rank once in a
+ * while */
+static void
+update_random_neighbor(void)
+{
+  if(random_rand() % 8 == 0) {
+    send_dio(random_rand() % NEIGHBORS, 1 + random_rand() % 4);
+  } else {
+    send_packet();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The best parent when the OF is asked about all neighbors */
+static rpl_nbr_t *
+scan_best(void)
+{
+  rpl_nbr_t *nbr;
+  rpl_nbr_t *best = NULL;
+
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    if(curr_instance.of->rank_via_nbr(nbr) < RPL_INFINITE_RANK
+       && curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+      best = curr_instance.of->best_parent(best, nbr);
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+/* The neighbors whose cached rank is not the one the OF computes */
+static int
+count_stale(void)
+{
+  rpl_nbr_t *nbr;
+  int stale = 0;
+
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL;
+      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    rpl_rank_t rank = curr_instance.of->rank_via_nbr(nbr);
+    if(rpl_neighbor_rank_via_nbr(nbr) != rank) {
+      stale++;
+    }
+  }
+  return stale;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rpl_parent_bench_process, ev, data)
+{
+  static struct etimer et;
+  static struct rpl_neighbor_stats stats;
+  static clock_time_t start;
+  static unsigned long update_time;
+  static unsigned long cached_time;
+  static unsigned long scan_time;
+  static int stale;
+  static int mismatches;
+  static int i;
+
+  PROCESS_BEGIN();
+
+  /* Let the stack start */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+
+  random_init(1);
+  init_dio();
+  add_neighbors();
+  printf("RPL parent bench: %u neighbors, joined %u\n",
+         rpl_neighbor_count(), NETSTACK_ROUTING.node_has_joined());
+
+  stale = 0;
+  mismatches = 0;
+  rpl_neighbor_reset_stats();
+  for(i = 0; i < ROUNDS; i++) {
+    rpl_nbr_t *best;
+    update_random_neighbor();
+    best = rpl_neighbor_select_best();
+    if(i % 100 == 0) {
+      rpl_nbr_t *scanned = scan_best();
+      stale += count_stale();
+      if(best != scanned && (best == NULL || scanned == NULL ||
+         curr_instance.of->nbr_path_cost(best)
+         != curr_instance.of->nbr_path_cost(scanned))) {
+        mismatches++;
+      }
+    }
+  }
+  rpl_neighbor_get_stats(&stats);
+  printf("RPL parent bench: %lu selections, %lu rank computations, %u candidates\n",
+         (unsigned long)stats.selections, (unsigned long)stats.recomputations,
+         stats.candidates);
+  printf("RPL parent bench: stale %d, mismatches %d\n", stale, mismatches);
+
+  /* The same link updates, alone, then followed by a selection */
+  random_init(2);
+  start = clock_time();
+  for(i = 0; i < TIME_ROUNDS; i++) {
+    send_packet();
+  }
+  update_time = clock_time() - start;
+
+  random_init(2);
+  start = clock_time();
+  for(i = 0; i < TIME_ROUNDS; i++) {
+    send_packet();
+    rpl_neighbor_select_best();
+  }
+  cached_time = clock_time() - start;
+
+  random_init(2);
+  start = clock_time();
+  for(i = 0; i < TIME_ROUNDS; i++) {
+    send_packet();
+    scan_best();
+  }
+  scan_time = clock_time() - start;
+
+  printf("RPL parent bench: selection after a link update, cached %lu ns, scan %lu ns\n",
+         (cached_time > update_time ? cached_time - update_time : 0)
+         * (1000000000UL / CLOCK_SECOND) / TIME_ROUNDS,
+         (scan_time > update_time ? scan_time - update_time : 0)
+         * (1000000000UL / CLOCK_SECOND) / TIME_ROUNDS);
+  printf("RPL parent bench: done\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+#
+# A stand-in for the SLIP radio of the native border router, for testing
+# the SLIP framing without a radio. The border router connects to it over
+# TCP with "-a localhost -p P". The stand-in answers the request for the
+# MAC address, with an address that has SLIP END and ESC bytes, and
+# reports each packet to send as sent.
+#
+# After the MAC address it sends --frames frames of --size random bytes,
+# with many END and ESC bytes, in bulk. The border router ignores them as
+# requests of an unknown type, and counts them in its statistics.
+#
+# A summary is printed when it exits.
+#
+# Options:
+#   --port P          TCP port to listen on (default 60001)
+#   --frames N        frames to send after the MAC address (default 0)
+#   --size N          bytes of each frame (default 100)
+#   --duration S      exit after S seconds (default: run until SIGTERM)
+#
+import argparse
+import random
+import select
+import signal
+import socket
+import sys
+import time
+
+SLIP_END = 0xC0
+SLIP_ESC = 0xDB
+SLIP_ESC_END = 0xDC
+SLIP_ESC_ESC = 0xDD
+
+MAC_ADDRESS = bytes([0x00, 0x12, SLIP_END, SLIP_ESC, 0x01, 0x02, 0x03, 0x04])
+
+
+def encode(frame):
+    return (frame.replace(bytes([SLIP_ESC]), bytes([SLIP_ESC, SLIP_ESC_ESC]))
+            .replace(bytes([SLIP_END]), bytes([SLIP_ESC, SLIP_ESC_END])) +
+            bytes([SLIP_END]))
+
+
+def decode(frame):
+    return (frame.replace(bytes([SLIP_ESC, SLIP_ESC_END]), bytes([SLIP_END]))
+            .replace(bytes([SLIP_ESC, SLIP_ESC_ESC]), bytes([SLIP_ESC])))
+
+
+class Stats:
+    def __init__(self):
+        self.frames = 0
+        self.packets = 0
+        self.requests = 0
+        self.sent = 0
+
+    def summary(self):
+        return ("frames %u packets %u mac-requests %u sent %u" %
+                (self.frames, self.packets, self.requests, self.sent))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--port', type=int, default=60001)
+    parser.add_argument('--frames', type=int, default=0)
+    parser.add_argument('--size', type=int, default=100)
+    parser.add_argument('--duration', type=float, default=0)
+    args = parser.parse_args()
+
+    stats = Stats()
+
+    def finish(*unused):
+        print("Radio stand-in: " + stats.summary(), flush=True)
+        sys.exit(0)
+
+    signal.signal(signal.SIGTERM, finish)
+    signal.signal(signal.SIGINT, finish)
+
+    # Requests of an unknown type, '?X', are ignored by the border router
+    rnd = random.Random(1)
+    choices = [SLIP_END, SLIP_ESC, SLIP_ESC_END, 0x00, 0x41, 0x7F]
+    frames = [b'?X' + bytes(rnd.choice(choices) for _ in range(args.size))
+              for _ in range(64)]
+    bulk = b''.join(encode(frames[i % len(frames)])
+                    for i in range(args.frames))
+
+    server = socket.socket(socket.AF_INET6, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('::', args.port))
+    server.listen(1)
+
+    sock = None
+    buf = b''
+    deadline = time.time() + args.duration if args.duration else None
+    while deadline is None or time.time() < deadline:
+        sockets = [sock] if sock else [server]
+        readable, _, _ = select.select(sockets, [], [], 0.1)
+        if server in readable:
+            sock, _ = server.accept()
+            continue
+        if not readable:
+            continue
+        data = sock.recv(65536)
+        if not data:
+            sock.close()
+            sock = None
+            continue
+        buf += data
+        while bytes([SLIP_END]) in buf:
+            frame, buf = buf.split(bytes([SLIP_END]), 1)
+            frame = decode(frame)
+            if not frame:
+                continue
+            stats.frames += 1
+            if frame[:2] == b'?M':
+                stats.requests += 1
+                sock.sendall(encode(b'!M' + MAC_ADDRESS))
+                if stats.requests == 1 and bulk:
+                    sock.sendall(bulk)
+                    stats.sent += args.frames
+            elif frame[:2] == b'!S':
+                # Report the packet as sent, with one transmission
+                stats.packets += 1
+                sock.sendall(encode(b'!R' + bytes([frame[2], 0, 1])))
+    finish()
+
+
+if __name__ == '__main__':
+    main()
@@ -35,4 +35,5 @@
  * at least three OID's in the same package are necessary
  */
 #define SNMP_CONF_MAX_NR_VALUES 3
+#define SNMP_CONF_MAX_BULK_VALUES 16
 #define LOG_CONF_LEVEL_SNMP     LOG_LEVEL_NONE
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Benchmark of the MaxHeap and B+-tree indexes of Antelope. For
+ *         each index type, the program inserts rows into an indexed
+ *         relation, runs range selections over the indexed attribute, and
+ *         then builds an index over an existing relation. It reports the
+ *         elapsed time and the storage accesses of each phase, and checks
+ *         the number of selected rows against the inserted keys.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "cfs/cfs-coffee.h"
+
+#include "antelope.h"
+#include "index.h"
+#include "relation.h"
+
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+#define BENCH_ROWS        1000
+#define BENCH_KEY_SPACE   2000
+#define BENCH_QUERIES     20
+#define BENCH_RANGE       50
+#define BENCH_CHURN       4000
+/*---------------------------------------------------------------------------*/
+PROCESS(index_bench_process, "Antelope index benchmark");
+AUTOSTART_PROCESSES(&index_bench_process);
+/*---------------------------------------------------------------------------*/
+struct bench_index {
+  const char *name;
+  const char *type;
+  /* Whether the index supports deletions. */
+  int churn;
+};
+
+static const struct bench_index bench_indexes[] = {
+  {"maxheap", "MAXHEAP", 0},
+  {"btree", "BTREE", 1}
+};
+
+static struct cfs_coffee_stats stats;
+static clock_time_t start_time;
+static clock_time_t worst_time;
+static unsigned long errors;
+static uint16_t keys[BENCH_ROWS];
+static uint32_t key_state;
+/*---------------------------------------------------------------------------*/
+static unsigned
+next_key(void)
+{
+  /* A local generator, since the MaxHeap index reseeds random_rand(). */
+  key_state = key_state * 1103515245UL + 12345;
+  return (unsigned)(key_state >> 16) % BENCH_KEY_SPACE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_measurement(void)
+{
+  cfs_coffee_reset_stats();
+  start_time = clock_time();
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_measurement(const char *name, const char *phase)
+{
+  cfs_coffee_get_stats(&stats);
+  printf("%s: %s: %lu ms, storage reads %lu, writes %lu\n", name, phase,
+         (unsigned long)((clock_time() - start_time) * 1000 / CLOCK_SECOND),
+         (unsigned long)stats.reads, (unsigned long)stats.writes);
+}
+/*---------------------------------------------------------------------------*/
+static void
+query(const char *name, const char *format, const char *rel,
+      const char *arg)
+{
+  db_result_t result;
+
+  result = db_query(NULL, format, rel, arg);
+  if(DB_ERROR(result)) {
+    printf("%s: ERROR: query \"%s\" failed: %s\n", name, format,
+           db_get_result_message(result));
+    errors++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+insert_rows(const char *name, const char *rel)
+{
+  db_result_t result;
+  clock_time_t insert_start;
+  unsigned i;
+
+  key_state = 1;
+  worst_time = 0;
+  for(i = 0; i < BENCH_ROWS; i++) {
+    insert_start = clock_time();
+    keys[i] = next_key();
+    result = db_query(NULL, "INSERT (%u, %u) INTO %s;", keys[i], i, rel);
+    if(DB_ERROR(result)) {
+      printf("%s: ERROR: insertion %u failed: %s\n", name, i,
+             db_get_result_message(result));
+      errors++;
+      return 0;
+    }
+    if(clock_time() - insert_start > worst_time) {
+      worst_time = clock_time() - insert_start;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+select_ranges(const char *name, const char *rel)
+{
+  static db_handle_t handle;
+  db_result_t result;
+  tuple_id_t rows, expected, total_rows;
+  unsigned i, j, min;
+
+  start_measurement();
+  total_rows = 0;
+  for(i = 0; i < BENCH_QUERIES; i++) {
+    min = i * (BENCH_KEY_SPACE - BENCH_RANGE) / BENCH_QUERIES;
+    result = db_query(&handle, "SELECT k, v FROM %s WHERE k >= %u AND k < %u;",
+                      rel, min, min + BENCH_RANGE);
+    rows = 0;
+    while(!DB_ERROR(result) && result != DB_FINISHED &&
+          db_processing(&handle)) {
+      result = db_process(&handle);
+      if(result == DB_GOT_ROW) {
+        rows++;
+      }
+    }
+    db_free(&handle);
+    total_rows += rows;
+
+    for(j = expected = 0; j < BENCH_ROWS; j++) {
+      if(keys[j] >= min && keys[j] < min + BENCH_RANGE) {
+        expected++;
+      }
+    }
+    if(DB_ERROR(result)) {
+      printf("%s: ERROR: range selection %u failed: %s\n", name, i,
+             db_get_result_message(result));
+      errors++;
+    } else if(rows != expected) {
+      printf("%s: ERROR: range selection %u returned %lu rows, not %lu\n",
+             name, i, (unsigned long)rows, (unsigned long)expected);
+      errors++;
+    }
+  }
+  print_measurement(name, "range selections");
+  printf("%s: range selections returned %lu rows\n", name,
+         (unsigned long)total_rows);
+}
+/*---------------------------------------------------------------------------*/
+static void
+select_fraction(const char *name, const char *rel)
+{
+  static db_handle_t handle;
+  static const char *operators[] = { "<", ">" };
+  db_result_t result;
+  tuple_id_t rows, expected;
+  unsigned i, j;
+
+  /* A fractional bound next to an existing key selects that key on one
+     side only, so it must be compared exactly, not truncated. */
+  for(i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
+    result = db_query(&handle, "SELECT k, v FROM %s WHERE k %s %u.5;",
+                      rel, operators[i], keys[0]);
+    rows = 0;
+    while(!DB_ERROR(result) && result != DB_FINISHED &&
+          db_processing(&handle)) {
+      result = db_process(&handle);
+      if(result == DB_GOT_ROW) {
+        rows++;
+      }
+    }
+    db_free(&handle);
+
+    for(j = expected = 0; j < BENCH_ROWS; j++) {
+      if(i == 0 ? keys[j] <= keys[0] : keys[j] > keys[0]) {
+        expected++;
+      }
+    }
+    if(DB_ERROR(result)) {
+      printf("%s: ERROR: selection k %s %u.5 failed: %s\n", name,
+             operators[i], keys[0], db_get_result_message(result));
+      errors++;
+    } else if(rows != expected) {
+      printf("%s: ERROR: selection k %s %u.5 returned %lu rows, not %lu\n",
+             name, operators[i], keys[0], (unsigned long)rows,
+             (unsigned long)expected);
+      errors++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Replace the indexed keys several times over through the index API. A
+ * B+-tree index uses new nodes for every update, so this exceeds the
+ * number of nodes of its file.
+ */
+static void
+churn_index(const char *name, index_t *index)
+{
+  static index_iterator_t iterator;
+  attribute_value_t value, max_value;
+  tuple_id_t rows, expected;
+  unsigned i, j, row, min;
+
+  start_measurement();
+  value.domain = max_value.domain = DOMAIN_INT;
+  for(i = 0; i < BENCH_CHURN; i++) {
+    row = i % BENCH_ROWS;
+    VALUE_INT(&value) = keys[row];
+    if(DB_ERROR(index_delete(index, &value))) {
+      printf("%s: ERROR: deletion %u of key %u failed\n", name, i, keys[row]);
+      errors++;
+      return;
+    }
+    keys[row] = next_key();
+    VALUE_INT(&value) = keys[row];
+    if(DB_ERROR(index_insert(index, &value, row))) {
+      printf("%s: ERROR: insertion %u of key %u failed\n", name, i,
+             keys[row]);
+      errors++;
+      return;
+    }
+  }
+  print_measurement(name, "deletions and insertions");
+
+  /* Count the entries of each range through the index. */
+  for(i = 0; i < BENCH_QUERIES; i++) {
+    min = i * (BENCH_KEY_SPACE - BENCH_RANGE) / BENCH_QUERIES;
+    VALUE_INT(&value) = min;
+    VALUE_INT(&max_value) = min + BENCH_RANGE - 1;
+    if(DB_ERROR(index_get_iterator(&iterator, index, &value, &max_value))) {
+      printf("%s: ERROR: no iterator for range %u\n", name, i);
+      errors++;
+      continue;
+    }
+    for(rows = 0; index_get_next(&iterator) != INVALID_TUPLE; rows++);
+
+    for(j = expected = 0; j < BENCH_ROWS; j++) {
+      if(keys[j] >= min && keys[j] < min + BENCH_RANGE) {
+        expected++;
+      }
+    }
+    if(rows != expected) {
+      printf("%s: ERROR: range %u has %lu entries after deletions, not %lu\n",
+             name, i, (unsigned long)rows, (unsigned long)expected);
+      errors++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(index_bench_process, ev, data)
+{
+  static const struct bench_index *bench;
+  static relation_t *rel;
+  static index_t *index;
+  static char rel_name[RELATION_NAME_LENGTH + 1];
+  attribute_t *attr;
+
+  PROCESS_BEGIN();
+
+  cfs_coffee_format();
+  db_init();
+
+  printf("Antelope index benchmark: %u rows, %u range selections of %u keys\n",
+         BENCH_ROWS, BENCH_QUERIES, BENCH_RANGE);
+
+  for(bench = bench_indexes;
+      bench < bench_indexes + sizeof(bench_indexes) / sizeof(bench_indexes[0]);
+      bench++) {
+    /* Insert rows into a relation with an index. */
+    snprintf(rel_name, sizeof(rel_name), "i%s", bench->name);
+    query(bench->name, "CREATE RELATION %s;", rel_name, NULL);
+    query(bench->name, "CREATE ATTRIBUTE k DOMAIN INT IN %s;", rel_name, NULL);
+    query(bench->name, "CREATE ATTRIBUTE v DOMAIN INT IN %s;", rel_name, NULL);
+    query(bench->name, "CREATE INDEX %s.k TYPE %s;", rel_name, bench->type);
+
+    start_measurement();
+    if(insert_rows(bench->name, rel_name)) {
+      print_measurement(bench->name, "insertions");
+      printf("%s: worst insertion %lu ms\n", bench->name,
+             (unsigned long)(worst_time * 1000 / CLOCK_SECOND));
+    }
+
+    /* Select rows in ranges of the indexed attribute. */
+    select_ranges(bench->name, rel_name);
+
+    /* Delete and insert keys, past the node limit of a B+-tree. */
+    if(bench->churn) {
+      rel = relation_load(rel_name);
+      attr = rel != NULL ? relation_attribute_get(rel, "k") : NULL;
+      if(attr == NULL || attr->index == NULL) {
+        printf("%s: ERROR: the index of %s is not loaded\n", bench->name,
+               rel_name);
+        errors++;
+      } else {
+        churn_index(bench->name, attr->index);
+      }
+      if(rel != NULL) {
+        relation_release(rel);
+      }
+    }
+
+    /* Build an index over an existing relation. */
+    snprintf(rel_name, sizeof(rel_name), "l%s", bench->name);
+    query(bench->name, "CREATE RELATION %s;", rel_name, NULL);
+    query(bench->name, "CREATE ATTRIBUTE k DOMAIN INT IN %s;", rel_name, NULL);
+    query(bench->name, "CREATE ATTRIBUTE v DOMAIN INT IN %s;", rel_name, NULL);
+    if(!insert_rows(bench->name, rel_name)) {
+      continue;
+    }
+
+    rel = relation_load(rel_name);
+    if(rel == NULL) {
+      printf("%s: ERROR: unable to load relation %s\n", bench->name, rel_name);
+      errors++;
+      continue;
+    }
+
+    start_measurement();
+    query(bench->name, "CREATE INDEX %s.k TYPE %s;", rel_name, bench->type);
+    attr = relation_attribute_get(rel, "k");
+    index = attr != NULL ? attr->index : NULL;
+    while(index != NULL && (index->flags & INDEX_LOAD_NEEDED)) {
+      PROCESS_PAUSE();
+    }
+    if(index == NULL || index->flags != INDEX_READY) {
+      printf("%s: ERROR: the index could not be loaded\n", bench->name);
+      errors++;
+    } else {
+      print_measurement(bench->name, "index load");
+    }
+    relation_release(rel);
+    select_ranges(bench->name, rel_name);
+    select_fraction(bench->name, rel_name);
+
+    /* Free the storage and file descriptors used by the indexes. */
+    snprintf(rel_name, sizeof(rel_name), "i%s", bench->name);
+    query(bench->name, "REMOVE RELATION %s;", rel_name, NULL);
+    snprintf(rel_name, sizeof(rel_name), "l%s", bench->name);
+    query(bench->name, "REMOVE RELATION %s;", rel_name, NULL);
+  }
+
+  printf("Antelope index benchmark finished, errors %lu\n", errors);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
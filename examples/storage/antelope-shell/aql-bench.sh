@@ -0,0 +1,105 @@
+#!/bin/bash
+#
+# Runs a set of AQL queries through shell-db on the native platform and
+# reports the wall-clock time of each query.
+#
+# Usage: ./aql-bench.sh [rows] [repetitions]
+#
+# Each measured query is run the given number of times, and the
+# mean time is reported.
+#
+
+ROWS=${1:-2000}
+REPEAT=${2:-10}
+SHELL_DB=${SHELL_DB:-./shell-db.native}
+
+if [ ! -x $SHELL_DB ]; then
+  echo "$SHELL_DB not found; build it with \"make TARGET=native\""
+  exit 1
+fi
+
+coproc DB { exec stdbuf -oL $SHELL_DB 2>&1; }
+
+# Send one query and wait until the shell has finished processing it.
+run_query() {
+  echo "$1" >&${DB[1]}
+  while read -r line <&${DB[0]}; do
+    case "$line" in
+      OK)
+        break
+        ;;
+      "["*"tuples returned"*)
+        summary="$line"
+        ;;
+      "["*"storage reads"*)
+        summary="$summary $line"
+        ;;
+      *failed*|"Processing error"*)
+        summary="$line"
+        break
+        ;;
+    esac
+  done
+}
+
+# Run a query and print the mean elapsed time in microseconds
+# together with the summary printed by the shell.
+query() {
+  local start end line summary="" i
+
+  if [ -z "$2" ]; then
+    run_query "$1"
+    return
+  fi
+
+  start=$(date +%s%N)
+  for i in $(seq 1 $REPEAT); do
+    run_query "$1"
+  done
+  end=$(date +%s%N)
+
+  printf "%-56s %8u us  %s\n" "$1" $(( (end - start) / 1000 / REPEAT )) "$summary"
+}
+
+# Deterministic pseudo-random attribute values.
+seed=1
+next_value() {
+  seed=$(( (seed * 1103515245 + 12345) % 2147483648 ))
+  value=$(( (seed >> 16) % 1000 ))
+}
+
+query "REMOVE RELATION bench;"
+query "CREATE RELATION bench;"
+query "CREATE ATTRIBUTE id DOMAIN INT IN bench;"
+query "CREATE ATTRIBUTE a DOMAIN INT IN bench;"
+query "CREATE ATTRIBUTE b DOMAIN INT IN bench;"
+
+start=$(date +%s%N)
+for i in $(seq 1 $ROWS); do
+  next_value
+  a=$value
+  next_value
+  query "INSERT ($i, $a, $value) INTO bench;"
+done
+end=$(date +%s%N)
+printf "%-56s %8u us\n" "INSERT ($ROWS rows)" $(( (end - start) / 1000 / ROWS ))
+
+query "SELECT COUNT(id) FROM bench;" print
+query "SELECT COUNT(id) FROM bench WHERE a < 100;" print
+query "SELECT COUNT(id) FROM bench WHERE a > 100 AND b < 500;" print
+query "SELECT COUNT(id) FROM bench WHERE a < 10 OR b < 10;" print
+query "SELECT COUNT(id) FROM bench WHERE a + b * 2 < 300;" print
+query "SELECT MAX(a) FROM bench WHERE id > 100;" print
+query "SELECT id FROM bench WHERE a < 20;" print
+query "SELECT id, a, b FROM bench WHERE a < 20;" print
+query "SELECT id FROM bench WHERE id >= 500 AND id < 520;" print
+query "CREATE INDEX bench.id TYPE BTREE;"
+# Wait for the index to be built in the background.
+sleep 5
+query "SELECT id FROM bench WHERE id >= 500 AND id < 520;" print
+query "SELECT COUNT(id) FROM bench WHERE id > 1000 AND a < 500;" print
+query "SELECT id FROM bench WHERE id > 10000;" print
+query "REMOVE RELATION bench;"
+
+kill $DB_PID 2>/dev/null
+wait 2>/dev/null
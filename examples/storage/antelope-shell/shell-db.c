@@ -40,6 +40,16 @@
 #include "dev/serial-line.h"
 
 #include "antelope.h"
+#include "cfs/cfs-coffee.h"
+
+#ifndef COFFEE_STATS
+#define COFFEE_STATS 0
+#endif /* COFFEE_STATS */
+
+/* The number of tuples to process before yielding to other processes. */
+#ifndef DB_SHELL_BATCH_SIZE
+#define DB_SHELL_BATCH_SIZE 32
+#endif /* DB_SHELL_BATCH_SIZE */
 
 PROCESS(db_shell, "DB shell");
 AUTOSTART_PROCESSES(&db_shell);
@@ -50,6 +60,9 @@ PROCESS_THREAD(db_shell, ev, data)
   db_result_t result;
   static tuple_id_t matching;
   static tuple_id_t processed;
+#if COFFEE_STATS
+  struct cfs_coffee_stats stats;
+#endif /* COFFEE_STATS */
 
   PROCESS_BEGIN();
 
@@ -58,6 +71,10 @@ PROCESS_THREAD(db_shell, ev, data)
   for(;;) {
     PROCESS_WAIT_EVENT_UNTIL(ev == serial_line_event_message && data != NULL);
 
+#if COFFEE_STATS
+    cfs_coffee_reset_stats();
+#endif /* COFFEE_STATS */
+
     result = db_query(&handle, data);
     if(DB_ERROR(result)) {
       printf("Query \"%s\" failed: %s\n",
@@ -77,7 +94,9 @@ PROCESS_THREAD(db_shell, ev, data)
     processed = 0;
 
     while(db_processing(&handle)) {
-      PROCESS_PAUSE();
+      if(processed % DB_SHELL_BATCH_SIZE == 0) {
+        PROCESS_PAUSE();
+      }
       result = db_process(&handle);
       switch(result) {
       case DB_GOT_ROW:
@@ -94,6 +113,11 @@ PROCESS_THREAD(db_shell, ev, data)
         /* The processing has finished. Wait for a new command. */
         printf("[%ld tuples returned; %ld tuples processed]\n",
                (long)matching, (long)processed);
+#if COFFEE_STATS
+        cfs_coffee_get_stats(&stats);
+        printf("[%lu storage reads; %lu bytes read]\n",
+               (unsigned long)stats.reads, (unsigned long)stats.read_bytes);
+#endif /* COFFEE_STATS */
         printf("OK\n");
       default:
         if(DB_ERROR(result)) {
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Simulation of Coffee garbage collection under a file rotation
+ *         workload. The program runs the same workload twice: once with
+ *         only the synchronous garbage collector, and once with the
+ *         incremental garbage collector running when the system is idle.
+ *         For each run, it reports the worst-case and mean latency of
+ *         file writes, modelled from the storage accesses they cause,
+ *         and the distribution of sector erases.
+ *
+ *         The program requires Coffee to be built with COFFEE_STATS
+ *         and COFFEE_INCREMENTAL_GC. It is mainly meant for the native
+ *         platform, where Coffee uses the emulated external memory.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs/cfs-coffee.h"
+#include "cfs-coffee-arch.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define SIM_ITERATIONS    2000
+#define SIM_FILES         12
+#define SIM_MAX_FILE_SIZE (COFFEE_SECTOR_SIZE / 4)
+#define SIM_IDLE_STEPS    32
+#define SIM_SEED          0x1234
+
+/* Costs of storage accesses in microseconds, as for a typical SPI NOR
+   flash with 256-byte program pages and 64 kB erase sectors. */
+#define COST_READ_US      30
+#define COST_WRITE_US     700
+#define COST_ERASE_US     400000UL
+
+#define SECTOR_COUNT      (COFFEE_SIZE / COFFEE_SECTOR_SIZE)
+/*---------------------------------------------------------------------------*/
+PROCESS(coffee_gc_sim_process, "Coffee GC simulation");
+AUTOSTART_PROCESSES(&coffee_gc_sim_process);
+/*---------------------------------------------------------------------------*/
+static uint32_t erases_before[SECTOR_COUNT];
+static unsigned long worst_us;
+static unsigned long total_us;
+static unsigned long failures;
+static unsigned long sync_gc_runs;
+/*---------------------------------------------------------------------------*/
+static unsigned long
+modelled_latency(const struct cfs_coffee_stats *stats)
+{
+  return stats->reads * COST_READ_US +
+         stats->writes * COST_WRITE_US +
+         stats->erases * COST_ERASE_US;
+}
+/*---------------------------------------------------------------------------*/
+static void
+rotate_file(unsigned index)
+{
+  static char buf[COFFEE_PAGE_SIZE];
+  struct cfs_coffee_stats stats;
+  char name[8];
+  cfs_offset_t size, written;
+  unsigned long latency;
+  int fd, n;
+
+  snprintf(name, sizeof(name), "sim%u", index);
+  size = 1 + random_rand() % SIM_MAX_FILE_SIZE;
+  memset(buf, index + 1, sizeof(buf));
+
+  cfs_remove(name);
+
+  cfs_coffee_reset_stats();
+  fd = -1;
+  if(cfs_coffee_reserve(name, size) == 0) {
+    fd = cfs_open(name, CFS_WRITE);
+  }
+  if(fd < 0) {
+    failures++;
+    return;
+  }
+  for(written = 0; written < size; written += n) {
+    n = size - written > sizeof(buf) ? sizeof(buf) : size - written;
+    if(cfs_write(fd, buf, n) != n) {
+      failures++;
+      break;
+    }
+  }
+  cfs_close(fd);
+  cfs_coffee_get_stats(&stats);
+
+  latency = modelled_latency(&stats);
+  total_us += latency;
+  if(latency > worst_us) {
+    worst_us = latency;
+  }
+  sync_gc_runs += stats.gc_runs;
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_run(void)
+{
+  unsigned i;
+
+  for(i = 0; i < SECTOR_COUNT; i++) {
+    erases_before[i] = cfs_coffee_get_erase_count(i);
+  }
+  cfs_coffee_format();
+  random_init(SIM_SEED);
+  worst_us = total_us = failures = sync_gc_runs = 0;
+
+  /* The erase counts are stored in the sectors, so formatting adds one
+     erase to each sector instead of resetting the counts. */
+  for(i = 0; i < SECTOR_COUNT; i++) {
+    if(cfs_coffee_get_erase_count(i) != erases_before[i] + 1) {
+      printf("Sector %u has erase count %lu after formatting, not %lu\n", i,
+             (unsigned long)cfs_coffee_get_erase_count(i),
+             (unsigned long)erases_before[i] + 1);
+      failures++;
+    }
+    erases_before[i] = cfs_coffee_get_erase_count(i);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_run(const char *mode)
+{
+  unsigned i;
+  uint32_t erases, min, max, total;
+
+  min = UINT32_MAX;
+  max = total = 0;
+  printf("%s: erases per sector:", mode);
+  for(i = 0; i < SECTOR_COUNT; i++) {
+    erases = cfs_coffee_get_erase_count(i) - erases_before[i];
+    printf(" %lu", (unsigned long)erases);
+    total += erases;
+    if(erases < min) {
+      min = erases;
+    }
+    if(erases > max) {
+      max = erases;
+    }
+  }
+  printf("\n");
+
+  printf("%s: erases %lu (min %lu, max %lu), synchronous GC runs %lu\n",
+         mode, (unsigned long)total, (unsigned long)min, (unsigned long)max,
+         sync_gc_runs);
+  printf("%s: write latency worst %lu us, mean %lu us, failures %lu\n",
+         mode, worst_us, total_us / SIM_ITERATIONS, failures);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coffee_gc_sim_process, ev, data)
+{
+  static unsigned iteration;
+  static unsigned idle;
+
+  PROCESS_BEGIN();
+
+  printf("Coffee GC simulation: %u iterations, %u files, %lu sectors\n",
+         SIM_ITERATIONS, SIM_FILES, (unsigned long)SECTOR_COUNT);
+
+  start_run();
+  for(iteration = 0; iteration < SIM_ITERATIONS; iteration++) {
+    rotate_file(random_rand() % SIM_FILES);
+  }
+  print_run("synchronous");
+
+  start_run();
+  process_start(&coffee_gc_process, NULL);
+  for(iteration = 0; iteration < SIM_ITERATIONS; iteration++) {
+    rotate_file(random_rand() % SIM_FILES);
+    /* Leave idle time for the garbage collection process. */
+    for(idle = 0; idle < SIM_IDLE_STEPS; idle++) {
+      PROCESS_PAUSE();
+    }
+  }
+  process_exit(&coffee_gc_process);
+  print_run("incremental");
+
+  printf("Coffee GC simulation finished\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Measurement of the storage accesses caused by many small writes
+ *         to a file that has a micro log. The program appends fixed-size
+ *         records to a modified file, first with unbuffered writes, and
+ *         then through a file descriptor with CFS_COFFEE_IO_WRITE_BUFFER.
+ *         For each run, it reports the storage writes, written bytes and
+ *         sector erases, and verifies the file contents.
+ *
+ *         The program requires Coffee to be built with COFFEE_STATS,
+ *         COFFEE_MICRO_LOGS and COFFEE_WRITE_BUFFERS. It is mainly meant
+ *         for the native platform, where Coffee uses the emulated
+ *         external memory.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs/cfs-coffee.h"
+#include "cfs-coffee-arch.h"
+
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define SIM_FILE          "records"
+#define SIM_HEADER_SIZE   32
+#define SIM_RECORD_SIZE   16
+#define SIM_RECORDS       1024
+#define SIM_FILE_SIZE     (SIM_HEADER_SIZE + SIM_RECORDS * SIM_RECORD_SIZE)
+/*---------------------------------------------------------------------------*/
+PROCESS(coffee_log_sim_process, "Coffee log simulation");
+AUTOSTART_PROCESSES(&coffee_log_sim_process);
+/*---------------------------------------------------------------------------*/
+static unsigned long failures;
+/*---------------------------------------------------------------------------*/
+static void
+fill_record(char *record, unsigned index)
+{
+  unsigned i;
+
+  for(i = 0; i < SIM_RECORD_SIZE; i++) {
+    record[i] = (char)(index * 7 + i);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(const char *mode, unsigned io_flags)
+{
+  char header[SIM_HEADER_SIZE];
+  char record[SIM_RECORD_SIZE];
+  char check[SIM_RECORD_SIZE];
+  struct cfs_coffee_stats stats;
+  unsigned i;
+  int fd;
+
+  cfs_coffee_format();
+
+  /* Create a file and modify its header, so that it gets a micro log. */
+  memset(header, 'h', sizeof(header));
+  fd = -1;
+  if(cfs_coffee_reserve(SIM_FILE, SIM_FILE_SIZE) == 0) {
+    fd = cfs_open(SIM_FILE, CFS_WRITE);
+  }
+  if(fd < 0 || cfs_write(fd, header, sizeof(header)) != sizeof(header)) {
+    printf("%s: ERROR: unable to create the file\n", mode);
+    failures++;
+    return;
+  }
+  cfs_close(fd);
+  fd = cfs_open(SIM_FILE, CFS_WRITE | CFS_READ);
+  header[0] = 'H';
+  if(fd < 0 || cfs_write(fd, header, sizeof(header)) != sizeof(header)) {
+    printf("%s: ERROR: unable to modify the file\n", mode);
+    failures++;
+    return;
+  }
+
+  cfs_coffee_reset_stats();
+  if(io_flags != 0 && cfs_coffee_set_io_semantics(fd, io_flags) < 0) {
+    printf("%s: ERROR: unable to set the I/O semantics\n", mode);
+    failures++;
+  }
+  for(i = 0; i < SIM_RECORDS; i++) {
+    fill_record(record, i);
+    if(cfs_write(fd, record, sizeof(record)) != sizeof(record)) {
+      printf("%s: ERROR: record %u was not written\n", mode, i);
+      failures++;
+      break;
+    }
+  }
+  /* Closing writes the buffered records, and reports if that fails. */
+  if(cfs_close(fd) < 0) {
+    printf("%s: ERROR: the last records were not written\n", mode);
+    failures++;
+  }
+  cfs_coffee_get_stats(&stats);
+
+  printf("%s: %u records of %u bytes: writes %lu, written bytes %lu, "
+         "erases %lu\n", mode, SIM_RECORDS, SIM_RECORD_SIZE,
+         (unsigned long)stats.writes, (unsigned long)stats.written_bytes,
+         (unsigned long)stats.erases);
+
+  /* Verify the file contents. */
+  fd = cfs_open(SIM_FILE, CFS_READ);
+  if(fd < 0 || cfs_read(fd, header, sizeof(header)) != sizeof(header) ||
+     header[0] != 'H' || header[1] != 'h') {
+    printf("%s: ERROR: wrong file header\n", mode);
+    failures++;
+  }
+  for(i = 0; fd >= 0 && i < SIM_RECORDS; i++) {
+    fill_record(record, i);
+    if(cfs_read(fd, check, sizeof(check)) != sizeof(check) ||
+       memcmp(check, record, sizeof(record)) != 0) {
+      printf("%s: ERROR: wrong contents in record %u\n", mode, i);
+      failures++;
+      break;
+    }
+  }
+  cfs_close(fd);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coffee_log_sim_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  run("unbuffered", 0);
+  run("buffered", CFS_COFFEE_IO_WRITE_BUFFER);
+
+  printf("Coffee log simulation finished, failures %lu\n", failures);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -36,5 +36,13 @@
 #define COFFEE_CONF_APPEND_ONLY       0
 #endif /* CONTIKI_TARGET_CC2538DK || CONTIKI_TARGET_ZOUL */
 
+#if CONTIKI_TARGET_NATIVE
+#define COFFEE_STATS                  1
+#define COFFEE_INCREMENTAL_GC         1
+#define COFFEE_SECTOR_HEADERS         1
+#define COFFEE_CONF_MICRO_LOGS        1
+#define COFFEE_WRITE_BUFFERS          2
+#endif /* CONTIKI_TARGET_NATIVE */
+
 #endif /* PROJECT_CONF_H_ */
 /*---------------------------------------------------------------------------*/
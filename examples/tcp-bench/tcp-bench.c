@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         TCP throughput benchmark. The node listens on two ports. A host
+ *         that connects sends the number of bytes it wants, followed by a
+ *         newline, and the node sends that many bytes and closes the
+ *         connection. Connections to the first port have a send window of
+ *         several segments, connections to the second port send one
+ *         segment at a time.
+ *
+ *         On the third and fourth port, the node receives the data that
+ *         the host sends until it closes the connection, and checks it.
+ *         Connections to the third port keep the segments that arrive
+ *         out of order and delay their acknowledgements, connections to
+ *         the fourth port do neither.
+ *
+ *         With TCP_BENCH_CONF_LOSS set to N, the node drops every Nth
+ *         TCP segment with data that it sends or receives, to test the
+ *         retransmissions.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/ipv6/tcp-socket.h"
+#include "net/netstack.h"
+
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+#define WINDOW_PORT        8080
+#define SINGLE_PORT        8081
+#define QUEUE_PORT         8082
+#define PLAIN_PORT         8083
+#define INPUT_BUFFER_SIZE  32
+#define OUTPUT_BUFFER_SIZE 10240
+#define CHUNK_SIZE         256
+
+#ifdef TCP_BENCH_CONF_LOSS
+#define LOSS TCP_BENCH_CONF_LOSS
+#else
+#define LOSS 0
+#endif
+/*---------------------------------------------------------------------------*/
+PROCESS(tcp_bench_process, "TCP benchmark");
+AUTOSTART_PROCESSES(&tcp_bench_process);
+/*---------------------------------------------------------------------------*/
+struct bench {
+  struct tcp_socket s;
+  uint16_t port;
+  uint8_t window;
+  uint8_t receiver;
+  uint8_t input[INPUT_BUFFER_SIZE];
+  uint8_t output[OUTPUT_BUFFER_SIZE];
+  uint32_t requested;
+  uint32_t total;
+  uint32_t queued;
+  uint32_t errors;
+  clock_time_t start;
+#if UIP_STATISTICS
+  uip_stats_t rexmit;
+  uip_stats_t sent;
+#endif /* UIP_STATISTICS */
+};
+
+static struct bench benches[4];
+#if LOSS
+static unsigned long segments;
+static unsigned long received_segments;
+#endif /* LOSS */
+/*---------------------------------------------------------------------------*/
+/* The data is a sequence with a period that no segment size divides,
+   so that the host detects data at the wrong offset */
+static void
+fill(struct bench *b)
+{
+  static uint8_t chunk[CHUNK_SIZE];
+  uint32_t len;
+  uint32_t i;
+
+  while(b->queued < b->total && tcp_socket_max_sendlen(&b->s) > 0) {
+    len = MIN(b->total - b->queued, sizeof(chunk));
+    len = MIN(len, tcp_socket_max_sendlen(&b->s));
+    for(i = 0; i < len; i++) {
+      chunk[i] = (b->queued + i) % 251;
+    }
+    b->queued += tcp_socket_send(&b->s, chunk, len);
+  }
+}
+#if LOSS
+/*---------------------------------------------------------------------------*/
+static enum netstack_ip_action
+drop_output(const linkaddr_t *localdest)
+{
+  if(UIP_IP_BUF->proto == UIP_PROTO_TCP && uip_len > UIP_IPTCPH_LEN &&
+     ++segments % LOSS == 0) {
+    return NETSTACK_IP_DROP;
+  }
+  return NETSTACK_IP_PROCESS;
+}
+/*---------------------------------------------------------------------------*/
+static enum netstack_ip_action
+drop_input(void)
+{
+  if(UIP_IP_BUF->proto == UIP_PROTO_TCP && uip_len > UIP_IPTCPH_LEN &&
+     (UIP_TCP_BUF->destport == UIP_HTONS(QUEUE_PORT) ||
+      UIP_TCP_BUF->destport == UIP_HTONS(PLAIN_PORT)) &&
+     ++received_segments % LOSS == 0) {
+    return NETSTACK_IP_DROP;
+  }
+  return NETSTACK_IP_PROCESS;
+}
+/*---------------------------------------------------------------------------*/
+static struct netstack_ip_packet_processor loss_processor = {
+  .process_input = drop_input,
+  .process_output = drop_output
+};
+#endif /* LOSS */
+/*---------------------------------------------------------------------------*/
+static void
+report(struct bench *b)
+{
+  unsigned long ms;
+
+  ms = (unsigned long)(clock_time() - b->start) * 1000 / CLOCK_SECOND;
+  printf("TCP benchmark: port %u window %u sent %lu bytes in %lu ms,"
+         " %lu kB/s", b->port, b->window ? UIP_TCP_SEND_WINDOW : 1,
+         (unsigned long)b->total, ms,
+         (unsigned long)(b->total / (ms > 0 ? ms : 1)));
+#if UIP_STATISTICS
+  printf(", retransmissions %lu",
+         (unsigned long)(uip_stat.tcp.rexmit - b->rexmit));
+#endif /* UIP_STATISTICS */
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+static void
+report_received(struct bench *b)
+{
+  unsigned long ms;
+
+  ms = (unsigned long)(clock_time() - b->start) * 1000 / CLOCK_SECOND;
+  printf("TCP benchmark: port %u received %lu bytes in %lu ms, %lu kB/s,"
+         " errors %lu", b->port, (unsigned long)b->total, ms,
+         (unsigned long)(b->total / (ms > 0 ? ms : 1)),
+         (unsigned long)b->errors);
+#if UIP_STATISTICS
+  printf(", segments sent %lu", (unsigned long)(uip_stat.tcp.sent - b->sent));
+#endif /* UIP_STATISTICS */
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+static int
+input(struct tcp_socket *s, void *ptr, const uint8_t *data, int len)
+{
+  struct bench *b = ptr;
+  int i;
+
+  if(b->receiver) {
+    if(b->total == 0) {
+      b->start = clock_time();
+#if UIP_STATISTICS
+      b->sent = uip_stat.tcp.sent;
+#endif /* UIP_STATISTICS */
+    }
+    for(i = 0; i < len; i++) {
+      if(data[i] != (b->total + i) % 251) {
+        b->errors++;
+      }
+    }
+    b->total += len;
+    return 0;
+  }
+
+  for(i = 0; i < len && b->total == 0; i++) {
+    if(data[i] >= '0' && data[i] <= '9') {
+      b->requested = b->requested * 10 + data[i] - '0';
+    } else if(data[i] == '\n') {
+      b->total = b->requested;
+      b->start = clock_time();
+#if UIP_STATISTICS
+      b->rexmit = uip_stat.tcp.rexmit;
+#endif /* UIP_STATISTICS */
+      fill(b);
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+event(struct tcp_socket *s, void *ptr, tcp_socket_event_t ev)
+{
+  struct bench *b = ptr;
+
+  switch(ev) {
+  case TCP_SOCKET_CONNECTED:
+    b->requested = b->total = b->queued = b->errors = 0;
+    break;
+  case TCP_SOCKET_DATA_SENT:
+    fill(b);
+    if(b->total > 0 && b->queued == b->total &&
+       tcp_socket_queuelen(s) == 0) {
+      report(b);
+      tcp_socket_close(s);
+    }
+    break;
+  case TCP_SOCKET_CLOSED:
+    if(b->receiver) {
+      report_received(b);
+    }
+    /* Fall through */
+  case TCP_SOCKET_TIMEDOUT:
+  case TCP_SOCKET_ABORTED:
+    if(b->receiver) {
+      b->total = 0;
+      break;
+    }
+    if(b->queued < b->total || tcp_socket_queuelen(s) > 0) {
+      printf("TCP benchmark: port %u connection lost after %lu bytes\n",
+             b->port, (unsigned long)(b->queued - tcp_socket_queuelen(s)));
+    }
+    b->total = 0;
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_listen(struct bench *b, uint16_t port, uint8_t window)
+{
+  b->port = port;
+  b->window = window;
+  tcp_socket_register(&b->s, b, b->input, sizeof(b->input),
+                      b->output, sizeof(b->output), input, event);
+  if(window && tcp_socket_set_window(&b->s, 1) < 0) {
+    printf("TCP benchmark: no send window, UIP_CONF_TCP_SEND_WINDOW is 0\n");
+    b->window = 0;
+  }
+  tcp_socket_listen(&b->s, port);
+}
+/*---------------------------------------------------------------------------*/
+static void
+receiver_listen(struct bench *b, uint16_t port, uint8_t queue)
+{
+  b->port = port;
+  b->receiver = 1;
+  tcp_socket_register(&b->s, b, b->input, sizeof(b->input),
+                      b->output, sizeof(b->output), input, event);
+  if(queue && (tcp_socket_set_receive_queue(&b->s, 1) < 0 ||
+               tcp_socket_set_delayed_ack(&b->s, 1) < 0)) {
+    printf("TCP benchmark: no receive queue,"
+           " UIP_CONF_TCP_RECEIVE_QUEUE is 0\n");
+  }
+  tcp_socket_listen(&b->s, port);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(tcp_bench_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+#if LOSS
+  netstack_ip_packet_processor_add(&loss_processor);
+  printf("TCP benchmark: dropping every %u-th data segment\n", LOSS);
+#endif /* LOSS */
+  bench_listen(&benches[0], WINDOW_PORT, 1);
+  bench_listen(&benches[1], SINGLE_PORT, 0);
+  printf("TCP benchmark: listening on ports %u (window of %u segments)"
+         " and %u (one segment)\n",
+         WINDOW_PORT, UIP_TCP_SEND_WINDOW, SINGLE_PORT);
+  receiver_listen(&benches[2], QUEUE_PORT, 1);
+  receiver_listen(&benches[3], PLAIN_PORT, 0);
+  printf("TCP benchmark: receiving on ports %u (queue of %u segments)"
+         " and %u (no queue)\n",
+         QUEUE_PORT, UIP_TCP_RECEIVE_QUEUE, PLAIN_PORT);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+#
+# The receiving end of the TCP benchmark. It connects to the native node,
+# asks for --bytes bytes, reads them until the node closes the connection
+# and checks that each byte is the one expected at its offset.
+#
+# A summary is printed when it exits. "errors" counts the bytes with a
+# wrong value, and the missing or extra bytes.
+#
+# Options:
+#   --address A       address of the node (default fd00::302:304:506:708)
+#   --port P          TCP port of the node (default 8080)
+#   --bytes N         bytes to ask for (default 1048576)
+#   --timeout S       give up after S seconds (default 60)
+#
+import argparse
+import socket
+import time
+
+
+def expected(offset, length):
+    return bytes((offset + i) % 251 for i in range(length))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--address', default='fd00::302:304:506:708')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--bytes', type=int, default=1048576)
+    parser.add_argument('--timeout', type=float, default=60)
+    args = parser.parse_args()
+
+    # The expected data repeats every 251 bytes
+    pattern = expected(0, 251 + 65536)
+
+    sock = socket.create_connection((args.address, args.port),
+                                    timeout=args.timeout)
+    start = time.time()
+    sock.sendall(b'%u\n' % args.bytes)
+
+    received = errors = 0
+    while True:
+        try:
+            data = sock.recv(65536)
+        except socket.timeout:
+            break
+        if not data:
+            break
+        start_offset = received % 251
+        if data != pattern[start_offset:start_offset + len(data)]:
+            errors += sum(1 for a, b in
+                          zip(data, expected(received, len(data))) if a != b)
+        received += len(data)
+    elapsed = time.time() - start
+    sock.close()
+
+    errors += abs(received - args.bytes)
+    print("Sink: port %u received %u bytes in %u ms, %u kB/s, errors %u" %
+          (args.port, received, elapsed * 1000,
+           received / 1000 / elapsed if elapsed > 0 else 0, errors),
+          flush=True)
+
+
+if __name__ == '__main__':
+    main()
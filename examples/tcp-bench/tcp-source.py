@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# The sending end of the TCP benchmark. It connects to the native node,
+# sends --bytes bytes, closes its side of the connection and waits for
+# the node to close the other side. The node checks each byte.
+#
+# A summary is printed when it exits.
+#
+# Options:
+#   --address A       address of the node (default fd00::302:304:506:708)
+#   --port P          TCP port of the node (default 8082)
+#   --bytes N         bytes to send (default 1048576)
+#   --timeout S       give up after S seconds (default 60)
+#
+import argparse
+import socket
+import time
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--address', default='fd00::302:304:506:708')
+    parser.add_argument('--port', type=int, default=8082)
+    parser.add_argument('--bytes', type=int, default=1048576)
+    parser.add_argument('--timeout', type=float, default=60)
+    args = parser.parse_args()
+
+    # The data repeats every 251 bytes
+    pattern = bytes(i % 251 for i in range(251 + 65536))
+
+    sock = socket.create_connection((args.address, args.port),
+                                    timeout=args.timeout)
+    start = time.time()
+    sent = 0
+    try:
+        while sent < args.bytes:
+            length = min(args.bytes - sent, 65536)
+            offset = sent % 251
+            sock.sendall(pattern[offset:offset + length])
+            sent += length
+        sock.shutdown(socket.SHUT_WR)
+        while sock.recv(65536):
+            pass
+    except socket.timeout:
+        pass
+    elapsed = time.time() - start
+    sock.close()
+
+    print("Source: port %u sent %u bytes in %u ms, %u kB/s" %
+          (args.port, sent, elapsed * 1000,
+           sent / 1000 / elapsed if elapsed > 0 else 0),
+          flush=True)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         UDP echo node for measuring the packet rate of the tun interface
+ *         of the native platform. Each datagram received on the benchmark
+ *         port is sent back to its sender. The number of echoed datagrams
+ *         is printed every few seconds while traffic arrives.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/ipv6/simple-udp.h"
+
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+#define BENCH_PORT      7777
+#define REPORT_INTERVAL (CLOCK_SECOND * 2)
+/*---------------------------------------------------------------------------*/
+PROCESS(tun_bench_process, "tun benchmark");
+AUTOSTART_PROCESSES(&tun_bench_process);
+/*---------------------------------------------------------------------------*/
+static struct simple_udp_connection udp_conn;
+static unsigned long echoed;
+/*---------------------------------------------------------------------------*/
+static void
+udp_rx_callback(struct simple_udp_connection *c,
+                const uip_ipaddr_t *sender_addr,
+                uint16_t sender_port,
+                const uip_ipaddr_t *receiver_addr,
+                uint16_t receiver_port,
+                const uint8_t *data,
+                uint16_t datalen)
+{
+  simple_udp_sendto_port(c, data, datalen, sender_addr, sender_port);
+  echoed++;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(tun_bench_process, ev, data)
+{
+  static struct etimer report_timer;
+  static unsigned long reported;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp_conn, BENCH_PORT, NULL, 0, udp_rx_callback);
+  printf("tun benchmark: echoing UDP port %u\n", BENCH_PORT);
+
+  etimer_set(&report_timer, REPORT_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&report_timer));
+    etimer_reset(&report_timer);
+    if(echoed != reported) {
+      printf("tun benchmark: echoed %lu datagrams, %lu per second\n",
+             echoed, (echoed - reported) * CLOCK_SECOND / REPORT_INTERVAL);
+      reported = echoed;
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
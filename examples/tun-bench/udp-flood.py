@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+#
+# A traffic generator for the tun benchmark. It sends UDP datagrams to the
+# echo port of the native node and counts the echoes. At most --window
+# datagrams are in flight, so the generator sends as fast as the node
+# answers without overflowing the queues of the tun device. A datagram
+# that is not echoed within one second is counted as lost.
+#
+# A summary is printed when it exits. "pps" is the number of echoed
+# datagrams per second.
+#
+# Options:
+#   --address A       address of the node (default fd00::302:304:506:708)
+#   --port P          UDP port of the node (default 7777)
+#   --duration S      send for S seconds (default 5)
+#   --window N        datagrams in flight (default 32)
+#   --size N          payload bytes of each datagram (default 64)
+#
+import argparse
+import select
+import socket
+import struct
+import time
+
+TIMEOUT = 1.0
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--address', default='fd00::302:304:506:708')
+    parser.add_argument('--port', type=int, default=7777)
+    parser.add_argument('--duration', type=float, default=5)
+    parser.add_argument('--window', type=int, default=32)
+    parser.add_argument('--size', type=int, default=64)
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    sock.setblocking(False)
+    address = (args.address, args.port)
+    padding = bytes(max(args.size - 4, 0))
+
+    # Send times of the datagrams in flight, by sequence number
+    in_flight = {}
+    sent = echoed = lost = 0
+    seqno = 0
+    start = time.time()
+    deadline = start + args.duration
+
+    while True:
+        now = time.time()
+        if now < deadline:
+            while len(in_flight) < args.window:
+                try:
+                    sock.sendto(struct.pack('>I', seqno) + padding, address)
+                except BlockingIOError:
+                    break
+                in_flight[seqno] = now
+                seqno += 1
+                sent += 1
+        elif not in_flight:
+            break
+
+        readable, _, _ = select.select([sock], [], [], 0.1)
+        while readable:
+            try:
+                data = sock.recv(2048)
+            except BlockingIOError:
+                break
+            if len(data) >= 4:
+                if in_flight.pop(struct.unpack('>I', data[:4])[0], None):
+                    echoed += 1
+
+        now = time.time()
+        for number, sent_at in list(in_flight.items()):
+            if now - sent_at > TIMEOUT:
+                del in_flight[number]
+                lost += 1
+
+    elapsed = time.time() - start
+    print("Flood: sent %u echoed %u lost %u pps %u" %
+          (sent, echoed, lost, echoed / elapsed), flush=True)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Sparse index of a sorted linked list
+ */
+
+#include "lib/list-index.h"
+/*---------------------------------------------------------------------------*/
+void
+list_index_update(struct list_index *index, list_t list)
+{
+  void *item;
+  int length;
+  uint16_t i;
+
+  length = list_length(list);
+  index->stride = length > index->size ?
+    (length + index->size - 1) / index->size : 1;
+
+  index->count = 0;
+  i = 0;
+  for(item = list_head(list); item != NULL; item = list_item_next(item)) {
+    if(i == 0) {
+      index->items[index->count++] = item;
+    }
+    if(++i == index->stride) {
+      i = 0;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_index_lower_bound(const struct list_index *index, list_t list,
+                       const void *key, list_index_cmp_t cmp, void **prev)
+{
+  void *item;
+  void *last;
+  uint16_t low, high, mid;
+
+  low = 0;
+  high = index->count;
+  while(low < high) {
+    mid = (low + high) / 2;
+    if(cmp(index->items[mid], key) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  /*
+   * The item is after the last indexed item before the key, within one
+   * stride of it
+   */
+  last = low > 0 ? index->items[low - 1] : NULL;
+  item = last != NULL ? list_item_next(last) : list_head(list);
+  while(item != NULL && cmp(item, key) < 0) {
+    last = item;
+    item = list_item_next(item);
+  }
+
+  if(prev != NULL) {
+    *prev = last;
+  }
+  return item;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/** \addtogroup data
+    @{ */
+/**
+ * \defgroup list-index Sparse index of a sorted linked list
+ *
+ * A list index speeds up the search of a linked list that is kept
+ * sorted. It holds every Nth item of the list in an array, where N, the
+ * stride, is the smallest number that fits the whole list in the
+ * array. A search is a binary search of the array followed by a walk of
+ * at most N items of the list.
+ *
+ * The index must be rebuilt with list_index_update() every time an item
+ * is added to or removed from the list.
+ * @{
+ */
+
+#ifndef LIST_INDEX_H_
+#define LIST_INDEX_H_
+
+#include "contiki.h"
+#include "lib/list.h"
+
+/**
+ * Compares an item of the list with a search key. Returns < 0 if the item
+ * is before the key, 0 if it matches and > 0 if it is after the key.
+ */
+typedef int (*list_index_cmp_t)(const void *item, const void *key);
+
+struct list_index {
+  void **items;
+  uint16_t size;
+  uint16_t count;
+  uint16_t stride;
+};
+
+/**
+ * Declare a list index of \c size items.
+ *
+ * \param name The name of the list index
+ * \param size The number of items held by the index
+ */
+#define LIST_INDEX(name, size)                                          \
+  static void *LIST_CONCAT(name, _items)[size];                         \
+  static struct list_index name = { LIST_CONCAT(name, _items), size, 0, 1 }
+
+/**
+ * \brief Rebuild the index of a sorted list
+ * \param index The list index
+ * \param list The list
+ */
+void list_index_update(struct list_index *index, list_t list);
+
+/**
+ * \brief Find the first item of a sorted list that is not before a key
+ * \param index The list index, up to date with the list
+ * \param list The list
+ * \param key The search key
+ * \param cmp The comparison of the list order
+ * \param prev Set to the item before the one returned, or NULL if it is
+ *        the first item. May be NULL.
+ * \return The item, or NULL if all the items are before the key
+ */
+void *list_index_lower_bound(const struct list_index *index, list_t list,
+                             const void *key, list_index_cmp_t cmp,
+                             void **prev);
+
+#endif /* LIST_INDEX_H_ */
+
+/** @} */
+/** @} */
@@ -79,7 +79,10 @@ typedef enum {
   COAP_GET = 1,
   COAP_POST,
   COAP_PUT,
-  COAP_DELETE
+  COAP_DELETE,
+  COAP_FETCH,                   /* RFC 8132 */
+  COAP_PATCH,
+  COAP_IPATCH
 } coap_method_t;
 
 /* CoAP response codes */
@@ -167,7 +167,7 @@ coap_receive(const coap_endpoint_t *src,
     LOG_DBG_("\n");
 
     /* handle requests */
-    if(message->code >= COAP_GET && message->code <= COAP_DELETE) {
+    if(message->code >= COAP_GET && message->code <= COAP_IPATCH) {
 
       /* use transaction buffer for response to confirmable request */
       if((transaction = coap_new_transaction(message->mid, src))) {
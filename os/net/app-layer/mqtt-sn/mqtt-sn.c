@@ -0,0 +1,965 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup mqtt-sn-engine
+ * @{
+ */
+/**
+ * \file
+ *    Implementation of the Contiki MQTT-SN client
+ */
+/*---------------------------------------------------------------------------*/
+#include "mqtt-sn.h"
+#include "net/ipv6/uiplib.h"
+
+#include <string.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "MQTT-SN"
+#define LOG_LEVEL LOG_LEVEL_MQTT_SN
+/*---------------------------------------------------------------------------*/
+typedef enum {
+  MQTT_SN_MSG_ADVERTISE   = 0x00,
+  MQTT_SN_MSG_SEARCHGW    = 0x01,
+  MQTT_SN_MSG_GWINFO      = 0x02,
+  MQTT_SN_MSG_CONNECT     = 0x04,
+  MQTT_SN_MSG_CONNACK     = 0x05,
+  MQTT_SN_MSG_REGISTER    = 0x0A,
+  MQTT_SN_MSG_REGACK      = 0x0B,
+  MQTT_SN_MSG_PUBLISH     = 0x0C,
+  MQTT_SN_MSG_PUBACK      = 0x0D,
+  MQTT_SN_MSG_SUBSCRIBE   = 0x12,
+  MQTT_SN_MSG_SUBACK      = 0x13,
+  MQTT_SN_MSG_UNSUBSCRIBE = 0x14,
+  MQTT_SN_MSG_UNSUBACK    = 0x15,
+  MQTT_SN_MSG_PINGREQ     = 0x16,
+  MQTT_SN_MSG_PINGRESP    = 0x17,
+  MQTT_SN_MSG_DISCONNECT  = 0x18,
+} mqtt_sn_msg_type_t;
+
+typedef enum {
+  MQTT_SN_FLAG_DUP           = 0x80,
+  MQTT_SN_FLAG_QOS_SHIFT     = 5,
+  MQTT_SN_FLAG_QOS_MASK      = 0x60,
+  MQTT_SN_FLAG_RETAIN        = 0x10,
+  MQTT_SN_FLAG_CLEAN_SESSION = 0x04,
+  MQTT_SN_FLAG_TOPIC_MASK    = 0x03,
+} mqtt_sn_flags_t;
+
+/*
+ * Message bodies are written at this offset into a buffer, which leaves room
+ * for the three-byte Length field of long messages and the MsgType.
+ */
+#define BODY_OFFSET 4
+#define MAX_BODY_SIZE (MQTT_SN_MAX_PACKET_SIZE - BODY_OFFSET)
+
+/* No reply is expected */
+#define NO_REPLY 0xFF
+/*---------------------------------------------------------------------------*/
+static void
+call_event(struct mqtt_sn_connection *conn, mqtt_sn_event_t event, void *data)
+{
+  conn->event_callback(conn, event, data);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+next_mid(struct mqtt_sn_connection *conn)
+{
+  if(++conn->mid_counter == 0) {
+    conn->mid_counter = 1;
+  }
+  return conn->mid_counter;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+write_u16(uint8_t *p, uint16_t value)
+{
+  p[0] = value >> 8;
+  p[1] = value & 0xFF;
+  return p + 2;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+read_u16(const uint8_t *p)
+{
+  return (p[0] << 8) | p[1];
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Adds the Length and MsgType fields in front of a message body written at
+ * BODY_OFFSET. Returns the length of the message.
+ */
+static uint16_t
+finish_message(uint8_t *buf, uint8_t type, uint8_t *end)
+{
+  uint16_t body_length = end - &buf[BODY_OFFSET];
+  uint16_t length = body_length + 2;
+
+  if(length <= 0xFF) {
+    buf[0] = length;
+    buf[1] = type;
+    memmove(&buf[2], &buf[BODY_OFFSET], body_length);
+    return length;
+  }
+
+  length += 2;
+  buf[0] = 0x01;
+  write_u16(&buf[1], length);
+  buf[3] = type;
+  return length;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_message(struct mqtt_sn_connection *conn, const uint8_t *buf,
+             uint16_t length)
+{
+  simple_udp_sendto_port(&conn->udp, buf, length, &conn->gw_addr,
+                         conn->gw_port);
+  conn->stats.tx_datagrams++;
+  conn->stats.tx_bytes += length;
+}
+/*---------------------------------------------------------------------------*/
+/* Topic table */
+/*---------------------------------------------------------------------------*/
+static struct mqtt_sn_topic *
+topic_lookup_id(struct mqtt_sn_connection *conn, uint8_t type, uint16_t id)
+{
+  int i;
+
+  for(i = 0; i < MQTT_SN_MAX_TOPICS; i++) {
+    if(conn->topics[i].name[0] != '\0' &&
+       conn->topics[i].type == type && conn->topics[i].id == id) {
+      return &conn->topics[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct mqtt_sn_topic *
+topic_lookup_name(struct mqtt_sn_connection *conn, const char *name)
+{
+  int i;
+
+  for(i = 0; i < MQTT_SN_MAX_TOPICS; i++) {
+    if(conn->topics[i].name[0] != '\0' &&
+       strcmp(conn->topics[i].name, name) == 0) {
+      return &conn->topics[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct mqtt_sn_topic *
+topic_add(struct mqtt_sn_connection *conn, uint8_t type, uint16_t id,
+          const char *name)
+{
+  struct mqtt_sn_topic *topic;
+  int i;
+
+  if(name[0] == '\0' || strlen(name) > MQTT_SN_MAX_TOPIC_LENGTH) {
+    return NULL;
+  }
+
+  topic = topic_lookup_name(conn, name);
+  for(i = 0; topic == NULL && i < MQTT_SN_MAX_TOPICS; i++) {
+    if(conn->topics[i].name[0] == '\0') {
+      topic = &conn->topics[i];
+    }
+  }
+
+  if(topic == NULL) {
+    LOG_WARN("topic table full, %s not kept\n", name);
+    return NULL;
+  }
+
+  topic->type = type;
+  topic->id = id;
+  strcpy(topic->name, name);
+  return topic;
+}
+/*---------------------------------------------------------------------------*/
+/* Requests that wait for a reply */
+/*---------------------------------------------------------------------------*/
+static void
+reset_connection(struct mqtt_sn_connection *conn)
+{
+  ctimer_stop(&conn->retry_timer);
+  ctimer_stop(&conn->keep_alive_timer);
+  conn->out_queue_full = 0;
+  conn->out_reply_type = NO_REPLY;
+  conn->waiting_for_pingresp = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* The gateway does not answer, or has closed the connection */
+static void
+abort_connection(struct mqtt_sn_connection *conn)
+{
+  reset_connection(conn);
+  conn->state = MQTT_SN_CONN_STATE_DISCONNECTED;
+  call_event(conn, MQTT_SN_EVENT_DISCONNECTED, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+retry_callback(void *ptr)
+{
+  struct mqtt_sn_connection *conn = ptr;
+
+  if(conn->out_retries >= MQTT_SN_RETRY_COUNT) {
+    LOG_WARN("no reply from the gateway\n");
+    abort_connection(conn);
+    return;
+  }
+
+  conn->out_retries++;
+  conn->stats.retransmissions++;
+
+  /* Retransmitted PUBLISH messages are marked as duplicates */
+  if(conn->out_reply_type == MQTT_SN_MSG_PUBACK) {
+    conn->out_buffer[conn->out_buffer[0] == 0x01 ? 4 : 2] |= MQTT_SN_FLAG_DUP;
+  }
+
+  LOG_DBG("retransmitting, attempt %u\n", conn->out_retries);
+  send_message(conn, conn->out_buffer, conn->out_length);
+  ctimer_restart(&conn->retry_timer);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends the request in the out buffer and waits for its reply */
+static void
+start_request(struct mqtt_sn_connection *conn, uint8_t reply_type,
+              uint16_t mid)
+{
+  conn->out_queue_full = 1;
+  conn->out_reply_type = reply_type;
+  conn->out_mid = mid;
+  conn->out_retries = 0;
+  send_message(conn, conn->out_buffer, conn->out_length);
+  ctimer_set(&conn->retry_timer, MQTT_SN_RETRY_TIMEOUT, retry_callback, conn);
+}
+/*---------------------------------------------------------------------------*/
+/* Checks if a reply ends the request that waits for it */
+static int
+end_request(struct mqtt_sn_connection *conn, uint8_t reply_type,
+            uint16_t mid)
+{
+  if(!conn->out_queue_full || conn->out_reply_type != reply_type ||
+     conn->out_mid != mid) {
+    return 0;
+  }
+
+  ctimer_stop(&conn->retry_timer);
+  conn->out_queue_full = 0;
+  conn->out_reply_type = NO_REPLY;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+keep_alive_callback(void *ptr)
+{
+  struct mqtt_sn_connection *conn = ptr;
+  uint8_t pingreq[2] = { 2, MQTT_SN_MSG_PINGREQ };
+
+  if(conn->state != MQTT_SN_CONN_STATE_CONNECTED) {
+    return;
+  }
+
+  if(conn->waiting_for_pingresp) {
+    LOG_WARN("no PINGRESP from the gateway\n");
+    abort_connection(conn);
+    return;
+  }
+
+  conn->waiting_for_pingresp = 1;
+  send_message(conn, pingreq, sizeof(pingreq));
+  ctimer_restart(&conn->keep_alive_timer);
+}
+/*---------------------------------------------------------------------------*/
+/* Input */
+/*---------------------------------------------------------------------------*/
+static void
+send_ack(struct mqtt_sn_connection *conn, uint8_t type, uint16_t topic_id,
+         uint16_t mid, uint8_t return_code)
+{
+  uint8_t buf[7];
+
+  buf[0] = sizeof(buf);
+  buf[1] = type;
+  write_u16(&buf[2], topic_id);
+  write_u16(&buf[4], mid);
+  buf[6] = return_code;
+  send_message(conn, buf, sizeof(buf));
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_connack(struct mqtt_sn_connection *conn, const uint8_t *body,
+               uint16_t length)
+{
+  uint8_t return_code;
+
+  if(length < 1 || !end_request(conn, MQTT_SN_MSG_CONNACK, 0)) {
+    return;
+  }
+
+  return_code = body[0];
+  if(return_code != MQTT_SN_RC_ACCEPTED) {
+    LOG_WARN("connection refused, return code %u\n", return_code);
+    reset_connection(conn);
+    conn->state = MQTT_SN_CONN_STATE_DISCONNECTED;
+    call_event(conn, MQTT_SN_EVENT_CONNECTION_REFUSED_ERROR, &return_code);
+    return;
+  }
+
+  conn->state = MQTT_SN_CONN_STATE_CONNECTED;
+  if(conn->keep_alive > 0) {
+    ctimer_set(&conn->keep_alive_timer, conn->keep_alive * CLOCK_SECOND,
+               keep_alive_callback, conn);
+  }
+  call_event(conn, MQTT_SN_EVENT_CONNECTED, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_register(struct mqtt_sn_connection *conn, const uint8_t *body,
+                uint16_t length)
+{
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+  uint16_t topic_id;
+  uint16_t mid;
+  uint8_t return_code = MQTT_SN_RC_ACCEPTED;
+
+  if(length < 5) {
+    return;
+  }
+
+  /* The gateway tells the topic ID of a topic matching a wildcard */
+  topic_id = read_u16(&body[0]);
+  mid = read_u16(&body[2]);
+  if(length - 4 > MQTT_SN_MAX_TOPIC_LENGTH) {
+    return_code = MQTT_SN_RC_NOT_SUPPORTED;
+  } else {
+    memcpy(name, &body[4], length - 4);
+    name[length - 4] = '\0';
+    if(topic_add(conn, MQTT_SN_TOPIC_TYPE_NORMAL, topic_id, name) == NULL) {
+      return_code = MQTT_SN_RC_CONGESTION;
+    }
+  }
+  send_ack(conn, MQTT_SN_MSG_REGACK, topic_id, mid, return_code);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_regack(struct mqtt_sn_connection *conn, const uint8_t *body,
+              uint16_t length)
+{
+  struct mqtt_sn_regack_event event;
+
+  if(length < 5) {
+    return;
+  }
+
+  event.topic_id = read_u16(&body[0]);
+  event.mid = read_u16(&body[2]);
+  event.return_code = body[4];
+  if(!end_request(conn, MQTT_SN_MSG_REGACK, event.mid)) {
+    return;
+  }
+
+  if(event.return_code == MQTT_SN_RC_ACCEPTED) {
+    topic_add(conn, MQTT_SN_TOPIC_TYPE_NORMAL, event.topic_id,
+              conn->pending_topic);
+  }
+  call_event(conn, MQTT_SN_EVENT_REGACK, &event);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_publish(struct mqtt_sn_connection *conn, const uint8_t *body,
+               uint16_t length)
+{
+  struct mqtt_sn_message *msg = &conn->in_publish_msg;
+  struct mqtt_sn_topic *topic;
+  uint8_t flags;
+  uint8_t qos;
+
+  if(length < 5) {
+    return;
+  }
+
+  flags = body[0];
+  qos = (flags & MQTT_SN_FLAG_QOS_MASK) >> MQTT_SN_FLAG_QOS_SHIFT;
+  msg->topic_type = flags & MQTT_SN_FLAG_TOPIC_MASK;
+  msg->topic_id = read_u16(&body[1]);
+  msg->mid = read_u16(&body[3]);
+
+  if(msg->topic_type == MQTT_SN_TOPIC_TYPE_SHORT) {
+    msg->topic[0] = body[1];
+    msg->topic[1] = body[2];
+    msg->topic[2] = '\0';
+  } else {
+    topic = topic_lookup_id(conn, msg->topic_type, msg->topic_id);
+    if(topic != NULL) {
+      strcpy(msg->topic, topic->name);
+    } else if(msg->topic_type == MQTT_SN_TOPIC_TYPE_NORMAL) {
+      /* The gateway shall have registered the topic ID first */
+      LOG_WARN("PUBLISH on unknown topic ID %u\n", msg->topic_id);
+      send_ack(conn, MQTT_SN_MSG_PUBACK, msg->topic_id, msg->mid,
+               MQTT_SN_RC_INVALID_TOPIC_ID);
+      return;
+    } else {
+      msg->topic[0] = '\0';
+    }
+  }
+  msg->topic_length = strlen(msg->topic);
+
+  msg->payload_chunk = &body[5];
+  msg->payload_chunk_length = length - 5;
+  msg->payload_length = msg->payload_chunk_length;
+  msg->payload_offset = 0;
+  msg->payload_left = 0;
+  msg->first_chunk = 1;
+
+  if(qos == MQTT_SN_QOS_LEVEL_1) {
+    send_ack(conn, MQTT_SN_MSG_PUBACK, msg->topic_id, msg->mid,
+             MQTT_SN_RC_ACCEPTED);
+  }
+
+  call_event(conn, MQTT_SN_EVENT_PUBLISH, msg);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_puback(struct mqtt_sn_connection *conn, const uint8_t *body,
+              uint16_t length)
+{
+  struct mqtt_sn_puback_event event;
+
+  if(length < 5) {
+    return;
+  }
+
+  event.topic_id = read_u16(&body[0]);
+  event.mid = read_u16(&body[2]);
+  event.return_code = body[4];
+
+  /*
+   * A PUBACK that does not end a request rejects a QoS 0 message, for
+   * example one that was published to an unknown topic ID.
+   */
+  if(!end_request(conn, MQTT_SN_MSG_PUBACK, event.mid) &&
+     event.return_code == MQTT_SN_RC_ACCEPTED) {
+    return;
+  }
+  call_event(conn, MQTT_SN_EVENT_PUBACK, &event);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_suback(struct mqtt_sn_connection *conn, const uint8_t *body,
+              uint16_t length)
+{
+  struct mqtt_sn_suback_event event;
+
+  if(length < 6) {
+    return;
+  }
+
+  event.qos_level = (body[0] & MQTT_SN_FLAG_QOS_MASK) >> MQTT_SN_FLAG_QOS_SHIFT;
+  event.topic_id = read_u16(&body[1]);
+  event.mid = read_u16(&body[3]);
+  event.return_code = body[5];
+  event.success = event.return_code == MQTT_SN_RC_ACCEPTED;
+  if(!end_request(conn, MQTT_SN_MSG_SUBACK, event.mid)) {
+    return;
+  }
+
+  /* Topic names without wildcards get a topic ID */
+  if(event.success && event.topic_id != 0 &&
+     strpbrk(conn->pending_topic, "#+") == NULL) {
+    topic_add(conn, MQTT_SN_TOPIC_TYPE_NORMAL, event.topic_id,
+              conn->pending_topic);
+  }
+  call_event(conn, MQTT_SN_EVENT_SUBACK, &event);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_unsuback(struct mqtt_sn_connection *conn, const uint8_t *body,
+                uint16_t length)
+{
+  uint16_t mid;
+
+  if(length < 2) {
+    return;
+  }
+
+  mid = read_u16(&body[0]);
+  if(end_request(conn, MQTT_SN_MSG_UNSUBACK, mid)) {
+    call_event(conn, MQTT_SN_EVENT_UNSUBACK, &mid);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_pingresp(struct mqtt_sn_connection *conn)
+{
+  conn->waiting_for_pingresp = 0;
+
+  /* The gateway has sent all buffered messages to the sleeping client */
+  if(conn->state == MQTT_SN_CONN_STATE_AWAKE &&
+     end_request(conn, MQTT_SN_MSG_PINGRESP, 0)) {
+    conn->state = MQTT_SN_CONN_STATE_ASLEEP;
+    call_event(conn, MQTT_SN_EVENT_ASLEEP, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_disconnect(struct mqtt_sn_connection *conn)
+{
+  if(end_request(conn, MQTT_SN_MSG_DISCONNECT, 0) &&
+     conn->sleep_duration > 0) {
+    reset_connection(conn);
+    conn->state = MQTT_SN_CONN_STATE_ASLEEP;
+    call_event(conn, MQTT_SN_EVENT_ASLEEP, NULL);
+    return;
+  }
+
+  abort_connection(conn);
+}
+/*---------------------------------------------------------------------------*/
+static void
+udp_input(struct simple_udp_connection *c,
+          const uip_ipaddr_t *sender_addr,
+          uint16_t sender_port,
+          const uip_ipaddr_t *receiver_addr,
+          uint16_t receiver_port,
+          const uint8_t *data,
+          uint16_t datalen)
+{
+  struct mqtt_sn_connection *conn = (struct mqtt_sn_connection *)c;
+  uint16_t length;
+  uint8_t header_length;
+  const uint8_t *body;
+  uint8_t type;
+
+  if(!conn->has_gw || sender_port != conn->gw_port ||
+     !uip_ipaddr_cmp(sender_addr, &conn->gw_addr)) {
+    return;
+  }
+
+  conn->stats.rx_datagrams++;
+  conn->stats.rx_bytes += datalen;
+
+  if(datalen >= 4 && data[0] == 0x01) {
+    length = read_u16(&data[1]);
+    header_length = 3;
+  } else if(datalen >= 2) {
+    length = data[0];
+    header_length = 1;
+  } else {
+    return;
+  }
+
+  if(length > datalen || length < header_length + 1) {
+    LOG_WARN("malformed message of %u bytes\n", datalen);
+    call_event(conn, MQTT_SN_EVENT_PROTOCOL_ERROR, NULL);
+    return;
+  }
+
+  type = data[header_length];
+  body = &data[header_length + 1];
+  length -= header_length + 1;
+  LOG_DBG("got message type 0x%02x with %u bytes\n", type, length);
+
+  switch(type) {
+  case MQTT_SN_MSG_CONNACK:
+    handle_connack(conn, body, length);
+    break;
+  case MQTT_SN_MSG_REGISTER:
+    handle_register(conn, body, length);
+    break;
+  case MQTT_SN_MSG_REGACK:
+    handle_regack(conn, body, length);
+    break;
+  case MQTT_SN_MSG_PUBLISH:
+    handle_publish(conn, body, length);
+    break;
+  case MQTT_SN_MSG_PUBACK:
+    handle_puback(conn, body, length);
+    break;
+  case MQTT_SN_MSG_SUBACK:
+    handle_suback(conn, body, length);
+    break;
+  case MQTT_SN_MSG_UNSUBACK:
+    handle_unsuback(conn, body, length);
+    break;
+  case MQTT_SN_MSG_PINGREQ:
+    {
+      uint8_t pingresp[2] = { 2, MQTT_SN_MSG_PINGRESP };
+      send_message(conn, pingresp, sizeof(pingresp));
+    }
+    break;
+  case MQTT_SN_MSG_PINGRESP:
+    handle_pingresp(conn);
+    break;
+  case MQTT_SN_MSG_DISCONNECT:
+    handle_disconnect(conn);
+    break;
+  case MQTT_SN_MSG_ADVERTISE:
+  case MQTT_SN_MSG_GWINFO:
+    /* Gateway discovery is not used, the gateway is configured */
+    break;
+  default:
+    LOG_DBG("unhandled message type 0x%02x\n", type);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* API */
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_register(struct mqtt_sn_connection *conn,
+                 struct process *app_process,
+                 const char *client_id,
+                 mqtt_sn_event_callback_t event_callback,
+                 uint16_t local_port)
+{
+  if(client_id == NULL || strlen(client_id) > MQTT_SN_CLIENT_ID_MAX_LEN ||
+     event_callback == NULL) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  memset(conn, 0, sizeof(*conn));
+  conn->app_process = app_process;
+  conn->event_callback = event_callback;
+  strcpy(conn->client_id, client_id);
+  conn->state = MQTT_SN_CONN_STATE_DISCONNECTED;
+  conn->out_reply_type = NO_REPLY;
+  conn->mid_counter = 1;
+
+  if(!simple_udp_register(&conn->udp, local_port, NULL, 0, udp_input)) {
+    return MQTT_SN_STATUS_ERROR;
+  }
+  /* Run the callbacks in the context of the application */
+  conn->udp.client_process = app_process;
+
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_set_gateway(struct mqtt_sn_connection *conn,
+                    const char *host, uint16_t port)
+{
+  if(host == NULL || !uiplib_ipaddrconv(host, &conn->gw_addr)) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  conn->gw_port = port;
+  conn->has_gw = 1;
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_connect(struct mqtt_sn_connection *conn,
+                const char *host,
+                uint16_t port,
+                uint16_t keep_alive,
+                uint8_t clean_session)
+{
+  uint8_t *p = &conn->out_buffer[BODY_OFFSET];
+  mqtt_sn_status_t status;
+
+  if(conn->out_queue_full) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+
+  status = mqtt_sn_set_gateway(conn, host, port);
+  if(status != MQTT_SN_STATUS_OK) {
+    return status;
+  }
+
+  conn->keep_alive = keep_alive;
+  conn->sleep_duration = 0;
+  conn->waiting_for_pingresp = 0;
+
+  *p++ = clean_session ? MQTT_SN_FLAG_CLEAN_SESSION : 0;
+  *p++ = MQTT_SN_PROTOCOL_ID;
+  p = write_u16(p, keep_alive);
+  memcpy(p, conn->client_id, strlen(conn->client_id));
+  p += strlen(conn->client_id);
+  conn->out_length = finish_message(conn->out_buffer, MQTT_SN_MSG_CONNECT, p);
+
+  conn->state = MQTT_SN_CONN_STATE_CONNECTING;
+  start_request(conn, MQTT_SN_MSG_CONNACK, 0);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+void
+mqtt_sn_disconnect(struct mqtt_sn_connection *conn)
+{
+  if(conn->state == MQTT_SN_CONN_STATE_DISCONNECTED ||
+     conn->state == MQTT_SN_CONN_STATE_DISCONNECTING) {
+    return;
+  }
+
+  /* A pending request is abandoned */
+  reset_connection(conn);
+  conn->sleep_duration = 0;
+  conn->out_length = finish_message(conn->out_buffer, MQTT_SN_MSG_DISCONNECT,
+                                    &conn->out_buffer[BODY_OFFSET]);
+  conn->state = MQTT_SN_CONN_STATE_DISCONNECTING;
+  start_request(conn, MQTT_SN_MSG_DISCONNECT, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a REGISTER, SUBSCRIBE or UNSUBSCRIBE request for a topic */
+static mqtt_sn_status_t
+topic_request(struct mqtt_sn_connection *conn, uint16_t *mid,
+              uint8_t type, uint8_t flags, uint16_t topic_id,
+              const char *topic)
+{
+  uint8_t *p = &conn->out_buffer[BODY_OFFSET];
+  uint16_t topic_length = topic != NULL ? strlen(topic) : 0;
+
+  if(!mqtt_sn_connected(conn)) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+  if(conn->out_queue_full) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+  if(topic_length > MQTT_SN_MAX_TOPIC_LENGTH) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  conn->out_mid = next_mid(conn);
+  if(mid != NULL) {
+    *mid = conn->out_mid;
+  }
+
+  if(type == MQTT_SN_MSG_REGISTER) {
+    p = write_u16(p, 0);
+  } else {
+    *p++ = flags;
+  }
+  p = write_u16(p, conn->out_mid);
+  if(topic != NULL) {
+    memcpy(p, topic, topic_length);
+    p += topic_length;
+    strcpy(conn->pending_topic, topic);
+  } else {
+    p = write_u16(p, topic_id);
+    conn->pending_topic[0] = '\0';
+  }
+  conn->out_length = finish_message(conn->out_buffer, type, p);
+
+  start_request(conn, type + 1, conn->out_mid);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_register_topic(struct mqtt_sn_connection *conn, uint16_t *mid,
+                       const char *topic)
+{
+  if(topic == NULL || topic[0] == '\0') {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+  return topic_request(conn, mid, MQTT_SN_MSG_REGISTER, 0, 0, topic);
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_add_predefined_topic(struct mqtt_sn_connection *conn,
+                             uint16_t topic_id, const char *topic)
+{
+  if(topic_add(conn, MQTT_SN_TOPIC_TYPE_PREDEFINED, topic_id, topic) == NULL) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+mqtt_sn_topic_id(struct mqtt_sn_connection *conn, const char *topic)
+{
+  struct mqtt_sn_topic *t = topic_lookup_name(conn, topic);
+
+  return t != NULL ? t->id : 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Short topic names have two characters and are sent as topic IDs */
+static uint8_t
+topic_flags(const char *topic)
+{
+  return strlen(topic) == 2 ? MQTT_SN_TOPIC_TYPE_SHORT :
+         MQTT_SN_TOPIC_TYPE_NORMAL;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_subscribe(struct mqtt_sn_connection *conn, uint16_t *mid,
+                  const char *topic, mqtt_sn_qos_level_t qos_level)
+{
+  uint8_t flags;
+
+  if(topic == NULL || topic[0] == '\0' || qos_level > MQTT_SN_QOS_LEVEL_1) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  flags = qos_level << MQTT_SN_FLAG_QOS_SHIFT | topic_flags(topic);
+  if(topic_flags(topic) == MQTT_SN_TOPIC_TYPE_SHORT) {
+    return topic_request(conn, mid, MQTT_SN_MSG_SUBSCRIBE, flags,
+                         MQTT_SN_SHORT_TOPIC_ID(topic), NULL);
+  }
+  return topic_request(conn, mid, MQTT_SN_MSG_SUBSCRIBE, flags, 0, topic);
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_subscribe_id(struct mqtt_sn_connection *conn, uint16_t *mid,
+                     uint16_t topic_id, mqtt_sn_qos_level_t qos_level)
+{
+  if(qos_level > MQTT_SN_QOS_LEVEL_1) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+  return topic_request(conn, mid, MQTT_SN_MSG_SUBSCRIBE,
+                       qos_level << MQTT_SN_FLAG_QOS_SHIFT |
+                       MQTT_SN_TOPIC_TYPE_PREDEFINED, topic_id, NULL);
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_unsubscribe(struct mqtt_sn_connection *conn, uint16_t *mid,
+                    const char *topic)
+{
+  if(topic == NULL || topic[0] == '\0') {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  if(topic_flags(topic) == MQTT_SN_TOPIC_TYPE_SHORT) {
+    return topic_request(conn, mid, MQTT_SN_MSG_UNSUBSCRIBE,
+                         MQTT_SN_TOPIC_TYPE_SHORT,
+                         MQTT_SN_SHORT_TOPIC_ID(topic), NULL);
+  }
+  return topic_request(conn, mid, MQTT_SN_MSG_UNSUBSCRIBE,
+                       MQTT_SN_TOPIC_TYPE_NORMAL, 0, topic);
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_publish(struct mqtt_sn_connection *conn,
+                uint16_t *mid,
+                uint16_t topic_id,
+                mqtt_sn_topic_type_t topic_type,
+                const uint8_t *payload,
+                uint16_t payload_size,
+                mqtt_sn_qos_level_t qos_level,
+                mqtt_sn_retain_t retain)
+{
+  uint8_t buf[MQTT_SN_MAX_PACKET_SIZE];
+  uint8_t *out;
+  uint8_t *p;
+  uint16_t msg_mid = 0;
+
+  if(payload_size > MAX_BODY_SIZE - 5 || qos_level == MQTT_SN_QOS_LEVEL_2 ||
+     topic_type > MQTT_SN_TOPIC_TYPE_SHORT) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  if(qos_level == MQTT_SN_QOS_LEVEL_MINUS_1) {
+    if(!conn->has_gw || topic_type == MQTT_SN_TOPIC_TYPE_NORMAL) {
+      return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+    }
+  } else if(!mqtt_sn_connected(conn)) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+
+  /* Only QoS 1 messages wait for a reply in the out buffer */
+  if(qos_level == MQTT_SN_QOS_LEVEL_1) {
+    if(conn->out_queue_full) {
+      return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+    }
+    out = conn->out_buffer;
+    msg_mid = next_mid(conn);
+  } else {
+    out = buf;
+  }
+
+  if(mid != NULL) {
+    *mid = msg_mid;
+  }
+
+  p = &out[BODY_OFFSET];
+  *p++ = qos_level << MQTT_SN_FLAG_QOS_SHIFT |
+    (retain ? MQTT_SN_FLAG_RETAIN : 0) | topic_type;
+  p = write_u16(p, topic_id);
+  p = write_u16(p, msg_mid);
+  memcpy(p, payload, payload_size);
+  p += payload_size;
+
+  if(qos_level == MQTT_SN_QOS_LEVEL_1) {
+    conn->out_length = finish_message(out, MQTT_SN_MSG_PUBLISH, p);
+    start_request(conn, MQTT_SN_MSG_PUBACK, msg_mid);
+  } else {
+    send_message(conn, out, finish_message(out, MQTT_SN_MSG_PUBLISH, p));
+  }
+
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_sleep(struct mqtt_sn_connection *conn, uint16_t duration)
+{
+  uint8_t *p = &conn->out_buffer[BODY_OFFSET];
+
+  if(duration == 0) {
+    return MQTT_SN_STATUS_INVALID_ARGS_ERROR;
+  }
+  if(!mqtt_sn_connected(conn)) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+  if(conn->out_queue_full) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+
+  conn->sleep_duration = duration;
+  p = write_u16(p, duration);
+  conn->out_length = finish_message(conn->out_buffer, MQTT_SN_MSG_DISCONNECT,
+                                    p);
+  start_request(conn, MQTT_SN_MSG_DISCONNECT, 0);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+mqtt_sn_status_t
+mqtt_sn_wake(struct mqtt_sn_connection *conn)
+{
+  uint8_t *p = &conn->out_buffer[BODY_OFFSET];
+
+  if(conn->state != MQTT_SN_CONN_STATE_ASLEEP) {
+    return MQTT_SN_STATUS_NOT_CONNECTED_ERROR;
+  }
+  if(conn->out_queue_full) {
+    return MQTT_SN_STATUS_OUT_QUEUE_FULL;
+  }
+
+  memcpy(p, conn->client_id, strlen(conn->client_id));
+  p += strlen(conn->client_id);
+  conn->out_length = finish_message(conn->out_buffer, MQTT_SN_MSG_PINGREQ, p);
+
+  conn->state = MQTT_SN_CONN_STATE_AWAKE;
+  start_request(conn, MQTT_SN_MSG_PINGRESP, 0);
+  call_event(conn, MQTT_SN_EVENT_AWAKE, NULL);
+  return MQTT_SN_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \addtogroup apps
+ * @{
+ *
+ * \defgroup mqtt-sn-engine An implementation of MQTT-SN v1.2
+ * @{
+ *
+ * This application is a client for MQTT for Sensor Networks (MQTT-SN) v1.2.
+ * MQTT-SN carries the MQTT publish/subscribe model over UDP, so a node does
+ * not need to keep a TCP connection open. A gateway translates between
+ * MQTT-SN and an MQTT broker.
+ *
+ * The client runs over simple_udp and supports:
+ *
+ * - Topic IDs registered with REGISTER/REGACK, predefined topic IDs and
+ *   two-character short topic names.
+ * - Publishing with QoS -1 (without a connection), 0 and 1, and
+ *   subscribing with QoS 0 and 1.
+ * - Sleeping clients: the gateway buffers messages for the client while it
+ *   sleeps, and delivers them when the client wakes up.
+ *
+ * The API and the events have the same shape as the ones of the MQTT engine
+ * (mqtt.h), with an MQTT_SN_ prefix, so that an application can be moved
+ * from one transport to the other with few changes.
+ *
+ * The specification can be found here: http://mqtt.org
+ */
+/**
+ * \file
+ *    Header file for the Contiki MQTT-SN client
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef MQTT_SN_H_
+#define MQTT_SN_H_
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/ipv6/simple-udp.h"
+#include "sys/ctimer.h"
+
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+/* Protocol constants */
+#define MQTT_SN_PROTOCOL_ID    0x01
+#define MQTT_SN_DEFAULT_PORT   1884
+
+#define MQTT_SN_CLIENT_ID_MAX_LEN 23
+
+/* Largest message that is sent or received */
+#ifdef MQTT_SN_CONF_MAX_PACKET_SIZE
+#define MQTT_SN_MAX_PACKET_SIZE MQTT_SN_CONF_MAX_PACKET_SIZE
+#else
+#define MQTT_SN_MAX_PACKET_SIZE 128
+#endif
+
+/* Longest topic name that is kept */
+#ifdef MQTT_SN_CONF_MAX_TOPIC_LENGTH
+#define MQTT_SN_MAX_TOPIC_LENGTH MQTT_SN_CONF_MAX_TOPIC_LENGTH
+#else
+#define MQTT_SN_MAX_TOPIC_LENGTH 32
+#endif
+
+/* Number of topic ID to topic name mappings that are kept */
+#ifdef MQTT_SN_CONF_MAX_TOPICS
+#define MQTT_SN_MAX_TOPICS MQTT_SN_CONF_MAX_TOPICS
+#else
+#define MQTT_SN_MAX_TOPICS 8
+#endif
+
+/* Time to wait for a reply before retransmitting a message (Tretry) */
+#ifdef MQTT_SN_CONF_RETRY_TIMEOUT
+#define MQTT_SN_RETRY_TIMEOUT MQTT_SN_CONF_RETRY_TIMEOUT
+#else
+#define MQTT_SN_RETRY_TIMEOUT (CLOCK_SECOND * 5)
+#endif
+
+/* Number of retransmissions before the gateway is considered lost (Nretry) */
+#ifdef MQTT_SN_CONF_RETRY_COUNT
+#define MQTT_SN_RETRY_COUNT MQTT_SN_CONF_RETRY_COUNT
+#else
+#define MQTT_SN_RETRY_COUNT 3
+#endif
+/*---------------------------------------------------------------------------*/
+typedef enum {
+  MQTT_SN_EVENT_CONNECTED,
+  MQTT_SN_EVENT_DISCONNECTED,
+
+  MQTT_SN_EVENT_SUBACK,
+  MQTT_SN_EVENT_UNSUBACK,
+  MQTT_SN_EVENT_PUBLISH,
+  MQTT_SN_EVENT_PUBACK,
+
+  /* MQTT-SN only */
+  MQTT_SN_EVENT_REGACK,
+  MQTT_SN_EVENT_ASLEEP,
+  MQTT_SN_EVENT_AWAKE,
+
+  /* Errors */
+  MQTT_SN_EVENT_ERROR = 0x80,
+  MQTT_SN_EVENT_PROTOCOL_ERROR,
+  MQTT_SN_EVENT_CONNECTION_REFUSED_ERROR,
+} mqtt_sn_event_t;
+
+typedef enum {
+  MQTT_SN_STATUS_OK,
+
+  MQTT_SN_STATUS_OUT_QUEUE_FULL,
+
+  /* Errors */
+  MQTT_SN_STATUS_ERROR = 0x80,
+  MQTT_SN_STATUS_NOT_CONNECTED_ERROR,
+  MQTT_SN_STATUS_INVALID_ARGS_ERROR,
+} mqtt_sn_status_t;
+
+typedef enum {
+  MQTT_SN_QOS_LEVEL_0,
+  MQTT_SN_QOS_LEVEL_1,
+  MQTT_SN_QOS_LEVEL_2,
+  /* Publish without a connection, to a predefined topic or a short topic */
+  MQTT_SN_QOS_LEVEL_MINUS_1,
+} mqtt_sn_qos_level_t;
+
+typedef enum {
+  MQTT_SN_RETAIN_OFF,
+  MQTT_SN_RETAIN_ON,
+} mqtt_sn_retain_t;
+
+typedef enum {
+  MQTT_SN_CLEAN_SESSION_OFF,
+  MQTT_SN_CLEAN_SESSION_ON,
+} mqtt_sn_clean_session_t;
+
+typedef enum {
+  MQTT_SN_TOPIC_TYPE_NORMAL,
+  MQTT_SN_TOPIC_TYPE_PREDEFINED,
+  MQTT_SN_TOPIC_TYPE_SHORT,
+} mqtt_sn_topic_type_t;
+
+/* Return codes of CONNACK, REGACK, PUBACK and SUBACK */
+typedef enum {
+  MQTT_SN_RC_ACCEPTED,
+  MQTT_SN_RC_CONGESTION,
+  MQTT_SN_RC_INVALID_TOPIC_ID,
+  MQTT_SN_RC_NOT_SUPPORTED,
+} mqtt_sn_return_code_t;
+
+typedef enum {
+  MQTT_SN_CONN_STATE_DISCONNECTED,
+  MQTT_SN_CONN_STATE_CONNECTING,
+  MQTT_SN_CONN_STATE_CONNECTED,
+  MQTT_SN_CONN_STATE_DISCONNECTING,
+  MQTT_SN_CONN_STATE_ASLEEP,
+  MQTT_SN_CONN_STATE_AWAKE,
+} mqtt_sn_conn_state_t;
+/*---------------------------------------------------------------------------*/
+/*
+ * Event data. The message ID is the first field of all of them, as in the
+ * MQTT engine, where MQTT_EVENT_PUBACK carries a pointer to the message ID.
+ */
+struct mqtt_sn_regack_event {
+  uint16_t mid;
+  uint16_t topic_id;
+  uint8_t return_code;
+};
+
+struct mqtt_sn_puback_event {
+  uint16_t mid;
+  uint16_t topic_id;
+  uint8_t return_code;
+};
+
+struct mqtt_sn_suback_event {
+  uint16_t mid;
+  mqtt_sn_qos_level_t qos_level;
+  uint8_t return_code;
+  uint8_t success;
+  uint16_t topic_id;
+};
+
+/*
+ * This is the MQTT-SN message that is exposed to the end user. It has the
+ * fields of struct mqtt_message. A message always fits in one datagram, so
+ * it is delivered as a single chunk.
+ */
+struct mqtt_sn_message {
+  uint32_t mid;
+  char topic[MQTT_SN_MAX_TOPIC_LENGTH + 1]; /* +1 for string termination */
+  uint16_t topic_length;
+  uint16_t topic_id;
+  mqtt_sn_topic_type_t topic_type;
+
+  const uint8_t *payload_chunk;
+  uint16_t payload_chunk_length;
+
+  uint8_t first_chunk;
+  uint32_t payload_length;
+  uint32_t payload_offset;
+  uint32_t payload_left;
+};
+
+/* A mapping between a topic ID and a topic name */
+struct mqtt_sn_topic {
+  uint16_t id;
+  uint8_t type;
+  char name[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+};
+
+/* Traffic counters, for comparing the cost of transports */
+struct mqtt_sn_stats {
+  uint32_t tx_datagrams;
+  uint32_t tx_bytes;
+  uint32_t rx_datagrams;
+  uint32_t rx_bytes;
+  uint16_t retransmissions;
+};
+/*---------------------------------------------------------------------------*/
+struct mqtt_sn_connection;
+
+typedef void (*mqtt_sn_event_callback_t)(struct mqtt_sn_connection *m,
+                                         mqtt_sn_event_t event,
+                                         void *data);
+/*---------------------------------------------------------------------------*/
+struct mqtt_sn_connection {
+  /* Must be first: the UDP callback gets a pointer to it */
+  struct simple_udp_connection udp;
+
+  struct process *app_process;
+  mqtt_sn_event_callback_t event_callback;
+  char client_id[MQTT_SN_CLIENT_ID_MAX_LEN + 1];
+
+  uip_ipaddr_t gw_addr;
+  uint16_t gw_port;
+  uint8_t has_gw;
+
+  mqtt_sn_conn_state_t state;
+  uint16_t keep_alive;
+  uint16_t sleep_duration;
+  uint16_t mid_counter;
+
+  /* The request that waits for a reply, which is retransmitted */
+  uint8_t out_buffer[MQTT_SN_MAX_PACKET_SIZE];
+  uint16_t out_length;
+  uint8_t out_reply_type;
+  uint16_t out_mid;
+  uint8_t out_retries;
+  uint8_t out_queue_full;
+  struct ctimer retry_timer;
+
+  struct ctimer keep_alive_timer;
+  uint8_t waiting_for_pingresp;
+
+  /* Pending topic name of a REGISTER or SUBSCRIBE request */
+  char pending_topic[MQTT_SN_MAX_TOPIC_LENGTH + 1];
+
+  struct mqtt_sn_topic topics[MQTT_SN_MAX_TOPICS];
+  struct mqtt_sn_message in_publish_msg;
+  struct mqtt_sn_stats stats;
+};
+/*---------------------------------------------------------------------------*/
+#define mqtt_sn_connected(conn) \
+  ((conn)->state == MQTT_SN_CONN_STATE_CONNECTED ? 1 : 0)
+
+#define mqtt_sn_ready(conn) \
+  (!(conn)->out_queue_full && mqtt_sn_connected((conn)))
+/*---------------------------------------------------------------------------*/
+/* This is the API exposed to the user. */
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Initializes an MQTT-SN connection.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param app_process A pointer to the application process handling the
+ *        connection.
+ * \param client_id A pointer to the client ID.
+ * \param event_callback Callback function responsible for handling the
+ *        events of the connection.
+ * \param local_port The local UDP port, or 0 for any port.
+ * \return MQTT_SN_STATUS_OK or MQTT_SN_STATUS_INVALID_ARGS_ERROR
+ *
+ * This function shall be called before any other MQTT-SN function.
+ */
+mqtt_sn_status_t mqtt_sn_register(struct mqtt_sn_connection *conn,
+                                  struct process *app_process,
+                                  const char *client_id,
+                                  mqtt_sn_event_callback_t event_callback,
+                                  uint16_t local_port);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Sets the gateway of a connection.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param host IP address of the gateway.
+ * \param port UDP port of the gateway, usually MQTT_SN_DEFAULT_PORT.
+ * \return MQTT_SN_STATUS_OK or MQTT_SN_STATUS_INVALID_ARGS_ERROR
+ *
+ * This is only needed for publishing with QoS -1 without connecting.
+ * mqtt_sn_connect() sets the gateway as well.
+ */
+mqtt_sn_status_t mqtt_sn_set_gateway(struct mqtt_sn_connection *conn,
+                                     const char *host, uint16_t port);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Connects to an MQTT-SN gateway.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param host IP address of the gateway.
+ * \param port UDP port of the gateway, usually MQTT_SN_DEFAULT_PORT.
+ * \param keep_alive Keep alive time in seconds.
+ * \param clean_session Request a new session.
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * MQTT_SN_EVENT_CONNECTED is reported when the gateway has accepted the
+ * connection. Calling this function while asleep makes the client active
+ * again.
+ */
+mqtt_sn_status_t mqtt_sn_connect(struct mqtt_sn_connection *conn,
+                                 const char *host,
+                                 uint16_t port,
+                                 uint16_t keep_alive,
+                                 uint8_t clean_session);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Disconnects from an MQTT-SN gateway.
+ * \param conn A pointer to the MQTT-SN connection.
+ */
+void mqtt_sn_disconnect(struct mqtt_sn_connection *conn);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Registers a topic name with the gateway.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param mid A pointer to store the message ID, or NULL.
+ * \param topic The topic name.
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * MQTT_SN_EVENT_REGACK is reported with the topic ID given by the gateway.
+ * The ID can be looked up with mqtt_sn_topic_id() afterwards.
+ */
+mqtt_sn_status_t mqtt_sn_register_topic(struct mqtt_sn_connection *conn,
+                                        uint16_t *mid,
+                                        const char *topic);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Adds a predefined topic ID.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param topic_id The predefined topic ID.
+ * \param topic The topic name that the ID stands for.
+ * \return MQTT_SN_STATUS_OK or MQTT_SN_STATUS_OUT_QUEUE_FULL
+ *
+ * Predefined topic IDs are configured in the gateway. Adding one to the
+ * connection only gives incoming messages on it a topic name.
+ */
+mqtt_sn_status_t mqtt_sn_add_predefined_topic(struct mqtt_sn_connection *conn,
+                                              uint16_t topic_id,
+                                              const char *topic);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Looks up the ID of a registered or predefined topic.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param topic The topic name.
+ * \return The topic ID, or 0 if the topic is not known.
+ */
+uint16_t mqtt_sn_topic_id(struct mqtt_sn_connection *conn, const char *topic);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Subscribes to a topic name.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param mid A pointer to store the message ID, or NULL.
+ * \param topic The topic name, which may contain wildcards. A name of two
+ *        characters is sent as a short topic name.
+ * \param qos_level QoS level, 0 or 1.
+ * \return MQTT_SN_STATUS_OK or an error status
+ */
+mqtt_sn_status_t mqtt_sn_subscribe(struct mqtt_sn_connection *conn,
+                                   uint16_t *mid,
+                                   const char *topic,
+                                   mqtt_sn_qos_level_t qos_level);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Subscribes to a predefined topic ID.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param mid A pointer to store the message ID, or NULL.
+ * \param topic_id The predefined topic ID.
+ * \param qos_level QoS level, 0 or 1.
+ * \return MQTT_SN_STATUS_OK or an error status
+ */
+mqtt_sn_status_t mqtt_sn_subscribe_id(struct mqtt_sn_connection *conn,
+                                      uint16_t *mid,
+                                      uint16_t topic_id,
+                                      mqtt_sn_qos_level_t qos_level);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Unsubscribes from a topic name.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param mid A pointer to store the message ID, or NULL.
+ * \param topic The topic name.
+ * \return MQTT_SN_STATUS_OK or an error status
+ */
+mqtt_sn_status_t mqtt_sn_unsubscribe(struct mqtt_sn_connection *conn,
+                                     uint16_t *mid,
+                                     const char *topic);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Publishes a message.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param mid A pointer to store the message ID, or NULL.
+ * \param topic_id The topic ID. For a short topic name, the two characters
+ *        of the name, as returned by MQTT_SN_SHORT_TOPIC_ID().
+ * \param topic_type The type of the topic ID.
+ * \param payload A pointer to the payload.
+ * \param payload_size The size of the payload.
+ * \param qos_level QoS level: -1, 0 or 1.
+ * \param retain Whether the gateway shall retain the message.
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * A QoS 1 message is retransmitted until MQTT_SN_EVENT_PUBACK is reported
+ * for it. With QoS -1, the message is sent once, also when the client is
+ * not connected. QoS -1 requires a predefined topic ID or a short topic
+ * name.
+ */
+mqtt_sn_status_t mqtt_sn_publish(struct mqtt_sn_connection *conn,
+                                 uint16_t *mid,
+                                 uint16_t topic_id,
+                                 mqtt_sn_topic_type_t topic_type,
+                                 const uint8_t *payload,
+                                 uint16_t payload_size,
+                                 mqtt_sn_qos_level_t qos_level,
+                                 mqtt_sn_retain_t retain);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Goes to sleep.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \param duration The sleep duration in seconds.
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * The gateway buffers the messages to the client while it sleeps.
+ * MQTT_SN_EVENT_ASLEEP is reported when the gateway has accepted. The
+ * client shall call mqtt_sn_wake() or mqtt_sn_connect() before the
+ * duration has passed, or the gateway considers the client lost.
+ */
+mqtt_sn_status_t mqtt_sn_sleep(struct mqtt_sn_connection *conn,
+                               uint16_t duration);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Wakes up to get the messages buffered by the gateway.
+ * \param conn A pointer to the MQTT-SN connection.
+ * \return MQTT_SN_STATUS_OK or an error status
+ *
+ * MQTT_SN_EVENT_AWAKE is reported first. The buffered messages are then
+ * reported with MQTT_SN_EVENT_PUBLISH, and MQTT_SN_EVENT_ASLEEP is reported
+ * when the gateway has sent all of them and the client is asleep again.
+ */
+mqtt_sn_status_t mqtt_sn_wake(struct mqtt_sn_connection *conn);
+/*---------------------------------------------------------------------------*/
+/* The topic ID of a short topic name of two characters */
+#define MQTT_SN_SHORT_TOPIC_ID(name) \
+  ((uint16_t)(((uint8_t)(name)[0] << 8) | (uint8_t)(name)[1]))
+/*---------------------------------------------------------------------------*/
+#endif /* MQTT_SN_H_ */
+/*---------------------------------------------------------------------------*/
+/**
+ * @}
+ * @}
+ */
@@ -59,6 +59,10 @@
 #include "lib/list.h"
 #include "sys/cc.h"
 
+#if MQTT_PERSIST
+#include "cfs/cfs.h"
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -209,6 +213,7 @@ static process_event_t mqtt_do_disconnect_mqtt_event;
 static process_event_t mqtt_do_subscribe_event;
 static process_event_t mqtt_do_unsubscribe_event;
 static process_event_t mqtt_do_publish_event;
+static process_event_t mqtt_do_flush_event;
 static process_event_t mqtt_do_pingreq_event;
 static process_event_t mqtt_continue_send_event;
 static process_event_t mqtt_abort_now_event;
@@ -233,6 +238,20 @@ static void tcp_event(struct tcp_socket *s, void *ptr,
 
 static void reset_packet(struct mqtt_in_packet *packet);
 /*---------------------------------------------------------------------------*/
+#if MQTT_PERSIST
+/* Records of the persistent log */
+typedef enum {
+  MQTT_PERSIST_ADD = 1,
+  MQTT_PERSIST_RELEASE,
+  MQTT_PERSIST_DONE,
+} mqtt_persist_op_t;
+
+#define MQTT_PERSIST_HDR_SIZE 6
+
+static void persist_log(struct mqtt_connection *conn, mqtt_persist_op_t op,
+                        struct mqtt_out_msg *msg);
+#endif
+/*---------------------------------------------------------------------------*/
 LIST(mqtt_conn_list);
 /*---------------------------------------------------------------------------*/
 PROCESS(mqtt_process, "MQTT process");
@@ -246,10 +265,336 @@ call_event(struct mqtt_connection *conn,
   process_post(conn->app_process, mqtt_update_event, NULL);
 }
 /*---------------------------------------------------------------------------*/
+#define QUEUE_SLOT(q, n)   (((q)->head + (n)) % MQTT_OUT_QUEUE_LENGTH)
+#define QUEUE_CURSOR(conn) \
+  (&(conn)->out_queue.msg[QUEUE_SLOT(&(conn)->out_queue, (conn)->out_queue.cursor)])
+/*---------------------------------------------------------------------------*/
+/*
+ * Reserves a slot and length contiguous bytes in the outgoing queue. A
+ * message is never split at the end of the ring buffer; if it does not fit
+ * there, it is placed at the start of the buffer.
+ */
+static struct mqtt_out_msg *
+queue_alloc(struct mqtt_out_queue *q, uint16_t length)
+{
+  struct mqtt_out_msg *msg;
+  uint16_t read_pos;
+  uint16_t offset;
+
+  if(q->count == MQTT_OUT_QUEUE_LENGTH || length > MQTT_OUT_QUEUE_SIZE) {
+    return NULL;
+  }
+
+  if(q->count == 0) {
+    offset = 0;
+  } else {
+    read_pos = q->msg[q->head].offset;
+    if(q->write_pos > read_pos) {
+      if(MQTT_OUT_QUEUE_SIZE - q->write_pos >= length) {
+        offset = q->write_pos;
+      } else if(read_pos >= length) {
+        offset = 0;
+      } else {
+        return NULL;
+      }
+    } else if(read_pos - q->write_pos >= length) {
+      offset = q->write_pos;
+    } else {
+      return NULL;
+    }
+  }
+
+  msg = &q->msg[QUEUE_SLOT(q, q->count)];
+  msg->offset = offset;
+  msg->length = length;
+  msg->state = MQTT_OUT_MSG_QUEUED;
+  q->write_pos = offset + length;
+  q->count++;
+
+  return msg;
+}
+/*---------------------------------------------------------------------------*/
+static struct mqtt_out_msg *
+queue_find(struct mqtt_out_queue *q, uint16_t mid, uint8_t state)
+{
+  uint8_t i;
+  uint8_t n;
+
+  for(n = 0; n < q->count; n++) {
+    i = QUEUE_SLOT(q, n);
+    if(q->msg[i].mid == mid && q->msg[i].state == state) {
+      return &q->msg[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Number of QoS 1/2 messages that have been sent but not completed */
+static uint8_t
+queue_inflight(struct mqtt_out_queue *q)
+{
+  uint8_t i;
+  uint8_t n;
+  uint8_t inflight = 0;
+
+  for(n = 0; n < q->count; n++) {
+    i = QUEUE_SLOT(q, n);
+    if(q->msg[i].state >= MQTT_OUT_MSG_SENT) {
+      inflight++;
+    }
+  }
+  return inflight;
+}
+/*---------------------------------------------------------------------------*/
+/* Releases completed messages from the front of the queue */
+static void
+queue_release(struct mqtt_out_queue *q)
+{
+  while(q->count > 0 && q->msg[q->head].state == MQTT_OUT_MSG_DONE) {
+    q->head = (q->head + 1) % MQTT_OUT_QUEUE_LENGTH;
+    q->count--;
+    /* The cursor of the flush process is relative to the head */
+    if(q->cursor > 0) {
+      q->cursor--;
+    }
+  }
+  if(q->count == 0) {
+    q->write_pos = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if the flush process has something to send */
+static int
+queue_sendable(struct mqtt_out_queue *q)
+{
+  uint8_t i;
+  uint8_t n;
+
+  for(n = 0; n < q->count; n++) {
+    i = QUEUE_SLOT(q, n);
+    if(q->msg[i].state == MQTT_OUT_MSG_PUBREL) {
+      return 1;
+    }
+    if(q->msg[i].state == MQTT_OUT_MSG_QUEUED) {
+      return q->msg[i].qos == MQTT_QOS_LEVEL_0 ||
+             queue_inflight(q) < MQTT_MAX_INFLIGHT;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Called when the connection is lost. Messages that have not been
+ * acknowledged are sent again, with the DUP flag set, after the next
+ * CONNACK. PUBREL is sent again for QoS 2 messages that got a PUBREC.
+ */
+static void
+queue_requeue(struct mqtt_out_queue *q)
+{
+  uint8_t i;
+  uint8_t n;
+
+  for(n = 0; n < q->count; n++) {
+    i = QUEUE_SLOT(q, n);
+    if(q->msg[i].state == MQTT_OUT_MSG_SENT) {
+      q->msg[i].state = MQTT_OUT_MSG_QUEUED;
+      q->buffer[q->msg[i].offset] |= MQTT_FHDR_DUP_FLAG;
+    } else if(q->msg[i].state == MQTT_OUT_MSG_PUBREL_SENT) {
+      q->msg[i].state = MQTT_OUT_MSG_PUBREL;
+    }
+  }
+  q->flush_pending = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule_flush(struct mqtt_connection *conn)
+{
+  if(conn->out_queue.flush_pending || !queue_sendable(&conn->out_queue)) {
+    return;
+  }
+  if(process_post(&mqtt_process, mqtt_do_flush_event, conn) ==
+     PROCESS_ERR_OK) {
+    conn->out_queue.flush_pending = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Marks a QoS 1/2 message as acknowledged and notifies the application */
+static void
+complete_msg(struct mqtt_connection *conn, struct mqtt_out_msg *msg)
+{
+  uint16_t mid = msg->mid;
+
+  msg->state = MQTT_OUT_MSG_DONE;
+  queue_release(&conn->out_queue);
+#if MQTT_PERSIST
+  persist_log(conn, MQTT_PERSIST_DONE, msg);
+#endif
+  schedule_flush(conn);
+
+  call_event(conn, MQTT_EVENT_PUBACK, &mid);
+}
+/*---------------------------------------------------------------------------*/
+#if MQTT_PERSIST
+/*
+ * The persistent log is a sequence of records. Each record starts with a
+ * header holding the operation, the QoS level, the message ID and, for
+ * MQTT_PERSIST_ADD, the length of the encoded PUBLISH message that follows.
+ */
+static void
+persist_name(struct mqtt_connection *conn, char *name)
+{
+  snprintf(name, MQTT_PERSIST_NAME_LEN, "mqtt-%s",
+           conn->client_id.string != NULL ? conn->client_id.string : "");
+}
+/*---------------------------------------------------------------------------*/
+static void
+persist_write(struct mqtt_connection *conn, mqtt_persist_op_t op,
+              struct mqtt_out_msg *msg)
+{
+  char name[MQTT_PERSIST_NAME_LEN];
+  uint8_t hdr[MQTT_PERSIST_HDR_SIZE];
+  uint16_t length;
+  int fd;
+
+  length = op == MQTT_PERSIST_ADD ? msg->length : 0;
+  hdr[0] = op;
+  hdr[1] = msg->qos;
+  hdr[2] = msg->mid >> 8;
+  hdr[3] = msg->mid & 0x00FF;
+  hdr[4] = length >> 8;
+  hdr[5] = length & 0x00FF;
+
+  persist_name(conn, name);
+  fd = cfs_open(name, CFS_WRITE | CFS_APPEND);
+  if(fd < 0) {
+    PRINTF("MQTT - Failed to open the persistent log\n");
+    return;
+  }
+  if(cfs_write(fd, hdr, sizeof(hdr)) != sizeof(hdr) ||
+     cfs_write(fd, &conn->out_queue.buffer[msg->offset], length) != length) {
+    PRINTF("MQTT - Failed to write the persistent log\n");
+  }
+  cfs_close(fd);
+
+  conn->out_queue.log_size += sizeof(hdr) + length;
+}
+/*---------------------------------------------------------------------------*/
+/* Rewrites the log with only the pending QoS 1/2 messages */
+static void
+persist_compact(struct mqtt_connection *conn)
+{
+  struct mqtt_out_queue *q = &conn->out_queue;
+  char name[MQTT_PERSIST_NAME_LEN];
+  uint8_t i;
+  uint8_t n;
+
+  persist_name(conn, name);
+  cfs_remove(name);
+  q->log_size = 0;
+
+  for(n = 0; n < q->count; n++) {
+    i = QUEUE_SLOT(q, n);
+    if(q->msg[i].qos == MQTT_QOS_LEVEL_0 ||
+       q->msg[i].state == MQTT_OUT_MSG_DONE) {
+      continue;
+    }
+    persist_write(conn, MQTT_PERSIST_ADD, &q->msg[i]);
+    if(q->msg[i].state >= MQTT_OUT_MSG_PUBREL) {
+      persist_write(conn, MQTT_PERSIST_RELEASE, &q->msg[i]);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+persist_log(struct mqtt_connection *conn, mqtt_persist_op_t op,
+            struct mqtt_out_msg *msg)
+{
+  if(msg->qos == MQTT_QOS_LEVEL_0) {
+    return;
+  }
+
+  persist_write(conn, op, msg);
+
+  if(op == MQTT_PERSIST_DONE && conn->out_queue.count == 0) {
+    /* Nothing is pending: start over with an empty log */
+    persist_compact(conn);
+  } else if(conn->out_queue.log_size > MQTT_PERSIST_MAX_LOG) {
+    persist_compact(conn);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Reloads the messages that were pending when the log was last written.
+ * They are all sent with the DUP flag set, since we cannot know whether
+ * they reached the broker.
+ */
+static void
+persist_restore(struct mqtt_connection *conn)
+{
+  struct mqtt_out_queue *q = &conn->out_queue;
+  struct mqtt_out_msg *msg;
+  char name[MQTT_PERSIST_NAME_LEN];
+  uint8_t hdr[MQTT_PERSIST_HDR_SIZE];
+  uint16_t mid;
+  uint16_t length;
+  int fd;
+
+  persist_name(conn, name);
+  fd = cfs_open(name, CFS_READ);
+  if(fd < 0) {
+    return;
+  }
+
+  while(cfs_read(fd, hdr, sizeof(hdr)) == sizeof(hdr)) {
+    mid = (hdr[2] << 8) | hdr[3];
+    length = (hdr[4] << 8) | hdr[5];
+
+    if(hdr[0] == MQTT_PERSIST_ADD) {
+      msg = queue_alloc(q, length);
+      if(msg == NULL) {
+        PRINTF("MQTT - No room to restore message %u\n", mid);
+        cfs_seek(fd, length, CFS_SEEK_CUR);
+        continue;
+      }
+      if(cfs_read(fd, &q->buffer[msg->offset], length) != length) {
+        /* Truncated record */
+        msg->state = MQTT_OUT_MSG_DONE;
+        break;
+      }
+      q->buffer[msg->offset] |= MQTT_FHDR_DUP_FLAG;
+      msg->mid = mid;
+      msg->qos = hdr[1];
+      conn->mid_counter = mid;
+    } else if(hdr[0] == MQTT_PERSIST_RELEASE) {
+      msg = queue_find(q, mid, MQTT_OUT_MSG_QUEUED);
+      if(msg != NULL) {
+        msg->state = MQTT_OUT_MSG_PUBREL;
+      }
+    } else if(hdr[0] == MQTT_PERSIST_DONE) {
+      msg = queue_find(q, mid, MQTT_OUT_MSG_QUEUED);
+      if(msg == NULL) {
+        msg = queue_find(q, mid, MQTT_OUT_MSG_PUBREL);
+      }
+      if(msg != NULL) {
+        msg->state = MQTT_OUT_MSG_DONE;
+        queue_release(q);
+      }
+    } else {
+      break;
+    }
+  }
+  cfs_close(fd);
+
+  queue_release(q);
+  persist_compact(conn);
+
+  DBG("MQTT - Restored %u pending messages\n", q->count);
+}
+#endif /* MQTT_PERSIST */
+/*---------------------------------------------------------------------------*/
 static void
 reset_defaults(struct mqtt_connection *conn)
 {
-  conn->mid_counter = 1;
   PT_INIT(&conn->out_proto_thread);
   conn->waiting_for_pingresp = 0;
 
@@ -265,6 +610,7 @@ abort_connection(struct mqtt_connection *conn)
 
   /* Reset outgoing packet */
   memset(&conn->out_packet, 0, sizeof(conn->out_packet));
+  queue_requeue(&conn->out_queue);
 
   tcp_socket_close(&conn->socket);
   tcp_socket_unregister(&conn->socket);
@@ -378,11 +724,11 @@ mqtt_decode_var_byte_int(const uint8_t *input_data_ptr,
                          int input_data_len,
                          uint32_t *input_pos,
                          uint32_t *pkt_byte_count,
-                         uint16_t *dest)
+                         uint32_t *dest)
 {
   uint8_t read_bytes = 0;
   uint8_t byte_in;
-  uint8_t multiplier = 1;
+  uint32_t multiplier = 1;
   uint32_t input_pos_0 = 0;
 
   if(input_pos == NULL) {
@@ -617,7 +963,6 @@ PT_THREAD(connect_pt(struct pt *pt, struct mqtt_connection *conn))
   timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
   /* Wait for CONNACK */
-  reset_packet(&conn->in_packet);
   PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
                 timer_expired(&conn->t));
   if(timer_expired(&conn->t)) {
@@ -629,7 +974,6 @@ PT_THREAD(connect_pt(struct pt *pt, struct mqtt_connection *conn))
     mqtt_disconnect(conn);
 #endif
   }
-  reset_packet(&conn->in_packet);
 
   DBG("MQTT - Done sending CONNECT\n");
 
@@ -735,14 +1079,12 @@ PT_THREAD(subscribe_pt(struct pt *pt, struct mqtt_connection *conn))
   timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
   /* Wait for SUBACK. */
-  reset_packet(&conn->in_packet);
   PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
                 timer_expired(&conn->t));
 
   if(timer_expired(&conn->t)) {
     DBG("Timeout waiting for SUBACK\n");
   }
-  reset_packet(&conn->in_packet);
 
   /* This is clear after the entire transaction is complete */
   conn->out_queue_full = 0;
@@ -809,7 +1151,6 @@ PT_THREAD(unsubscribe_pt(struct pt *pt, struct mqtt_connection *conn))
   timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
   /* Wait for UNSUBACK */
-  reset_packet(&conn->in_packet);
   PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
                 timer_expired(&conn->t));
 
@@ -817,8 +1158,6 @@ PT_THREAD(unsubscribe_pt(struct pt *pt, struct mqtt_connection *conn))
     DBG("Timeout waiting for UNSUBACK\n");
   }
 
-  reset_packet(&conn->in_packet);
-
   /* This is clear after the entire transaction is complete */
   conn->out_queue_full = 0;
 
@@ -908,7 +1247,6 @@ PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn))
     process_post(conn->app_process, mqtt_update_event, NULL);
   } else if(conn->out_packet.qos == 1) {
     /* Wait for PUBACK */
-    reset_packet(&conn->in_packet);
     PT_WAIT_UNTIL(pt, conn->out_packet.qos_state == MQTT_QOS_STATE_GOT_ACK ||
                   timer_expired(&conn->t));
     if(timer_expired(&conn->t)) {
@@ -923,8 +1261,6 @@ PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn))
     /* Should wait for PUBREC, send PUBREL and then wait for PUBCOMP */
   }
 
-  reset_packet(&conn->in_packet);
-
   /* This is clear after the entire transaction is complete */
   conn->out_queue_full = 0;
 
@@ -933,6 +1269,56 @@ PT_THREAD(publish_pt(struct pt *pt, struct mqtt_connection *conn))
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Writes as many queued messages as the in-flight window allows into the
+ * output buffer and sends them together. Messages are sent in the order they
+ * were published.
+ */
+static
+PT_THREAD(flush_pt(struct pt *pt, struct mqtt_connection *conn))
+{
+  PT_BEGIN(pt);
+
+  conn->out_queue.cursor = 0;
+  while(conn->out_queue.cursor < conn->out_queue.count) {
+    if(QUEUE_CURSOR(conn)->state == MQTT_OUT_MSG_PUBREL) {
+      conn->out_queue.pubrel[0] = MQTT_FHDR_MSG_TYPE_PUBREL |
+        MQTT_FHDR_QOS_LEVEL_1;
+      conn->out_queue.pubrel[1] = MQTT_MID_SIZE;
+      conn->out_queue.pubrel[2] = QUEUE_CURSOR(conn)->mid >> 8;
+      conn->out_queue.pubrel[3] = QUEUE_CURSOR(conn)->mid & 0x00FF;
+      PT_MQTT_WRITE_BYTES(conn, conn->out_queue.pubrel,
+                          sizeof(conn->out_queue.pubrel));
+      QUEUE_CURSOR(conn)->state = MQTT_OUT_MSG_PUBREL_SENT;
+    } else if(QUEUE_CURSOR(conn)->state == MQTT_OUT_MSG_QUEUED) {
+      if(QUEUE_CURSOR(conn)->qos > MQTT_QOS_LEVEL_0 &&
+         queue_inflight(&conn->out_queue) >= MQTT_MAX_INFLIGHT) {
+        /* The window is full, keep the remaining messages in order */
+        break;
+      }
+      DBG("MQTT - Sending queued message %u (%u bytes)\n",
+          QUEUE_CURSOR(conn)->mid, QUEUE_CURSOR(conn)->length);
+      PT_MQTT_WRITE_BYTES(conn,
+                          &conn->out_queue.buffer[QUEUE_CURSOR(conn)->offset],
+                          QUEUE_CURSOR(conn)->length);
+      if(QUEUE_CURSOR(conn)->qos == MQTT_QOS_LEVEL_0) {
+        QUEUE_CURSOR(conn)->state = MQTT_OUT_MSG_DONE;
+      } else {
+        QUEUE_CURSOR(conn)->state = MQTT_OUT_MSG_SENT;
+      }
+    }
+    conn->out_queue.cursor++;
+  }
+
+  send_out_buffer(conn);
+
+  /* Let the application know that there is room in the queue */
+  queue_release(&conn->out_queue);
+  process_post(conn->app_process, mqtt_update_event, NULL);
+
+  PT_END(pt);
+}
+/*---------------------------------------------------------------------------*/
 static
 PT_THREAD(pingreq_pt(struct pt *pt, struct mqtt_connection *conn))
 {
@@ -950,12 +1336,9 @@ PT_THREAD(pingreq_pt(struct pt *pt, struct mqtt_connection *conn))
   conn->waiting_for_pingresp = 1;
 
   /* Wait for PINGRESP or timeout */
-  reset_packet(&conn->in_packet);
   timer_set(&conn->t, RESPONSE_WAIT_TIMEOUT);
 
-  PT_WAIT_UNTIL(pt, conn->in_packet.packet_received || timer_expired(&conn->t));
-
-  reset_packet(&conn->in_packet);
+  PT_WAIT_UNTIL(pt, !conn->waiting_for_pingresp || timer_expired(&conn->t));
 
   conn->waiting_for_pingresp = 0;
 
@@ -1061,12 +1444,16 @@ handle_connack(struct mqtt_connection *conn)
   /* Always reset packet before callback since it might be used directly */
   conn->state = MQTT_CONN_STATE_CONNECTED_TO_BROKER;
   call_event(conn, MQTT_EVENT_CONNECTED, &connack_event);
+
+  /* Send messages queued before the connection was (re-)established */
+  schedule_flush(conn);
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_pingresp(struct mqtt_connection *conn)
 {
   DBG("MQTT - Got PINGRESP\n");
+  conn->waiting_for_pingresp = 0;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -1144,22 +1531,70 @@ handle_unsuback(struct mqtt_connection *conn)
 static void
 handle_puback(struct mqtt_connection *conn)
 {
+  struct mqtt_out_msg *msg;
+
   DBG("MQTT - Got PUBACK\n");
 
+  msg = queue_find(&conn->out_queue, conn->in_packet.mid, MQTT_OUT_MSG_SENT);
+  if(msg != NULL && msg->qos == MQTT_QOS_LEVEL_1) {
+    complete_msg(conn, msg);
+    return;
+  }
+
   conn->out_packet.qos_state = MQTT_QOS_STATE_GOT_ACK;
 
   call_event(conn, MQTT_EVENT_PUBACK, &conn->in_packet.mid);
 }
 /*---------------------------------------------------------------------------*/
+static void
+handle_pubrec(struct mqtt_connection *conn)
+{
+  struct mqtt_out_msg *msg;
+
+  DBG("MQTT - Got PUBREC\n");
+
+  msg = queue_find(&conn->out_queue, conn->in_packet.mid, MQTT_OUT_MSG_SENT);
+  if(msg == NULL || msg->qos != MQTT_QOS_LEVEL_2) {
+    PRINTF("MQTT - Got PUBREC for unknown message %u\n", conn->in_packet.mid);
+    return;
+  }
+
+  msg->state = MQTT_OUT_MSG_PUBREL;
+#if MQTT_PERSIST
+  persist_log(conn, MQTT_PERSIST_RELEASE, msg);
+#endif
+  schedule_flush(conn);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_pubcomp(struct mqtt_connection *conn)
+{
+  struct mqtt_out_msg *msg;
+
+  DBG("MQTT - Got PUBCOMP\n");
+
+  msg = queue_find(&conn->out_queue, conn->in_packet.mid,
+                   MQTT_OUT_MSG_PUBREL_SENT);
+  if(msg == NULL) {
+    PRINTF("MQTT - Got PUBCOMP for unknown message %u\n", conn->in_packet.mid);
+    return;
+  }
+
+  complete_msg(conn, msg);
+}
+/*---------------------------------------------------------------------------*/
 static mqtt_pub_status_t
 handle_publish(struct mqtt_connection *conn)
 {
-  DBG("MQTT - Got PUBLISH, called once per manageable chunk of message.\n");
+  DBG("MQTT - Got PUBLISH, called once per chunk of the payload.\n");
   DBG("MQTT - Handling publish on topic '%s'\n", conn->in_publish_msg.topic);
 
 #if MQTT_PROTOCOL_VERSION >= MQTT_PROTOCOL_VERSION_3_1_1
-  if(strlen(conn->in_publish_msg.topic) < conn->in_packet.topic_len) {
+  if(conn->in_publish_msg.first_chunk &&
+     strlen(conn->in_publish_msg.topic) <
+     MIN(conn->in_packet.topic_len, MQTT_MAX_TOPIC_LENGTH)) {
     DBG("NULL detected in received PUBLISH topic\n");
+    conn->in_packet.discard = 1;
 #if MQTT_5
     mqtt_disconnect(conn, MQTT_PROP_LIST_NONE);
 #else
@@ -1171,22 +1606,17 @@ handle_publish(struct mqtt_connection *conn)
 
   DBG("MQTT - This chunk is %i bytes\n", conn->in_publish_msg.payload_chunk_length);
 
-  if(((conn->in_packet.fhdr & 0x09) >> 1) > 0) {
+  if(conn->in_publish_msg.first_chunk &&
+     (conn->in_packet.fhdr & (MQTT_FHDR_QOS_LEVEL_1 | MQTT_FHDR_QOS_LEVEL_2))) {
     PRINTF("MQTT - Error, got incoming PUBLISH with QoS > 0, not supported atm!\n");
   }
 
   call_event(conn, MQTT_EVENT_PUBLISH, &conn->in_publish_msg);
 
-  if(conn->in_publish_msg.first_chunk == 1) {
-    conn->in_publish_msg.first_chunk = 0;
-  }
+  conn->in_publish_msg.first_chunk = 0;
 
   /* If this is the last time handle_publish will be called, reset packet. */
   if(conn->in_publish_msg.payload_left == 0) {
-
-    /* Check for QoS and initiate the reply, do not rely on the data in the
-     * in_packet being untouched. */
-
     DBG("MQTT - (handle_publish) resetting packet.\n");
     reset_packet(&conn->in_packet);
   }
@@ -1194,60 +1624,197 @@ handle_publish(struct mqtt_connection *conn)
   return MQTT_PUBLISH_OK;
 }
 /*---------------------------------------------------------------------------*/
-static void
+/*
+ * Reads the topic of an incoming PUBLISH message. Topics longer than
+ * MQTT_MAX_TOPIC_LENGTH are truncated. Returns 0 if the input ends before the
+ * topic does.
+ */
+static int
+parse_publish_topic(struct mqtt_connection *conn,
+                    uint32_t *pos,
+                    const uint8_t *input_data_ptr,
+                    int input_data_len)
+{
+  struct mqtt_in_packet *packet = &conn->in_packet;
+  uint32_t copy_bytes;
+  uint32_t keep_bytes;
+
+  /* Read out topic length, which may be split between two inputs */
+  while(packet->topic_len_received < 2) {
+    if(*pos >= input_data_len) {
+      return 0;
+    }
+    packet->topic_len = (packet->topic_len << 8) | input_data_ptr[(*pos)++];
+    packet->byte_counter++;
+    packet->topic_len_received++;
+  }
+
+  /* Read out topic, keeping as much of it as fits */
+  copy_bytes = MIN(packet->topic_len - packet->topic_pos,
+                   input_data_len - *pos);
+  if(packet->topic_pos < MQTT_MAX_TOPIC_LENGTH) {
+    keep_bytes = MIN(copy_bytes, MQTT_MAX_TOPIC_LENGTH - packet->topic_pos);
+    memcpy(&conn->in_publish_msg.topic[packet->topic_pos],
+           &input_data_ptr[*pos], keep_bytes);
+  }
+  DBG("MQTT - topic_pos: %i copy_bytes: %i\n", packet->topic_pos, copy_bytes);
+  (*pos) += copy_bytes;
+  packet->byte_counter += copy_bytes;
+  packet->topic_pos += copy_bytes;
+
+  if(packet->topic_pos < packet->topic_len) {
+    return 0;
+  }
+
+  conn->in_publish_msg.topic[MIN(packet->topic_len,
+                                 MQTT_MAX_TOPIC_LENGTH)] = '\0';
+  conn->in_publish_msg.topic_length = packet->topic_len;
+  packet->topic_received = 1;
+  DBG("MQTT - Got topic '%s'\n", conn->in_publish_msg.topic);
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Reads the variable header of an incoming PUBLISH message that follows the
+ * topic: the Packet Identifier for QoS > 0 and, in MQTTv5, the properties.
+ * Returns 1 when the header is complete, 0 if the input ends before it does
+ * and -1 if the header is malformed or does not fit in the input buffer.
+ */
+static int
 parse_publish_vhdr(struct mqtt_connection *conn,
                    uint32_t *pos,
                    const uint8_t *input_data_ptr,
                    int input_data_len)
 {
-  uint16_t copy_bytes;
+  struct mqtt_in_packet *packet = &conn->in_packet;
+  struct mqtt_message *msg = &conn->in_publish_msg;
+  uint32_t copy_bytes;
+  uint32_t topic_bytes = 2 + packet->topic_len;
+  uint8_t mid_len = 0;
 
-  /* Read out topic length */
-  if(conn->in_packet.topic_len_received == 0) {
-    conn->in_packet.topic_pos = 0;
-    conn->in_packet.topic_len = (input_data_ptr[(*pos)++] << 8);
-    conn->in_packet.byte_counter++;
-    if(*pos >= input_data_len) {
-      return;
+  if(packet->fhdr & (MQTT_FHDR_QOS_LEVEL_1 | MQTT_FHDR_QOS_LEVEL_2)) {
+    mid_len = 2;
+  }
+
+#if MQTT_5
+  /* The length of the properties is needed to know the header length */
+  while(packet->vhdr_len == 0) {
+    uint32_t props_pos = mid_len;
+    uint32_t props_len = 0;
+    uint8_t props_len_bytes;
+
+    if(packet->payload_pos > mid_len) {
+      props_len_bytes = mqtt_decode_var_byte_int(packet->payload,
+                                                 packet->payload_pos,
+                                                 &props_pos, NULL,
+                                                 &props_len);
+      if(props_len_bytes > 0) {
+        packet->vhdr_len = mid_len + props_len_bytes + props_len;
+        break;
+      }
+      if(packet->payload_pos >= mid_len + MQTT_MAX_REMAINING_LENGTH_BYTES) {
+        return -1;
+      }
     }
-    conn->in_packet.topic_len |= input_data_ptr[(*pos)++];
-    conn->in_packet.byte_counter++;
-    conn->in_packet.topic_len_received = 1;
-    /* Abort if topic is longer than our topic buffer */
-    if(conn->in_packet.topic_len > MQTT_MAX_TOPIC_LENGTH) {
-      DBG("MQTT - topic too long %u/%u\n", conn->in_packet.topic_len, MQTT_MAX_TOPIC_LENGTH);
-      return;
+
+    if(*pos >= input_data_len) {
+      return 0;
     }
-    DBG("MQTT - Read PUBLISH topic len %i\n", conn->in_packet.topic_len);
-    /* WARNING: Check here if TOPIC fits in payload area, otherwise error */
-  }
-
-  /* Read out topic */
-  if(conn->in_packet.topic_len_received == 1 &&
-     conn->in_packet.topic_received == 0) {
-    copy_bytes = MIN(conn->in_packet.topic_len - conn->in_packet.topic_pos,
-                     input_data_len - *pos);
-    DBG("MQTT - topic_pos: %i copy_bytes: %i\n", conn->in_packet.topic_pos,
-        copy_bytes);
-    memcpy(&conn->in_publish_msg.topic[conn->in_packet.topic_pos],
-           &input_data_ptr[*pos],
-           copy_bytes);
-    (*pos) += copy_bytes;
-    conn->in_packet.byte_counter += copy_bytes;
-    conn->in_packet.topic_pos += copy_bytes;
-
-    if(conn->in_packet.topic_len - conn->in_packet.topic_pos == 0) {
-      DBG("MQTT - Got topic '%s'", conn->in_publish_msg.topic);
-      conn->in_packet.topic_received = 1;
-      conn->in_publish_msg.topic[conn->in_packet.topic_pos] = '\0';
-      conn->in_publish_msg.payload_length =
-        conn->in_packet.remaining_length - conn->in_packet.topic_len - 2;
-      conn->in_publish_msg.payload_left = conn->in_publish_msg.payload_length;
+    packet->payload[packet->payload_pos++] = input_data_ptr[(*pos)++];
+    packet->byte_counter++;
+  }
+#else
+  packet->vhdr_len = mid_len;
+#endif
+
+  if(packet->vhdr_len > MQTT_INPUT_BUFF_SIZE ||
+     packet->remaining_length < topic_bytes + packet->vhdr_len) {
+    return -1;
+  }
+
+  copy_bytes = MIN(packet->vhdr_len - packet->payload_pos,
+                   input_data_len - *pos);
+  memcpy(&packet->payload[packet->payload_pos], &input_data_ptr[*pos],
+         copy_bytes);
+  packet->payload_pos += copy_bytes;
+  packet->byte_counter += copy_bytes;
+  (*pos) += copy_bytes;
+
+  if(packet->payload_pos < packet->vhdr_len) {
+    return 0;
+  }
+
+  packet->payload_start = packet->payload;
+  if(mid_len > 0) {
+    packet->mid = (packet->payload[0] << 8) | packet->payload[1];
+    packet->payload_start += 2;
+    msg->mid = packet->mid;
+  }
+
+#if MQTT_5
+  mqtt_prop_decode_input_props(conn);
+#endif
+
+  msg->payload_length =
+    packet->remaining_length - topic_bytes - packet->vhdr_len;
+  msg->payload_offset = 0;
+  msg->payload_left = msg->payload_length;
+  /* Set this once per incoming publish message */
+  msg->first_chunk = 1;
+  packet->vhdr_received = 1;
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Reads input data for a PUBLISH message. The payload is not copied: each
+ * input holding payload bytes is passed to the application as one chunk.
+ */
+static int
+input_publish(struct mqtt_connection *conn,
+              uint32_t pos,
+              const uint8_t *input_data_ptr,
+              int input_data_len)
+{
+  struct mqtt_message *msg = &conn->in_publish_msg;
+  uint32_t chunk_length;
+
+  if(!conn->in_packet.topic_received &&
+     !parse_publish_topic(conn, &pos, input_data_ptr, input_data_len)) {
+    return pos;
+  }
+
+  if(!conn->in_packet.vhdr_received) {
+    switch(parse_publish_vhdr(conn, &pos, input_data_ptr, input_data_len)) {
+    case 0:
+      return pos;
+    case -1:
+      PRINTF("MQTT - Error, malformed or unsupported PUBLISH header\n");
+      conn->in_packet.discard = 1;
+      return pos;
     }
+  }
+
+  chunk_length = MIN(msg->payload_left, input_data_len - pos);
 
-    /* Set this once per incomming publish message */
-    conn->in_publish_msg.first_chunk = 1;
+  /* An empty payload is delivered as a single, empty chunk */
+  if(chunk_length == 0 && msg->payload_left > 0) {
+    return pos;
   }
+
+  msg->payload_chunk = &input_data_ptr[pos];
+  msg->payload_chunk_length = chunk_length;
+  msg->payload_offset = msg->payload_length - msg->payload_left;
+  msg->payload_left -= chunk_length;
+  conn->in_packet.byte_counter += chunk_length;
+  pos += chunk_length;
+
+  if(handle_publish(conn) != MQTT_PUBLISH_OK) {
+    return input_data_len;
+  }
+
+  return pos;
 }
 /*---------------------------------------------------------------------------*/
 /* MQTTv5 only */
@@ -1295,6 +1862,8 @@ parse_vhdr(struct mqtt_connection *conn)
   /* Some message types include a packet identifier */
   switch(conn->in_packet.fhdr & 0xF0) {
   case MQTT_FHDR_MSG_TYPE_PUBACK:
+  case MQTT_FHDR_MSG_TYPE_PUBREC:
+  case MQTT_FHDR_MSG_TYPE_PUBCOMP:
   case MQTT_FHDR_MSG_TYPE_SUBACK:
   case MQTT_FHDR_MSG_TYPE_UNSUBACK:
     conn->in_packet.mid = (conn->in_packet.payload[0] << 8) |
@@ -1303,7 +1872,7 @@ parse_vhdr(struct mqtt_connection *conn)
     break;
 
   /* Other message types have a 0-length VHDR */
-  /* PUBLISH has a VHDR for QoS > 0, which is currently unsupported */
+  /* The VHDR of PUBLISH is read by parse_publish_vhdr() */
   default:
     break;
   }
@@ -1337,16 +1906,35 @@ parse_vhdr(struct mqtt_connection *conn)
 #endif
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Total size of the packet being received, including the fixed header and
+ * the encoded Remaining Length.
+ */
+static uint32_t
+in_packet_size(struct mqtt_in_packet *packet)
+{
+  uint32_t size = MQTT_FHDR_SIZE + packet->remaining_length;
+  uint32_t length = packet->remaining_length;
+
+  do {
+    size++;
+    length /= 128;
+  } while(length > 0);
+
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Reads input data for one packet. Returns the number of bytes that belong to
+ * the packet, or all of the input data if the rest of it cannot be used.
+ */
 static int
-tcp_input(struct tcp_socket *s,
-          void *ptr,
-          const uint8_t *input_data_ptr,
-          int input_data_len)
+input_packet(struct mqtt_connection *conn,
+             const uint8_t *input_data_ptr,
+             int input_data_len)
 {
-  struct mqtt_connection *conn = ptr;
   uint32_t pos = 0;
   uint32_t copy_bytes = 0;
-  mqtt_pub_status_t pub_status;
   uint8_t remaining_length_bytes;
 
   if(input_data_len == 0) {
@@ -1367,7 +1955,7 @@ tcp_input(struct tcp_socket *s,
     DBG("MQTT - Read VHDR '%02X'\n", conn->in_packet.fhdr);
 
     if(pos >= input_data_len) {
-      return 0;
+      return pos;
     }
   }
 
@@ -1380,7 +1968,7 @@ tcp_input(struct tcp_socket *s,
 
     if(remaining_length_bytes == 0) {
       call_event(conn, MQTT_EVENT_ERROR, NULL);
-      return 0;
+      return input_data_len;
     }
 
     DBG("MQTT - Finished reading remaining length byte\n");
@@ -1393,88 +1981,57 @@ tcp_input(struct tcp_socket *s,
    *
    * TODO: Decide if we, for example, want to disconnect instead.
    */
-  if((conn->in_packet.remaining_length > MQTT_INPUT_BUFF_SIZE) &&
-     (conn->in_packet.fhdr & 0xF0) != MQTT_FHDR_MSG_TYPE_PUBLISH) {
-
+  if(conn->in_packet.remaining_length > MQTT_INPUT_BUFF_SIZE &&
+     (conn->in_packet.fhdr & 0xF0) != MQTT_FHDR_MSG_TYPE_PUBLISH &&
+     !conn->in_packet.discard) {
     PRINTF("MQTT - Error, unsupported payload size for non-PUBLISH message\n");
+    conn->in_packet.discard = 1;
+  }
 
-    conn->in_packet.byte_counter += input_data_len;
-    if(conn->in_packet.byte_counter >=
-       (MQTT_FHDR_SIZE + conn->in_packet.remaining_length)) {
+  if(conn->in_packet.discard) {
+    copy_bytes = MIN(input_data_len - pos,
+                     in_packet_size(&conn->in_packet) -
+                     conn->in_packet.byte_counter);
+    conn->in_packet.byte_counter += copy_bytes;
+    pos += copy_bytes;
+    if(conn->in_packet.byte_counter >= in_packet_size(&conn->in_packet)) {
       conn->in_packet.packet_received = 1;
     }
-    return 0;
+    return pos;
+  }
+
+  /* The payload of a PUBLISH message is not buffered */
+  if((conn->in_packet.fhdr & 0xF0) == MQTT_FHDR_MSG_TYPE_PUBLISH) {
+    return input_publish(conn, pos, input_data_ptr, input_data_len);
   }
 
   /*
    * Supported payload, reads out both VHDR and Payload of all packets.
    *
-   * Note: There will always be at least one byte left to read when we enter
-   *       this loop.
+   * Note: The input may end right after the Remaining Length field.
    */
-  while(conn->in_packet.byte_counter <
-        (MQTT_FHDR_SIZE + conn->in_packet.remaining_length)) {
-
-    if((conn->in_packet.fhdr & 0xF0) == MQTT_FHDR_MSG_TYPE_PUBLISH &&
-       conn->in_packet.topic_received == 0) {
-      parse_publish_vhdr(conn, &pos, input_data_ptr, input_data_len);
-    }
-
-    /* Read in as much as we can into the packet payload */
-    copy_bytes = MIN(input_data_len - pos,
-                     MQTT_INPUT_BUFF_SIZE - conn->in_packet.payload_pos);
-    DBG("- Copied %i payload bytes\n", copy_bytes);
-    memcpy(&conn->in_packet.payload[conn->in_packet.payload_pos],
-           &input_data_ptr[pos],
-           copy_bytes);
-    conn->in_packet.byte_counter += copy_bytes;
-    conn->in_packet.payload_pos += copy_bytes;
-    pos += copy_bytes;
+  copy_bytes = MIN(input_data_len - pos,
+                   in_packet_size(&conn->in_packet) -
+                   conn->in_packet.byte_counter);
+  DBG("- Copied %i payload bytes\n", copy_bytes);
+  memcpy(&conn->in_packet.payload[conn->in_packet.payload_pos],
+         &input_data_ptr[pos],
+         copy_bytes);
+  conn->in_packet.byte_counter += copy_bytes;
+  conn->in_packet.payload_pos += copy_bytes;
+  pos += copy_bytes;
 
 #if DEBUG_MQTT == 1
-    uint32_t i;
-    DBG("MQTT - Copied bytes: \n");
-    for(i = 0; i < copy_bytes; i++) {
-      DBG("%02X ", conn->in_packet.payload[i]);
-    }
-    DBG("\n");
-#endif
-
-    /* Full buffer, shall only happen to PUBLISH messages. */
-    if(MQTT_INPUT_BUFF_SIZE - conn->in_packet.payload_pos == 0) {
-      conn->in_publish_msg.payload_chunk = conn->in_packet.payload;
-      conn->in_publish_msg.payload_chunk_length = MQTT_INPUT_BUFF_SIZE;
-      conn->in_publish_msg.payload_left -= MQTT_INPUT_BUFF_SIZE;
-
-#if MQTT_5
-      if(!conn->in_packet.has_props) {
-        mqtt_prop_decode_input_props(conn);
-      }
-
-      if(conn->in_publish_msg.first_chunk) {
-        conn->in_publish_msg.payload_chunk_length -= conn->in_packet.properties_len +
-          conn->in_packet.properties_enc_len;
-
-        /* Payload chunk should point past the MQTT properties and to the payload itself */
-        conn->in_publish_msg.payload_chunk += conn->in_packet.properties_len +
-          conn->in_packet.properties_enc_len;
-      }
+  uint32_t i;
+  DBG("MQTT - Copied bytes: \n");
+  for(i = 0; i < copy_bytes; i++) {
+    DBG("%02X ", conn->in_packet.payload[i]);
+  }
+  DBG("\n");
 #endif
 
-      pub_status = handle_publish(conn);
-
-      conn->in_publish_msg.payload_chunk = conn->in_packet.payload;
-      conn->in_packet.payload_pos = 0;
-
-      if(pub_status != MQTT_PUBLISH_OK) {
-        return 0;
-      }
-    }
-
-    if(pos >= input_data_len &&
-       (conn->in_packet.byte_counter < (MQTT_FHDR_SIZE + conn->in_packet.remaining_length))) {
-      return 0;
-    }
+  if(conn->in_packet.byte_counter < in_packet_size(&conn->in_packet)) {
+    return pos;
   }
 
   parse_vhdr(conn);
@@ -1496,7 +2053,7 @@ tcp_input(struct tcp_socket *s,
                MQTT_EVENT_ERROR,
                NULL);
     abort_connection(conn);
-    return 0;
+    return input_data_len;
   }
 #endif
 
@@ -1505,24 +2062,6 @@ tcp_input(struct tcp_socket *s,
   case MQTT_FHDR_MSG_TYPE_CONNACK:
     handle_connack(conn);
     break;
-  case MQTT_FHDR_MSG_TYPE_PUBLISH:
-    /* This is the only or the last chunk of publish payload */
-    conn->in_publish_msg.payload_chunk = conn->in_packet.payload;
-    conn->in_publish_msg.payload_chunk_length = conn->in_packet.payload_pos;
-    conn->in_publish_msg.payload_left = 0;
-
-    DBG("MQTT - First chunk? %i\n", conn->in_publish_msg.first_chunk);
-#if MQTT_5
-    if(conn->in_publish_msg.first_chunk) {
-      conn->in_publish_msg.payload_chunk_length -= conn->in_packet.properties_len +
-        conn->in_packet.properties_enc_len;
-      /* Payload chunk should point past the MQTT properties and to the payload itself */
-      conn->in_publish_msg.payload_chunk += conn->in_packet.properties_len +
-        conn->in_packet.properties_enc_len;
-    }
-#endif
-    (void)handle_publish(conn);
-    break;
   case MQTT_FHDR_MSG_TYPE_PUBACK:
     handle_puback(conn);
     break;
@@ -1536,10 +2075,15 @@ tcp_input(struct tcp_socket *s,
     handle_pingresp(conn);
     break;
 
-  /* QoS 2 not implemented yet */
   case MQTT_FHDR_MSG_TYPE_PUBREC:
-  case MQTT_FHDR_MSG_TYPE_PUBREL:
+    handle_pubrec(conn);
+    break;
   case MQTT_FHDR_MSG_TYPE_PUBCOMP:
+    handle_pubcomp(conn);
+    break;
+
+  /* Incoming QoS 2 not implemented yet */
+  case MQTT_FHDR_MSG_TYPE_PUBREL:
     call_event(conn, MQTT_EVENT_NOT_IMPLEMENTED_ERROR, NULL);
     PRINTF("MQTT - Got unhandled MQTT Message Type '%i'",
            (conn->in_packet.fhdr & 0xF0));
@@ -1563,6 +2107,31 @@ tcp_input(struct tcp_socket *s,
 
   conn->in_packet.packet_received = 1;
 
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+tcp_input(struct tcp_socket *s,
+          void *ptr,
+          const uint8_t *input_data_ptr,
+          int input_data_len)
+{
+  struct mqtt_connection *conn = ptr;
+  int pos = 0;
+  int len;
+
+  /*
+   * A segment may hold several packets, such as the acknowledgements of a
+   * batch of queued PUBLISH messages.
+   */
+  while(pos < input_data_len) {
+    len = input_packet(conn, &input_data_ptr[pos], input_data_len - pos);
+    if(len <= 0) {
+      break;
+    }
+    pos += len;
+  }
+
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -1589,9 +2158,12 @@ tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
     call_event(conn, MQTT_EVENT_DISCONNECTED, &event);
     abort_connection(conn);
 
-    /* If connecting retry */
+    /*
+     * If connecting retry. This is done by the MQTT process, after it has
+     * handled the abort event posted above.
+     */
     if(conn->auto_reconnect == 1) {
-      connect_tcp(conn);
+      process_post(&mqtt_process, mqtt_do_connect_tcp_event, conn);
     }
     break;
   }
@@ -1608,6 +2180,7 @@ tcp_event(struct tcp_socket *s, void *ptr, tcp_socket_event_t event)
     if(conn->socket.output_data_len == 0) {
       conn->out_buffer_sent = 1;
       conn->out_buffer_ptr = conn->out_buffer;
+      schedule_flush(conn);
     }
 
     ctimer_restart(&conn->keep_alive_timer);
@@ -1726,6 +2299,21 @@ PROCESS_THREAD(mqtt_process, ev, data)
         }
       }
     }
+    if(ev == mqtt_do_flush_event) {
+      conn = data;
+      conn->out_queue.flush_pending = 0;
+      DBG("MQTT - Got mqtt_do_flush_event!\n");
+
+      /* Retried on TCP_SOCKET_DATA_SENT if the output buffer is busy */
+      if(conn->out_buffer_sent == 1 &&
+         conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
+        PT_INIT(&conn->out_proto_thread);
+        while(conn->state == MQTT_CONN_STATE_CONNECTED_TO_BROKER &&
+              flush_pt(&conn->out_proto_thread, conn) < PT_EXITED) {
+          PT_MQTT_WAIT_SEND();
+        }
+      }
+    }
 #if MQTT_5
     if(ev == mqtt_do_auth_event) {
       conn = data;
@@ -1758,6 +2346,7 @@ mqtt_init(void)
     mqtt_do_subscribe_event = process_alloc_event();
     mqtt_do_unsubscribe_event = process_alloc_event();
     mqtt_do_publish_event = process_alloc_event();
+    mqtt_do_flush_event = process_alloc_event();
     mqtt_do_pingreq_event = process_alloc_event();
     mqtt_update_event = process_alloc_event();
     mqtt_abort_now_event = process_alloc_event();
@@ -1795,6 +2384,7 @@ mqtt_register(struct mqtt_connection *conn, struct process *app_process,
   conn->app_process = app_process;
   conn->auto_reconnect = 1;
   conn->max_segment_size = max_segment_size;
+  conn->mid_counter = 1;
 
   reset_defaults(conn);
 
@@ -1802,6 +2392,10 @@ mqtt_register(struct mqtt_connection *conn, struct process *app_process,
 
   list_add(mqtt_conn_list, conn);
 
+#if MQTT_PERSIST
+  persist_restore(conn);
+#endif
+
   DBG("MQTT - Registered successfully\n");
 
   return MQTT_STATUS_OK;
@@ -1975,6 +2569,108 @@ mqtt_unsubscribe(struct mqtt_connection *conn, uint16_t *mid,
   return MQTT_STATUS_OK;
 }
 /*----------------------------------------------------------------------------*/
+/*
+ * Encodes a PUBLISH message into the outgoing queue. Returns
+ * MQTT_STATUS_INVALID_ARGS_ERROR if the message can never fit in the queue.
+ */
+static mqtt_status_t
+queue_publish(struct mqtt_connection *conn, uint16_t *mid,
+              char *topic, uint16_t topic_length,
+              uint8_t *payload, uint32_t payload_size,
+              mqtt_qos_level_t qos_level, mqtt_retain_t retain,
+              struct mqtt_prop_list *prop_list)
+{
+  struct mqtt_out_msg *msg;
+  uint8_t remaining_length_enc[MQTT_MAX_REMAINING_LENGTH_BYTES + 1];
+  uint8_t remaining_length_enc_bytes;
+  uint32_t remaining_length;
+  uint32_t length;
+  uint8_t *p;
+#if MQTT_5
+  struct mqtt_prop_out_property *prop;
+#endif
+
+  remaining_length = MQTT_STRING_LEN_SIZE + topic_length + payload_size;
+  if(qos_level > MQTT_QOS_LEVEL_0) {
+    remaining_length += MQTT_MID_SIZE;
+  }
+#if MQTT_5
+  remaining_length +=
+    prop_list ? (prop_list->properties_len + prop_list->properties_len_enc_bytes)
+    : 1;
+#endif
+
+  mqtt_encode_var_byte_int(remaining_length_enc, &remaining_length_enc_bytes,
+                           remaining_length);
+  length = MQTT_FHDR_SIZE + remaining_length_enc_bytes + remaining_length;
+  if(remaining_length_enc_bytes > MQTT_MAX_REMAINING_LENGTH_BYTES ||
+     length > MQTT_OUT_QUEUE_SIZE) {
+    return MQTT_STATUS_INVALID_ARGS_ERROR;
+  }
+
+  msg = queue_alloc(&conn->out_queue, length);
+  if(msg == NULL) {
+    DBG("MQTT - Not accepted, queue full!\n");
+    return MQTT_STATUS_OUT_QUEUE_FULL;
+  }
+  msg->mid = INCREMENT_MID(conn);
+  msg->qos = qos_level;
+
+  p = &conn->out_queue.buffer[msg->offset];
+  *p = MQTT_FHDR_MSG_TYPE_PUBLISH | qos_level << 1;
+  if(retain == MQTT_RETAIN_ON) {
+    *p |= MQTT_FHDR_RETAIN_FLAG;
+  }
+  p++;
+  memcpy(p, remaining_length_enc, remaining_length_enc_bytes);
+  p += remaining_length_enc_bytes;
+
+  /* Variable Header */
+  *p++ = topic_length >> 8;
+  *p++ = topic_length & 0x00FF;
+  memcpy(p, topic, topic_length);
+  p += topic_length;
+  if(qos_level > MQTT_QOS_LEVEL_0) {
+    *p++ = msg->mid >> 8;
+    *p++ = msg->mid & 0x00FF;
+  }
+
+#if MQTT_5
+  /* Properties */
+  if(prop_list) {
+    memcpy(p, prop_list->properties_len_enc,
+           prop_list->properties_len_enc_bytes);
+    p += prop_list->properties_len_enc_bytes;
+    for(prop = (struct mqtt_prop_out_property *)list_head(prop_list->props);
+        prop != NULL;
+        prop = (struct mqtt_prop_out_property *)list_item_next(prop)) {
+      *p++ = prop->id;
+      memcpy(p, prop->val, prop->property_len);
+      p += prop->property_len;
+    }
+  } else {
+    *p++ = 0;
+  }
+#endif
+
+  /* Payload */
+  memcpy(p, payload, payload_size);
+
+  if(mid) {
+    *mid = msg->mid;
+  }
+
+#if MQTT_PERSIST
+  persist_log(conn, MQTT_PERSIST_ADD, msg);
+#endif
+
+  DBG("MQTT - Queued message %u (%lu bytes)\n", msg->mid,
+      (unsigned long)length);
+
+  schedule_flush(conn);
+  return MQTT_STATUS_OK;
+}
+/*----------------------------------------------------------------------------*/
 mqtt_status_t
 mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
              uint8_t *payload, uint32_t payload_size,
@@ -1987,38 +2683,55 @@ mqtt_publish(struct mqtt_connection *conn, uint16_t *mid, char *topic,
              mqtt_retain_t retain)
 #endif
 {
+  mqtt_status_t status;
+  uint16_t topic_length;
+
   if(conn->state != MQTT_CONN_STATE_CONNECTED_TO_BROKER) {
     return MQTT_STATUS_NOT_CONNECTED_ERROR;
   }
 
   DBG("MQTT - Call to mqtt_publish...\n");
 
-  /* Currently don't have a queue, so only one item at a time */
-  if(conn->out_queue_full) {
-    DBG("MQTT - Not accepted!\n");
-    return MQTT_STATUS_OUT_QUEUE_FULL;
-  }
-  conn->out_queue_full = 1;
-  DBG("MQTT - Accepted!\n");
-
-  conn->out_packet.mid = INCREMENT_MID(conn);
-  conn->out_packet.retain = retain;
 #if MQTT_5
   if(topic_alias_en == MQTT_TOPIC_ALIAS_ON) {
-    conn->out_packet.topic = "";
-    conn->out_packet.topic_length = 0;
-    conn->out_packet.topic_alias = topic_alias;
+    topic = "";
     if(topic_alias == 0) {
       DBG("MQTT - Error, a topic alias of 0 is not permitted! It won't be sent.\n");
     }
   } else {
-    conn->out_packet.topic = topic;
-    conn->out_packet.topic_length = strlen(topic);
-    conn->out_packet.topic_alias = 0;
+    topic_alias = 0;
   }
+  topic_length = strlen(topic);
+
+  status = queue_publish(conn, mid, topic, topic_length, payload, payload_size,
+                         qos_level, retain, prop_list);
 #else
+  topic_length = strlen(topic);
+
+  status = queue_publish(conn, mid, topic, topic_length, payload, payload_size,
+                         qos_level, retain, NULL);
+#endif
+  if(status != MQTT_STATUS_INVALID_ARGS_ERROR) {
+    return status;
+  }
+
+  /*
+   * Too large for the queue. Send it directly from the application buffer,
+   * after everything that has been queued before it.
+   */
+  if(conn->out_queue_full || conn->out_queue.count > 0) {
+    DBG("MQTT - Not accepted!\n");
+    return MQTT_STATUS_OUT_QUEUE_FULL;
+  }
+  conn->out_queue_full = 1;
+  DBG("MQTT - Accepted!\n");
+
+  conn->out_packet.mid = INCREMENT_MID(conn);
+  conn->out_packet.retain = retain;
   conn->out_packet.topic = topic;
-  conn->out_packet.topic_length = strlen(topic);
+  conn->out_packet.topic_length = topic_length;
+#if MQTT_5
+  conn->out_packet.topic_alias = topic_alias;
 #endif
   conn->out_packet.payload = payload;
   conn->out_packet.payload_size = payload_size;
@@ -125,8 +125,23 @@
 #define MQTT_TCP_INPUT_BUFF_SIZE 512
 #define MQTT_TCP_OUTPUT_BUFF_SIZE 512
 
+/*
+ * Buffer for incoming packets other than PUBLISH, and for the variable header
+ * of incoming PUBLISH messages. The payload of a PUBLISH message is not
+ * buffered: it is handed to the application straight from the TCP input
+ * buffer, so it may be of any size.
+ */
 #define MQTT_INPUT_BUFF_SIZE 512
+
+/*
+ * Longest topic of an incoming PUBLISH message that is kept. Longer topics
+ * are truncated, see struct mqtt_message.
+ */
+#ifdef MQTT_CONF_MAX_TOPIC_LENGTH
+#define MQTT_MAX_TOPIC_LENGTH MQTT_CONF_MAX_TOPIC_LENGTH
+#else
 #define MQTT_MAX_TOPIC_LENGTH 64
+#endif
 #define MQTT_MAX_TOPICS_PER_SUBSCRIBE 1
 
 #define MQTT_FHDR_SIZE 1
@@ -139,6 +154,52 @@
 
 #define MQTT_TOPIC_MAX_LENGTH 128
 
+/*
+ * Outgoing PUBLISH queue. Messages whose encoded size fits are copied into a
+ * ring buffer of MQTT_OUT_QUEUE_SIZE bytes, so that several of them can be
+ * written into the same TCP segment. Up to MQTT_MAX_INFLIGHT QoS 1/2
+ * messages may be awaiting acknowledgement at any time. Larger messages are
+ * sent directly from the application buffer, one at a time.
+ */
+#ifdef MQTT_CONF_OUT_QUEUE_SIZE
+#define MQTT_OUT_QUEUE_SIZE MQTT_CONF_OUT_QUEUE_SIZE
+#else
+#define MQTT_OUT_QUEUE_SIZE 512
+#endif
+
+/* Maximum number of messages in the outgoing queue */
+#ifdef MQTT_CONF_OUT_QUEUE_LENGTH
+#define MQTT_OUT_QUEUE_LENGTH MQTT_CONF_OUT_QUEUE_LENGTH
+#else
+#define MQTT_OUT_QUEUE_LENGTH 8
+#endif
+
+/* Maximum number of unacknowledged QoS 1/2 messages */
+#ifdef MQTT_CONF_MAX_INFLIGHT
+#define MQTT_MAX_INFLIGHT MQTT_CONF_MAX_INFLIGHT
+#else
+#define MQTT_MAX_INFLIGHT 4
+#endif
+
+/*
+ * Keep a log of unacknowledged QoS 1/2 messages in CFS, so that they are
+ * retransmitted after a reboot. The log is compacted when it grows beyond
+ * MQTT_PERSIST_MAX_LOG bytes and removed when no message is pending.
+ */
+#ifdef MQTT_CONF_PERSIST
+#define MQTT_PERSIST MQTT_CONF_PERSIST
+#else
+#define MQTT_PERSIST 0
+#endif
+
+#ifdef MQTT_CONF_PERSIST_MAX_LOG
+#define MQTT_PERSIST_MAX_LOG MQTT_CONF_PERSIST_MAX_LOG
+#else
+#define MQTT_PERSIST_MAX_LOG (4 * MQTT_OUT_QUEUE_SIZE)
+#endif
+
+#define MQTT_PERSIST_NAME_LEN 16
+
 #if MQTT_PROTOCOL_VERSION >= MQTT_PROTOCOL_VERSION_3_1_1
 #ifdef MQTT_CONF_SUPPORTS_EMPTY_CLIENT_ID
 #define MQTT_SRV_SUPPORTS_EMPTY_CLIENT_ID MQTT_CONF_SUPPORTS_EMPTY_CLIENT_ID
@@ -260,6 +321,15 @@ typedef enum {
   /* Expand for QoS 2 */
 } mqtt_qos_state_t;
 
+/* The state of a message in the outgoing queue */
+typedef enum {
+  MQTT_OUT_MSG_DONE,
+  MQTT_OUT_MSG_QUEUED,        /* PUBLISH not sent yet */
+  MQTT_OUT_MSG_SENT,          /* Waiting for PUBACK or PUBREC */
+  MQTT_OUT_MSG_PUBREL,        /* PUBREL not sent yet */
+  MQTT_OUT_MSG_PUBREL_SENT,   /* Waiting for PUBCOMP */
+} mqtt_out_msg_state_t;
+
 typedef enum {
   MQTT_PUBLISH_OK,
   MQTT_PUBLISH_ERR,
@@ -406,17 +476,31 @@ typedef enum {
   MQTT_AUTH_RE_AUTH,
 } mqtt_auth_type_t;
 
-/* This is the MQTT message that is exposed to the end user. */
+/*
+ * This is the MQTT message that is exposed to the end user.
+ *
+ * The payload of an incoming PUBLISH message is delivered in one or more
+ * MQTT_EVENT_PUBLISH events, each with one chunk of the payload. A chunk
+ * points straight into the TCP input buffer and is only valid during the
+ * event. payload_offset is the position of the chunk in the payload,
+ * first_chunk is set for the first chunk and payload_left is 0 for the last.
+ *
+ * topic_length is the length of the topic in the message. If it is longer
+ * than MQTT_MAX_TOPIC_LENGTH, topic only holds the first
+ * MQTT_MAX_TOPIC_LENGTH characters.
+ */
 struct mqtt_message {
   uint32_t mid;
   char topic[MQTT_MAX_TOPIC_LENGTH + 1]; /* +1 for string termination */
+  uint16_t topic_length;
 
-  uint8_t *payload_chunk;
+  const uint8_t *payload_chunk;
   uint16_t payload_chunk_length;
 
   uint8_t first_chunk;
-  uint16_t payload_length;
-  uint16_t payload_left;
+  uint32_t payload_length;
+  uint32_t payload_offset;
+  uint32_t payload_left;
 };
 
 /* This struct represents a packet received from the MQTT server. */
@@ -430,7 +514,7 @@ struct mqtt_in_packet {
   uint8_t packet_received;
 
   uint8_t fhdr;
-  uint16_t remaining_length;
+  uint32_t remaining_length;
   uint16_t mid;
 
   /* Helper variables needed to decode the remaining_length */
@@ -448,8 +532,13 @@ struct mqtt_in_packet {
   /* Message specific data */
   uint16_t topic_len;
   uint16_t topic_pos;
-  uint8_t topic_len_received;
+  uint8_t topic_len_received; /* number of topic length bytes read */
   uint8_t topic_received;
+  uint16_t vhdr_len;
+  uint8_t vhdr_received;
+
+  /* The packet cannot be handled, and its remaining bytes are skipped */
+  uint8_t discard;
 
   /* Properties */
 #if MQTT_5
@@ -458,7 +547,7 @@ struct mqtt_in_packet {
 
   uint8_t has_props;  /* the properties have been decoded */
   uint8_t properties_enc_len;  /* number of bytes used to encode property length */
-  uint16_t properties_len; /* length of properties excluding encoded length */
+  uint32_t properties_len; /* length of properties excluding encoded length */
   uint8_t *props_start;  /* pointer to first byte in first property */
   uint8_t *curr_props_pos;  /* pointer to property to parse next */
 #endif
@@ -485,6 +574,35 @@ struct mqtt_out_packet {
   uint8_t auth_reason_code;
 #endif
 };
+/* A message in the outgoing queue */
+struct mqtt_out_msg {
+  uint16_t offset;
+  uint16_t length;
+  uint16_t mid;
+  uint8_t qos;
+  uint8_t state;
+};
+
+/*
+ * The outgoing queue. Messages are kept in the order they were published.
+ * Each encoded message is stored contiguously in the ring buffer and is
+ * released when it has been sent (QoS 0) or acknowledged (QoS 1/2) and all
+ * messages before it have been released.
+ */
+struct mqtt_out_queue {
+  uint8_t buffer[MQTT_OUT_QUEUE_SIZE];
+  struct mqtt_out_msg msg[MQTT_OUT_QUEUE_LENGTH];
+  uint16_t write_pos;
+  uint8_t head;
+  uint8_t count;
+  uint8_t cursor;
+  uint8_t flush_pending;
+  /* A PUBREL: fixed header, remaining length and message ID */
+  uint8_t pubrel[MQTT_FHDR_SIZE + 1 + MQTT_MID_SIZE];
+#if MQTT_PERSIST
+  uint16_t log_size;
+#endif
+};
 /*---------------------------------------------------------------------------*/
 /**
  * \brief           MQTT event callback function
@@ -549,6 +667,7 @@ struct mqtt_connection {
   uint8_t out_buffer[MQTT_TCP_OUTPUT_BUFF_SIZE];
   uint8_t out_buffer_sent;
   struct mqtt_out_packet out_packet;
+  struct mqtt_out_queue out_queue;
   struct pt out_proto_thread;
   uint32_t out_write_pos;
   uint16_t max_segment_size;
@@ -686,7 +805,7 @@ mqtt_status_t mqtt_unsubscribe(struct mqtt_connection *conn,
  * \param topic A pointer to the topic to subscribe to.
  * \param payload A pointer to the topic payload.
  * \param payload_size Payload size.
- * \param qos_level Quality Of Service level to use. Currently supports 0, 1.
+ * \param qos_level Quality Of Service level to use. Supports 0, 1 and 2.
  * \param retain If the RETAIN flag is set to 1, in a PUBLISH Packet sent by a
  *        Client to a Server, the Server MUST store the Application Message
  *        and its QoS, so that it can be delivered to future subscribers whose
@@ -698,6 +817,22 @@ mqtt_status_t mqtt_unsubscribe(struct mqtt_connection *conn,
  * \return MQTT_STATUS_OK or some error status
  *
  * This function publishes to a topic on a MQTT broker.
+ *
+ * Messages that fit in the outgoing queue are copied, so the topic and
+ * payload buffers may be reused as soon as the function returns. Queued
+ * messages are sent in order, several per TCP segment, with up to
+ * MQTT_MAX_INFLIGHT QoS 1/2 messages awaiting acknowledgement.
+ * MQTT_EVENT_PUBACK is reported when a QoS 1 message has been acknowledged
+ * with PUBACK or a QoS 2 message with PUBCOMP. Unacknowledged messages are
+ * retransmitted with the DUP flag set after a reconnect.
+ *
+ * Larger messages are sent directly from the given buffers, which must
+ * remain valid until mqtt_ready() returns true again. Such messages are only
+ * accepted when the outgoing queue is empty.
+ *
+ * MQTT_STATUS_OUT_QUEUE_FULL is returned when the message cannot be accepted
+ * yet. The application process receives mqtt_update_event when room has
+ * been made.
  */
 mqtt_status_t mqtt_publish(struct mqtt_connection *conn,
                            uint16_t *mid,
@@ -769,7 +904,7 @@ uint8_t mqtt_decode_var_byte_int(const uint8_t *input_data_ptr,
                                  int input_data_len,
                                  uint32_t *input_pos,
                                  uint32_t *pkt_byte_count,
-                                 uint16_t *dest);
+                                 uint32_t *dest);
 /*---------------------------------------------------------------------------*/
 /**
  * \brief Send authentication message (MQTTv5-only).
@@ -101,6 +101,37 @@
 #define SNMP_MAX_NR_VALUES 2
 #endif
 
+#ifdef SNMP_CONF_MAX_BULK_VALUES
+#if SNMP_CONF_MAX_BULK_VALUES > 255
+#error "Number of OID's per packet is limited to 255 in this implementation"
+#endif
+#if SNMP_CONF_MAX_BULK_VALUES < SNMP_MAX_NR_VALUES
+#error "SNMP_CONF_MAX_BULK_VALUES must not be lower than SNMP_MAX_NR_VALUES"
+#endif
+/**
+ * \brief Configurable maximum number of OIDs in one GETBULK response
+ */
+#define SNMP_MAX_BULK_VALUES SNMP_CONF_MAX_BULK_VALUES
+#else
+/**
+ * \brief Default maximum number of OIDs in one GETBULK response
+ */
+#define SNMP_MAX_BULK_VALUES SNMP_MAX_NR_VALUES
+#endif
+
+#ifdef SNMP_CONF_MIB_INDEX_SIZE
+/**
+ * \brief Configurable size of the MIB index. Every Nth resource is indexed
+ *        for a binary search, with N chosen to cover the whole MIB
+ */
+#define SNMP_MIB_INDEX_SIZE SNMP_CONF_MIB_INDEX_SIZE
+#else
+/**
+ * \brief Default size of the MIB index
+ */
+#define SNMP_MIB_INDEX_SIZE 16
+#endif
+
 #ifdef SNMP_CONF_MAX_PACKET_SIZE
 #error "SNMP_CONF_MAX_PACKET_SIZE is obsolete. Use UIP_CONF_BUFFER_SIZE"
 #endif /* SNMP_CONF_MAX_PACKET_SIZE */
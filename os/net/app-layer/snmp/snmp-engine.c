@@ -118,10 +118,42 @@ snmp_engine_get_next(snmp_header_t *header, snmp_varbind_t *varbinds)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Marks the end of the MIB for a varbind, or sets the error for SNMPv1.
+ * Returns 0 if there is no room for the varbind.
+ */
+static inline int
+snmp_engine_end_of_mib(snmp_header_t *header, snmp_varbind_t *varbinds,
+                       uint8_t *varbinds_length, snmp_oid_t *oid)
+{
+  switch(header->version) {
+  case SNMP_VERSION_1:
+    header->error_status = SNMP_STATUS_NO_SUCH_NAME;
+    /*
+     * Varbinds are 1 indexed
+     */
+    header->error_index = *varbinds_length + 1;
+    break;
+  case SNMP_VERSION_2C:
+    if(*varbinds_length >= SNMP_MAX_BULK_VALUES) {
+      return 0;
+    }
+    (&varbinds[*varbinds_length])->value_type = BER_DATA_TYPE_END_OF_MIB_VIEW;
+    memcpy(&varbinds[*varbinds_length].oid, oid, sizeof(snmp_oid_t));
+    (*varbinds_length)++;
+    break;
+  default:
+    header->error_status = SNMP_STATUS_NO_SUCH_NAME;
+    header->error_index = 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static inline int
 snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
 {
   snmp_mib_resource_t *resource;
+  snmp_mib_resource_t *last[SNMP_MAX_NR_VALUES];
   snmp_oid_t oids[SNMP_MAX_NR_VALUES];
   uint32_t j, original_varbinds_length;
   uint8_t repeater;
@@ -135,9 +167,15 @@ snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
   while(original_varbinds_length < SNMP_MAX_NR_VALUES &&
         varbinds[original_varbinds_length].value_type != BER_DATA_TYPE_EOC) {
     memcpy(&oids[original_varbinds_length], &varbinds[original_varbinds_length].oid, sizeof(snmp_oid_t));
+    last[original_varbinds_length] = NULL;
     original_varbinds_length++;
   }
+  memset(varbinds, 0, sizeof(snmp_varbind_t) * original_varbinds_length);
 
+  /*
+   * The response is truncated when the varbinds are full. The message is
+   * truncated further by snmp_engine() if it does not fit the packet.
+   */
   varbinds_length = 0;
   for(i = 0; i < original_varbinds_length; i++) {
     if(i >= header->non_repeaters) {
@@ -146,27 +184,15 @@ snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
 
     resource = snmp_mib_find_next(&oids[i]);
     if(!resource) {
-      switch(header->version) {
-      case SNMP_VERSION_1:
-        header->error_status = SNMP_STATUS_NO_SUCH_NAME;
-        /*
-         * Varbinds are 1 indexed
-         */
-        header->error_index = i + 1;
-        break;
-      case SNMP_VERSION_2C:
-        (&varbinds[i])->value_type = BER_DATA_TYPE_END_OF_MIB_VIEW;
-        break;
-      default:
-        header->error_status = SNMP_STATUS_NO_SUCH_NAME;
-        header->error_index = 0;
+      if(!snmp_engine_end_of_mib(header, varbinds, &varbinds_length, &oids[i])) {
+        return 0;
       }
     } else {
-      if(varbinds_length < SNMP_MAX_NR_VALUES) {
+      if(varbinds_length < SNMP_MAX_BULK_VALUES) {
         resource->handler(&varbinds[varbinds_length], &resource->oid);
         (varbinds_length)++;
       } else {
-        return -1;
+        return 0;
       }
     }
   }
@@ -174,37 +200,25 @@ snmp_engine_get_bulk(snmp_header_t *header, snmp_varbind_t *varbinds)
   for(i = 0; i < header->max_repetitions; i++) {
     repeater = 0;
     for(j = header->non_repeaters; j < original_varbinds_length; j++) {
-      resource = snmp_mib_find_next(&oids[j]);
+      if(last[j] == NULL) {
+        resource = snmp_mib_find_next(&oids[j]);
+      } else {
+        /* The MIB is sorted - the next resource follows the last one */
+        resource = last[j]->next;
+      }
       if(!resource) {
-        switch(header->version) {
-        case SNMP_VERSION_1:
-          header->error_status = SNMP_STATUS_NO_SUCH_NAME;
-          /*
-           * Varbinds are 1 indexed
-           */
-          header->error_index = varbinds_length + 1;
-          break;
-        case SNMP_VERSION_2C:
-          if(varbinds_length < SNMP_MAX_NR_VALUES) {
-            (&varbinds[varbinds_length])->value_type = BER_DATA_TYPE_END_OF_MIB_VIEW;
-            memcpy(&varbinds[varbinds_length].oid, &oids[j], sizeof(snmp_oid_t));
-            (varbinds_length)++;
-          } else {
-            return -1;
-          }
-          break;
-        default:
-          header->error_status = SNMP_STATUS_NO_SUCH_NAME;
-          header->error_index = 0;
+        if(!snmp_engine_end_of_mib(header, varbinds, &varbinds_length, &oids[j])) {
+          return 0;
         }
       } else {
-        if(varbinds_length < SNMP_MAX_NR_VALUES) {
+        if(varbinds_length < SNMP_MAX_BULK_VALUES) {
           resource->handler(&varbinds[varbinds_length], &resource->oid);
           (varbinds_length)++;
           memcpy(&oids[j], &resource->oid, sizeof(snmp_oid_t));
+          last[j] = resource;
           repeater++;
         } else {
-          return -1;
+          return 0;
         }
       }
     }
@@ -220,7 +234,12 @@ int
 snmp_engine(snmp_packet_t *snmp_packet)
 {
   snmp_header_t header;
-  snmp_varbind_t varbinds[SNMP_MAX_NR_VALUES];
+  /* Static, since a GETBULK response may need many varbinds */
+  static snmp_varbind_t varbinds[SNMP_MAX_BULK_VALUES];
+  uint8_t *out;
+  uint16_t used;
+  uint8_t request_type;
+  int16_t i;
 
   memset(&header, 0, sizeof(header));
   memset(varbinds, 0, sizeof(varbinds));
@@ -263,7 +282,32 @@ snmp_engine(snmp_packet_t *snmp_packet)
     return 0;
   }
 
+  request_type = header.pdu_type;
   header.pdu_type = BER_DATA_TYPE_PDU_GET_RESPONSE;
 
-  return snmp_message_encode(snmp_packet, &header, varbinds);
+  out = snmp_packet->out;
+  used = snmp_packet->used;
+  if(snmp_message_encode(snmp_packet, &header, varbinds)) {
+    return 1;
+  }
+  if(request_type != BER_DATA_TYPE_PDU_GET_BULK) {
+    return 0;
+  }
+
+  /*
+   * The response does not fit the packet. Drop the last varbinds,
+   * which is allowed for GETBULK, until it fits.
+   */
+  for(i = SNMP_MAX_BULK_VALUES - 1; i > 0; i--) {
+    if(varbinds[i].value_type == BER_DATA_TYPE_EOC) {
+      continue;
+    }
+    varbinds[i].value_type = BER_DATA_TYPE_EOC;
+    snmp_packet->out = out;
+    snmp_packet->used = used;
+    if(snmp_message_encode(snmp_packet, &header, varbinds)) {
+      return 1;
+    }
+  }
+  return 0;
 }
@@ -49,9 +49,9 @@ int
 snmp_message_encode(snmp_packet_t *snmp_packet, snmp_header_t *header, snmp_varbind_t *varbinds)
 {
   uint32_t last_out_len;
-  int8_t i;
+  int16_t i;
 
-  for(i = SNMP_MAX_NR_VALUES - 1; i >= 0; i--) {
+  for(i = SNMP_MAX_BULK_VALUES - 1; i >= 0; i--) {
     if(varbinds[i].value_type == BER_DATA_TYPE_EOC) {
       continue;
     }
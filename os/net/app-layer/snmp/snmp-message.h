@@ -66,7 +66,7 @@
  *
  * @param snmp_packet A pointer to the snmp packet
  * @param header The SNMP header struct
- * @param varbinds The varbinds array
+ * @param varbinds The varbinds array, of SNMP_MAX_BULK_VALUES varbinds
  *
  * @return
  */
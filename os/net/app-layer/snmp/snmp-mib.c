@@ -41,12 +41,19 @@
 
 #include "snmp-mib.h"
 #include "lib/list.h"
+#include "lib/list-index.h"
 
 #define LOG_MODULE "SNMP [mib]"
 #define LOG_LEVEL LOG_LEVEL_SNMP
 
 LIST(snmp_mib);
 
+/*
+ * Every Nth resource of the sorted MIB list, for a binary search. The list
+ * is walked for at most N resources from the closest indexed one.
+ */
+LIST_INDEX(snmp_mib_index, SNMP_MIB_INDEX_SIZE);
+
 /*---------------------------------------------------------------------------*/
 /**
  * @brief Compares to oids
@@ -85,18 +92,38 @@ snmp_mib_cmp_oid(snmp_oid_t *oid1, snmp_oid_t *oid2)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+static int
+snmp_mib_resource_cmp(const void *item, const void *key)
+{
+  return snmp_mib_cmp_oid(&((snmp_mib_resource_t *)item)->oid,
+                          (snmp_oid_t *)key);
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief Finds the first resource with an OID equal to or greater than this
+ *        OID
+ *
+ * @param oid The OID
+ * @param prev Set to the resource before it, or NULL if it is the first one
+ *
+ * @return The resource or NULL if all the OIDs are lower
+ */
+static snmp_mib_resource_t *
+snmp_mib_lower_bound(snmp_oid_t *oid, snmp_mib_resource_t **prev)
+{
+  return list_index_lower_bound(&snmp_mib_index, snmp_mib, oid,
+                                snmp_mib_resource_cmp, (void **)prev);
+}
+/*---------------------------------------------------------------------------*/
 snmp_mib_resource_t *
 snmp_mib_find(snmp_oid_t *oid)
 {
   snmp_mib_resource_t *resource;
+  snmp_mib_resource_t *prev;
 
-  resource = NULL;
-  for(resource = list_head(snmp_mib);
-      resource; resource = resource->next) {
-
-    if(!snmp_mib_cmp_oid(oid, &resource->oid)) {
-      return resource;
-    }
+  resource = snmp_mib_lower_bound(oid, &prev);
+  if(resource != NULL && !snmp_mib_cmp_oid(oid, &resource->oid)) {
+    return resource;
   }
 
   return NULL;
@@ -106,37 +133,31 @@ snmp_mib_resource_t *
 snmp_mib_find_next(snmp_oid_t *oid)
 {
   snmp_mib_resource_t *resource;
+  snmp_mib_resource_t *prev;
 
-  resource = NULL;
-  for(resource = list_head(snmp_mib);
-      resource; resource = resource->next) {
-
-    if(snmp_mib_cmp_oid(&resource->oid, oid) > 0) {
-      return resource;
-    }
+  resource = snmp_mib_lower_bound(oid, &prev);
+  if(resource != NULL && !snmp_mib_cmp_oid(oid, &resource->oid)) {
+    return resource->next;
   }
 
-  return NULL;
+  return resource;
 }
 /*---------------------------------------------------------------------------*/
 void
 snmp_mib_add(snmp_mib_resource_t *new_resource)
 {
   snmp_mib_resource_t *resource;
+  snmp_mib_resource_t *prev;
   uint8_t i;
 
-  for(resource = list_head(snmp_mib);
-      resource; resource = resource->next) {
+  snmp_mib_lower_bound(&new_resource->oid, &prev);
+  list_insert(snmp_mib, prev, new_resource);
 
-    if(snmp_mib_cmp_oid(&resource->oid, &new_resource->oid) > 0) {
-      break;
-    }
-  }
-  if(resource == NULL) {
-    list_add(snmp_mib, new_resource);
-  } else {
-    list_insert(snmp_mib, new_resource, resource);
-  }
+  /*
+   * Resources are added at initialization, so the index is simply
+   * rebuilt
+   */
+  list_index_update(&snmp_mib_index, snmp_mib);
 
   if(LOG_DBG_ENABLED) {
     /*
@@ -164,4 +185,5 @@ void
 snmp_mib_init(void)
 {
   list_init(snmp_mib);
+  list_index_update(&snmp_mib_index, snmp_mib);
 }
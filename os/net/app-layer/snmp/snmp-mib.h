@@ -110,7 +110,7 @@ snmp_mib_resource_t *
 snmp_mib_find_next(snmp_oid_t *oid);
 
 /**
- * @brief Adds a resource into the linked list
+ * @brief Adds a resource into the linked list, sorted by OID
  *
  * @param resource The resource
  */
@@ -2172,6 +2172,35 @@ sicslowpan_get_last_rssi(void)
   return last_rssi;
 }
 /*--------------------------------------------------------------------*/
+int
+sicslowpan_depends_on_receiver(const uint8_t *frame, int len)
+{
+  int pos = 0;
+
+  if(len < 1) {
+    return 1;
+  }
+  if((frame[0] & SICSLOWPAN_DISPATCH_FRAG_MASK) == SICSLOWPAN_DISPATCH_FRAGN) {
+    return -1;
+  }
+  if((frame[0] & SICSLOWPAN_DISPATCH_FRAG_MASK) == SICSLOWPAN_DISPATCH_FRAG1) {
+    pos += SICSLOWPAN_FRAG1_HDR_LEN;
+  }
+  if(pos + 2 > len) {
+    return 1;
+  }
+  if(frame[pos] == SICSLOWPAN_DISPATCH_IPV6) {
+    return 0;
+  }
+  if((frame[pos] & SICSLOWPAN_DISPATCH_IPHC_MASK) == SICSLOWPAN_DISPATCH_IPHC) {
+    /* A unicast destination with DAM 11 is the address of the receiver */
+    return !(frame[pos + 1] & SICSLOWPAN_IPHC_M)
+      && (frame[pos + 1] & SICSLOWPAN_IPHC_DAM_11) == SICSLOWPAN_IPHC_DAM_11;
+  }
+  /* Other headers, such as 6LoRH, are not parsed */
+  return 1;
+}
+/*--------------------------------------------------------------------*/
 const struct network_driver sicslowpan_driver = {
   "sicslowpan",
   sicslowpan_init,
@@ -338,6 +338,18 @@ struct sicslowpan_nh_compressor {
 
 extern CC_DEPRECATED("Use UIPBUF_ATTR_RSSI instead") int sicslowpan_get_last_rssi(void);
 
+/**
+ * Tells whether a 6LoWPAN frame only makes sense for the link-layer
+ * receiver it was compressed for, i.e., whether its IPv6 destination is
+ * derived from the link-layer address of the receiver. Used by MAC layers
+ * that move queued frames to another receiver.
+ *
+ * \param frame The 6LoWPAN frame, without link-layer header
+ * \param len The length of the frame
+ * \return 1 if so, 0 if not, -1 for a fragment other than the first
+ */
+int sicslowpan_depends_on_receiver(const uint8_t *frame, int len);
+
 extern const struct network_driver sicslowpan_driver;
 
 #endif /* SICSLOWPAN_H_ */
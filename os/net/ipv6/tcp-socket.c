@@ -45,6 +45,9 @@
 static void relisten(struct tcp_socket *s);
 
 LIST(socketlist);
+
+/* Non-zero while the callbacks of a socket are called by uIP */
+static uint8_t in_appcall;
 /*---------------------------------------------------------------------------*/
 PROCESS(tcp_socket_process, "TCP socket process");
 /*---------------------------------------------------------------------------*/
@@ -60,6 +63,24 @@ static void
 senddata(struct tcp_socket *s)
 {
   int len = MIN(s->output_data_max_seg, uip_mss());
+#if UIP_TCP_SEND_WINDOW
+  uint16_t offset;
+
+  if(uip_tcp_window_enabled(uip_conn)) {
+    /* The data in flight stays at the start of the buffer until it
+       is acknowledged. The next segment follows it. */
+    offset = uip_outstanding(uip_conn);
+    if(s->output_data_len > offset) {
+      len = MIN(s->output_data_len - offset, len);
+      uip_send(&s->output_data_ptr[offset], len);
+      if(s->output_data_len > offset + len) {
+        /* Sent if the window has room for it */
+        tcpip_poll_tcp(uip_conn);
+      }
+    }
+    return;
+  }
+#endif /* UIP_TCP_SEND_WINDOW */
 
   if(s->output_senddata_len > 0) {
     len = MIN(s->output_senddata_len, len);
@@ -71,6 +92,28 @@ senddata(struct tcp_socket *s)
 static void
 acked(struct tcp_socket *s)
 {
+#if UIP_TCP_SEND_WINDOW
+  if(uip_tcp_window_enabled(uip_conn)) {
+    if(uip_ackedlen() > s->output_data_len) {
+      PRINTF("tcp: acked %d bytes, only %d in the buffer\n",
+             uip_ackedlen(), s->output_data_len);
+      tcp_markconn(uip_conn, NULL);
+      uip_abort();
+      call_event(s, TCP_SOCKET_ABORTED);
+      relisten(s);
+      return;
+    }
+    memmove(&s->output_data_ptr[0],
+            &s->output_data_ptr[uip_ackedlen()],
+            s->output_data_len - uip_ackedlen());
+    s->output_data_len -= uip_ackedlen();
+    s->output_senddata_len = s->output_data_len;
+
+    call_event(s, TCP_SOCKET_DATA_SENT);
+    return;
+  }
+#endif /* UIP_TCP_SEND_WINDOW */
+
   if(s->output_senddata_len > 0) {
     /* Copy the data in the outputbuf down and update outputbufptr and
        outputbuf_lastsent */
@@ -164,6 +207,7 @@ appcall(void *state)
 	  s->flags &= ~TCP_SOCKET_FLAGS_LISTENING;
           s->output_data_max_seg = uip_mss();
 	  tcp_markconn(uip_conn, s);
+          s->c = uip_conn;
 	  call_event(s, TCP_SOCKET_CONNECTED);
 	  break;
 	}
@@ -176,6 +220,18 @@ appcall(void *state)
     if(s == NULL) {
       uip_abort();
     } else {
+#if UIP_TCP_SEND_WINDOW
+      if(s->flags & TCP_SOCKET_FLAGS_WINDOW) {
+        uip_tcp_window_enable(uip_conn);
+      }
+#endif /* UIP_TCP_SEND_WINDOW */
+#if UIP_TCP_RECEIVE_QUEUE
+      uip_tcp_receive_enable(uip_conn,
+                             (s->flags & TCP_SOCKET_FLAGS_REASS ?
+                              UIP_TCP_RECEIVE_REASS : 0) |
+                             (s->flags & TCP_SOCKET_FLAGS_DELACK ?
+                              UIP_TCP_RECEIVE_DELAYED_ACK : 0));
+#endif /* UIP_TCP_RECEIVE_QUEUE */
       if(uip_newdata()) {
         newdata(s);
       }
@@ -241,7 +297,9 @@ PROCESS_THREAD(tcp_socket_process, ev, data)
     PROCESS_WAIT_EVENT();
 
     if(ev == tcpip_event) {
+      in_appcall = 1;
       appcall(data);
+      in_appcall = 0;
     }
   }
   PROCESS_END();
@@ -357,7 +415,12 @@ tcp_socket_send(struct tcp_socket *s,
     s->output_senddata_len = s->output_data_len;
   }
 
-  tcpip_poll_tcp(s->c);
+  /* From a callback of the connection, the data is sent when the
+     callback returns. A poll for each call would fill the event
+     queue. */
+  if(!in_appcall || s->c != uip_conn) {
+    tcpip_poll_tcp(s->c);
+  }
 
   return len;
 }
@@ -407,3 +470,60 @@ tcp_socket_queuelen(struct tcp_socket *s)
   return s->output_data_len;
 }
 /*---------------------------------------------------------------------------*/
+int
+tcp_socket_set_window(struct tcp_socket *s, int enable)
+{
+#if UIP_TCP_SEND_WINDOW
+  if(s == NULL) {
+    return -1;
+  }
+
+  if(enable) {
+    s->flags |= TCP_SOCKET_FLAGS_WINDOW;
+  } else {
+    s->flags &= ~TCP_SOCKET_FLAGS_WINDOW;
+  }
+  return 1;
+#else /* UIP_TCP_SEND_WINDOW */
+  return -1;
+#endif /* UIP_TCP_SEND_WINDOW */
+}
+/*---------------------------------------------------------------------------*/
+int
+tcp_socket_set_receive_queue(struct tcp_socket *s, int enable)
+{
+#if UIP_TCP_RECEIVE_QUEUE
+  if(s == NULL) {
+    return -1;
+  }
+
+  if(enable) {
+    s->flags |= TCP_SOCKET_FLAGS_REASS;
+  } else {
+    s->flags &= ~TCP_SOCKET_FLAGS_REASS;
+  }
+  return 1;
+#else /* UIP_TCP_RECEIVE_QUEUE */
+  return -1;
+#endif /* UIP_TCP_RECEIVE_QUEUE */
+}
+/*---------------------------------------------------------------------------*/
+int
+tcp_socket_set_delayed_ack(struct tcp_socket *s, int enable)
+{
+#if UIP_TCP_RECEIVE_QUEUE
+  if(s == NULL) {
+    return -1;
+  }
+
+  if(enable) {
+    s->flags |= TCP_SOCKET_FLAGS_DELACK;
+  } else {
+    s->flags &= ~TCP_SOCKET_FLAGS_DELACK;
+  }
+  return 1;
+#else /* UIP_TCP_RECEIVE_QUEUE */
+  return -1;
+#endif /* UIP_TCP_RECEIVE_QUEUE */
+}
+/*---------------------------------------------------------------------------*/
@@ -109,6 +109,9 @@ enum {
   TCP_SOCKET_FLAGS_NONE      = 0x00,
   TCP_SOCKET_FLAGS_LISTENING = 0x01,
   TCP_SOCKET_FLAGS_CLOSING   = 0x02,
+  TCP_SOCKET_FLAGS_WINDOW    = 0x04,
+  TCP_SOCKET_FLAGS_REASS     = 0x08,
+  TCP_SOCKET_FLAGS_DELACK    = 0x10,
 };
 
 /**
@@ -296,4 +299,62 @@ int tcp_socket_max_sendlen(struct tcp_socket *s);
  */
 int tcp_socket_queuelen(struct tcp_socket *s);
 
+/**
+ * \brief      Let a TCP socket send several segments before they are acknowledged
+ * \param s    A pointer to a TCP socket
+ * \param enable Non-zero to use a send window, zero to send one segment at a time
+ * \retval -1  If the send window is not supported (UIP_CONF_TCP_SEND_WINDOW is zero)
+ * \retval 1   If the setting was changed
+ *
+ *             This function sets whether the next connections of
+ *             the socket keep up to UIP_CONF_TCP_SEND_WINDOW
+ *             segments in flight, with congestion control and fast
+ *             retransmit. The output buffer holds the data until it
+ *             is acknowledged, so it should be large enough for the
+ *             window. The function is called after
+ *             tcp_socket_register(), before the connection is
+ *             established.
+ *
+ */
+int tcp_socket_set_window(struct tcp_socket *s, int enable);
+
+/**
+ * \brief      Let a TCP socket keep the segments received after a lost segment
+ * \param s    A pointer to a TCP socket
+ * \param enable Non-zero to keep the segments, zero to drop them
+ * \retval -1  If the receive queue is not supported (UIP_CONF_TCP_RECEIVE_QUEUE is zero)
+ * \retval 1   If the setting was changed
+ *
+ *             This function sets whether the next connections of
+ *             the socket keep the segments that arrive out of order,
+ *             so that the remote host only needs to send the lost
+ *             segment again. The input callback gets the data in
+ *             order. The connections advertise a window of
+ *             UIP_CONF_TCP_RECEIVE_QUEUE + 1 segments. The function
+ *             is called after tcp_socket_register(), before the
+ *             connection is established.
+ *
+ */
+int tcp_socket_set_receive_queue(struct tcp_socket *s, int enable);
+
+/**
+ * \brief      Let a TCP socket delay its acknowledgements
+ * \param s    A pointer to a TCP socket
+ * \param enable Non-zero to delay the acknowledgements, zero to send them at once
+ * \retval -1  If delayed acknowledgements are not supported (UIP_CONF_TCP_RECEIVE_QUEUE is zero)
+ * \retval 1   If the setting was changed
+ *
+ *             This function sets whether the next connections of
+ *             the socket acknowledge every second segment, and the
+ *             others with the data sent in reply or after up to half
+ *             a second. It halves the acknowledgements of a bulk
+ *             transfer, but slows down a remote host that sends one
+ *             segment at a time, such as another uIP host without a
+ *             send window. The function is called after
+ *             tcp_socket_register(), before the connection is
+ *             established.
+ *
+ */
+int tcp_socket_set_delayed_ack(struct tcp_socket *s, int enable);
+
 #endif /* TCP_SOCKET_H */
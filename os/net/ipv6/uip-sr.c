@@ -248,6 +248,21 @@ uip_sr_free_all(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+uip_sr_free_graph(void *graph)
+{
+  uip_sr_node_t *l;
+  uip_sr_node_t *next;
+  for(l = list_head(nodelist); l != NULL; l = next) {
+    next = list_item_next(l);
+    if(l->graph == graph) {
+      list_remove(nodelist, l);
+      memb_free(&nodememb, l);
+      num_nodes--;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 int
 uip_sr_link_snprint(char *buf, int buflen, uip_sr_node_t *link)
 {
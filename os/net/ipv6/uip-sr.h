@@ -180,6 +180,13 @@ void uip_sr_init(void);
 */
 void uip_sr_free_all(void);
 
+/**
+ * Deallocate all nodes of a given graph
+ *
+ * \param graph The graph the nodes belong to
+*/
+void uip_sr_free_graph(void *graph);
+
 /**
 * Print a textual description of a source routing link
 *
@@ -825,6 +825,84 @@ void uip_send(const void *data, int len);
  */
 #define uip_mss()             (uip_conn->mss)
 
+#if UIP_TCP_SEND_WINDOW
+/**
+ * Let a connection send several segments before they are acknowledged.
+ *
+ * The connection sends up to UIP_TCP_SEND_WINDOW segments, limited by
+ * its congestion window and the window of the remote host. The
+ * application keeps the unacknowledged data in a buffer. When it is
+ * called, it sends the data that starts uip_outstanding(uip_conn)
+ * bytes into the buffer, one segment at a time, and removes
+ * uip_ackedlen() bytes from the start of the buffer when
+ * uip_acked() is set. To retransmit, uIP calls the application with
+ * uip_rexmit() set and uip_outstanding(uip_conn) reduced, so the
+ * same rule gives the data to send again. The application polls the
+ * connection with tcpip_poll_tcp() to send the next segment.
+ *
+ * This function is called when the connection is established.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ */
+void uip_tcp_window_enable(struct uip_conn *conn);
+
+/**
+ * Check if a connection sends several segments before they are
+ * acknowledged.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ *
+ * \hideinitializer
+ */
+#define uip_tcp_window_enabled(conn) ((conn)->window & UIP_TCP_WINDOW_ENABLED)
+
+/**
+ * The number of bytes acknowledged by the remote host, when
+ * uip_acked() is set on a connection with a send window.
+ *
+ * \hideinitializer
+ */
+#define uip_ackedlen()        uip_acked_len
+
+extern uint16_t uip_acked_len;
+#endif /* UIP_TCP_SEND_WINDOW */
+
+#if UIP_TCP_RECEIVE_QUEUE
+/**
+ * Change how a connection receives data.
+ *
+ * With UIP_TCP_RECEIVE_REASS, the segments that arrive after a lost
+ * segment are kept, up to UIP_TCP_RECEIVE_QUEUE segments for all
+ * connections, and the application is called with each of them, in
+ * order, once the lost segment has arrived. The connection then
+ * advertises a window of UIP_TCP_RECEIVE_QUEUE + 1 segments.
+ *
+ * With UIP_TCP_RECEIVE_DELAYED_ACK, a segment is acknowledged with
+ * the next one, with the data that the application sends, or by the
+ * periodic timer, whichever comes first (RFC 1122). Segments that
+ * arrive out of order, or that fill a gap, are acknowledged at once.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ * \param flags UIP_TCP_RECEIVE_REASS and UIP_TCP_RECEIVE_DELAYED_ACK,
+ * or zero for the default behavior.
+ */
+void uip_tcp_receive_enable(struct uip_conn *conn, uint8_t flags);
+
+/**
+ * Limit the window advertised by a connection.
+ *
+ * An application that keeps the data it receives sets the limit to
+ * the free space of its buffer, each time that it changes. Zero
+ * removes the limit.
+ *
+ * \param conn A pointer to the uip_conn structure for the connection.
+ * \param wnd The largest window to advertise, in bytes.
+ *
+ * \hideinitializer
+ */
+#define uip_tcp_receive_window(conn, wnd) ((conn)->rcv_wnd = (wnd))
+#endif /* UIP_TCP_RECEIVE_QUEUE */
+
 /**
  * Set up a new UDP connection.
  *
@@ -1341,9 +1419,35 @@ struct uip_conn {
   uint8_t timer;         /**< The retransmission timer. */
   uint8_t nrtx;          /**< The number of retransmissions for the last
                               segment sent. */
+#if UIP_TCP_SEND_WINDOW
+  uint16_t high;         /**< Length of the data sent after snd_nxt,
+                              including the data to be sent again. */
+  uint16_t cwnd;         /**< Congestion window, in bytes. */
+  uint16_t ssthresh;     /**< Slow start threshold, in bytes. */
+  uint16_t snd_wnd;      /**< Window advertised by the remote host. */
+  uint16_t recover;      /**< Length of the data to be acknowledged
+                              before fast recovery ends. */
+  uint8_t dupacks;       /**< Number of duplicate acknowledgements. */
+  uint8_t window;        /**< Send window flags. */
+#endif /* UIP_TCP_SEND_WINDOW */
+#if UIP_TCP_RECEIVE_QUEUE
+  uint16_t rcv_wnd;      /**< Largest window advertised, or zero. */
+  uint8_t receive;       /**< Receive flags. */
+#endif /* UIP_TCP_RECEIVE_QUEUE */
   uip_tcp_appstate_t appstate; /** The application state. */
 };
 
+#if UIP_TCP_SEND_WINDOW
+#define UIP_TCP_WINDOW_ENABLED  0x01 /**< Several segments can be in flight. */
+#define UIP_TCP_WINDOW_RECOVERY 0x02 /**< In fast recovery. */
+#endif /* UIP_TCP_SEND_WINDOW */
+
+#if UIP_TCP_RECEIVE_QUEUE
+#define UIP_TCP_RECEIVE_REASS       0x01 /**< Keeps out of order segments. */
+#define UIP_TCP_RECEIVE_DELAYED_ACK 0x02 /**< Delays acknowledgements. */
+#define UIP_TCP_RECEIVE_ACK_PENDING 0x04 /**< A segment is not acknowledged. */
+#endif /* UIP_TCP_RECEIVE_QUEUE */
+
 
 /**
  * Pointer to the current TCP connection.
@@ -1377,6 +1481,7 @@ struct uip_udp_conn {
   uint16_t lport;        /**< The local port number in network byte order. */
   uint16_t rport;        /**< The remote port number in network byte order. */
   uint8_t  ttl;          /**< Default time-to-live. */
+  uint8_t  tc;           /**< Traffic class (DSCP and ECN), 0 by default. */
   /** The application state. */
   uip_udp_appstate_t appstate;
 };
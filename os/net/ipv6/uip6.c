@@ -157,6 +157,11 @@ uint16_t uip_urglen, uip_surglen;
 
 /* The uip_len is either 8 or 16 bits, depending on the maximum packet size.*/
 uint16_t uip_len, uip_slen;
+
+#if UIP_TCP_SEND_WINDOW
+/* The number of bytes acknowledged on a connection with a send window */
+uint16_t uip_acked_len;
+#endif /* UIP_TCP_SEND_WINDOW */
 /** @} */
 
 /*---------------------------------------------------------------------------*/
@@ -477,6 +482,13 @@ uip_connect(const uip_ipaddr_t *ripaddr, uint16_t rport)
 
   conn->len = 1;   /* TCP length of the SYN is one. */
   conn->nrtx = 0;
+#if UIP_TCP_SEND_WINDOW
+  conn->window = 0;
+#endif /* UIP_TCP_SEND_WINDOW */
+#if UIP_TCP_RECEIVE_QUEUE
+  conn->receive = 0;
+  conn->rcv_wnd = 0;
+#endif /* UIP_TCP_RECEIVE_QUEUE */
   conn->timer = 1; /* Send the SYN next time around. */
   conn->rto = UIP_RTO;
   conn->sa = 0;
@@ -558,6 +570,7 @@ uip_udp_new(const uip_ipaddr_t *ripaddr, uint16_t rport)
     uip_ipaddr_copy(&conn->ripaddr, ripaddr);
   }
   conn->ttl = uip_ds6_if.cur_hop_limit;
+  conn->tc = 0;
 
   return conn;
 }
@@ -813,6 +826,410 @@ uip_add_rcv_nxt(uint16_t n)
   uip_conn->rcv_nxt[2] = uip_acc32[2];
   uip_conn->rcv_nxt[3] = uip_acc32[3];
 }
+/*---------------------------------------------------------------------------*/
+static void
+update_rto(struct uip_conn *conn)
+{
+  signed char m;
+  m = conn->rto - conn->timer;
+  /* This is taken directly from VJs original code in his paper */
+  m = m - (conn->sa >> 3);
+  conn->sa += m;
+  if(m < 0) {
+    m = -m;
+  }
+  m = m - (conn->sv >> 2);
+  conn->sv += m;
+  conn->rto = (conn->sa >> 3) + conn->sv;
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_SEND_WINDOW || UIP_TCP_RECEIVE_QUEUE
+static uint32_t
+seq32(const uint8_t *seq)
+{
+  return ((uint32_t)seq[0] << 24) | ((uint32_t)seq[1] << 16) |
+    ((uint32_t)seq[2] << 8) | seq[3];
+}
+#endif /* UIP_TCP_SEND_WINDOW || UIP_TCP_RECEIVE_QUEUE */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_SEND_WINDOW
+static uint16_t
+window_max(struct uip_conn *conn)
+{
+  uint32_t max = (uint32_t)UIP_TCP_SEND_WINDOW * conn->initialmss;
+
+  return max > 0xffff ? 0xffff : max;
+}
+/*---------------------------------------------------------------------------*/
+/* The number of bytes that the connection can send now */
+static uint16_t
+window_room(struct uip_conn *conn)
+{
+  uint32_t wnd;
+
+  if(!uip_tcp_window_enabled(conn)) {
+    return 0;
+  }
+  if(conn->len == 0) {
+    /* One segment can always be sent. If the remote host has a zero
+       window, the segment probes it, as with a single segment. */
+    return conn->mss;
+  }
+  wnd = conn->cwnd;
+  if(!(conn->window & UIP_TCP_WINDOW_RECOVERY)) {
+    /* Limited transmit (RFC 3042): a new segment for each of the
+       first duplicate acknowledgements keeps them coming */
+    wnd += (uint32_t)conn->dupacks * conn->mss;
+  }
+  wnd = MIN(wnd, conn->snd_wnd);
+  /* Only whole segments are sent while data is in flight */
+  return wnd >= (uint32_t)conn->len + conn->mss ? wnd - conn->len : 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_tcp_window_enable(struct uip_conn *conn)
+{
+  conn->window = UIP_TCP_WINDOW_ENABLED;
+  /* The initial window of RFC 5681 */
+  if(conn->mss > 2190) {
+    conn->cwnd = 2 * conn->mss;
+  } else if(conn->mss > 1095) {
+    conn->cwnd = 3 * conn->mss;
+  } else {
+    conn->cwnd = 4 * conn->mss;
+  }
+  conn->cwnd = MIN(conn->cwnd, window_max(conn));
+  conn->ssthresh = window_max(conn);
+  /* Updated by the next segment from the remote host */
+  conn->snd_wnd = conn->mss;
+  conn->high = 0;
+  conn->recover = 0;
+  conn->dupacks = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Sets the slow start threshold to half the data in flight */
+static void
+window_loss(struct uip_conn *conn)
+{
+  conn->ssthresh = MAX(conn->len / 2, 2 * conn->mss);
+}
+/*---------------------------------------------------------------------------*/
+/* Handles an acknowledgement on a connection with a send window, in
+   the ESTABLISHED state. Sets uip_flags to UIP_ACKDATA if data was
+   acknowledged, to UIP_REXMIT to send the first unacknowledged
+   segment again, and to UIP_POLL if more data can be sent. */
+static void
+window_ack(struct uip_conn *conn)
+{
+  uint32_t acked;
+  uint16_t wnd;
+
+  acked = seq32(UIP_TCP_BUF->ackno) - seq32(conn->snd_nxt);
+  wnd = ((uint16_t)UIP_TCP_BUF->wnd[0] << 8) + UIP_TCP_BUF->wnd[1];
+
+  if(acked == 0) {
+    if(uip_len == 0 && wnd == conn->snd_wnd &&
+       (UIP_TCP_BUF->flags & (TCP_SYN | TCP_FIN)) == 0) {
+      /* A duplicate acknowledgement: a later segment has arrived */
+      if(conn->window & UIP_TCP_WINDOW_RECOVERY) {
+        conn->cwnd = MIN(conn->cwnd + conn->mss, window_max(conn));
+      } else if(++conn->dupacks == 3) {
+        /* Fast retransmit */
+        window_loss(conn);
+        conn->cwnd = MIN(conn->ssthresh + 3 * conn->mss, window_max(conn));
+        conn->recover = conn->high;
+        conn->window |= UIP_TCP_WINDOW_RECOVERY;
+        UIP_STAT(++uip_stat.tcp.rexmit);
+        uip_flags = UIP_REXMIT;
+        return;
+      }
+    }
+    conn->snd_wnd = wnd;
+    if(window_room(conn) > 0) {
+      uip_flags = UIP_POLL;
+    }
+    return;
+  }
+
+  if(acked > conn->high) {
+    /* Acknowledges data that was not sent */
+    return;
+  }
+
+  uip_add32(conn->snd_nxt, acked);
+  conn->snd_nxt[0] = uip_acc32[0];
+  conn->snd_nxt[1] = uip_acc32[1];
+  conn->snd_nxt[2] = uip_acc32[2];
+  conn->snd_nxt[3] = uip_acc32[3];
+
+  if(conn->nrtx == 0) {
+    update_rto(conn);
+  }
+  conn->nrtx = 0;
+  conn->timer = conn->rto;
+  conn->len = conn->len > acked ? conn->len - acked : 0;
+  conn->high -= acked;
+  conn->snd_wnd = wnd;
+  conn->dupacks = 0;
+  uip_acked_len = acked;
+  uip_flags = UIP_ACKDATA;
+
+  if(conn->window & UIP_TCP_WINDOW_RECOVERY) {
+    if(acked >= conn->recover) {
+      /* All the data sent before the loss is acknowledged */
+      conn->cwnd = MIN(conn->ssthresh, MAX(conn->len, conn->mss) + conn->mss);
+      conn->window &= ~UIP_TCP_WINDOW_RECOVERY;
+    } else {
+      /* A partial acknowledgement: the next segment was lost too */
+      conn->recover -= acked;
+      conn->cwnd = (conn->cwnd > acked ? conn->cwnd - acked : 0) + conn->mss;
+      UIP_STAT(++uip_stat.tcp.rexmit);
+      uip_flags |= UIP_REXMIT;
+    }
+  } else if(conn->cwnd < conn->ssthresh) {
+    /* Slow start */
+    conn->cwnd += MIN(acked, conn->mss);
+  } else {
+    /* Congestion avoidance */
+    conn->cwnd += MAX((uint32_t)conn->mss * conn->mss / conn->cwnd, 1);
+  }
+  conn->cwnd = MIN(conn->cwnd, window_max(conn));
+}
+/*---------------------------------------------------------------------------*/
+/* Fits the data from the application into the window. Returns the
+   offset of the data from snd_nxt. */
+static uint16_t
+window_output(struct uip_conn *conn, uint16_t rexmit_len)
+{
+  uint16_t offset;
+  uint16_t room;
+
+  if(uip_slen > conn->mss) {
+    uip_slen = conn->mss;
+  }
+  if(rexmit_len > 0) {
+    /* The first unacknowledged segment is sent again */
+    conn->len = rexmit_len;
+    if(uip_slen > rexmit_len) {
+      uip_slen = rexmit_len;
+    }
+    return 0;
+  }
+  room = window_room(conn);
+  if(uip_slen > room) {
+    uip_slen = room;
+  }
+  offset = conn->len;
+  conn->len += uip_slen;
+  if(conn->high < conn->len) {
+    conn->high = conn->len;
+  }
+  return offset;
+}
+/*---------------------------------------------------------------------------*/
+/* Goes back to the first unacknowledged byte after a timeout */
+static void
+window_timeout(struct uip_conn *conn)
+{
+  window_loss(conn);
+  conn->cwnd = conn->mss;
+  conn->len = 0;
+  conn->dupacks = 0;
+  conn->window &= ~UIP_TCP_WINDOW_RECOVERY;
+}
+#else /* UIP_TCP_SEND_WINDOW */
+#define window_room(conn) 0
+#endif /* UIP_TCP_SEND_WINDOW */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_RECEIVE_QUEUE
+/* A segment that arrived after a lost segment */
+struct tcp_segment {
+  struct uip_conn *conn;
+  uint32_t seqno;
+  uint16_t len;
+  uint8_t data[UIP_TCP_MSS];
+};
+
+static struct tcp_segment receive_queue[UIP_TCP_RECEIVE_QUEUE];
+
+/* Set when the segment passed to the application filled a gap */
+static uint8_t receive_filled;
+/*---------------------------------------------------------------------------*/
+static void
+receive_flush(struct uip_conn *conn)
+{
+  uint8_t i;
+
+  for(i = 0; i < UIP_TCP_RECEIVE_QUEUE; i++) {
+    if(receive_queue[i].conn == conn) {
+      receive_queue[i].conn = NULL;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_tcp_receive_enable(struct uip_conn *conn, uint8_t flags)
+{
+  if((flags ^ conn->receive) & UIP_TCP_RECEIVE_REASS) {
+    /* Segments that an earlier connection kept, or that are no
+       longer wanted */
+    receive_flush(conn);
+  }
+  conn->receive = (conn->receive & UIP_TCP_RECEIVE_ACK_PENDING) |
+    (flags & (UIP_TCP_RECEIVE_REASS | UIP_TCP_RECEIVE_DELAYED_ACK));
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+receive_window(struct uip_conn *conn)
+{
+  uint32_t wnd = UIP_RECEIVE_WINDOW;
+
+  if(conn->receive & UIP_TCP_RECEIVE_REASS) {
+    wnd = MAX(wnd, (uint32_t)(UIP_TCP_RECEIVE_QUEUE + 1) * UIP_TCP_MSS);
+    wnd = MIN(wnd, 0xffff);
+  }
+  if(conn->rcv_wnd > 0 && wnd > conn->rcv_wnd) {
+    wnd = conn->rcv_wnd;
+  }
+  return wnd;
+}
+/*---------------------------------------------------------------------------*/
+/* Keeps the incoming segment, which is not the next one expected */
+static void
+receive_enqueue(struct uip_conn *conn)
+{
+  struct tcp_segment *free = NULL;
+  uint32_t seqno;
+  uint32_t offset;
+  uint8_t i;
+
+  if(!(conn->receive & UIP_TCP_RECEIVE_REASS) ||
+     (conn->tcpstateflags & UIP_TS_MASK) != UIP_ESTABLISHED ||
+     (conn->tcpstateflags & UIP_STOPPED) ||
+     uip_len == 0 || uip_len > UIP_TCP_MSS ||
+     (UIP_TCP_BUF->flags & (TCP_SYN | TCP_FIN | TCP_URG)) != 0) {
+    return;
+  }
+
+  /* Only a segment that is within the window, after the next one */
+  seqno = seq32(UIP_TCP_BUF->seqno);
+  offset = seqno - seq32(conn->rcv_nxt);
+  if(offset == 0 || offset >= 0x80000000 ||
+     offset + uip_len > receive_window(conn)) {
+    return;
+  }
+
+  for(i = 0; i < UIP_TCP_RECEIVE_QUEUE; i++) {
+    if(receive_queue[i].conn == conn) {
+      if(receive_queue[i].seqno == seqno) {
+        /* Already kept */
+        return;
+      }
+    } else if(free == NULL &&
+              (receive_queue[i].conn == NULL ||
+               (receive_queue[i].conn->tcpstateflags & UIP_TS_MASK) !=
+               UIP_ESTABLISHED ||
+               !(receive_queue[i].conn->receive & UIP_TCP_RECEIVE_REASS))) {
+      /* Unused, or left by a connection that no longer wants it */
+      free = &receive_queue[i];
+    }
+  }
+  if(free == NULL) {
+    return;
+  }
+
+  free->conn = conn;
+  free->seqno = seqno;
+  free->len = uip_len;
+  memcpy(free->data, uip_appdata, uip_len);
+}
+/*---------------------------------------------------------------------------*/
+/* Replaces the data passed to the application with the next data kept
+   for the connection, if any. Returns non-zero if there is such
+   data. */
+static uint8_t
+receive_dequeue(struct uip_conn *conn)
+{
+  struct tcp_segment *seg;
+  uint32_t rcv_nxt;
+  uint32_t offset;
+  uint8_t found;
+  uint8_t i;
+
+  if(!(conn->receive & UIP_TCP_RECEIVE_REASS) ||
+     (conn->tcpstateflags & UIP_STOPPED)) {
+    return 0;
+  }
+
+  rcv_nxt = seq32(conn->rcv_nxt);
+  found = 0;
+  for(i = 0; i < UIP_TCP_RECEIVE_QUEUE; i++) {
+    seg = &receive_queue[i];
+    if(seg->conn != conn) {
+      continue;
+    }
+    offset = rcv_nxt - seg->seqno;
+    if(offset < 0x80000000 && offset >= seg->len) {
+      /* The data has been received since */
+      seg->conn = NULL;
+    } else if(offset < 0x80000000 && !found) {
+      /* The segment starts at or before the next byte expected */
+      found = 1;
+      uip_len = seg->len - offset;
+      uip_appdata = uip_sappdata;
+      memcpy(uip_appdata, &seg->data[offset], uip_len);
+      uip_add_rcv_nxt(uip_len);
+      seg->conn = NULL;
+    }
+  }
+  if(!found) {
+    return 0;
+  }
+
+  if(uip_flags & UIP_ACKDATA) {
+#if UIP_TCP_SEND_WINDOW
+    if(!uip_tcp_window_enabled(conn))
+#endif /* UIP_TCP_SEND_WINDOW */
+    {
+      /* The application has been told: the data in flight is gone */
+      conn->len = 0;
+    }
+  }
+  uip_flags = UIP_NEWDATA;
+  receive_filled = 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if the acknowledgement of the new data can wait */
+static uint8_t
+receive_ack_delayed(struct uip_conn *conn)
+{
+  uint8_t i;
+
+  if(!(uip_flags & UIP_NEWDATA) ||
+     !(conn->receive & UIP_TCP_RECEIVE_DELAYED_ACK) ||
+     (conn->receive & UIP_TCP_RECEIVE_ACK_PENDING) ||
+     receive_filled) {
+    /* At least every second segment is acknowledged at once, and a
+       segment that fills a gap */
+    return 0;
+  }
+  if(conn->receive & UIP_TCP_RECEIVE_REASS) {
+    for(i = 0; i < UIP_TCP_RECEIVE_QUEUE; i++) {
+      if(receive_queue[i].conn == conn) {
+        /* There is still a gap */
+        return 0;
+      }
+    }
+  }
+  conn->receive |= UIP_TCP_RECEIVE_ACK_PENDING;
+  return 1;
+}
+#define ack_pending(conn) ((conn)->receive & UIP_TCP_RECEIVE_ACK_PENDING)
+#else /* UIP_TCP_RECEIVE_QUEUE */
+#define receive_window(conn) (UIP_RECEIVE_WINDOW)
+#define ack_pending(conn) 0
+#endif /* UIP_TCP_RECEIVE_QUEUE */
 #endif
 /*---------------------------------------------------------------------------*/
 
@@ -956,6 +1373,10 @@ uip_process(uint8_t flag)
   uint16_t tmp16;
   uint8_t opt;
   register struct uip_conn *uip_connr = uip_conn;
+#if UIP_TCP_SEND_WINDOW
+  uint16_t snd_off = 0;
+  uint16_t rexmit_len = 0;
+#endif /* UIP_TCP_SEND_WINDOW */
 #endif /* UIP_TCP */
 #if UIP_UDP
   if(flag == UIP_UDP_SEND_CONN) {
@@ -969,7 +1390,9 @@ uip_process(uint8_t flag)
   if(flag == UIP_POLL_REQUEST) {
 #if UIP_TCP
     if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
-       !uip_outstanding(uip_connr)) {
+       (!uip_outstanding(uip_connr) || window_room(uip_connr) > 0)) {
+      /* Forget the data of the last segment sent */
+      uip_slen = 0;
       uip_flags = UIP_POLL;
       UIP_APPCALL();
       goto appsend;
@@ -1065,6 +1488,19 @@ uip_process(uint8_t flag)
 #endif /* UIP_ACTIVE_OPEN */
 
           case UIP_ESTABLISHED:
+#if UIP_TCP_SEND_WINDOW
+            if(uip_tcp_window_enabled(uip_connr)) {
+              /*
+               * With a send window, the application sends the data
+               * again from the first unacknowledged byte, one segment
+               * at a time, as new data.
+               */
+              window_timeout(uip_connr);
+              uip_flags = UIP_REXMIT;
+              UIP_APPCALL();
+              goto appsend;
+            }
+#endif /* UIP_TCP_SEND_WINDOW */
             /*
              * In the ESTABLISHED state, we call upon the application
              * to do the actual retransmit after which we jump into
@@ -1082,6 +1518,15 @@ uip_process(uint8_t flag)
             goto tcp_send_finack;
           }
         }
+#if UIP_TCP_SEND_WINDOW
+        if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
+           window_room(uip_connr) > 0) {
+          /* The window has room for more data */
+          uip_flags = UIP_POLL;
+          UIP_APPCALL();
+          goto appsend;
+        }
+#endif /* UIP_TCP_SEND_WINDOW */
       } else if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
         /*
          * If there was no need for a retransmission, we poll the
@@ -1091,6 +1536,10 @@ uip_process(uint8_t flag)
         UIP_APPCALL();
         goto appsend;
       }
+      if(ack_pending(uip_connr)) {
+        /* A delayed acknowledgement */
+        goto tcp_send_ack;
+      }
     }
     goto drop;
 #endif /* UIP_TCP */
@@ -1572,8 +2021,8 @@ uip_process(uint8_t flag)
      length. */
   uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
 
-  UIP_IP_BUF->vtc = 0x60;
-  UIP_IP_BUF->tcflow = 0x00;
+  UIP_IP_BUF->vtc = 0x60 | (uip_udp_conn->tc >> 4);
+  UIP_IP_BUF->tcflow = uip_udp_conn->tc << 4;
   UIP_IP_BUF->ttl = uip_udp_conn->ttl;
   UIP_IP_BUF->proto = UIP_PROTO_UDP;
 
@@ -1748,6 +2197,13 @@ uip_process(uint8_t flag)
   uip_connr->sa = 0;
   uip_connr->sv = 4;
   uip_connr->nrtx = 0;
+#if UIP_TCP_SEND_WINDOW
+  uip_connr->window = 0;
+#endif /* UIP_TCP_SEND_WINDOW */
+#if UIP_TCP_RECEIVE_QUEUE
+  uip_connr->receive = 0;
+  uip_connr->rcv_wnd = 0;
+#endif /* UIP_TCP_RECEIVE_QUEUE */
   uip_connr->lport = UIP_TCP_BUF->destport;
   uip_connr->rport = UIP_TCP_BUF->srcport;
   uip_ipaddr_copy(&uip_connr->ripaddr, &UIP_IP_BUF->srcipaddr);
@@ -1878,6 +2334,9 @@ uip_process(uint8_t flag)
 #endif
         }
       }
+#if UIP_TCP_RECEIVE_QUEUE
+      receive_enqueue(uip_connr);
+#endif /* UIP_TCP_RECEIVE_QUEUE */
       goto tcp_send_ack;
     }
   }
@@ -1886,6 +2345,15 @@ uip_process(uint8_t flag)
      data. If so, we update the sequence number, reset the length of
      the outstanding data, calculate RTT estimations, and reset the
      retransmission timer. */
+#if UIP_TCP_SEND_WINDOW
+  if(uip_tcp_window_enabled(uip_connr) &&
+     (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+    /* Several segments may be in flight */
+    if((UIP_TCP_BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
+      window_ack(uip_connr);
+    }
+  } else
+#endif /* UIP_TCP_SEND_WINDOW */
   if((UIP_TCP_BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
     uip_add32(uip_connr->snd_nxt, uip_connr->len);
 
@@ -1901,18 +2369,7 @@ uip_process(uint8_t flag)
 
       /* Do RTT estimation, unless we have done retransmissions. */
       if(uip_connr->nrtx == 0) {
-        signed char m;
-        m = uip_connr->rto - uip_connr->timer;
-        /* This is taken directly from VJs original code in his paper */
-        m = m - (uip_connr->sa >> 3);
-        uip_connr->sa += m;
-        if(m < 0) {
-          m = -m;
-        }
-        m = m - (uip_connr->sv >> 2);
-        uip_connr->sv += m;
-        uip_connr->rto = (uip_connr->sa >> 3) + uip_connr->sv;
-
+        update_rto(uip_connr);
       }
       /* Set the acknowledged flag. */
       uip_flags = UIP_ACKDATA;
@@ -2093,6 +2550,9 @@ uip_process(uint8_t flag)
          "persistent timer" and uses the retransmission mechanim.
      */
     tmp16 = ((uint16_t)UIP_TCP_BUF->wnd[0] << 8) + (uint16_t)UIP_TCP_BUF->wnd[1];
+#if UIP_TCP_SEND_WINDOW
+    uip_connr->snd_wnd = tmp16;
+#endif /* UIP_TCP_SEND_WINDOW */
     if(tmp16 > uip_connr->initialmss ||
         tmp16 == 0) {
       tmp16 = uip_connr->initialmss;
@@ -2114,10 +2574,33 @@ uip_process(uint8_t flag)
          If the application wishes to send any data, this data should be
          put into the uip_appdata and the length of the data should be
          put into uip_len. If the application don't have any data to
-         send, uip_len must be set to 0. */
-    if(uip_flags & (UIP_NEWDATA | UIP_ACKDATA)) {
+         send, uip_len must be set to 0.
+
+         With a send window, the application is also called to send
+         the first unacknowledged segment again (UIP_REXMIT), or to send
+         more data when the window has grown (UIP_POLL). For a
+         retransmission, the length of the outstanding data is zero
+         while the application is called. */
+    if(uip_flags & (UIP_NEWDATA | UIP_ACKDATA | UIP_REXMIT | UIP_POLL)) {
       uip_slen = 0;
+#if UIP_TCP_SEND_WINDOW
+      if(uip_flags & UIP_REXMIT) {
+        rexmit_len = uip_connr->len;
+        uip_connr->len = 0;
+      }
+#endif /* UIP_TCP_SEND_WINDOW */
       UIP_APPCALL();
+#if UIP_TCP_RECEIVE_QUEUE
+      /* The segments kept after a gap that the new data has filled
+         are passed to the application in the same way, as long as it
+         has nothing to send. The others wait for the next call. */
+      receive_filled = 0;
+      while((uip_flags & UIP_NEWDATA) && uip_slen == 0 &&
+            (uip_flags & (UIP_ABORT | UIP_CLOSE)) == 0 &&
+            receive_dequeue(uip_connr)) {
+        UIP_APPCALL();
+      }
+#endif /* UIP_TCP_RECEIVE_QUEUE */
 
       appsend:
 
@@ -2137,6 +2620,11 @@ uip_process(uint8_t flag)
         goto tcp_send_nodata;
       }
 
+#if UIP_TCP_SEND_WINDOW
+      if(uip_tcp_window_enabled(uip_connr)) {
+        snd_off = window_output(uip_connr, rexmit_len);
+      } else
+#endif /* UIP_TCP_SEND_WINDOW */
       /* If uip_slen > 0, the application has data to be sent. */
       if(uip_slen > 0) {
 
@@ -2169,6 +2657,10 @@ uip_process(uint8_t flag)
           uip_slen = uip_connr->len;
         }
       }
+#if UIP_TCP_SEND_WINDOW
+      /* With a send window, acknowledgements reset the count. */
+      if(!uip_tcp_window_enabled(uip_connr))
+#endif /* UIP_TCP_SEND_WINDOW */
       uip_connr->nrtx = 0;
       apprexmit:
       uip_appdata = uip_sappdata;
@@ -2178,14 +2670,24 @@ uip_process(uint8_t flag)
       if(uip_slen > 0 && uip_connr->len > 0) {
         /* Add the length of the IP and TCP headers. */
         uip_len = uip_connr->len + UIP_IPTCPH_LEN;
+#if UIP_TCP_SEND_WINDOW
+        if(uip_tcp_window_enabled(uip_connr)) {
+          uip_len = uip_slen + UIP_IPTCPH_LEN;
+        }
+#endif /* UIP_TCP_SEND_WINDOW */
         /* We always set the ACK flag in response packets. */
         UIP_TCP_BUF->flags = TCP_ACK | TCP_PSH;
         /* Send the packet. */
         goto tcp_send_noopts;
       }
       /* If there is no data to send, just send out a pure ACK if
-           there is newdata. */
-      if(uip_flags & UIP_NEWDATA) {
+           there is newdata, unless the acknowledgement is delayed. */
+#if UIP_TCP_RECEIVE_QUEUE
+      if(receive_ack_delayed(uip_connr)) {
+        goto drop;
+      }
+#endif /* UIP_TCP_RECEIVE_QUEUE */
+      if((uip_flags & UIP_NEWDATA) || ack_pending(uip_connr)) {
         uip_len = UIP_IPTCPH_LEN;
         UIP_TCP_BUF->flags = TCP_ACK;
         goto tcp_send_noopts;
@@ -2281,11 +2783,24 @@ uip_process(uint8_t flag)
   UIP_TCP_BUF->ackno[1] = uip_connr->rcv_nxt[1];
   UIP_TCP_BUF->ackno[2] = uip_connr->rcv_nxt[2];
   UIP_TCP_BUF->ackno[3] = uip_connr->rcv_nxt[3];
+#if UIP_TCP_RECEIVE_QUEUE
+  uip_connr->receive &= ~UIP_TCP_RECEIVE_ACK_PENDING;
+#endif /* UIP_TCP_RECEIVE_QUEUE */
 
   UIP_TCP_BUF->seqno[0] = uip_connr->snd_nxt[0];
   UIP_TCP_BUF->seqno[1] = uip_connr->snd_nxt[1];
   UIP_TCP_BUF->seqno[2] = uip_connr->snd_nxt[2];
   UIP_TCP_BUF->seqno[3] = uip_connr->snd_nxt[3];
+#if UIP_TCP_SEND_WINDOW
+  if(snd_off > 0) {
+    /* A segment that follows other segments in flight */
+    uip_add32(uip_connr->snd_nxt, snd_off);
+    UIP_TCP_BUF->seqno[0] = uip_acc32[0];
+    UIP_TCP_BUF->seqno[1] = uip_acc32[1];
+    UIP_TCP_BUF->seqno[2] = uip_acc32[2];
+    UIP_TCP_BUF->seqno[3] = uip_acc32[3];
+  }
+#endif /* UIP_TCP_SEND_WINDOW */
 
   UIP_TCP_BUF->srcport  = uip_connr->lport;
   UIP_TCP_BUF->destport = uip_connr->rport;
@@ -2306,8 +2821,9 @@ uip_process(uint8_t flag)
        window so that the remote host will stop sending data. */
     UIP_TCP_BUF->wnd[0] = UIP_TCP_BUF->wnd[1] = 0;
   } else {
-    UIP_TCP_BUF->wnd[0] = ((UIP_RECEIVE_WINDOW) >> 8);
-    UIP_TCP_BUF->wnd[1] = ((UIP_RECEIVE_WINDOW) & 0xff);
+    tmp16 = receive_window(uip_connr);
+    UIP_TCP_BUF->wnd[0] = (tmp16 >> 8);
+    UIP_TCP_BUF->wnd[1] = (tmp16 & 0xff);
   }
 
   tcp_send_noconn:
@@ -440,6 +440,44 @@ void uip_log(char *msg);
 #define UIP_RECEIVE_WINDOW (UIP_CONF_RECEIVE_WINDOW)
 #endif
 
+/**
+ * The maximum number of unacknowledged TCP segments of a connection.
+ *
+ * If non-zero, an application can let a connection send this many
+ * segments before they are acknowledged, with
+ * uip_tcp_window_enable(). The connection then uses slow start,
+ * congestion avoidance and fast retransmit with NewReno
+ * recovery. Other connections send one segment at a time. If zero,
+ * the support is not compiled in.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SEND_WINDOW
+#define UIP_TCP_SEND_WINDOW (UIP_CONF_TCP_SEND_WINDOW)
+#else
+#define UIP_TCP_SEND_WINDOW 0
+#endif
+
+/**
+ * The number of TCP segments that can be held after a lost segment.
+ *
+ * If non-zero, a connection on which the application has called
+ * uip_tcp_receive_enable() keeps the segments that arrive out of
+ * order, and passes them to the application when the missing segment
+ * arrives. The segments of all connections share this number of
+ * buffers of UIP_TCP_MSS bytes. Such a connection can also delay its
+ * acknowledgements, and advertises a window of one segment for each
+ * buffer in addition to the next one. If zero, the support is not
+ * compiled in.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_RECEIVE_QUEUE
+#define UIP_TCP_RECEIVE_QUEUE (UIP_CONF_TCP_RECEIVE_QUEUE)
+#else
+#define UIP_TCP_RECEIVE_QUEUE 0
+#endif
+
 /**
  * How long a connection should stay in the TIME_WAIT state.
  *
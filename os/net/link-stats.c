@@ -80,6 +80,13 @@ link_stats_from_lladdr(const linkaddr_t *lladdr)
   return nbr_table_get_from_lladdr(link_stats, lladdr);
 }
 /*---------------------------------------------------------------------------*/
+/* Returns the link stats of the neighbor of an item of another table */
+const struct link_stats *
+link_stats_from_nbr_item(nbr_table_t *table, const void *item)
+{
+  return nbr_table_get_from_item(link_stats, table, item);
+}
+/*---------------------------------------------------------------------------*/
 /* Returns the neighbor's address given a link stats item */
 const linkaddr_t *
 link_stats_get_lladdr(const struct link_stats *stat)
@@ -34,6 +34,7 @@
 #define LINK_STATS_H_
 
 #include "net/linkaddr.h"
+#include "net/nbr-table.h"
 
 /* ETX fixed point divisor. 128 is the value used by RPL (RFC 6551 and RFC 6719) */
 #ifdef LINK_STATS_CONF_ETX_DIVISOR
@@ -96,6 +97,9 @@ struct link_stats {
 
 /* Returns the neighbor's link statistics */
 const struct link_stats *link_stats_from_lladdr(const linkaddr_t *lladdr);
+/* Returns the link statistics of the neighbor of an item of another
+   neighbor table, without an address lookup */
+const struct link_stats *link_stats_from_nbr_item(nbr_table_t *table, const void *item);
 /* Returns the address of the neighbor */
 const linkaddr_t *link_stats_get_lladdr(const struct link_stats *);
 /* Are the statistics fresh? */
@@ -51,6 +51,9 @@
 #include "lib/list.h"
 #include "lib/memb.h"
 #include "lib/assert.h"
+#if NETSTACK_CONF_WITH_IPV6
+#include "net/ipv6/sicslowpan.h"
+#endif /* NETSTACK_CONF_WITH_IPV6 */
 
 /* Log configuration */
 #include "sys/log.h"
@@ -151,6 +154,27 @@ neighbor_queue_from_addr(const linkaddr_t *addr)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static struct neighbor_queue *
+neighbor_queue_get_or_add(const linkaddr_t *addr)
+{
+  struct neighbor_queue *n = neighbor_queue_from_addr(addr);
+  if(n == NULL) {
+    /* Allocate a new neighbor entry */
+    n = memb_alloc(&neighbor_memb);
+    if(n != NULL) {
+      /* Init neighbor entry */
+      linkaddr_copy(&n->addr, addr);
+      n->transmissions = 0;
+      n->collisions = 0;
+      /* Init packet queue for this neighbor */
+      LIST_STRUCT_INIT(n, packet_queue);
+      /* Add neighbor to the neighbor list */
+      list_add(neighbor_list, n);
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
 static clock_time_t
 backoff_period(void)
 {
@@ -460,22 +484,8 @@ csma_output_packet(mac_callback_t sent, void *ptr)
   packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, seqno++);
   packetbuf_set_attr(PACKETBUF_ATTR_FRAME_TYPE, FRAME802154_DATAFRAME);
 
-  /* Look for the neighbor entry */
-  n = neighbor_queue_from_addr(addr);
-  if(n == NULL) {
-    /* Allocate a new neighbor entry */
-    n = memb_alloc(&neighbor_memb);
-    if(n != NULL) {
-      /* Init neighbor entry */
-      linkaddr_copy(&n->addr, addr);
-      n->transmissions = 0;
-      n->collisions = 0;
-      /* Init packet queue for this neighbor */
-      LIST_STRUCT_INIT(n, packet_queue);
-      /* Add neighbor to the neighbor list */
-      list_add(neighbor_list, n);
-    }
-  }
+  /* Look for the neighbor entry, or allocate a new one */
+  n = neighbor_queue_get_or_add(addr);
 
   if(n != NULL) {
     /* Add packet to the neighbor's queue */
@@ -530,6 +540,87 @@ csma_output_packet(mac_callback_t sent, void *ptr)
   mac_call_sent_callback(sent, ptr, MAC_TX_QUEUE_FULL, 1);
 }
 /*---------------------------------------------------------------------------*/
+int
+csma_output_requeue(const linkaddr_t *from, const linkaddr_t *to)
+{
+  struct neighbor_queue *n_from;
+  struct neighbor_queue *n_to;
+  struct packet_queue *q;
+  struct packet_queue *next;
+  int was_empty;
+  int move = 0;
+  int moved = 0;
+  int left = 0;
+
+  n_from = neighbor_queue_from_addr(from);
+  if(n_from == NULL || linkaddr_cmp(from, to)
+     || linkaddr_cmp(to, &linkaddr_null)) {
+    return 0;
+  }
+  n_to = neighbor_queue_get_or_add(to);
+  if(n_to == NULL) {
+    LOG_WARN("could not allocate neighbor, not requeueing\n");
+    return 0;
+  }
+  was_empty = list_head(n_to->packet_queue) == NULL;
+
+  for(q = list_head(n_from->packet_queue); q != NULL; q = next) {
+    next = list_item_next(q);
+#if NETSTACK_CONF_WITH_IPV6
+    {
+      /* Fragments other than the first follow the first one */
+      int depends = sicslowpan_depends_on_receiver(queuebuf_dataptr(q->buf),
+                                                   queuebuf_datalen(q->buf));
+      if(depends >= 0) {
+        move = !depends;
+      }
+    }
+#else /* NETSTACK_CONF_WITH_IPV6 */
+    move = 1;
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+    if(move && list_length(n_to->packet_queue) >= CSMA_MAX_PACKET_PER_NEIGHBOR) {
+      /* Stays queued for the old receiver */
+      left++;
+      continue;
+    }
+    if(move) {
+      if(q == list_head(n_from->packet_queue)) {
+        /* The retransmissions so far were to the old receiver */
+        n_from->transmissions = 0;
+        n_from->collisions = 0;
+      }
+      list_remove(n_from->packet_queue, q);
+      linkaddr_copy(queuebuf_addr(q->buf, PACKETBUF_ADDR_RECEIVER), to);
+      list_add(n_to->packet_queue, q);
+      moved++;
+    }
+  }
+
+  LOG_INFO("requeued %d packets from ", moved);
+  LOG_INFO_LLADDR(from);
+  LOG_INFO_(" to ");
+  LOG_INFO_LLADDR(to);
+  LOG_INFO_("\n");
+  if(left > 0) {
+    LOG_WARN("neighbor queue full, %d packets left queued for ", left);
+    LOG_WARN_LLADDR(from);
+    LOG_WARN_("\n");
+  }
+
+  if(list_head(n_from->packet_queue) == NULL) {
+    ctimer_stop(&n_from->transmit_timer);
+    list_remove(neighbor_list, n_from);
+    memb_free(&neighbor_memb, n_from);
+  }
+  if(list_head(n_to->packet_queue) == NULL) {
+    list_remove(neighbor_list, n_to);
+    memb_free(&neighbor_memb, n_to);
+  } else if(was_empty) {
+    schedule_transmission(n_to);
+  }
+  return moved;
+}
+/*---------------------------------------------------------------------------*/
 void
 csma_output_init(void)
 {
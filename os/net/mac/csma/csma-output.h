@@ -48,4 +48,16 @@
 void csma_output_packet(mac_callback_t sent, void *ptr);
 void csma_output_init(void);
 
+/**
+ * Moves the packets queued for a neighbor to the queue of another one, for
+ * instance when a routing protocol replaces a failed next hop. Frames
+ * addressed to the neighbor itself stay in its queue, and so do the
+ * packets that do not fit in the queue of the new receiver.
+ *
+ * \param from The link-layer address of the neighbor
+ * \param to The link-layer address of the new receiver
+ * \return The number of packets moved
+ */
+int csma_output_requeue(const linkaddr_t *from, const linkaddr_t *to);
+
 #endif /* CSMA_OUTPUT_H_ */
@@ -449,6 +449,16 @@ nbr_table_get_from_lladdr(nbr_table_t *table, const linkaddr_t *lladdr)
   return nbr_get_bit(used_map, table, item) ? item : NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Returns the item of the neighbor of an item of another table. All
+ * tables share the keys, so this needs no address lookup. */
+nbr_table_item_t *
+nbr_table_get_from_item(nbr_table_t *table, nbr_table_t *item_table,
+                        const nbr_table_item_t *item)
+{
+  nbr_table_item_t *other = item_from_index(table, index_from_item(item_table, item));
+  return nbr_get_bit(used_map, table, other) ? other : NULL;
+}
+/*---------------------------------------------------------------------------*/
 /* Removes a neighbor from the current table (unset "used" bit) */
 int
 nbr_table_remove(nbr_table_t *table, void *item)
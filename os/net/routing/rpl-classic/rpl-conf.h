@@ -291,6 +291,36 @@
 #define RPL_WITH_DAO_ACK 0
 #endif /* RPL_CONF_WITH_DAO_ACK */
 
+/*
+ * RPL DAO aggregation, storing mode only. When enabled, a node waits
+ * RPL_DAO_AGGREGATION_DELAY after the first DAO it has to forward, and
+ * forwards the targets of all the DAOs it received meanwhile in DAOs of
+ * up to RPL_DAO_AGGREGATION_MAX_TARGETS Target options. A DAO-ACK for
+ * such a DAO is forwarded once to each child DAO it acknowledges. This
+ * avoids a DAO per node at every hop towards the root after a global
+ * repair. Nodes always accept DAOs with several targets, but older
+ * versions only install the last one, so all nodes must be updated
+ * before aggregation is enabled.
+ * */
+#ifdef RPL_CONF_WITH_DAO_AGGREGATION
+#define RPL_WITH_DAO_AGGREGATION RPL_CONF_WITH_DAO_AGGREGATION
+#else
+#define RPL_WITH_DAO_AGGREGATION 0
+#endif /* RPL_CONF_WITH_DAO_AGGREGATION */
+
+#ifdef RPL_CONF_DAO_AGGREGATION_DELAY
+#define RPL_DAO_AGGREGATION_DELAY RPL_CONF_DAO_AGGREGATION_DELAY
+#else
+#define RPL_DAO_AGGREGATION_DELAY (CLOCK_SECOND / 2)
+#endif /* RPL_CONF_DAO_AGGREGATION_DELAY */
+
+/* The targets in a DAO forwarded with aggregation */
+#ifdef RPL_CONF_DAO_AGGREGATION_MAX_TARGETS
+#define RPL_DAO_AGGREGATION_MAX_TARGETS RPL_CONF_DAO_AGGREGATION_MAX_TARGETS
+#else
+#define RPL_DAO_AGGREGATION_MAX_TARGETS 4
+#endif /* RPL_CONF_DAO_AGGREGATION_MAX_TARGETS */
+
 /*
  * RPL REPAIR ON DAO NACK. When enabled, DAO NACK will trigger a local
  * repair in order to quickly find a new parent to send DAO's to.
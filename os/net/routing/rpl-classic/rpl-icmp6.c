@@ -70,6 +70,14 @@
 #define RPL_DIO_MOP_MASK                 0x38
 #define RPL_DIO_PREFERENCE_MASK          0x07
 
+/* The children that a forwarded DAO ACK goes to: one per target of an
+   aggregated DAO, or the sender of a DAO that was forwarded as it was. */
+#if RPL_WITH_DAO_AGGREGATION
+#define DAO_ACK_FWD_MAX_CHILDREN RPL_DAO_AGGREGATION_MAX_TARGETS
+#else /* RPL_WITH_DAO_AGGREGATION */
+#define DAO_ACK_FWD_MAX_CHILDREN 1
+#endif /* RPL_WITH_DAO_AGGREGATION */
+
 /*---------------------------------------------------------------------------*/
 static void dis_input(void);
 static void dio_input(void);
@@ -100,40 +108,6 @@ UIP_ICMP6_HANDLER(dio_handler, ICMP6_RPL, RPL_CODE_DIO, dio_input);
 UIP_ICMP6_HANDLER(dao_handler, ICMP6_RPL, RPL_CODE_DAO, dao_input);
 UIP_ICMP6_HANDLER(dao_ack_handler, ICMP6_RPL, RPL_CODE_DAO_ACK, dao_ack_input);
 /*---------------------------------------------------------------------------*/
-
-#if RPL_WITH_DAO_ACK
-static uip_ds6_route_t *
-find_route_entry_by_dao_ack(uint8_t seq)
-{
-  uip_ds6_route_t *re;
-  re = uip_ds6_route_head();
-  while(re != NULL) {
-    if(re->state.dao_seqno_out == seq && RPL_ROUTE_IS_DAO_PENDING(re)) {
-      /* found it! */
-      return re;
-    }
-    re = uip_ds6_route_next(re);
-  }
-  return NULL;
-}
-#endif /* RPL_WITH_DAO_ACK */
-
-#if RPL_WITH_STORING
-/* prepare for forwarding of DAO */
-static uint8_t
-prepare_for_dao_fwd(uint8_t sequence, uip_ds6_route_t *rep)
-{
-  /* not pending - or pending but not a retransmission */
-  RPL_LOLLIPOP_INCREMENT(dao_sequence);
-
-  /* set DAO pending and sequence numbers */
-  rep->state.dao_seqno_in = sequence;
-  rep->state.dao_seqno_out = dao_sequence;
-  RPL_ROUTE_SET_DAO_PENDING(rep);
-  return dao_sequence;
-}
-#endif /* RPL_WITH_STORING */
-/*---------------------------------------------------------------------------*/
 static int
 get_global_addr(uip_ipaddr_t *addr)
 {
@@ -636,6 +610,375 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
 #endif /* RPL_LEAF_ONLY */
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_STORING
+/* What became of a target of a received DAO */
+#define DAO_TARGET_ACK     0 /* installed, can be acknowledged now */
+#define DAO_TARGET_WAIT    1 /* acknowledged when our parent acknowledges it */
+#define DAO_TARGET_FAILED  2 /* no room for the route */
+
+static uint8_t dao_fwd_queued;
+
+#if RPL_WITH_DAO_AGGREGATION
+/* The longest target option, and a transit option in storing mode */
+#define DAO_TARGET_MAX_LEN (4 + sizeof(uip_ipaddr_t))
+#define DAO_TRANSIT_LEN    6
+
+static struct ctimer dao_fwd_timer;
+/*---------------------------------------------------------------------------*/
+/* The lifetime of a route, in the lifetime units of its instance */
+static uint8_t
+dao_fwd_lifetime(rpl_instance_t *instance, uip_ds6_route_t *rep)
+{
+  uint32_t lifetime;
+
+  if(RPL_ROUTE_IS_NOPATH_RECEIVED(rep)) {
+    return RPL_ZERO_LIFETIME;
+  }
+  if(rep->state.lifetime == RPL_ROUTE_INFINITE_LIFETIME) {
+    return RPL_INFINITE_LIFETIME;
+  }
+  if(instance->lifetime_unit == 0) {
+    return instance->default_lifetime;
+  }
+  lifetime = (rep->state.lifetime + instance->lifetime_unit - 1) /
+    instance->lifetime_unit;
+  return lifetime < RPL_INFINITE_LIFETIME ? lifetime : RPL_INFINITE_LIFETIME - 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+add_transit(unsigned char *buffer, int pos, uint8_t lifetime)
+{
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = DAO_TRANSIT_LEN - 2;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = 0; /* path seq - ignored */
+  buffer[pos++] = lifetime;
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Send the queued targets of an instance to its preferred parent, with
+ * as many targets per DAO as allowed. Consecutive targets with the same
+ * lifetime share a transit option.
+ */
+static void
+dao_fwd_output(rpl_instance_t *instance)
+{
+  uip_ipaddr_t *parent_ipaddr;
+  uip_ds6_route_t *rep;
+  unsigned char *buffer;
+  uint8_t seq_no;
+  uint8_t lifetime;
+  uint8_t last_lifetime;
+  int targets;
+  int more;
+  int pos;
+
+  parent_ipaddr = NULL;
+  if(instance->current_dag->preferred_parent != NULL) {
+    parent_ipaddr = rpl_parent_get_ipaddr(instance->current_dag->preferred_parent);
+  }
+
+  do {
+    /* Keep the sequence number of our own DAO for its DAO ACK */
+    seq_no = dao_sequence;
+    do {
+      RPL_LOLLIPOP_INCREMENT(seq_no);
+    } while(seq_no == instance->my_dao_seqno);
+
+    uipbuf_clear();
+    buffer = UIP_ICMP_PAYLOAD;
+    pos = 0;
+
+    buffer[pos++] = instance->instance_id;
+    buffer[pos] = 0;
+#if RPL_DAO_SPECIFY_DAG
+    buffer[pos] |= RPL_DAO_D_FLAG;
+#endif /* RPL_DAO_SPECIFY_DAG */
+#if RPL_WITH_DAO_ACK
+    buffer[pos] |= RPL_DAO_K_FLAG;
+#endif /* RPL_WITH_DAO_ACK */
+    ++pos;
+    buffer[pos++] = 0; /* reserved */
+    buffer[pos++] = seq_no;
+#if RPL_DAO_SPECIFY_DAG
+    memcpy(buffer + pos, &instance->current_dag->dag_id,
+           sizeof(instance->current_dag->dag_id));
+    pos += sizeof(instance->current_dag->dag_id);
+#endif /* RPL_DAO_SPECIFY_DAG */
+
+    targets = 0;
+    more = 0;
+    last_lifetime = RPL_ZERO_LIFETIME;
+    for(rep = uip_ds6_route_head(); rep != NULL; rep = uip_ds6_route_next(rep)) {
+      if(!RPL_ROUTE_IS_DAO_FWD(rep) || rep->state.dag == NULL ||
+         rep->state.dag->instance != instance) {
+        continue;
+      }
+      if(parent_ipaddr == NULL) {
+        /* Nowhere to forward to; the route is announced with our next DAO */
+        RPL_ROUTE_CLEAR_DAO_FWD(rep);
+        continue;
+      }
+      if(targets == RPL_DAO_AGGREGATION_MAX_TARGETS ||
+         UIP_IPH_LEN + UIP_ICMPH_LEN + pos + DAO_TARGET_MAX_LEN +
+         2 * DAO_TRANSIT_LEN > UIP_BUFSIZE) {
+        more = 1;
+        break;
+      }
+
+      lifetime = dao_fwd_lifetime(instance, rep);
+      if(targets > 0 && lifetime != last_lifetime) {
+        pos = add_transit(buffer, pos, last_lifetime);
+      }
+      buffer[pos++] = RPL_OPTION_TARGET;
+      buffer[pos++] = 2 + ((rep->length + 7) / CHAR_BIT);
+      buffer[pos++] = 0; /* reserved */
+      buffer[pos++] = rep->length;
+      memcpy(buffer + pos, &rep->ipaddr, (rep->length + 7) / CHAR_BIT);
+      pos += ((rep->length + 7) / CHAR_BIT);
+
+      /* The DAO ACK for this sequence number goes back to the child */
+      RPL_ROUTE_CLEAR_DAO_FWD(rep);
+      rep->state.dao_seqno_out = seq_no;
+      RPL_ROUTE_SET_DAO_PENDING(rep);
+      last_lifetime = lifetime;
+      targets++;
+    }
+
+    if(targets == 0) {
+      break;
+    }
+    pos = add_transit(buffer, pos, last_lifetime);
+    dao_sequence = seq_no;
+
+    LOG_INFO("Forwarding a DAO with sequence number %u and %u targets to ",
+             seq_no, targets);
+    LOG_INFO_6ADDR(parent_ipaddr);
+    LOG_INFO_("\n");
+
+    RPL_STAT(rpl_stats.daos_forwarded++);
+    RPL_STAT(rpl_stats.dao_targets_forwarded += targets);
+    uip_icmp6_send(parent_ipaddr, ICMP6_RPL, RPL_CODE_DAO, pos);
+  } while(more);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_dao_fwd_timer(void *ptr)
+{
+  int i;
+
+  dao_fwd_queued = 0;
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(instance_table[i].used && instance_table[i].current_dag != NULL) {
+      dao_fwd_output(&instance_table[i]);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+queue_dao_fwd(uip_ds6_route_t *rep, uint8_t sequence)
+{
+  rep->state.dao_seqno_in = sequence;
+  if(!RPL_ROUTE_IS_DAO_FWD(rep)) {
+    RPL_ROUTE_SET_DAO_FWD(rep);
+    dao_fwd_queued++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Forward the queued targets now, or once more DAOs had a chance to arrive */
+static void
+schedule_dao_fwd(void)
+{
+  if(dao_fwd_queued < RPL_DAO_AGGREGATION_MAX_TARGETS) {
+    if(ctimer_expired(&dao_fwd_timer)) {
+      ctimer_set(&dao_fwd_timer, RPL_DAO_AGGREGATION_DELAY,
+                 handle_dao_fwd_timer, NULL);
+    }
+    return;
+  }
+  ctimer_stop(&dao_fwd_timer);
+  handle_dao_fwd_timer(NULL);
+}
+#else /* RPL_WITH_DAO_AGGREGATION */
+/* The outgoing sequence number of a retransmitted DAO */
+static uint8_t dao_fwd_seqno;
+static uint8_t dao_fwd_retransmission;
+/*---------------------------------------------------------------------------*/
+static void
+queue_dao_fwd(uip_ds6_route_t *rep, uint8_t sequence)
+{
+  /* if this is pending and we get the same seq no it is a retrans */
+  if(RPL_ROUTE_IS_DAO_PENDING(rep) && rep->state.dao_seqno_in == sequence) {
+    /* keep the same seq-no as before for parent also */
+    dao_fwd_seqno = rep->state.dao_seqno_out;
+    dao_fwd_retransmission = 1;
+  }
+  rep->state.dao_seqno_in = sequence;
+  if(!RPL_ROUTE_IS_DAO_FWD(rep)) {
+    RPL_ROUTE_SET_DAO_FWD(rep);
+    dao_fwd_queued++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Without aggregation, the received DAO is forwarded as it is, with an
+ * outgoing sequence number of ours. The routes of its targets keep that
+ * number for the DAO ACK.
+ */
+static void
+dao_fwd_received(rpl_instance_t *instance, unsigned char *buffer,
+                 uint8_t length, int targets)
+{
+  uip_ipaddr_t *parent_ipaddr;
+  uip_ds6_route_t *rep;
+  uint8_t out_seq;
+
+  parent_ipaddr = NULL;
+  if(instance->current_dag->preferred_parent != NULL) {
+    parent_ipaddr = rpl_parent_get_ipaddr(instance->current_dag->preferred_parent);
+  }
+
+  out_seq = 0;
+  if(dao_fwd_queued > 0 && parent_ipaddr != NULL) {
+    if(dao_fwd_retransmission) {
+      out_seq = dao_fwd_seqno;
+    } else {
+      RPL_LOLLIPOP_INCREMENT(dao_sequence);
+      out_seq = dao_sequence;
+    }
+  }
+  for(rep = uip_ds6_route_head(); rep != NULL; rep = uip_ds6_route_next(rep)) {
+    if(!RPL_ROUTE_IS_DAO_FWD(rep) || rep->state.dag == NULL ||
+       rep->state.dag->instance != instance) {
+      continue;
+    }
+    RPL_ROUTE_CLEAR_DAO_FWD(rep);
+    if(parent_ipaddr != NULL) {
+      rep->state.dao_seqno_out = out_seq;
+      RPL_ROUTE_SET_DAO_PENDING(rep);
+    }
+  }
+  dao_fwd_queued = 0;
+  dao_fwd_retransmission = 0;
+
+  if(parent_ipaddr == NULL) {
+    return;
+  }
+
+  LOG_DBG("Forwarding DAO to parent ");
+  LOG_DBG_6ADDR(parent_ipaddr);
+  LOG_DBG_(" out seq: %d\n", out_seq);
+
+  buffer[3] = out_seq; /* add an outgoing seq no before fwd */
+  RPL_STAT(rpl_stats.daos_forwarded++);
+  RPL_STAT(rpl_stats.dao_targets_forwarded += targets);
+  uip_icmp6_send(parent_ipaddr, ICMP6_RPL, RPL_CODE_DAO, length);
+}
+#endif /* RPL_WITH_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
+/* The lifetime in the first transit option after a target option */
+static uint8_t
+dao_transit_lifetime(rpl_instance_t *instance, unsigned char *buffer,
+                     int pos, int length)
+{
+  int len;
+
+  for(; pos < length; pos += len) {
+    if(buffer[pos] == RPL_OPTION_PAD1) {
+      len = 1;
+      continue;
+    }
+    len = 2 + buffer[pos + 1];
+    if(buffer[pos] == RPL_OPTION_TRANSIT && pos + 5 < length) {
+      /* The path sequence and control are ignored. */
+      return buffer[pos + 5];
+    }
+  }
+  return instance->default_lifetime;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_target_input(rpl_instance_t *instance, uip_ipaddr_t *dao_sender_addr,
+                 uip_ipaddr_t *prefix, uint8_t prefixlen, uint8_t lifetime,
+                 uint8_t sequence, int learned_from)
+{
+  rpl_dag_t *dag;
+  uip_ds6_route_t *rep;
+  int ack_now;
+
+  dag = instance->current_dag;
+  rep = uip_ds6_route_lookup(prefix);
+
+  if(lifetime == RPL_ZERO_LIFETIME) {
+    LOG_INFO("No-Path DAO received\n");
+    /* No-Path DAO received; invoke the route purging routine. */
+    if(rep != NULL &&
+       !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) &&
+       rep->length == prefixlen &&
+       uip_ds6_route_nexthop(rep) != NULL &&
+       uip_ipaddr_cmp(uip_ds6_route_nexthop(rep), dao_sender_addr)) {
+      LOG_DBG("Setting expiration timer for prefix ");
+      LOG_DBG_6ADDR(prefix);
+      LOG_DBG_("\n");
+      RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
+      rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
+
+      /* We forward the No-Path target to our parent, if we have one. */
+      if(dag->preferred_parent != NULL) {
+        queue_dao_fwd(rep, sequence);
+      }
+    }
+    /* independent if we remove or not - ACK the request */
+    return DAO_TARGET_ACK;
+  }
+
+  LOG_INFO("Adding DAO route\n");
+
+  /* Update and add neighbor - if no room - fail. */
+  if(rpl_icmp6_update_nbr_table(dao_sender_addr, NBR_TABLE_REASON_RPL_DAO,
+                                instance) == NULL) {
+    LOG_ERR("Out of Memory, dropping DAO from ");
+    LOG_ERR_6ADDR(dao_sender_addr);
+    LOG_ERR_(", ");
+    LOG_ERR_LLADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    LOG_ERR_("\n");
+    return DAO_TARGET_FAILED;
+  }
+
+  rep = rpl_add_route(dag, prefix, prefixlen, dao_sender_addr);
+  if(rep == NULL) {
+    RPL_STAT(rpl_stats.mem_overflows++);
+    LOG_ERR("Could not add a route after receiving a DAO\n");
+    return DAO_TARGET_FAILED;
+  }
+
+  /* set lifetime and clear NOPATH bit */
+  rep->state.lifetime = RPL_LIFETIME(instance, lifetime);
+  RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
+
+  if(learned_from != RPL_ROUTE_FROM_UNICAST_DAO) {
+    return DAO_TARGET_WAIT;
+  }
+
+  /*
+   * check if this route is already installed and we can ack now!
+   * not pending - and same seq-no means that we can ack.
+   * (e.g. the route is installed already so it will not take any
+   * more room that it already takes - so should be ok!)
+   */
+  ack_now = (!RPL_ROUTE_IS_DAO_PENDING(rep) &&
+             rep->state.dao_seqno_in == sequence) ||
+    dag->rank == ROOT_RANK(instance);
+
+  if(dag->preferred_parent != NULL) {
+    queue_dao_fwd(rep, sequence);
+  }
+  return ack_now ? DAO_TARGET_ACK : DAO_TARGET_WAIT;
+}
+#endif /* RPL_WITH_STORING */
+/*---------------------------------------------------------------------------*/
 static void
 dao_input_storing(void)
 {
@@ -649,25 +992,22 @@ dao_input_storing(void)
   uint8_t lifetime;
   uint8_t prefixlen;
   uint8_t flags;
-  uint8_t subopt_type;
-  /*
-    uint8_t pathcontrol;
-    uint8_t pathsequence;
-  */
   uip_ipaddr_t prefix;
-  uip_ds6_route_t *rep;
   uint8_t buffer_length;
   int pos;
   int len;
   int i;
   int learned_from;
   rpl_parent_t *parent;
-  uip_ds6_nbr_t *nbr;
   int is_root;
+  int targets;
+  int wait_for_ack;
+  int failed;
+#if RPL_WITH_MULTICAST
+  int fwd_mcast = 0;
+#endif
 
-  prefixlen = 0;
   parent = NULL;
-  memset(&prefix, 0, sizeof(prefix));
 
   uip_ipaddr_copy(&dao_sender_addr, &UIP_IP_BUF->srcipaddr);
 
@@ -679,8 +1019,6 @@ dao_input_storing(void)
 
   instance = rpl_get_instance(instance_id);
 
-  lifetime = instance->default_lifetime;
-
   flags = buffer[pos++];
   /* reserved */
   pos++;
@@ -730,180 +1068,110 @@ dao_input_storing(void)
     }
   }
 
-  /* Check if there are any RPL options present. */
+  /*
+   * Handle each target option, with the lifetime of the transit option
+   * that follows it. An aggregated DAO carries several targets; it is
+   * acknowledged as a whole.
+   */
+  targets = 0;
+  wait_for_ack = 0;
+  failed = 0;
   for(i = pos; i < buffer_length; i += len) {
-    subopt_type = buffer[i];
-    if(subopt_type == RPL_OPTION_PAD1) {
+    if(buffer[i] == RPL_OPTION_PAD1) {
       len = 1;
-    } else {
-      /* The option consists of a two-byte header and a payload. */
-      len = 2 + buffer[i + 1];
+      continue;
     }
-
-    switch(subopt_type) {
-      case RPL_OPTION_TARGET:
-        /* Handle the target option. */
-        prefixlen = buffer[i + 3];
-        memset(&prefix, 0, sizeof(prefix));
-        memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
-        break;
-      case RPL_OPTION_TRANSIT:
-        /* The path sequence and control are ignored. */
-        /*      pathcontrol = buffer[i + 3];
-                pathsequence = buffer[i + 4];*/
-        lifetime = buffer[i + 5];
-        /* The parent address is also ignored. */
-        break;
+    /* The option consists of a two-byte header and a payload. */
+    len = 2 + buffer[i + 1];
+    if(buffer[i] != RPL_OPTION_TARGET) {
+      continue;
     }
-  }
 
-  LOG_INFO("DAO lifetime: %u, prefix length: %u prefix: ",
-         (unsigned)lifetime, (unsigned)prefixlen);
-  LOG_INFO_6ADDR(&prefix);
-  LOG_INFO_("\n");
+    prefixlen = buffer[i + 3];
+    if(prefixlen > sizeof(prefix) * CHAR_BIT ||
+       i + 4 + (prefixlen + 7) / CHAR_BIT > buffer_length) {
+      LOG_WARN("Invalid target option in DAO\n");
+      RPL_STAT(rpl_stats.malformed_msgs++);
+      continue;
+    }
+    memset(&prefix, 0, sizeof(prefix));
+    memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
+    lifetime = dao_transit_lifetime(instance, buffer, i + len, buffer_length);
+    targets++;
+
+    LOG_INFO("DAO lifetime: %u, prefix length: %u prefix: ",
+           (unsigned)lifetime, (unsigned)prefixlen);
+    LOG_INFO_6ADDR(&prefix);
+    LOG_INFO_("\n");
 
 #if RPL_WITH_MULTICAST
-  if(uip_is_addr_mcast_global(&prefix)) {
-    /*
-     * "rep" is used for a unicast route which we don't need now; so set NULL so
-     * that operations on "rep" will be skipped.
-     */
-    rep = NULL;
-    mcast_group = uip_mcast6_route_add(&prefix);
-    if(mcast_group) {
-      mcast_group->dag = dag;
-      mcast_group->lifetime = RPL_LIFETIME(instance, lifetime);
+    if(uip_is_addr_mcast_global(&prefix)) {
+      mcast_group = uip_mcast6_route_add(&prefix);
+      if(mcast_group) {
+        mcast_group->dag = dag;
+        mcast_group->lifetime = RPL_LIFETIME(instance, lifetime);
+      }
+      fwd_mcast = 1;
+      wait_for_ack = 1;
+      continue;
     }
-    goto fwd_dao;
-  }
 #endif
 
-  rep = uip_ds6_route_lookup(&prefix);
-
-  if(lifetime == RPL_ZERO_LIFETIME) {
-    LOG_INFO("No-Path DAO received\n");
-    /* No-Path DAO received; invoke the route purging routine. */
-    if(rep != NULL &&
-       !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) &&
-       rep->length == prefixlen &&
-       uip_ds6_route_nexthop(rep) != NULL &&
-       uip_ipaddr_cmp(uip_ds6_route_nexthop(rep), &dao_sender_addr)) {
-      LOG_DBG("Setting expiration timer for prefix ");
-      LOG_DBG_6ADDR(&prefix);
-      LOG_DBG_("\n");
-      RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
-      rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
-
-      /* We forward the incoming No-Path DAO to our parent, if we have
-         one. */
-      if(dag->preferred_parent != NULL &&
-         rpl_parent_get_ipaddr(dag->preferred_parent) != NULL) {
-        uint8_t out_seq;
-        out_seq = prepare_for_dao_fwd(sequence, rep);
-
-        LOG_DBG("Forwarding No-path DAO to parent - out_seq:%d",
-               out_seq);
-        LOG_DBG_6ADDR(rpl_parent_get_ipaddr(dag->preferred_parent));
-        LOG_DBG_("\n");
-
-        buffer = UIP_ICMP_PAYLOAD;
-        buffer[3] = out_seq; /* add an outgoing seq no before fwd */
-        uip_icmp6_send(rpl_parent_get_ipaddr(dag->preferred_parent),
-                       ICMP6_RPL, RPL_CODE_DAO, buffer_length);
-      }
+    switch(dao_target_input(instance, &dao_sender_addr, &prefix, prefixlen,
+                            lifetime, sequence, learned_from)) {
+    case DAO_TARGET_WAIT:
+      wait_for_ack = 1;
+      break;
+    case DAO_TARGET_FAILED:
+      failed = 1;
+      break;
     }
-    /* independent if we remove or not - ACK the request */
-    if(flags & RPL_DAO_K_FLAG) {
-      /* indicate that we accepted the no-path DAO */
-      uipbuf_clear();
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
-    }
-    return;
   }
 
-  LOG_INFO("Adding DAO route\n");
-
-  /* Update and add neighbor - if no room - fail. */
-  if((nbr = rpl_icmp6_update_nbr_table(&dao_sender_addr, NBR_TABLE_REASON_RPL_DAO, instance)) == NULL) {
-    LOG_ERR("Out of Memory, dropping DAO from ");
-    LOG_ERR_6ADDR(&dao_sender_addr);
-    LOG_ERR_(", ");
-    LOG_ERR_LLADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    LOG_ERR_("\n");
-    if(flags & RPL_DAO_K_FLAG) {
-      /* signal the failure to add the node */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-                     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
-    }
+  if(targets == 0) {
+    LOG_WARN("Received a DAO without a target\n");
+    RPL_STAT(rpl_stats.malformed_msgs++);
     return;
   }
 
-  rep = rpl_add_route(dag, &prefix, prefixlen, &dao_sender_addr);
-  if(rep == NULL) {
-    RPL_STAT(rpl_stats.mem_overflows++);
-    LOG_ERR("Could not add a route after receiving a DAO\n");
-    if(flags & RPL_DAO_K_FLAG) {
-      /* signal the failure to add the node */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-                     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
-    }
-    return;
+#if RPL_WITH_DAO_AGGREGATION
+#if RPL_WITH_MULTICAST
+  /*
+   * Multicast groups have no route entry to queue, so the DAO is
+   * forwarded as it is.
+   */
+  if(fwd_mcast && learned_from == RPL_ROUTE_FROM_UNICAST_DAO &&
+     dag->preferred_parent != NULL &&
+     rpl_parent_get_ipaddr(dag->preferred_parent) != NULL) {
+    buffer[3] = 0; /* add an outgoing seq no before fwd */
+    RPL_STAT(rpl_stats.daos_forwarded++);
+    RPL_STAT(rpl_stats.dao_targets_forwarded += targets);
+    uip_icmp6_send(rpl_parent_get_ipaddr(dag->preferred_parent),
+                   ICMP6_RPL, RPL_CODE_DAO, buffer_length);
   }
+#endif
 
-  /* set lifetime and clear NOPATH bit */
-  rep->state.lifetime = RPL_LIFETIME(instance, lifetime);
-  RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
-
+  if(dao_fwd_queued > 0) {
+    schedule_dao_fwd();
+  }
+#else /* RPL_WITH_DAO_AGGREGATION */
+  if(dao_fwd_queued > 0
 #if RPL_WITH_MULTICAST
-fwd_dao:
+     || (fwd_mcast && learned_from == RPL_ROUTE_FROM_UNICAST_DAO)
 #endif
+     ) {
+    dao_fwd_received(instance, buffer, buffer_length, targets);
+  }
+#endif /* RPL_WITH_DAO_AGGREGATION */
 
-  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
-    int should_ack = 0;
-
-    if(flags & RPL_DAO_K_FLAG) {
-      if(rep != NULL) {
-        /*
-         * check if this route is already installed and we can ack now!
-         * not pending - and same seq-no means that we can ack.
-         * (e.g. the route is installed already so it will not take any
-         * more room that it already takes - so should be ok!)
-         */
-        if((!RPL_ROUTE_IS_DAO_PENDING(rep) &&
-            rep->state.dao_seqno_in == sequence) ||
-           dag->rank == ROOT_RANK(instance)) {
-          should_ack = 1;
-        }
-      }
-    }
-
-    if(dag->preferred_parent != NULL &&
-       rpl_parent_get_ipaddr(dag->preferred_parent) != NULL) {
-      uint8_t out_seq = 0;
-      if(rep != NULL) {
-        /* if this is pending and we get the same seq no it is a retrans */
-        if(RPL_ROUTE_IS_DAO_PENDING(rep) &&
-           rep->state.dao_seqno_in == sequence) {
-          /* keep the same seq-no as before for parent also */
-          out_seq = rep->state.dao_seqno_out;
-        } else {
-          out_seq = prepare_for_dao_fwd(sequence, rep);
-        }
-      }
-
-      LOG_DBG("Forwarding DAO to parent ");
-      LOG_DBG_6ADDR(rpl_parent_get_ipaddr(dag->preferred_parent));
-      LOG_DBG_(" in seq: %d out seq: %d\n", sequence, out_seq);
-
-      buffer = UIP_ICMP_PAYLOAD;
-      buffer[3] = out_seq; /* add an outgoing seq no before fwd */
-      uip_icmp6_send(rpl_parent_get_ipaddr(dag->preferred_parent),
-                     ICMP6_RPL, RPL_CODE_DAO, buffer_length);
-    }
-    if(should_ack) {
+  if(flags & RPL_DAO_K_FLAG) {
+    if(failed) {
+      /* signal the failure to add the node */
+      uipbuf_clear();
+      dao_ack_output(instance, &dao_sender_addr, sequence,
+                     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+                     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
+    } else if(!wait_for_ack) {
       LOG_DBG("Sending DAO ACK\n");
       uipbuf_clear();
       dao_ack_output(instance, &dao_sender_addr, sequence,
@@ -1045,6 +1313,8 @@ dao_input(void)
     goto discard;
   }
 
+  RPL_STAT(rpl_stats.daos_received++);
+
   if(RPL_IS_STORING(instance)) {
     dao_input_storing();
   } else if(RPL_IS_NON_STORING(instance)) {
@@ -1267,10 +1537,101 @@ dao_output_target_seq(rpl_parent_t *parent, uip_ipaddr_t *prefix,
   LOG_INFO_("\n");
 
   if(dest_ipaddr != NULL) {
+    RPL_STAT(rpl_stats.daos_sent++);
     uip_icmp6_send(dest_ipaddr, ICMP6_RPL, RPL_CODE_DAO, pos);
   }
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_ACK
+/*
+ * Forward a DAO ACK to the children whose targets were in the DAO it
+ * acknowledges. The targets of a child DAO may have been forwarded in
+ * several DAOs; the child gets a single DAO ACK, when the last of them
+ * is acknowledged.
+ */
+static int
+dao_ack_is_pending(const uip_ipaddr_t *nexthop, uint8_t seqno_in)
+{
+  uip_ds6_route_t *re;
+
+  for(re = uip_ds6_route_head(); re != NULL; re = uip_ds6_route_next(re)) {
+    if(RPL_ROUTE_IS_DAO_PENDING(re) && re->state.dao_seqno_in == seqno_in &&
+       uip_ds6_route_nexthop(re) != NULL &&
+       uip_ipaddr_cmp(uip_ds6_route_nexthop(re), nexthop)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_ack_fwd(rpl_instance_t *instance, uint8_t sequence, uint8_t status)
+{
+  struct {
+    uip_ipaddr_t nexthop;
+    uint8_t seqno_in;
+  } acked[DAO_ACK_FWD_MAX_CHILDREN];
+  uip_ds6_route_t *re;
+  uip_ds6_route_t *next;
+  int found;
+  int count;
+  int i;
+
+  /* Clear the pending flag of the routes, and note their children */
+  found = 0;
+  count = 0;
+  for(re = uip_ds6_route_head(); re != NULL; re = next) {
+    next = uip_ds6_route_next(re);
+    if(re->state.dao_seqno_out != sequence || !RPL_ROUTE_IS_DAO_PENDING(re)) {
+      continue;
+    }
+    found = 1;
+    RPL_ROUTE_CLEAR_DAO_PENDING(re);
+
+    if(uip_ds6_route_nexthop(re) == NULL) {
+      LOG_WARN("No next hop to fwd DAO ACK to\n");
+    } else {
+      for(i = 0; i < count; i++) {
+        if(acked[i].seqno_in == re->state.dao_seqno_in &&
+           uip_ipaddr_cmp(&acked[i].nexthop, uip_ds6_route_nexthop(re))) {
+          break;
+        }
+      }
+      if(i == count && count == DAO_ACK_FWD_MAX_CHILDREN) {
+        /* More children than a forwarded DAO covers, from an older DAO
+           with the same sequence number. The child retransmits its DAO. */
+        LOG_WARN("No room to fwd DAO ACK to:");
+        LOG_WARN_6ADDR(uip_ds6_route_nexthop(re));
+        LOG_WARN_("\n");
+      } else if(i == count) {
+        uip_ipaddr_copy(&acked[count].nexthop, uip_ds6_route_nexthop(re));
+        acked[count].seqno_in = re->state.dao_seqno_in;
+        count++;
+      }
+    }
+
+    if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
+      /* this node did not get in to the routing tables above... - remove */
+      uip_ds6_route_rm(re);
+    }
+  }
+
+  /* forward the DAO ACK with the recorded seq no of each child DAO */
+  for(i = 0; i < count; i++) {
+    if(status < RPL_DAO_ACK_UNABLE_TO_ACCEPT &&
+       dao_ack_is_pending(&acked[i].nexthop, acked[i].seqno_in)) {
+      continue;
+    }
+    LOG_INFO("Fwd DAO ACK to:");
+    LOG_INFO_6ADDR(&acked[i].nexthop);
+    LOG_INFO_("\n");
+    uipbuf_clear();
+    dao_ack_output(instance, &acked[i].nexthop, acked[i].seqno_in, status);
+  }
+  return found;
+}
+#endif /* RPL_WITH_DAO_ACK */
+/*---------------------------------------------------------------------------*/
 static void
 dao_ack_input(void)
 {
@@ -1340,30 +1701,8 @@ dao_ack_input(void)
 #endif
 
   } else if(RPL_IS_STORING(instance)) {
-    /* this DAO ACK should be forwarded to another recently registered route */
-    uip_ds6_route_t *re;
-    const uip_ipaddr_t *nexthop;
-    if((re = find_route_entry_by_dao_ack(sequence)) != NULL) {
-      /* pick the recorded seq no from that node and forward DAO ACK - and
-         clear the pending flag*/
-      RPL_ROUTE_CLEAR_DAO_PENDING(re);
-
-      nexthop = uip_ds6_route_nexthop(re);
-      if(nexthop == NULL) {
-        LOG_WARN("No next hop to fwd DAO ACK to\n");
-      } else {
-        LOG_INFO("Fwd DAO ACK to:");
-        LOG_INFO_6ADDR(nexthop);
-        LOG_INFO_("\n");
-        buffer[2] = re->state.dao_seqno_in;
-        uip_icmp6_send(nexthop, ICMP6_RPL, RPL_CODE_DAO_ACK, 4);
-      }
-
-      if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
-        /* this node did not get in to the routing tables above... - remove */
-        uip_ds6_route_rm(re);
-      }
-    } else {
+    /* this DAO ACK should be forwarded to recently registered routes */
+    if(!dao_ack_fwd(instance, sequence, status)) {
       LOG_WARN("No route entry found to forward DAO ACK (seqno %u)\n", sequence);
     }
   }
@@ -1389,6 +1728,7 @@ dao_ack_output(rpl_instance_t *instance, uip_ipaddr_t *dest, uint8_t sequence,
   buffer[2] = sequence;
   buffer[3] = status;
 
+  RPL_STAT(rpl_stats.dao_acks_sent++);
   uip_icmp6_send(dest, ICMP6_RPL, RPL_CODE_DAO_ACK, 4);
 #endif /* RPL_WITH_DAO_ACK */
 }
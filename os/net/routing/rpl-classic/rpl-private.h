@@ -257,6 +257,11 @@ struct rpl_stats {
   uint16_t loop_errors;
   uint16_t loop_warnings;
   uint16_t root_repairs;
+  uint16_t daos_sent;
+  uint16_t daos_received;
+  uint16_t daos_forwarded;
+  uint16_t dao_targets_forwarded;
+  uint16_t dao_acks_sent;
 };
 typedef struct rpl_stats rpl_stats_t;
 
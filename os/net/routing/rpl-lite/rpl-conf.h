@@ -181,6 +181,19 @@
 #define RPL_PROBING_SEND_FUNC(addr) rpl_icmp6_dio_output((addr))
 #endif
 
+/*
+ * Fast local repair. When the preferred parent does not acknowledge this
+ * many packets in a row, switch at once to the best backup parent instead
+ * of waiting for its link metric to degrade, and move the packets queued
+ * for it to the new parent (see RPL_CALLBACK_REQUEUE). The failed parent
+ * is not selected again until it is heard from. 0 disables fast repair.
+ */
+#ifdef RPL_CONF_FAST_REPAIR_NOACKS
+#define RPL_FAST_REPAIR_NOACKS RPL_CONF_FAST_REPAIR_NOACKS
+#else
+#define RPL_FAST_REPAIR_NOACKS 0
+#endif
+
 /*
  * This value decides if this node must stay as a leaf or not
  * as allowed by draft-ietf-roll-rpl-19#section-8.5
@@ -367,6 +380,30 @@
 #define RPL_DEFAULT_INSTANCE	          0 /* Default of 0 for compression */
 #endif /* RPL_CONF_DEFAULT_INSTANCE */
 
+/*
+ * The number of RPL instances a node can be part of at the same time.
+ * Each instance has its own OF, DAG, timers and neighbor table, so that
+ * e.g. alarms can follow a hop-count DAG while bulk traffic follows an
+ * ETX DAG. Outgoing packets are mapped to an instance by DSCP or flow
+ * label (see rpl-instance.h). The default instance, RPL_DEFAULT_INSTANCE,
+ * is the one reported by the routing API and the only one that installs
+ * a default route. With a single instance, no per-instance state is added.
+ * Each extra instance takes a neighbor table, out of the NBR_TABLE
+ * module's limit of 8 tables.
+ */
+#ifdef RPL_CONF_MAX_INSTANCES
+#define RPL_MAX_INSTANCES RPL_CONF_MAX_INSTANCES
+#else /* RPL_CONF_MAX_INSTANCES */
+#define RPL_MAX_INSTANCES 1
+#endif /* RPL_CONF_MAX_INSTANCES */
+
+/* The number of DSCP or flow label to instance mappings */
+#ifdef RPL_CONF_INSTANCE_MAP_SIZE
+#define RPL_INSTANCE_MAP_SIZE RPL_CONF_INSTANCE_MAP_SIZE
+#else /* RPL_CONF_INSTANCE_MAP_SIZE */
+#define RPL_INSTANCE_MAP_SIZE 4
+#endif /* RPL_CONF_INSTANCE_MAP_SIZE */
+
 /* Set to have the root advertise a grounded DAG */
 #ifndef RPL_CONF_GROUNDED
 #define RPL_GROUNDED                    0
@@ -396,6 +433,17 @@
 
 #endif /* MAC_CONF_WITH_TSCH */
 
+/* RPL callback moving the packets queued in the MAC layer for a failed
+ * parent to the new parent, at fast repair. Returns the number of packets
+ * moved. TSCH frames are built when queued, and are not moved. */
+#if MAC_CONF_WITH_CSMA
+
+#ifndef RPL_CALLBACK_REQUEUE
+#define RPL_CALLBACK_REQUEUE csma_output_requeue
+#endif /* RPL_CALLBACK_REQUEUE */
+
+#endif /* MAC_CONF_WITH_CSMA */
+
 /* Set to 1 to drop packets when a forwarding loop is detected
  * on a packet that already had an error signaled, as per RFC6550 - 11.2.2.2.
  * Disabled by default for more reliability: even in the event of a loop,
@@ -122,6 +122,12 @@ rpl_dag_root_set_prefix(uip_ipaddr_t *prefix, uip_ipaddr_t *iid)
 /*---------------------------------------------------------------------------*/
 int
 rpl_dag_root_start(void)
+{
+  return rpl_dag_root_start_instance(RPL_DEFAULT_INSTANCE, RPL_OF_OCP);
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_dag_root_start_instance(uint8_t instance_id, rpl_ocp_t ocp)
 {
   struct uip_ds6_addr *root_if;
   int i;
@@ -140,12 +146,9 @@ rpl_dag_root_start(void)
   }
 
   root_if = uip_ds6_addr_lookup(ipaddr);
-  if(ipaddr != NULL || root_if != NULL) {
-
-    rpl_dag_init_root(RPL_DEFAULT_INSTANCE, ipaddr,
-      (uip_ipaddr_t *)rpl_get_global_address(), 64, UIP_ND6_RA_FLAG_AUTONOMOUS);
-    rpl_dag_update_state();
-
+  if((ipaddr != NULL || root_if != NULL)
+     && rpl_dag_init_root(instance_id, ocp, ipaddr,
+          (uip_ipaddr_t *)rpl_get_global_address(), 64, UIP_ND6_RA_FLAG_AUTONOMOUS)) {
     LOG_INFO("created a new RPL DAG\n");
     return 0;
   } else {
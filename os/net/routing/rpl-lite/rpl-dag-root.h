@@ -57,6 +57,16 @@ void rpl_dag_root_set_prefix(uip_ipaddr_t *prefix, uip_ipaddr_t *iid);
 */
 int rpl_dag_root_start(void);
 
+/**
+ * Set the node as root of an instance, and start a DAG. The node can be
+ * root of up to RPL_MAX_INSTANCES instances, with different OFs.
+ *
+ * \param instance_id The RPL instance ID
+ * \param ocp The objective code point of the OF, e.g. RPL_OCP_OF0
+ * \return 0 in case of success, -1 otherwise
+*/
+int rpl_dag_root_start_instance(uint8_t instance_id, rpl_ocp_t ocp);
+
 /**
  * Tells whether we are DAG root or not
  *
@@ -57,10 +57,6 @@ extern rpl_of_t rpl_of0, rpl_mrhof;
 static rpl_of_t * const objective_functions[] = RPL_SUPPORTED_OFS;
 static int process_dio_init_dag(rpl_dio_t *dio);
 
-/*---------------------------------------------------------------------------*/
-/* Allocate instance table. */
-rpl_instance_t curr_instance;
-
 /*---------------------------------------------------------------------------*/
 
 #ifdef RPL_VALIDATE_DIO_FUNC
@@ -95,6 +91,43 @@ rpl_dag_get_root_ipaddr(uip_ipaddr_t *ipaddr)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+/* Tells whether another instance we are part of uses a given prefix */
+static int
+prefix_used_elsewhere(const rpl_prefix_t *prefix)
+{
+#if RPL_MAX_INSTANCES > 1
+  rpl_instance_t *instance;
+
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used && instance != rpl_curr_instance
+       && instance->dag.prefix_info.length == prefix->length
+       && uip_ipaddr_prefixcmp(&instance->dag.prefix_info.prefix,
+                               &prefix->prefix, prefix->length)) {
+      return 1;
+    }
+  }
+#endif /* RPL_MAX_INSTANCES > 1 */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Tells whether we are part of another instance than the current one */
+static int
+other_instance_used(void)
+{
+#if RPL_MAX_INSTANCES > 1
+  rpl_instance_t *instance;
+
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used && instance != rpl_curr_instance) {
+      return 1;
+    }
+  }
+#endif /* RPL_MAX_INSTANCES > 1 */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 void
 rpl_dag_leave(void)
 {
@@ -108,18 +141,21 @@ rpl_dag_leave(void)
     rpl_icmp6_dao_output(0);
   }
 
-  /* Forget past link statistics */
-  link_stats_reset();
+  /* Forget past link statistics, unless other instances still use them */
+  if(!other_instance_used()) {
+    link_stats_reset();
+  }
 
   /* Remove all neighbors, links and default route */
   rpl_neighbor_remove_all();
-  uip_sr_free_all();
+  uip_sr_free_graph(RPL_SR_GRAPH);
 
   /* Stop all timers */
   rpl_timers_stop_dag_timers();
 
   /* Remove autoconfigured address */
-  if((curr_instance.dag.prefix_info.flags & UIP_ND6_RA_FLAG_AUTONOMOUS)) {
+  if((curr_instance.dag.prefix_info.flags & UIP_ND6_RA_FLAG_AUTONOMOUS)
+     && !prefix_used_elsewhere(&curr_instance.dag.prefix_info)) {
     rpl_reset_prefix(&curr_instance.dag.prefix_info);
   }
 
@@ -393,6 +429,11 @@ update_nbr_from_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 #if RPL_WITH_MC
   memcpy(&nbr->mc, &dio->mc, sizeof(nbr->mc));
 #endif /* RPL_WITH_MC */
+#if RPL_FAST_REPAIR_NOACKS
+  /* A parent left by fast repair may be selected again */
+  nbr->flags &= ~RPL_NBR_FAILED;
+#endif /* RPL_FAST_REPAIR_NOACKS */
+  rpl_neighbor_invalidate(nbr);
 
   return nbr;
 }
@@ -486,6 +527,8 @@ init_dag(uint8_t instance_id, uip_ipaddr_t *dag_id, rpl_ocp_t ocp,
   rpl_of_t *of;
 
   memset(&curr_instance, 0, sizeof(curr_instance));
+  /* The rank through a neighbor depends on the OF and instance settings */
+  rpl_neighbor_invalidate_all();
 
   /* OF */
   of = find_objective_function(ocp);
@@ -599,10 +642,22 @@ process_dio_init_dag(rpl_dio_t *dio)
 void
 rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 {
-  if(!curr_instance.used && !rpl_dag_root_is_root()) {
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+
+  /* The instance of the DIO, or an entry where to join it */
+  instance = rpl_instance_alloc(dio->instance_id);
+  if(instance == NULL) {
+    LOG_INFO("no room for instance %u, ignoring DIO\n", dio->instance_id);
+    return;
+  }
+  prev = rpl_instance_set_current(instance);
+
+  if(!curr_instance.used) {
     /* Attempt to init our DAG from this DIO */
     if(!process_dio_init_dag(dio)) {
       LOG_WARN("failed to init DAG\n");
+      rpl_instance_set_current(prev);
       return;
     }
   }
@@ -613,6 +668,8 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
     process_dio_from_current_dag(from, dio);
     rpl_dag_update_state();
   }
+
+  rpl_instance_set_current(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -633,9 +690,9 @@ void
 rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao)
 {
   if(dao->lifetime == 0) {
-    uip_sr_expire_parent(NULL, from, &dao->parent_addr);
+    uip_sr_expire_parent(RPL_SR_GRAPH, from, &dao->parent_addr);
   } else {
-    if(!uip_sr_update_node(NULL, from, &dao->parent_addr, RPL_LIFETIME(dao->lifetime))) {
+    if(!uip_sr_update_node(RPL_SR_GRAPH, from, &dao->parent_addr, RPL_LIFETIME(dao->lifetime))) {
       LOG_ERR("failed to add link on incoming DAO\n");
       return;
     }
@@ -665,6 +722,7 @@ rpl_process_dao_ack(uint8_t sequence, uint8_t status)
     }
     /* Let the rpl-timers module know that we got an ACK for the last DAO */
     rpl_timers_notify_dao_ack();
+    rpl_neighbor_notify_dao_ack();
 
     if(!status_ok) {
       /* We got a NACK, start poisoning and leave */
@@ -700,6 +758,7 @@ rpl_process_hbh(rpl_nbr_t *sender, uint16_t sender_rank, int loop_detected, int
      * the sender's rank from ext header */
     if(sender != NULL) {
       sender->rank = sender_rank;
+      rpl_neighbor_invalidate(sender);
       /* Select DAG and preferred parent. In case of a parent switch,
       the new parent will be used to forward the current packet. */
       rpl_dag_update_state();
@@ -709,11 +768,34 @@ rpl_process_hbh(rpl_nbr_t *sender, uint16_t sender_rank, int loop_detected, int
   return !drop;
 }
 /*---------------------------------------------------------------------------*/
-void
-rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
+/* The MinHopRankIncrease of a DAG we are root of */
+static rpl_rank_t
+root_min_hoprankinc(rpl_ocp_t ocp)
+{
+#ifndef RPL_CONF_MIN_HOPRANKINC
+  if(ocp != RPL_OF_OCP) {
+    /* The default for this OF, as in rpl-conf.h */
+    return ocp == RPL_OCP_MRHOF ? 128 : 256;
+  }
+#endif /* RPL_CONF_MIN_HOPRANKINC */
+  return RPL_MIN_HOPRANKINC;
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_dag_init_root(uint8_t instance_id, rpl_ocp_t ocp, uip_ipaddr_t *dag_id,
             uip_ipaddr_t *prefix, unsigned prefix_len, uint8_t prefix_flags)
 {
   uint8_t version = RPL_LOLLIPOP_INIT;
+  struct rpl_timers_profile profile;
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+
+  instance = rpl_instance_alloc(instance_id);
+  if(instance == NULL) {
+    LOG_ERR("no room for instance %u\n", instance_id);
+    return 0;
+  }
+  prev = rpl_instance_set_current(instance);
 
   /* If we're in an instance, first leave it */
   if(curr_instance.used) {
@@ -726,15 +808,19 @@ rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
   }
 
   /* Init DAG and instance */
-  init_dag(instance_id, dag_id, RPL_OF_OCP, prefix, prefix_len, prefix_flags);
+  if(!init_dag(instance_id, dag_id, ocp, prefix, prefix_len, prefix_flags)) {
+    rpl_instance_set_current(prev);
+    return 0;
+  }
 
   /* Instance */
   curr_instance.mop = RPL_MOP_DEFAULT;
   curr_instance.max_rankinc = RPL_MAX_RANKINC;
-  curr_instance.min_hoprankinc = RPL_MIN_HOPRANKINC;
-  curr_instance.dio_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
-  curr_instance.dio_intmin = RPL_DIO_INTERVAL_MIN;
-  curr_instance.dio_redundancy = RPL_DIO_REDUNDANCY;
+  curr_instance.min_hoprankinc = root_min_hoprankinc(ocp);
+  rpl_timers_get_profile(&profile);
+  curr_instance.dio_intdoubl = profile.dio_intdoubl;
+  curr_instance.dio_intmin = profile.dio_intmin;
+  curr_instance.dio_redundancy = profile.dio_redundancy;
   curr_instance.default_lifetime = RPL_DEFAULT_LIFETIME;
   curr_instance.lifetime_unit = RPL_DEFAULT_LIFETIME_UNIT;
 
@@ -750,18 +836,16 @@ rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
 
   rpl_timers_dio_reset("Init root");
 
-  LOG_INFO("created DAG with instance ID %u, DAG ID ",
-         curr_instance.instance_id);
+  LOG_INFO("created DAG with instance ID %u, OCP %u, DAG ID ",
+         curr_instance.instance_id, curr_instance.of->ocp);
   LOG_INFO_6ADDR(&curr_instance.dag.dag_id);
   LOG_INFO_(", rank %u\n", curr_instance.dag.rank);
 
   LOG_ANNOTATE("#A root=%u\n", curr_instance.dag.dag_id.u8[sizeof(curr_instance.dag.dag_id) - 1]);
-}
-/*---------------------------------------------------------------------------*/
-void
-rpl_dag_init(void)
-{
-  memset(&curr_instance, 0, sizeof(curr_instance));
+
+  rpl_dag_update_state();
+  rpl_instance_set_current(prev);
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -109,12 +109,15 @@ int rpl_is_addr_in_our_dag(const uip_ipaddr_t *addr);
  * Initializes DAG internal structure for a root node
  *
  * \param instance_id The instance ID
+ * \param ocp The objective code point of the OF
  * \param dag_id The DAG ID
  * \param prefix The prefix
  * \param prefix_len The prefix length
  * \param flags The prefix flags (from DIO)
+ * \return 1 on success, 0 if the OF is not supported or there is no room
+ * for the instance
 */
-void rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
+int rpl_dag_init_root(uint8_t instance_id, rpl_ocp_t ocp, uip_ipaddr_t *dag_id,
   uip_ipaddr_t *prefix, unsigned prefix_len, uint8_t flags);
 
 /**
@@ -187,11 +190,6 @@ int rpl_dag_ready_to_advertise(void);
 */
 void rpl_dag_update_state(void);
 
-/**
- * Initializes rpl-dag module
-*/
-void rpl_dag_init(void);
-
  /** @} */
 
 #endif /* RPL_DAG_H */
@@ -54,8 +54,8 @@
 #define LOG_LEVEL LOG_LEVEL_RPL
 
 /*---------------------------------------------------------------------------*/
-int
-rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
+static int
+srh_get_next_hop(uip_ipaddr_t *ipaddr)
 {
   struct uip_routing_hdr *rh_header;
   uip_sr_node_t *dest_node;
@@ -68,8 +68,8 @@ rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
     return 0;
   }
 
-  root_node = uip_sr_get_node(NULL, &curr_instance.dag.dag_id);
-  dest_node = uip_sr_get_node(NULL, &UIP_IP_BUF->destipaddr);
+  root_node = uip_sr_get_node(RPL_SR_GRAPH, &curr_instance.dag.dag_id);
+  dest_node = uip_sr_get_node(RPL_SR_GRAPH, &UIP_IP_BUF->destipaddr);
 
   if((rh_header != NULL && rh_header->routing_type == RPL_RH_TYPE_SRH) ||
      (dest_node != NULL && root_node != NULL &&
@@ -83,11 +83,53 @@ rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
     return 1;
   }
 
+#if RPL_MAX_INSTANCES > 1
+  /* Only the default instance installs a default route. Packets of the
+   * other instances go up through the preferred parent of their instance. */
+  if(!rpl_instance_is_default() && !rpl_dag_root_is_root()
+     && curr_instance.dag.preferred_parent != NULL
+     && !uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr)
+     && !uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+    uip_ipaddr_copy(ipaddr,
+                    rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent));
+    return 1;
+  }
+#endif /* RPL_MAX_INSTANCES > 1 */
+
   LOG_DBG("no SRH found\n");
   return 0;
 }
 /*---------------------------------------------------------------------------*/
 int
+rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
+{
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+  int ret;
+
+  instance = rpl_instance_for_packet();
+  if(instance == NULL) {
+    return 0;
+  }
+  prev = rpl_instance_set_current(instance);
+  ret = srh_get_next_hop(ipaddr);
+#if RPL_MAX_INSTANCES > 1
+  /* The root removed the headers telling the instance of forwarded
+   * packets: look for direct children in the graphs of its other instances */
+  for(instance = rpl_instances;
+      ret == 0 && instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used && instance != rpl_curr_instance
+       && instance->dag.rank == ROOT_RANK) {
+      rpl_instance_set_current(instance);
+      ret = srh_get_next_hop(ipaddr);
+    }
+  }
+#endif /* RPL_MAX_INSTANCES > 1 */
+  rpl_instance_set_current(prev);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+int
 rpl_ext_header_srh_update(void)
 {
   struct uip_routing_hdr *rh_header;
@@ -211,20 +253,20 @@ insert_srh_header(void)
     return 1;
   }
 
-  dest_node = uip_sr_get_node(NULL, &UIP_IP_BUF->destipaddr);
+  dest_node = uip_sr_get_node(RPL_SR_GRAPH, &UIP_IP_BUF->destipaddr);
   if(dest_node == NULL) {
     /* The destination is not found, skip SRH insertion */
     LOG_INFO("SRH node not found, skip SRH insertion\n");
     return 1;
   }
 
-  root_node = uip_sr_get_node(NULL, &curr_instance.dag.dag_id);
+  root_node = uip_sr_get_node(RPL_SR_GRAPH, &curr_instance.dag.dag_id);
   if(root_node == NULL) {
     LOG_ERR("SRH root node not found\n");
     return 0;
   }
 
-  if(!uip_sr_is_addr_reachable(NULL, &UIP_IP_BUF->destipaddr)) {
+  if(!uip_sr_is_addr_reachable(RPL_SR_GRAPH, &UIP_IP_BUF->destipaddr)) {
     LOG_ERR("SRH no path found to destination\n");
     return 0;
   }
@@ -315,8 +357,8 @@ insert_srh_header(void)
   return 1;
 }
 /*---------------------------------------------------------------------------*/
-int
-rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
+static int
+hbh_update(uint8_t *ext_buf, int opt_offset)
 {
   int down;
   int rank_error_signaled;
@@ -368,6 +410,19 @@ rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
   return rpl_process_hbh(sender, sender_rank, loop_detected, rank_error_signaled);
 }
 /*---------------------------------------------------------------------------*/
+int
+rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
+{
+  struct uip_ext_hdr_opt_rpl *rpl_opt = (struct uip_ext_hdr_opt_rpl *)(ext_buf + opt_offset);
+  rpl_instance_t *prev;
+  int ret;
+
+  prev = rpl_instance_set_current(rpl_instance_get(rpl_opt->instance));
+  ret = hbh_update(ext_buf, opt_offset);
+  rpl_instance_set_current(prev);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
 /* In-place update of the RPL HBH extension header, when already present
  * in the uIP packet. Used by insert_hbh_header and rpl_ext_header_update.
  * Returns 1 on success, 0 on failure. */
@@ -438,8 +493,8 @@ insert_hbh_header(void)
   return update_hbh_header();
 }
 /*---------------------------------------------------------------------------*/
-int
-rpl_ext_header_update(void)
+static int
+ext_header_update(void)
 {
   if(!curr_instance.used
       || uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr)
@@ -466,6 +521,24 @@ rpl_ext_header_update(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+int
+rpl_ext_header_update(void)
+{
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+  int ret;
+
+  /* Select the instance before the root removes the headers carrying it */
+  instance = rpl_instance_for_packet();
+  if(instance == NULL) {
+    return 1;
+  }
+  prev = rpl_instance_set_current(instance);
+  ret = ext_header_update();
+  rpl_instance_set_current(prev);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
 bool
 rpl_ext_header_remove(void)
 {
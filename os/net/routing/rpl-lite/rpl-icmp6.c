@@ -78,6 +78,8 @@ static void dao_ack_input(void);
 UIP_ICMP6_HANDLER(dao_ack_handler, ICMP6_RPL, RPL_CODE_DAO_ACK, dao_ack_input);
 #endif /* RPL_WITH_DAO_ACK */
 
+static struct rpl_icmp6_stats stats;
+
 /*---------------------------------------------------------------------------*/
 static uint32_t
 get32(uint8_t *buffer, int pos)
@@ -108,6 +110,23 @@ set16(uint8_t *buffer, int pos, uint16_t value)
   buffer[pos++] = value & 0xff;
 }
 /*---------------------------------------------------------------------------*/
+/* Counts the message in uip_buf */
+static void
+count_input(int type)
+{
+  stats.received[type]++;
+  stats.received_bytes[type] += uip_len - uip_l3_icmp_hdr_len + UIP_ICMPH_LEN;
+}
+/*---------------------------------------------------------------------------*/
+/* Counts a message with a payload of len bytes, and sends it */
+static void
+send_message(uip_ipaddr_t *dest, int code, int len, int type)
+{
+  stats.sent[type]++;
+  stats.sent_bytes[type] += UIP_ICMPH_LEN + len;
+  uip_icmp6_send(dest, ICMP6_RPL, code, len);
+}
+/*---------------------------------------------------------------------------*/
 uip_ds6_nbr_t *
 rpl_icmp6_update_nbr_table(uip_ipaddr_t *from, nbr_table_reason_t reason, void *data)
 {
@@ -131,7 +150,14 @@ rpl_icmp6_update_nbr_table(uip_ipaddr_t *from, nbr_table_reason_t reason, void *
 static void
 dis_input(void)
 {
-  if(!curr_instance.used) {
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+  uip_ipaddr_t from;
+  int is_multicast;
+
+  count_input(RPL_ICMP6_STATS_DIS);
+
+  if(rpl_instance_for_packet() == NULL) {
     LOG_WARN("dis_input: not in an instance yet, discard\n");
     goto discard;
   }
@@ -140,7 +166,17 @@ dis_input(void)
   LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
   LOG_INFO_("\n");
 
-  rpl_process_dis(&UIP_IP_BUF->srcipaddr, uip_is_addr_mcast(&UIP_IP_BUF->destipaddr));
+  /* The DIS solicits all instances. Replies overwrite uip_buf. */
+  uip_ipaddr_copy(&from, &UIP_IP_BUF->srcipaddr);
+  is_multicast = uip_is_addr_mcast(&UIP_IP_BUF->destipaddr);
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used) {
+      prev = rpl_instance_set_current(instance);
+      rpl_process_dis(&from, is_multicast);
+      rpl_instance_set_current(prev);
+    }
+  }
 
   discard:
     uipbuf_clear();
@@ -165,7 +201,7 @@ rpl_icmp6_dis_output(uip_ipaddr_t *addr)
   LOG_INFO_6ADDR(addr);
   LOG_INFO_("\n");
 
-  uip_icmp6_send(addr, ICMP6_RPL, RPL_CODE_DIS, 2);
+  send_message(addr, RPL_CODE_DIS, 2, RPL_ICMP6_STATS_DIS);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -179,6 +215,8 @@ dio_input(void)
   int len;
   uip_ipaddr_t from;
 
+  count_input(RPL_ICMP6_STATS_DIO);
+
   memset(&dio, 0, sizeof(dio));
 
   /* Set default values in case the DIO configuration option is missing. */
@@ -448,7 +486,7 @@ rpl_icmp6_dio_output(uip_ipaddr_t *uc_addr)
   LOG_INFO_6ADDR(addr);
   LOG_INFO_("\n");
 
-  uip_icmp6_send(addr, ICMP6_RPL, RPL_CODE_DIO, pos);
+  send_message(addr, RPL_CODE_DIO, pos, RPL_ICMP6_STATS_DIO);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -462,10 +500,14 @@ dao_input(void)
   int len;
   int i;
   uip_ipaddr_t from;
+  rpl_instance_t *prev;
+
+  count_input(RPL_ICMP6_STATS_DAO);
 
   memset(&dao, 0, sizeof(dao));
 
   dao.instance_id = UIP_ICMP_PAYLOAD[0];
+  prev = rpl_instance_set_current(rpl_instance_get(dao.instance_id));
   if(!curr_instance.used || curr_instance.instance_id != dao.instance_id) {
     LOG_ERR("dao_input: unknown RPL instance %u, discard\n", dao.instance_id);
     goto discard;
@@ -536,6 +578,7 @@ dao_input(void)
   rpl_process_dao(&from, &dao);
 
   discard:
+    rpl_instance_set_current(prev);
     uipbuf_clear();
 }
 /*---------------------------------------------------------------------------*/
@@ -615,7 +658,7 @@ rpl_icmp6_dao_output(uint8_t lifetime)
   LOG_INFO_("\n");
 
   /* Send DAO to root (IPv6 address is DAG ID) */
-  uip_icmp6_send(&curr_instance.dag.dag_id, ICMP6_RPL, RPL_CODE_DAO, pos);
+  send_message(&curr_instance.dag.dag_id, RPL_CODE_DAO, pos, RPL_ICMP6_STATS_DAO);
 }
 #if RPL_WITH_DAO_ACK
 /*---------------------------------------------------------------------------*/
@@ -626,6 +669,9 @@ dao_ack_input(void)
   uint8_t instance_id;
   uint8_t sequence;
   uint8_t status;
+  rpl_instance_t *prev;
+
+  count_input(RPL_ICMP6_STATS_DAO_ACK);
 
   buffer = UIP_ICMP_PAYLOAD;
 
@@ -633,6 +679,7 @@ dao_ack_input(void)
   sequence = buffer[2];
   status = buffer[3];
 
+  prev = rpl_instance_set_current(rpl_instance_get(instance_id));
   if(!curr_instance.used || curr_instance.instance_id != instance_id) {
     LOG_ERR("dao_ack_input: unknown instance, discard\n");
     goto discard;
@@ -647,6 +694,7 @@ dao_ack_input(void)
   rpl_process_dao_ack(sequence, status);
 
   discard:
+    rpl_instance_set_current(prev);
     uipbuf_clear();
 }
 /*---------------------------------------------------------------------------*/
@@ -669,7 +717,7 @@ rpl_icmp6_dao_ack_output(uip_ipaddr_t *dest, uint8_t sequence, uint8_t status)
   LOG_INFO_6ADDR(dest);
   LOG_INFO_(" with status %d\n", status);
 
-  uip_icmp6_send(dest, ICMP6_RPL, RPL_CODE_DAO_ACK, 4);
+  send_message(dest, RPL_CODE_DAO_ACK, 4, RPL_ICMP6_STATS_DAO_ACK);
 }
 #endif /* RPL_WITH_DAO_ACK */
 /*---------------------------------------------------------------------------*/
@@ -684,5 +732,19 @@ rpl_icmp6_init()
 #endif /* RPL_WITH_DAO_ACK */
 }
 /*---------------------------------------------------------------------------*/
+void
+rpl_icmp6_get_stats(struct rpl_icmp6_stats *s)
+{
+  if(s != NULL) {
+    memcpy(s, &stats, sizeof(stats));
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_icmp6_reset_stats(void)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+/*---------------------------------------------------------------------------*/
 
 /** @}*/
@@ -84,6 +84,24 @@ struct rpl_dao {
 };
 typedef struct rpl_dao rpl_dao_t;
 
+/* RPL control message types, as indices of the counters */
+enum {
+  RPL_ICMP6_STATS_DIS,
+  RPL_ICMP6_STATS_DIO,
+  RPL_ICMP6_STATS_DAO,
+  RPL_ICMP6_STATS_DAO_ACK,
+  RPL_ICMP6_STATS_TYPES
+};
+
+/* Counters of the RPL control messages sent and received, by type. The
+ * bytes are those of the ICMPv6 messages, without the IPv6 headers. */
+struct rpl_icmp6_stats {
+  uint32_t sent[RPL_ICMP6_STATS_TYPES];
+  uint32_t sent_bytes[RPL_ICMP6_STATS_TYPES];
+  uint32_t received[RPL_ICMP6_STATS_TYPES];
+  uint32_t received_bytes[RPL_ICMP6_STATS_TYPES];
+};
+
 /********** Public functions **********/
 
 /**
@@ -136,6 +154,18 @@ void rpl_icmp6_dao_ack_output(uip_ipaddr_t *dest, uint8_t sequence, uint8_t stat
 */
 void rpl_icmp6_init(void);
 
+/**
+ * Get the counters of RPL control messages
+ *
+ * \param stats Where to copy the counters
+*/
+void rpl_icmp6_get_stats(struct rpl_icmp6_stats *stats);
+
+/**
+ * Reset the counters of RPL control messages
+*/
+void rpl_icmp6_reset_stats(void);
+
  /** @} */
 
 #endif /* RPL_ICMP6_H_ */
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup rpl-lite
+ * @{
+ *
+ * \file
+ *         Instance table, and mapping of outgoing traffic to instances.
+ */
+
+#include "net/routing/rpl-lite/rpl.h"
+#include "net/ipv6/uip-icmp6.h"
+
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "RPL"
+#define LOG_LEVEL LOG_LEVEL_RPL
+
+/* Allocate instance table */
+rpl_instance_t rpl_instances[RPL_MAX_INSTANCES];
+
+#if RPL_MAX_INSTANCES > 1
+rpl_instance_t *rpl_curr_instance = &rpl_instances[0];
+
+/* Maps a flow label, or a DSCP if the flow label is 0, to an instance */
+struct instance_map_entry {
+  uint32_t flow_label;
+  uint8_t dscp;
+  uint8_t instance_id;
+};
+static struct instance_map_entry instance_map[RPL_INSTANCE_MAP_SIZE];
+static uint8_t instance_map_len;
+#endif /* RPL_MAX_INSTANCES > 1 */
+
+/*---------------------------------------------------------------------------*/
+#if RPL_MAX_INSTANCES > 1
+rpl_instance_t *
+rpl_instance_set_current(rpl_instance_t *instance)
+{
+  rpl_instance_t *prev = rpl_curr_instance;
+
+  rpl_curr_instance = instance != NULL ? instance : &rpl_instances[0];
+  rpl_neighbor_select_instance();
+  return prev;
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_instance_is_default(void)
+{
+  return rpl_curr_instance == &rpl_instances[0];
+}
+/*---------------------------------------------------------------------------*/
+static int
+map_add(uint32_t flow_label, uint8_t dscp, uint8_t instance_id)
+{
+  uint8_t i;
+
+  for(i = 0; i < instance_map_len; i++) {
+    if(instance_map[i].flow_label == flow_label
+       && (flow_label != 0 || instance_map[i].dscp == dscp)) {
+      break;
+    }
+  }
+  if(i == RPL_INSTANCE_MAP_SIZE) {
+    LOG_WARN("instance map full\n");
+    return 0;
+  }
+  if(i == instance_map_len) {
+    instance_map_len++;
+  }
+  instance_map[i].flow_label = flow_label;
+  instance_map[i].dscp = dscp;
+  instance_map[i].instance_id = instance_id;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static rpl_instance_t *
+map_lookup(void)
+{
+  uint8_t tc;
+  uint32_t flow_label;
+  rpl_instance_t *instance;
+  uint8_t i;
+
+  tc = ((UIP_IP_BUF->vtc & 0x0f) << 4) | (UIP_IP_BUF->tcflow >> 4);
+  flow_label = ((uint32_t)(UIP_IP_BUF->tcflow & 0x0f) << 16)
+    | UIP_HTONS(UIP_IP_BUF->flow);
+
+  if(flow_label != 0) {
+    for(i = 0; i < instance_map_len; i++) {
+      if(instance_map[i].flow_label == flow_label) {
+        instance = rpl_instance_get(instance_map[i].instance_id);
+        if(instance != NULL) {
+          return instance;
+        }
+      }
+    }
+  }
+  for(i = 0; i < instance_map_len; i++) {
+    if(instance_map[i].flow_label == 0 && instance_map[i].dscp == (tc >> 2)) {
+      instance = rpl_instance_get(instance_map[i].instance_id);
+      if(instance != NULL) {
+        return instance;
+      }
+    }
+  }
+  return NULL;
+}
+#endif /* RPL_MAX_INSTANCES > 1 */
+/*---------------------------------------------------------------------------*/
+rpl_instance_t *
+rpl_instance_get(uint8_t instance_id)
+{
+  rpl_instance_t *instance;
+
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used && instance->instance_id == instance_id) {
+      return instance;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+rpl_instance_t *
+rpl_instance_alloc(uint8_t instance_id)
+{
+  rpl_instance_t *instance;
+
+  instance = rpl_instance_get(instance_id);
+  if(instance != NULL) {
+    return instance;
+  }
+  if(instance_id == RPL_DEFAULT_INSTANCE || RPL_MAX_INSTANCES == 1) {
+    return rpl_instances[0].used ? NULL : &rpl_instances[0];
+  }
+  for(instance = rpl_instances + 1;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(!instance->used) {
+      return instance;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+rpl_instance_t *
+rpl_instance_for_packet(void)
+{
+#if RPL_MAX_INSTANCES > 1
+  struct uip_ext_hdr_opt_rpl *rpl_opt;
+  struct uip_icmp_hdr *icmp_hdr;
+  rpl_instance_t *instance;
+
+  /* Packets that already went through RPL carry their instance */
+  rpl_opt = (struct uip_ext_hdr_opt_rpl *)UIP_IP_PAYLOAD(2);
+  if(UIP_IP_BUF->proto == UIP_PROTO_HBHO
+     && uip_len >= UIP_IPH_LEN + RPL_HOP_BY_HOP_LEN
+     && rpl_opt->opt_type == UIP_EXT_HDR_OPT_RPL) {
+    instance = rpl_instance_get(rpl_opt->instance);
+  } else {
+    /* So do RPL control messages. DIS have no instance and are link-local. */
+    icmp_hdr = (struct uip_icmp_hdr *)uipbuf_search_header(uip_buf, uip_len,
+                                                            UIP_PROTO_ICMP6);
+    if(icmp_hdr != NULL && icmp_hdr->type == ICMP6_RPL
+       && icmp_hdr->icode != RPL_CODE_DIS
+       && (uint8_t *)icmp_hdr + UIP_ICMPH_LEN < uip_buf + uip_len) {
+      instance = rpl_instance_get(((uint8_t *)icmp_hdr)[UIP_ICMPH_LEN]);
+    } else {
+      instance = map_lookup();
+    }
+  }
+  if(instance != NULL) {
+    return instance;
+  }
+
+  /* The default instance, or any instance we are part of */
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used) {
+      return instance;
+    }
+  }
+  return NULL;
+#else /* RPL_MAX_INSTANCES > 1 */
+  return curr_instance.used ? &curr_instance : NULL;
+#endif /* RPL_MAX_INSTANCES > 1 */
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_instance_map_dscp(uint8_t dscp, uint8_t instance_id)
+{
+#if RPL_MAX_INSTANCES > 1
+  return map_add(0, dscp & 0x3f, instance_id);
+#else /* RPL_MAX_INSTANCES > 1 */
+  return 0;
+#endif /* RPL_MAX_INSTANCES > 1 */
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_instance_map_flow_label(uint32_t flow_label, uint8_t instance_id)
+{
+#if RPL_MAX_INSTANCES > 1
+  flow_label &= 0xfffff;
+  return flow_label != 0 && map_add(flow_label, 0, instance_id);
+#else /* RPL_MAX_INSTANCES > 1 */
+  return 0;
+#endif /* RPL_MAX_INSTANCES > 1 */
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_instance_clear_map(void)
+{
+#if RPL_MAX_INSTANCES > 1
+  instance_map_len = 0;
+#endif /* RPL_MAX_INSTANCES > 1 */
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_instance_init(void)
+{
+  memset(rpl_instances, 0, sizeof(rpl_instances));
+#if RPL_MAX_INSTANCES > 1
+  rpl_instance_set_current(NULL);
+  instance_map_len = 0;
+#endif /* RPL_MAX_INSTANCES > 1 */
+}
+/** @}*/
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+ /**
+ * \addtogroup rpl-lite
+ * @{
+ *
+ * \file
+ *	Header file for rpl-instance module. RPL Lite runs every instance
+ *	through curr_instance: the entry points (ICMPv6 input, timers, link
+ *	callback, extension header processing) make the instance they work
+ *	on current, and restore the default instance when done.
+ *
+ */
+
+#ifndef RPL_INSTANCE_H
+#define RPL_INSTANCE_H
+
+/********** Public symbols **********/
+
+/* The instance table. The first entry holds the default instance */
+extern rpl_instance_t rpl_instances[RPL_MAX_INSTANCES];
+
+#if RPL_MAX_INSTANCES > 1
+/* The instance being worked on */
+extern rpl_instance_t *rpl_curr_instance;
+#define curr_instance (*rpl_curr_instance)
+#define RPL_CURR_INSTANCE_INDEX (rpl_curr_instance - rpl_instances)
+/* Each instance has its own source routing graph at the root */
+#define RPL_SR_GRAPH ((void *)rpl_curr_instance)
+#else /* RPL_MAX_INSTANCES > 1 */
+#define curr_instance (rpl_instances[0])
+#define RPL_CURR_INSTANCE_INDEX 0
+#define RPL_SR_GRAPH NULL
+#endif /* RPL_MAX_INSTANCES > 1 */
+
+/********** Public functions **********/
+
+#if RPL_MAX_INSTANCES > 1
+/**
+ * Makes an instance the current one
+ *
+ * \param instance The instance, or NULL for the default instance
+ * \return The instance that was current until now
+ */
+rpl_instance_t *rpl_instance_set_current(rpl_instance_t *instance);
+
+/**
+ * Tells whether the current instance is the default one
+ *
+ * \return 1 if so, 0 otherwise
+ */
+int rpl_instance_is_default(void);
+#else /* RPL_MAX_INSTANCES > 1 */
+static inline rpl_instance_t *
+rpl_instance_set_current(rpl_instance_t *instance)
+{
+  return &rpl_instances[0];
+}
+static inline int
+rpl_instance_is_default(void)
+{
+  return 1;
+}
+#endif /* RPL_MAX_INSTANCES > 1 */
+
+/**
+ * Looks up an instance we are part of
+ *
+ * \param instance_id The RPL instance ID
+ * \return The instance, or NULL if we are not part of it
+ */
+rpl_instance_t *rpl_instance_get(uint8_t instance_id);
+
+/**
+ * Finds the entry for an instance we are about to join or start. This is
+ * the entry already used by the instance, or a free entry. The default
+ * instance always gets the first entry.
+ *
+ * \param instance_id The RPL instance ID
+ * \return The entry, or NULL if the table is full
+ */
+rpl_instance_t *rpl_instance_alloc(uint8_t instance_id);
+
+/**
+ * Selects the instance a packet in uip_buf belongs to: the instance of its
+ * RPL hop-by-hop option or of the RPL control message it carries, else the
+ * instance mapped to its flow label or DSCP, else the default instance.
+ *
+ * \return The instance, or NULL if we are not part of any instance
+ */
+rpl_instance_t *rpl_instance_for_packet(void);
+
+/**
+ * Sends the packets with a given DSCP through an instance
+ *
+ * \param dscp The Differentiated Services Code Point (6 bits)
+ * \param instance_id The RPL instance ID
+ * \return 1 on success, 0 if the map is full or with a single instance
+ */
+int rpl_instance_map_dscp(uint8_t dscp, uint8_t instance_id);
+
+/**
+ * Sends the packets with a given flow label through an instance. Flow
+ * label mappings take precedence over DSCP mappings.
+ *
+ * \param flow_label The IPv6 flow label (20 bits, non-zero)
+ * \param instance_id The RPL instance ID
+ * \return 1 on success, 0 if the map is full or with a single instance
+ */
+int rpl_instance_map_flow_label(uint32_t flow_label, uint8_t instance_id);
+
+/**
+ * Removes all DSCP and flow label mappings
+ */
+void rpl_instance_clear_map(void);
+
+/**
+ * Initializes the rpl-instance module
+ */
+void rpl_instance_init(void);
+
+ /** @} */
+
+#endif /* RPL_INSTANCE_H */
@@ -45,6 +45,7 @@
 #include "contiki.h"
 #include "net/routing/rpl-lite/rpl.h"
 #include "net/link-stats.h"
+#include "net/mac/mac.h"
 #include "net/nbr-table.h"
 #include "net/ipv6/uiplib.h"
 
@@ -57,12 +58,40 @@
 #ifdef RPL_CALLBACK_PARENT_SWITCH
 void RPL_CALLBACK_PARENT_SWITCH(rpl_nbr_t *old, rpl_nbr_t *new);
 #endif /* RPL_CALLBACK_PARENT_SWITCH */
+#ifdef RPL_CALLBACK_REQUEUE
+int RPL_CALLBACK_REQUEUE(const linkaddr_t *from, const linkaddr_t *to);
+#endif /* RPL_CALLBACK_REQUEUE */
 
 static rpl_nbr_t * best_parent(int fresh_only);
 
 /*---------------------------------------------------------------------------*/
 /* Per-neighbor RPL information */
+#if RPL_MAX_INSTANCES > 1
+/* One table per instance, as the rank of a neighbor and our rank through
+ * it depend on the DAG. rpl_neighbors is the table of the current instance. */
+static rpl_nbr_t neighbor_mem[RPL_MAX_INSTANCES][NBR_TABLE_MAX_NEIGHBORS];
+static nbr_table_t neighbor_tables[RPL_MAX_INSTANCES];
+nbr_table_t *rpl_neighbors = &neighbor_tables[0];
+#else /* RPL_MAX_INSTANCES > 1 */
 NBR_TABLE_GLOBAL(rpl_nbr_t, rpl_neighbors);
+#endif /* RPL_MAX_INSTANCES > 1 */
+
+/* The neighbors that the OF accepts as parents, by increasing path
+ * cost. A neighbor is moved when its rank, metric container or link
+ * changes, instead of asking the OF about all neighbors at each parent
+ * selection. */
+struct candidate_cache {
+  rpl_nbr_t *nbrs[NBR_TABLE_MAX_NEIGHBORS];
+  uint16_t count;
+  /* Set when the rank through some neighbor must be computed again */
+  uint8_t dirty;
+};
+static struct candidate_cache candidate_caches[RPL_MAX_INSTANCES];
+#define candidate_list (candidate_caches[RPL_CURR_INSTANCE_INDEX].nbrs)
+#define candidate_count (candidate_caches[RPL_CURR_INSTANCE_INDEX].count)
+#define cache_dirty (candidate_caches[RPL_CURR_INSTANCE_INDEX].dirty)
+
+static struct rpl_neighbor_stats nbr_stats;
 
 /*---------------------------------------------------------------------------*/
 static int
@@ -86,6 +115,107 @@ acceptable_rank(rpl_rank_t rank)
       && rank <= max_acceptable_rank();
 }
 /*---------------------------------------------------------------------------*/
+static void
+remove_candidate(rpl_nbr_t *nbr)
+{
+  uint16_t i;
+
+  for(i = 0; i < candidate_count; i++) {
+    if(candidate_list[i] == nbr) {
+      candidate_count--;
+      memmove(&candidate_list[i], &candidate_list[i + 1],
+              (candidate_count - i) * sizeof(candidate_list[0]));
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+insert_candidate(rpl_nbr_t *nbr)
+{
+  uint16_t i;
+
+  if(candidate_count >= NBR_TABLE_MAX_NEIGHBORS) {
+    return;
+  }
+  /* After the candidates with the same cost, so that the order of
+   * equal neighbors does not change with their updates */
+  for(i = candidate_count; i > 0 && candidate_list[i - 1]->path_cost > nbr->path_cost; i--) {
+    candidate_list[i] = candidate_list[i - 1];
+  }
+  candidate_list[i] = nbr;
+  candidate_count++;
+}
+/*---------------------------------------------------------------------------*/
+/* Asks the OF about a neighbor, and moves it among the candidates */
+static void
+update_cache(rpl_nbr_t *nbr)
+{
+  remove_candidate(nbr);
+  nbr->rank_via = curr_instance.of->rank_via_nbr(nbr);
+  nbr->path_cost = curr_instance.of->nbr_path_cost(nbr);
+  nbr->flags |= RPL_NBR_CACHED;
+  nbr_stats.recomputations++;
+  if(!(nbr->flags & RPL_NBR_FAILED)
+     && curr_instance.of->nbr_is_acceptable_parent(nbr)) {
+    nbr->flags |= RPL_NBR_CANDIDATE;
+    insert_candidate(nbr);
+  } else {
+    nbr->flags &= ~RPL_NBR_CANDIDATE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_all_caches(void)
+{
+  rpl_nbr_t *nbr;
+
+  if(!cache_dirty) {
+    return;
+  }
+  cache_dirty = 0;
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    if(!(nbr->flags & RPL_NBR_CACHED)) {
+      update_cache(nbr);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_invalidate(rpl_nbr_t *nbr)
+{
+  if(nbr != NULL) {
+    nbr->flags &= ~RPL_NBR_CACHED;
+    cache_dirty = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_invalidate_all(void)
+{
+  rpl_nbr_t *nbr;
+
+  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+    nbr->flags &= ~RPL_NBR_CACHED;
+  }
+  cache_dirty = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_get_stats(struct rpl_neighbor_stats *stats)
+{
+  if(stats != NULL) {
+    memcpy(stats, &nbr_stats, sizeof(*stats));
+    stats->candidates = candidate_count;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_reset_stats(void)
+{
+  memset(&nbr_stats, 0, sizeof(nbr_stats));
+}
+/*---------------------------------------------------------------------------*/
 int
 rpl_neighbor_snprint(char *buf, int buflen, rpl_nbr_t *nbr)
 {
@@ -205,10 +335,36 @@ remove_neighbor(rpl_nbr_t *nbr)
   if(nbr == curr_instance.dag.unicast_dio_target) {
     curr_instance.dag.unicast_dio_target = NULL;
   }
+  remove_candidate(nbr);
   nbr_table_remove(rpl_neighbors, nbr);
   rpl_timers_schedule_state_update(); /* Updating from here is unsafe; postpone */
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_MAX_INSTANCES > 1
+/* Called by the neighbor table when it evicts a neighbor */
+static void
+neighbor_removed(rpl_nbr_t *nbr)
+{
+  rpl_instance_t *prev;
+  int i;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(nbr >= neighbor_mem[i] && nbr < neighbor_mem[i] + NBR_TABLE_MAX_NEIGHBORS) {
+      prev = rpl_instance_set_current(&rpl_instances[i]);
+      remove_neighbor(nbr);
+      rpl_instance_set_current(prev);
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_select_instance(void)
+{
+  rpl_neighbors = &neighbor_tables[RPL_CURR_INSTANCE_INDEX];
+}
+#endif /* RPL_MAX_INSTANCES > 1 */
+/*---------------------------------------------------------------------------*/
 rpl_nbr_t *
 rpl_neighbor_get_from_lladdr(uip_lladdr_t *addr)
 {
@@ -237,7 +393,10 @@ rpl_rank_t
 rpl_neighbor_rank_via_nbr(rpl_nbr_t *nbr)
 {
   if(nbr != NULL && curr_instance.of->rank_via_nbr != NULL) {
-    return curr_instance.of->rank_via_nbr(nbr);
+    if(!(nbr->flags & RPL_NBR_CACHED)) {
+      update_cache(nbr);
+    }
+    return nbr->rank_via;
   }
   return RPL_INFINITE_RANK;
 }
@@ -258,8 +417,7 @@ rpl_neighbor_get_ipaddr(rpl_nbr_t *nbr)
 const struct link_stats *
 rpl_neighbor_get_link_stats(rpl_nbr_t *nbr)
 {
-  const linkaddr_t *lladdr = rpl_neighbor_get_lladdr(nbr);
-  return link_stats_from_lladdr(lladdr);
+  return link_stats_from_nbr_item(rpl_neighbors, nbr);
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -294,10 +452,13 @@ rpl_neighbor_set_preferred_parent(rpl_nbr_t *nbr)
     nbr_table_unlock(rpl_neighbors, curr_instance.dag.preferred_parent);
     nbr_table_lock(rpl_neighbors, nbr);
 
-    /* Update DS6 default route. Use an infinite lifetime */
-    uip_ds6_defrt_rm(uip_ds6_defrt_lookup(
-      rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent)));
-    uip_ds6_defrt_add(rpl_neighbor_get_ipaddr(nbr), 0);
+    /* Update DS6 default route. Use an infinite lifetime. The other
+     * instances route upwards through rpl_ext_header_srh_get_next_hop. */
+    if(rpl_instance_is_default()) {
+      uip_ds6_defrt_rm(uip_ds6_defrt_lookup(
+        rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent)));
+      uip_ds6_defrt_add(rpl_neighbor_get_ipaddr(nbr), 0);
+    }
 
     curr_instance.dag.preferred_parent = nbr;
     curr_instance.dag.unprocessed_parent_switch = true;
@@ -336,45 +497,188 @@ rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr)
   return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)lladdr);
 }
 /*---------------------------------------------------------------------------*/
+static int
+is_usable_candidate(rpl_nbr_t *nbr, int fresh_only)
+{
+  if(!acceptable_rank(nbr->rank_via)) {
+    /* Exclude neighbors with a rank that is not acceptable */
+    return 0;
+  }
+
+  if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
+    /* Filter out non-fresh nerighbors if fresh_only is set */
+    return 0;
+  }
+
+#if UIP_ND6_SEND_NS
+  /* Exclude links to a neighbor that is not reachable at a NUD level */
+  if(rpl_get_ds6_nbr(nbr) == NULL) {
+    return 0;
+  }
+#endif /* UIP_ND6_SEND_NS */
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
 best_parent(int fresh_only)
 {
   rpl_nbr_t *nbr;
   rpl_nbr_t *best = NULL;
+  rpl_nbr_t *preferred = curr_instance.dag.preferred_parent;
+  uint16_t i;
 
   if(curr_instance.used == 0) {
     return NULL;
   }
 
-  /* Search for the best parent according to the OF */
-  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+  update_all_caches();
+  nbr_stats.selections++;
 
-    if(!acceptable_rank(rpl_neighbor_rank_via_nbr(nbr))
-      || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
-      /* Exclude neighbors with a rank that is not acceptable */
-      continue;
-    }
+  /* Search for the best parent according to the OF, among the neighbors
+   * it accepts. The OFs pick the lowest path cost, unless the other
+   * neighbor is the preferred parent: only the neighbors with the lowest
+   * path cost and the preferred parent are compared. */
+  for(i = 0; i < candidate_count; i++) {
+    nbr = candidate_list[i];
 
-    if(fresh_only && !rpl_neighbor_is_fresh(nbr)) {
-      /* Filter out non-fresh nerighbors if fresh_only is set */
-      continue;
+    if(best != NULL && nbr->path_cost > best->path_cost) {
+      break;
     }
-
-#if UIP_ND6_SEND_NS
-    /* Exclude links to a neighbor that is not reachable at a NUD level */
-    if(rpl_get_ds6_nbr(nbr) == NULL) {
-      continue;
+    if(nbr != preferred && is_usable_candidate(nbr, fresh_only)) {
+      best = curr_instance.of->best_parent(best, nbr);
     }
-#endif /* UIP_ND6_SEND_NS */
+  }
 
-    /* Now we have an acceptable parent, check if it is the new best */
-    best = curr_instance.of->best_parent(best, nbr);
+  if(preferred != NULL && (preferred->flags & RPL_NBR_CANDIDATE)
+     && is_usable_candidate(preferred, fresh_only)) {
+    best = curr_instance.of->best_parent(best, preferred);
   }
 
   return best;
 }
 /*---------------------------------------------------------------------------*/
 rpl_nbr_t *
+rpl_neighbor_get_backup(int index)
+{
+  rpl_nbr_t *nbr;
+  uint16_t i;
+
+  if(curr_instance.used == 0) {
+    return NULL;
+  }
+
+  update_all_caches();
+
+  /* Only neighbors with a lower rank, so that switching to them at once
+   * does not create a loop */
+  for(i = 0; i < candidate_count; i++) {
+    nbr = candidate_list[i];
+    if(nbr != curr_instance.dag.preferred_parent
+       && rpl_neighbor_is_parent(nbr) && is_usable_candidate(nbr, 0)
+       && index-- == 0) {
+      return nbr;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_FAST_REPAIR_NOACKS
+/*
+ * The preferred parent stopped acknowledging our packets. This runs from
+ * the MAC sent callback, so only what cannot wait is done here: the parent
+ * switch and the new rank, which neither add nor remove neighbors, and the
+ * requeueing of the packets queued for the old parent. CSMA frees the
+ * packet that failed before it calls back, so that packet is not moved,
+ * and there is no queue left to move if it was the last one. The rest of
+ * the state update may remove neighbors, and is postponed.
+ */
+static void
+fast_repair(rpl_nbr_t *parent)
+{
+  rpl_nbr_t *backup;
+  linkaddr_t parent_lladdr;
+  uint32_t switch_time;
+
+  backup = rpl_neighbor_get_backup(0);
+  if(backup == NULL) {
+    /* Keep the parent, and let its link metric decide */
+    LOG_WARN("preferred parent failed, no backup parent\n");
+    nbr_stats.failed_repairs++;
+    return;
+  }
+
+  switch_time = (uint32_t)(clock_time() - curr_instance.dag.parent_failing_since)
+    * 1000 / CLOCK_SECOND;
+  nbr_stats.repairs++;
+  nbr_stats.switch_time += switch_time;
+  nbr_stats.max_switch_time = MAX(nbr_stats.max_switch_time, switch_time);
+  LOG_WARN("preferred parent failed after %u NOACKs in %lu ms, switching to backup ",
+           parent->noacks, (unsigned long)switch_time);
+  LOG_WARN_6ADDR(rpl_neighbor_get_ipaddr(backup));
+  LOG_WARN_("\n");
+
+  linkaddr_copy(&parent_lladdr, rpl_neighbor_get_lladdr(parent));
+  parent->flags |= RPL_NBR_FAILED;
+  rpl_neighbor_invalidate(parent);
+
+  rpl_neighbor_set_preferred_parent(backup);
+  curr_instance.dag.rank = rpl_neighbor_rank_via_nbr(backup);
+  curr_instance.dag.repaired_at = clock_time();
+
+#ifdef RPL_CALLBACK_REQUEUE
+  nbr_stats.requeued += RPL_CALLBACK_REQUEUE(&parent_lladdr,
+                                             rpl_neighbor_get_lladdr(backup));
+#endif /* RPL_CALLBACK_REQUEUE */
+
+  /* The DAO through the new parent is sent by the postponed update */
+  rpl_timers_schedule_state_update();
+}
+#endif /* RPL_FAST_REPAIR_NOACKS */
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_packet_sent(rpl_nbr_t *nbr, int status)
+{
+#if RPL_FAST_REPAIR_NOACKS
+  if(nbr == NULL) {
+    return;
+  }
+  if(status == MAC_TX_OK) {
+    nbr->noacks = 0;
+    if(nbr->flags & RPL_NBR_FAILED) {
+      nbr->flags &= ~RPL_NBR_FAILED;
+      rpl_neighbor_invalidate(nbr);
+    }
+  } else if(status == MAC_TX_NOACK) {
+    if(nbr->noacks < 0xff) {
+      nbr->noacks++;
+    }
+    if(nbr == curr_instance.dag.preferred_parent) {
+      if(nbr->noacks == 1) {
+        curr_instance.dag.parent_failing_since = clock_time();
+      }
+      if(nbr->noacks == RPL_FAST_REPAIR_NOACKS) {
+        fast_repair(nbr);
+      }
+    }
+  }
+#endif /* RPL_FAST_REPAIR_NOACKS */
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_neighbor_notify_dao_ack(void)
+{
+#if RPL_FAST_REPAIR_NOACKS
+  if(curr_instance.dag.repaired_at != 0) {
+    nbr_stats.acked_repairs++;
+    nbr_stats.ack_time += (uint32_t)(clock_time() - curr_instance.dag.repaired_at)
+      * 1000 / CLOCK_SECOND;
+    curr_instance.dag.repaired_at = 0;
+  }
+#endif /* RPL_FAST_REPAIR_NOACKS */
+}
+/*---------------------------------------------------------------------------*/
+rpl_nbr_t *
 rpl_neighbor_select_best(void)
 {
   rpl_nbr_t *best;
@@ -441,6 +745,18 @@ rpl_neighbor_select_best(void)
 void
 rpl_neighbor_init(void)
 {
+#if RPL_MAX_INSTANCES > 1
+  int i;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    neighbor_tables[i].item_size = sizeof(rpl_nbr_t);
+    neighbor_tables[i].data = (nbr_table_item_t *)neighbor_mem[i];
+    nbr_table_register(&neighbor_tables[i], (nbr_table_callback *)neighbor_removed);
+  }
+  rpl_neighbor_select_instance();
+#else /* RPL_MAX_INSTANCES > 1 */
   nbr_table_register(rpl_neighbors, (nbr_table_callback *)remove_neighbor);
+#endif /* RPL_MAX_INSTANCES > 1 */
+  memset(candidate_caches, 0, sizeof(candidate_caches));
 }
 /** @} */
@@ -64,6 +64,20 @@
  */
 NBR_TABLE_DECLARE(rpl_neighbors);
 
+/* Parent selection and fast repair counters */
+struct rpl_neighbor_stats {
+  uint32_t selections; /* Parent selections */
+  uint32_t recomputations; /* Ranks through a neighbor computed by the OF */
+  uint16_t candidates; /* Neighbors currently accepted by the OF */
+  uint16_t repairs; /* Switches to a backup parent after NOACKs */
+  uint16_t failed_repairs; /* Failures of the preferred parent without a backup */
+  uint16_t requeued; /* Packets moved to the queue of the new parent */
+  uint32_t switch_time; /* Total time from the first NOACK to the switch, in ms */
+  uint32_t max_switch_time; /* Longest time from the first NOACK to the switch, in ms */
+  uint16_t acked_repairs; /* Repairs where a DAO through the new parent was acknowledged */
+  uint32_t ack_time; /* Total time from the switch to that DAO ACK, in ms */
+};
+
 /********** Public functions **********/
 
 /**
@@ -71,6 +85,14 @@ NBR_TABLE_DECLARE(rpl_neighbors);
 */
 void rpl_neighbor_init(void);
 
+#if RPL_MAX_INSTANCES > 1
+/**
+ * Points rpl_neighbors to the neighbor table of the current instance.
+ * Called by rpl_instance_set_current.
+*/
+void rpl_neighbor_select_instance(void);
+#endif /* RPL_MAX_INSTANCES > 1 */
+
 /**
  * Tells whether a neighbor is in the parent set.
  *
@@ -184,6 +206,57 @@ void rpl_neighbor_remove_all(void);
 */
 rpl_nbr_t *rpl_neighbor_select_best(void);
 
+/**
+ * Tells that the rank through a neighbor must be computed again, because
+ * its rank, metric container or link statistics changed
+ *
+ * \param nbr The neighbor
+*/
+void rpl_neighbor_invalidate(rpl_nbr_t *nbr);
+
+/**
+ * Tells that the rank through all neighbors must be computed again,
+ * e.g. after a change of OF or instance settings
+*/
+void rpl_neighbor_invalidate_all(void);
+
+/**
+ * Returns a backup parent. The backup parents are the neighbors in the
+ * parent set that the OF accepts as parents, except the preferred parent,
+ * by increasing path cost.
+ *
+ * \param index The position in the backup parents, 0 for the best
+ * \return The backup parent, NULL if there are not that many
+*/
+rpl_nbr_t *rpl_neighbor_get_backup(int index);
+
+/**
+ * Tells the outcome of a unicast transmission to a neighbor. Used for
+ * fast repair, when RPL_FAST_REPAIR_NOACKS is set.
+ *
+ * \param nbr The neighbor
+ * \param status The MAC status (MAC_TX_OK, MAC_TX_NOACK, ...)
+*/
+void rpl_neighbor_packet_sent(rpl_nbr_t *nbr, int status);
+
+/**
+ * Tells that our last DAO was acknowledged. Used for the repair latency
+ * statistics.
+*/
+void rpl_neighbor_notify_dao_ack(void);
+
+/**
+ * Get the parent selection counters
+ *
+ * \param stats Where to copy the counters
+*/
+void rpl_neighbor_get_stats(struct rpl_neighbor_stats *stats);
+
+/**
+ * Reset the parent selection counters
+*/
+void rpl_neighbor_reset_stats(void);
+
 /**
 * Print a textual description of RPL neighbor into a string
 *
@@ -86,6 +86,14 @@ static void handle_state_update(void *ptr);
 static struct ctimer dis_timer; /* Not part of a DAG because when not joined */
 static struct ctimer periodic_timer; /* Not part of a DAG because used for general state maintenance */
 
+static struct rpl_timers_profile profile = {
+  RPL_DIO_INTERVAL_MIN,
+  RPL_DIO_INTERVAL_DOUBLINGS,
+  RPL_DIO_REDUNDANCY,
+  RPL_DAO_DELAY,
+  RPL_PROBING_INTERVAL
+};
+
 /*---------------------------------------------------------------------------*/
 /*------------------------------- DIS -------------------------------------- */
 /*---------------------------------------------------------------------------*/
@@ -98,13 +106,37 @@ rpl_timers_schedule_periodic_dis(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Tells whether we have not joined any instance yet, or some instance we
+ * are part of (but not root of) has no parent. DIS are not specific to an
+ * instance, and get us DIOs for all instances. */
+static int
+needs_dis(void)
+{
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+  int joined = 0;
+  int needed = 0;
+
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used) {
+      joined = 1;
+      prev = rpl_instance_set_current(instance);
+      if(!rpl_dag_root_is_root() &&
+         (curr_instance.dag.preferred_parent == NULL ||
+          curr_instance.dag.rank == RPL_INFINITE_RANK)) {
+        needed = 1;
+      }
+      rpl_instance_set_current(prev);
+    }
+  }
+  return !joined || needed;
+}
+/*---------------------------------------------------------------------------*/
 static void
 handle_dis_timer(void *ptr)
 {
-  if(!rpl_dag_root_is_root() &&
-     (!curr_instance.used ||
-       curr_instance.dag.preferred_parent == NULL ||
-       curr_instance.dag.rank == RPL_INFINITE_RANK)) {
+  if(needs_dis()) {
     /* Send DIS and schedule next */
     rpl_icmp6_dis_output(NULL);
     rpl_timers_schedule_periodic_dis();
@@ -139,7 +171,7 @@ new_dio_interval(void)
   curr_instance.dag.dio_counter = 0;
 
   /* schedule the timer */
-  ctimer_set(&curr_instance.dag.dio_timer, ticks, &handle_dio_timer, NULL);
+  ctimer_set(&curr_instance.dag.dio_timer, ticks, &handle_dio_timer, &curr_instance);
 
 #ifdef RPL_CALLBACK_NEW_DIO_INTERVAL
   RPL_CALLBACK_NEW_DIO_INTERVAL((CLOCK_SECOND * 1UL << curr_instance.dag.dio_intcurrent) / 1000);
@@ -168,7 +200,10 @@ rpl_timers_dio_reset(const char *str)
 static void
 handle_dio_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
+
   if(!rpl_dag_ready_to_advertise()) {
+    rpl_instance_set_current(prev);
     return; /* We will be scheduled again later */
   }
 
@@ -191,7 +226,7 @@ handle_dio_timer(void *ptr)
       rpl_icmp6_dio_output(NULL);
     }
     curr_instance.dag.dio_send = 0;
-    ctimer_set(&curr_instance.dag.dio_timer, curr_instance.dag.dio_next_delay, handle_dio_timer, NULL);
+    ctimer_set(&curr_instance.dag.dio_timer, curr_instance.dag.dio_next_delay, handle_dio_timer, &curr_instance);
   } else {
     /* check if we need to double interval */
     if(curr_instance.dag.dio_intcurrent < curr_instance.dio_intmin + curr_instance.dio_intdoubl) {
@@ -199,6 +234,7 @@ handle_dio_timer(void *ptr)
     }
     new_dio_interval();
   }
+  rpl_instance_set_current(prev);
 }
 /*---------------------------------------------------------------------------*/
 /*------------------------------- Unicast DIO ------------------------------ */
@@ -210,17 +246,19 @@ rpl_timers_schedule_unicast_dio(rpl_nbr_t *target)
   if(curr_instance.used) {
     curr_instance.dag.unicast_dio_target = target;
     ctimer_set(&curr_instance.dag.unicast_dio_timer, 0,
-                  handle_unicast_dio_timer, NULL);
+                  handle_unicast_dio_timer, &curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_unicast_dio_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
   uip_ipaddr_t *target_ipaddr = rpl_neighbor_get_ipaddr(curr_instance.dag.unicast_dio_target);
   if(target_ipaddr != NULL) {
     rpl_icmp6_dio_output(target_ipaddr);
   }
+  rpl_instance_set_current(prev);
 }
 /*---------------------------------------------------------------------------*/
 /*------------------------------- DAO -------------------------------------- */
@@ -231,7 +269,7 @@ static void
 schedule_dao_retransmission(void)
 {
   clock_time_t expiration_time = RPL_DAO_RETRANSMISSION_TIMEOUT / 2 + (random_rand() % (RPL_DAO_RETRANSMISSION_TIMEOUT));
-  ctimer_set(&curr_instance.dag.dao_timer, expiration_time, resend_dao, NULL);
+  ctimer_set(&curr_instance.dag.dao_timer, expiration_time, resend_dao, &curr_instance);
 }
 #endif /* RPL_WITH_DAO_ACK */
 /*---------------------------------------------------------------------------*/
@@ -255,7 +293,7 @@ schedule_dao_refresh(void)
     }
 
     /* Schedule transmission */
-    ctimer_set(&curr_instance.dag.dao_timer, target_refresh, send_new_dao, NULL);
+    ctimer_set(&curr_instance.dag.dao_timer, target_refresh, send_new_dao, &curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -266,14 +304,16 @@ rpl_timers_schedule_dao(void)
     /* No need for DAO aggregation delay as per RFC 6550 section 9.5, as this
     * only serves storing mode. Use simple delay instead, with the only purpose
     * to reduce congestion. */
-    clock_time_t expiration_time = RPL_DAO_DELAY / 2 + (random_rand() % (RPL_DAO_DELAY));
-    ctimer_set(&curr_instance.dag.dao_timer, expiration_time, send_new_dao, NULL);
+    clock_time_t expiration_time = profile.dao_delay / 2 + (random_rand() % (profile.dao_delay));
+    ctimer_set(&curr_instance.dag.dao_timer, expiration_time, send_new_dao, &curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 send_new_dao(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
+
 #if RPL_WITH_DAO_ACK
   /* We are sending a new DAO here. Prepare retransmissions */
   curr_instance.dag.dao_transmissions = 1;
@@ -293,6 +333,7 @@ send_new_dao(void *ptr)
   RPL_LOLLIPOP_INCREMENT(curr_instance.dag.dao_last_seqno);
   /* Send a DAO with own prefix as target and default lifetime */
   rpl_icmp6_dao_output(curr_instance.default_lifetime);
+  rpl_instance_set_current(prev);
 }
 #if RPL_WITH_DAO_ACK
 /*---------------------------------------------------------------------------*/
@@ -305,15 +346,17 @@ rpl_timers_schedule_dao_ack(uip_ipaddr_t *target, uint16_t sequence)
   if(curr_instance.used) {
     uip_ipaddr_copy(&curr_instance.dag.dao_ack_target, target);
     curr_instance.dag.dao_ack_sequence = sequence;
-    ctimer_set(&curr_instance.dag.dao_ack_timer, 0, handle_dao_ack_timer, NULL);
+    ctimer_set(&curr_instance.dag.dao_ack_timer, 0, handle_dao_ack_timer, &curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_dao_ack_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
   rpl_icmp6_dao_ack_output(&curr_instance.dag.dao_ack_target,
     curr_instance.dag.dao_ack_sequence, RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+  rpl_instance_set_current(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -327,6 +370,8 @@ rpl_timers_notify_dao_ack(void)
 static void
 resend_dao(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
+
   /* Increment transmission counter before sending */
   curr_instance.dag.dao_transmissions++;
   /* Send a DAO with own prefix as target and default lifetime */
@@ -338,8 +383,8 @@ resend_dao(void *ptr)
   } else {
     /* No more retransmissions. Perform local repair. */
     rpl_local_repair("DAO max rtx");
-    return;
   }
+  rpl_instance_set_current(prev);
 }
 #endif /* RPL_WITH_DAO_ACK */
 /*---------------------------------------------------------------------------*/
@@ -349,7 +394,7 @@ resend_dao(void *ptr)
 clock_time_t
 get_probing_delay(void)
 {
-  return ((RPL_PROBING_INTERVAL) / 2) + random_rand() % (RPL_PROBING_INTERVAL);
+  return (profile.probing_interval / 2) + random_rand() % (profile.probing_interval);
 }
 /*---------------------------------------------------------------------------*/
 rpl_nbr_t *
@@ -425,6 +470,7 @@ get_probing_target(void)
 static void
 handle_probing_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
   rpl_nbr_t *probing_target = RPL_PROBING_SELECT_FUNC();
   uip_ipaddr_t *target_ipaddr = rpl_neighbor_get_ipaddr(probing_target);
 
@@ -448,6 +494,7 @@ handle_probing_timer(void *ptr)
 
   /* Schedule next probing */
   rpl_schedule_probing();
+  rpl_instance_set_current(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -455,7 +502,7 @@ rpl_schedule_probing(void)
 {
   if(curr_instance.used) {
     ctimer_set(&curr_instance.dag.probing_timer, RPL_PROBING_DELAY_FUNC(),
-                  handle_probing_timer, NULL);
+                  handle_probing_timer, &curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -464,7 +511,7 @@ rpl_schedule_probing_now(void)
 {
   if(curr_instance.used) {
     ctimer_set(&curr_instance.dag.probing_timer,
-      random_rand() % (CLOCK_SECOND * 4), handle_probing_timer, NULL);
+      random_rand() % (CLOCK_SECOND * 4), handle_probing_timer, &curr_instance);
   }
 }
 #endif /* RPL_WITH_PROBING */
@@ -474,9 +521,11 @@ rpl_schedule_probing_now(void)
 static void
 handle_leaving_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
   if(curr_instance.used) {
     rpl_dag_leave();
   }
+  rpl_instance_set_current(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -494,7 +543,7 @@ rpl_timers_schedule_leaving(void)
 {
   if(curr_instance.used) {
     if(ctimer_expired(&curr_instance.dag.leave)) {
-      ctimer_set(&curr_instance.dag.leave, RPL_DELAY_BEFORE_LEAVING, handle_leaving_timer, NULL);
+      ctimer_set(&curr_instance.dag.leave, RPL_DELAY_BEFORE_LEAVING, handle_leaving_timer, &curr_instance);
     }
   }
 }
@@ -511,24 +560,35 @@ rpl_timers_init(void)
 static void
 handle_periodic_timer(void *ptr)
 {
-  if(curr_instance.used) {
-    rpl_dag_periodic(PERIODIC_DELAY_SECONDS);
-    uip_sr_periodic(PERIODIC_DELAY_SECONDS);
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+  int used = 0;
+
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used) {
+      prev = rpl_instance_set_current(instance);
+      rpl_dag_periodic(PERIODIC_DELAY_SECONDS);
+      used = 1;
+
+      /* Useful because part of the state update is time-dependent, e.g.,
+      the meaning of last_advertised_rank changes with time */
+      rpl_dag_update_state();
+
+      if(LOG_INFO_ENABLED) {
+        rpl_neighbor_print_list("Periodic");
+        rpl_dag_root_print_links("Periodic");
+      }
+      rpl_instance_set_current(prev);
+    }
   }
 
-  if(!curr_instance.used ||
-      curr_instance.dag.preferred_parent == NULL ||
-      curr_instance.dag.rank == RPL_INFINITE_RANK) {
-    rpl_timers_schedule_periodic_dis(); /* Schedule DIS if needed */
+  if(used) {
+    uip_sr_periodic(PERIODIC_DELAY_SECONDS);
   }
 
-  /* Useful because part of the state update is time-dependent, e.g.,
-  the meaning of last_advertised_rank changes with time */
-  rpl_dag_update_state();
-
-  if(LOG_INFO_ENABLED) {
-    rpl_neighbor_print_list("Periodic");
-    rpl_dag_root_print_links("Periodic");
+  if(needs_dis()) {
+    rpl_timers_schedule_periodic_dis(); /* Schedule DIS if needed */
   }
 
   ctimer_reset(&periodic_timer);
@@ -563,14 +623,71 @@ void
 rpl_timers_schedule_state_update(void)
 {
   if(curr_instance.used) {
-    ctimer_set(&curr_instance.dag.state_update, 0, handle_state_update, NULL);
+    ctimer_set(&curr_instance.dag.state_update, 0, handle_state_update, &curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_state_update(void *ptr)
 {
+  rpl_instance_t *prev = rpl_instance_set_current(ptr);
   rpl_dag_update_state();
+  rpl_instance_set_current(prev);
+}
+/*---------------------------------------------------------------------------*/
+/*------------------------------- Profile ---------------------------------- */
+/*---------------------------------------------------------------------------*/
+void
+rpl_timers_get_profile(struct rpl_timers_profile *p)
+{
+  if(p != NULL) {
+    memcpy(p, &profile, sizeof(profile));
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_timers_set_profile(const struct rpl_timers_profile *p)
+{
+  unsigned max_interval;
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+
+  if(p == NULL) {
+    return 0;
+  }
+
+  /* The longest interval, in ms, must fit in clock ticks on 32 bits */
+  max_interval = p->dio_intmin + p->dio_intdoubl;
+  if(p->dio_intmin == 0 || max_interval > 31
+     || (1UL << max_interval) > 0xffffffffUL / CLOCK_SECOND) {
+    return 0;
+  }
+  /* The delays are randomized modulo their value */
+  if(p->dao_delay == 0 || p->probing_interval == 0) {
+    return 0;
+  }
+
+  memcpy(&profile, p, sizeof(profile));
+
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    prev = rpl_instance_set_current(instance);
+    if(curr_instance.used && rpl_dag_root_is_root()) {
+      curr_instance.dio_intmin = profile.dio_intmin;
+      curr_instance.dio_intdoubl = profile.dio_intdoubl;
+      curr_instance.dio_redundancy = profile.dio_redundancy;
+      /* Restart Trickle from the new Imin */
+      curr_instance.dag.dio_intcurrent = 0;
+      rpl_timers_dio_reset("Profile");
+    }
+    rpl_instance_set_current(prev);
+  }
+
+  LOG_INFO("profile: Trickle Imin %u, doublings %u, redundancy %u, DAO delay %lu, probing %lu\n",
+           profile.dio_intmin, profile.dio_intdoubl, profile.dio_redundancy,
+           (unsigned long)profile.dao_delay, (unsigned long)profile.probing_interval);
+
+  return 1;
 }
 
 /** @}*/
@@ -49,6 +49,20 @@
 
 #include "net/routing/rpl-lite/rpl.h"
 
+/********** Data structures **********/
+
+/* Control-plane profile. The Trickle parameters are those of the DAGs
+ * that the node roots, and are advertised in its DIOs: the other nodes
+ * take them from the DAG they join. The DAO delay and the probing
+ * interval apply locally. */
+struct rpl_timers_profile {
+  uint8_t dio_intmin; /* Trickle Imin, as log2 of milliseconds */
+  uint8_t dio_intdoubl; /* Trickle doublings of Imin */
+  uint8_t dio_redundancy; /* Trickle redundancy constant, 0 to never suppress DIOs */
+  clock_time_t dao_delay; /* DAOs are delayed by dao_delay +/- dao_delay/2 */
+  clock_time_t probing_interval; /* Probing every probing_interval +/- probing_interval/2 */
+};
+
 /********** Public functions **********/
 
 /**
@@ -125,6 +139,25 @@ void rpl_timers_schedule_state_update(void);
 */
 void rpl_timers_unschedule_state_update(void);
 
+/**
+ * Get the current control-plane profile. It is initialized from
+ * RPL_DIO_INTERVAL_MIN, RPL_DIO_INTERVAL_DOUBLINGS, RPL_DIO_REDUNDANCY,
+ * RPL_DAO_DELAY and RPL_PROBING_INTERVAL.
+ *
+ * \param profile Where to copy the profile
+*/
+void rpl_timers_get_profile(struct rpl_timers_profile *profile);
+
+/**
+ * Set the control-plane profile. If the node is a DAG root, the new
+ * Trickle parameters apply to its DAG at once, and reach the other nodes
+ * with the next global repair.
+ *
+ * \param profile The new profile
+ * \return 1 if the profile was applied, 0 if a parameter is out of range
+*/
+int rpl_timers_set_profile(const struct rpl_timers_profile *profile);
+
  /** @} */
 
 #endif /* RPL_TIMERS_H */
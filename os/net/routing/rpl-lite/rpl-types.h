@@ -141,10 +141,21 @@ struct rpl_nbr {
   rpl_metric_container_t mc;
 #endif /* RPL_WITH_MC */
   rpl_rank_t rank;
+  rpl_rank_t rank_via; /* Our rank through the neighbor and the path cost,
+  as last computed by the OF. Valid if RPL_NBR_CACHED is set in 'flags'. */
+  uint16_t path_cost;
   uint8_t dtsn;
+  uint8_t flags;
+#if RPL_FAST_REPAIR_NOACKS
+  uint8_t noacks; /* Packets in a row the neighbor did not acknowledge */
+#endif /* RPL_FAST_REPAIR_NOACKS */
 };
 typedef struct rpl_nbr rpl_nbr_t;
 
+#define RPL_NBR_CACHED     0x01 /* rank_via, path_cost and RPL_NBR_CANDIDATE are valid */
+#define RPL_NBR_CANDIDATE  0x02 /* The OF accepts the neighbor as a parent */
+#define RPL_NBR_FAILED     0x04 /* Left by fast repair, and not heard from since */
+
 /*---------------------------------------------------------------------------*/
  /**
   * \brief API for RPL objective functions (OF)
@@ -219,6 +230,10 @@ struct rpl_dag {
   uint16_t dao_ack_sequence;
   struct ctimer dao_ack_timer;
 #endif /* RPL_WITH_DAO_ACK */
+#if RPL_FAST_REPAIR_NOACKS
+  clock_time_t parent_failing_since; /* First NOACK of the preferred parent in a row */
+  clock_time_t repaired_at; /* Last fast repair, until the DAO through the new parent is acknowledged */
+#endif /* RPL_FAST_REPAIR_NOACKS */
 };
 typedef struct rpl_dag rpl_dag_t;
 
@@ -93,25 +93,43 @@ rpl_get_global_address(void)
   return ipaddr;
 }
 /*---------------------------------------------------------------------------*/
-void
-rpl_link_callback(const linkaddr_t *addr, int status, int numtx)
+static void
+link_callback_instance(const linkaddr_t *addr, int status, int numtx)
 {
-  if(curr_instance.used == 1 ) {
-    rpl_nbr_t *nbr = rpl_neighbor_get_from_lladdr((uip_lladdr_t *)addr);
-    if(nbr != NULL) {
-      /* If this is the neighbor we were probing urgently, mark urgent
-      probing as done */
+  rpl_nbr_t *nbr = rpl_neighbor_get_from_lladdr((uip_lladdr_t *)addr);
+  if(nbr != NULL) {
+    /* If this is the neighbor we were probing urgently, mark urgent
+    probing as done */
 #if RPL_WITH_PROBING
-      if(curr_instance.dag.urgent_probing_target == nbr) {
-        curr_instance.dag.urgent_probing_target = NULL;
-      }
+    if(curr_instance.dag.urgent_probing_target == nbr) {
+      curr_instance.dag.urgent_probing_target = NULL;
+    }
 #endif
-      /* Link stats were updated, and we need to update our internal state.
-      Updating from here is unsafe; postpone */
-      LOG_INFO("packet sent to ");
-      LOG_INFO_LLADDR(addr);
-      LOG_INFO_(", status %u, tx %u, new link metric %u\n", status, numtx, rpl_neighbor_get_link_metric(nbr));
-      rpl_timers_schedule_state_update();
+    /* Link stats were updated, and we need to update our internal state.
+    Updating from here is unsafe; postpone */
+    rpl_neighbor_invalidate(nbr);
+    /* Consecutive NOACKs from the preferred parent trigger fast repair */
+    rpl_neighbor_packet_sent(nbr, status);
+    LOG_INFO("packet sent to ");
+    LOG_INFO_LLADDR(addr);
+    LOG_INFO_(", status %u, tx %u, new link metric %u\n", status, numtx, rpl_neighbor_get_link_metric(nbr));
+    rpl_timers_schedule_state_update();
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_link_callback(const linkaddr_t *addr, int status, int numtx)
+{
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+
+  /* The link is shared by all instances that have the neighbor */
+  for(instance = rpl_instances;
+      instance < rpl_instances + RPL_MAX_INSTANCES; instance++) {
+    if(instance->used == 1) {
+      prev = rpl_instance_set_current(instance);
+      link_callback_instance(addr, status, numtx);
+      rpl_instance_set_current(prev);
     }
   }
 }
@@ -199,7 +217,7 @@ init(void)
   uip_create_linklocal_rplnodes_mcast(&rpl_multicast_addr);
   uip_ds6_maddr_add(&rpl_multicast_addr);
 
-  rpl_dag_init();
+  rpl_instance_init();
   rpl_neighbor_init();
   rpl_timers_init();
   rpl_icmp6_init();
@@ -211,7 +229,9 @@ static int
 get_sr_node_ipaddr(uip_ipaddr_t *addr, const uip_sr_node_t *node)
 {
   if(addr != NULL && node != NULL) {
-    memcpy(addr, &curr_instance.dag.dag_id, 8);
+    /* The graph is the instance, with several instances */
+    const rpl_instance_t *instance = node->graph != NULL ? node->graph : &curr_instance;
+    memcpy(addr, &instance->dag.dag_id, 8);
     memcpy(((unsigned char *)addr) + 8, &node->link_identifier, 8);
     return 1;
   } else {
@@ -51,6 +51,7 @@
 #include "net/routing/rpl-lite/rpl-const.h"
 #include "net/routing/rpl-lite/rpl-conf.h"
 #include "net/routing/rpl-lite/rpl-types.h"
+#include "net/routing/rpl-lite/rpl-instance.h"
 #include "net/routing/rpl-lite/rpl-icmp6.h"
 #include "net/routing/rpl-lite/rpl-dag.h"
 #include "net/routing/rpl-lite/rpl-dag-root.h"
@@ -60,8 +61,6 @@
 
 /********** Public symbols **********/
 
-/* The only instance */
-extern rpl_instance_t curr_instance;
 /* The RPL multicast address (used for DIS and DIO) */
 extern uip_ipaddr_t rpl_multicast_addr;
 
@@ -46,15 +46,140 @@
 #define NUM_ENTRIES 32
 #endif /* IP64_ADDRMAP_CONF_ENTRIES */
 
+/* The number of buckets of each of the two hash tables: one for the
+   lookups from the IPv6 side, by the address/port/protocol tuple,
+   and one for the lookups from the IPv4 side, by the mapped port. */
+#ifdef IP64_ADDRMAP_CONF_HASH_SIZE
+#define HASH_SIZE IP64_ADDRMAP_CONF_HASH_SIZE
+#else /* IP64_ADDRMAP_CONF_HASH_SIZE */
+#define HASH_SIZE 16
+#endif /* IP64_ADDRMAP_CONF_HASH_SIZE */
+
+/* The mappings are expired through a timer wheel of WHEEL_SLOTS
+   slots, each covering WHEEL_TICK clock ticks. A mapping is put in
+   the slot of its expiry time, so that only the slots that have
+   passed need to be looked at. Lifetimes that are longer than the
+   wheel go into its last slot. When that slot is reached, the mappings
+   that have not expired are put back in the slot of their remaining
+   lifetime, so they take several turns of the wheel. */
+#ifdef IP64_ADDRMAP_CONF_WHEEL_SLOTS
+#define WHEEL_SLOTS IP64_ADDRMAP_CONF_WHEEL_SLOTS
+#else /* IP64_ADDRMAP_CONF_WHEEL_SLOTS */
+#define WHEEL_SLOTS 64
+#endif /* IP64_ADDRMAP_CONF_WHEEL_SLOTS */
+
+#ifdef IP64_ADDRMAP_CONF_WHEEL_TICK
+#define WHEEL_TICK IP64_ADDRMAP_CONF_WHEEL_TICK
+#else /* IP64_ADDRMAP_CONF_WHEEL_TICK */
+#define WHEEL_TICK (CLOCK_SECOND * 8)
+#endif /* IP64_ADDRMAP_CONF_WHEEL_TICK */
+
 MEMB(entrymemb, struct ip64_addrmap_entry, NUM_ENTRIES);
 LIST(entrylist);
 
+static struct ip64_addrmap_entry *flow_table[HASH_SIZE];
+static struct ip64_addrmap_entry *port_table[HASH_SIZE];
+
+static struct ip64_addrmap_entry *wheel[WHEEL_SLOTS];
+static uint16_t wheel_slot;
+static clock_time_t wheel_time;
+
 #define FIRST_MAPPED_PORT 10000
 #define LAST_MAPPED_PORT  20000
 static uint16_t mapped_port = FIRST_MAPPED_PORT;
 
 #define printf(...)
 
+/*---------------------------------------------------------------------------*/
+static uint16_t
+flow_hash(const uip_ip6addr_t *ip6addr, uint16_t ip6port,
+          const uip_ip4addr_t *ip4addr, uint16_t ip4port,
+          uint8_t protocol)
+{
+  uint16_t hash;
+  uint8_t i;
+
+  hash = protocol;
+  for(i = 0; i < 8; i++) {
+    hash = hash * 31 + ip6addr->u16[i];
+  }
+  hash = hash * 31 + ip4addr->u16[0];
+  hash = hash * 31 + ip4addr->u16[1];
+  hash = hash * 31 + ip6port;
+  hash = hash * 31 + ip4port;
+  return hash % HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+port_hash(uint16_t port)
+{
+  return port % HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+wheel_offset(struct ip64_addrmap_entry *m)
+{
+  /* The expiry time, counted from the start of the current slot */
+  if(timer_expired(&m->timer)) {
+    return 0;
+  }
+  return (clock_time_t)(m->timer.start + m->timer.interval - wheel_time);
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_add(struct ip64_addrmap_entry *m)
+{
+  clock_time_t offset;
+  uint16_t slot;
+
+  offset = wheel_offset(m);
+  if(offset / WHEEL_TICK >= WHEEL_SLOTS) {
+    slot = (wheel_slot + WHEEL_SLOTS - 1) % WHEEL_SLOTS;
+  } else {
+    slot = (wheel_slot + offset / WHEEL_TICK) % WHEEL_SLOTS;
+  }
+
+  m->wheel_next = wheel[slot];
+  if(m->wheel_next != NULL) {
+    m->wheel_next->wheel_prevp = &m->wheel_next;
+  }
+  m->wheel_prevp = &wheel[slot];
+  wheel[slot] = m;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_remove(struct ip64_addrmap_entry *m)
+{
+  *m->wheel_prevp = m->wheel_next;
+  if(m->wheel_next != NULL) {
+    m->wheel_next->wheel_prevp = m->wheel_prevp;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_entry(struct ip64_addrmap_entry *m)
+{
+  struct ip64_addrmap_entry **p;
+
+  for(p = &flow_table[flow_hash(&m->ip6addr, m->ip6port,
+                                &m->ip4addr, m->ip4port, m->protocol)];
+      *p != NULL; p = &(*p)->flow_next) {
+    if(*p == m) {
+      *p = m->flow_next;
+      break;
+    }
+  }
+  for(p = &port_table[port_hash(m->mapped_port)];
+      *p != NULL; p = &(*p)->port_next) {
+    if(*p == m) {
+      *p = m->port_next;
+      break;
+    }
+  }
+  wheel_remove(m);
+  list_remove(entrylist, m);
+  memb_free(&entrymemb, m);
+}
 /*---------------------------------------------------------------------------*/
 struct ip64_addrmap_entry *
 ip64_addrmap_list(void)
@@ -62,31 +187,62 @@ ip64_addrmap_list(void)
   return list_head(entrylist);
 }
 /*---------------------------------------------------------------------------*/
+int
+ip64_addrmap_count(void)
+{
+  return list_length(entrylist);
+}
+/*---------------------------------------------------------------------------*/
 void
 ip64_addrmap_init(void)
 {
   memb_init(&entrymemb);
   list_init(entrylist);
+  memset(flow_table, 0, sizeof(flow_table));
+  memset(port_table, 0, sizeof(port_table));
+  memset(wheel, 0, sizeof(wheel));
+  wheel_slot = 0;
+  wheel_time = clock_time();
   mapped_port = FIRST_MAPPED_PORT;
 }
 /*---------------------------------------------------------------------------*/
 static void
-check_age(void)
+expire_slot(uint16_t slot)
 {
-  struct ip64_addrmap_entry *m;
+  struct ip64_addrmap_entry *m, *next;
 
-  /* Walk through the list of address mappings, throw away the ones
-     that are too old. */
-  m = list_head(entrylist);
-  while(m != NULL) {
+  for(m = wheel[slot]; m != NULL; m = next) {
+    next = m->wheel_next;
     if(timer_expired(&m->timer)) {
-      list_remove(entrylist, m);
-      memb_free(&entrymemb, m);
-      m = list_head(entrylist);
-    } else {
-      m = list_item_next(m);
+      remove_entry(m);
+    } else if(wheel_offset(m) >= WHEEL_TICK) {
+      /* A lifetime longer than the wheel, for another turn */
+      wheel_remove(m);
+      wheel_add(m);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+check_age(void)
+{
+  clock_time_t now;
+  uint16_t steps;
+
+  /* Turn the wheel up to the current time, throwing away the address
+     mappings that are too old in each slot that it passes. */
+  now = clock_time();
+  for(steps = 0; steps < WHEEL_SLOTS; steps++) {
+    expire_slot(wheel_slot);
+    if((clock_time_t)(now - wheel_time) < WHEEL_TICK) {
+      return;
     }
+    wheel_time += WHEEL_TICK;
+    wheel_slot = (wheel_slot + 1) % WHEEL_SLOTS;
   }
+
+  /* A full turn has passed, all slots have been looked at */
+  wheel_time = now;
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -94,21 +250,23 @@ recycle(void)
 {
   /* Find the oldest recyclable mapping and remove it. */
   struct ip64_addrmap_entry *m, *oldest;
+  uint16_t i;
 
-  /* Walk through the list of address mappings, throw away the ones
-     that are too old. */
-
+  /* The slots of the wheel are in expiry order, so the oldest mapping
+     is in the first slot that has a recyclable one. */
   oldest = NULL;
-  for(m = list_head(entrylist);
-      m != NULL;
-      m = list_item_next(m)) {
-    if(m->flags & FLAGS_RECYCLABLE) {
-      if(oldest == NULL) {
-        oldest = m;
-      } else {
-        if(timer_remaining(&m->timer) <
-           timer_remaining(&oldest->timer)) {
+  for(i = 0; i < WHEEL_SLOTS && oldest == NULL; i++) {
+    for(m = wheel[(wheel_slot + i) % WHEEL_SLOTS];
+        m != NULL;
+        m = m->wheel_next) {
+      if(m->flags & FLAGS_RECYCLABLE) {
+        if(oldest == NULL) {
           oldest = m;
+        } else {
+          if(timer_remaining(&m->timer) <
+             timer_remaining(&oldest->timer)) {
+            oldest = m;
+          }
         }
       }
     }
@@ -117,8 +275,7 @@ recycle(void)
   /* If we found an oldest recyclable entry, remove it and return
      non-zero. */
   if(oldest != NULL) {
-    list_remove(entrylist, oldest);
-    memb_free(&entrymemb, oldest);
+    remove_entry(oldest);
     return 1;
   }
 
@@ -137,7 +294,8 @@ ip64_addrmap_lookup(const uip_ip6addr_t *ip6addr,
   printf("lookup ip4port %d ip6port %d\n", uip_htons(ip4port),
 	 uip_htons(ip6port));
   check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
+  for(m = flow_table[flow_hash(ip6addr, ip6port, ip4addr, ip4port, protocol)];
+      m != NULL; m = m->flow_next) {
     printf("protocol %d %d, ip4port %d %d, ip6port %d %d, ip4 %d ip6 %d\n",
 	   m->protocol, protocol,
 	   m->ip4port, ip4port,
@@ -162,7 +320,7 @@ ip64_addrmap_lookup_port(uint16_t mapped_port, uint8_t protocol)
   struct ip64_addrmap_entry *m;
 
   check_age();
-  for(m = list_head(entrylist); m != NULL; m = list_item_next(m)) {
+  for(m = port_table[port_hash(mapped_port)]; m != NULL; m = m->port_next) {
     printf("mapped port %d %d, protocol %d %d\n",
 	   m->mapped_port, mapped_port,
 	   m->protocol, protocol);
@@ -175,6 +333,19 @@ ip64_addrmap_lookup_port(uint16_t mapped_port, uint8_t protocol)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+static int
+mapped_port_in_use(uint16_t port)
+{
+  struct ip64_addrmap_entry *m;
+
+  for(m = port_table[port_hash(port)]; m != NULL; m = m->port_next) {
+    if(m->mapped_port == port) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 static void
 increase_mapped_port(void)
 {
@@ -190,6 +361,7 @@ ip64_addrmap_create(const uip_ip6addr_t *ip6addr,
 		    uint8_t protocol)
 {
   struct ip64_addrmap_entry *m;
+  uint16_t hash;
 
   check_age();
   m = memb_alloc(&entrymemb);
@@ -209,26 +381,27 @@ ip64_addrmap_create(const uip_ip6addr_t *ip6addr,
     m->flags = FLAGS_NONE;
     m->ip6to4 = 1;
     m->ip4to6 = 0;
+    m->ip6to4_bytes = 0;
+    m->ip4to6_bytes = 0;
     timer_set(&m->timer, 0);
 
-    /* Pick a new, unused local port. First make sure that the
-       mapped_port number does not belong to any active connection. If
-       so, we keep increasing the mapped_port until we're free. */
-    {
-      struct ip64_addrmap_entry *n;
-      n = list_head(entrylist);
-      while(n != NULL) {
-	if(n->mapped_port == mapped_port) {
-	  increase_mapped_port();
-	  n = list_head(entrylist);
-	} else {
-	  n = list_item_next(m);
-	}
-      }
+    /* Pick a new, unused local port. If the mapped_port number
+       belongs to an active connection, we keep increasing the
+       mapped_port until we're free. */
+    while(mapped_port_in_use(mapped_port)) {
+      increase_mapped_port();
     }
     m->mapped_port = mapped_port;
     increase_mapped_port();
 
+    hash = flow_hash(ip6addr, ip6port, ip4addr, ip4port, protocol);
+    m->flow_next = flow_table[hash];
+    flow_table[hash] = m;
+    hash = port_hash(m->mapped_port);
+    m->port_next = port_table[hash];
+    port_table[hash] = m;
+    wheel_add(m);
+
     list_add(entrylist, m);
     return m;
   }
@@ -241,6 +414,8 @@ ip64_addrmap_set_lifetime(struct ip64_addrmap_entry *e,
 {
   if(e != NULL) {
     timer_set(&e->timer, time);
+    wheel_remove(e);
+    wheel_add(e);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -252,3 +427,13 @@ ip64_addrmap_set_recycleble(struct ip64_addrmap_entry *e)
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+ip64_addrmap_count_bytes(struct ip64_addrmap_entry *e,
+                         uint16_t ip6to4_bytes, uint16_t ip4to6_bytes)
+{
+  if(e != NULL) {
+    e->ip6to4_bytes += ip6to4_bytes;
+    e->ip4to6_bytes += ip4to6_bytes;
+  }
+}
+/*---------------------------------------------------------------------------*/
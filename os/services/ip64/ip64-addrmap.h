@@ -38,10 +38,16 @@
 
 struct ip64_addrmap_entry {
   struct ip64_addrmap_entry *next;
+  /* The chains of the flow and the mapped port hash tables */
+  struct ip64_addrmap_entry *flow_next, *port_next;
+  /* The slot of the expiry wheel */
+  struct ip64_addrmap_entry *wheel_next, **wheel_prevp;
   struct timer timer;
   uip_ip6addr_t ip6addr;
   uip_ip4addr_t ip4addr;
+  /* Packet and byte counters, for each direction */
   uint32_t ip6to4, ip4to6;
+  uint32_t ip6to4_bytes, ip4to6_bytes;
   uint16_t mapped_port;
   uint16_t ip6port;
   uint16_t ip4port;
@@ -96,6 +102,18 @@ void ip64_addrmap_set_lifetime(struct ip64_addrmap_entry *e,
  */
 void ip64_addrmap_set_recycleble(struct ip64_addrmap_entry *e);
 
+/**
+ * Account the bytes of a packet translated with an address mapping.
+ * The packets are counted by the lookup functions.
+ */
+void ip64_addrmap_count_bytes(struct ip64_addrmap_entry *e,
+                              uint16_t ip6to4_bytes, uint16_t ip4to6_bytes);
+
+/**
+ * Obtain the number of address mappings.
+ */
+int ip64_addrmap_count(void);
+
 /**
  * Obtain the list of all address mappings.
  */
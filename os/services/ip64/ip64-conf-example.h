@@ -45,4 +45,11 @@
  * optional configuration parameter. The default value is set in ip64.h 
  */
 /* #define IP64_CONF_DHCP                      1 */
+
+/*
+ * The size of the NAT64 address mapping table, and the number of
+ * buckets of its hash tables. See ip64-addrmap.c for the defaults.
+ */
+/* #define IP64_ADDRMAP_CONF_ENTRIES           128 */
+/* #define IP64_ADDRMAP_CONF_HASH_SIZE         32 */
 #endif /* IP64_CONF_H */
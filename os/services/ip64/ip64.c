@@ -358,6 +358,39 @@ ipv6_transport_checksum(const uint8_t *packet, uint16_t len, uint8_t proto)
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+/* Sums the fields of a TCP or UDP checksum that the translation
+   changes: the addresses of the pseudoheader and the ports. */
+static uint16_t
+translated_fields_sum(const void *addresses, uint16_t len,
+                      const uint8_t *transport)
+{
+  uint16_t sum;
+
+  sum = chksum(0, (const uint8_t *)addresses, len);
+  return chksum(sum, transport, 2 * sizeof(uint16_t));
+}
+/*---------------------------------------------------------------------------*/
+/* Adjusts a checksum, in network byte order, for fields with the sum
+   old_sum that were replaced with fields with the sum new_sum. This
+   is HC' = ~(~HC + ~m + m') of RFC 1624. */
+static uint16_t
+chksum_adjust(uint16_t chksum, uint16_t old_sum, uint16_t new_sum)
+{
+  uint16_t sum, t;
+
+  sum = ~uip_ntohs(chksum);
+  t = ~old_sum;
+  sum += t;
+  if(sum < t) {
+    sum++;		/* carry */
+  }
+  sum += new_sum;
+  if(sum < new_sum) {
+    sum++;		/* carry */
+  }
+  return uip_htons(~sum);
+}
+/*---------------------------------------------------------------------------*/
 int
 ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
 	  uint8_t *resultpacket)
@@ -425,13 +458,15 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
     PRINTF("ip64_6to4: TCP header\n");
     v4hdr->proto = IP_PROTO_TCP;
 
-    /* Compute and check the TCP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
+#if IP64_VERIFY_CHECKSUM
+    /* Check the TCP checksum - since we're only going to adjust it,
+       a bad checksum would otherwise be forwarded. */
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_TCP) != 0xffff) {
       PRINTF("Bad TCP checksum, dropping packet\n");
+      return 0;
     }
+#endif /* IP64_VERIFY_CHECKSUM */
 
     break;
 
@@ -447,13 +482,15 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
                       (uint8_t *)udphdr + sizeof(struct udp_hdr),
                       BUFSIZE - IPV4_HDRLEN - sizeof(struct udp_hdr));
     }
-    /* Compute and check the UDP checksum - since we're going to
-       recompute it ourselves, we must ensure that it was correct in
-       the first place. */
+#if IP64_VERIFY_CHECKSUM
+    /* Check the UDP checksum - since we're only going to adjust it,
+       a bad checksum would otherwise be forwarded. */
     if(ipv6_transport_checksum(ipv6packet, ipv6len,
                                IP_PROTO_UDP) != 0xffff) {
       PRINTF("Bad UDP checksum, dropping packet\n");
+      return 0;
     }
+#endif /* IP64_VERIFY_CHECKSUM */
     break;
 
   case IP_PROTO_ICMPV6:
@@ -601,6 +638,8 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
         }
       }
 
+      ip64_addrmap_count_bytes(m, ipv6len, 0);
+
       /* Set the source port of the packet to be the mapped port
          number. */
       udphdr->srcport = uip_htons(m->mapped_port);
@@ -619,14 +658,35 @@ ip64_6to4(const uint8_t *ipv6packet, const uint16_t ipv6packet_len,
      field. */
   switch(v4hdr->proto) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_TCP));
+    /* Only the addresses and the ports have changed, so we adjust
+       the checksum for them instead of recomputing it over the whole
+       packet. */
+    tcphdr->tcpchksum =
+      chksum_adjust(tcphdr->tcpchksum,
+                    translated_fields_sum(&v6hdr->srcipaddr,
+                                          2 * sizeof(uip_ip6addr_t),
+                                          &ipv6packet[IPV6_HDRLEN]),
+                    translated_fields_sum(&v4hdr->srcipaddr,
+                                          2 * sizeof(uip_ip4addr_t),
+                                          &resultpacket[IPV4_HDRLEN]));
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
-						  IP_PROTO_UDP));
+    /* DNS packets have been rewritten by the DNS64 module, so their
+       checksum must be recomputed. */
+    if(udphdr->destport == UIP_HTONS(DNS_PORT) || udphdr->udpchksum == 0) {
+      udphdr->udpchksum = 0;
+      udphdr->udpchksum = ~(ipv4_transport_checksum(resultpacket, ipv4len,
+                                                    IP_PROTO_UDP));
+    } else {
+      udphdr->udpchksum =
+        chksum_adjust(udphdr->udpchksum,
+                      translated_fields_sum(&v6hdr->srcipaddr,
+                                            2 * sizeof(uip_ip6addr_t),
+                                            &ipv6packet[IPV6_HDRLEN]),
+                      translated_fields_sum(&v4hdr->srcipaddr,
+                                            2 * sizeof(uip_ip4addr_t),
+                                            &resultpacket[IPV4_HDRLEN]));
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
@@ -728,6 +788,17 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
   switch(v4hdr->proto) {
   case IP_PROTO_UDP:
     v6hdr->nxthdr = IP_PROTO_UDP;
+#if IP64_VERIFY_CHECKSUM
+    /* Check the UDP checksum, if the packet has one - since we're
+       only going to adjust it, a bad checksum would otherwise be
+       forwarded. */
+    if(udphdr->udpchksum != 0 &&
+       ipv4_transport_checksum(ipv4packet, ipv4len,
+                               IP_PROTO_UDP) != 0xffff) {
+      PRINTF("Bad UDP checksum, dropping packet\n");
+      return 0;
+    }
+#endif /* IP64_VERIFY_CHECKSUM */
     /* Check if this is a DNS request. If so, we should rewrite it
        with the DNS64 module. */
     if(udphdr->srcport == UIP_HTONS(DNS_PORT)) {
@@ -747,6 +818,15 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
 
   case IP_PROTO_TCP:
     v6hdr->nxthdr = IP_PROTO_TCP;
+#if IP64_VERIFY_CHECKSUM
+    /* Check the TCP checksum - since we're only going to adjust it,
+       a bad checksum would otherwise be forwarded. */
+    if(ipv4_transport_checksum(ipv4packet, ipv4len,
+                               IP_PROTO_TCP) != 0xffff) {
+      PRINTF("Bad TCP checksum, dropping packet\n");
+      return 0;
+    }
+#endif /* IP64_VERIFY_CHECKSUM */
     break;
 
   case IP_PROTO_ICMPV4:
@@ -843,6 +923,7 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
 	} else {
 	  PRINTF("Inbound lookup did not fail\n");
 	}
+	ip64_addrmap_count_bytes(m, 0, ipv4len);
 	ip64_addr_copy6(&v6hdr->destipaddr, &m->ip6addr);
 	udphdr->destport = uip_htons(m->ip6port);
       }
@@ -854,18 +935,39 @@ ip64_4to6(const uint8_t *ipv4packet, const uint16_t ipv4packet_len,
      field. */
   switch(v6hdr->nxthdr) {
   case IP_PROTO_TCP:
-    tcphdr->tcpchksum = 0;
-    tcphdr->tcpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_TCP));
+    /* Only the addresses and the ports have changed, so we adjust
+       the checksum for them instead of recomputing it over the whole
+       packet. */
+    tcphdr->tcpchksum =
+      chksum_adjust(tcphdr->tcpchksum,
+                    translated_fields_sum(&v4hdr->srcipaddr,
+                                          2 * sizeof(uip_ip4addr_t),
+                                          &ipv4packet[IPV4_HDRLEN]),
+                    translated_fields_sum(&v6hdr->srcipaddr,
+                                          2 * sizeof(uip_ip6addr_t),
+                                          &resultpacket[IPV6_HDRLEN]));
     break;
   case IP_PROTO_UDP:
-    udphdr->udpchksum = 0;
-    /* As the udplen might have changed (DNS) we need to update it also */
-    udphdr->udplen = uip_htons(ipv6_packet_len);
-    udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
-						  ipv6len,
-						  IP_PROTO_UDP));
+    /* DNS packets have been rewritten by the DNS64 module, and a zero
+       checksum means that the IPv4 packet had none, which IPv6 does
+       not allow. In both cases, the checksum must be recomputed. */
+    if(udphdr->srcport == UIP_HTONS(DNS_PORT) || udphdr->udpchksum == 0) {
+      udphdr->udpchksum = 0;
+      /* As the udplen might have changed (DNS) we need to update it also */
+      udphdr->udplen = uip_htons(ipv6_packet_len);
+      udphdr->udpchksum = ~(ipv6_transport_checksum(resultpacket,
+                                                    ipv6len,
+                                                    IP_PROTO_UDP));
+    } else {
+      udphdr->udpchksum =
+        chksum_adjust(udphdr->udpchksum,
+                      translated_fields_sum(&v4hdr->srcipaddr,
+                                            2 * sizeof(uip_ip4addr_t),
+                                            &ipv4packet[IPV4_HDRLEN]),
+                      translated_fields_sum(&v6hdr->srcipaddr,
+                                            2 * sizeof(uip_ip6addr_t),
+                                            &resultpacket[IPV6_HDRLEN]));
+    }
     if(udphdr->udpchksum == 0) {
       udphdr->udpchksum = 0xffff;
     }
@@ -84,5 +84,16 @@ extern uint16_t ip64_packet_buffer_maxlen;
 #define IP64_DHCP 1
 #endif /* IP64_CONF_DHCP */
 
+/* The TCP and UDP checksums are adjusted for the translated addresses
+   and ports rather than recomputed, so a packet with a bad checksum
+   keeps a bad checksum. With IP64_CONF_VERIFY_CHECKSUM, such packets
+   are dropped by the translation. It may be disabled for trusted
+   interfaces, to save a pass over each packet. */
+#ifdef IP64_CONF_VERIFY_CHECKSUM
+#define IP64_VERIFY_CHECKSUM IP64_CONF_VERIFY_CHECKSUM
+#else /* IP64_CONF_VERIFY_CHECKSUM */
+#define IP64_VERIFY_CHECKSUM 1
+#endif /* IP64_CONF_VERIFY_CHECKSUM */
+
 #endif /* IP64_H */
 
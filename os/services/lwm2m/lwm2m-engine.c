@@ -47,12 +47,16 @@
 #include "lwm2m-device.h"
 #include "lwm2m-plain-text.h"
 #include "lwm2m-json.h"
+#include "lwm2m-senml.h"
+#include "lwm2m-senml-json.h"
+#include "lwm2m-senml-cbor.h"
 #include "coap-constants.h"
 #include "coap-engine.h"
 #include "lwm2m-tlv.h"
 #include "lwm2m-tlv-reader.h"
 #include "lwm2m-tlv-writer.h"
 #include "lib/list.h"
+#include "lib/list-index.h"
 #include "sys/cc.h"
 #include <stdio.h>
 #include <string.h>
@@ -90,9 +94,10 @@
 #include "lwm2m-rd-client.h"
 #endif
 
+#include "lwm2m-notification-queue.h"
+
 #if LWM2M_QUEUE_MODE_ENABLED
 #include "lwm2m-queue-mode.h"
-#include "lwm2m-notification-queue.h"
 #if LWM2M_QUEUE_MODE_OBJECT_ENABLED
 #include "lwm2m-queue-mode-object.h"
 #endif /* LWM2M_QUEUE_MODE_OBJECT_ENABLED */
@@ -107,6 +112,48 @@
 /* invalid instance ID - ffff object ID */
 #define NO_INSTANCE 0xffffffff
 
+/* Maximum number of paths in a Read-Composite or Observe-Composite */
+#ifdef LWM2M_ENGINE_CONF_COMPOSITE_MAX_PATHS
+#define COMPOSITE_MAX_PATHS LWM2M_ENGINE_CONF_COMPOSITE_MAX_PATHS
+#else
+#define COMPOSITE_MAX_PATHS 8
+#endif /* LWM2M_ENGINE_CONF_COMPOSITE_MAX_PATHS */
+
+/* Number of Observe-Composite relations - 0 disables Observe-Composite */
+#ifdef LWM2M_ENGINE_CONF_COMPOSITE_OBSERVERS
+#define COMPOSITE_OBSERVERS LWM2M_ENGINE_CONF_COMPOSITE_OBSERVERS
+#else
+#define COMPOSITE_OBSERVERS 2
+#endif /* LWM2M_ENGINE_CONF_COMPOSITE_OBSERVERS */
+
+/* A composite response is generated in full, and then sent block by block */
+#ifdef LWM2M_ENGINE_CONF_COMPOSITE_BUFFER_SIZE
+#define COMPOSITE_BUFFER_SIZE LWM2M_ENGINE_CONF_COMPOSITE_BUFFER_SIZE
+#else
+#define COMPOSITE_BUFFER_SIZE 256
+#endif /* LWM2M_ENGINE_CONF_COMPOSITE_BUFFER_SIZE */
+
+/*
+ * The object instances are kept sorted by object id and instance id. The
+ * index holds every Nth instance for a binary search, with N chosen to
+ * index all of them - a search then walks at most N instances of the list.
+ */
+#ifdef LWM2M_ENGINE_CONF_INSTANCE_INDEX_SIZE
+#define INSTANCE_INDEX_SIZE LWM2M_ENGINE_CONF_INSTANCE_INDEX_SIZE
+#else
+#define INSTANCE_INDEX_SIZE 16
+#endif /* LWM2M_ENGINE_CONF_INSTANCE_INDEX_SIZE */
+
+/*
+ * The registration payload is generated once and kept until an object or
+ * an instance is added or removed - 0 generates it at every registration.
+ */
+#ifdef LWM2M_ENGINE_CONF_RD_CACHE_SIZE
+#define RD_CACHE_SIZE LWM2M_ENGINE_CONF_RD_CACHE_SIZE
+#else
+#define RD_CACHE_SIZE 0
+#endif /* LWM2M_ENGINE_CONF_RD_CACHE_SIZE */
+
 /* This is a double-buffer for generating BLOCKs in CoAP - the idea
    is that typical LWM2M resources will fit 1 block unless they themselves
    handle BLOCK transfer - having a double sized buffer makes it possible
@@ -127,6 +174,23 @@ static uint64_t lwm2m_buf_lock_timeout = 0;
 static lwm2m_write_opaque_callback current_opaque_callback;
 static int current_opaque_offset = 0;
 
+static uint8_t composite_buf[COMPOSITE_BUFFER_SIZE];
+
+#if COMPOSITE_OBSERVERS > 0
+typedef struct {
+  coap_endpoint_t endpoint;
+  uint32_t obs_counter;
+  unsigned int content_format;
+  uint8_t token[COAP_TOKEN_LEN];
+  uint8_t token_len;
+  uint8_t pending; /* a notification is to be sent */
+  uint8_t path_count; /* zero if the entry is free */
+  lwm2m_path_t paths[COMPOSITE_MAX_PATHS];
+} composite_observer_t;
+
+static composite_observer_t composite_observers[COMPOSITE_OBSERVERS];
+#endif /* COMPOSITE_OBSERVERS > 0 */
+
 static coap_handler_status_t lwm2m_handler_callback(coap_message_t *request,
                                                     coap_message_t *response,
                                                     uint8_t *buffer,
@@ -147,15 +211,56 @@ COAP_HANDLER(lwm2m_handler, lwm2m_handler_callback);
 LIST(object_list);
 LIST(generic_object_list);
 
+/* Every Nth object instance of object_list, for a binary search */
+LIST_INDEX(instance_index, INSTANCE_INDEX_SIZE);
+
+#if RD_CACHE_SIZE > 0
+#define RD_CACHE_INVALID   0
+#define RD_CACHE_VALID     1
+#define RD_CACHE_TOO_LARGE 2
+static char rd_cache[RD_CACHE_SIZE];
+static uint16_t rd_cache_len;
+static uint8_t rd_cache_state;
+#endif /* RD_CACHE_SIZE > 0 */
+
+#define INSTANCE_KEY(oid, iid) (((uint32_t)(oid) << 16) | (iid))
+/*---------------------------------------------------------------------------*/
+static int
+instance_cmp(const void *item, const void *key)
+{
+  const lwm2m_object_instance_t *instance = item;
+  uint32_t instance_key;
+
+  instance_key = INSTANCE_KEY(instance->object_id, instance->instance_id);
+  if(instance_key < *(const uint32_t *)key) {
+    return -1;
+  }
+  return instance_key > *(const uint32_t *)key;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the first object instance with the same or higher ids, and sets
+ * prev to the instance before it.
+ */
+static lwm2m_object_instance_t *
+find_instance(uint16_t object_id, uint16_t instance_id,
+              lwm2m_object_instance_t **prev)
+{
+  uint32_t key = INSTANCE_KEY(object_id, instance_id);
+
+  return list_index_lower_bound(&instance_index, object_list, &key,
+                                instance_cmp, (void **)prev);
+}
 /*---------------------------------------------------------------------------*/
 static lwm2m_object_t *
 get_object(uint16_t object_id)
 {
   lwm2m_object_t *object;
+  /* Sorted by object id */
   for(object = list_head(generic_object_list);
-      object != NULL;
+      object != NULL && object->impl->object_id <= object_id;
       object = object->next) {
-    if(object->impl && object->impl->object_id == object_id) {
+    if(object->impl->object_id == object_id) {
       return object;
     }
   }
@@ -166,15 +271,9 @@ static int
 has_non_generic_object(uint16_t object_id)
 {
   lwm2m_object_instance_t *instance;
-  for(instance = list_head(object_list);
-      instance != NULL;
-      instance = instance->next) {
-    if(instance->object_id == object_id) {
-      return 1;
-    }
-  }
 
-  return 0;
+  instance = find_instance(object_id, 0, NULL);
+  return instance != NULL && instance->object_id == object_id;
 }
 /*---------------------------------------------------------------------------*/
 static lwm2m_object_instance_t *
@@ -187,15 +286,15 @@ get_instance(uint16_t object_id, uint16_t instance_id, lwm2m_object_t **o)
     *o = NULL;
   }
 
-  for(instance = list_head(object_list);
-      instance != NULL;
-      instance = instance->next) {
-    if(instance->object_id == object_id) {
-      if(instance->instance_id == instance_id ||
-         instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
-        return instance;
-      }
-    }
+  if(instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
+    instance = find_instance(object_id, 0, NULL);
+  } else {
+    instance = find_instance(object_id, instance_id, NULL);
+  }
+  if(instance != NULL && instance->object_id == object_id &&
+     (instance->instance_id == instance_id ||
+      instance_id == LWM2M_OBJECT_INSTANCE_NONE)) {
+    return instance;
   }
 
   object = get_object(object_id);
@@ -285,7 +384,7 @@ get_method_as_string(coap_resource_flags_t method)
 static const char *
 get_status_as_string(lwm2m_status_t status)
 {
-  static char buffer[8];
+  static char buffer[16];
   switch(status) {
   case LWM2M_STATUS_OK:
     return "OK";
@@ -391,6 +490,69 @@ void lwm2m_engine_set_opaque_callback(lwm2m_context_t *ctx, lwm2m_write_opaque_c
   current_opaque_callback = cb;
 }
 /*---------------------------------------------------------------------------*/
+#if RD_CACHE_SIZE > 0
+static int
+add_rd_link(int len, uint16_t object_id, uint16_t instance_id)
+{
+  int n;
+
+  if(instance_id == LWM2M_OBJECT_INSTANCE_NONE) {
+    n = snprintf(&rd_cache[len], sizeof(rd_cache) - len,
+                 len > 0 ? ",</%u>" : "</%u>", object_id);
+  } else {
+    n = snprintf(&rd_cache[len], sizeof(rd_cache) - len,
+                 len > 0 ? ",</%u/%u>" : "</%u/%u>", object_id, instance_id);
+  }
+  if(n < 0 || n >= sizeof(rd_cache) - len) {
+    return -1;
+  }
+  return len + n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_rd_cache(void)
+{
+  lwm2m_object_instance_t *instance;
+  lwm2m_object_t *object;
+  int len = 0;
+
+  for(instance = list_head(object_list);
+      instance != NULL && len >= 0;
+      instance = instance->next) {
+    len = add_rd_link(len, instance->object_id, instance->instance_id);
+  }
+  for(object = list_head(generic_object_list);
+      object != NULL && len >= 0;
+      object = object->next) {
+    instance = object->impl->get_first(NULL);
+    if(instance == NULL) {
+      len = add_rd_link(len, object->impl->object_id,
+                        LWM2M_OBJECT_INSTANCE_NONE);
+    }
+    for(; instance != NULL && len >= 0;
+        instance = object->impl->get_next(instance, NULL)) {
+      len = add_rd_link(len, instance->object_id, instance->instance_id);
+    }
+  }
+
+  if(len < 0) {
+    LOG_DBG("RD data does not fit the cache of %u bytes\n", RD_CACHE_SIZE);
+    rd_cache_state = RD_CACHE_TOO_LARGE;
+  } else {
+    rd_cache_len = len;
+    rd_cache_state = RD_CACHE_VALID;
+  }
+}
+#endif /* RD_CACHE_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_engine_clear_rd_data(void)
+{
+#if RD_CACHE_SIZE > 0
+  rd_cache_state = RD_CACHE_INVALID;
+#endif /* RD_CACHE_SIZE > 0 */
+}
+/*---------------------------------------------------------------------------*/
 int
 lwm2m_engine_set_rd_data(lwm2m_buffer_t *outbuf, int block)
 {
@@ -401,6 +563,22 @@ lwm2m_engine_set_rd_data(lwm2m_buffer_t *outbuf, int block)
   /* pick size from outbuf */
   int maxsize = outbuf->size;
 
+#if RD_CACHE_SIZE > 0
+  if(rd_cache_state == RD_CACHE_INVALID) {
+    update_rd_cache();
+  }
+  if(rd_cache_state == RD_CACHE_VALID) {
+    /* Every block but the last is full */
+    len = (int)rd_cache_len - block * maxsize;
+    if(len < 0) {
+      len = 0;
+    }
+    outbuf->len = MIN(len, maxsize);
+    memcpy(outbuf->buffer, &rd_cache[block * maxsize], outbuf->len);
+    return len > maxsize;
+  }
+#endif /* RD_CACHE_SIZE > 0 */
+
   if(lwm2m_buf_lock[0] != 0 && (lwm2m_buf_lock_timeout > coap_timer_uptime()) &&
      ((lwm2m_buf_lock[1] != 0xffff) ||
       (lwm2m_buf_lock[2] != 0xffff))) {
@@ -508,6 +686,8 @@ lwm2m_engine_init(void)
 {
   list_init(object_list);
   list_init(generic_object_list);
+  list_index_update(&instance_index, object_list);
+  lwm2m_engine_clear_rd_data();
 
 #ifdef LWM2M_ENGINE_CLIENT_ENDPOINT_NAME
   const char *endpoint = LWM2M_ENGINE_CLIENT_ENDPOINT_NAME;
@@ -564,6 +744,8 @@ lwm2m_engine_init(void)
   /* Register the CoAP handler for lightweight object handling */
   coap_add_handler(&lwm2m_handler);
 
+  lwm2m_notification_queue_init();
+
 #if USE_RD_CLIENT
   lwm2m_rd_client_init(endpoint);
 #endif
@@ -598,6 +780,12 @@ lwm2m_engine_select_writer(lwm2m_context_t *context, unsigned int accept)
     case APPLICATION_JSON:
       context->writer = &lwm2m_json_writer;
       break;
+    case LWM2M_SENML_JSON:
+      context->writer = &lwm2m_senml_json_writer;
+      break;
+    case LWM2M_SENML_CBOR:
+      context->writer = &lwm2m_senml_cbor_writer;
+      break;
     default:
       LOG_WARN("Unknown Accept type %u, using LWM2M plain text\n", accept);
       context->writer = &lwm2m_plain_text_writer;
@@ -631,6 +819,12 @@ lwm2m_engine_select_reader(lwm2m_context_t *context, unsigned int content_format
     case TEXT_PLAIN:
       context->reader = &lwm2m_plain_text_reader;
       break;
+    case LWM2M_SENML_JSON:
+      context->reader = &lwm2m_senml_json_reader;
+      break;
+    case LWM2M_SENML_CBOR:
+      context->reader = &lwm2m_senml_cbor_reader;
+      break;
     default:
       LOG_WARN("Unknown content type %u, using LWM2M plain text\n",
                content_format);
@@ -889,6 +1083,12 @@ perform_multi_resource_read_op(lwm2m_object_t *object,
       last_instance_id = NO_INSTANCE;
     }
     if(ctx->operation == LWM2M_OP_READ) {
+      /* SenML keeps all the instances in one array */
+      if(instance != NULL) {
+        ctx->writer_flags |= WRITER_MORE_INSTANCES;
+      } else {
+        ctx->writer_flags &= ~WRITER_MORE_INSTANCES;
+      }
       LOG_DBG("END Writer %d ->", ctx->outbuf->len);
       len = ctx->writer->end_write(ctx);
       ctx->outbuf->len += len;
@@ -938,6 +1138,7 @@ create_instance(lwm2m_context_t *context, lwm2m_object_t *object)
   if(instance != NULL) {
     LOG_DBG("Created instance: %u/%u\n", context->object_id, context->object_instance_id);
     coap_set_status_code(context->response, CREATED_2_01);
+    lwm2m_engine_clear_rd_data();
 #if USE_RD_CLIENT
     lwm2m_rd_client_set_update_rd();
 #endif
@@ -1040,6 +1241,581 @@ process_tlv_write(lwm2m_context_t *ctx, lwm2m_object_t *object,
   return LWM2M_STATUS_ERROR;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Parses the path of a SenML record - the base name followed by the name.
+ * Returns the number of levels in the path, or 0 if it is not valid.
+ */
+static int
+parse_senml_path(const lwm2m_senml_record_t *record,
+                 uint16_t *oid, uint16_t *iid, uint16_t *rid)
+{
+  char path[sizeof("/65535/65535/65535/65535")];
+  int len = 0;
+  int ret;
+
+  if(record->base_name_len + record->name_len >= sizeof(path)) {
+    return 0;
+  }
+  if(record->base_name_len > 0) {
+    memcpy(path, record->base_name, record->base_name_len);
+    len = record->base_name_len;
+  }
+  if(record->name_len > 0) {
+    memcpy(&path[len], record->name, record->name_len);
+    len += record->name_len;
+  }
+  /* Only absolute paths below the root are valid */
+  if(len < 2 || path[0] != '/') {
+    return 0;
+  }
+  if(path[len - 1] == '/') {
+    len--;
+  }
+  ret = parse_path(&path[1], len - 1, oid, iid, rid);
+  return ret < 0 ? 0 : ret;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes the resources in a SenML payload. A composite write may write to
+ * any existing object instance, other writes only to the object, instance
+ * or resource of the request.
+ */
+static lwm2m_status_t
+perform_senml_write_op(lwm2m_object_t *object, lwm2m_context_t *ctx,
+                       unsigned int format, int composite)
+{
+  lwm2m_senml_next_record_t next_record;
+  lwm2m_senml_record_t record;
+  lwm2m_object_instance_t *instance;
+  lwm2m_buffer_t *inbuf = ctx->inbuf;
+  lwm2m_buffer_t value;
+  lwm2m_status_t status;
+  uint16_t oid = 0, iid = 0, rid = 0;
+  uint16_t target_iid = ctx->object_instance_id;
+  uint16_t target_rid = ctx->resource_id;
+  uint8_t target_level = ctx->level;
+  int levels;
+
+  if(format == LWM2M_SENML_CBOR) {
+    next_record = lwm2m_senml_cbor_next_record;
+  } else if(format == LWM2M_SENML_JSON) {
+    next_record = lwm2m_senml_json_next_record;
+  } else {
+    return LWM2M_STATUS_UNSUPPORTED_CONTENT_FORMAT;
+  }
+
+  memset(&record, 0, sizeof(record));
+  while(next_record(ctx, &record)) {
+    if(record.value == NULL) {
+      continue;
+    }
+    levels = parse_senml_path(&record, &oid, &iid, &rid);
+    if(levels == 4) {
+      /* Single resource instances can not be written */
+      return LWM2M_STATUS_NOT_IMPLEMENTED;
+    } else if(levels != 3) {
+      return LWM2M_STATUS_BAD_REQUEST;
+    }
+    LOG_DBG("SenML write %u/%u/%u\n", oid, iid, rid);
+
+    if(composite) {
+      instance = get_instance(oid, iid, NULL);
+      ctx->object_id = oid;
+    } else if(oid != ctx->object_id ||
+              (target_level > 1 && iid != target_iid) ||
+              (target_level > 2 && rid != target_rid)) {
+      /* Outside of the path of the request */
+      return LWM2M_STATUS_BAD_REQUEST;
+    } else {
+      ctx->object_instance_id = iid;
+      ctx->level = 3;
+      instance = get_or_create_instance(ctx, object, NULL);
+    }
+    if(instance == NULL || instance->callback == NULL) {
+      return LWM2M_STATUS_NOT_FOUND;
+    }
+
+    ctx->object_instance_id = iid;
+    ctx->resource_id = rid;
+    ctx->level = 3;
+    if(!check_write(ctx, instance, rid)) {
+      return LWM2M_STATUS_OPERATION_NOT_ALLOWED;
+    }
+
+    /* Let the reader see only the value of the record */
+    value.buffer = (uint8_t *)record.value;
+    value.size = record.value_len;
+    value.len = record.value_len;
+    value.pos = 0;
+    ctx->inbuf = &value;
+    status = instance->callback(instance, ctx);
+    ctx->inbuf = inbuf;
+    if(status != LWM2M_STATUS_OK) {
+      return status;
+    }
+  }
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the paths of a Read-Composite or Observe-Composite request */
+static lwm2m_status_t
+parse_composite_paths(lwm2m_context_t *ctx, unsigned int format,
+                      lwm2m_path_t *paths, uint8_t *count)
+{
+  lwm2m_senml_next_record_t next_record;
+  lwm2m_senml_record_t record;
+  int levels;
+
+  if(format == LWM2M_SENML_CBOR) {
+    next_record = lwm2m_senml_cbor_next_record;
+  } else if(format == LWM2M_SENML_JSON) {
+    next_record = lwm2m_senml_json_next_record;
+  } else {
+    return LWM2M_STATUS_UNSUPPORTED_CONTENT_FORMAT;
+  }
+
+  *count = 0;
+  memset(&record, 0, sizeof(record));
+  while(next_record(ctx, &record)) {
+    if(*count == COMPOSITE_MAX_PATHS) {
+      LOG_WARN("Composite request with more than %u paths\n",
+               COMPOSITE_MAX_PATHS);
+      return LWM2M_STATUS_SERVICE_UNAVAILABLE;
+    }
+    levels = parse_senml_path(&record, &paths[*count].object_id,
+                              &paths[*count].instance_id,
+                              &paths[*count].resource_id);
+    if(levels == 4) {
+      return LWM2M_STATUS_NOT_IMPLEMENTED;
+    } else if(levels == 0) {
+      return LWM2M_STATUS_BAD_REQUEST;
+    }
+    paths[*count].level = levels;
+    (*count)++;
+  }
+  return *count > 0 ? LWM2M_STATUS_OK : LWM2M_STATUS_BAD_REQUEST;
+}
+/*---------------------------------------------------------------------------*/
+/* The whole value of an opaque resource has to fit in the response */
+static lwm2m_status_t
+read_composite_opaque(lwm2m_object_instance_t *instance, lwm2m_context_t *ctx)
+{
+  uint32_t offset = ctx->offset;
+  lwm2m_status_t status;
+
+  ctx->offset = 0;
+  ctx->writer_flags &= ~WRITER_HAS_MORE;
+  status = current_opaque_callback(instance, ctx,
+                                   ctx->outbuf->size - ctx->outbuf->len);
+  current_opaque_callback = NULL;
+  ctx->offset = offset;
+  if(ctx->writer_flags & WRITER_HAS_MORE) {
+    LOG_WARN("Opaque %u/%u/%u does not fit the composite response\n",
+             ctx->object_id, ctx->object_instance_id, ctx->resource_id);
+    return LWM2M_STATUS_ERROR;
+  }
+  return status;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Generates the whole response of a composite read in composite_buf, and
+ * copies the block at ctx->offset to the output buffer. Resources that do
+ * not exist are left out of the response.
+ */
+static lwm2m_status_t
+read_composite(lwm2m_context_t *ctx, const lwm2m_path_t *paths,
+               uint8_t count)
+{
+  lwm2m_buffer_t buffer = {
+    .len = 0, .pos = 0, .size = sizeof(composite_buf), .buffer = composite_buf
+  };
+  lwm2m_buffer_t *outbuf = ctx->outbuf;
+  lwm2m_write_opaque_callback opaque_callback = current_opaque_callback;
+  int opaque_offset = current_opaque_offset;
+  lwm2m_object_instance_t *instance;
+  lwm2m_object_t *object;
+  lwm2m_status_t status = LWM2M_STATUS_OK;
+  size_t len;
+  int i, r;
+
+  if(ctx->writer != &lwm2m_senml_json_writer &&
+     ctx->writer != &lwm2m_senml_cbor_writer) {
+    return LWM2M_STATUS_NOT_ACCEPTABLE;
+  }
+
+  ctx->outbuf = &buffer;
+  ctx->operation = LWM2M_OP_READ;
+  ctx->writer_flags = 0;
+  buffer.len += ctx->writer->init_write(ctx);
+
+  for(i = 0; i < count && status == LWM2M_STATUS_OK; i++) {
+    instance = get_instance(paths[i].object_id,
+                            paths[i].level < 2 ? LWM2M_OBJECT_INSTANCE_NONE :
+                            paths[i].instance_id, &object);
+    while(instance != NULL && status == LWM2M_STATUS_OK) {
+      for(r = 0; r < instance->resource_count; r++) {
+        if(!RSC_READABLE(instance->resource_ids[r]) ||
+           (paths[i].level == 3 &&
+            RSC_ID(instance->resource_ids[r]) != paths[i].resource_id)) {
+          continue;
+        }
+        ctx->object_id = instance->object_id;
+        ctx->object_instance_id = instance->instance_id;
+        ctx->resource_id = RSC_ID(instance->resource_ids[r]);
+        ctx->level = 3;
+        current_opaque_callback = NULL;
+        status = instance->callback(instance, ctx);
+        if(status == LWM2M_STATUS_OK && current_opaque_callback != NULL) {
+          status = read_composite_opaque(instance, ctx);
+        }
+        if(status == LWM2M_STATUS_NOT_FOUND) {
+          status = LWM2M_STATUS_OK;
+        } else if(status != LWM2M_STATUS_OK) {
+          break;
+        }
+      }
+      ctx->object_id = paths[i].object_id;
+      ctx->level = paths[i].level;
+      instance = next_object_instance(ctx, object, instance);
+    }
+  }
+
+  current_opaque_callback = opaque_callback;
+  current_opaque_offset = opaque_offset;
+  if(status == LWM2M_STATUS_OK) {
+    len = ctx->writer->end_write(ctx);
+    if(len == 0) {
+      LOG_WARN("Composite response larger than %u bytes\n",
+               (unsigned)sizeof(composite_buf));
+      status = LWM2M_STATUS_ERROR;
+    }
+    buffer.len += len;
+  }
+  ctx->outbuf = outbuf;
+  if(status != LWM2M_STATUS_OK) {
+    return status;
+  }
+
+  if(ctx->offset > buffer.len) {
+    return LWM2M_STATUS_BAD_REQUEST;
+  }
+  len = MIN(buffer.len - ctx->offset, outbuf->size);
+  memcpy(outbuf->buffer, &composite_buf[ctx->offset], len);
+  outbuf->len = len;
+  ctx->offset += len;
+  if(ctx->offset < buffer.len) {
+    ctx->writer_flags |= WRITER_HAS_MORE;
+  } else {
+    ctx->writer_flags &= ~WRITER_HAS_MORE;
+  }
+  LOG_DBG("Composite read: %u of %u bytes\n", (unsigned)len, buffer.len);
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+#if COMPOSITE_OBSERVERS > 0
+/*
+ * Adds or removes an Observe-Composite relation. The relation is kept by
+ * the LWM2M engine since it depends on the payload of the request.
+ */
+static lwm2m_status_t
+observe_composite(lwm2m_context_t *ctx, const lwm2m_path_t *paths,
+                  uint8_t count)
+{
+  const coap_endpoint_t *endpoint;
+  composite_observer_t *obs = NULL;
+  uint32_t observe;
+  int i;
+
+  endpoint = coap_get_src_endpoint(ctx->request);
+  if(endpoint == NULL || !coap_get_header_observe(ctx->request, &observe)) {
+    return LWM2M_STATUS_OK;
+  }
+
+  /* A registration replaces any earlier one with the same token */
+  for(i = 0; i < COMPOSITE_OBSERVERS; i++) {
+    if(composite_observers[i].path_count > 0 &&
+       coap_endpoint_cmp(&composite_observers[i].endpoint, endpoint) &&
+       composite_observers[i].token_len == ctx->request->token_len &&
+       memcmp(composite_observers[i].token, ctx->request->token,
+              ctx->request->token_len) == 0) {
+      LOG_INFO("Removing composite observer %d\n", i);
+      composite_observers[i].path_count = 0;
+    }
+    if(composite_observers[i].path_count == 0 && obs == NULL) {
+      obs = &composite_observers[i];
+    }
+  }
+  if(observe != 0) {
+    return LWM2M_STATUS_OK;
+  }
+  if(obs == NULL) {
+    return LWM2M_STATUS_SERVICE_UNAVAILABLE;
+  }
+
+  coap_endpoint_copy(&obs->endpoint, endpoint);
+  obs->token_len = ctx->request->token_len;
+  memcpy(obs->token, ctx->request->token, obs->token_len);
+  obs->content_format = ctx->content_type;
+  obs->obs_counter = 0;
+  memcpy(obs->paths, paths, count * sizeof(lwm2m_path_t));
+  obs->path_count = count;
+  LOG_INFO("Adding composite observer with %u paths\n", count);
+
+  coap_set_header_observe(ctx->response, (obs->obs_counter)++);
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_composite_notification(composite_observer_t *obs)
+{
+  coap_message_t request[1];
+  coap_message_t notification[1];
+  coap_transaction_t *transaction;
+  lwm2m_context_t context;
+  lwm2m_buffer_t outbuf;
+
+  transaction = coap_new_transaction(coap_get_mid(), &obs->endpoint);
+  if(transaction == NULL) {
+    return;
+  }
+
+  /* A "fake" request, as for the other notifications */
+  coap_init_message(request, COAP_TYPE_CON, COAP_FETCH, 0);
+  coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05,
+                    transaction->mid);
+  if(COAP_OBSERVE_REFRESH_INTERVAL != 0
+     && (obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0)) {
+    notification->type = COAP_TYPE_CON;
+  }
+
+  memset(&context, 0, sizeof(context));
+  memset(&outbuf, 0, sizeof(outbuf));
+  outbuf.buffer = transaction->message + COAP_MAX_HEADER_SIZE;
+  outbuf.size = COAP_MAX_BLOCK_SIZE;
+  context.outbuf = &outbuf;
+  context.request = request;
+  context.response = notification;
+  lwm2m_engine_select_writer(&context, obs->content_format);
+
+  if(read_composite(&context, obs->paths, obs->path_count) !=
+     LWM2M_STATUS_OK) {
+    coap_clear_transaction(transaction);
+    return;
+  }
+
+  coap_set_header_observe(notification, (obs->obs_counter)++);
+  /* mask out to keep the CoAP observe option length <= 3 bytes */
+  obs->obs_counter &= 0xffffff;
+  coap_set_token(notification, obs->token, obs->token_len);
+  coap_set_header_content_format(notification, context.content_type);
+  if(context.writer_flags & WRITER_HAS_MORE) {
+    /* The observer fetches the rest with Block2 */
+    coap_set_header_block2(notification, 0, 1, COAP_MAX_BLOCK_SIZE);
+  }
+  coap_set_payload(notification, outbuf.buffer, outbuf.len);
+
+  transaction->message_len =
+    coap_serialize_message(notification, transaction->message);
+  coap_send_transaction(transaction);
+}
+/*---------------------------------------------------------------------------*/
+/* Does any of the paths overlap with the given path? */
+static int
+composite_paths_match(const composite_observer_t *obs,
+                      const lwm2m_path_t *path)
+{
+  const lwm2m_path_t *p;
+  int i;
+
+  for(i = 0; i < obs->path_count; i++) {
+    p = &obs->paths[i];
+    if(p->object_id == path->object_id &&
+       (p->level < 2 || path->level < 2 ||
+        p->instance_id == path->instance_id) &&
+       (p->level < 3 || path->level < 3 ||
+        p->resource_id == path->resource_id)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif /* COMPOSITE_OBSERVERS > 0 */
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_engine_has_composite_observers(const lwm2m_path_t *path)
+{
+#if COMPOSITE_OBSERVERS > 0
+  int i;
+
+  for(i = 0; i < COMPOSITE_OBSERVERS; i++) {
+    if(composite_paths_match(&composite_observers[i], path)) {
+      return 1;
+    }
+  }
+#endif /* COMPOSITE_OBSERVERS > 0 */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Marks the composite observations that include the path. The
+ * notifications are sent by lwm2m_engine_send_composite_notifications(), so
+ * that changes to several of the paths give a single notification.
+ */
+void
+lwm2m_engine_notify_composite_observers(const lwm2m_path_t *path)
+{
+#if COMPOSITE_OBSERVERS > 0
+  int i;
+
+  for(i = 0; i < COMPOSITE_OBSERVERS; i++) {
+    if(composite_paths_match(&composite_observers[i], path)) {
+      composite_observers[i].pending = 1;
+    }
+  }
+#endif /* COMPOSITE_OBSERVERS > 0 */
+}
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_engine_send_composite_notifications(void)
+{
+#if COMPOSITE_OBSERVERS > 0
+  int i;
+
+  for(i = 0; i < COMPOSITE_OBSERVERS; i++) {
+    if(composite_observers[i].pending) {
+      composite_observers[i].pending = 0;
+      if(composite_observers[i].path_count > 0) {
+        send_composite_notification(&composite_observers[i]);
+      }
+    }
+  }
+#endif /* COMPOSITE_OBSERVERS > 0 */
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * LWM2M Send - reports the paths to the server with a POST to /dp. The
+ * report has to fit a single block. Returns 1 if the report was sent.
+ */
+int
+lwm2m_engine_send(const coap_endpoint_t *server_ep,
+                  const lwm2m_path_t *paths, uint8_t count)
+{
+  coap_message_t request[1];
+  coap_transaction_t *transaction;
+  lwm2m_context_t context;
+  lwm2m_buffer_t outbuf;
+  uint8_t token[2];
+
+  transaction = coap_new_transaction(coap_get_mid(), server_ep);
+  if(transaction == NULL) {
+    return 0;
+  }
+
+  coap_init_message(request, COAP_TYPE_CON, COAP_POST, transaction->mid);
+  coap_set_header_uri_path(request, "dp");
+  token[0] = transaction->mid >> 8;
+  token[1] = transaction->mid & 0xff;
+  coap_set_token(request, token, sizeof(token));
+
+  memset(&context, 0, sizeof(context));
+  memset(&outbuf, 0, sizeof(outbuf));
+  outbuf.buffer = transaction->message + COAP_MAX_HEADER_SIZE;
+  outbuf.size = COAP_MAX_BLOCK_SIZE;
+  context.outbuf = &outbuf;
+  context.request = request;
+  context.response = request;
+  lwm2m_engine_select_writer(&context, LWM2M_SENML_CBOR);
+
+  if(read_composite(&context, paths, count) != LWM2M_STATUS_OK ||
+     (context.writer_flags & WRITER_HAS_MORE)) {
+    LOG_WARN("Send: the report of %u paths does not fit a block\n", count);
+    coap_clear_transaction(transaction);
+    return 0;
+  }
+
+  coap_set_header_content_format(request, context.content_type);
+  coap_set_payload(request, outbuf.buffer, outbuf.len);
+  transaction->message_len =
+    coap_serialize_message(request, transaction->message);
+  coap_send_transaction(transaction);
+  LOG_INFO("Send: reported %u paths in %u bytes\n", count, outbuf.len);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Write-Attributes - the notification attributes are in the query */
+static lwm2m_status_t
+perform_write_attributes_op(lwm2m_context_t *ctx)
+{
+  lwm2m_path_t path;
+  const char *query;
+  uint16_t pmin, pmax;
+  uint32_t value;
+  int len, pos, end, eq;
+
+  path.object_id = ctx->object_id;
+  path.instance_id = ctx->object_instance_id;
+  path.resource_id = ctx->resource_id;
+  path.level = ctx->level;
+  lwm2m_notification_queue_get_attributes(&path, &pmin, &pmax);
+
+  len = coap_get_header_uri_query(ctx->request, &query);
+  for(pos = 0; pos < len; pos = end + 1) {
+    for(end = pos; end < len && query[end] != '&'; end++);
+    for(eq = pos; eq < end && query[eq] != '='; eq++);
+
+    /* An attribute without a value is removed */
+    value = 0;
+    if(eq < end - 1) {
+      for(eq++; eq < end; eq++) {
+        if(query[eq] < '0' || query[eq] > '9' || value > 0xffff) {
+          return LWM2M_STATUS_BAD_REQUEST;
+        }
+        value = value * 10 + query[eq] - '0';
+      }
+      if(value > 0xffff) {
+        return LWM2M_STATUS_BAD_REQUEST;
+      }
+    }
+    if(end - pos >= 4 && strncmp(&query[pos], "pmin", 4) == 0 &&
+       (end - pos == 4 || query[pos + 4] == '=')) {
+      pmin = value;
+    } else if(end - pos >= 4 && strncmp(&query[pos], "pmax", 4) == 0 &&
+              (end - pos == 4 || query[pos + 4] == '=')) {
+      pmax = value;
+    } else {
+      LOG_WARN("Unsupported attribute: ");
+      LOG_WARN_COAP_STRING(&query[pos], end - pos);
+      LOG_WARN_("\n");
+      return LWM2M_STATUS_BAD_REQUEST;
+    }
+  }
+  return lwm2m_notification_queue_set_attributes(&path, pmin, pmax);
+}
+/*---------------------------------------------------------------------------*/
+/* Read-Composite and Observe-Composite - a FETCH on the root path */
+static lwm2m_status_t
+perform_composite_read_op(lwm2m_context_t *ctx, unsigned int format)
+{
+  lwm2m_path_t paths[COMPOSITE_MAX_PATHS];
+  lwm2m_status_t status;
+#if COMPOSITE_OBSERVERS > 0
+  uint32_t offset = ctx->offset;
+#endif /* COMPOSITE_OBSERVERS > 0 */
+  uint8_t count;
+
+  status = parse_composite_paths(ctx, format, paths, &count);
+  if(status == LWM2M_STATUS_OK) {
+    status = read_composite(ctx, paths, count);
+  }
+#if COMPOSITE_OBSERVERS > 0
+  /* Only the first block of the response starts an observation */
+  if(status == LWM2M_STATUS_OK && offset == 0) {
+    status = observe_composite(ctx, paths, count);
+  }
+#endif /* COMPOSITE_OBSERVERS > 0 */
+  return status;
+}
+/*---------------------------------------------------------------------------*/
 static int last_tlv_id = 0;
 
 static lwm2m_status_t
@@ -1194,6 +1970,9 @@ perform_multi_resource_write_op(lwm2m_object_t *object,
             format == LWM2M_OLD_OPAQUE) {
     return call_instance(instance, ctx);
 
+  } else if(format == LWM2M_SENML_JSON || format == LWM2M_SENML_CBOR) {
+    return perform_senml_write_op(object, ctx, format, 0);
+
   } else {
     /* Unsupported format */
     return LWM2M_STATUS_UNSUPPORTED_CONTENT_FORMAT;
@@ -1234,23 +2013,22 @@ lwm2m_engine_add_object(lwm2m_object_instance_t *object)
     return 0;
   }
 
-  for(instance = list_head(object_list);
-      instance != NULL;
+  /* The instances of an object are next to each other in the list */
+  for(instance = find_instance(object->object_id, 0, NULL);
+      instance != NULL && instance->object_id == object->object_id;
       instance = instance->next) {
-    if(object->object_id == instance->object_id) {
-      if(object->instance_id == instance->instance_id) {
-        LOG_DBG("object with id %u/%u already registered\n",
-               instance->object_id, instance->instance_id);
-        return 0;
-      }
+    if(object->instance_id == instance->instance_id) {
+      LOG_DBG("object with id %u/%u already registered\n",
+             instance->object_id, instance->instance_id);
+      return 0;
+    }
 
-      found++;
-      if(instance->instance_id > max_id) {
-        max_id = instance->instance_id;
-      }
-      if(instance->instance_id < min_id) {
-        min_id = instance->instance_id;
-      }
+    found++;
+    if(instance->instance_id > max_id) {
+      max_id = instance->instance_id;
+    }
+    if(instance->instance_id < min_id) {
+      min_id = instance->instance_id;
     }
   }
 
@@ -1265,7 +2043,10 @@ lwm2m_engine_add_object(lwm2m_object_instance_t *object)
       object->instance_id = max_id + 1;
     }
   }
-  list_add(object_list, object);
+  find_instance(object->object_id, object->instance_id, &instance);
+  list_insert(object_list, instance, object);
+  list_index_update(&instance_index, object_list);
+  lwm2m_engine_clear_rd_data();
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1276,6 +2057,8 @@ void
 lwm2m_engine_remove_object(lwm2m_object_instance_t *object)
 {
   list_remove(object_list, object);
+  list_index_update(&instance_index, object_list);
+  lwm2m_engine_clear_rd_data();
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1284,6 +2067,9 @@ lwm2m_engine_remove_object(lwm2m_object_instance_t *object)
 int
 lwm2m_engine_add_generic_object(lwm2m_object_t *object)
 {
+  lwm2m_object_t *prev;
+  lwm2m_object_t *next;
+
   if(object == NULL || object->impl == NULL
      || object->impl->get_first == NULL
      || object->impl->get_next == NULL
@@ -1303,7 +2089,12 @@ lwm2m_engine_add_generic_object(lwm2m_object_t *object)
              object->impl->object_id);
     return 0;
   }
-  list_add(generic_object_list, object);
+  /* Keep the list sorted by object id */
+  for(prev = NULL, next = list_head(generic_object_list);
+      next != NULL && next->impl->object_id < object->impl->object_id;
+      prev = next, next = next->next);
+  list_insert(generic_object_list, prev, object);
+  lwm2m_engine_clear_rd_data();
 
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
@@ -1316,6 +2107,7 @@ void
 lwm2m_engine_remove_generic_object(lwm2m_object_t *object)
 {
   list_remove(generic_object_list, object);
+  lwm2m_engine_clear_rd_data();
 #if USE_RD_CLIENT
   lwm2m_rd_client_set_update_rd();
 #endif
@@ -1336,11 +2128,12 @@ next_object_instance(const lwm2m_context_t *context, lwm2m_object_t *object,
   }
 
   if(object == NULL) {
-    for(last = last->next; last != NULL; last = last->next) {
-      /* if no context is given - this will just give the next object */
-      if(context == NULL || last->object_id == context->object_id) {
-        return last;
-      }
+    /* if no context is given - this will just give the next object */
+    last = last->next;
+    if(last != NULL &&
+       (context == NULL || last->object_id == context->object_id)) {
+      /* The instances of an object are next to each other */
+      return last;
     }
     return NULL;
   }
@@ -1352,10 +2145,12 @@ lwm2m_handler_callback(coap_message_t *request, coap_message_t *response,
                        uint8_t *buffer, uint16_t buffer_size, int32_t *offset)
 {
   const char *url;
+  const char *query;
   int url_len;
   unsigned int format;
   unsigned int accept;
   int depth;
+  int composite;
   lwm2m_context_t context;
   lwm2m_object_t *object;
   lwm2m_object_instance_t *instance;
@@ -1425,11 +2220,20 @@ lwm2m_queue_mode_request_received();
     return COAP_HANDLER_STATUS_PROCESSED;
   }
 
-  depth = lwm2m_engine_parse_context(url, url_len, request, response,
-                                     buffer, buffer_size, &context);
-  if(depth < 0) {
-    /* Not a LWM2M context */
-    return COAP_HANDLER_STATUS_CONTINUE;
+  /* The composite operations address the paths in the payload */
+  composite = url_len == 0 &&
+    (request->code == COAP_FETCH || request->code == COAP_IPATCH);
+  if(composite) {
+    depth = 0;
+    object = NULL;
+    instance = NULL;
+  } else {
+    depth = lwm2m_engine_parse_context(url, url_len, request, response,
+                                       buffer, buffer_size, &context);
+    if(depth < 0) {
+      /* Not a LWM2M context */
+      return COAP_HANDLER_STATUS_CONTINUE;
+    }
   }
 
   LOG_DBG("%s URL:'", get_method_as_string(coap_get_method_type(request)));
@@ -1459,7 +2263,7 @@ lwm2m_queue_mode_request_received();
    * 2 => Object and Instance
    * 3 => Object and Instance and Resource
    */
-  if(depth < 1) {
+  if(depth < 1 && !composite) {
     /* No possible object id found in URL - ignore request unless delete all */
     if(coap_get_method_type(request) == METHOD_DELETE) {
       LOG_DBG("This is a delete all - for bootstrap...\n");
@@ -1474,6 +2278,7 @@ lwm2m_queue_mode_request_received();
           object->impl->delete_instance(LWM2M_OBJECT_INSTANCE_NONE, NULL);
         }
       }
+      lwm2m_engine_clear_rd_data();
 #if USE_RD_CLIENT
       lwm2m_rd_client_set_update_rd();
 #endif
@@ -1482,15 +2287,18 @@ lwm2m_queue_mode_request_received();
     return COAP_HANDLER_STATUS_CONTINUE;
   }
 
-  instance = get_instance_by_context(&context, &object);
+  if(!composite) {
+    instance = get_instance_by_context(&context, &object);
 
-  /*
-   * Check if we found either instance or object. Instance means we found an
-   * existing instance and generic objects means we might create an instance.
-   */
-  if(instance == NULL && object == NULL) {
-    /* No matching object/instance found - ignore request */
-    return COAP_HANDLER_STATUS_CONTINUE;
+    /*
+     * Check if we found either instance or object. Instance means we found
+     * an existing instance and generic objects means we might create an
+     * instance.
+     */
+    if(instance == NULL && object == NULL) {
+      /* No matching object/instance found - ignore request */
+      return COAP_HANDLER_STATUS_CONTINUE;
+    }
   }
 
   LOG_INFO("Context: %u/%u/%u  found: %d\n",
@@ -1507,7 +2315,12 @@ lwm2m_queue_mode_request_received();
   switch(coap_get_method_type(request)) {
   case METHOD_PUT:
     /* can also be write atts */
-    context.operation = LWM2M_OP_WRITE;
+    if(context.inbuf->size == 0 &&
+       coap_get_header_uri_query(request, &query) > 0) {
+      context.operation = LWM2M_OP_WRITE_ATTR;
+    } else {
+      context.operation = LWM2M_OP_WRITE;
+    }
     coap_set_status_code(response, CHANGED_2_04);
     break;
   case METHOD_POST:
@@ -1533,6 +2346,15 @@ lwm2m_queue_mode_request_received();
     coap_set_status_code(response, DELETED_2_02);
     break;
   default:
+    if(request->code == COAP_FETCH && composite) {
+      /* Read-Composite and Observe-Composite */
+      context.operation = LWM2M_OP_READ;
+      coap_set_status_code(response, CONTENT_2_05);
+    } else if(request->code == COAP_IPATCH && composite) {
+      /* Write-Composite */
+      context.operation = LWM2M_OP_WRITE;
+      coap_set_status_code(response, CHANGED_2_04);
+    }
     break;
   }
 
@@ -1570,10 +2392,21 @@ lwm2m_queue_mode_request_received();
     success = perform_multi_resource_read_op(object, instance, &context);
     break;
   case LWM2M_OP_READ:
-    success = perform_multi_resource_read_op(object, instance, &context);
+    if(composite) {
+      success = perform_composite_read_op(&context, format);
+    } else {
+      success = perform_multi_resource_read_op(object, instance, &context);
+    }
     break;
   case LWM2M_OP_WRITE:
-    success = perform_multi_resource_write_op(object, instance, &context, format);
+    if(composite) {
+      success = perform_senml_write_op(NULL, &context, format, 1);
+    } else {
+      success = perform_multi_resource_write_op(object, instance, &context, format);
+    }
+    break;
+  case LWM2M_OP_WRITE_ATTR:
+    success = perform_write_attributes_op(&context);
     break;
   case LWM2M_OP_EXECUTE:
     success = call_instance(instance, &context);
@@ -1582,6 +2415,7 @@ lwm2m_queue_mode_request_received();
     if(object != NULL && object->impl != NULL &&
        object->impl->delete_instance != NULL) {
       object->impl->delete_instance(context.object_instance_id, &success);
+      lwm2m_engine_clear_rd_data();
 #if USE_RD_CLIENT
       lwm2m_rd_client_set_update_rd();
 #endif
@@ -1626,6 +2460,9 @@ lwm2m_queue_mode_request_received();
     }
   } else {
     switch(success) {
+    case LWM2M_STATUS_BAD_REQUEST:
+      coap_set_status_code(response, BAD_REQUEST_4_00);
+      break;
     case LWM2M_STATUS_FORBIDDEN:
       coap_set_status_code(response, FORBIDDEN_4_03);
       break;
@@ -1641,6 +2478,12 @@ lwm2m_queue_mode_request_received();
     case LWM2M_STATUS_UNSUPPORTED_CONTENT_FORMAT:
       coap_set_status_code(response, UNSUPPORTED_MEDIA_TYPE_4_15);
       break;
+    case LWM2M_STATUS_NOT_IMPLEMENTED:
+      coap_set_status_code(response, NOT_IMPLEMENTED_5_01);
+      break;
+    case LWM2M_STATUS_SERVICE_UNAVAILABLE:
+      coap_set_status_code(response, SERVICE_UNAVAILABLE_5_03);
+      break;
     default:
       /* Failed to handle the request */
       coap_set_status_code(response, INTERNAL_SERVER_ERROR_5_00);
@@ -1653,46 +2496,16 @@ lwm2m_queue_mode_request_received();
   return COAP_HANDLER_STATUS_PROCESSED;
 }
 /*---------------------------------------------------------------------------*/
-static void
-lwm2m_send_notification(char* path)
-{
-#if LWM2M_QUEUE_MODE_ENABLED && LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
-    if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
-      lwm2m_queue_mode_set_handler_from_notification();
-    } 
-#endif
-  coap_notify_observers_sub(NULL, path);
-}
-/*---------------------------------------------------------------------------*/
-void 
+void
 lwm2m_notify_object_observers(lwm2m_object_instance_t *obj,
-                                   uint16_t resource)
+                              uint16_t resource)
 {
-  char path[20]; /* 60000/60000/60000 */
   if(obj != NULL) {
-    snprintf(path, 20, "%d/%d/%d", obj->object_id, obj->instance_id, resource);
-  }
-
-#if LWM2M_QUEUE_MODE_ENABLED
-  
-  if(coap_has_observers(path)) {
-    /* Client is sleeping -> add the notification to the list */
-    if(!lwm2m_rd_client_is_client_awake()) {
-      lwm2m_notification_queue_add_notification_path(obj->object_id, obj->instance_id, resource);
-
-      /* if it is the first notification -> wake up and send update */
-      if(!lwm2m_queue_mode_is_waked_up_by_notification()) {
-        lwm2m_queue_mode_set_waked_up_by_notification();
-        lwm2m_rd_client_fsm_execute_queue_mode_update();
-      }
-    /* Client is awake -> send the notification */  
-    } else {
-      lwm2m_send_notification(path);
-    }
+    /* The notification queue coalesces the changes */
+    lwm2m_notification_queue_add_notification_path(obj->object_id,
+                                                   obj->instance_id,
+                                                   resource);
   }
-#else 
-  lwm2m_send_notification(path);
-#endif
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -58,12 +58,16 @@ typedef enum {
   LWM2M_JSON       = 11543,
   LWM2M_OLD_TLV    = 1542,
   LWM2M_OLD_JSON   = 1543,
-  LWM2M_OLD_OPAQUE  = 1544
+  LWM2M_OLD_OPAQUE  = 1544,
+  LWM2M_SENML_JSON = 110,
+  LWM2M_SENML_CBOR = 112
 } lwm2m_content_format_t;
 
 void lwm2m_engine_init(void);
 
 int lwm2m_engine_set_rd_data(lwm2m_buffer_t *outbuf, int block);
+/* Call when the instances of a generic object change on their own */
+void lwm2m_engine_clear_rd_data(void);
 
 typedef lwm2m_status_t
 (* lwm2m_object_instance_callback_t)(lwm2m_object_instance_t *object,
@@ -74,6 +78,14 @@ typedef int
 
 #define LWM2M_OBJECT_INSTANCE_NONE 0xffff
 
+/* An object, object instance or resource */
+typedef struct {
+  uint16_t object_id;
+  uint16_t instance_id;
+  uint16_t resource_id;
+  uint8_t level; /* 1. object, 2. object/instance, 3. object/instance/resource */
+} lwm2m_path_t;
+
 struct lwm2m_object_instance {
   lwm2m_object_instance_t *next;
   uint16_t object_id;
@@ -114,6 +126,12 @@ void lwm2m_engine_remove_generic_object(lwm2m_object_t *object);
 void lwm2m_notify_object_observers(lwm2m_object_instance_t *obj,
                                    uint16_t resource);
 
+int  lwm2m_engine_has_composite_observers(const lwm2m_path_t *path);
+void lwm2m_engine_notify_composite_observers(const lwm2m_path_t *path);
+void lwm2m_engine_send_composite_notifications(void);
+int  lwm2m_engine_send(const coap_endpoint_t *server_ep,
+                       const lwm2m_path_t *paths, uint8_t count);
+
 void lwm2m_engine_set_opaque_callback(lwm2m_context_t *ctx, lwm2m_write_opaque_callback cb);
 
 #endif /* LWM2M_ENGINE_H */
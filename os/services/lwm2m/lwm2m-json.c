@@ -73,8 +73,8 @@ lwm2m_json_next_token(lwm2m_context_t *ctx, struct json_data *json)
 {
   int pos = ctx->inbuf->pos;
   uint8_t type = T_NONE;
-  uint8_t vpos_start = 0;
-  uint8_t vpos_end = 0;
+  int vpos_start = 0;
+  int vpos_end = 0;
   uint8_t cont;
   uint8_t wscount = 0;
 
@@ -86,7 +86,11 @@ lwm2m_json_next_token(lwm2m_context_t *ctx, struct json_data *json)
   while(pos < ctx->inbuf->size && cont) {
     uint8_t c = ctx->inbuf->buffer[pos++];
     switch(c) {
-    case '{': type = T_OBJ; break;
+    case '{':
+      if(type != T_STRING_B) {
+        type = T_OBJ;
+      }
+      break;
     case '}':
     case ',':
       if(type == T_VAL || type == T_STRING) {
@@ -36,18 +36,20 @@
 /**
  * \file
  *         Implementation of functions to manage the queue to store notifications
-           when waiting for the response to the update message in Queue Mode.
+ *         until they are sent. A change is queued once per path, however often
+ *         it changes, and a full queue coalesces the paths of an object
+ *         instance. The notifications of a path are sent at most every pmin
+ *         seconds, and at least every pmax seconds. While the client sleeps in
+ *         Queue Mode, the notifications are held until the next update.
  * \author
  *         Carlos Gonzalo Peces <carlosgp143@gmail.com>
  */
 /*---------------------------------------------------------------------------*/
 #include "lwm2m-notification-queue.h"
-
-#if LWM2M_QUEUE_MODE_ENABLED
-
-#include "lwm2m-queue-mode.h"
 #include "lwm2m-engine.h"
 #include "coap-engine.h"
+#include "coap-observe.h"
+#include "coap-timer.h"
 #include "lib/memb.h"
 #include "lib/list.h"
 #include <string.h>
@@ -55,6 +57,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#if LWM2M_QUEUE_MODE_ENABLED
+#include "lwm2m-queue-mode.h"
+#include "lwm2m-rd-client.h"
+#endif /* LWM2M_QUEUE_MODE_ENABLED */
+
 /* Log configuration */
 #include "coap-log.h"
 #define LOG_MODULE "lwm2m-notification-queue"
@@ -63,48 +70,144 @@
 #ifdef LWM2M_NOTIFICATION_QUEUE_CONF_LENGTH
 #define LWM2M_NOTIFICATION_QUEUE_LENGTH LWM2M_NOTIFICATION_QUEUE_CONF_LENGTH
 #else
-#define LWM2M_NOTIFICATION_QUEUE_LENGTH COAP_MAX_OBSERVERS
+#define LWM2M_NOTIFICATION_QUEUE_LENGTH (COAP_MAX_OBSERVERS * 2)
+#endif
+
+/* The number of paths with pmin/pmax attributes */
+#ifdef LWM2M_NOTIFICATION_QUEUE_CONF_ATTRIBUTES
+#define LWM2M_NOTIFICATION_QUEUE_ATTRIBUTES LWM2M_NOTIFICATION_QUEUE_CONF_ATTRIBUTES
+#else
+#define LWM2M_NOTIFICATION_QUEUE_ATTRIBUTES 4
 #endif
 
+/*
+ * Define this to 1 to report the changes held during Queue Mode sleep with
+ * a single LWM2M Send when the client wakes up, instead of notifications.
+ */
+#ifdef LWM2M_NOTIFICATION_QUEUE_CONF_SEND
+#define LWM2M_NOTIFICATION_QUEUE_SEND LWM2M_NOTIFICATION_QUEUE_CONF_SEND
+#else
+#define LWM2M_NOTIFICATION_QUEUE_SEND 0
+#endif
+
+/*
+ * Define this to 0 to hold the notifications until the next regular update
+ * in Queue Mode, instead of waking up at the first notification.
+ */
+#ifdef LWM2M_NOTIFICATION_QUEUE_CONF_WAKE_UP
+#define LWM2M_NOTIFICATION_QUEUE_WAKE_UP LWM2M_NOTIFICATION_QUEUE_CONF_WAKE_UP
+#else
+#define LWM2M_NOTIFICATION_QUEUE_WAKE_UP 1
+#endif
+
+typedef struct notification_attributes {
+  struct notification_attributes *next;
+  lwm2m_path_t path;
+  uint16_t pmin; /* seconds */
+  uint16_t pmax; /* seconds, 0 if not set */
+  uint8_t notified;
+  uint64_t last_notification;
+} notification_attributes_t;
+
 /*---------------------------------------------------------------------------*/
-/* Queue to store the notifications in the period when the client has woken up, sent the update and it's waiting for the server response*/
-MEMB(notification_memb, notification_path_t, LWM2M_NOTIFICATION_QUEUE_LENGTH); /* Length + 1 to allocate the new path to add */
+/* Queue to store the notifications until they are sent */
+MEMB(notification_memb, notification_path_t, LWM2M_NOTIFICATION_QUEUE_LENGTH);
 LIST(notification_paths_queue);
+MEMB(attributes_memb, notification_attributes_t, LWM2M_NOTIFICATION_QUEUE_ATTRIBUTES);
+LIST(attributes_list);
+
+static coap_timer_t notification_timer;
+/* The number of changes since the last notifications */
+static uint16_t queued_changes;
+/*
+ * Reading a resource for a notification may change other resources, such
+ * as the minimum and maximum of a sensor. These changes are queued while
+ * processing and sent in the same batch.
+ */
+static uint8_t processing;
+static uint8_t queued_while_processing;
+
+static void process_notifications(int flush);
+/*---------------------------------------------------------------------------*/
+static void
+notification_timer_callback(coap_timer_t *timer)
+{
+  process_notifications(0);
+}
 /*---------------------------------------------------------------------------*/
 void
 lwm2m_notification_queue_init(void)
 {
   list_init(notification_paths_queue);
+  list_init(attributes_list);
+  coap_timer_set_callback(&notification_timer, notification_timer_callback);
 }
 /*---------------------------------------------------------------------------*/
 static void
-extend_path(notification_path_t *path_object, char *path, int path_size)
+extend_path(const lwm2m_path_t *path_object, char *path, int path_size)
 {
   switch(path_object->level) {
   case 1:
-    snprintf(path, path_size, "%u", path_object->reduced_path[0]);
+    snprintf(path, path_size, "%u", path_object->object_id);
     break;
   case 2:
-    snprintf(path, path_size, "%u/%u", path_object->reduced_path[0], path_object->reduced_path[1]);
+    snprintf(path, path_size, "%u/%u", path_object->object_id, path_object->instance_id);
     break;
   case 3:
-    snprintf(path, path_size, "%u/%u/%u", path_object->reduced_path[0], path_object->reduced_path[1], path_object->reduced_path[2]);
+    snprintf(path, path_size, "%u/%u/%u", path_object->object_id, path_object->instance_id, path_object->resource_id);
     break;
   }
 }
 /*---------------------------------------------------------------------------*/
+static void
+get_path(const notification_path_t *path_object, lwm2m_path_t *path)
+{
+  path->object_id = path_object->reduced_path[0];
+  path->instance_id = path_object->reduced_path[1];
+  path->resource_id = path_object->reduced_path[2];
+  path->level = path_object->level;
+}
+/*---------------------------------------------------------------------------*/
+/* Is the path equal to, or below, the prefix path? */
+static int
+is_path_prefix(const lwm2m_path_t *prefix, const lwm2m_path_t *path)
+{
+  return prefix->level <= path->level &&
+    prefix->object_id == path->object_id &&
+    (prefix->level < 2 || prefix->instance_id == path->instance_id) &&
+    (prefix->level < 3 || prefix->resource_id == path->resource_id);
+}
+/*---------------------------------------------------------------------------*/
 static int
-is_notification_path_present(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
+has_observers(const lwm2m_path_t *path)
 {
-  notification_path_t *iteration_path = (notification_path_t *)list_head(notification_paths_queue);
-  while(iteration_path != NULL) {
-    if(iteration_path->reduced_path[0] == object_id && iteration_path->reduced_path[1] == instance_id
-       && iteration_path->reduced_path[2] == resource_id) {
-      return 1;
+  char url[20]; /* 60000/60000/60000 */
+
+#if LWM2M_QUEUE_MODE_ENABLED && LWM2M_NOTIFICATION_QUEUE_SEND
+  if(!lwm2m_rd_client_is_client_awake()) {
+    /* All the changes are reported with a Send after the sleep */
+    return 1;
+  }
+#endif /* LWM2M_QUEUE_MODE_ENABLED && LWM2M_NOTIFICATION_QUEUE_SEND */
+  extend_path(path, url, sizeof(url));
+  return coap_has_observers(url) || lwm2m_engine_has_composite_observers(path);
+}
+/*---------------------------------------------------------------------------*/
+/* The attributes of the path, or of the closest path above it */
+static notification_attributes_t *
+find_attributes(const lwm2m_path_t *path)
+{
+  notification_attributes_t *attributes;
+  notification_attributes_t *found = NULL;
+
+  for(attributes = list_head(attributes_list); attributes != NULL;
+      attributes = attributes->next) {
+    if(is_path_prefix(&attributes->path, path) &&
+       (found == NULL || attributes->path.level > found->path.level)) {
+      found = attributes;
     }
-    iteration_path = iteration_path->next;
   }
-  return 0;
+  return found;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -114,46 +217,351 @@ remove_notification_path(notification_path_t *path)
   memb_free(&notification_memb, path);
 }
 /*---------------------------------------------------------------------------*/
+/* Removes the other queued paths that are below the path */
+static void
+remove_covered_paths(notification_path_t *path_object)
+{
+  notification_path_t *iteration_path;
+  notification_path_t *next;
+  lwm2m_path_t path, prefix;
+
+  get_path(path_object, &prefix);
+  for(iteration_path = list_head(notification_paths_queue);
+      iteration_path != NULL; iteration_path = next) {
+    next = iteration_path->next;
+    get_path(iteration_path, &path);
+    if(iteration_path != path_object && is_path_prefix(&prefix, &path)) {
+      remove_notification_path(iteration_path);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+queue_path(const lwm2m_path_t *path)
+{
+  notification_path_t *iteration_path;
+  notification_path_t *path_object;
+  lwm2m_path_t queued;
+
+  queued_changes++;
+  for(iteration_path = list_head(notification_paths_queue);
+      iteration_path != NULL; iteration_path = iteration_path->next) {
+    get_path(iteration_path, &queued);
+    if(is_path_prefix(&queued, path)) {
+      LOG_DBG("Notification path already present, not queueing it\n");
+      return;
+    }
+  }
+
+  path_object = memb_alloc(&notification_memb);
+  if(path_object == NULL) {
+    /* Coalesce with a queued path of the same object instance or object */
+    for(iteration_path = list_head(notification_paths_queue);
+        iteration_path != NULL; iteration_path = iteration_path->next) {
+      if(iteration_path->reduced_path[0] == path->object_id &&
+         path->level >= 2 && iteration_path->level >= 2 &&
+         iteration_path->reduced_path[1] == path->instance_id) {
+        iteration_path->level = 2;
+        break;
+      }
+    }
+    if(iteration_path == NULL) {
+      for(iteration_path = list_head(notification_paths_queue);
+          iteration_path != NULL; iteration_path = iteration_path->next) {
+        if(iteration_path->reduced_path[0] == path->object_id) {
+          iteration_path->level = 1;
+          break;
+        }
+      }
+    }
+    if(iteration_path == NULL) {
+      LOG_WARN("Queue is full, could not queue %u/%u/%u\n",
+               path->object_id, path->instance_id, path->resource_id);
+      return;
+    }
+    LOG_DBG("Queue is full, coalesced to level %u\n", iteration_path->level);
+    remove_covered_paths(iteration_path);
+    return;
+  }
+
+  path_object->reduced_path[0] = path->object_id;
+  path_object->reduced_path[1] = path->instance_id;
+  path_object->reduced_path[2] = path->resource_id;
+  path_object->level = path->level;
+  /* The queued paths below this one are covered by its notification */
+  remove_covered_paths(path_object);
+  list_add(notification_paths_queue, path_object);
+  LOG_DBG("Notification path added to the list: %u/%u/%u\n",
+          path->object_id, path->instance_id, path->resource_id);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_notification(const lwm2m_path_t *path)
+{
+  char url[20]; /* 60000/60000/60000 */
+
+  extend_path(path, url, sizeof(url));
+#if LWM2M_QUEUE_MODE_ENABLED && LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
+  if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
+    lwm2m_queue_mode_set_handler_from_notification();
+  }
+#endif
+  LOG_DBG("Sending notification with path: %s\n", url);
+  coap_notify_observers_sub(NULL, url);
+  lwm2m_engine_notify_composite_observers(path);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Sends the notifications that are due, and sets the timer for the next
+ * ones. With flush, all the queued notifications are sent regardless of
+ * pmin.
+ */
+static void
+process_notifications(int flush)
+{
+  notification_path_t *iteration_path;
+  notification_path_t *next;
+  notification_attributes_t *attributes;
+  lwm2m_path_t path;
+  uint64_t now, due, next_time = 0;
+  uint16_t sent = 0;
+  uint8_t awake = 1;
+
+  if(processing) {
+    return;
+  }
+  processing = 1;
+  now = coap_timer_uptime();
+
+  /* pmax - notify even if nothing has changed */
+  for(attributes = list_head(attributes_list); attributes != NULL;
+      attributes = attributes->next) {
+    if(attributes->pmax > 0 &&
+       now >= attributes->last_notification + attributes->pmax * 1000ULL) {
+      if(has_observers(&attributes->path)) {
+        queue_path(&attributes->path);
+      } else {
+        attributes->last_notification = now;
+      }
+    }
+  }
+
+#if LWM2M_QUEUE_MODE_ENABLED
+  if(!lwm2m_rd_client_is_client_awake()) {
+    /* Client is sleeping -> wake up and send update at the first notification */
+    if(LWM2M_NOTIFICATION_QUEUE_WAKE_UP &&
+       list_head(notification_paths_queue) != NULL &&
+       !lwm2m_queue_mode_is_waked_up_by_notification()) {
+      lwm2m_queue_mode_set_waked_up_by_notification();
+      lwm2m_rd_client_fsm_execute_queue_mode_update(NULL);
+    }
+    awake = 0;
+  }
+#endif /* LWM2M_QUEUE_MODE_ENABLED */
+
+  if(awake) {
+    /*
+     * The changes queued while sending go out in the same batch. They are
+     * limited, in case a resource changes at every read.
+     */
+    queued_while_processing = 0;
+    for(iteration_path = list_head(notification_paths_queue);
+        iteration_path != NULL && sent < LWM2M_NOTIFICATION_QUEUE_LENGTH * 2;
+        iteration_path = next) {
+      next = iteration_path->next;
+      get_path(iteration_path, &path);
+      attributes = find_attributes(&path);
+      if(!flush && attributes != NULL && attributes->pmin > 0) {
+        due = attributes->last_notification + attributes->pmin * 1000ULL;
+        if(now < due) {
+          /* Held back by pmin */
+          if(next_time == 0 || due < next_time) {
+            next_time = due;
+          }
+          continue;
+        }
+      }
+      remove_notification_path(iteration_path);
+      send_notification(&path);
+      sent++;
+      if(attributes != NULL) {
+        attributes->notified = 1;
+      }
+      if(queued_while_processing) {
+        /* The queue may have been coalesced - start over */
+        queued_while_processing = 0;
+        next = list_head(notification_paths_queue);
+      }
+    }
+
+    if(sent > 0) {
+      /* One notification for each composite observation */
+      lwm2m_engine_send_composite_notifications();
+      LOG_INFO("Sent %u notifications for %u changes\n", sent, queued_changes);
+      queued_changes = 0;
+    }
+    if(queued_while_processing || iteration_path != NULL) {
+      /* Changed by the last reads - send them in the next batch */
+      next_time = now;
+    }
+  }
+
+  for(attributes = list_head(attributes_list); attributes != NULL;
+      attributes = attributes->next) {
+    if(attributes->notified) {
+      attributes->notified = 0;
+      attributes->last_notification = now;
+    }
+    if(attributes->pmax > 0) {
+      due = attributes->last_notification + attributes->pmax * 1000ULL;
+      if(next_time == 0 || due < next_time) {
+        next_time = due;
+      }
+    }
+  }
+
+  if(next_time > 0) {
+    coap_timer_set(&notification_timer, next_time > now ? next_time - now : 0);
+  } else {
+    coap_timer_stop(&notification_timer);
+  }
+  processing = 0;
+}
+/*---------------------------------------------------------------------------*/
 void
 lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t instance_id, uint16_t resource_id)
 {
-  if(is_notification_path_present(object_id, instance_id, resource_id)) {
-    LOG_DBG("Notification path already present, not queueing it\n");
+  lwm2m_path_t path;
+
+  path.object_id = object_id;
+  path.instance_id = instance_id;
+  path.resource_id = resource_id;
+  path.level = 3;
+  if(!has_observers(&path)) {
     return;
   }
-  notification_path_t *path_object = memb_alloc(&notification_memb);
-  if(path_object == NULL) {
-    LOG_DBG("Queue is full, could not allocate new notification\n");
+  queue_path(&path);
+  if(processing) {
+    queued_while_processing = 1;
     return;
   }
-  path_object->reduced_path[0] = object_id;
-  path_object->reduced_path[1] = instance_id;
-  path_object->reduced_path[2] = resource_id;
-  path_object->level = 3;
-  list_add(notification_paths_queue, path_object);
-  LOG_DBG("Notification path added to the list: %u/%u/%u\n", object_id, instance_id, resource_id);
+  process_notifications(0);
+}
+/*---------------------------------------------------------------------------*/
+#if LWM2M_NOTIFICATION_QUEUE_SEND
+/* Reports all the queued paths with a single LWM2M Send */
+static int
+send_queued_paths(const coap_endpoint_t *server_ep)
+{
+  lwm2m_path_t paths[LWM2M_NOTIFICATION_QUEUE_LENGTH];
+  notification_path_t *iteration_path;
+  notification_attributes_t *attributes;
+  uint8_t count = 0;
+
+  for(iteration_path = list_head(notification_paths_queue);
+      iteration_path != NULL; iteration_path = iteration_path->next) {
+    get_path(iteration_path, &paths[count++]);
+  }
+  if(count == 0) {
+    return 0;
+  }
+  /* The changes caused by reading the paths are in the report */
+  processing = 1;
+  count = lwm2m_engine_send(server_ep, paths, count) ? count : 0;
+  processing = 0;
+  if(count == 0) {
+    return 0;
+  }
+
+  LOG_INFO("Sent %u paths for %u changes\n", count, queued_changes);
+  while((iteration_path = list_head(notification_paths_queue)) != NULL) {
+    remove_notification_path(iteration_path);
+  }
+  queued_changes = 0;
+  for(attributes = list_head(attributes_list); attributes != NULL;
+      attributes = attributes->next) {
+    attributes->last_notification = coap_timer_uptime();
+  }
+  return 1;
+}
+#endif /* LWM2M_NOTIFICATION_QUEUE_SEND */
+/*---------------------------------------------------------------------------*/
+void
+lwm2m_notification_queue_send_notifications(const coap_endpoint_t *server_ep)
+{
+#if LWM2M_NOTIFICATION_QUEUE_SEND
+  if(server_ep != NULL && send_queued_paths(server_ep)) {
+    process_notifications(0);
+    return;
+  }
+#endif /* LWM2M_NOTIFICATION_QUEUE_SEND */
+  process_notifications(1);
 }
 /*---------------------------------------------------------------------------*/
 void
-lwm2m_notification_queue_send_notifications()
+lwm2m_notification_queue_get_attributes(const lwm2m_path_t *path,
+                                        uint16_t *pmin, uint16_t *pmax)
 {
-  char path[20];
-  notification_path_t *iteration_path = (notification_path_t *)list_head(notification_paths_queue);
-  notification_path_t *aux = iteration_path;
+  notification_attributes_t *attributes;
 
-  while(iteration_path != NULL) {
-    extend_path(iteration_path, path, sizeof(path));
-#if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
-    if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
-      lwm2m_queue_mode_set_handler_from_notification();
+  *pmin = 0;
+  *pmax = 0;
+  for(attributes = list_head(attributes_list); attributes != NULL;
+      attributes = attributes->next) {
+    if(attributes->path.level == path->level &&
+       is_path_prefix(&attributes->path, path)) {
+      *pmin = attributes->pmin;
+      *pmax = attributes->pmax;
+      return;
     }
-#endif
-    LOG_DBG("Sending stored notification with path: %s\n", path);
-    coap_notify_observers_sub(NULL, path);
-    aux = iteration_path;
-    iteration_path = iteration_path->next;
-    remove_notification_path(aux);
   }
 }
-#endif /* LWM2M_QUEUE_MODE_ENABLED */
-/** @} */
\ No newline at end of file
+/*---------------------------------------------------------------------------*/
+lwm2m_status_t
+lwm2m_notification_queue_set_attributes(const lwm2m_path_t *path,
+                                        uint16_t pmin, uint16_t pmax)
+{
+  notification_attributes_t *attributes;
+
+  if(pmax > 0 && pmin > pmax) {
+    return LWM2M_STATUS_BAD_REQUEST;
+  }
+
+  for(attributes = list_head(attributes_list); attributes != NULL;
+      attributes = attributes->next) {
+    if(attributes->path.level == path->level &&
+       is_path_prefix(&attributes->path, path)) {
+      break;
+    }
+  }
+
+  if(pmin == 0 && pmax == 0) {
+    if(attributes != NULL) {
+      list_remove(attributes_list, attributes);
+      memb_free(&attributes_memb, attributes);
+    }
+  } else {
+    if(attributes == NULL) {
+      attributes = memb_alloc(&attributes_memb);
+      if(attributes == NULL) {
+        LOG_WARN("No room for the attributes of %u/%u/%u\n",
+                 path->object_id, path->instance_id, path->resource_id);
+        return LWM2M_STATUS_SERVICE_UNAVAILABLE;
+      }
+      memcpy(&attributes->path, path, sizeof(lwm2m_path_t));
+      attributes->notified = 0;
+      attributes->last_notification = coap_timer_uptime();
+      list_add(attributes_list, attributes);
+    }
+    attributes->pmin = pmin;
+    attributes->pmax = pmax;
+  }
+  LOG_INFO("Attributes of %u/%u/%u (level %u): pmin %u pmax %u\n",
+           path->object_id, path->instance_id, path->resource_id,
+           path->level, pmin, pmax);
+
+  process_notifications(0);
+  return LWM2M_STATUS_OK;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
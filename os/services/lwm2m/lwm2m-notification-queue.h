@@ -36,7 +36,9 @@
 /**
  * \file
  *         Header file for functions to manage the queue to store notifications
-       when waiting for the response to the update message in Queue Mode.
+ *         until they are sent. The queue coalesces the changes, applies the
+ *         pmin/pmax notification attributes, and holds the notifications while
+ *         the client sleeps in Queue Mode.
  * \author
  *         Carlos Gonzalo Peces <carlosgp143@gmail.com>
  */
@@ -45,7 +47,9 @@
 #define LWM2M_NOTIFICATION_QUEUE_H
 
 #include "contiki.h"
+#include "lwm2m-engine.h"
 #include "lwm2m-queue-mode-conf.h"
+#include "coap-endpoint.h"
 
 #include <inttypes.h>
 
@@ -59,7 +63,15 @@ void lwm2m_notification_queue_init(void);
 
 void lwm2m_notification_queue_add_notification_path(uint16_t object_id, uint16_t instance_id, uint16_t resource_id);
 
-void lwm2m_notification_queue_send_notifications();
+/* Sends the stored notifications when the client wakes up in Queue Mode */
+void lwm2m_notification_queue_send_notifications(const coap_endpoint_t *server_ep);
+
+/* The pmin and pmax attributes in seconds, 0 if not set */
+void lwm2m_notification_queue_get_attributes(const lwm2m_path_t *path,
+                                             uint16_t *pmin, uint16_t *pmax);
+lwm2m_status_t lwm2m_notification_queue_set_attributes(const lwm2m_path_t *path,
+                                                       uint16_t pmin,
+                                                       uint16_t pmax);
 
 #endif /* LWM2M_NOTIFICATION_QUEUE_H */
-/** @} */
\ No newline at end of file
+/** @} */
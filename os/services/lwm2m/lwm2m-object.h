@@ -116,6 +116,10 @@ typedef enum {
 #define WRITER_OUTPUT_VALUE      1
 #define WRITER_RESOURCE_INSTANCE 2
 #define WRITER_HAS_MORE          4
+/* another object instance follows in the same payload */
+#define WRITER_MORE_INSTANCES    8
+/* the SenML array of the payload has been opened */
+#define WRITER_SENML_OPEN        16
 
 typedef struct lwm2m_reader lwm2m_reader_t;
 typedef struct lwm2m_writer lwm2m_writer_t;
@@ -158,6 +162,7 @@ typedef struct lwm2m_context {
   uint16_t last_value_len;
 
   uint8_t writer_flags; /* flags for reader/writer */
+  uint32_t senml_base; /* object instance of the last SenML base name */
   const lwm2m_reader_t *reader;
   const lwm2m_writer_t *writer;
 } lwm2m_context_t;
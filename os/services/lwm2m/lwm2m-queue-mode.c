@@ -121,6 +121,7 @@ lwm2m_queue_mode_set_dynamic_adaptation_flag(uint8_t flag)
 }
 #endif
 /*---------------------------------------------------------------------------*/
+#if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
 #if !UPDATE_WITH_MEAN
 static uint16_t
 get_maximum_time()
@@ -181,6 +182,7 @@ lwm2m_queue_mode_add_time_to_window(uint16_t time)
   times_window_index++;
   update_awake_time();
 }
+#endif /* LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION */
 /*---------------------------------------------------------------------------*/
 uint8_t
 lwm2m_queue_mode_is_waked_up_by_notification()
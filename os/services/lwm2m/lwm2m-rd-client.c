@@ -55,6 +55,7 @@
 #include "coap-callback-api.h"
 #include "lwm2m-security.h"
 #include "lib/list.h"
+#include "sys/energest.h"
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
@@ -125,6 +126,9 @@ static uint8_t queue_mode_client_awake; /* 1 - client is awake,
                                          * 0 - client is sleeping
                                          */
 static uint16_t queue_mode_client_awake_time; /* The time to be awake */
+/* Uptime and radio-on time at the wake-up, to measure the awake period */
+static uint64_t queue_mode_wake_up_time;
+static uint64_t queue_mode_wake_up_radio_time;
 /* Callback for the client awake timer */
 static void queue_mode_awake_timer_callback(coap_timer_t *timer);
 #endif
@@ -493,11 +497,8 @@ update_callback(coap_callback_request_state_t *callback_state)
       /* remember the last reg time */
       session_info->last_update = coap_timer_uptime();
 #if LWM2M_QUEUE_MODE_ENABLED
-      /* If it has been waked up by a notification, send the stored notifications in queue */
       if(lwm2m_queue_mode_is_waked_up_by_notification()) {
-
         lwm2m_queue_mode_clear_waked_up_by_notification();
-        lwm2m_notification_queue_send_notifications();
       }
 #if LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION
       if(lwm2m_queue_mode_get_dynamic_adaptation_flag()) {
@@ -505,6 +506,8 @@ update_callback(coap_callback_request_state_t *callback_state)
       }
 #endif /* LWM2M_QUEUE_MODE_INCLUDE_DYNAMIC_ADAPTATION */
       lwm2m_rd_client_fsm_execute_queue_mode_awake(session_info); /* Avoid 500 ms delay and move directly to the state*/
+      /* Send the notifications that were stored while sleeping */
+      lwm2m_notification_queue_send_notifications(&session_info->server_ep);
 #else
 
       session_info->rd_state = REGISTRATION_DONE;
@@ -790,6 +793,12 @@ periodic_process(coap_timer_t *timer)
 #ifdef LWM2M_QUEUE_MODE_WAKE_UP
       LWM2M_QUEUE_MODE_WAKE_UP();
 #endif /* LWM2M_QUEUE_MODE_WAKE_UP */
+      if(queue_mode_wake_up_time == 0) {
+        energest_flush();
+        queue_mode_wake_up_time = coap_timer_uptime();
+        queue_mode_wake_up_radio_time = energest_type_time(ENERGEST_TYPE_LISTEN) +
+          energest_type_time(ENERGEST_TYPE_TRANSMIT);
+      }
       prepare_update(session_info, session_info->rd_flags & FLAG_RD_DATA_UPDATE_TRIGGERED);
       /* Add session info as user data to use it in the callbacks */
       session_info->rd_request_state.state.user_data = (void *)session_info;
@@ -873,6 +882,18 @@ queue_mode_awake_timer_callback(coap_timer_t *timer)
   LOG_DBG("Queue Mode: Client is SLEEPING at %lu\n", (unsigned long)coap_timer_uptime());
   queue_mode_client_awake = 0;
 
+  if(queue_mode_wake_up_time > 0) {
+    /* The radio-on time is only measured with Energest enabled */
+    energest_flush();
+    LOG_INFO("Queue Mode: awake for %lu ms, radio on for %lu ms\n",
+             (unsigned long)(coap_timer_uptime() - queue_mode_wake_up_time),
+             (unsigned long)((energest_type_time(ENERGEST_TYPE_LISTEN) +
+                              energest_type_time(ENERGEST_TYPE_TRANSMIT) -
+                              queue_mode_wake_up_radio_time) * 1000 /
+                             ENERGEST_SECOND));
+    queue_mode_wake_up_time = 0;
+  }
+
   lwm2m_session_info_t *session_info = (lwm2m_session_info_t *)list_head(session_info_list);
   while(session_info != NULL) {
     session_info->rd_state = QUEUE_MODE_SEND_UPDATE;
@@ -897,7 +918,10 @@ void
 lwm2m_rd_client_fsm_execute_queue_mode_update(lwm2m_session_info_t *session_info)
 {
   coap_timer_stop(&rd_timer);
-  session_info->rd_state = QUEUE_MODE_SEND_UPDATE;
+  /* Without a session, the sleeping sessions are already waiting to update */
+  if(session_info != NULL) {
+    session_info->rd_state = QUEUE_MODE_SEND_UPDATE;
+  }
   periodic_process(&rd_timer);
 }
 /*---------------------------------------------------------------------------*/
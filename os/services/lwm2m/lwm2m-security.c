@@ -287,6 +287,8 @@ lwm2m_security_add_server(uint16_t instance_id,
         instances[i].instance.resource_count =
           sizeof(resources) / sizeof(lwm2m_resource_id_t);
         list_add(instances_list, &instances[i].instance);
+        /* The registration payload has changed */
+        lwm2m_engine_clear_rd_data();
         server = &instances[i];
       }
     }
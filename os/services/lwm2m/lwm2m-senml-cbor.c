@@ -0,0 +1,724 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M SenML-CBOR reader and
+ *         writer
+ */
+
+#include "lwm2m-object.h"
+#include "lwm2m-senml.h"
+#include "lwm2m-senml-cbor.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "lwm2m-cbor"
+#define LOG_LEVEL  LOG_LEVEL_NONE
+
+/* CBOR major types (RFC 8949) */
+#define CBOR_UINT    0
+#define CBOR_NINT    1
+#define CBOR_BYTES   2
+#define CBOR_TEXT    3
+#define CBOR_ARRAY   4
+#define CBOR_MAP     5
+#define CBOR_SIMPLE  7
+
+#define CBOR_INDEFINITE 31
+#define CBOR_FALSE   0xf4
+#define CBOR_TRUE    0xf5
+#define CBOR_FLOAT16 0xf9
+#define CBOR_FLOAT32 0xfa
+#define CBOR_FLOAT64 0xfb
+#define CBOR_BREAK   0xff
+
+/* Nesting depth of the data items that the reader skips */
+#define CBOR_MAX_DEPTH 4
+
+/* SenML labels (RFC 8428, Section 6) */
+#define SENML_BASE_NAME -2
+#define SENML_NAME       0
+#define SENML_VALUE      2
+#define SENML_STRING     3
+#define SENML_BOOLEAN    4
+#define SENML_DATA       8
+/* Any label that the reader ignores */
+#define SENML_OTHER      0x7fff
+
+/* Room for the longest base name, "/65535/65535/" */
+#define NAME_SIZE 14
+
+#define APPEND(x) do {                          \
+    size_t s = (x);                             \
+    if(s == 0) {                                \
+      return 0;                                 \
+    }                                           \
+    len += s;                                   \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+static size_t
+write_head(uint8_t *outbuf, size_t outlen, uint8_t major, uint32_t arg)
+{
+  size_t len;
+
+  major <<= 5;
+  if(arg < 24) {
+    len = 1;
+    outbuf[0] = major | arg;
+  } else if(arg <= 0xff) {
+    len = 2;
+    outbuf[0] = major | 24;
+  } else if(arg <= 0xffff) {
+    len = 3;
+    outbuf[0] = major | 25;
+  } else {
+    len = 5;
+    outbuf[0] = major | 26;
+  }
+  if(outlen < len) {
+    return 0;
+  }
+  switch(len) {
+  case 5:
+    outbuf[1] = arg >> 24;
+    outbuf[2] = arg >> 16;
+    outbuf[3] = arg >> 8;
+    outbuf[4] = arg;
+    break;
+  case 3:
+    outbuf[1] = arg >> 8;
+    outbuf[2] = arg;
+    break;
+  case 2:
+    outbuf[1] = arg;
+    break;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_label(uint8_t *outbuf, size_t outlen, int label)
+{
+  if(label < 0) {
+    return write_head(outbuf, outlen, CBOR_NINT, -1 - label);
+  }
+  return write_head(outbuf, outlen, CBOR_UINT, label);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_text(uint8_t *outbuf, size_t outlen, const char *text, size_t textlen)
+{
+  size_t len;
+
+  len = write_head(outbuf, outlen, CBOR_TEXT, textlen);
+  if(len == 0 || outlen - len < textlen) {
+    return 0;
+  }
+  memcpy(&outbuf[len], text, textlen);
+  return len + textlen;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes the start of a record: the map header, the base name if the
+ * object instance has changed, the name and the label of the value.
+ */
+static size_t
+write_record(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen, int label)
+{
+  char name[NAME_SIZE];
+  uint32_t base;
+  int new_base;
+  int name_len;
+  size_t len = 0;
+
+  base = ((uint32_t)ctx->object_id << 16) | ctx->object_instance_id;
+  new_base = ctx->senml_base != base;
+
+  APPEND(write_head(outbuf, outlen, CBOR_MAP, new_base ? 3 : 2));
+  if(new_base) {
+    name_len = snprintf(name, sizeof(name), "/%u/%u/",
+                        ctx->object_id, ctx->object_instance_id);
+    APPEND(write_label(&outbuf[len], outlen - len, SENML_BASE_NAME));
+    APPEND(write_text(&outbuf[len], outlen - len, name, name_len));
+  }
+  if(ctx->writer_flags & WRITER_RESOURCE_INSTANCE) {
+    name_len = snprintf(name, sizeof(name), "%u/%u",
+                        ctx->resource_id, ctx->resource_instance_id);
+  } else {
+    name_len = snprintf(name, sizeof(name), "%u", ctx->resource_id);
+  }
+  APPEND(write_label(&outbuf[len], outlen - len, SENML_NAME));
+  APPEND(write_text(&outbuf[len], outlen - len, name, name_len));
+  APPEND(write_label(&outbuf[len], outlen - len, label));
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_record(lwm2m_context_t *ctx, size_t len)
+{
+  ctx->senml_base = ((uint32_t)ctx->object_id << 16) | ctx->object_instance_id;
+  ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Converts a fixed point value to the bits of an IEEE 754 single precision
+ * float, without using floating point arithmetics.
+ */
+static uint32_t
+fix_to_float32(int32_t value, int bits)
+{
+  uint32_t sign = 0;
+  uint32_t mantissa;
+  int msb;
+
+  if(value == 0) {
+    return 0;
+  }
+  if(value < 0) {
+    sign = 0x80000000;
+    mantissa = -(uint32_t)value;
+  } else {
+    mantissa = value;
+  }
+  for(msb = 31; (mantissa & (1UL << msb)) == 0; msb--);
+
+  /* Place the most significant bit at bit 23 and round to nearest */
+  if(msb > 23) {
+    mantissa += 1UL << (msb - 24);
+    if(msb < 31 && (mantissa >> (msb + 1)) != 0) {
+      /* The rounding carried into the next bit */
+      msb++;
+    }
+    mantissa >>= msb - 23;
+  } else {
+    mantissa <<= 23 - msb;
+  }
+  return sign | ((uint32_t)(msb - bits + 127) << 23) | (mantissa & 0x7fffff);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+init_write(lwm2m_context_t *ctx)
+{
+  if(ctx->writer_flags & (WRITER_SENML_OPEN | WRITER_OUTPUT_VALUE)) {
+    return 0;
+  }
+  if(ctx->outbuf->len >= ctx->outbuf->size) {
+    return 0;
+  }
+  ctx->writer_flags |= WRITER_SENML_OPEN;
+  ctx->senml_base = LWM2M_SENML_NO_BASE;
+  /* The number of records is not known: use an indefinite length array */
+  ctx->outbuf->buffer[ctx->outbuf->len] = (CBOR_ARRAY << 5) | CBOR_INDEFINITE;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_write(lwm2m_context_t *ctx)
+{
+  size_t len = 0;
+
+  if(ctx->writer_flags & WRITER_MORE_INSTANCES) {
+    return 0;
+  }
+  if((ctx->writer_flags & (WRITER_SENML_OPEN | WRITER_OUTPUT_VALUE)) == 0) {
+    len = init_write(ctx);
+    if(len == 0) {
+      return 0;
+    }
+  }
+  if(ctx->outbuf->len + len >= ctx->outbuf->size) {
+    return 0;
+  }
+  ctx->outbuf->buffer[ctx->outbuf->len + len] = CBOR_BREAK;
+  ctx->writer_flags &= ~WRITER_SENML_OPEN;
+  return len + 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+enter_sub(lwm2m_context_t *ctx)
+{
+  ctx->writer_flags |= WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+exit_sub(lwm2m_context_t *ctx)
+{
+  ctx->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+          int32_t value)
+{
+  size_t len = 0;
+
+  APPEND(write_record(ctx, outbuf, outlen, SENML_VALUE));
+  if(value < 0) {
+    APPEND(write_head(&outbuf[len], outlen - len, CBOR_NINT,
+                      -(uint32_t)(value + 1)));
+  } else {
+    APPEND(write_head(&outbuf[len], outlen - len, CBOR_UINT, value));
+  }
+  LOG_DBG("Write int %"PRId32" (%u bytes)\n", value, (unsigned)len);
+  return end_record(ctx, len);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *value, size_t stringlen)
+{
+  size_t len = 0;
+
+  APPEND(write_record(ctx, outbuf, outlen, SENML_STRING));
+  APPEND(write_text(&outbuf[len], outlen - len, value, stringlen));
+  return end_record(ctx, len);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                 int32_t value, int bits)
+{
+  uint32_t f;
+  size_t len = 0;
+
+  APPEND(write_record(ctx, outbuf, outlen, SENML_VALUE));
+  if(outlen - len < 5) {
+    return 0;
+  }
+  f = fix_to_float32(value, bits);
+  outbuf[len++] = CBOR_FLOAT32;
+  outbuf[len++] = f >> 24;
+  outbuf[len++] = f >> 16;
+  outbuf[len++] = f >> 8;
+  outbuf[len++] = f;
+  return end_record(ctx, len);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+              int value)
+{
+  size_t len = 0;
+
+  APPEND(write_record(ctx, outbuf, outlen, SENML_BOOLEAN));
+  if(outlen - len < 1) {
+    return 0;
+  }
+  outbuf[len++] = value ? CBOR_TRUE : CBOR_FALSE;
+  return end_record(ctx, len);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The length of a byte string is encoded before its data, so an opaque
+ * resource can be streamed after this header.
+ */
+static size_t
+write_opaque_header(lwm2m_context_t *ctx, size_t total_size)
+{
+  uint8_t *outbuf = &ctx->outbuf->buffer[ctx->outbuf->len];
+  size_t outlen = ctx->outbuf->size - ctx->outbuf->len;
+  size_t len = 0;
+
+  APPEND(write_record(ctx, outbuf, outlen, SENML_DATA));
+  APPEND(write_head(&outbuf[len], outlen - len, CBOR_BYTES, total_size));
+  return end_record(ctx, len);
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_writer_t lwm2m_senml_cbor_writer = {
+  init_write,
+  end_write,
+  enter_sub,
+  exit_sub,
+  write_int,
+  write_string,
+  write_float32fix,
+  write_boolean,
+  write_opaque_header
+};
+/*---------------------------------------------------------------------------*/
+/*
+ * Reads the head of a data item. Returns the size of the head, or 0 if
+ * the head is incomplete or uses a reserved encoding.
+ */
+static size_t
+read_head(const uint8_t *inbuf, size_t len, uint8_t *major, uint64_t *arg)
+{
+  uint8_t info;
+  size_t size;
+  size_t i;
+
+  if(len == 0) {
+    return 0;
+  }
+  *major = inbuf[0] >> 5;
+  info = inbuf[0] & 0x1f;
+  if(info < 24 || info == CBOR_INDEFINITE) {
+    *arg = info;
+    return 1;
+  }
+  if(info > 27) {
+    return 0;
+  }
+  size = 1 << (info - 24);
+  if(len < size + 1) {
+    return 0;
+  }
+  *arg = 0;
+  for(i = 1; i <= size; i++) {
+    *arg = (*arg << 8) | inbuf[i];
+  }
+  return size + 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the size of the data item at inbuf, or 0 if it is malformed */
+static size_t
+skip_item(const uint8_t *inbuf, size_t len, int depth)
+{
+  uint8_t major;
+  uint64_t arg;
+  uint64_t count;
+  size_t pos;
+  size_t size;
+
+  pos = read_head(inbuf, len, &major, &arg);
+  if(pos == 0 || depth > CBOR_MAX_DEPTH) {
+    return 0;
+  }
+  switch(major) {
+  case CBOR_BYTES:
+  case CBOR_TEXT:
+    if((inbuf[0] & 0x1f) == CBOR_INDEFINITE || arg > len - pos) {
+      return 0;
+    }
+    return pos + arg;
+  case CBOR_ARRAY:
+  case CBOR_MAP:
+    if((inbuf[0] & 0x1f) == CBOR_INDEFINITE) {
+      while(pos < len && inbuf[pos] != CBOR_BREAK) {
+        size = skip_item(&inbuf[pos], len - pos, depth + 1);
+        if(size == 0) {
+          return 0;
+        }
+        pos += size;
+      }
+      return pos < len ? pos + 1 : 0;
+    }
+    count = major == CBOR_MAP ? arg * 2 : arg;
+    while(count-- > 0) {
+      size = skip_item(&inbuf[pos], len - pos, depth + 1);
+      if(size == 0) {
+        return 0;
+      }
+      pos += size;
+    }
+    return pos;
+  default:
+    if((inbuf[0] & 0x1f) == CBOR_INDEFINITE) {
+      return 0;
+    }
+    return pos;
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_senml_cbor_next_record(lwm2m_context_t *ctx,
+                             lwm2m_senml_record_t *record)
+{
+  const uint8_t *inbuf = ctx->inbuf->buffer;
+  size_t len = ctx->inbuf->size;
+  size_t pos = ctx->inbuf->pos;
+  size_t size;
+  uint8_t major;
+  uint64_t arg;
+  uint64_t count;
+  int indefinite;
+  int64_t label;
+
+  if(pos == 0) {
+    /* Skip the head of the array of records */
+    size = read_head(inbuf, len, &major, &arg);
+    if(size == 0 || major != CBOR_ARRAY) {
+      return 0;
+    }
+    pos = size;
+  }
+  if(pos >= len || inbuf[pos] == CBOR_BREAK) {
+    return 0;
+  }
+
+  size = read_head(&inbuf[pos], len - pos, &major, &count);
+  if(size == 0 || major != CBOR_MAP) {
+    LOG_DBG("Record is not a map\n");
+    return 0;
+  }
+  indefinite = (inbuf[pos] & 0x1f) == CBOR_INDEFINITE;
+  pos += size;
+
+  record->name = NULL;
+  record->name_len = 0;
+  record->value = NULL;
+  record->value_len = 0;
+
+  while(indefinite ? (pos < len && inbuf[pos] != CBOR_BREAK) : count-- > 0) {
+    /* The label */
+    size = read_head(&inbuf[pos], len - pos, &major, &arg);
+    if(size == 0) {
+      return 0;
+    }
+    if(major == CBOR_UINT) {
+      label = arg;
+    } else if(major == CBOR_NINT) {
+      label = -1 - (int64_t)arg;
+    } else {
+      /* Text labels, such as "vlo" for object links, are not supported */
+      label = SENML_OTHER;
+      size = skip_item(&inbuf[pos], len - pos, 0);
+      if(size == 0) {
+        return 0;
+      }
+    }
+    pos += size;
+
+    /* The value */
+    size = skip_item(&inbuf[pos], len - pos, 0);
+    if(size == 0) {
+      return 0;
+    }
+    if(label == SENML_BASE_NAME || label == SENML_NAME) {
+      if(read_head(&inbuf[pos], size, &major, &arg) == 0 ||
+         major != CBOR_TEXT) {
+        return 0;
+      }
+      if(label == SENML_BASE_NAME) {
+        record->base_name = &inbuf[pos + size - arg];
+        record->base_name_len = arg;
+      } else {
+        record->name = &inbuf[pos + size - arg];
+        record->name_len = arg;
+      }
+    } else if(label == SENML_VALUE || label == SENML_STRING ||
+              label == SENML_BOOLEAN || label == SENML_DATA) {
+      record->value = &inbuf[pos];
+      record->value_len = size;
+    }
+    pos += size;
+  }
+  if(indefinite) {
+    if(pos >= len) {
+      return 0;
+    }
+    /* The break of the map */
+    pos++;
+  }
+  ctx->inbuf->pos = pos;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Converts a half, single or double precision float to a fixed point
+ * value. The mantissa includes the implicit bit.
+ */
+static size_t
+read_float(const uint8_t *inbuf, size_t len, int32_t *value, int bits)
+{
+  uint64_t raw = 0;
+  uint64_t mantissa;
+  int mantissa_bits;
+  int exponent_bits;
+  int exponent;
+  int shift;
+  int negative;
+  size_t size;
+  size_t i;
+
+  switch(inbuf[0]) {
+  case CBOR_FLOAT16:
+    size = 3;
+    mantissa_bits = 10;
+    exponent_bits = 5;
+    break;
+  case CBOR_FLOAT32:
+    size = 5;
+    mantissa_bits = 23;
+    exponent_bits = 8;
+    break;
+  case CBOR_FLOAT64:
+    size = 9;
+    mantissa_bits = 52;
+    exponent_bits = 11;
+    break;
+  default:
+    return 0;
+  }
+  if(len < size) {
+    return 0;
+  }
+  for(i = 1; i < size; i++) {
+    raw = (raw << 8) | inbuf[i];
+  }
+
+  negative = (raw >> (mantissa_bits + exponent_bits)) & 1;
+  exponent = (raw >> mantissa_bits) & ((1 << exponent_bits) - 1);
+  mantissa = raw & ((1ULL << mantissa_bits) - 1);
+  if(exponent == (1 << exponent_bits) - 1) {
+    /* Infinity or NaN */
+    return 0;
+  }
+  if(exponent == 0) {
+    /* Subnormal */
+    exponent = 1;
+  } else {
+    mantissa |= 1ULL << mantissa_bits;
+  }
+  /* The value is mantissa * 2^shift in the fixed point format */
+  shift = exponent - ((1 << (exponent_bits - 1)) - 1) - mantissa_bits + bits;
+
+  if(shift >= 0) {
+    if(mantissa != 0 && (shift > 31 || mantissa > (INT32_MAX >> shift))) {
+      mantissa = (uint64_t)INT32_MAX + negative;
+    } else {
+      mantissa <<= shift;
+    }
+  } else if(-shift > 63) {
+    mantissa = 0;
+  } else {
+    /* Round to nearest */
+    mantissa = (mantissa + (1ULL << (-shift - 1))) >> -shift;
+    if(mantissa > INT32_MAX) {
+      mantissa = (uint64_t)INT32_MAX + negative;
+    }
+  }
+  *value = negative ? (int32_t)-(int64_t)mantissa : (int32_t)mantissa;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_int(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+         int32_t *value)
+{
+  uint8_t major;
+  uint64_t arg;
+  size_t size;
+
+  size = read_head(inbuf, len, &major, &arg);
+  if(size == 0) {
+    return 0;
+  }
+  if(major == CBOR_UINT && arg <= INT32_MAX) {
+    *value = arg;
+  } else if(major == CBOR_NINT && arg <= INT32_MAX) {
+    *value = -1 - (int32_t)arg;
+  } else if(major == CBOR_SIMPLE) {
+    size = read_float(inbuf, len, value, 0);
+  } else {
+    return 0;
+  }
+  ctx->last_value_len = size;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_string(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+            uint8_t *value, size_t stringlen)
+{
+  uint8_t major;
+  uint64_t arg;
+  size_t size;
+
+  size = read_head(inbuf, len, &major, &arg);
+  if(size == 0 || (major != CBOR_TEXT && major != CBOR_BYTES) ||
+     arg > len - size) {
+    return 0;
+  }
+  if(stringlen <= arg) {
+    /* The outbuffer can not contain the full string including ending zero */
+    return 0;
+  }
+  memcpy(value, &inbuf[size], arg);
+  value[arg] = '\0';
+  ctx->last_value_len = arg;
+  return arg;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_float32fix(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+                int32_t *value, int bits)
+{
+  size_t size;
+
+  if(len > 0 && (inbuf[0] >> 5) == CBOR_SIMPLE) {
+    size = read_float(inbuf, len, value, bits);
+  } else {
+    size = read_int(ctx, inbuf, len, value);
+    if(size > 0) {
+      if(*value > (INT32_MAX >> bits)) {
+        *value = INT32_MAX;
+      } else if(*value < (INT32_MIN >> bits)) {
+        *value = INT32_MIN;
+      } else {
+        *value *= 1L << bits;
+      }
+    }
+  }
+  ctx->last_value_len = size;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_boolean(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+             int *value)
+{
+  if(len > 0 && (inbuf[0] == CBOR_TRUE || inbuf[0] == CBOR_FALSE)) {
+    *value = inbuf[0] == CBOR_TRUE;
+    ctx->last_value_len = 1;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_reader_t lwm2m_senml_cbor_reader = {
+  read_int,
+  read_string,
+  read_float32fix,
+  read_boolean
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
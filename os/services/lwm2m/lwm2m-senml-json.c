@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Implementation of the Contiki OMA LWM2M SenML-JSON reader and
+ *         writer
+ */
+
+#include "lwm2m-object.h"
+#include "lwm2m-json.h"
+#include "lwm2m-plain-text.h"
+#include "lwm2m-senml.h"
+#include "lwm2m-senml-json.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "lwm2m-senml"
+#define LOG_LEVEL  LOG_LEVEL_NONE
+
+/* [{"bn":"/3/0/","n":"0","vs":"Contiki-NG"},{"n":"9","v":100}] */
+
+/*---------------------------------------------------------------------------*/
+/*
+ * Writes the start of a record up to the value: the separator, the base
+ * name if the object instance has changed, the name and the label.
+ */
+static size_t
+write_record(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *label)
+{
+  const char *sep = (ctx->writer_flags & WRITER_OUTPUT_VALUE) ? "," : "";
+  uint32_t base;
+  int len;
+  int res;
+
+  base = ((uint32_t)ctx->object_id << 16) | ctx->object_instance_id;
+  if(ctx->senml_base != base) {
+    len = snprintf((char *)outbuf, outlen, "%s{\"bn\":\"/%u/%u/\",", sep,
+                   ctx->object_id, ctx->object_instance_id);
+  } else {
+    len = snprintf((char *)outbuf, outlen, "%s{", sep);
+  }
+  if(len < 0 || len >= outlen) {
+    return 0;
+  }
+  if(ctx->writer_flags & WRITER_RESOURCE_INSTANCE) {
+    res = snprintf((char *)&outbuf[len], outlen - len, "\"n\":\"%u/%u\",\"%s\":",
+                   ctx->resource_id, ctx->resource_instance_id, label);
+  } else {
+    res = snprintf((char *)&outbuf[len], outlen - len, "\"n\":\"%u\",\"%s\":",
+                   ctx->resource_id, label);
+  }
+  if(res < 0 || res >= outlen - len) {
+    return 0;
+  }
+  return len + res;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_record(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen, size_t len)
+{
+  if(len + 1 >= outlen) {
+    return 0;
+  }
+  outbuf[len++] = '}';
+  ctx->senml_base = ((uint32_t)ctx->object_id << 16) | ctx->object_instance_id;
+  ctx->writer_flags |= WRITER_OUTPUT_VALUE;
+  LOG_DBG("Write %.*s\n", (int)len, (char *)outbuf);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+init_write(lwm2m_context_t *ctx)
+{
+  if(ctx->writer_flags & (WRITER_SENML_OPEN | WRITER_OUTPUT_VALUE)) {
+    return 0;
+  }
+  if(ctx->outbuf->len >= ctx->outbuf->size) {
+    return 0;
+  }
+  ctx->writer_flags |= WRITER_SENML_OPEN;
+  ctx->senml_base = LWM2M_SENML_NO_BASE;
+  ctx->outbuf->buffer[ctx->outbuf->len] = '[';
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+end_write(lwm2m_context_t *ctx)
+{
+  size_t len = 0;
+
+  if(ctx->writer_flags & WRITER_MORE_INSTANCES) {
+    return 0;
+  }
+  if((ctx->writer_flags & (WRITER_SENML_OPEN | WRITER_OUTPUT_VALUE)) == 0) {
+    len = init_write(ctx);
+    if(len == 0) {
+      return 0;
+    }
+  }
+  if(ctx->outbuf->len + len >= ctx->outbuf->size) {
+    return 0;
+  }
+  ctx->outbuf->buffer[ctx->outbuf->len + len] = ']';
+  ctx->writer_flags &= ~WRITER_SENML_OPEN;
+  return len + 1;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+enter_sub(lwm2m_context_t *ctx)
+{
+  ctx->writer_flags |= WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+exit_sub(lwm2m_context_t *ctx)
+{
+  ctx->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_int(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+          int32_t value)
+{
+  size_t len;
+  int res;
+
+  len = write_record(ctx, outbuf, outlen, "v");
+  if(len == 0) {
+    return 0;
+  }
+  res = snprintf((char *)&outbuf[len], outlen - len, "%"PRId32, value);
+  if(res <= 0 || res >= outlen - len) {
+    return 0;
+  }
+  return end_record(ctx, outbuf, outlen, len + res);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_float32fix(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+                 int32_t value, int bits)
+{
+  size_t len;
+  size_t res;
+
+  len = write_record(ctx, outbuf, outlen, "v");
+  if(len == 0) {
+    return 0;
+  }
+  res = lwm2m_plain_text_write_float32fix(&outbuf[len], outlen - len,
+                                          value, bits);
+  if(res == 0 || res >= outlen - len) {
+    return 0;
+  }
+  return end_record(ctx, outbuf, outlen, len + res);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_boolean(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+              int value)
+{
+  size_t len;
+  int res;
+
+  len = write_record(ctx, outbuf, outlen, "vb");
+  if(len == 0) {
+    return 0;
+  }
+  res = snprintf((char *)&outbuf[len], outlen - len, value ? "true" : "false");
+  if(res <= 0 || res >= outlen - len) {
+    return 0;
+  }
+  return end_record(ctx, outbuf, outlen, len + res);
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+write_string(lwm2m_context_t *ctx, uint8_t *outbuf, size_t outlen,
+             const char *value, size_t stringlen)
+{
+  size_t len;
+  size_t i;
+  int res;
+
+  len = write_record(ctx, outbuf, outlen, "vs");
+  if(len == 0 || len + 1 >= outlen) {
+    return 0;
+  }
+  outbuf[len++] = '"';
+  for(i = 0; i < stringlen; i++) {
+    if((uint8_t)value[i] < 0x20) {
+      res = snprintf((char *)&outbuf[len], outlen - len, "\\u%04x",
+                     (uint8_t)value[i]);
+      if(res <= 0 || res >= outlen - len) {
+        return 0;
+      }
+      len += res;
+      continue;
+    }
+    if(value[i] == '"' || value[i] == '\\') {
+      if(len + 1 >= outlen) {
+        return 0;
+      }
+      outbuf[len++] = '\\';
+    }
+    if(len + 1 >= outlen) {
+      return 0;
+    }
+    outbuf[len++] = value[i];
+  }
+  if(len + 1 >= outlen) {
+    return 0;
+  }
+  outbuf[len++] = '"';
+  return end_record(ctx, outbuf, outlen, len);
+}
+/*---------------------------------------------------------------------------*/
+/* Opaque values are base64 encoded in SenML-JSON and can not be streamed */
+const lwm2m_writer_t lwm2m_senml_json_writer = {
+  init_write,
+  end_write,
+  enter_sub,
+  exit_sub,
+  write_int,
+  write_string,
+  write_float32fix,
+  write_boolean,
+  NULL
+};
+/*---------------------------------------------------------------------------*/
+static int
+is_label(const struct json_data *json, const char *label)
+{
+  size_t len = strlen(label);
+  return json->name_len == len && memcmp(json->name, label, len) == 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+lwm2m_senml_json_next_record(lwm2m_context_t *ctx,
+                             lwm2m_senml_record_t *record)
+{
+  struct json_data json;
+
+  record->name = NULL;
+  record->name_len = 0;
+  record->value = NULL;
+  record->value_len = 0;
+
+  while(lwm2m_json_next_token(ctx, &json)) {
+    if(is_label(&json, "bn")) {
+      record->base_name = json.value;
+      record->base_name_len = json.value_len;
+    } else if(is_label(&json, "n")) {
+      record->name = json.value;
+      record->name_len = json.value_len;
+    } else if(is_label(&json, "v") || is_label(&json, "vs") ||
+              is_label(&json, "vb")) {
+      record->value = json.value;
+      record->value_len = json.value_len;
+    }
+    /* The token ended with the end of the record */
+    if(ctx->inbuf->buffer[ctx->inbuf->pos - 1] == '}') {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_int(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+         int32_t *value)
+{
+  int size = lwm2m_plain_text_read_int(inbuf, len, value);
+  ctx->last_value_len = size;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_string(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+            uint8_t *value, size_t stringlen)
+{
+  size_t i;
+  size_t pos = 0;
+
+  for(i = 0; i < len; i++) {
+    if(pos + 1 >= stringlen) {
+      /* The outbuffer can not contain the full string including ending zero */
+      return 0;
+    }
+    if(inbuf[i] == '\\' && i + 1 < len) {
+      /* Only the escapes of single characters are supported */
+      i++;
+      switch(inbuf[i]) {
+      case 'n':
+        value[pos++] = '\n';
+        break;
+      case 't':
+        value[pos++] = '\t';
+        break;
+      case 'r':
+        value[pos++] = '\r';
+        break;
+      default:
+        value[pos++] = inbuf[i];
+        break;
+      }
+    } else {
+      value[pos++] = inbuf[i];
+    }
+  }
+  value[pos] = '\0';
+  ctx->last_value_len = pos;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_float32fix(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+                int32_t *value, int bits)
+{
+  int size = lwm2m_plain_text_read_float32fix(inbuf, len, value, bits);
+  ctx->last_value_len = size;
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+static size_t
+read_boolean(lwm2m_context_t *ctx, const uint8_t *inbuf, size_t len,
+             int *value)
+{
+  if(len == 4 && memcmp(inbuf, "true", 4) == 0) {
+    *value = 1;
+  } else if(len == 5 && memcmp(inbuf, "false", 5) == 0) {
+    *value = 0;
+  } else {
+    return 0;
+  }
+  ctx->last_value_len = len;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+const lwm2m_reader_t lwm2m_senml_json_reader = {
+  read_int,
+  read_string,
+  read_float32fix,
+  read_boolean
+};
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \addtogroup lwm2m
+ * @{
+ */
+
+/**
+ * \file
+ *         Definitions shared by the SenML-JSON and SenML-CBOR formats
+ *         (RFC 8428) of the Contiki OMA LWM2M engine
+ */
+
+#ifndef LWM2M_SENML_H_
+#define LWM2M_SENML_H_
+
+#include "lwm2m-object.h"
+
+/* Value of senml_base in the context before the first base name */
+#define LWM2M_SENML_NO_BASE 0xffffffff
+
+/*
+ * One SenML record found by a SenML reader. The pointers refer to the
+ * payload of the request. The base name stays set for the following
+ * records until a record sets a new one.
+ */
+typedef struct {
+  const uint8_t *base_name;
+  const uint8_t *name;
+  /* The encoded value, or NULL when the record has no value */
+  const uint8_t *value;
+  uint16_t base_name_len;
+  uint16_t name_len;
+  uint16_t value_len;
+} lwm2m_senml_record_t;
+
+/*
+ * Finds the next record in the payload in ctx->inbuf, starting at
+ * ctx->inbuf->pos. Returns 0 when there are no more records.
+ */
+typedef int (* lwm2m_senml_next_record_t)(lwm2m_context_t *ctx,
+                                          lwm2m_senml_record_t *record);
+
+#endif /* LWM2M_SENML_H_ */
+/** @} */
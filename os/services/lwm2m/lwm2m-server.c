@@ -267,6 +267,8 @@ lwm2m_server_add(uint16_t instance_id, uint16_t server_id, uint32_t lifetime)
       server_instances[i].server_id = server_id;
       server_instances[i].lifetime = lifetime;
       list_add(server_list, &server_instances[i].instance);
+      /* The registration payload has changed */
+      lwm2m_engine_clear_rd_data();
 
       return &server_instances[i];
     }
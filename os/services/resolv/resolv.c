@@ -65,6 +65,7 @@
 #include "net/ipv6/tcpip.h"
 #include "net/ipv6/uip-udp-packet.h"
 #include "net/ipv6/uip-nameserver.h"
+#include "net/ipv6/ip64-addr.h"
 #include "lib/random.h"
 #include "resolv.h"
 
@@ -124,6 +125,36 @@ int strncasecmp(const char *s1, const char *s2, size_t n);
 #define RESOLV_SUPPORTS_RECORD_EXPIRATION 1
 #endif
 
+/** The time in seconds to cache a negative answer that has no SOA record,
+ *  or a name that no server could resolve. */
+#ifdef RESOLV_CONF_NEGATIVE_TTL
+#define RESOLV_NEGATIVE_TTL RESOLV_CONF_NEGATIVE_TTL
+#else
+#define RESOLV_NEGATIVE_TTL 30
+#endif
+
+/* The upper bound of the negative caching time taken from an SOA record,
+ * as recommended by RFC 2308. */
+#define RESOLV_MAX_NEGATIVE_TTL 10800
+
+/* If RESOLV_CONF_SUPPORTS_A_RECORDS is set, an A question is sent along
+ * with the AAAA question for each DNS name. An IPv4 address is mapped to
+ * IPv6 with ip64_addr_4to6(), and is used only if the AAAA question gives
+ * no address. This is useful behind an IP64 or NAT64 gateway.
+ */
+#ifdef RESOLV_CONF_SUPPORTS_A_RECORDS
+#define RESOLV_SUPPORTS_A_RECORDS RESOLV_CONF_SUPPORTS_A_RECORDS
+#else
+#define RESOLV_SUPPORTS_A_RECORDS 0
+#endif
+
+/* Count the lookups and questions; see resolv_get_stats(). */
+#ifdef RESOLV_CONF_STATS
+#define RESOLV_STATS RESOLV_CONF_STATS
+#else
+#define RESOLV_STATS 0
+#endif
+
 #if RESOLV_CONF_SUPPORTS_MDNS && !RESOLV_VERIFY_ANSWER_NAMES
 #error RESOLV_CONF_SUPPORTS_MDNS cannot be set without RESOLV_CONF_VERIFY_ANSWER_NAMES
 #endif
@@ -144,6 +175,7 @@ int strncasecmp(const char *s1, const char *s2, size_t n);
 
 #define DNS_TYPE_A      1
 #define DNS_TYPE_CNAME  5
+#define DNS_TYPE_SOA    6
 #define DNS_TYPE_PTR   12
 #define DNS_TYPE_MX    15
 #define DNS_TYPE_TXT   16
@@ -210,8 +242,16 @@ struct namemap {
   uint8_t state;
   uint8_t tmr;
   uint16_t id;
+#if RESOLV_SUPPORTS_A_RECORDS
+  uint16_t id_a;
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
+  uint16_t seqno;
   uint8_t retries;
-  uint8_t seqno;
+#define QUERY_AAAA 0x01
+#define QUERY_A    0x02
+#define ANSWER_A   0x04 /* A mapped A answer waits for the AAAA answer */
+  uint8_t pending;
+  uint8_t hash;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
   unsigned long expiration;
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
@@ -232,12 +272,23 @@ struct namemap {
 
 static struct namemap names[RESOLV_ENTRIES];
 
-static uint8_t seqno;
+static uint16_t seqno;
+
+#if RESOLV_STATS
+static struct resolv_stats resolv_stats;
+#define STATS_ADD(field, value) resolv_stats.field += (value)
+#else
+#define STATS_ADD(field, value)
+#endif
 
 static struct uip_udp_conn *resolv_conn = NULL;
 
 static struct etimer retry;
 
+/* Set when the retry timer has expired, so that the timers of the
+ * questions are advanced only once per period. */
+static uint8_t retry_tick;
+
 process_event_t resolv_event_found;
 
 PROCESS(resolv_process, "DNS resolver");
@@ -561,6 +612,144 @@ mdns_prep_host_announce_packet(void)
 }
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
 /*---------------------------------------------------------------------------*/
+/** \internal
+ * Hashes a name, ignoring case. The hash lets the lookups skip the
+ * string comparison of most entries.
+ */
+static uint8_t
+name_hash(const char *name)
+{
+  uint8_t hash = 0;
+
+  while(*name) {
+    hash = (uint8_t)((hash << 3) | (hash >> 5)) ^ tolower((unsigned char)*name++);
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns the entry of a name, or NULL if the name is not in the cache.
+ */
+static struct namemap *
+find_entry(const char *name, uint8_t hash)
+{
+  uint8_t i;
+
+  for(i = 0; i < RESOLV_ENTRIES; ++i) {
+    if(names[i].state != STATE_UNUSED && names[i].hash == hash &&
+       strcasecmp(names[i].name, name) == 0) {
+      return &names[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Marks an entry as the most recently used one.
+ */
+static void
+touch_entry(struct namemap *namemapptr)
+{
+  namemapptr->seqno = seqno++;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Checks whether the answer of a resolved or failed entry may still be
+ * used. Without record expiration, only addresses are kept.
+ */
+static uint8_t
+entry_is_fresh(const struct namemap *namemapptr)
+{
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+  return clock_seconds() <= namemapptr->expiration;
+#else /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  return namemapptr->state == STATE_DONE;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns the time to cache a negative answer. This is the smaller one of
+ * the TTL and the MINIMUM field of the SOA record in the authority section
+ * (RFC 2308), or RESOLV_NEGATIVE_TTL if there is no SOA record.
+ */
+static uint32_t
+negative_ttl(unsigned char *queryptr, uint8_t nanswers, uint8_t nauthrr)
+{
+  const unsigned char *end = (unsigned char *)uip_appdata + uip_datalen();
+  uint32_t ttl, minimum;
+  uint16_t len;
+
+  for(nauthrr += nanswers; nauthrr > 0; --nauthrr) {
+    queryptr = skip_name(queryptr);
+    if(queryptr + 10 > end) {
+      break;
+    }
+    len = (queryptr[8] << 8) | queryptr[9];
+    if(queryptr + 10 + len > end) {
+      break;
+    }
+    if(nanswers > 0) {
+      --nanswers;
+    } else if(queryptr[0] == 0 && queryptr[1] == DNS_TYPE_SOA && len >= 22) {
+      ttl = (uint32_t)queryptr[4] << 24 | (uint32_t)queryptr[5] << 16 |
+        (uint32_t)queryptr[6] << 8 | queryptr[7];
+      queryptr += 10 + len - 4;
+      minimum = (uint32_t)queryptr[0] << 24 | (uint32_t)queryptr[1] << 16 |
+        (uint32_t)queryptr[2] << 8 | queryptr[3];
+      ttl = ttl < minimum ? ttl : minimum;
+      return ttl < RESOLV_MAX_NEGATIVE_TTL ? ttl : RESOLV_MAX_NEGATIVE_TTL;
+    }
+    queryptr += 10 + len;
+  }
+  return RESOLV_NEGATIVE_TTL;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Caches the failure of an entry for the given time and reports it.
+ */
+static void
+entry_failed(struct namemap *namemapptr, uint32_t ttl)
+{
+  /* STATE_ERROR basically means "not found". */
+  namemapptr->state = STATE_ERROR;
+  namemapptr->pending = 0;
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+  namemapptr->expiration = clock_seconds() + ttl;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  STATS_ADD(failures, 1);
+  resolv_found(namemapptr->name, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Completes an entry with the address that it holds.
+ */
+static void
+entry_resolved(struct namemap *namemapptr)
+{
+  namemapptr->state = STATE_DONE;
+  namemapptr->pending = 0;
+  STATS_ADD(answers, 1);
+  resolv_found(namemapptr->name, &namemapptr->ipaddr);
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns the questions to send for an entry.
+ */
+static uint8_t
+entry_questions(const struct namemap *namemapptr)
+{
+#if RESOLV_SUPPORTS_A_RECORDS
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(namemapptr->is_mdns) {
+    return QUERY_AAAA;
+  }
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+  return QUERY_AAAA | QUERY_A;
+#else /* RESOLV_SUPPORTS_A_RECORDS */
+  return QUERY_AAAA;
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
+}
+/*---------------------------------------------------------------------------*/
 static char
 try_next_server(struct namemap *namemapptr)
 {
@@ -577,26 +766,117 @@ try_next_server(struct namemap *namemapptr)
 }
 /*---------------------------------------------------------------------------*/
 /** \internal
- * Runs through the list of names to see if there are any that have
- * not yet been queried and, if so, sends out a query.
+ * Sends one question for an entry.
  */
 static void
-check_entries(void)
+send_question(struct namemap *namemapptr, uint8_t question)
 {
-  volatile uint8_t i;
-
   uint8_t *query;
 
   register struct dns_hdr *hdr;
 
+  uint16_t type = NATIVE_DNS_TYPE;
+
+  hdr = (struct dns_hdr *)uip_appdata;
+  memset(hdr, 0, sizeof(struct dns_hdr));
+  hdr->id = random_rand();
+#if RESOLV_SUPPORTS_A_RECORDS
+  if(question == QUERY_A) {
+    namemapptr->id_a = hdr->id;
+    type = DNS_TYPE_A;
+  } else
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
+  {
+    namemapptr->id = hdr->id;
+  }
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(!namemapptr->is_mdns || namemapptr->is_probe) {
+    hdr->flags1 = DNS_FLAG1_RD;
+  }
+  if(namemapptr->is_mdns) {
+    hdr->id = 0;
+  }
+  if(namemapptr->is_probe) {
+    type = DNS_TYPE_ANY;
+  }
+#else /* RESOLV_CONF_SUPPORTS_MDNS */
+  hdr->flags1 = DNS_FLAG1_RD;
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+  hdr->numquestions = UIP_HTONS(1);
+  query = (unsigned char *)uip_appdata + sizeof(*hdr);
+  query = encode_name(query, namemapptr->name);
+  *query++ = (uint8_t) ((type) >> 8);
+  *query++ = (uint8_t) ((type));
+  *query++ = (uint8_t) ((DNS_CLASS_IN) >> 8);
+  *query++ = (uint8_t) ((DNS_CLASS_IN));
+  STATS_ADD(questions, 1);
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(namemapptr->is_mdns) {
+    if(namemapptr->is_probe) {
+      /* This is our conflict detection request.
+       * In order to be in compliance with the MDNS
+       * spec, we need to add the records we are proposing
+       * to the rrauth section.
+       */
+      uint8_t count = 0;
+
+      query = mdns_write_announce_records(query, &count);
+      hdr->numauthrr = UIP_HTONS(count);
+    }
+    uip_udp_packet_sendto(resolv_conn, uip_appdata,
+                          (query - (uint8_t *) uip_appdata),
+                          &resolv_mdns_addr, UIP_HTONS(MDNS_PORT));
+
+    LOG_DBG("Sent MDNS %s for \"%s\".\n",
+           namemapptr->is_probe?"probe":"request",namemapptr->name);
+  } else {
+    uip_udp_packet_sendto(resolv_conn, uip_appdata,
+                          (query - (uint8_t *) uip_appdata),
+                          (const uip_ipaddr_t *)
+                            uip_nameserver_get(namemapptr->server),
+                          UIP_HTONS(DNS_PORT));
+
+    LOG_DBG("Sent DNS request (type %u) for \"%s\".\n", type,
+           namemapptr->name);
+  }
+#else /* RESOLV_CONF_SUPPORTS_MDNS */
+  uip_udp_packet_sendto(resolv_conn, uip_appdata,
+                        (query - (uint8_t *) uip_appdata),
+                        uip_nameserver_get(namemapptr->server),
+                        UIP_HTONS(DNS_PORT));
+  LOG_DBG("Sent DNS request (type %u) for \"%s\".\n", type,
+         namemapptr->name);
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Runs through the list of names to see if there are any that have
+ * not yet been queried or whose questions have timed out, and sends
+ * out their questions. The questions of all such names are sent at
+ * once, so that simultaneous lookups do not wait for each other.
+ */
+static void
+check_entries(void)
+{
+  uint8_t i;
+
   register struct namemap *namemapptr;
 
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     namemapptr = &names[i];
     if(namemapptr->state == STATE_NEW || namemapptr->state == STATE_ASKING) {
-      etimer_set(&retry, CLOCK_SECOND / 4);
+      if(retry_tick || etimer_expired(&retry)) {
+        etimer_set(&retry, CLOCK_SECOND / 4);
+      }
       if(namemapptr->state == STATE_ASKING) {
-        if(--namemapptr->tmr == 0) {
+        if(retry_tick && --namemapptr->tmr == 0) {
+#if RESOLV_SUPPORTS_A_RECORDS
+          if(namemapptr->pending & ANSWER_A) {
+            /* The AAAA answer is late, so use the A answer */
+            entry_resolved(namemapptr);
+            continue;
+          }
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
 #if RESOLV_CONF_SUPPORTS_MDNS
           if(++namemapptr->retries ==
              (namemapptr->is_mdns ? RESOLV_CONF_MAX_MDNS_RETRIES :
@@ -608,19 +888,15 @@ check_entries(void)
             /* Try the next server (if possible) before failing. Otherwise
                simply mark the entry as failed. */
             if(try_next_server(namemapptr) == 0) {
-              /* STATE_ERROR basically means "not found". */
-              namemapptr->state = STATE_ERROR;
-
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-              /* Keep the "not found" error valid for 30 seconds */
-              namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-
-              resolv_found(namemapptr->name, NULL);
+              entry_failed(namemapptr, RESOLV_NEGATIVE_TTL);
               continue;
             }
+            namemapptr->pending = entry_questions(namemapptr);
           }
-          namemapptr->tmr = namemapptr->retries * namemapptr->retries * 3;
+          /* The first question to the next server is retried as soon
+             as the first question to the previous one. */
+          namemapptr->tmr = namemapptr->retries > 0 ?
+            namemapptr->retries * namemapptr->retries * 3 : 1;
 
 #if RESOLV_CONF_SUPPORTS_MDNS
           if(namemapptr->is_probe) {
@@ -638,76 +914,19 @@ check_entries(void)
         namemapptr->state = STATE_ASKING;
         namemapptr->tmr = 1;
         namemapptr->retries = 0;
+        namemapptr->pending = entry_questions(namemapptr);
       }
-      hdr = (struct dns_hdr *)uip_appdata;
-      memset(hdr, 0, sizeof(struct dns_hdr));
-      hdr->id = random_rand();
-      namemapptr->id = hdr->id;
-#if RESOLV_CONF_SUPPORTS_MDNS
-      if(!namemapptr->is_mdns || namemapptr->is_probe) {
-        hdr->flags1 = DNS_FLAG1_RD;
-      }
-      if(namemapptr->is_mdns) {
-        hdr->id = 0;
-      }
-#else /* RESOLV_CONF_SUPPORTS_MDNS */
-      hdr->flags1 = DNS_FLAG1_RD;
-#endif /* RESOLV_CONF_SUPPORTS_MDNS */
-      hdr->numquestions = UIP_HTONS(1);
-      query = (unsigned char *)uip_appdata + sizeof(*hdr);
-      query = encode_name(query, namemapptr->name);
-#if RESOLV_CONF_SUPPORTS_MDNS
-      if(namemapptr->is_probe) {
-        *query++ = (uint8_t) ((DNS_TYPE_ANY) >> 8);
-        *query++ = (uint8_t) ((DNS_TYPE_ANY));
-      } else
-#endif /* RESOLV_CONF_SUPPORTS_MDNS */
-      {
-        *query++ = (uint8_t) ((NATIVE_DNS_TYPE) >> 8);
-        *query++ = (uint8_t) ((NATIVE_DNS_TYPE));
+      if(namemapptr->pending & QUERY_AAAA) {
+        send_question(namemapptr, QUERY_AAAA);
       }
-      *query++ = (uint8_t) ((DNS_CLASS_IN) >> 8);
-      *query++ = (uint8_t) ((DNS_CLASS_IN));
-#if RESOLV_CONF_SUPPORTS_MDNS
-      if(namemapptr->is_mdns) {
-        if(namemapptr->is_probe) {
-          /* This is our conflict detection request.
-           * In order to be in compliance with the MDNS
-           * spec, we need to add the records we are proposing
-           * to the rrauth section.
-           */
-          uint8_t count = 0;
-
-          query = mdns_write_announce_records(query, &count);
-          hdr->numauthrr = UIP_HTONS(count);
-        }
-        uip_udp_packet_sendto(resolv_conn, uip_appdata,
-                              (query - (uint8_t *) uip_appdata),
-                              &resolv_mdns_addr, UIP_HTONS(MDNS_PORT));
-
-        LOG_DBG("(i=%d) Sent MDNS %s for \"%s\".\n", i,
-               namemapptr->is_probe?"probe":"request",namemapptr->name);
-      } else {
-        uip_udp_packet_sendto(resolv_conn, uip_appdata,
-                              (query - (uint8_t *) uip_appdata),
-                              (const uip_ipaddr_t *)
-                                uip_nameserver_get(namemapptr->server),
-                              UIP_HTONS(DNS_PORT));
-
-        LOG_DBG("(i=%d) Sent DNS request for \"%s\".\n", i,
-               namemapptr->name);
+#if RESOLV_SUPPORTS_A_RECORDS
+      if(namemapptr->pending & QUERY_A) {
+        send_question(namemapptr, QUERY_A);
       }
-#else /* RESOLV_CONF_SUPPORTS_MDNS */
-      uip_udp_packet_sendto(resolv_conn, uip_appdata,
-                            (query - (uint8_t *) uip_appdata),
-                            uip_nameserver_get(namemapptr->server),
-                            UIP_HTONS(DNS_PORT));
-      LOG_DBG("(i=%d) Sent DNS request for \"%s\".\n", i,
-             namemapptr->name);
-#endif /* RESOLV_CONF_SUPPORTS_MDNS */
-      break;
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
     }
   }
+  retry_tick = 0;
 }
 /*---------------------------------------------------------------------------*/
 /** \internal
@@ -720,6 +939,8 @@ newdata(void)
 
   int8_t i;
 
+  uint8_t question = 0;
+
   register struct namemap *namemapptr = NULL;
 
   struct dns_answer *ans;
@@ -827,11 +1048,6 @@ newdata(void)
 
 /** ANSWER HANDLING SECTION **************************************************/
 
-  if(nanswers == 0) {
-    /* Skip responses with no answers. */
-    return;
-  }
-
 #if RESOLV_CONF_SUPPORTS_MDNS
   if(UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT) &&
      hdr->id == 0) {
@@ -839,6 +1055,11 @@ newdata(void)
      * because we can't use the `id` field. We will look up the
      * appropriate request in a later step. */
 
+    if(nanswers == 0) {
+      /* Skip responses with no answers. */
+      return;
+    }
+
     i = -1;
     namemapptr = NULL;
   } else
@@ -846,33 +1067,37 @@ newdata(void)
   {
     for(i = 0; i < RESOLV_ENTRIES; ++i) {
       namemapptr = &names[i];
-      if(namemapptr->state == STATE_ASKING &&
-         namemapptr->id == hdr->id) {
+      if(namemapptr->state != STATE_ASKING) {
+        continue;
+      }
+      if((namemapptr->pending & QUERY_AAAA) && namemapptr->id == hdr->id) {
+        question = QUERY_AAAA;
+        break;
+      }
+#if RESOLV_SUPPORTS_A_RECORDS
+      if((namemapptr->pending & QUERY_A) && namemapptr->id_a == hdr->id) {
+        question = QUERY_A;
         break;
       }
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
     }
 
-    if(i >= RESOLV_ENTRIES || i < 0 || namemapptr->state != STATE_ASKING) {
+    if(i >= RESOLV_ENTRIES || i < 0) {
       LOG_DBG("DNS response has bad ID (%04X) \n", uip_ntohs(hdr->id));
       return;
     }
 
     LOG_DBG("Incoming response for \"%s\".\n", namemapptr->name);
 
-    /* We'll change this to DONE when we find the record. */
-    namemapptr->state = STATE_ERROR;
-
     namemapptr->err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
 
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    /* If we remain in the error state, keep it cached for 30 seconds. */
-    namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-
-    /* Check for error. If so, call callback to inform. */
+    /* Check for error. If so, call callback to inform. The SOA record
+       of a "name error" tells how long the name is known not to exist. */
     if(namemapptr->err != 0) {
-      namemapptr->state = STATE_ERROR;
-      resolv_found(namemapptr->name, NULL);
+      entry_failed(namemapptr, namemapptr->err == DNS_FLAG2_ERR_NAME ?
+                   negative_ttl(queryptr, nanswers,
+                                (uint8_t)uip_ntohs(hdr->numauthrr)) :
+                   RESOLV_NEGATIVE_TTL);
       return;
     }
   }
@@ -904,12 +1129,20 @@ newdata(void)
     /* Check the class and length of the answer to make sure
      * it matches what we are expecting
      */
-    if(((uip_ntohs(ans->class) & 0x7FFF) != DNS_CLASS_IN) ||
-       (ans->len != UIP_HTONS(sizeof(uip_ipaddr_t)))) {
+    if((uip_ntohs(ans->class) & 0x7FFF) != DNS_CLASS_IN) {
       goto skip_to_next_answer;
     }
 
-    if(ans->type != UIP_HTONS(NATIVE_DNS_TYPE)) {
+#if RESOLV_SUPPORTS_A_RECORDS
+    if(question == QUERY_A) {
+      if(ans->type != UIP_HTONS(DNS_TYPE_A) ||
+         ans->len != UIP_HTONS(sizeof(uip_ip4addr_t))) {
+        goto skip_to_next_answer;
+      }
+    } else
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
+    if(ans->type != UIP_HTONS(NATIVE_DNS_TYPE) ||
+       ans->len != UIP_HTONS(sizeof(uip_ipaddr_t))) {
       goto skip_to_next_answer;
     }
 
@@ -945,6 +1178,8 @@ newdata(void)
           namemapptr = NULL;
           goto skip_to_next_answer;
         }
+        namemapptr->hash = name_hash(namemapptr->name);
+        touch_entry(namemapptr);
       }
       if(i == RESOLV_ENTRIES) {
         LOG_DBG
@@ -977,7 +1212,6 @@ newdata(void)
 
     LOG_DBG("Answer for \"%s\" is usable.\n", namemapptr->name);
 
-    namemapptr->state = STATE_DONE;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
     namemapptr->expiration = (uint32_t) uip_ntohs(ans->ttl[0]) << 16 |
         (uint32_t) uip_ntohs(ans->ttl[1]);
@@ -986,9 +1220,21 @@ newdata(void)
     namemapptr->expiration += clock_seconds();
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
 
-    uip_ipaddr_copy(&namemapptr->ipaddr, (uip_ipaddr_t *) ans->ipaddr);
+#if RESOLV_SUPPORTS_A_RECORDS
+    if(question == QUERY_A) {
+      ip64_addr_4to6((uip_ip4addr_t *)ans->ipaddr, &namemapptr->ipaddr);
+      namemapptr->pending = (namemapptr->pending & ~QUERY_A) | ANSWER_A;
+      if(namemapptr->pending & QUERY_AAAA) {
+        /* Keep the IPv4 address until the AAAA answer arrives */
+        return;
+      }
+    } else
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
+    {
+      uip_ipaddr_copy(&namemapptr->ipaddr, (uip_ipaddr_t *) ans->ipaddr);
+    }
 
-    resolv_found(namemapptr->name, &namemapptr->ipaddr);
+    entry_resolved(namemapptr);
     break;
 
   skip_to_next_answer:
@@ -1005,9 +1251,24 @@ newdata(void)
   if(nanswers == 0)
 #endif
   {
+    namemapptr->pending &= ~question;
+    if(namemapptr->pending & (QUERY_AAAA | QUERY_A)) {
+      /* The answer to the other question is still to come */
+      return;
+    }
+#if RESOLV_SUPPORTS_A_RECORDS
+    if(namemapptr->pending & ANSWER_A) {
+      entry_resolved(namemapptr);
+      return;
+    }
+#endif /* RESOLV_SUPPORTS_A_RECORDS */
     if(try_next_server(namemapptr)) {
-      namemapptr->state = STATE_ASKING;
+      namemapptr->state = STATE_NEW;
       process_post(&resolv_process, PROCESS_EVENT_TIMER, NULL);
+    } else {
+      /* No record of the name: cache the negative answer */
+      entry_failed(namemapptr, negative_ttl(queryptr, 0,
+                                            (uint8_t)uip_ntohs(hdr->numauthrr)));
     }
   }
 
@@ -1114,6 +1375,9 @@ PROCESS_THREAD(resolv_process, ev, data)
     PROCESS_WAIT_EVENT();
 
     if(ev == PROCESS_EVENT_TIMER) {
+      if(data == &retry) {
+        retry_tick = 1;
+      }
       tcpip_poll_udp(resolv_conn);
     } else if(ev == tcpip_event) {
       if(uip_udp_conn == resolv_conn) {
@@ -1192,6 +1456,10 @@ remove_trailing_dots(const char *name) {
 /**
  * Queues a name so that a question for the name will be sent out.
  *
+ * A name that is being resolved is not asked again, and a name with a
+ * fresh answer in the cache is reported at once with resolv_event_found.
+ * Names in the local TLD are always asked again.
+ *
  * \param name The hostname that is to be queried.
  */
 void
@@ -1199,38 +1467,66 @@ resolv_query(const char *name)
 {
   uint8_t i;
 
-  uint8_t lseq, lseqi;
+  uint16_t age, oldest;
 
-  register struct namemap *nameptr = 0;
+  uint8_t hash;
 
-  init();
+  register struct namemap *nameptr;
 
-  lseq = lseqi = 0;
+  init();
 
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
+  hash = name_hash(name);
 
-  for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    nameptr = &names[i];
-    if(0 == strcasecmp(nameptr->name, name)) {
-      break;
-    }
-    if((nameptr->state == STATE_UNUSED)
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-      || (nameptr->state == STATE_DONE && clock_seconds() > nameptr->expiration)
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  STATS_ADD(queries, 1);
+
+  nameptr = find_entry(name, hash);
+  if(nameptr != NULL
+#if RESOLV_CONF_SUPPORTS_MDNS
+     && !nameptr->is_mdns
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
     ) {
-      lseqi = i;
-      lseq = 255;
-    } else if(seqno - nameptr->seqno > lseq) {
-      lseq = seqno - nameptr->seqno;
-      lseqi = i;
+    touch_entry(nameptr);
+    if(nameptr->state == STATE_NEW || nameptr->state == STATE_ASKING) {
+      /* The answer will be reported to everyone waiting for it. */
+      STATS_ADD(joined, 1);
+      return;
+    }
+    if(entry_is_fresh(nameptr)) {
+      if(nameptr->state == STATE_DONE) {
+        STATS_ADD(cache_hits, 1);
+      } else {
+        STATS_ADD(negative_hits, 1);
+      }
+      process_post(PROCESS_BROADCAST, resolv_event_found, nameptr->name);
+      return;
     }
   }
 
-  if(i == RESOLV_ENTRIES) {
-    i = lseqi;
-    nameptr = &names[i];
+  if(nameptr == NULL) {
+    /* Take an unused entry, or else the entry with an expired answer or
+     * the least recently used entry. Names that are being resolved are
+     * only taken if all entries are being resolved. */
+    oldest = 0;
+    for(i = 0; i < RESOLV_ENTRIES; ++i) {
+      if(names[i].state == STATE_UNUSED) {
+        nameptr = &names[i];
+        break;
+      }
+      age = (uint16_t)(seqno - names[i].seqno) >> 1;
+      if(names[i].state == STATE_DONE || names[i].state == STATE_ERROR) {
+        age = entry_is_fresh(&names[i]) ? age | 0x8000 : 0xffff;
+      }
+      if(nameptr == NULL || age > oldest) {
+        oldest = age;
+        nameptr = &names[i];
+      }
+    }
+    if(nameptr->state != STATE_UNUSED) {
+      LOG_DBG("Evicting \"%s\".\n", nameptr->name);
+      STATS_ADD(evictions, 1);
+    }
   }
 
   LOG_DBG("Starting query for \"%s\".\n", name);
@@ -1238,9 +1534,9 @@ resolv_query(const char *name)
   memset(nameptr, 0, sizeof(*nameptr));
 
   strncpy(nameptr->name, name, sizeof(nameptr->name) - 1);
+  nameptr->hash = name_hash(nameptr->name);
   nameptr->state = STATE_NEW;
-  nameptr->seqno = seqno;
-  ++seqno;
+  touch_entry(nameptr);
 
 #if RESOLV_CONF_SUPPORTS_MDNS
   {
@@ -1278,8 +1574,6 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
 {
   resolv_status_t ret = RESOLV_STATUS_UNCACHED;
 
-  uint8_t i;
-
   struct namemap *nameptr;
 
   /* Remove trailing dots, if present. */
@@ -1297,44 +1591,47 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
   }
 #endif /* UIP_CONF_LOOPBACK_INTERFACE */
 
-  /* Walk through the list to see if the name is in there. */
-  for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    nameptr = &names[i];
-
-    if(strcasecmp(name, nameptr->name) == 0) {
-      switch (nameptr->state) {
-      case STATE_DONE:
-        ret = RESOLV_STATUS_CACHED;
+  nameptr = find_entry(name, name_hash(name));
+  if(nameptr != NULL) {
+    switch (nameptr->state) {
+    case STATE_DONE:
+      ret = RESOLV_STATUS_CACHED;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
-          ret = RESOLV_STATUS_EXPIRED;
-        }
+      if(clock_seconds() > nameptr->expiration) {
+        ret = RESOLV_STATUS_EXPIRED;
+      }
 #endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
-      case STATE_NEW:
-      case STATE_ASKING:
-        ret = RESOLV_STATUS_RESOLVING;
-        break;
-      /* Almost certainly a not-found error from server */
-      case STATE_ERROR:
-        ret = RESOLV_STATUS_NOT_FOUND;
+      break;
+    case STATE_NEW:
+    case STATE_ASKING:
+      ret = RESOLV_STATUS_RESOLVING;
+      break;
+    /* Almost certainly a not-found error from server */
+    case STATE_ERROR:
+      ret = RESOLV_STATUS_NOT_FOUND;
 #if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
-          ret = RESOLV_STATUS_UNCACHED;
-        }
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
+      if(clock_seconds() > nameptr->expiration) {
+        ret = RESOLV_STATUS_UNCACHED;
       }
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+      break;
+    }
 
-      if(ipaddr) {
-        *ipaddr = &nameptr->ipaddr;
-      }
+    if(ret == RESOLV_STATUS_CACHED || ret == RESOLV_STATUS_NOT_FOUND) {
+      touch_entry(nameptr);
+    }
 
-      /* Break out of for loop. */
-      break;
+    if(ipaddr) {
+      *ipaddr = &nameptr->ipaddr;
     }
   }
 
+  if(ret == RESOLV_STATUS_CACHED) {
+    STATS_ADD(lookup_hits, 1);
+  } else if(ret != RESOLV_STATUS_RESOLVING) {
+    STATS_ADD(lookup_misses, 1);
+  }
+
 #if LOG_LEVEL == LOG_LEVEL_DBG
   switch (ret) {
   case RESOLV_STATUS_CACHED:
@@ -1415,6 +1712,24 @@ resolv_found(char *name, uip_ipaddr_t * ipaddr)
   process_post(PROCESS_BROADCAST, resolv_event_found, name);
 }
 /*---------------------------------------------------------------------------*/
+void
+resolv_get_stats(struct resolv_stats *stats)
+{
+#if RESOLV_STATS
+  memcpy(stats, &resolv_stats, sizeof(*stats));
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+}
+/*---------------------------------------------------------------------------*/
+void
+resolv_reset_stats(void)
+{
+#if RESOLV_STATS
+  memset(&resolv_stats, 0, sizeof(resolv_stats));
+#endif
+}
+/*---------------------------------------------------------------------------*/
 #endif /* UIP_UDP */
 
 /** @} */
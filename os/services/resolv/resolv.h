@@ -90,11 +90,44 @@ enum {
 
 typedef uint8_t resolv_status_t;
 
+/**
+ * \brief Cache statistics of the resolver.
+ *
+ * The counters are maintained only if the resolver is built with
+ * RESOLV_CONF_STATS set to 1.
+ */
+struct resolv_stats {
+  uint32_t lookup_hits;   /**< Lookups that found a fresh address. */
+  uint32_t lookup_misses; /**< Lookups that found no usable address. */
+  uint32_t queries;       /**< Calls of resolv_query(). */
+  uint32_t cache_hits;    /**< Queries answered with a cached address. */
+  uint32_t negative_hits; /**< Queries answered with a cached failure. */
+  uint32_t joined;        /**< Queries of a name that was being resolved. */
+  uint32_t evictions;     /**< Cached names replaced by a new name. */
+  uint32_t questions;     /**< DNS and mDNS questions sent. */
+  uint32_t answers;       /**< Names resolved by a received answer. */
+  uint32_t failures;      /**< Names that could not be resolved. */
+};
+
 /* Functions. */
 resolv_status_t resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr);
 
 void resolv_query(const char *name);
 
+/**
+ * \brief Get the cache statistics of the resolver.
+ * \param stats A pointer to a structure that receives the statistics.
+ *
+ * All counters are zero if the resolver has been built without
+ * RESOLV_CONF_STATS.
+ */
+void resolv_get_stats(struct resolv_stats *stats);
+
+/**
+ * \brief Reset the cache statistics of the resolver.
+ */
+void resolv_reset_stats(void);
+
 #if RESOLV_CONF_SUPPORTS_MDNS
 void resolv_set_hostname(const char *hostname);
 
@@ -151,7 +151,11 @@ send_packet(mac_callback_t sent, void *ptr)
       /* Copy packet data */
       memcpy(&buf[3 + size], packetbuf_hdrptr(), packetbuf_totlen());
 
-      write_to_slip(buf, packetbuf_totlen() + size + 3);
+      if(write_to_slip(buf, packetbuf_totlen() + size + 3) < 0) {
+        /* The SLIP output queue is full */
+        LOG_WARN("send failed, SLIP queue full\n");
+        mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
+      }
     }
   }
 }
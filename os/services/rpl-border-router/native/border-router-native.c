@@ -55,9 +55,6 @@
 
 #include <stdlib.h>
 
-extern long slip_sent;
-extern long slip_received;
-
 static uint8_t mac_set;
 
 extern int contiki_argc;
@@ -94,8 +91,15 @@ border_router_set_mac(const uint8_t *data)
 void
 border_router_print_stat()
 {
-  printf("bytes received over SLIP: %ld\n", slip_received);
-  printf("bytes sent over SLIP: %ld\n", slip_sent);
+  struct slip_stats stats;
+
+  slip_get_stats(&stats);
+  printf("bytes received over SLIP: %lu\n", stats.bytes_received);
+  printf("bytes sent over SLIP: %lu\n", stats.bytes_sent);
+  printf("frames received over SLIP: %lu, dropped %lu\n",
+         stats.frames_received, stats.input_errors);
+  printf("frames sent over SLIP: %lu, dropped %lu\n",
+         stats.frames_sent, stats.frames_dropped);
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(border_router_process, ev, data)
@@ -41,9 +41,29 @@
 #include "net/ipv6/uip.h"
 #include <stdio.h>
 
+/* Statistics of the SLIP connection to the radio */
+struct slip_stats {
+  unsigned long bytes_sent;
+  unsigned long bytes_received;
+  unsigned long frames_sent;
+  unsigned long frames_received;
+  /* Frames not sent because the output queue was full */
+  unsigned long frames_dropped;
+  /* Received frames dropped because they were too large */
+  unsigned long input_errors;
+};
+
 int border_router_cmd_handler(const uint8_t *data, int len);
 int slip_config_handle_arguments(int argc, char **argv);
-void write_to_slip(const uint8_t *buf, int len);
+
+/**
+ * Queues a frame to the radio.
+ *
+ * \return 0, or -1 if the output queue has no room for the frame
+ */
+int write_to_slip(const uint8_t *buf, int len);
+int slip_empty(void);
+void slip_get_stats(struct slip_stats *stats);
 
 void border_router_set_prefix_64(const uip_ipaddr_t *prefix_64);
 void border_router_set_mac(const uint8_t *data);
@@ -52,8 +72,6 @@ void border_router_print_stat(void);
 
 void tun_init(void);
 
-int slip_init(void);
-int slip_set_fd(int maxfd, fd_set *rset, fd_set *wset);
-void slip_handle_fd(fd_set *rset, fd_set *wset);
+void slip_init(void);
 
 #endif /* BORDER_ROUTER_H_ */
@@ -33,7 +33,9 @@
 /* use a non-default MAC driver */
 #define NETSTACK_CONF_MAC border_router_mac_driver
 
+#ifndef SLIP_DEV_CONF_SEND_DELAY
 #define SLIP_DEV_CONF_SEND_DELAY (CLOCK_SECOND / 32)
+#endif
 
 #define SERIALIZE_ATTRIBUTES 1
 
@@ -54,6 +54,7 @@
 #include "net/netstack.h"
 #include "net/packetbuf.h"
 #include "cmd.h"
+#include "border-router.h"
 #include "border-router-cmds.h"
 
 extern int slip_config_verbose;
@@ -70,13 +71,19 @@ extern speed_t slip_config_b_rate;
 #define SEND_DELAY 0
 #endif
 
-int devopen(const char *dev, int flags);
+/* The size of the queue of encoded frames to the radio */
+#ifdef SLIP_DEV_CONF_OUTPUT_SIZE
+#define OUTPUT_SIZE SLIP_DEV_CONF_OUTPUT_SIZE
+#else
+#define OUTPUT_SIZE 4096
+#endif
 
-static FILE *inslip;
+/* The largest decoded frame from the radio */
+#define INPUT_SIZE 2048
 
-/* for statistics */
-long slip_sent = 0;
-long slip_received = 0;
+int devopen(const char *dev, int flags);
+
+static struct slip_stats stats;
 
 int slipfd = 0;
 
@@ -87,6 +94,16 @@ int slipfd = 0;
 #define SLIP_ESC_END 0334
 #define SLIP_ESC_ESC 0335
 
+/*
+ * The escape code of each byte in a SLIP frame, or zero for the bytes that
+ * are sent as they are. The encoder and the decoder copy the runs of
+ * plain bytes in bulk.
+ */
+static const uint8_t escape_table[256] = {
+  [SLIP_END] = SLIP_ESC_END,
+  [SLIP_ESC] = SLIP_ESC_ESC,
+};
+
 /*---------------------------------------------------------------------------*/
 static void *
 get_in_addr(struct sockaddr *sa)
@@ -168,164 +185,184 @@ slip_packet_input(unsigned char *data, int len)
   NETSTACK_MAC.input();
 }
 /*---------------------------------------------------------------------------*/
+static void
+slip_frame_input(unsigned char *inbuf, int inbufptr)
+{
+  int i;
+
+  stats.frames_received++;
+  if(inbuf[0] == '!') {
+    command_context = CMD_CONTEXT_RADIO;
+    cmd_input(inbuf, inbufptr);
+  } else if(inbuf[0] == '?') {
+#define DEBUG_LINE_MARKER '\r'
+  } else if(inbuf[0] == DEBUG_LINE_MARKER) {
+    fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
+  } else if(is_sensible_string(inbuf, inbufptr)) {
+    if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
+      fwrite(inbuf, inbufptr, 1, stdout);
+    }
+  } else {
+    if(slip_config_verbose > 2) {
+      printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
+      if(slip_config_verbose > 4) {
+#if WIRESHARK_IMPORT_FORMAT
+        printf("0000");
+        for(i = 0; i < inbufptr; i++) {
+          printf(" %02x", inbuf[i]);
+        }
+#else
+        printf("         ");
+        for(i = 0; i < inbufptr; i++) {
+          printf("%02x", inbuf[i]);
+          if((i & 3) == 3) {
+            printf(" ");
+          }
+          if((i & 15) == 15) {
+            printf("\n         ");
+          }
+        }
+#endif
+        printf("\n");
+      }
+    }
+    slip_packet_input(inbuf, inbufptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
 /*
  * Read from serial, when we have a packet call slip_packet_input. No output
- * buffering, input buffered by stdio.
+ * buffering. The input is read in chunks, and the runs of plain bytes are
+ * copied to the frame at once.
  */
-void
-serial_input(FILE *inslip)
+static void
+serial_input(void)
 {
-  static unsigned char inbuf[2048];
+  static unsigned char rxbuf[INPUT_SIZE];
+  static unsigned char inbuf[INPUT_SIZE];
   static int inbufptr = 0;
-  int ret, i;
+  /* An escape at the end of the previous chunk */
+  static uint8_t escaped;
+  /* The frame is too large and is dropped at its end */
+  static uint8_t overflow;
+  const unsigned char *p, *end, *run;
   unsigned char c;
+  int len, i;
 
-#ifdef linux
-  ret = fread(&c, 1, 1, inslip);
-  if(ret == -1 || ret == 0) {
-    err(1, "serial_input: read");
-  }
-  goto after_fread;
-#endif
-
-read_more:
-  if(inbufptr >= sizeof(inbuf)) {
-    fprintf(stderr, "*** dropping large %d byte packet\n", inbufptr);
-    inbufptr = 0;
+  len = read(slipfd, rxbuf, sizeof(rxbuf));
+  if(len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+    return;
   }
-  ret = fread(&c, 1, 1, inslip);
-#ifdef linux
-after_fread:
-#endif
-  if(ret == -1) {
+  if(len <= 0) {
     err(1, "serial_input: read");
   }
-  if(ret == 0) {
-    clearerr(inslip);
-    return;
-  }
-  slip_received++;
-  switch(c) {
-  case SLIP_END:
-    if(inbufptr > 0) {
-      if(inbuf[0] == '!') {
-        command_context = CMD_CONTEXT_RADIO;
-        cmd_input(inbuf, inbufptr);
-      } else if(inbuf[0] == '?') {
-#define DEBUG_LINE_MARKER '\r'
-      } else if(inbuf[0] == DEBUG_LINE_MARKER) {
-        fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(inbuf, inbufptr)) {
-        if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
-          fwrite(inbuf, inbufptr, 1, stdout);
+  stats.bytes_received += len;
+
+  p = rxbuf;
+  end = rxbuf + len;
+  while(p < end) {
+    if(escaped) {
+      c = *p++;
+      escaped = 0;
+      if(c == SLIP_ESC_END) {
+        c = SLIP_END;
+      } else if(c == SLIP_ESC_ESC) {
+        c = SLIP_ESC;
+      }
+      run = &c;
+      len = 1;
+    } else {
+      /* The run of bytes up to the next END or ESC */
+      run = p;
+      while(p < end && escape_table[*p] == 0) {
+        p++;
+      }
+      len = p - run;
+      if(len == 0) {
+        c = *p++;
+        if(c == SLIP_ESC) {
+          escaped = 1;
+          continue;
         }
-      } else {
-        if(slip_config_verbose > 2) {
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
-          if(slip_config_verbose > 4) {
-#if WIRESHARK_IMPORT_FORMAT
-            printf("0000");
-            for(i = 0; i < inbufptr; i++) {
-              printf(" %02x", inbuf[i]);
-            }
-#else
-            printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", inbuf[i]);
-              if((i & 3) == 3) {
-                printf(" ");
-              }
-              if((i & 15) == 15) {
-                printf("\n         ");
-              }
-            }
-#endif
-            printf("\n");
-          }
+        /* SLIP_END */
+        if(overflow) {
+          fprintf(stderr, "*** dropping large packet\n");
+          stats.input_errors++;
+          overflow = 0;
+        } else if(inbufptr > 0) {
+          slip_frame_input(inbuf, inbufptr);
         }
-        slip_packet_input(inbuf, inbufptr);
+        inbufptr = 0;
+        continue;
       }
-      inbufptr = 0;
     }
-    break;
 
-  case SLIP_ESC:
-    if(fread(&c, 1, 1, inslip) != 1) {
-      clearerr(inslip);
-      /* Put ESC back and give up! */
-      ungetc(SLIP_ESC, inslip);
-      return;
+    if(overflow || inbufptr + len > sizeof(inbuf)) {
+      overflow = 1;
+      continue;
     }
 
-    switch(c) {
-    case SLIP_ESC_END:
-      c = SLIP_END;
-      break;
-    case SLIP_ESC_ESC:
-      c = SLIP_ESC;
-      break;
+    if(slip_config_verbose < 2) {
+      memcpy(&inbuf[inbufptr], run, len);
+      inbufptr += len;
+      continue;
     }
-    /* FALLTHROUGH */
-  default:
-    inbuf[inbufptr++] = c;
-
-    /* Echo lines as they are received for verbose=2,3,5+ */
-    /* Echo all printable characters for verbose==4 */
-    if(slip_config_verbose == 4) {
-      if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
-        fwrite(&c, 1, 1, stdout);
-      }
-    } else if(slip_config_verbose >= 2) {
-      if(c == '\n' && is_sensible_string(inbuf, inbufptr)) {
-        fwrite(inbuf, inbufptr, 1, stdout);
-        inbufptr = 0;
+
+    for(i = 0; i < len; i++) {
+      c = run[i];
+      inbuf[inbufptr++] = c;
+
+      /* Echo lines as they are received for verbose=2,3,5+ */
+      /* Echo all printable characters for verbose==4 */
+      if(slip_config_verbose == 4) {
+        if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
+          fwrite(&c, 1, 1, stdout);
+        }
+      } else if(slip_config_verbose >= 2) {
+        if(c == '\n' && is_sensible_string(inbuf, inbufptr)) {
+          fwrite(inbuf, inbufptr, 1, stdout);
+          inbufptr = 0;
+        }
       }
     }
-    break;
   }
-
-  goto read_more;
 }
-unsigned char slip_buf[2048];
-int slip_end, slip_begin, slip_packet_end, slip_packet_count;
+/*
+ * The encoded frames waiting to be written to the radio. The queue holds
+ * complete frames only, between slip_begin and slip_end.
+ */
+static unsigned char slip_buf[OUTPUT_SIZE];
+static int slip_end, slip_begin;
 static struct timer send_delay_timer;
 /* delay between slip packets */
 static clock_time_t send_delay = SEND_DELAY;
 /*---------------------------------------------------------------------------*/
-static void
-slip_send(int fd, unsigned char c)
-{
-  if(slip_end >= sizeof(slip_buf)) {
-    err(1, "slip_send overflow");
-  }
-  slip_buf[slip_end] = c;
-  slip_end++;
-  slip_sent++;
-  if(c == SLIP_END) {
-    /* Full packet received. */
-    slip_packet_count++;
-    if(slip_packet_end == 0) {
-      slip_packet_end = slip_end;
-    }
-  }
-}
-/*---------------------------------------------------------------------------*/
 int
 slip_empty()
 {
-  return slip_packet_end == 0;
+  return slip_begin == slip_end;
 }
 /*---------------------------------------------------------------------------*/
 void
 slip_flushbuf(int fd)
 {
-  int n;
+  unsigned char *frame_end;
+  int n, len;
 
   if(slip_empty()) {
     return;
   }
 
-  n = write(fd, slip_buf + slip_begin, slip_packet_end - slip_begin);
+  len = slip_end - slip_begin;
+  if(send_delay > 0) {
+    /* One frame at a time, with a delay between the frames */
+    frame_end = memchr(slip_buf + slip_begin, SLIP_END, len);
+    if(frame_end != NULL) {
+      len = frame_end + 1 - (slip_buf + slip_begin);
+    }
+  }
+
+  n = write(fd, slip_buf + slip_begin, len);
 
   if(n == -1 && errno != EAGAIN) {
     err(1, "slip_flushbuf write failed");
@@ -333,36 +370,27 @@ slip_flushbuf(int fd)
     PROGRESS("Q");		/* Outqueue is full! */
   } else {
     slip_begin += n;
-    if(slip_begin == slip_packet_end) {
-      slip_packet_count--;
-      if(slip_end > slip_packet_end) {
-        memmove(slip_buf, slip_buf + slip_packet_end,
-               slip_end - slip_packet_end);
-      }
-      slip_end -= slip_packet_end;
-      slip_begin = slip_packet_end = 0;
-      if(slip_end > 0) {
-        /* Find end of next slip packet */
-        for(n = 1; n < slip_end; n++) {
-          if(slip_buf[n] == SLIP_END) {
-            slip_packet_end = n + 1;
-            break;
-          }
-        }
-        /* a delay between slip packets to avoid losing data */
-        if(send_delay > 0) {
-          timer_set(&send_delay_timer, send_delay);
-        }
-      }
+    if(slip_empty()) {
+      slip_begin = slip_end = 0;
+    } else if(n == len && send_delay > 0) {
+      /* a delay between slip packets to avoid losing data */
+      timer_set(&send_delay_timer, send_delay);
     }
   }
 }
 /*---------------------------------------------------------------------------*/
-static void
+/*
+ * Encodes a frame into the output queue. Returns 0, or -1 if the queue
+ * has no room for the frame.
+ */
+static int
 write_to_serial(int outfd, const uint8_t *inbuf, int len)
 {
   const uint8_t *p = inbuf;
-  int i;
+  const uint8_t *end = inbuf + len;
+  const uint8_t *run;
+  unsigned char *out;
+  int i, size;
 
   if(slip_config_verbose > 2) {
 #ifdef __CYGWIN__
@@ -392,37 +420,67 @@ write_to_serial(int outfd, const uint8_t *inbuf, int len)
     }
   }
 
+  /* The encoded size: each END and ESC takes two bytes */
+  size = len + 1;
+  for(i = 0; i < len; i++) {
+    if(escape_table[p[i]] != 0) {
+      size++;
+    }
+  }
+
+  if(slip_end + size > sizeof(slip_buf)) {
+    if(slip_begin > 0) {
+      memmove(slip_buf, slip_buf + slip_begin, slip_end - slip_begin);
+      slip_end -= slip_begin;
+      slip_begin = 0;
+    }
+    if(slip_end + size > sizeof(slip_buf)) {
+      /* Let the caller know, instead of blocking */
+      stats.frames_dropped++;
+      return -1;
+    }
+  }
+
   /* It would be ``nice'' to send a SLIP_END here but it's not
    * really necessary.
    */
-  /* slip_send(outfd, SLIP_END); */
 
-  for(i = 0; i < len; i++) {
-    switch(p[i]) {
-    case SLIP_END:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_END);
-      break;
-    case SLIP_ESC:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_ESC);
-      break;
-    default:
-      slip_send(outfd, p[i]);
-      break;
+  out = slip_buf + slip_end;
+  while(p < end) {
+    run = p;
+    while(p < end && escape_table[*p] == 0) {
+      p++;
+    }
+    memcpy(out, run, p - run);
+    out += p - run;
+    if(p < end) {
+      *out++ = SLIP_ESC;
+      *out++ = escape_table[*p++];
     }
   }
-  slip_send(outfd, SLIP_END);
+  *out++ = SLIP_END;
+
+  slip_end += size;
+  stats.bytes_sent += size;
+  stats.frames_sent++;
   PROGRESS("t");
+  return 0;
 }
 /*---------------------------------------------------------------------------*/
 /* writes an 802.15.4 packet to slip-radio */
-void
+int
 write_to_slip(const uint8_t *buf, int len)
 {
   if(slipfd > 0) {
-    write_to_serial(slipfd, buf, len);
+    return write_to_serial(slipfd, buf, len);
   }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_get_stats(struct slip_stats *s)
+{
+  *s = stats;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -499,7 +557,7 @@ static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
   if(FD_ISSET(slipfd, rset)) {
-    serial_input(inslip);
+    serial_input();
   }
 
   if(FD_ISSET(slipfd, wset)) {
@@ -559,10 +617,7 @@ slip_init(void)
   }
 
   timer_set(&send_delay_timer, 0);
-  slip_send(slipfd, SLIP_END);
-  inslip = fdopen(slipfd, "r");
-  if(inslip == NULL) {
-    err(1, "slip_init: fdopen");
-  }
+  /* An empty frame flushes any noise at the radio */
+  slip_buf[slip_end++] = SLIP_END;
 }
 /*---------------------------------------------------------------------------*/
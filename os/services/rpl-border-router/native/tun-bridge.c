@@ -71,6 +71,17 @@ extern const char *slip_config_ipaddr;
 extern char slip_config_tundev[32];
 extern uint16_t slip_config_basedelay;
 
+/*
+ * The largest number of packets read from the tun device each time it is
+ * readable. A batch ends early when a packet has been queued for the
+ * SLIP radio, so a burst does not overflow the SLIP output buffer.
+ */
+#ifdef TUN_BRIDGE_CONF_BATCH_SIZE
+#define TUN_BRIDGE_BATCH_SIZE TUN_BRIDGE_CONF_BATCH_SIZE
+#else
+#define TUN_BRIDGE_BATCH_SIZE 16
+#endif
+
 #ifndef __CYGWIN__
 static int tunfd;
 
@@ -213,6 +224,11 @@ tun_init()
     err(1, "tun_init: open");
   }
 
+  /* Reads stop at an empty device queue instead of blocking */
+  if(fcntl(tunfd, F_SETFL, fcntl(tunfd, F_GETFL) | O_NONBLOCK) == -1) {
+    err(1, "tun_init: fcntl");
+  }
+
   select_set_callback(tunfd, &tun_select_callback);
 
   fprintf(stderr, "opened %s device ``/dev/%s''\n",
@@ -230,6 +246,10 @@ tun_output(uint8_t *data, int len)
 {
   /* fprintf(stderr, "*** Writing to tun...%d\n", len); */
   if(write(tunfd, data, len) != len) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      /* The device queue is full, drop the packet */
+      return -1;
+    }
     err(1, "serial_to_tun: write");
     return -1;
   }
@@ -241,6 +261,10 @@ tun_input(unsigned char *data, int maxlen)
 {
   int size;
   if((size = read(tunfd, data, maxlen)) == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      /* No more packets queued */
+      return 0;
+    }
     err(1, "tun_input: read");
   }
   return size;
@@ -296,19 +320,33 @@ handle_fd(fd_set *rset, fd_set *wset)
 
   if(delaymsec == 0) {
     int size;
+    int count;
 
     if(FD_ISSET(tunfd, rset)) {
-      size = tun_input(uip_buf, sizeof(uip_buf));
-      /* printf("TUN data incoming read:%d\n", size); */
-      uip_len = size;
-      tcpip_input();
-
-      if(slip_config_basedelay) {
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        delaymsec = slip_config_basedelay;
-        delaystartsec = tv.tv_sec;
-        delaystartmsec = tv.tv_usec / 1000;
+      /*
+       * Drain the device queue while the packets are for the border
+       * router itself, a batch of packets at most.
+       */
+      for(count = 0; count < TUN_BRIDGE_BATCH_SIZE; count++) {
+        size = tun_input(uip_buf, sizeof(uip_buf));
+        /* printf("TUN data incoming read:%d\n", size); */
+        if(size <= 0) {
+          break;
+        }
+        uip_len = size;
+        tcpip_input();
+
+        if(slip_config_basedelay) {
+          struct timeval tv;
+          gettimeofday(&tv, NULL);
+          delaymsec = slip_config_basedelay;
+          delaystartsec = tv.tv_sec;
+          delaystartmsec = tv.tv_usec / 1000;
+          break;
+        }
+        if(!slip_empty()) {
+          break;
+        }
       }
     }
   }
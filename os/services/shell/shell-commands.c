@@ -235,6 +235,20 @@ PT_THREAD(cmd_rpl_nbr(struct pt *pt, shell_output_func output, char *args))
     }
   }
 
+  {
+    struct rpl_neighbor_stats stats;
+    rpl_neighbor_get_stats(&stats);
+    SHELL_OUTPUT(output, "Parent selection: %lu selections, %lu rank computations, %u candidates\n",
+                 (unsigned long)stats.selections, (unsigned long)stats.recomputations,
+                 stats.candidates);
+    SHELL_OUTPUT(output, "Fast repair: %u repairs, %u without backup, %u packets requeued, "
+                 "switch %lu ms avg %lu ms max, DAO ACK %lu ms avg\n",
+                 stats.repairs, stats.failed_repairs, stats.requeued,
+                 stats.repairs ? (unsigned long)(stats.switch_time / stats.repairs) : 0,
+                 (unsigned long)stats.max_switch_time,
+                 stats.acked_repairs ? (unsigned long)(stats.ack_time / stats.acked_repairs) : 0);
+  }
+
   PT_END(pt);
 }
 /*---------------------------------------------------------------------------*/
@@ -296,6 +310,120 @@ PT_THREAD(cmd_rpl_refresh_routes(struct pt *pt, shell_output_func output, char *
 
   PT_END(pt);
 }
+/*---------------------------------------------------------------------------*/
+static int
+parse_number(const char *str, unsigned long *value)
+{
+  char *end;
+
+  if(str == NULL) {
+    return 0;
+  }
+  *value = strtoul(str, &end, 10);
+  return end != str && *end == '\0';
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(cmd_rpl_profile(struct pt *pt, shell_output_func output, char *args))
+{
+  struct rpl_timers_profile profile;
+  unsigned long values[3];
+  char *next_args;
+  char *param;
+  int count;
+  int expected;
+
+  PT_BEGIN(pt);
+
+  rpl_timers_get_profile(&profile);
+
+  SHELL_ARGS_INIT(args, next_args);
+  SHELL_ARGS_NEXT(args, next_args);
+  param = args;
+
+  if(param != NULL) {
+    /* Get the values of the parameter */
+    expected = !strcmp(param, "dio") ? 3 : 1;
+    for(count = 0; count < expected; count++) {
+      SHELL_ARGS_NEXT(args, next_args);
+      if(!parse_number(args, &values[count])) {
+        SHELL_OUTPUT(output, "Invalid value: %s\n", args != NULL ? args : "(none)");
+        PT_EXIT(pt);
+      }
+    }
+
+    if(!strcmp(param, "dio")) {
+      profile.dio_intmin = MIN(values[0], 0xff);
+      profile.dio_intdoubl = MIN(values[1], 0xff);
+      profile.dio_redundancy = MIN(values[2], 0xff);
+    } else if(!strcmp(param, "dao-delay") || !strcmp(param, "probing")) {
+      /* The delays are converted to clock ticks, which must not wrap */
+      if(values[0] > (clock_time_t)~(clock_time_t)0 / CLOCK_SECOND) {
+        SHELL_OUTPUT(output, "Value out of range\n");
+        PT_EXIT(pt);
+      }
+      if(!strcmp(param, "dao-delay")) {
+        profile.dao_delay = (clock_time_t)values[0] * CLOCK_SECOND / 1000;
+      } else {
+        profile.probing_interval = (clock_time_t)values[0] * CLOCK_SECOND;
+      }
+    } else {
+      SHELL_OUTPUT(output, "Invalid parameter: %s\n", param);
+      PT_EXIT(pt);
+    }
+
+    if(!rpl_timers_set_profile(&profile)) {
+      SHELL_OUTPUT(output, "Value out of range\n");
+      PT_EXIT(pt);
+    }
+  }
+
+  SHELL_OUTPUT(output, "RPL profile:\n");
+  SHELL_OUTPUT(output, "-- Trickle: Imin %u, doublings %u, redundancy %u\n",
+               profile.dio_intmin, profile.dio_intdoubl, profile.dio_redundancy);
+  SHELL_OUTPUT(output, "-- DAO delay: %lu ms\n",
+               (unsigned long)(profile.dao_delay * 1000 / CLOCK_SECOND));
+  SHELL_OUTPUT(output, "-- Probing interval: %lu s\n",
+               (unsigned long)(profile.probing_interval / CLOCK_SECOND));
+  if(curr_instance.used) {
+    SHELL_OUTPUT(output, "-- DAG Trickle: Imin %u, doublings %u, redundancy %u\n",
+                 curr_instance.dio_intmin, curr_instance.dio_intdoubl,
+                 curr_instance.dio_redundancy);
+  }
+
+  PT_END(pt);
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(cmd_rpl_stats(struct pt *pt, shell_output_func output, char *args))
+{
+  static const char *const names[RPL_ICMP6_STATS_TYPES] = {
+    "DIS", "DIO", "DAO", "DAO-ACK"
+  };
+  struct rpl_icmp6_stats stats;
+  char *next_args;
+  int i;
+
+  PT_BEGIN(pt);
+
+  SHELL_ARGS_INIT(args, next_args);
+  SHELL_ARGS_NEXT(args, next_args);
+
+  rpl_icmp6_get_stats(&stats);
+  SHELL_OUTPUT(output, "RPL control messages (packets/bytes):\n");
+  for(i = 0; i < RPL_ICMP6_STATS_TYPES; i++) {
+    SHELL_OUTPUT(output, "-- %-7s: sent %lu/%lu, received %lu/%lu\n", names[i],
+                 (unsigned long)stats.sent[i], (unsigned long)stats.sent_bytes[i],
+                 (unsigned long)stats.received[i], (unsigned long)stats.received_bytes[i]);
+  }
+
+  if(args != NULL && !strcmp(args, "reset")) {
+    rpl_icmp6_reset_stats();
+    SHELL_OUTPUT(output, "Counters reset\n");
+  }
+
+  PT_END(pt);
+}
 #endif /* ROUTING_CONF_RPL_LITE */
 /*---------------------------------------------------------------------------*/
 static void
@@ -1000,6 +1128,8 @@ const struct shell_command_t builtin_shell_commands[] = {
   { "rpl-refresh-routes",   cmd_rpl_refresh_routes,   "'> rpl-refresh-routes': Refreshes all routes through a DTSN increment" },
   { "rpl-status",           cmd_rpl_status,           "'> rpl-status': Shows a summary of the current RPL state" },
   { "rpl-nbr",              cmd_rpl_nbr,              "'> rpl-nbr': Shows the RPL neighbor table" },
+  { "rpl-profile",          cmd_rpl_profile,          "'> rpl-profile [dio imin doublings redundancy | dao-delay ms | probing s]': Shows or sets the RPL control-plane profile. The Trickle parameters of a root reach the DAG with the next global repair." },
+  { "rpl-stats",            cmd_rpl_stats,            "'> rpl-stats [reset]': Shows the RPL control message counters, and optionally resets them" },
 #endif /* ROUTING_CONF_RPL_LITE */
   { "rpl-global-repair",    cmd_rpl_global_repair,    "'> rpl-global-repair': Triggers a RPL global repair" },
 #endif /* UIP_CONF_IPV6_RPL */
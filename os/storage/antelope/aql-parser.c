@@ -278,6 +278,16 @@ PARSER(operand)
   case STRING_VALUE:
     break;
   case FLOAT_VALUE:
+#if LVM_USE_FLOATS
+    {
+      float float_value;
+
+      memcpy(&float_value, lexer->value, sizeof(float_value));
+      if(LVM_ERROR(lvm_set_float(&p, float_value))) {
+        RETURN(SYNTAX_ERROR);
+      }
+    }
+#endif /* LVM_USE_FLOATS */
     break;
   case INTEGER_VALUE:
     if(LVM_ERROR(lvm_set_long(&p, *(long *)lexer->value))) {
@@ -655,6 +665,9 @@ PARSER_TOKEN(index_type)
   case MEMHASH:
     type = INDEX_MEMHASH;
     break;
+  case BTREE:
+    type = INDEX_BTREE;
+    break;
   default:
     return NONE;
   };
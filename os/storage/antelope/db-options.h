@@ -111,6 +111,12 @@
 #define DB_VM_BYTECODE_SIZE		256
 #endif /* DB_VM_BYTECODE_SIZE */
 
+/* The size of the buffer that holds rows read ahead when scanning
+   a relation. Rows larger than the buffer are read one at a time. */
+#ifndef DB_SCAN_BUFFER_SIZE
+#define DB_SCAN_BUFFER_SIZE		128
+#endif /* DB_SCAN_BUFFER_SIZE */
+
 /*----------------------------------------------------------------------------*/
 
 /* Language options. */
@@ -215,6 +221,31 @@
 #define DB_HEAP_CACHE_LIMIT		1
 #endif /* DB_HEAP_CACHE_LIMIT */
 
+/* The maximum number of B+-tree indexes. */
+#ifndef DB_BTREE_INDEX_LIMIT
+#define DB_BTREE_INDEX_LIMIT		1
+#endif /* DB_BTREE_INDEX_LIMIT */
+
+/* The number of 256-byte nodes reserved in the file of a B+-tree index.
+   Nodes are never rewritten, so each leaf split and each deletion consumes
+   new nodes for the leaves and for the path to the root. When the file
+   runs out of nodes, the live entries are compacted into a new file of
+   the same size, so up to twice this space is used while it happens. */
+#ifndef DB_BTREE_NODE_LIMIT
+#define DB_BTREE_NODE_LIMIT		256
+#endif /* DB_BTREE_NODE_LIMIT */
+
+/* The maximum number of nodes cached in RAM by all B+-tree indexes. */
+#ifndef DB_BTREE_CACHE_LIMIT
+#define DB_BTREE_CACHE_LIMIT		4
+#endif /* DB_BTREE_CACHE_LIMIT */
+
+/* The number of entries that are sorted in RAM and passed together to
+   an index that supports bulk loading, when indexing an old relation. */
+#ifndef DB_INDEX_BULK_LOAD_SIZE
+#define DB_INDEX_BULK_LOAD_SIZE		32
+#endif /* DB_INDEX_BULK_LOAD_SIZE */
+
 /*----------------------------------------------------------------------------*/
 
 /* LVM options. */
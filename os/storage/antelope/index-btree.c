@@ -0,0 +1,1107 @@
+/*
+ * Copyright (c) 2026, Contiki-NG Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *     A B+-tree index for flash memory.
+ *
+ *     The tree is stored in a file of fixed-size nodes, and every byte
+ *     of the file is written at most once. Leaf entries are appended to
+ *     the free slots of a leaf in arrival order, and are sorted when the
+ *     leaf is read into the node cache. When a leaf is full, it is split
+ *     into two new leaves, and the internal nodes on the path to the
+ *     root are copied with the updated child pointers. The root is thus
+ *     always the most recently allocated node, which lets the tree be
+ *     reloaded by searching for the first unallocated node.
+ *
+ *     Range searches descend to the first leaf that may hold the lower
+ *     bound, and then advance through the leaves by means of the path
+ *     from the root, which also serves as the iteration state.
+ *
+ *     Since the nodes that are replaced are not reused, the file runs out
+ *     of nodes after a number of updates. The live entries are then
+ *     copied into partially filled leaves in a new file, the internal
+ *     nodes are built bottom-up on top of them, and the index switches
+ *     to the new file.
+ */
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cfs/cfs.h"
+#include "lib/memb.h"
+
+#include "db-options.h"
+#include "index.h"
+#include "result.h"
+#include "storage.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ipv6/uip-debug.h"
+
+#define NODE_SIZE		256
+#define MAX_DEPTH		8
+
+#define NODE_FREE		0
+#define NODE_LEAF		1
+#define NODE_INTERNAL		2
+
+#define NO_NODE			0xffff
+
+/* The number of entries in a leaf written by a compaction. The free
+   slots let later insertions be appended without a split. */
+#define COMPACT_LEAF_FILL	(LEAF_CAPACITY * 3 / 4)
+
+typedef int32_t btree_key_t;
+typedef uint16_t btree_node_id_t;
+
+struct node_header {
+  uint8_t type;
+  /* The number of entries in a leaf, or children in an internal node. */
+  uint8_t count;
+  uint16_t reserved;
+};
+
+/* The stored value is the tuple ID plus one, so that an unwritten
+   slot can be distinguished from a valid entry. */
+struct leaf_pair {
+  btree_key_t key;
+  uint32_t value;
+};
+
+#define LEAF_CAPACITY							\
+  ((NODE_SIZE - sizeof(struct node_header)) / sizeof(struct leaf_pair))
+#define FANOUT								\
+  ((NODE_SIZE - sizeof(struct node_header) + sizeof(btree_key_t)) /	\
+   (sizeof(btree_key_t) + sizeof(btree_node_id_t)))
+
+struct leaf {
+  struct node_header header;
+  struct leaf_pair pairs[LEAF_CAPACITY];
+};
+
+/* The child at position i holds keys in the range [keys[i - 1], keys[i]]. */
+struct internal {
+  struct node_header header;
+  btree_key_t keys[FANOUT - 1];
+  btree_node_id_t children[FANOUT];
+};
+
+union node {
+  struct node_header header;
+  struct leaf leaf;
+  struct internal internal;
+};
+
+struct btree {
+  index_t *index;
+  db_storage_id_t storage;
+  btree_node_id_t node_count;
+};
+typedef struct btree btree_t;
+
+/* A path from the root to a leaf, and a position in the leaf. */
+struct cursor {
+  btree_node_id_t nodes[MAX_DEPTH + 1];
+  uint8_t positions[MAX_DEPTH + 1];
+  uint8_t depth;
+};
+
+struct node_cache {
+  btree_t *tree;
+  btree_node_id_t node_id;
+  uint16_t last_use;
+  union node node;
+};
+
+static struct node_cache node_cache[DB_BTREE_CACHE_LIMIT];
+static uint16_t cache_clock;
+
+/* The state of the last range search, which a compaction invalidates. */
+static struct {
+  index_iterator_t *index_iterator;
+  struct cursor cursor;
+  btree_key_t max;
+} iteration_cache;
+MEMB(btrees, btree_t, DB_BTREE_INDEX_LIMIT);
+
+/* Work buffers for node splits, which hold one entry more than a node. */
+static struct leaf_pair split_pairs[LEAF_CAPACITY + 1];
+static btree_key_t split_keys[FANOUT];
+static btree_node_id_t split_children[FANOUT + 1];
+static union node new_node;
+
+static db_result_t create(index_t *);
+static db_result_t destroy(index_t *);
+static db_result_t load(index_t *);
+static db_result_t release(index_t *);
+static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
+static db_result_t delete(index_t *, attribute_value_t *);
+static tuple_id_t get_next(index_iterator_t *);
+static db_result_t bulk_insert(index_t *, index_entry_t *, unsigned);
+
+index_api_t index_btree = {
+  INDEX_BTREE,
+  INDEX_API_EXTERNAL | INDEX_API_RANGE_QUERIES | INDEX_API_BULK_LOAD,
+  create,
+  destroy,
+  load,
+  release,
+  insert,
+  delete,
+  get_next,
+  bulk_insert
+};
+
+static btree_key_t
+to_key(long value)
+{
+  if(value > INT32_MAX) {
+    return INT32_MAX;
+  } else if(value < INT32_MIN) {
+    return INT32_MIN;
+  }
+  return (btree_key_t)value;
+}
+
+static unsigned long
+node_offset(btree_node_id_t node_id)
+{
+  return (unsigned long)node_id * NODE_SIZE;
+}
+
+static void
+sort_pairs(struct leaf_pair *pairs, unsigned count)
+{
+  struct leaf_pair pair;
+  unsigned i, j;
+
+  for(i = 1; i < count; i++) {
+    pair = pairs[i];
+    for(j = i; j > 0 && pairs[j - 1].key > pair.key; j--) {
+      pairs[j] = pairs[j - 1];
+    }
+    pairs[j] = pair;
+  }
+}
+
+static void
+invalidate_cache(btree_t *tree)
+{
+  int i;
+
+  for(i = 0; i < DB_BTREE_CACHE_LIMIT; i++) {
+    if(node_cache[i].tree == tree) {
+      node_cache[i].tree = NULL;
+    }
+  }
+}
+
+static struct node_cache *
+get_cache_slot(btree_t *tree, btree_node_id_t node_id)
+{
+  struct node_cache *victim;
+  int i;
+
+  victim = &node_cache[0];
+  for(i = 0; i < DB_BTREE_CACHE_LIMIT; i++) {
+    if(node_cache[i].tree == tree && node_cache[i].node_id == node_id) {
+      return &node_cache[i];
+    }
+    if(node_cache[i].tree == NULL) {
+      victim = &node_cache[i];
+    } else if(victim->tree != NULL &&
+              (uint16_t)(cache_clock - node_cache[i].last_use) >
+              (uint16_t)(cache_clock - victim->last_use)) {
+      victim = &node_cache[i];
+    }
+  }
+
+  victim->tree = NULL;
+  return victim;
+}
+
+static union node *
+get_node(btree_t *tree, btree_node_id_t node_id)
+{
+  struct node_cache *cache;
+  union node *node;
+  unsigned count;
+
+  cache = get_cache_slot(tree, node_id);
+  cache->last_use = ++cache_clock;
+  node = &cache->node;
+  if(cache->tree == tree) {
+    return node;
+  }
+
+  if(node_id >= tree->node_count ||
+     DB_ERROR(storage_read(tree->storage, node, node_offset(node_id),
+                           sizeof(*node)))) {
+    PRINTF("DB: Failed to read B+-tree node %u\n", (unsigned)node_id);
+    return NULL;
+  }
+
+  if(node->header.type == NODE_LEAF) {
+    /* Entries are written to a leaf in arrival order. */
+    for(count = 0; count < LEAF_CAPACITY; count++) {
+      if(node->leaf.pairs[count].value == 0) {
+        break;
+      }
+    }
+    node->header.count = count;
+    sort_pairs(node->leaf.pairs, count);
+  } else if(node->header.type != NODE_INTERNAL) {
+    PRINTF("DB: Invalid B+-tree node %u\n", (unsigned)node_id);
+    return NULL;
+  }
+
+  cache->tree = tree;
+  cache->node_id = node_id;
+  return node;
+}
+
+static int
+write_node(btree_t *tree, btree_node_id_t node_id, union node *node)
+{
+  struct node_cache *cache;
+  unsigned size;
+
+  /* Only the used slots of a leaf are written, so that the free slots
+     can be appended to later. */
+  if(node->header.type == NODE_LEAF) {
+    size = offsetof(struct leaf, pairs) +
+      node->header.count * sizeof(struct leaf_pair);
+  } else {
+    size = sizeof(struct internal);
+  }
+
+  if(DB_ERROR(storage_write(tree->storage, node, node_offset(node_id), size))) {
+    return 0;
+  }
+
+  cache = get_cache_slot(tree, node_id);
+  cache->tree = tree;
+  cache->node_id = node_id;
+  cache->last_use = ++cache_clock;
+  memcpy(&cache->node, node, sizeof(*node));
+
+  return 1;
+}
+
+static btree_node_id_t
+allocate_node(btree_t *tree)
+{
+  return tree->node_count++;
+}
+
+static unsigned
+child_position(struct internal *node, btree_key_t key, int upper)
+{
+  unsigned low, high, middle;
+
+  /* Find the number of keys that are smaller than the given key, or,
+     if upper is set, smaller than or equal to the given key. */
+  low = 0;
+  high = node->header.count - 1;
+  while(low < high) {
+    middle = (low + high) / 2;
+    if(node->keys[middle] < key || (upper && node->keys[middle] == key)) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+static union node *
+descend(btree_t *tree, btree_key_t key, int upper, struct cursor *cursor,
+        btree_key_t *limit, int *has_limit)
+{
+  union node *node;
+  unsigned level;
+  unsigned position;
+
+  *has_limit = 0;
+  cursor->nodes[0] = tree->node_count - 1;
+  for(level = 0;; level++) {
+    node = get_node(tree, cursor->nodes[level]);
+    if(node == NULL) {
+      return NULL;
+    }
+    if(node->header.type == NODE_LEAF) {
+      cursor->depth = level;
+      cursor->positions[level] = 0;
+      return node;
+    }
+    if(level == MAX_DEPTH) {
+      return NULL;
+    }
+    position = child_position(&node->internal, key, upper);
+    if(position < node->header.count - 1U) {
+      *limit = node->internal.keys[position];
+      *has_limit = 1;
+    }
+    cursor->positions[level] = position;
+    cursor->nodes[level + 1] = node->internal.children[position];
+  }
+}
+
+static int
+next_leaf(btree_t *tree, struct cursor *cursor, btree_key_t max)
+{
+  union node *node;
+  int level;
+  unsigned position;
+
+  /* Find the lowest ancestor with a sibling subtree to the right. */
+  for(level = cursor->depth - 1; level >= 0; level--) {
+    node = get_node(tree, cursor->nodes[level]);
+    if(node == NULL) {
+      return 0;
+    }
+    position = cursor->positions[level];
+    if(position + 1 < node->header.count) {
+      if(node->internal.keys[position] > max) {
+        /* The subtrees to the right hold only larger keys. */
+        return 0;
+      }
+      cursor->positions[level] = position + 1;
+      break;
+    }
+  }
+  if(level < 0) {
+    return 0;
+  }
+
+  /* Descend to the leftmost leaf of the subtree. */
+  for(; level < cursor->depth; level++) {
+    node = get_node(tree, cursor->nodes[level]);
+    if(node == NULL) {
+      return 0;
+    }
+    cursor->nodes[level + 1] = node->internal.children[cursor->positions[level]];
+    cursor->positions[level + 1] = 0;
+  }
+  return 1;
+}
+
+/*
+ * Replace the child on the cursor path at the given level with a new
+ * node, and add the optional right sibling with the separator key. The
+ * ancestors are copied to new nodes up to the root, which is written last.
+ */
+static int
+update_path(btree_t *tree, struct cursor *cursor, int level,
+            btree_node_id_t left, btree_key_t separator,
+            btree_node_id_t right)
+{
+  union node *node;
+  unsigned count, position, half, i;
+
+  for(level--; level >= 0; level--) {
+    node = get_node(tree, cursor->nodes[level]);
+    if(node == NULL) {
+      return 0;
+    }
+
+    count = node->header.count;
+    position = cursor->positions[level];
+    memcpy(split_keys, node->internal.keys, (count - 1) * sizeof(btree_key_t));
+    memcpy(split_children, node->internal.children,
+           count * sizeof(btree_node_id_t));
+    split_children[position] = left;
+    if(right != NO_NODE) {
+      for(i = count; i > position + 1; i--) {
+        split_children[i] = split_children[i - 1];
+        split_keys[i - 1] = split_keys[i - 2];
+      }
+      split_children[position + 1] = right;
+      split_keys[position] = separator;
+      count++;
+    }
+
+    memset(&new_node, 0, sizeof(new_node));
+    new_node.header.type = NODE_INTERNAL;
+    if(count <= FANOUT) {
+      new_node.header.count = count;
+      memcpy(new_node.internal.keys, split_keys,
+             (count - 1) * sizeof(btree_key_t));
+      memcpy(new_node.internal.children, split_children,
+             count * sizeof(btree_node_id_t));
+      left = allocate_node(tree);
+      right = NO_NODE;
+      if(!write_node(tree, left, &new_node)) {
+        return 0;
+      }
+      continue;
+    }
+
+    /* Split the node and promote the middle key to the parent. */
+    half = count / 2;
+    new_node.header.count = half;
+    memcpy(new_node.internal.keys, split_keys,
+           (half - 1) * sizeof(btree_key_t));
+    memcpy(new_node.internal.children, split_children,
+           half * sizeof(btree_node_id_t));
+    left = allocate_node(tree);
+    if(!write_node(tree, left, &new_node)) {
+      return 0;
+    }
+    separator = split_keys[half - 1];
+
+    memset(&new_node, 0, sizeof(new_node));
+    new_node.header.type = NODE_INTERNAL;
+    new_node.header.count = count - half;
+    memcpy(new_node.internal.keys, &split_keys[half],
+           (count - half - 1) * sizeof(btree_key_t));
+    memcpy(new_node.internal.children, &split_children[half],
+           (count - half) * sizeof(btree_node_id_t));
+    right = allocate_node(tree);
+    if(!write_node(tree, right, &new_node)) {
+      return 0;
+    }
+  }
+
+  if(right != NO_NODE) {
+    /* The root was split; grow the tree by one level. */
+    memset(&new_node, 0, sizeof(new_node));
+    new_node.header.type = NODE_INTERNAL;
+    new_node.header.count = 2;
+    new_node.internal.keys[0] = separator;
+    new_node.internal.children[0] = left;
+    new_node.internal.children[1] = right;
+    if(!write_node(tree, allocate_node(tree), &new_node)) {
+      return 0;
+    }
+    PRINTF("DB: The B+-tree grew to depth %u\n", cursor->depth + 1);
+  }
+
+  return 1;
+}
+
+static int
+has_free_nodes(btree_t *tree, struct cursor *cursor)
+{
+  /* In the worst case, every node on the path is split, and a new
+     root is added. */
+  return tree->node_count + 2 * (cursor->depth + 1) + 1 <=
+    DB_BTREE_NODE_LIMIT;
+}
+
+static int
+is_rightmost(btree_t *tree, struct cursor *cursor)
+{
+  union node *node;
+  int level;
+
+  for(level = 0; level < cursor->depth; level++) {
+    node = get_node(tree, cursor->nodes[level]);
+    if(node == NULL ||
+       cursor->positions[level] + 1 != node->header.count) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Copy the live entries into a new file, in which the internal nodes are
+ * built bottom-up on top of the leaves so that the root is the last node,
+ * and switch the index to it.
+ */
+static int
+compact(btree_t *tree)
+{
+  btree_t compacted;
+  struct cursor cursor;
+  union node *node;
+  char *generated;
+  char filename[DB_MAX_FILENAME_LENGTH];
+  char old_filename[DB_MAX_FILENAME_LENGTH];
+  btree_key_t limit;
+  int has_limit, result;
+  unsigned position, children, i;
+  unsigned long leaves_per_child;
+  btree_node_id_t level_start, level_end, child;
+
+  generated = storage_generate_file("btree",
+                                    (unsigned long)DB_BTREE_NODE_LIMIT *
+                                    NODE_SIZE);
+  if(generated == NULL) {
+    PRINTF("DB: Failed to generate a B+-tree file\n");
+    return 0;
+  }
+  memcpy(filename, generated, sizeof(filename));
+
+  compacted.index = tree->index;
+  compacted.node_count = 0;
+  compacted.storage = storage_open(filename);
+  if(compacted.storage < 0) {
+    cfs_remove(filename);
+    return 0;
+  }
+
+  /* Copy the entries in key order into partially filled leaves. */
+  result = 1;
+  memset(&new_node, 0, sizeof(new_node));
+  new_node.header.type = NODE_LEAF;
+  node = descend(tree, INT32_MIN, 0, &cursor, &limit, &has_limit);
+  while(node != NULL) {
+    for(position = 0; position < node->header.count; position++) {
+      new_node.leaf.pairs[new_node.header.count++] =
+        node->leaf.pairs[position];
+      if(new_node.header.count == COMPACT_LEAF_FILL) {
+        if(compacted.node_count == DB_BTREE_NODE_LIMIT ||
+           !write_node(&compacted, allocate_node(&compacted), &new_node)) {
+          result = 0;
+          break;
+        }
+        new_node.header.count = 0;
+        /* The write may have evicted the leaf from the cache. */
+        node = get_node(tree, cursor.nodes[cursor.depth]);
+        if(node == NULL) {
+          result = 0;
+          break;
+        }
+      }
+    }
+    if(!result) {
+      break;
+    }
+    if(!next_leaf(tree, &cursor, INT32_MAX)) {
+      /* Either the last leaf has been copied, or a node read failed. */
+      result = is_rightmost(tree, &cursor);
+      break;
+    }
+    node = get_node(tree, cursor.nodes[cursor.depth]);
+  }
+  if(node == NULL) {
+    result = 0;
+  }
+  if(result && (new_node.header.count > 0 || compacted.node_count == 0)) {
+    result = compacted.node_count < DB_BTREE_NODE_LIMIT &&
+      write_node(&compacted, allocate_node(&compacted), &new_node);
+  }
+
+  /* Add levels of internal nodes until a level has a single node. Every
+     node but the last of a level has FANOUT children. */
+  level_start = 0;
+  level_end = compacted.node_count;
+  leaves_per_child = 1;
+  while(result && level_end - level_start > 1) {
+    for(child = level_start; result && child < level_end; child += children) {
+      children = level_end - child;
+      if(children > FANOUT) {
+        children = FANOUT;
+      }
+      memset(&new_node, 0, sizeof(new_node));
+      new_node.header.type = NODE_INTERNAL;
+      new_node.header.count = children;
+      for(i = 0; i < children; i++) {
+        new_node.internal.children[i] = child + i;
+        if(i > 0) {
+          /* The separator is the first key of the leftmost leaf of the
+             child, and the leaves are the first nodes of the file. */
+          node = get_node(&compacted,
+                          (child + i - level_start) * leaves_per_child);
+          if(node == NULL) {
+            result = 0;
+            break;
+          }
+          new_node.internal.keys[i - 1] = node->leaf.pairs[0].key;
+        }
+      }
+      result = result && compacted.node_count < DB_BTREE_NODE_LIMIT &&
+        write_node(&compacted, allocate_node(&compacted), &new_node);
+    }
+    level_start = level_end;
+    level_end = compacted.node_count;
+    leaves_per_child *= FANOUT;
+  }
+
+  /* Record the new file before the old one is removed. */
+  if(result) {
+    memcpy(old_filename, tree->index->descriptor_file, sizeof(old_filename));
+    memcpy(tree->index->descriptor_file, filename, sizeof(filename));
+    if(DB_ERROR(storage_put_index(tree->index))) {
+      memcpy(tree->index->descriptor_file, old_filename,
+             sizeof(old_filename));
+      result = 0;
+    }
+  }
+
+  invalidate_cache(&compacted);
+  if(!result) {
+    PRINTF("DB: Failed to compact the B+-tree\n");
+    storage_close(compacted.storage);
+    cfs_remove(filename);
+    return 0;
+  }
+
+  PRINTF("DB: Compacted the B+-tree from %u to %u nodes\n",
+         (unsigned)tree->node_count, (unsigned)compacted.node_count);
+
+  invalidate_cache(tree);
+  storage_close(tree->storage);
+  cfs_remove(old_filename);
+  tree->storage = compacted.storage;
+  tree->node_count = compacted.node_count;
+  iteration_cache.index_iterator = NULL;
+
+  return 1;
+}
+
+static int
+split_leaf(btree_t *tree, struct cursor *cursor, union node *leaf,
+           struct leaf_pair *pair)
+{
+  unsigned count, half, i;
+  btree_node_id_t left, right;
+
+  if(!has_free_nodes(tree, cursor)) {
+    PRINTF("DB: The B+-tree has no free nodes\n");
+    return 0;
+  }
+
+  /* The leaf is copied first, because reading other nodes may evict it
+     from the cache. */
+  count = leaf->header.count;
+  for(i = count; i > 0 && leaf->leaf.pairs[i - 1].key > pair->key; i--) {
+    split_pairs[i] = leaf->leaf.pairs[i - 1];
+  }
+  split_pairs[i] = *pair;
+  memcpy(split_pairs, leaf->leaf.pairs, i * sizeof(struct leaf_pair));
+  count++;
+
+  /*
+   * Keys that are appended to the end of the rightmost leaf are likely
+   * to be followed by larger keys. The left leaf is then kept full,
+   * so that sequential insertions produce densely packed leaves.
+   */
+  if(i == count - 1 && is_rightmost(tree, cursor)) {
+    half = count - 1;
+  } else {
+    half = count / 2;
+  }
+
+  memset(&new_node, 0, sizeof(new_node));
+  new_node.header.type = NODE_LEAF;
+  new_node.header.count = half;
+  memcpy(new_node.leaf.pairs, split_pairs, half * sizeof(struct leaf_pair));
+  left = allocate_node(tree);
+  if(!write_node(tree, left, &new_node)) {
+    return 0;
+  }
+
+  memset(&new_node, 0, sizeof(new_node));
+  new_node.header.type = NODE_LEAF;
+  new_node.header.count = count - half;
+  memcpy(new_node.leaf.pairs, &split_pairs[half],
+         (count - half) * sizeof(struct leaf_pair));
+  right = allocate_node(tree);
+  if(!write_node(tree, right, &new_node)) {
+    return 0;
+  }
+
+  PRINTF("DB: Split B+-tree leaf %u into %u and %u\n",
+         (unsigned)cursor->nodes[cursor->depth], (unsigned)left,
+         (unsigned)right);
+
+  return update_path(tree, cursor, cursor->depth, left,
+                     split_pairs[half].key, right);
+}
+
+static int
+append_pairs(btree_t *tree, btree_node_id_t node_id, union node *leaf,
+             struct leaf_pair *pairs, unsigned count)
+{
+  struct leaf *cached;
+  unsigned i, j;
+
+  if(DB_ERROR(storage_write(tree->storage, pairs,
+                            node_offset(node_id) +
+                            offsetof(struct leaf, pairs) +
+                            leaf->header.count * sizeof(struct leaf_pair),
+                            count * sizeof(struct leaf_pair)))) {
+    return 0;
+  }
+
+  /* Keep the cached leaf sorted. */
+  cached = &leaf->leaf;
+  for(i = 0; i < count; i++) {
+    for(j = cached->header.count;
+        j > 0 && cached->pairs[j - 1].key > pairs[i].key; j--) {
+      cached->pairs[j] = cached->pairs[j - 1];
+    }
+    cached->pairs[j] = pairs[i];
+    cached->header.count++;
+  }
+
+  return 1;
+}
+
+static int
+insert_pair(btree_t *tree, btree_key_t key, tuple_id_t tuple_id)
+{
+  struct cursor cursor;
+  union node *leaf;
+  struct leaf_pair pair;
+  btree_key_t limit;
+  int has_limit;
+
+  leaf = descend(tree, key, 1, &cursor, &limit, &has_limit);
+  if(leaf != NULL && leaf->header.count == LEAF_CAPACITY &&
+     !has_free_nodes(tree, &cursor)) {
+    if(!compact(tree)) {
+      return 0;
+    }
+    leaf = descend(tree, key, 1, &cursor, &limit, &has_limit);
+  }
+  if(leaf == NULL) {
+    return 0;
+  }
+
+  pair.key = key;
+  pair.value = tuple_id + 1;
+
+  if(leaf->header.count < LEAF_CAPACITY) {
+    return append_pairs(tree, cursor.nodes[cursor.depth], leaf, &pair, 1);
+  }
+
+  return split_leaf(tree, &cursor, leaf, &pair);
+}
+
+static db_result_t
+create(index_t *index)
+{
+  btree_t *tree;
+  char *filename;
+
+  filename = storage_generate_file("btree",
+                                   (unsigned long)DB_BTREE_NODE_LIMIT *
+                                   NODE_SIZE);
+  if(filename == NULL) {
+    PRINTF("DB: Failed to generate a B+-tree file\n");
+    return DB_INDEX_ERROR;
+  }
+  memcpy(index->descriptor_file, filename, sizeof(index->descriptor_file));
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    cfs_remove(index->descriptor_file);
+    index->descriptor_file[0] = '\0';
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->index = index;
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0) {
+    goto error;
+  }
+
+  /* The tree starts as a single, empty leaf. */
+  memset(&new_node, 0, sizeof(new_node));
+  new_node.header.type = NODE_LEAF;
+  tree->node_count = 0;
+  if(!write_node(tree, allocate_node(tree), &new_node)) {
+    storage_close(tree->storage);
+    goto error;
+  }
+
+  PRINTF("DB: Created a B+-tree index in \"%s\"\n", index->descriptor_file);
+  return DB_OK;
+
+error:
+  invalidate_cache(tree);
+  memb_free(&btrees, tree);
+  cfs_remove(index->descriptor_file);
+  index->descriptor_file[0] = '\0';
+  return DB_STORAGE_ERROR;
+}
+
+static db_result_t
+destroy(index_t *index)
+{
+  /* The index has already been released. */
+  cfs_remove(index->descriptor_file);
+  return DB_OK;
+}
+
+static db_result_t
+load(index_t *index)
+{
+  btree_t *tree;
+  struct node_header header;
+  unsigned low, high, middle;
+
+  index->opaque_data = tree = memb_alloc(&btrees);
+  if(tree == NULL) {
+    PRINTF("DB: Failed to allocate a B+-tree\n");
+    return DB_ALLOCATION_ERROR;
+  }
+
+  tree->index = index;
+  tree->storage = storage_open(index->descriptor_file);
+  if(tree->storage < 0) {
+    memb_free(&btrees, tree);
+    return DB_STORAGE_ERROR;
+  }
+
+  /* Nodes are allocated sequentially, so the node count can be found
+     by a binary search for the first free node. */
+  low = 1;
+  high = DB_BTREE_NODE_LIMIT;
+  while(low < high) {
+    middle = (low + high) / 2;
+    if(DB_ERROR(storage_read(tree->storage, &header, node_offset(middle),
+                             sizeof(header)))) {
+      storage_close(tree->storage);
+      memb_free(&btrees, tree);
+      return DB_STORAGE_ERROR;
+    }
+    if(header.type == NODE_FREE) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  tree->node_count = low;
+
+  PRINTF("DB: Loaded a B+-tree index from \"%s\" with %u nodes\n",
+         index->descriptor_file, (unsigned)tree->node_count);
+
+  return DB_OK;
+}
+
+static db_result_t
+release(index_t *index)
+{
+  btree_t *tree;
+
+  tree = index->opaque_data;
+  invalidate_cache(tree);
+  storage_close(tree->storage);
+  memb_free(&btrees, tree);
+
+  return DB_OK;
+}
+
+static db_result_t
+insert(index_t *index, attribute_value_t *value, tuple_id_t tuple_id)
+{
+  if(!insert_pair(index->opaque_data, to_key(db_value_to_long(value)),
+                  tuple_id)) {
+    PRINTF("DB: Failed to insert key %ld into a B+-tree index\n",
+           db_value_to_long(value));
+    return DB_INDEX_ERROR;
+  }
+  return DB_OK;
+}
+
+static db_result_t
+bulk_insert(index_t *index, index_entry_t *entries, unsigned count)
+{
+  btree_t *tree;
+  struct cursor cursor;
+  union node *leaf;
+  btree_key_t key, limit;
+  int has_limit;
+  unsigned i, n;
+
+  tree = index->opaque_data;
+
+  /*
+   * The entries are sorted, so each descent to a leaf can be followed
+   * by a single write of all the entries that belong to that leaf.
+   */
+  for(i = 0; i < count; i += n) {
+    key = to_key(entries[i].value);
+    leaf = descend(tree, key, 1, &cursor, &limit, &has_limit);
+    if(leaf == NULL) {
+      return DB_INDEX_ERROR;
+    }
+
+    for(n = 0; i + n < count && leaf->header.count + n < LEAF_CAPACITY; n++) {
+      key = to_key(entries[i + n].value);
+      if(has_limit && key >= limit) {
+        break;
+      }
+      split_pairs[n].key = key;
+      split_pairs[n].value = entries[i + n].tuple_id + 1;
+    }
+
+    if(n > 0) {
+      if(!append_pairs(tree, cursor.nodes[cursor.depth], leaf,
+                       split_pairs, n)) {
+        return DB_INDEX_ERROR;
+      }
+    } else {
+      n = 1;
+      if(!insert_pair(tree, key, entries[i].tuple_id)) {
+        return DB_INDEX_ERROR;
+      }
+    }
+  }
+
+  return DB_OK;
+}
+
+/*
+ * Find the leaf and the position of an entry with the given key. The
+ * cursor is set to the path of the leaf.
+ */
+static union node *
+find_pair(btree_t *tree, btree_key_t key, struct cursor *cursor,
+          unsigned *position)
+{
+  union node *leaf;
+  btree_key_t limit;
+  int has_limit;
+  unsigned i;
+
+  leaf = descend(tree, key, 0, cursor, &limit, &has_limit);
+  for(;;) {
+    if(leaf == NULL) {
+      return NULL;
+    }
+    for(i = 0; i < leaf->header.count && leaf->leaf.pairs[i].key < key; i++);
+    if(i < leaf->header.count) {
+      break;
+    }
+    /* Duplicates of a separator key may continue in the next leaf. */
+    if(!next_leaf(tree, cursor, key)) {
+      return NULL;
+    }
+    leaf = get_node(tree, cursor->nodes[cursor->depth]);
+  }
+
+  if(leaf->leaf.pairs[i].key != key) {
+    return NULL;
+  }
+  *position = i;
+  return leaf;
+}
+
+static db_result_t
+delete(index_t *index, attribute_value_t *value)
+{
+  btree_t *tree;
+  struct cursor cursor;
+  union node *leaf;
+  btree_key_t key;
+  unsigned i;
+  btree_node_id_t node_id;
+
+  tree = index->opaque_data;
+  key = to_key(db_value_to_long(value));
+
+  leaf = find_pair(tree, key, &cursor, &i);
+  if(leaf != NULL && !has_free_nodes(tree, &cursor)) {
+    if(!compact(tree)) {
+      return DB_INDEX_ERROR;
+    }
+    leaf = find_pair(tree, key, &cursor, &i);
+  }
+  if(leaf == NULL || !has_free_nodes(tree, &cursor)) {
+    return DB_INDEX_ERROR;
+  }
+
+  /* Write a copy of the leaf without the entry. */
+  memcpy(&new_node, leaf, sizeof(new_node));
+  memmove(&new_node.leaf.pairs[i], &new_node.leaf.pairs[i + 1],
+          (new_node.header.count - i - 1) * sizeof(struct leaf_pair));
+  new_node.header.count--;
+  node_id = allocate_node(tree);
+  if(!write_node(tree, node_id, &new_node) ||
+     !update_path(tree, &cursor, cursor.depth, node_id, 0, NO_NODE)) {
+    return DB_INDEX_ERROR;
+  }
+
+  return DB_OK;
+}
+
+static tuple_id_t
+get_next(index_iterator_t *iterator)
+{
+  btree_t *tree;
+  union node *leaf;
+  struct leaf_pair *pair;
+  btree_key_t min, limit;
+  int has_limit;
+  uint8_t *position;
+
+  tree = iterator->index->opaque_data;
+
+  if(iteration_cache.index_iterator != iterator || iterator->next_item_no == 0) {
+    /* Initialize the cursor for a new search. */
+    iteration_cache.index_iterator = iterator;
+    min = to_key(db_value_to_long(&iterator->min_value));
+    iteration_cache.max = to_key(db_value_to_long(&iterator->max_value));
+    leaf = descend(tree, min, 0, &iteration_cache.cursor, &limit, &has_limit);
+    if(leaf == NULL) {
+      return INVALID_TUPLE;
+    }
+    position = &iteration_cache.cursor.positions[iteration_cache.cursor.depth];
+    while(*position < leaf->header.count &&
+          leaf->leaf.pairs[*position].key < min) {
+      (*position)++;
+    }
+  }
+
+  position = &iteration_cache.cursor.positions[iteration_cache.cursor.depth];
+  for(;;) {
+    leaf = get_node(tree, iteration_cache.cursor.nodes[iteration_cache.cursor.depth]);
+    if(leaf == NULL) {
+      return INVALID_TUPLE;
+    }
+    if(*position < leaf->header.count) {
+      break;
+    }
+    if(!next_leaf(tree, &iteration_cache.cursor, iteration_cache.max)) {
+      return INVALID_TUPLE;
+    }
+  }
+
+  pair = &leaf->leaf.pairs[*position];
+  if(pair->key > iteration_cache.max) {
+    return INVALID_TUPLE;
+  }
+
+  (*position)++;
+  iterator->next_item_no++;
+
+  PRINTF("DB: Found key %ld with value %lu in the B+-tree\n",
+         (long)pair->key, (unsigned long)(pair->value - 1));
+
+  return (tuple_id_t)(pair->value - 1);
+}
@@ -49,7 +49,7 @@
 #include "storage.h"
 
 static index_api_t *index_components[] = {&index_inline,
-	&index_maxheap};
+	&index_maxheap, &index_btree};
 
 LIST(indices);
 MEMB(index_memb, index_t, DB_INDEX_POOL_SIZE);
@@ -57,6 +57,10 @@ MEMB(index_memb, index_t, DB_INDEX_POOL_SIZE);
 static process_event_t load_request_event;
 PROCESS(db_indexer, "DB Indexer");
 
+/* Entries collected for indexes that support bulk loading. */
+static index_entry_t bulk_entries[DB_INDEX_BULK_LOAD_SIZE];
+static unsigned bulk_count;
+
 static index_api_t *
 find_index_api(index_type_t index_type)
 {
@@ -342,6 +346,47 @@ index_exists(attribute_t *attr)
   return 1;
 }
 
+static db_result_t
+bulk_flush(index_t *index)
+{
+  index_entry_t entry;
+  unsigned i, j;
+  unsigned count;
+
+  /* Sort the entries by value before passing them to the index. */
+  for(i = 1; i < bulk_count; i++) {
+    entry = bulk_entries[i];
+    for(j = i; j > 0 && bulk_entries[j - 1].value > entry.value; j--) {
+      bulk_entries[j] = bulk_entries[j - 1];
+    }
+    bulk_entries[j] = entry;
+  }
+
+  count = bulk_count;
+  bulk_count = 0;
+  if(count == 0) {
+    return DB_OK;
+  }
+
+  return index->api->bulk_insert(index, bulk_entries, count);
+}
+
+static db_result_t
+load_value(index_t *index, attribute_value_t *value, tuple_id_t row)
+{
+  if(!(index->api->flags & INDEX_API_BULK_LOAD)) {
+    return index_insert(index, value, row);
+  }
+
+  bulk_entries[bulk_count].value = db_value_to_long(value);
+  bulk_entries[bulk_count].tuple_id = row;
+  if(++bulk_count < DB_INDEX_BULK_LOAD_SIZE) {
+    return DB_OK;
+  }
+
+  return bulk_flush(index);
+}
+
 static index_t *
 get_next_index_to_load(void)
 {
@@ -388,7 +433,8 @@ PROCESS_THREAD(db_indexer, ev, data)
       continue;
     }
 
-    for(;; row++) {
+    bulk_count = 0;
+    for(row = 0;; row++) {
       PROCESS_PAUSE();
 
       result = db_process(&handle);
@@ -408,13 +454,19 @@ PROCESS_THREAD(db_indexer, ev, data)
           goto cleanup;
         }
 
-	if(DB_ERROR(index_insert(index, &value, row))) {
+	if(DB_ERROR(load_value(index, &value, row))) {
 	  index->flags |= INDEX_LOAD_ERROR;
 	  goto cleanup;
 	}
       }
     }
 
+    if((index->api->flags & INDEX_API_BULK_LOAD) &&
+       DB_ERROR(bulk_flush(index))) {
+      index->flags |= INDEX_LOAD_ERROR;
+      goto cleanup;
+    }
+
     PRINTF("DB: Loaded %lu rows into the index\n",
 	(unsigned long)handle.current_row);
 
@@ -43,7 +43,8 @@ typedef enum {
   INDEX_NONE = 0,
   INDEX_INLINE = 1,
   INDEX_MEMHASH = 2,
-  INDEX_MAXHEAP = 3
+  INDEX_MAXHEAP = 3,
+  INDEX_BTREE = 4
 } index_type_t;
 
 #define INDEX_READY		0x00
@@ -55,6 +56,7 @@ typedef enum {
 #define INDEX_API_INLINE	0x04
 #define INDEX_API_COMPLETE	0x08
 #define INDEX_API_RANGE_QUERIES	0x10
+#define INDEX_API_BULK_LOAD	0x20
 
 struct index_api;
 
@@ -80,6 +82,13 @@ struct index_iterator {
 };
 typedef struct index_iterator index_iterator_t;
 
+/* An entry passed to indexes that support bulk loading. */
+struct index_entry {
+  long value;
+  tuple_id_t tuple_id;
+};
+typedef struct index_entry index_entry_t;
+
 struct index_api {
   index_type_t type;
   uint8_t flags;
@@ -90,6 +99,8 @@ struct index_api {
   db_result_t (*insert)(index_t *, attribute_value_t *, tuple_id_t);
   db_result_t (*delete)(index_t *, attribute_value_t *);
   tuple_id_t (*get_next)(index_iterator_t *);
+  /* Insert entries sorted by value; used if INDEX_API_BULK_LOAD is set. */
+  db_result_t (*bulk_insert)(index_t *, index_entry_t *, unsigned);
 };
 
 typedef struct index_api index_api_t;
@@ -97,6 +108,7 @@ typedef struct index_api index_api_t;
 extern index_api_t index_inline;
 extern index_api_t index_maxheap;
 extern index_api_t index_memhash;
+extern index_api_t index_btree;
 
 void index_init(void);
 db_result_t index_create(index_type_t, relation_t *, attribute_t *);
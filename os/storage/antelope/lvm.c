@@ -64,12 +64,19 @@
 #define LVM_USE_FLOATS			0
 #endif
 
+#ifndef LVM_MAX_PLAN_NODES
+#define LVM_MAX_PLAN_NODES		32
+#endif
+
 #define IS_CONNECTIVE(op) ((op) & LVM_CONNECTIVE)
 
 struct variable {
   operand_type_t type;
   operand_value_t value;
   char name[LVM_MAX_NAME_LENGTH + 1];
+  /* The location of the variable's value in a raw row, if bound. */
+  uint16_t row_offset;
+  uint8_t row_size;
 };
 typedef struct variable variable_t;
 
@@ -87,6 +94,32 @@ static variable_t variables[LVM_MAX_VARIABLE_ID];
 /* Range derivations of variables that are used for index searches. */
 static derivation_t derivations[LVM_MAX_VARIABLE_ID];
 
+/*
+ * A compiled plan is a flat copy of the bytecode in prefix order, in
+ * which variables bound to a row are replaced by their offsets in the
+ * row, constant subexpressions are folded, and each node refers to the
+ * node that follows its subtree. The latter makes it possible to skip
+ * the second operand of a logical connective when the first operand
+ * determines the result. Plans compute with longs only, so code with
+ * float operands is not compiled, but interpreted.
+ */
+enum plan_node_type {
+  PLAN_LONG = LVM_OPERAND | 1,
+  PLAN_VARIABLE = LVM_OPERAND | 2,
+  PLAN_ROW_INT = LVM_OPERAND | 3,
+  PLAN_ROW_LONG = LVM_OPERAND | 4
+};
+
+struct plan_node {
+  uint8_t type;
+  uint8_t next;
+  uint16_t offset;
+  long value;
+};
+
+static struct plan_node plan[LVM_MAX_PLAN_NODES];
+static uint8_t plan_length;
+
 #if DEBUG
 static void
 print_derivations(derivation_t *d)
@@ -162,6 +195,88 @@ operand_to_long(operand_t *operand)
   }
 }
 
+#if LVM_USE_FLOATS
+static int
+operand_is_float(operand_t *operand)
+{
+  return operand->type == LVM_FLOAT ||
+    (operand->type == LVM_VARIABLE &&
+     variables[operand->value.id].type == LVM_FLOAT);
+}
+
+static double
+operand_to_double(operand_t *operand)
+{
+  if(operand->type == LVM_FLOAT) {
+    return operand->value.f;
+  } else if(operand->type == LVM_VARIABLE &&
+            variables[operand->value.id].type == LVM_FLOAT) {
+    return variables[operand->value.id].value.f;
+  }
+  return operand_to_long(operand);
+}
+
+/* Arithmetic and comparisons involving a float are done in floating
+   point, so that fractional values are not truncated. */
+static lvm_status_t
+eval_float_expr(operator_t op, operand_t *operand, operand_t *result)
+{
+  double value[2];
+  double result_value;
+
+  value[0] = operand_to_double(&operand[0]);
+  value[1] = operand_to_double(&operand[1]);
+
+  switch(op) {
+  case LVM_ADD:
+    result_value = value[0] + value[1];
+    break;
+  case LVM_SUB:
+    result_value = value[0] - value[1];
+    break;
+  case LVM_MUL:
+    result_value = value[0] * value[1];
+    break;
+  case LVM_DIV:
+    if(value[1] == 0) {
+      return LVM_MATH_ERROR;
+    }
+    result_value = value[0] / value[1];
+    break;
+  default:
+    return LVM_EXECUTION_ERROR;
+  }
+
+  result->type = LVM_FLOAT;
+  result->value.f = result_value;
+
+  return LVM_TRUE;
+}
+
+static int
+eval_float_relation(operator_t op, double d1, double d2)
+{
+  switch(op) {
+  case LVM_EQ:
+    return d1 == d2;
+  case LVM_NEQ:
+    return d1 != d2;
+  case LVM_GE:
+    return d1 > d2;
+  case LVM_GEQ:
+    return d1 >= d2;
+  case LVM_LE:
+    return d1 < d2;
+  case LVM_LEQ:
+    return d1 <= d2;
+  default:
+    break;
+  }
+
+  return LVM_EXECUTION_ERROR;
+}
+#endif /* LVM_USE_FLOATS */
+
 static lvm_status_t
 eval_expr(lvm_instance_t *p, operator_t op, operand_t *result)
 {
@@ -192,6 +307,12 @@ eval_expr(lvm_instance_t *p, operator_t op, operand_t *result)
     value[i] = operand_to_long(&operand[i]);
   }
 
+#if LVM_USE_FLOATS
+  if(operand_is_float(&operand[0]) || operand_is_float(&operand[1])) {
+    return eval_float_expr(op, operand, result);
+  }
+#endif /* LVM_USE_FLOATS */
+
   switch(op) {
   case LVM_ADD:
     result_value = value[0] + value[1];
@@ -230,6 +351,10 @@ eval_logic(lvm_instance_t *p, operator_t *op)
   long l1, l2;
   int logic_result[2];
   unsigned arguments;
+#if LVM_USE_FLOATS
+  double float_result[2];
+  int use_float = 0;
+#endif
 
   if(IS_CONNECTIVE(*op)) {
     arguments = *op == LVM_NOT ? 1 : 2;
@@ -271,7 +396,17 @@ eval_logic(lvm_instance_t *p, operator_t *op)
       return LVM_SEMANTIC_ERROR;
     }
     result[i] = operand_to_long(&operand);
+#if LVM_USE_FLOATS
+    float_result[i] = operand_to_double(&operand);
+    use_float |= operand_is_float(&operand);
+#endif
+  }
+
+#if LVM_USE_FLOATS
+  if(use_float) {
+    return eval_float_relation(*op, float_result[0], float_result[1]);
   }
+#endif
 
   l1 = result[0];
   l2 = result[1];
@@ -297,6 +432,236 @@ eval_logic(lvm_instance_t *p, operator_t *op)
   return LVM_EXECUTION_ERROR;
 }
 
+static long
+get_row_value(const unsigned char *ptr, uint8_t size)
+{
+  if(size == 2) {
+    return ptr[0] << 8 | ptr[1];
+  }
+
+  return (uint32_t)ptr[0] << 24 | (uint32_t)ptr[1] << 16 |
+         (uint32_t)ptr[2] << 8 | ptr[3];
+}
+
+static lvm_status_t
+compile_node(lvm_instance_t *p, uint8_t allowed_types)
+{
+  uint8_t index;
+  struct plan_node *node;
+  struct plan_node *second;
+  node_type_t type;
+  operator_t *operator;
+  operand_t operand;
+  variable_t *var;
+  unsigned i;
+  unsigned arguments;
+  lvm_status_t status;
+
+  if(plan_length == LVM_MAX_PLAN_NODES || p->ip >= p->end) {
+    return LVM_STACK_OVERFLOW;
+  }
+
+  index = plan_length++;
+  node = &plan[index];
+
+  type = get_type(p);
+  if(!(type & allowed_types)) {
+    return LVM_SEMANTIC_ERROR;
+  }
+
+  switch(type) {
+  case LVM_CMP_OP:
+  case LVM_ARITH_OP:
+    operator = get_operator(p);
+    node->type = *operator;
+    arguments = *operator == LVM_NOT ? 1 : 2;
+    for(i = 0; i < arguments; i++) {
+      status = compile_node(p, IS_CONNECTIVE(*operator) ? LVM_CMP_OP :
+                               LVM_ARITH_OP | LVM_OPERAND);
+      if(LVM_ERROR(status)) {
+        return status;
+      }
+    }
+
+    if(type != LVM_ARITH_OP) {
+      break;
+    }
+
+    /* Fold arithmetic on constants into a single constant. */
+    second = &plan[plan[index + 1].next];
+    if(plan[index + 1].type == PLAN_LONG && second->type == PLAN_LONG &&
+       !(node->type == LVM_DIV && second->value == 0)) {
+      switch(node->type) {
+      case LVM_ADD:
+        node->value = plan[index + 1].value + second->value;
+        break;
+      case LVM_SUB:
+        node->value = plan[index + 1].value - second->value;
+        break;
+      case LVM_MUL:
+        node->value = plan[index + 1].value * second->value;
+        break;
+      case LVM_DIV:
+        node->value = plan[index + 1].value / second->value;
+        break;
+      default:
+        return LVM_EXECUTION_ERROR;
+      }
+      node->type = PLAN_LONG;
+      plan_length = index + 1;
+    }
+    break;
+  case LVM_OPERAND:
+    get_operand(p, &operand);
+    switch(operand.type) {
+    case LVM_LONG:
+      node->type = PLAN_LONG;
+      node->value = operand.value.l;
+      break;
+#if LVM_USE_FLOATS
+    case LVM_FLOAT:
+      /* Plans compute with longs; leave floats to the interpreter. */
+      return LVM_TYPE_ERROR;
+#endif /* LVM_USE_FLOATS */
+    case LVM_VARIABLE:
+      if(operand.value.id >= LVM_MAX_VARIABLE_ID) {
+        return LVM_INVALID_IDENTIFIER;
+      }
+      var = &variables[operand.value.id];
+      if(var->type == LVM_FLOAT) {
+        return LVM_TYPE_ERROR;
+      }
+      if(var->row_size == 2) {
+        node->type = PLAN_ROW_INT;
+        node->offset = var->row_offset;
+      } else if(var->row_size == 4) {
+        node->type = PLAN_ROW_LONG;
+        node->offset = var->row_offset;
+      } else {
+        node->type = PLAN_VARIABLE;
+        node->offset = operand.value.id;
+      }
+      break;
+    default:
+      return LVM_TYPE_ERROR;
+    }
+    break;
+  default:
+    return LVM_SEMANTIC_ERROR;
+  }
+
+  node->next = plan_length;
+  return LVM_TRUE;
+}
+
+static lvm_status_t
+run_expr(const unsigned char *row, uint8_t index, long *result)
+{
+  struct plan_node *node;
+  long value[2];
+  lvm_status_t status;
+
+  node = &plan[index];
+  switch(node->type) {
+  case PLAN_LONG:
+    *result = node->value;
+    return LVM_TRUE;
+  case PLAN_VARIABLE:
+    *result = variables[node->offset].value.l;
+    return LVM_TRUE;
+  case PLAN_ROW_INT:
+    *result = get_row_value(row + node->offset, 2);
+    return LVM_TRUE;
+  case PLAN_ROW_LONG:
+    *result = get_row_value(row + node->offset, 4);
+    return LVM_TRUE;
+  default:
+    break;
+  }
+
+  status = run_expr(row, index + 1, &value[0]);
+  if(LVM_ERROR(status)) {
+    return status;
+  }
+  status = run_expr(row, plan[index + 1].next, &value[1]);
+  if(LVM_ERROR(status)) {
+    return status;
+  }
+
+  switch(node->type) {
+  case LVM_ADD:
+    *result = value[0] + value[1];
+    break;
+  case LVM_SUB:
+    *result = value[0] - value[1];
+    break;
+  case LVM_MUL:
+    *result = value[0] * value[1];
+    break;
+  case LVM_DIV:
+    if(value[1] == 0) {
+      return LVM_MATH_ERROR;
+    }
+    *result = value[0] / value[1];
+    break;
+  default:
+    return LVM_EXECUTION_ERROR;
+  }
+
+  return LVM_TRUE;
+}
+
+static lvm_status_t
+run_logic(const unsigned char *row, uint8_t index)
+{
+  struct plan_node *node;
+  long value[2];
+  lvm_status_t status;
+
+  node = &plan[index];
+  if(IS_CONNECTIVE(node->type)) {
+    status = run_logic(row, index + 1);
+    if(LVM_ERROR(status) || node->type == LVM_NOT) {
+      return LVM_ERROR(status) ? status : !status;
+    }
+
+    /* Evaluate the second operand only if the first one does not
+       determine the result. */
+    if((node->type == LVM_AND) != (status == LVM_TRUE)) {
+      return status;
+    }
+    return run_logic(row, plan[index + 1].next);
+  }
+
+  status = run_expr(row, index + 1, &value[0]);
+  if(LVM_ERROR(status)) {
+    return status;
+  }
+  status = run_expr(row, plan[index + 1].next, &value[1]);
+  if(LVM_ERROR(status)) {
+    return status;
+  }
+
+  switch(node->type) {
+  case LVM_EQ:
+    return value[0] == value[1];
+  case LVM_NEQ:
+    return value[0] != value[1];
+  case LVM_GE:
+    return value[0] > value[1];
+  case LVM_GEQ:
+    return value[0] >= value[1];
+  case LVM_LE:
+    return value[0] < value[1];
+  case LVM_LEQ:
+    return value[0] <= value[1];
+  default:
+    break;
+  }
+
+  return LVM_EXECUTION_ERROR;
+}
+
 void
 lvm_reset(lvm_instance_t *p, unsigned char *code, lvm_ip_t size)
 {
@@ -309,6 +674,7 @@ lvm_reset(lvm_instance_t *p, unsigned char *code, lvm_ip_t size)
 
   memset(variables, 0, sizeof(variables));
   memset(derivations, 0, sizeof(derivations));
+  plan_length = 0;
 }
 
 lvm_ip_t
@@ -397,6 +763,43 @@ lvm_execute(lvm_instance_t *p)
   return status;
 }
 
+lvm_status_t
+lvm_compile(lvm_instance_t *p)
+{
+  lvm_status_t status;
+
+  plan_length = 0;
+  p->ip = 0;
+  status = compile_node(p, LVM_CMP_OP);
+  p->ip = 0;
+  if(LVM_ERROR(status)) {
+    PRINTF("Failed to compile the code: %d\n", (int)status);
+    plan_length = 0;
+  }
+
+  return status;
+}
+
+lvm_status_t
+lvm_execute_row(lvm_instance_t *p, const unsigned char *row)
+{
+  variable_t *var;
+
+  if(plan_length > 0) {
+    return run_logic(row, 0);
+  }
+
+  /* There is no compiled plan; load the bound variables
+     from the row and interpret the bytecode. */
+  for(var = variables; var < &variables[LVM_MAX_VARIABLE_ID]; var++) {
+    if(var->row_size != 0) {
+      var->value.l = get_row_value(row + var->row_offset, var->row_size);
+    }
+  }
+
+  return lvm_execute(p);
+}
+
 lvm_status_t
 lvm_set_type(lvm_instance_t *p, node_type_t type)
 {
@@ -481,6 +884,19 @@ lvm_set_long(lvm_instance_t *p, long l)
   return lvm_set_operand(p, &op);
 }
 
+#if LVM_USE_FLOATS
+lvm_status_t
+lvm_set_float(lvm_instance_t *p, float f)
+{
+  operand_t op;
+
+  op.type = LVM_FLOAT;
+  op.value.f = f;
+
+  return lvm_set_operand(p, &op);
+}
+#endif /* LVM_USE_FLOATS */
+
 lvm_status_t
 lvm_register_variable(char *name, operand_type_t type)
 {
@@ -516,6 +932,25 @@ lvm_set_variable_value(char *name, operand_value_t value)
   return LVM_TRUE;
 }
 
+lvm_status_t
+lvm_bind_variable(char *name, unsigned offset, unsigned size)
+{
+  variable_id_t id;
+
+  if(size != 0 && size != 2 && size != 4) {
+    return LVM_TYPE_ERROR;
+  }
+
+  id = lookup(name);
+  if(id == LVM_MAX_VARIABLE_ID || variables[id].name[0] == '\0') {
+    return LVM_INVALID_IDENTIFIER;
+  }
+
+  variables[id].row_offset = offset;
+  variables[id].row_size = size;
+  return LVM_TRUE;
+}
+
 lvm_status_t
 lvm_set_variable(lvm_instance_t *p, char *name)
 {
@@ -588,14 +1023,10 @@ create_union(derivation_t *result, derivation_t *d1, derivation_t *d2)
   int i;
 
   for(i = 0; i < LVM_MAX_VARIABLE_ID; i++) {
-    if(!d1[i].derived && !d2[i].derived) {
+    if(!d1[i].derived || !d2[i].derived) {
+      /* One of the operands does not constrain the variable,
+         so neither does the union. */
       continue;
-    } else if(d1[i].derived && !d2[i].derived) {
-      result[i].min.l = d1[i].min.l;
-      result[i].max.l = d1[i].max.l;
-    } else if(!d1[i].derived && d2[i].derived) {
-      result[i].min.l = d2[i].min.l;
-      result[i].max.l = d2[i].max.l;
     } else {
       /* Both derivations have been made; create a
          union of the ranges. */
@@ -696,6 +1127,13 @@ derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
      return LVM_DERIVATION_ERROR;
   }
 
+#if LVM_USE_FLOATS
+  /* The ranges are integral; a float bound is checked on each row. */
+  if(operand_is_float(&operand[0]) || operand_is_float(&operand[1])) {
+    return LVM_DERIVATION_ERROR;
+  }
+#endif
+
   PRINTF("variable id %d, value %ld\n", variable_id, *(long *)value);
 
   derivation = local_derivations + variable_id;
@@ -812,6 +1250,11 @@ print_operand(lvm_instance_t *p, lvm_ip_t index)
   case LVM_LONG:
     PRINTF("long:%ld ", operand.value.l);
     break;
+#if LVM_USE_FLOATS
+  case LVM_FLOAT:
+    PRINTF("float:%f ", (double)operand.value.f);
+    break;
+#endif /* LVM_USE_FLOATS */
   default:
     PRINTF("?? ");
     break;
@@ -899,6 +1342,11 @@ main(void)
 
   lvm_execute(&p);
 
+  /* The same statement evaluated through a compiled plan. */
+  lvm_compile(&p);
+  printf("Compiled plan: %s\n",
+         lvm_execute_row(&p, NULL) == LVM_TRUE ? "true" : "false");
+
   /* Infix: !(9999 + 1 < -1 + 10001) => !(10000 < 10000) => true */
   lvm_reset(&p, code, sizeof(code));
   lvm_set_relation(&p, LVM_NOT);
@@ -984,7 +1432,7 @@ main(void)
   lvm_print_derivations(&p);
 
   /* Infix: (a < 100 /\ a < 90 /\ a > 80 /\ a < 105) \/ b > 10000 =>
-     a:(81,89), b:(10001:oo) */
+     no ranges, since each operand leaves the other variable unconstrained */
   lvm_reset(&p, code, sizeof(code));
   lvm_register_variable("a", LVM_LONG);
   lvm_register_variable("b", LVM_LONG);
@@ -128,8 +128,11 @@ lvm_status_t lvm_get_derived_range(lvm_instance_t *p, char *name,
                                    operand_value_t *max);
 void lvm_print_derivations(lvm_instance_t *p);
 lvm_status_t lvm_execute(lvm_instance_t *p);
+lvm_status_t lvm_compile(lvm_instance_t *p);
+lvm_status_t lvm_execute_row(lvm_instance_t *p, const unsigned char *row);
 lvm_status_t lvm_register_variable(char *name, operand_type_t type);
 lvm_status_t lvm_set_variable_value(char *name, operand_value_t value);
+lvm_status_t lvm_bind_variable(char *name, unsigned offset, unsigned size);
 void lvm_print_code(lvm_instance_t *p);
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p);
 lvm_ip_t lvm_shift_for_operator(lvm_instance_t *p, lvm_ip_t end);
@@ -139,6 +142,9 @@ lvm_status_t lvm_set_op(lvm_instance_t *p, operator_t op);
 lvm_status_t lvm_set_relation(lvm_instance_t *p, operator_t op);
 lvm_status_t lvm_set_operand(lvm_instance_t *p, operand_t *op);
 lvm_status_t lvm_set_long(lvm_instance_t *p, long l);
+#if LVM_USE_FLOATS
+lvm_status_t lvm_set_float(lvm_instance_t *p, float f);
+#endif
 lvm_status_t lvm_set_variable(lvm_instance_t *p, char *name);
 
 #endif /* LVM_H */
@@ -88,6 +88,12 @@ static unsigned char * const left_row = row;
 static unsigned char * const right_row = extra_row;
 static unsigned char * const join_row = result_row;
 
+/* Rows read ahead when scanning a relation sequentially. */
+static unsigned char scan_buffer[DB_SCAN_BUFFER_SIZE];
+static relation_t *scan_rel;
+static tuple_id_t scan_first;
+static unsigned scan_count;
+
 LIST(relations);
 MEMB(relations_memb, relation_t, DB_RELATION_POOL_SIZE);
 MEMB(attributes_memb, attribute_t, DB_ATTRIBUTE_POOL_SIZE);
@@ -636,7 +642,7 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
   operand_value_t max;
   attribute_value_t av_min;
   attribute_value_t av_max;
-  long range;
+  unsigned long range;
   unsigned long min_range;
 
   index = NULL;
@@ -649,20 +655,28 @@ select_index(db_handle_t *handle, lvm_instance_t *lvm_instance)
       attr = attr->next) {
     if(attr->index != NULL &&
        !LVM_ERROR(lvm_get_derived_range(lvm_instance, attr->name, &min, &max))) {
+      if(min.l == LONG_MIN && max.l == LONG_MAX) {
+        /* The predicate does not constrain this attribute. */
+        continue;
+      }
+
       range = (unsigned long)max.l - (unsigned long)min.l;
       PRINTF("DB: The search range for attribute \"%s\" comprises %ld values\n",
              attr->name, range + 1);
 
       if(range <= min_range) {
         index = attr->index;
-        av_min.domain = av_max.domain = DOMAIN_INT;
+        min_range = range;
+        av_min.domain = av_max.domain = DOMAIN_LONG;
         VALUE_LONG(&av_min) = min.l;
         VALUE_LONG(&av_max) = max.l;
       }
     }
   }
 
-  if(index != NULL) {
+  /* Reading the tuples in the order of the index is worthwhile only if
+     the search range comprises fewer values than there are tuples. */
+  if(index != NULL && min_range < relation_cardinality(handle->rel)) {
     /* We found a suitable index; get an iterator for it. */
     if(index_get_iterator(&handle->index_iterator, index, 
                           &av_min, &av_max) == DB_OK) {
@@ -696,7 +710,19 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
     return DB_IMPLEMENTATION_ERROR;
   }
 
+  scan_rel = NULL;
+
   if(adt->lvm_instance != NULL) {
+    /* Let the predicate read the attribute values directly from
+       the rows of the source relation. */
+    for(attr = list_head(rel->attributes); attr != NULL; attr = attr->next) {
+      if(attr->domain == DOMAIN_INT || attr->domain == DOMAIN_LONG) {
+        lvm_bind_variable(attr->name, get_attribute_value_offset(rel, attr),
+                          attr->element_size);
+      }
+    }
+    lvm_compile(adt->lvm_instance);
+
     /* Try to establish acceptable ranges for the attribute values. */
     if(!LVM_ERROR(lvm_derive(adt->lvm_instance))) {
       select_index(handle, adt->lvm_instance);
@@ -731,6 +757,38 @@ relation_process_remove(void *handle_ptr)
 }
 #endif
 
+static db_result_t
+fetch_row(relation_t *rel, tuple_id_t tuple_id, unsigned char **row_ptr)
+{
+  unsigned count;
+  db_result_t result;
+
+  if(rel == scan_rel && tuple_id >= scan_first &&
+     tuple_id < scan_first + scan_count) {
+    *row_ptr = scan_buffer + (tuple_id - scan_first) * rel->row_length;
+    return DB_OK;
+  }
+
+  count = sizeof(scan_buffer) / rel->row_length;
+  if(count <= 1) {
+    *row_ptr = row;
+    return storage_get_row(rel, &tuple_id, row);
+  }
+
+  scan_rel = NULL;
+  result = storage_get_rows(rel, tuple_id, scan_buffer, &count);
+  if(result != DB_OK) {
+    return result;
+  }
+
+  scan_rel = rel;
+  scan_first = tuple_id;
+  scan_count = count;
+  *row_ptr = scan_buffer;
+
+  return DB_OK;
+}
+
 db_result_t
 relation_process_select(void *handle_ptr)
 {
@@ -740,9 +798,9 @@ relation_process_select(void *handle_ptr)
   unsigned attribute_count;
   struct source_dest_map *attr_map_ptr, *attr_map_end;
   attribute_t *result_attr;
+  unsigned char *from_row;
   unsigned char *from_ptr;
   unsigned char *to_ptr;
-  operand_value_t operand_value;
   uint8_t intbuf[2];
   attribute_value_t value;
   lvm_status_t wanted_result;
@@ -756,22 +814,22 @@ relation_process_select(void *handle_ptr)
   if(handle->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
     handle->tuple_id = index_get_next(&handle->index_iterator);
     if(handle->tuple_id == INVALID_TUPLE) {
-      PRINTF("DB: An attribute value could not be found in the index\n");
-      if(handle->index_iterator.next_item_no == 0) {
-        return DB_INDEX_ERROR;
-      }
-
+      PRINTF("DB: No more matching values in the index\n");
       if(adt->flags & AQL_FLAG_AGGREGATE) {
         goto end_aggregation;
       }
 
       return DB_FINISHED;
     }
+
+    /* Rows are fetched in the order of the index, so reading
+       ahead is unlikely to pay off. */
+    from_row = row;
+    result = storage_get_row(handle->rel, &handle->tuple_id, row);
+  } else {
+    result = fetch_row(handle->rel, handle->tuple_id, &from_row);
   }
 
-  /* Put the tuples fulfilling the given condition into a new relation.
-     The tuples may be projected. */
-  result = storage_get_row(handle->rel, &handle->tuple_id, row);
   handle->tuple_id++;
   if(DB_ERROR(result)) {
     PRINTF("DB: Failed to get a row in relation %s!\n", handle->rel->name);
@@ -783,66 +841,47 @@ relation_process_select(void *handle_ptr)
     return DB_FINISHED;
   }
 
-  /* Process the attributes in the result relation. */
-  for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-    from_ptr = row + attr_map_ptr->from_offset;
-    result_attr = attr_map_ptr->to_attr;
-
-    /* Update the internal state of the PLE. */
-    if(result_attr->domain == DOMAIN_INT) {
-      operand_value.l = from_ptr[0] << 8 | from_ptr[1];
-      lvm_set_variable_value(result_attr->name, operand_value);
-    } else if(result_attr->domain == DOMAIN_LONG) {
-      operand_value.l = (uint32_t)from_ptr[0] << 24 |
-                        (uint32_t)from_ptr[1] << 16 |
-                        (uint32_t)from_ptr[2] << 8 |
-                        from_ptr[3];
-      lvm_set_variable_value(result_attr->name, operand_value);
-    }
-
-    if(result_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
-      /* The attribute is used just for the predicate,
-         so do not copy the current value into the result. */
-      continue;
-    }
-
-    if(!(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE)) {
-      /* No aggregators. Copy the original value into the resulting tuple. */
-      memcpy(result_row + attr_map_ptr->to_offset, from_ptr,
-             result_attr->element_size);
-    }
-  }
-
   wanted_result = LVM_TRUE;
   if(AQL_GET_FLAGS(adt) & AQL_FLAG_INVERSE_LOGIC) {
     wanted_result = LVM_FALSE;
   }
 
-  /* Check whether the given predicate is true for this tuple. */
-  if(adt->lvm_instance == NULL ||
-     lvm_execute(adt->lvm_instance) == wanted_result) {
-    if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
-      for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-        from_ptr = row + attr_map_ptr->from_offset;
-        result = db_phy_to_value(&value, attr_map_ptr->to_attr, from_ptr);
-        if(DB_ERROR(result)) {
-	  return result;
-        }
-        aggregate(attr_map_ptr->to_attr, &value);
-      }
-    } else {
-      if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
-        if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
-          PRINTF("DB: Failed to store a row in the result relation!\n");
-          return DB_STORAGE_ERROR;
-        }
+  /* Check whether the given predicate is true for this tuple. The
+     predicate is evaluated on the stored row, so the projected
+     attributes are only copied for matching tuples. */
+  if(adt->lvm_instance != NULL &&
+     lvm_execute_row(adt->lvm_instance, from_row) != wanted_result) {
+    return DB_OK;
+  }
+
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_AGGREGATE) {
+    for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+      from_ptr = from_row + attr_map_ptr->from_offset;
+      result = db_phy_to_value(&value, attr_map_ptr->to_attr, from_ptr);
+      if(DB_ERROR(result)) {
+        return result;
       }
-      handle->current_row++;
-      return DB_GOT_ROW;
+      aggregate(attr_map_ptr->to_attr, &value);
     }
+    return DB_OK;
   }
 
-  return DB_OK;
+  /* Put the tuples fulfilling the given condition into a new relation.
+     The tuples may be projected. */
+  for(attr_map_ptr = attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+    memcpy(result_row + attr_map_ptr->to_offset,
+           from_row + attr_map_ptr->from_offset,
+           attr_map_ptr->to_attr->element_size);
+  }
+
+  if(AQL_GET_FLAGS(adt) & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(handle->result_rel, result_row))) {
+      PRINTF("DB: Failed to store a row in the result relation!\n");
+      return DB_STORAGE_ERROR;
+    }
+  }
+  handle->current_row++;
+  return DB_GOT_ROW;
 
 end_aggregation:
   /* Generate aggregated result if requested. */
@@ -916,6 +955,12 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     PRINTF("DB: Found attribute %s in relation %s\n",
 	attribute_name, rel->name);
 
+    if(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE) {
+      /* The predicate reads this attribute from the source rows,
+         so it is not needed in the result. */
+      continue;
+    }
+
     attr = relation_attribute_add(handle->result_rel, dir,
 				  attribute_name, 
 				  adt->aggregators[i] ? DOMAIN_INT : attr->domain,
@@ -929,10 +974,7 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
     attr->aggregator = adt->aggregators[i];
     switch(attr->aggregator) {
     case AQL_NONE:
-      if(!(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE)) {
-        /* Only count attributes projected into the result set. */
-        normal_attributes++;
-      }
+      normal_attributes++;
       break;
     case AQL_MAX:
       attr->aggregation_value = LONG_MIN;
@@ -402,24 +402,39 @@ storage_put_index(index_t *index)
 
 db_result_t
 storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
+{
+  unsigned count;
+
+  count = 1;
+  return storage_get_rows(rel, *tuple_id, row, &count);
+}
+
+db_result_t
+storage_get_rows(relation_t *rel, tuple_id_t tuple_id, storage_row_t rows,
+                 unsigned *count)
 {
   int r;
   tuple_id_t nrows;
+  unsigned i;
 
   if(DB_ERROR(storage_get_row_amount(rel, &nrows))) {
     return DB_STORAGE_ERROR;
   }
 
-  if(*tuple_id >= nrows) {
+  if(tuple_id >= nrows) {
     return DB_FINISHED;
   }
 
-  if(cfs_seek(rel->tuple_storage, *tuple_id * rel->row_length, CFS_SEEK_SET) ==
+  if(*count > nrows - tuple_id) {
+    *count = nrows - tuple_id;
+  }
+
+  if(cfs_seek(rel->tuple_storage, tuple_id * rel->row_length, CFS_SEEK_SET) ==
               (cfs_offset_t)-1) {
     return DB_STORAGE_ERROR;
   }
 
-  r = cfs_read(rel->tuple_storage, row, rel->row_length);
+  r = cfs_read(rel->tuple_storage, rows, *count * rel->row_length);
   if(r < 0) {
     PRINTF("DB: Reading failed on fd %d\n", rel->tuple_storage);
     return DB_STORAGE_ERROR;
@@ -430,9 +445,12 @@ storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t row)
     return DB_STORAGE_ERROR;
   }
 
-  row[rel->row_length - 1] ^= ROW_XOR;
+  *count = r / rel->row_length;
+  for(i = 1; i <= *count; i++) {
+    rows[i * rel->row_length - 1] ^= ROW_XOR;
+  }
 
-  PRINTF("DB: Read %d bytes from relation %s\n", rel->row_length, rel->name);
+  PRINTF("DB: Read %d bytes from relation %s\n", r, rel->name);
 
   return DB_OK;
 }
@@ -84,6 +84,99 @@
 #define COFFEE_EXTENDED_WEAR_LEVELLING  1
 #endif
 
+/*
+ * The name index maps hashed file names to the start pages of active
+ * files, so that opening a file does not require a sequential scan of
+ * the page headers. The index is built on first use and maintained
+ * when files are reserved and removed. If there are more files than
+ * index entries, lookups fall back to scanning the storage on a miss.
+ * Each entry requires sizeof(coffee_page_t) + 2 bytes of RAM.
+ */
+#ifndef COFFEE_NAME_INDEX_SIZE
+#define COFFEE_NAME_INDEX_SIZE  8
+#endif
+
+/*
+ * The header cache keeps copies of recently read page headers, which
+ * are read repeatedly when looking up files and when accessing files
+ * that have a micro log. The cache is write-through, so that it never
+ * holds data that differs from the storage.
+ */
+#ifndef COFFEE_HEADER_CACHE_SIZE
+#define COFFEE_HEADER_CACHE_SIZE  4
+#endif
+
+/* Count storage accesses; see cfs_coffee_get_stats(). */
+#ifndef COFFEE_STATS
+#define COFFEE_STATS  0
+#endif
+
+/*
+ * The incremental garbage collector reclaims sectors in bounded steps,
+ * which are taken by calling cfs_coffee_gc_step() or by running
+ * coffee_gc_process. This reduces the need for the synchronous garbage
+ * collection that otherwise runs when a file reservation fails.
+ */
+#ifndef COFFEE_INCREMENTAL_GC
+#define COFFEE_INCREMENTAL_GC  0
+#endif
+
+/*
+ * The minimum number of obsolete pages in a sector for the incremental
+ * garbage collector to erase it. Erasing sectors with few obsolete pages
+ * reclaims little space and wears the storage unnecessarily.
+ */
+#ifndef COFFEE_GC_MIN_OBSOLETE
+#define COFFEE_GC_MIN_OBSOLETE  (COFFEE_PAGES_PER_SECTOR / 2)
+#endif
+
+/*
+ * The weight of the erase count when the incremental garbage collector
+ * selects a sector. Each erase that a sector has undergone counts
+ * against it as much as this amount of obsolete pages per 256 pages.
+ */
+#ifndef COFFEE_GC_WEAR_WEIGHT
+#define COFFEE_GC_WEAR_WEIGHT  8
+#endif
+
+/*
+ * Sector headers reserve the first page of each sector for the number
+ * of times that the sector has been erased, which is rewritten after
+ * each erasure. The erase counts thus persist across reboots and
+ * formatting, and the incremental garbage collector uses them to level
+ * the wear. This changes the storage layout, so the storage must be
+ * formatted when the setting is changed.
+ */
+#ifndef COFFEE_SECTOR_HEADERS
+#define COFFEE_SECTOR_HEADERS  COFFEE_INCREMENTAL_GC
+#endif
+
+/*
+ * Write buffers coalesce small sequential writes through file
+ * descriptors that have the CFS_COFFEE_IO_WRITE_BUFFER semantics. This
+ * reduces the number of storage writes, and, for files with a micro
+ * log, the number of log records and log merges. Each buffer requires
+ * COFFEE_WRITE_BUFFER_SIZE bytes of RAM, and should preferably be at
+ * least as large as the log record size of the buffered files.
+ */
+#ifndef COFFEE_WRITE_BUFFERS
+#define COFFEE_WRITE_BUFFERS  0
+#endif
+
+#ifndef COFFEE_WRITE_BUFFER_SIZE
+#define COFFEE_WRITE_BUFFER_SIZE  COFFEE_PAGE_SIZE
+#endif
+
+/*
+ * The maximum time in clock ticks that data may stay in a write buffer
+ * before it is written to the storage. If set to 0, buffers are only
+ * flushed when full, when the file descriptor is closed, read from, or
+ * seeked in, and when cfs_coffee_flush() or cfs_coffee_sync() is called.
+ */
+#ifndef COFFEE_WRITE_BUFFER_TIMEOUT
+#define COFFEE_WRITE_BUFFER_TIMEOUT  0
+#endif
+
 #if COFFEE_START & (COFFEE_SECTOR_SIZE - 1)
 #error COFFEE_START must point to the first byte in a sector.
 #endif
@@ -148,16 +241,28 @@
 /* Shortcuts derived from the hardware-dependent configuration of Coffee. */
 #define COFFEE_SECTOR_COUNT \
   (coffee_page_t)(COFFEE_SIZE / COFFEE_SECTOR_SIZE)
+#if COFFEE_SECTOR_HEADERS
+/* The pages of Coffee exclude the header page of each sector. */
+#define COFFEE_PAGES_PER_SECTOR \
+  ((coffee_page_t)(COFFEE_SECTOR_SIZE / COFFEE_PAGE_SIZE - 1))
+#define COFFEE_PAGE_COUNT \
+  ((coffee_page_t)(COFFEE_SECTOR_COUNT * COFFEE_PAGES_PER_SECTOR))
+#define COFFEE_SECTOR_DATA_SIZE \
+  ((cfs_offset_t)COFFEE_PAGES_PER_SECTOR * COFFEE_PAGE_SIZE)
+#else
 #define COFFEE_PAGE_COUNT \
   ((coffee_page_t)(COFFEE_SIZE / COFFEE_PAGE_SIZE))
 #define COFFEE_PAGES_PER_SECTOR \
   ((coffee_page_t)(COFFEE_SECTOR_SIZE / COFFEE_PAGE_SIZE))
+#endif /* COFFEE_SECTOR_HEADERS */
 
 /* This structure is used for garbage collection statistics. */
 struct sector_status {
   coffee_page_t active;
   coffee_page_t obsolete;
   coffee_page_t free;
+  /* Obsolete pages of an extent starting in a previous sector. */
+  coffee_page_t inherited;
 };
 
 /* The structure of cached file objects. */
@@ -197,6 +302,42 @@ struct log_param {
   uint16_t size;
 };
 
+#if COFFEE_NAME_INDEX_SIZE > 0
+/* An entry in the name index. Free entries have the page INVALID_PAGE. */
+struct name_index_entry {
+  coffee_page_t page;
+  uint16_t hash;
+};
+
+/* States of the name index. */
+#define NAME_INDEX_UNBUILT    0
+#define NAME_INDEX_COMPLETE   1
+#define NAME_INDEX_PARTIAL    2
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
+
+#if COFFEE_HEADER_CACHE_SIZE > 0
+/* An entry in the header cache. */
+struct header_cache_entry {
+  struct file_header hdr;
+  coffee_page_t page;
+  uint8_t used;
+};
+#endif /* COFFEE_HEADER_CACHE_SIZE > 0 */
+
+#if COFFEE_WRITE_BUFFERS > 0
+/* A write buffer, which holds data to be written at a file offset. */
+struct write_buffer {
+#if COFFEE_WRITE_BUFFER_TIMEOUT > 0
+  struct ctimer timer;
+#endif
+  cfs_offset_t offset;
+  uint16_t length;
+  int8_t fd;
+  uint8_t used;
+  char data[COFFEE_WRITE_BUFFER_SIZE];
+};
+#endif /* COFFEE_WRITE_BUFFERS > 0 */
+
 /*
  * Variables that keep track of opened files and internal
  * optimization information for Coffee.
@@ -206,23 +347,245 @@ static struct file_desc coffee_fd_set[COFFEE_FD_SET_SIZE];
 static coffee_page_t next_free;
 static char gc_wait;
 
+#if COFFEE_NAME_INDEX_SIZE > 0
+static struct name_index_entry name_index[COFFEE_NAME_INDEX_SIZE];
+static uint8_t name_index_state;
+#endif
+
+#if COFFEE_HEADER_CACHE_SIZE > 0
+static struct header_cache_entry header_cache[COFFEE_HEADER_CACHE_SIZE];
+static uint8_t header_cache_next;
+#endif
+
+#if COFFEE_WRITE_BUFFERS > 0
+static struct write_buffer write_buffers[COFFEE_WRITE_BUFFERS];
+#endif
+
+#if COFFEE_INCREMENTAL_GC
+/* The state of the incremental garbage collector between steps. */
+static struct {
+  coffee_page_t sector;
+  coffee_page_t candidate;
+  coffee_page_t candidate_isolation;
+  coffee_page_t candidate_inherited;
+  int32_t candidate_score;
+} incremental_gc;
+
+PROCESS(coffee_gc_process, "Coffee GC");
+#endif /* COFFEE_INCREMENTAL_GC */
+
+#if COFFEE_STATS
+static struct cfs_coffee_stats coffee_stats;
+#define STATS_ADD(field, value) coffee_stats.field += (value)
+#else
+#define STATS_ADD(field, value)
+#endif
+
+/*---------------------------------------------------------------------------*/
+#if COFFEE_SECTOR_HEADERS
+/*
+ * Returns the storage offset of a Coffee offset, and sets size to the
+ * number of bytes that can be accessed there before the next sector
+ * header.
+ */
+static cfs_offset_t
+sector_data_offset(cfs_offset_t offset, cfs_offset_t *size)
+{
+  cfs_offset_t remaining;
+
+  remaining = COFFEE_SECTOR_DATA_SIZE - offset % COFFEE_SECTOR_DATA_SIZE;
+  if(*size > remaining) {
+    *size = remaining;
+  }
+  return (offset / COFFEE_SECTOR_DATA_SIZE) * COFFEE_SECTOR_SIZE +
+    COFFEE_PAGE_SIZE + offset % COFFEE_SECTOR_DATA_SIZE;
+}
+#endif /* COFFEE_SECTOR_HEADERS */
+/*---------------------------------------------------------------------------*/
+static void
+storage_read(void *buf, cfs_offset_t size, cfs_offset_t offset)
+{
+#if COFFEE_SECTOR_HEADERS
+  cfs_offset_t chunk;
+#endif
+
+  STATS_ADD(reads, 1);
+  STATS_ADD(read_bytes, size);
+#if COFFEE_SECTOR_HEADERS
+  for(; size > 0; size -= chunk, offset += chunk) {
+    chunk = size;
+    COFFEE_READ(buf, chunk, sector_data_offset(offset, &chunk));
+    buf = (char *)buf + chunk;
+  }
+#else
+  COFFEE_READ(buf, size, offset);
+#endif /* COFFEE_SECTOR_HEADERS */
+}
+/*---------------------------------------------------------------------------*/
+static void
+storage_write(const void *buf, cfs_offset_t size, cfs_offset_t offset)
+{
+#if COFFEE_SECTOR_HEADERS
+  cfs_offset_t chunk;
+#endif
+
+  STATS_ADD(writes, 1);
+  STATS_ADD(written_bytes, size);
+#if COFFEE_SECTOR_HEADERS
+  for(; size > 0; size -= chunk, offset += chunk) {
+    chunk = size;
+    COFFEE_WRITE(buf, chunk, sector_data_offset(offset, &chunk));
+    buf = (const char *)buf + chunk;
+  }
+#else
+  COFFEE_WRITE(buf, size, offset);
+#endif /* COFFEE_SECTOR_HEADERS */
+}
+/*---------------------------------------------------------------------------*/
+/* The erase count is kept at the start of the header page of a sector. */
+static uint32_t
+read_erase_count(coffee_page_t sector)
+{
+#if COFFEE_SECTOR_HEADERS
+  uint32_t erase_count;
+
+  STATS_ADD(reads, 1);
+  STATS_ADD(read_bytes, sizeof(erase_count));
+  COFFEE_READ(&erase_count, sizeof(erase_count),
+              (cfs_offset_t)sector * COFFEE_SECTOR_SIZE);
+  return erase_count;
+#else
+  return 0;
+#endif /* COFFEE_SECTOR_HEADERS */
+}
+/*---------------------------------------------------------------------------*/
+static void
+storage_erase(coffee_page_t sector)
+{
+#if COFFEE_HEADER_CACHE_SIZE > 0
+  int i;
+#endif
+#if COFFEE_SECTOR_HEADERS
+  uint32_t erase_count;
+#endif
+
+#if COFFEE_HEADER_CACHE_SIZE > 0
+  for(i = 0; i < COFFEE_HEADER_CACHE_SIZE; i++) {
+    if(header_cache[i].page / COFFEE_PAGES_PER_SECTOR == sector) {
+      header_cache[i].used = 0;
+    }
+  }
+#endif /* COFFEE_HEADER_CACHE_SIZE > 0 */
+
+#if COFFEE_SECTOR_HEADERS
+  erase_count = read_erase_count(sector) + 1;
+#endif
+  STATS_ADD(erases, 1);
+  COFFEE_ERASE(sector);
+#if COFFEE_SECTOR_HEADERS
+  STATS_ADD(writes, 1);
+  STATS_ADD(written_bytes, sizeof(erase_count));
+  COFFEE_WRITE(&erase_count, sizeof(erase_count),
+               (cfs_offset_t)sector * COFFEE_SECTOR_SIZE);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+#if COFFEE_HEADER_CACHE_SIZE > 0
+static struct header_cache_entry *
+header_cache_lookup(coffee_page_t page)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_HEADER_CACHE_SIZE; i++) {
+    if(header_cache[i].used && header_cache[i].page == page) {
+      return &header_cache[i];
+    }
+  }
+  return NULL;
+}
+#endif /* COFFEE_HEADER_CACHE_SIZE > 0 */
 /*---------------------------------------------------------------------------*/
 static void
 write_header(struct file_header *hdr, coffee_page_t page)
 {
+#if COFFEE_HEADER_CACHE_SIZE > 0
+  struct header_cache_entry *entry;
+#endif
+
   hdr->flags |= HDR_FLAG_VALID;
-  COFFEE_WRITE(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+  storage_write(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+
+#if COFFEE_HEADER_CACHE_SIZE > 0
+  /* Headers are only cached when read, but cached copies must be updated. */
+  entry = header_cache_lookup(page);
+  if(entry != NULL) {
+    memcpy(&entry->hdr, hdr, sizeof(entry->hdr));
+  }
+#endif
 }
 /*---------------------------------------------------------------------------*/
 static void
 read_header(struct file_header *hdr, coffee_page_t page)
 {
-  COFFEE_READ(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+#if COFFEE_HEADER_CACHE_SIZE > 0
+  struct header_cache_entry *entry;
+
+  entry = header_cache_lookup(page);
+  if(entry != NULL) {
+    STATS_ADD(header_cache_hits, 1);
+    memcpy(hdr, &entry->hdr, sizeof(*hdr));
+    return;
+  }
+  STATS_ADD(header_cache_misses, 1);
+#endif /* COFFEE_HEADER_CACHE_SIZE > 0 */
+
+  storage_read(hdr, sizeof(*hdr), page * COFFEE_PAGE_SIZE);
+
+#if COFFEE_HEADER_CACHE_SIZE > 0
+  /* Free pages are not cached, since a scan reads many of them only once. */
+  if(HDR_ALLOCATED(*hdr)) {
+    entry = &header_cache[header_cache_next];
+    header_cache_next = (header_cache_next + 1) % COFFEE_HEADER_CACHE_SIZE;
+    memcpy(&entry->hdr, hdr, sizeof(entry->hdr));
+    entry->page = page;
+    entry->used = 1;
+  }
+#endif /* COFFEE_HEADER_CACHE_SIZE > 0 */
+
   if(DEBUG && HDR_ACTIVE(*hdr) && !HDR_VALID(*hdr)) {
     PRINTF("Coffee: Invalid header at page %u!\n", (unsigned)page);
   }
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_WRITE_BUFFERS > 0
+static struct write_buffer *
+get_write_buffer(int fd)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_WRITE_BUFFERS; i++) {
+    if(write_buffers[i].used && write_buffers[i].fd == fd) {
+      return &write_buffers[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+release_write_buffer(struct write_buffer *wb)
+{
+  /* Any buffered data is discarded. */
+  if(wb != NULL) {
+#if COFFEE_WRITE_BUFFER_TIMEOUT > 0
+    ctimer_stop(&wb->timer);
+#endif
+    wb->used = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int flush_write_buffer(struct write_buffer *wb);
+#endif /* COFFEE_WRITE_BUFFERS > 0 */
+/*---------------------------------------------------------------------------*/
 static cfs_offset_t
 absolute_offset(coffee_page_t page, cfs_offset_t offset)
 {
@@ -269,11 +632,11 @@ get_sector_status(coffee_page_t sector, struct sector_status *stats)
     active = skip_pages;
   } else {
     if(skip_pages >= COFFEE_PAGES_PER_SECTOR) {
-      stats->obsolete = COFFEE_PAGES_PER_SECTOR;
+      stats->obsolete = stats->inherited = COFFEE_PAGES_PER_SECTOR;
       skip_pages -= COFFEE_PAGES_PER_SECTOR;
       return skip_pages >= COFFEE_PAGES_PER_SECTOR ? 0 : skip_pages;
     }
-    obsolete = skip_pages;
+    obsolete = stats->inherited = skip_pages;
   }
 
   /* Determine the amount of pages of each type that have not been
@@ -349,41 +712,95 @@ isolate_pages(coffee_page_t start, coffee_page_t skip_pages)
 }
 /*---------------------------------------------------------------------------*/
 static void
+erase_sector(coffee_page_t sector, coffee_page_t isolation_count,
+             coffee_page_t inherited)
+{
+  coffee_page_t first_page;
+
+  /*
+   * Free pages must always extend to the end of a sector, so pages
+   * may not be allocated after the start of an erased sector before
+   * the pages preceding them. When the search for free pages wraps
+   * around, only an allocation point within the sector must be moved.
+   */
+  first_page = sector * COFFEE_PAGES_PER_SECTOR;
+  if(first_page < next_free &&
+     (!COFFEE_INCREMENTAL_GC ||
+      next_free < first_page + COFFEE_PAGES_PER_SECTOR)) {
+    next_free = first_page;
+  }
+
+  if(isolation_count > 0) {
+    isolate_pages(first_page + COFFEE_PAGES_PER_SECTOR, isolation_count);
+  }
+
+  storage_erase(sector);
+  PRINTF("Coffee: Erased sector %d!\n", sector);
+
+  /*
+   * If an obsolete extent starting in a previous sector, which is not
+   * erased, reaches into this sector, its pages must remain allocated.
+   * Otherwise, new files could be reserved in them, and sequential
+   * scans that skip over the extent would miss the new file headers.
+   */
+  if(inherited > 0) {
+    isolate_pages(first_page, inherited);
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if COFFEE_INCREMENTAL_GC
+static void
+incremental_gc_restart(void)
+{
+  /*
+   * The scan must restart whenever the sector status may have changed
+   * in a way that makes a candidate unsafe to erase, and whenever
+   * get_sector_status() has been called by someone else.
+   */
+  incremental_gc.sector = 0;
+  incremental_gc.candidate = INVALID_PAGE;
+}
+#endif /* COFFEE_INCREMENTAL_GC */
+/*---------------------------------------------------------------------------*/
+static void
 collect_garbage(int mode)
 {
   coffee_page_t sector;
   struct sector_status stats;
-  coffee_page_t first_page, isolation_count;
+  coffee_page_t isolation_count, inherited;
+  int previous_erased;
 
   PRINTF("Coffee: Running the garbage collector in %s mode\n",
          mode == GC_RELUCTANT ? "reluctant" : "greedy");
+  STATS_ADD(gc_runs, 1);
+#if COFFEE_INCREMENTAL_GC
+  incremental_gc_restart();
+#endif
+
   /*
    * The garbage collector erases as many sectors as possible. A sector is
    * erasable if there are only free or obsolete pages in it.
    */
+  previous_erased = 0;
   for(sector = 0; sector < COFFEE_SECTOR_COUNT; sector++) {
     isolation_count = get_sector_status(sector, &stats);
     PRINTF("Coffee: Sector %u has %u active, %u obsolete, and %u free pages.\n",
            (unsigned)sector, (unsigned)stats.active,
            (unsigned)stats.obsolete, (unsigned)stats.free);
 
-    if(stats.active > 0) {
+    /* Inherited pages are of no concern if the sector in which their
+       extent starts has been erased in this pass. */
+    inherited = previous_erased ? 0 : stats.inherited;
+    previous_erased = 0;
+
+    if(stats.active > 0 || inherited >= COFFEE_PAGES_PER_SECTOR) {
       continue;
     }
 
     if((mode == GC_RELUCTANT && stats.free == 0) ||
        (mode == GC_GREEDY && stats.obsolete > 0)) {
-      first_page = sector * COFFEE_PAGES_PER_SECTOR;
-      if(first_page < next_free) {
-        next_free = first_page;
-      }
-
-      if(isolation_count > 0) {
-        isolate_pages(first_page + COFFEE_PAGES_PER_SECTOR, isolation_count);
-      }
-
-      COFFEE_ERASE(sector);
-      PRINTF("Coffee: Erased sector %d!\n", sector);
+      erase_sector(sector, isolation_count, inherited);
+      previous_erased = 1;
 
       if(mode == GC_RELUCTANT && isolation_count > 0) {
         break;
@@ -406,7 +823,7 @@ next_file(coffee_page_t page, struct file_header *hdr)
    * always shorter than a sector.
    */
   if(HDR_FREE(*hdr)) {
-    return (page + COFFEE_PAGES_PER_SECTOR) & ~(COFFEE_PAGES_PER_SECTOR - 1);
+    return (page / COFFEE_PAGES_PER_SECTOR + 1) * COFFEE_PAGES_PER_SECTOR;
   } else if(HDR_ISOLATED(*hdr)) {
     return page + 1;
   }
@@ -452,12 +869,145 @@ load_file(coffee_page_t start, struct file_header *hdr)
   return file;
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_NAME_INDEX_SIZE > 0
+static uint16_t
+name_hash(const char *name)
+{
+  uint16_t hash;
+  int i;
+
+  /* Only the part of the name that fits in a file header is hashed. */
+  hash = 5381;
+  for(i = 0; i < COFFEE_NAME_LENGTH - 1 && name[i] != '\0'; i++) {
+    hash = (hash << 5) + hash + (uint8_t)name[i];
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+static void
+name_index_add(const char *name, coffee_page_t page)
+{
+  int i;
+
+  if(name_index_state == NAME_INDEX_UNBUILT) {
+    return;
+  }
+
+  for(i = 0; i < COFFEE_NAME_INDEX_SIZE; i++) {
+    if(name_index[i].page == INVALID_PAGE) {
+      name_index[i].page = page;
+      name_index[i].hash = name_hash(name);
+      return;
+    }
+  }
+
+  /* The index is full, so misses must be resolved by scanning. */
+  name_index_state = NAME_INDEX_PARTIAL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+name_index_remove(coffee_page_t page)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_NAME_INDEX_SIZE; i++) {
+    if(name_index[i].page == page) {
+      name_index[i].page = INVALID_PAGE;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+name_index_reset(uint8_t state)
+{
+  int i;
+
+  for(i = 0; i < COFFEE_NAME_INDEX_SIZE; i++) {
+    name_index[i].page = INVALID_PAGE;
+  }
+  name_index_state = state;
+}
+/*---------------------------------------------------------------------------*/
+static void
+name_index_build(void)
+{
+  struct file_header hdr;
+  coffee_page_t page;
+
+  name_index_reset(NAME_INDEX_COMPLETE);
+
+  for(page = 0; page < COFFEE_PAGE_COUNT; page = next_file(page, &hdr)) {
+    read_header(&hdr, page);
+    if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr)) {
+      name_index_add(hdr.name, page);
+    }
+  }
+
+  PRINTF("Coffee: Built the name index (%s)\n",
+         name_index_state == NAME_INDEX_COMPLETE ? "complete" : "partial");
+}
+/*---------------------------------------------------------------------------*/
+static struct file *
+name_index_find(const char *name, uint8_t *resolved)
+{
+  struct file_header hdr;
+  uint16_t hash;
+  int i, j;
+
+  *resolved = 0;
+
+  if(name_index_state == NAME_INDEX_UNBUILT) {
+    name_index_build();
+  }
+
+  hash = name_hash(name);
+  for(i = 0; i < COFFEE_NAME_INDEX_SIZE; i++) {
+    if(name_index[i].page == INVALID_PAGE || name_index[i].hash != hash) {
+      continue;
+    }
+
+    /* The hash matches, but the name must be checked for collisions. */
+    read_header(&hdr, name_index[i].page);
+    if(!HDR_ACTIVE(hdr) || HDR_LOG(hdr) || strcmp(name, hdr.name) != 0) {
+      continue;
+    }
+
+    STATS_ADD(index_hits, 1);
+    *resolved = 1;
+    for(j = 0; j < COFFEE_MAX_OPEN_FILES; j++) {
+      if(!FILE_FREE(&coffee_files[j]) &&
+         coffee_files[j].page == name_index[i].page) {
+        return &coffee_files[j];
+      }
+    }
+    return load_file(name_index[i].page, &hdr);
+  }
+
+  STATS_ADD(index_misses, 1);
+  if(name_index_state == NAME_INDEX_COMPLETE) {
+    /* The index covers all files, so the file does not exist. */
+    *resolved = 1;
+  }
+  return NULL;
+}
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
 static struct file *
 find_file(const char *name)
 {
   int i;
   struct file_header hdr;
   coffee_page_t page;
+#if COFFEE_NAME_INDEX_SIZE > 0
+  struct file *file;
+  uint8_t resolved;
+
+  file = name_index_find(name, &resolved);
+  if(resolved) {
+    return file;
+  }
+#endif /* COFFEE_NAME_INDEX_SIZE > 0 */
 
   /* First check if the file metadata is cached. */
   for(i = 0; i < COFFEE_MAX_OPEN_FILES; i++) {
@@ -501,7 +1051,7 @@ file_end(coffee_page_t start)
    */
 
   for(page = hdr.max_pages - 1; page >= 0; page--) {
-    COFFEE_READ(buf, sizeof(buf), (start + page) * COFFEE_PAGE_SIZE);
+    storage_read(buf, sizeof(buf), (start + page) * COFFEE_PAGE_SIZE);
     for(i = COFFEE_PAGE_SIZE - 1; i >= 0; i--) {
       if(buf[i] != 0) {
         if(page == 0 && i < sizeof(hdr)) {
@@ -517,13 +1067,13 @@ file_end(coffee_page_t start)
 }
 /*---------------------------------------------------------------------------*/
 static coffee_page_t
-find_contiguous_pages(coffee_page_t amount)
+find_free_pages(coffee_page_t from, coffee_page_t to, coffee_page_t amount)
 {
   coffee_page_t page, start;
   struct file_header hdr;
 
   start = INVALID_PAGE;
-  for(page = next_free; page < COFFEE_PAGE_COUNT;) {
+  for(page = from; page < to;) {
     read_header(&hdr, page);
     if(HDR_FREE(hdr)) {
       if(start == INVALID_PAGE) {
@@ -552,6 +1102,29 @@ find_contiguous_pages(coffee_page_t amount)
   return INVALID_PAGE;
 }
 /*---------------------------------------------------------------------------*/
+static coffee_page_t
+find_contiguous_pages(coffee_page_t amount)
+{
+  coffee_page_t start;
+
+  start = find_free_pages(next_free, COFFEE_PAGE_COUNT, amount);
+#if COFFEE_INCREMENTAL_GC
+  /*
+   * The incremental garbage collector does not move the allocation
+   * point backwards when erasing sectors. Instead, the search wraps
+   * around, so that the storage is written as a circular log and the
+   * erasures are spread evenly across the sectors.
+   */
+  if(start == INVALID_PAGE && next_free > 0) {
+    start = find_free_pages(0, next_free, amount);
+    if(start != INVALID_PAGE) {
+      next_free = start + amount;
+    }
+  }
+#endif /* COFFEE_INCREMENTAL_GC */
+  return start;
+}
+/*---------------------------------------------------------------------------*/
 static int
 remove_by_page(coffee_page_t page, int remove_log,
 	       int close_fds, int gc_allowed)
@@ -572,6 +1145,9 @@ remove_by_page(coffee_page_t page, int remove_log,
 
   hdr.flags |= HDR_FLAG_OBSOLETE;
   write_header(&hdr, page);
+#if COFFEE_NAME_INDEX_SIZE > 0
+  name_index_remove(page);
+#endif
 
   gc_wait = 0;
 
@@ -580,6 +1156,9 @@ remove_by_page(coffee_page_t page, int remove_log,
     for(i = 0; i < COFFEE_FD_SET_SIZE; i++) {
       if(coffee_fd_set[i].file != NULL && coffee_fd_set[i].file->page == page) {
         coffee_fd_set[i].flags = COFFEE_FD_FREE;
+#if COFFEE_WRITE_BUFFERS > 0
+        release_write_buffer(get_write_buffer(i));
+#endif
       }
     }
   }
@@ -596,6 +1175,12 @@ remove_by_page(coffee_page_t page, int remove_log,
     collect_garbage(GC_RELUCTANT);
   }
 
+#if COFFEE_INCREMENTAL_GC
+  if(process_is_running(&coffee_gc_process)) {
+    process_poll(&coffee_gc_process);
+  }
+#endif
+
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -636,6 +1221,15 @@ reserve(const char *name, coffee_page_t pages,
   hdr.max_pages = pages;
   hdr.flags = HDR_FLAG_ALLOCATED | flags;
   write_header(&hdr, page);
+#if COFFEE_INCREMENTAL_GC
+  /* The reserved pages may belong to a sector selected for erasure. */
+  incremental_gc_restart();
+#endif
+#if COFFEE_NAME_INDEX_SIZE > 0
+  if(!(flags & HDR_FLAG_LOG)) {
+    name_index_add(name, page);
+  }
+#endif
 
   PRINTF("Coffee: Reserved %u pages starting from %u for file %s\n",
          (unsigned)pages, (unsigned)page, name);
@@ -703,7 +1297,7 @@ get_record_index(coffee_page_t log_page, uint16_t search_records,
       }
 
       base -= batch_size * sizeof(indices[0]);
-      COFFEE_READ(&indices, sizeof(indices[0]) * batch_size, base);
+      storage_read(&indices, sizeof(indices[0]) * batch_size, base);
 
       for(i = batch_size - 1; i >= 0; i--) {
         if(indices[i] - 1 == region) {
@@ -744,7 +1338,7 @@ read_log_page(struct file_header *hdr, int16_t record_count,
   base = absolute_offset(hdr->log_page, log_records * sizeof(region));
   base += (cfs_offset_t)match_index * log_record_size;
   base += lp->offset;
-  COFFEE_READ(lp->buf, lp->size, base);
+  storage_read(lp->buf, lp->size, base);
 
   return lp->size;
 }
@@ -814,7 +1408,7 @@ merge_log(coffee_page_t file_page, int extend)
       cfs_close(fd);
       return -1;
     } else if(n > 0) {
-      COFFEE_WRITE(buf, n, absolute_offset(new_file->page, offset));
+      storage_write(buf, n, absolute_offset(new_file->page, offset));
       offset += n;
     }
   } while(n != 0);
@@ -871,7 +1465,7 @@ find_next_record(struct file *file, coffee_page_t log_page,
       batch_size = log_records - processed >= preferred_batch_size ?
         preferred_batch_size : log_records - processed;
 
-      COFFEE_READ(&indices, batch_size * sizeof(indices[0]),
+      storage_read(&indices, batch_size * sizeof(indices[0]),
                   absolute_offset(log_page, processed * sizeof(indices[0])));
       for(log_record = 0; log_record < batch_size; log_record++) {
         if(indices[log_record] == 0) {
@@ -935,7 +1529,7 @@ write_log_page(struct file *file, struct log_param *lp)
 
     if((lp->offset > 0 || lp->size != log_record_size) &&
        read_log_page(&hdr, log_record, &lp_out) < 0) {
-      COFFEE_READ(copy_buf, sizeof(copy_buf),
+      storage_read(copy_buf, sizeof(copy_buf),
                   absolute_offset(file->page, offset));
     }
 
@@ -947,11 +1541,11 @@ write_log_page(struct file *file, struct log_param *lp)
      */
     offset = absolute_offset(log_page, 0);
     ++region;
-    COFFEE_WRITE(&region, sizeof(region),
+    storage_write(&region, sizeof(region),
                  offset + log_record * sizeof(region));
 
     offset += log_records * sizeof(region);
-    COFFEE_WRITE(copy_buf, sizeof(copy_buf),
+    storage_write(copy_buf, sizeof(copy_buf),
                  offset + log_record * log_record_size);
     file->record_count = log_record + 1;
   }
@@ -1010,14 +1604,32 @@ cfs_open(const char *name, int flags)
   return fd;
 }
 /*---------------------------------------------------------------------------*/
-void
+int
 cfs_close(int fd)
 {
-  if(FD_VALID(fd)) {
-    coffee_fd_set[fd].flags = COFFEE_FD_FREE;
-    coffee_fd_set[fd].file->references--;
-    coffee_fd_set[fd].file = NULL;
+  int r;
+#if COFFEE_WRITE_BUFFERS > 0
+  struct write_buffer *wb;
+#endif
+
+  if(!FD_VALID(fd)) {
+    return -1;
   }
+
+  r = 0;
+#if COFFEE_WRITE_BUFFERS > 0
+  /* The descriptor is closed even if the buffered data cannot be written. */
+  wb = get_write_buffer(fd);
+  if(wb != NULL) {
+    r = flush_write_buffer(wb);
+    release_write_buffer(wb);
+  }
+#endif
+  coffee_fd_set[fd].flags = COFFEE_FD_FREE;
+  coffee_fd_set[fd].file->references--;
+  coffee_fd_set[fd].file = NULL;
+
+  return r;
 }
 /*---------------------------------------------------------------------------*/
 cfs_offset_t
@@ -1029,6 +1641,11 @@ cfs_seek(int fd, cfs_offset_t offset, int whence)
   if(!FD_VALID(fd)) {
     return -1;
   }
+#if COFFEE_WRITE_BUFFERS > 0
+  if(cfs_coffee_flush(fd) < 0) {
+    return -1;
+  }
+#endif
   fdp = &coffee_fd_set[fd];
 
   if(whence == CFS_SEEK_SET) {
@@ -1092,6 +1709,13 @@ cfs_read(int fd, void *buf, unsigned size)
     return -1;
   }
 
+#if COFFEE_WRITE_BUFFERS > 0
+  /* Reads must see the data written through the same descriptor. */
+  if(cfs_coffee_flush(fd) < 0) {
+    return -1;
+  }
+#endif
+
   fdp = &coffee_fd_set[fd];
   file = fdp->file;
 
@@ -1105,7 +1729,7 @@ cfs_read(int fd, void *buf, unsigned size)
 
   /* If the file is not modified, read directly from the file extent. */
   if(!FILE_MODIFIED(file)) {
-    COFFEE_READ(buf, size, absolute_offset(file->page, fdp->offset));
+    storage_read(buf, size, absolute_offset(file->page, fdp->offset));
     fdp->offset += size;
     return size;
   }
@@ -1126,7 +1750,7 @@ cfs_read(int fd, void *buf, unsigned size)
 
     /* Read from the original file if we cannot find the data in the log. */
     if(r < 0) {
-      COFFEE_READ(buf, lp.size, absolute_offset(file->page, fdp->offset));
+      storage_read(buf, lp.size, absolute_offset(file->page, fdp->offset));
       r = lp.size;
     }
     fdp->offset += r;
@@ -1137,8 +1761,8 @@ cfs_read(int fd, void *buf, unsigned size)
   return size;
 }
 /*---------------------------------------------------------------------------*/
-int
-cfs_write(int fd, const void *buf, unsigned size)
+static int
+write_file(int fd, const void *buf, unsigned size)
 {
   struct file_desc *fdp;
   struct file *file;
@@ -1209,7 +1833,7 @@ cfs_write(int fd, const void *buf, unsigned size)
        * corresponding end offset in the original extent to ensure that
        * the correct file size is calculated when opening the file again.
        */
-      COFFEE_WRITE(dummy, 1, absolute_offset(file->page, fdp->offset - 1));
+      storage_write(dummy, 1, absolute_offset(file->page, fdp->offset - 1));
     }
   } else {
 #endif /* COFFEE_MICRO_LOGS */
@@ -1217,7 +1841,7 @@ cfs_write(int fd, const void *buf, unsigned size)
       return -1;
     }
 
-    COFFEE_WRITE(buf, size, absolute_offset(file->page, fdp->offset));
+    storage_write(buf, size, absolute_offset(file->page, fdp->offset));
     fdp->offset += size;
 #if COFFEE_MICRO_LOGS
   }
@@ -1230,6 +1854,166 @@ cfs_write(int fd, const void *buf, unsigned size)
   return size;
 }
 /*---------------------------------------------------------------------------*/
+#if COFFEE_WRITE_BUFFERS > 0
+static int
+flush_write_buffer(struct write_buffer *wb)
+{
+  struct file_desc *fdp;
+  cfs_offset_t offset;
+  uint16_t length;
+  int r;
+
+  if(wb->length == 0) {
+    return 0;
+  }
+
+#if COFFEE_WRITE_BUFFER_TIMEOUT > 0
+  ctimer_stop(&wb->timer);
+#endif
+
+  /*
+   * The buffer is emptied while writing, because writing may cause a
+   * log merge, which reads the file and would flush the buffer again.
+   */
+  fdp = &coffee_fd_set[wb->fd];
+  offset = fdp->offset;
+  length = wb->length;
+  wb->length = 0;
+
+  fdp->offset = wb->offset;
+  r = write_file(wb->fd, wb->data, length);
+  fdp->offset = offset;
+
+  if(r == length) {
+    return 0;
+  }
+
+  /*
+   * Keep the data that was not written, so that it is not lost while the
+   * descriptor offset is already past it. A later flush tries again.
+   */
+  if(wb->used) {
+    if(r > 0) {
+      memmove(wb->data, &wb->data[r], length - r);
+      wb->offset += r;
+      length -= r;
+    }
+    wb->length = length;
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+#if COFFEE_WRITE_BUFFER_TIMEOUT > 0
+static void
+write_buffer_timeout(void *ptr)
+{
+  flush_write_buffer(ptr);
+}
+#endif /* COFFEE_WRITE_BUFFER_TIMEOUT > 0 */
+/*---------------------------------------------------------------------------*/
+/*
+ * Tells whether the buffer can take a write at the descriptor offset, the
+ * buffered data starting at the given offset. Flushing the buffer must
+ * pass the checks of write_file, and must neither extend the file nor
+ * merge its micro log, as these may fail for lack of space. Returns 1 if
+ * the write can be buffered, 0 if it must be done at once, or -1 if
+ * write_file would refuse it.
+ */
+static int
+write_bufferable(struct file_desc *fdp, cfs_offset_t start, unsigned size)
+{
+  struct file *file;
+  cfs_offset_t end;
+#if COFFEE_MICRO_LOGS
+  struct file_header hdr;
+  uint16_t log_record_size;
+  uint16_t log_records;
+  int records;
+#endif
+
+  file = fdp->file;
+  end = fdp->offset + size;
+  if(end + sizeof(struct file_header) > file->max_pages * COFFEE_PAGE_SIZE) {
+    return 0;
+  }
+#if COFFEE_MICRO_LOGS
+  if(!(fdp->io_flags & CFS_COFFEE_IO_FLASH_AWARE) &&
+     (FILE_MODIFIED(file) || start < file->end)) {
+    /* The log must have a record for each region that the data covers. */
+    read_header(&hdr, file->page);
+    if(!HDR_MODIFIED(hdr)) {
+      return 0;
+    }
+    adjust_log_config(&hdr, &log_record_size, &log_records);
+    records = (end - 1) / log_record_size - start / log_record_size + 1;
+    if(find_next_record(file, hdr.log_page, log_records) + records >
+       log_records) {
+      return 0;
+    }
+    return 1;
+  }
+#endif /* COFFEE_MICRO_LOGS */
+  if(COFFEE_APPEND_ONLY && start < file->end) {
+    return -1;
+  }
+  return 1;
+}
+#endif /* COFFEE_WRITE_BUFFERS > 0 */
+/*---------------------------------------------------------------------------*/
+int
+cfs_write(int fd, const void *buf, unsigned size)
+{
+#if COFFEE_WRITE_BUFFERS > 0
+  struct write_buffer *wb;
+  struct file_desc *fdp;
+  int bufferable;
+
+  if(!(FD_VALID(fd) && FD_WRITABLE(fd))) {
+    return -1;
+  }
+
+  wb = get_write_buffer(fd);
+  if(wb != NULL) {
+    fdp = &coffee_fd_set[fd];
+
+    /* Only a contiguous sequence of writes can be coalesced. */
+    if(wb->length > 0 &&
+       (fdp->offset != wb->offset + wb->length ||
+        wb->length + size > sizeof(wb->data))) {
+      if(flush_write_buffer(wb) < 0) {
+        return -1;
+      }
+    }
+
+    /* Writes that may fail are not buffered, but done at once. */
+    bufferable = write_bufferable(fdp, wb->length > 0 ? wb->offset : fdp->offset,
+                                  size);
+    if(bufferable < 0) {
+      return -1;
+    }
+    if(!bufferable && flush_write_buffer(wb) < 0) {
+      return -1;
+    }
+
+    if(bufferable && size <= sizeof(wb->data)) {
+      if(wb->length == 0) {
+        wb->offset = fdp->offset;
+#if COFFEE_WRITE_BUFFER_TIMEOUT > 0
+        ctimer_set(&wb->timer, COFFEE_WRITE_BUFFER_TIMEOUT,
+                   write_buffer_timeout, wb);
+#endif
+      }
+      memcpy(&wb->data[wb->length], buf, size);
+      wb->length += size;
+      fdp->offset += size;
+      return size;
+    }
+  }
+#endif /* COFFEE_WRITE_BUFFERS > 0 */
+
+  return write_file(fd, buf, size);
+}
+/*---------------------------------------------------------------------------*/
 int
 cfs_opendir(struct cfs_dir *dir, const char *name)
 {
@@ -1253,8 +2037,9 @@ cfs_readdir(struct cfs_dir *dir, struct cfs_dirent *record)
   while(page < COFFEE_PAGE_COUNT) {
     read_header(&hdr, page);
     if(HDR_ACTIVE(hdr) && !HDR_LOG(hdr)) {
-      memcpy(record->name, hdr.name, sizeof(record->name));
-      record->name[sizeof(record->name) - 1] = '\0';
+      memset(record->name, 0, sizeof(record->name));
+      memcpy(record->name, hdr.name,
+             MIN(sizeof(record->name) - 1, sizeof(hdr.name)));
       record->size = file_end(page);
 
       next_page = next_file(page, &hdr);
@@ -1312,16 +2097,75 @@ cfs_coffee_configure_log(const char *filename, unsigned log_size,
 int
 cfs_coffee_set_io_semantics(int fd, unsigned flags)
 {
+#if COFFEE_WRITE_BUFFERS > 0
+  int i;
+#endif
+
   if(!FD_VALID(fd)) {
     return -1;
   }
 
+  if(flags & CFS_COFFEE_IO_WRITE_BUFFER) {
+#if COFFEE_WRITE_BUFFERS > 0
+    if(get_write_buffer(fd) == NULL) {
+      for(i = 0; i < COFFEE_WRITE_BUFFERS && write_buffers[i].used; i++);
+      if(i == COFFEE_WRITE_BUFFERS) {
+        return -1;
+      }
+      write_buffers[i].used = 1;
+      write_buffers[i].fd = fd;
+      write_buffers[i].length = 0;
+    }
+#else
+    return -1;
+#endif
+  }
+
   coffee_fd_set[fd].io_flags |= flags;
 
   return 0;
 }
 /*---------------------------------------------------------------------------*/
 int
+cfs_coffee_flush(int fd)
+{
+#if COFFEE_WRITE_BUFFERS > 0
+  struct write_buffer *wb;
+#endif
+
+  if(!FD_VALID(fd)) {
+    return -1;
+  }
+
+#if COFFEE_WRITE_BUFFERS > 0
+  wb = get_write_buffer(fd);
+  if(wb != NULL) {
+    return flush_write_buffer(wb);
+  }
+#endif
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_coffee_sync(void)
+{
+  int result;
+#if COFFEE_WRITE_BUFFERS > 0
+  int i;
+#endif
+
+  result = 0;
+#if COFFEE_WRITE_BUFFERS > 0
+  for(i = 0; i < COFFEE_WRITE_BUFFERS; i++) {
+    if(write_buffers[i].used && flush_write_buffer(&write_buffers[i]) < 0) {
+      result = -1;
+    }
+  }
+#endif
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+int
 cfs_coffee_format(void)
 {
   coffee_page_t i;
@@ -1329,13 +2173,27 @@ cfs_coffee_format(void)
   PRINTF("Coffee: Formatting %u sectors", (unsigned)COFFEE_SECTOR_COUNT);
 
   for(i = 0; i < COFFEE_SECTOR_COUNT; i++) {
-    COFFEE_ERASE(i);
+    storage_erase(i);
     PRINTF(".");
   }
 
   /* Formatting invalidates the file information. */
   memset(&coffee_files, 0, sizeof(coffee_files));
   memset(&coffee_fd_set, 0, sizeof(coffee_fd_set));
+#if COFFEE_NAME_INDEX_SIZE > 0
+  name_index_reset(NAME_INDEX_COMPLETE);
+#endif
+#if COFFEE_HEADER_CACHE_SIZE > 0
+  memset(&header_cache, 0, sizeof(header_cache));
+#endif
+#if COFFEE_INCREMENTAL_GC
+  incremental_gc_restart();
+#endif
+#if COFFEE_WRITE_BUFFERS > 0
+  for(i = 0; i < COFFEE_WRITE_BUFFERS; i++) {
+    release_write_buffer(&write_buffers[i]);
+  }
+#endif
   next_free = 0;
   gc_wait = 1;
 
@@ -1344,3 +2202,96 @@ cfs_coffee_format(void)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+void
+cfs_coffee_get_stats(struct cfs_coffee_stats *stats)
+{
+#if COFFEE_STATS
+  memcpy(stats, &coffee_stats, sizeof(*stats));
+#else
+  memset(stats, 0, sizeof(*stats));
+#endif
+}
+/*---------------------------------------------------------------------------*/
+void
+cfs_coffee_reset_stats(void)
+{
+#if COFFEE_STATS
+  memset(&coffee_stats, 0, sizeof(coffee_stats));
+#endif
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+cfs_coffee_get_erase_count(unsigned sector)
+{
+  if(sector < COFFEE_SECTOR_COUNT) {
+    return read_erase_count(sector);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+#if COFFEE_INCREMENTAL_GC
+int
+cfs_coffee_gc_step(void)
+{
+  struct sector_status stats;
+  coffee_page_t isolation_count, reclaimable;
+  int32_t score;
+
+  if(incremental_gc.sector < COFFEE_SECTOR_COUNT) {
+    /* Scan one sector per step and remember the best erasable one. */
+    isolation_count = get_sector_status(incremental_gc.sector, &stats);
+    /* Inherited pages will be isolated again after the erasure. */
+    reclaimable = stats.obsolete - stats.inherited;
+    if(stats.active == 0 && reclaimable >= COFFEE_GC_MIN_OBSOLETE) {
+      score = ((int32_t)reclaimable << 8) / COFFEE_PAGES_PER_SECTOR -
+        (int32_t)read_erase_count(incremental_gc.sector) *
+        COFFEE_GC_WEAR_WEIGHT;
+      if(incremental_gc.candidate == INVALID_PAGE ||
+         score > incremental_gc.candidate_score) {
+        incremental_gc.candidate = incremental_gc.sector;
+        incremental_gc.candidate_isolation = isolation_count;
+        incremental_gc.candidate_inherited = stats.inherited;
+        incremental_gc.candidate_score = score;
+      }
+    }
+    incremental_gc.sector++;
+    return 1;
+  }
+
+  if(incremental_gc.candidate == INVALID_PAGE) {
+    /* Nothing is worth erasing; the next call starts a new scan. */
+    incremental_gc.sector = 0;
+    return 0;
+  }
+
+  PRINTF("Coffee: Incremental GC erases sector %u (score %ld)\n",
+         (unsigned)incremental_gc.candidate,
+         (long)incremental_gc.candidate_score);
+  erase_sector(incremental_gc.candidate, incremental_gc.candidate_isolation,
+               incremental_gc.candidate_inherited);
+  gc_wait = 0;
+  incremental_gc_restart();
+
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coffee_gc_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  incremental_gc_restart();
+
+  while(1) {
+    /* Take one step at a time, yielding to other processes in between. */
+    while(cfs_coffee_gc_step()) {
+      PROCESS_PAUSE();
+    }
+
+    /* Wait until a file removal creates new obsolete pages. */
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+  }
+
+  PROCESS_END();
+}
+#endif /* COFFEE_INCREMENTAL_GC */
+/*---------------------------------------------------------------------------*/
@@ -72,6 +72,31 @@
  */
 #define CFS_COFFEE_IO_ENSURE_READ_LENGTH		0x4
 
+/**
+ * Instruct Coffee to collect small sequential writes in a RAM buffer
+ * and to write them to the storage as one larger write. This reduces
+ * the number of micro log records for files that are modified by
+ * many small writes.
+ *
+ * Buffered data is visible to reads through the same file descriptor,
+ * but not to other file descriptors until the buffer is flushed. The
+ * buffer is flushed when it is full, when the file descriptor is read
+ * from, seeked in, or closed, and when cfs_coffee_flush() or
+ * cfs_coffee_sync() is called. Buffered data is lost if the file is
+ * removed or the system is reset before the buffer is flushed.
+ *
+ * Writes that would have to extend the file or merge its micro log are
+ * not buffered, so that a lack of space is reported by cfs_write(). If
+ * flushing still fails, the data stays in the buffer, and the read,
+ * seek, close or flush that caused the flush returns -1.
+ *
+ * Coffee must be built with COFFEE_WRITE_BUFFERS set to the number
+ * of buffers to allocate. Setting this flag fails if no buffer is free.
+ *
+ * \sa cfs_coffee_set_io_semantics(), cfs_coffee_flush()
+ */
+#define CFS_COFFEE_IO_WRITE_BUFFER		0x8
+
 /**
  * \file
  *	Header for the Coffee file system.
@@ -125,6 +150,21 @@ int cfs_coffee_configure_log(const char *file, unsigned log_size,
  */
 int cfs_coffee_set_io_semantics(int fd, unsigned flags);
 
+/**
+ * \brief Write buffered data of a file descriptor to the storage.
+ * \param fd The file descriptor.
+ * \return 0 on success, -1 on failure.
+ *
+ * \sa CFS_COFFEE_IO_WRITE_BUFFER
+ */
+int cfs_coffee_flush(int fd);
+
+/**
+ * \brief Write the buffered data of all file descriptors to the storage.
+ * \return 0 on success, -1 if any buffer could not be written.
+ */
+int cfs_coffee_sync(void);
+
 /**
  * \brief Format the storage area assigned to Coffee.
  * \return 0 on success, -1 on failure.
@@ -140,6 +180,71 @@ int cfs_coffee_set_io_semantics(int fd, unsigned flags);
  */
 int cfs_coffee_format(void);
 
+/**
+ * \brief Storage access statistics of Coffee.
+ *
+ * The counters are maintained only if Coffee is built with COFFEE_STATS
+ * set to 1. The flash accesses caused by a single file operation can be
+ * measured by resetting the counters before the operation and fetching
+ * them afterwards.
+ */
+struct cfs_coffee_stats {
+  uint32_t reads;               /**< Read requests issued to the storage. */
+  uint32_t read_bytes;          /**< Bytes read from the storage. */
+  uint32_t writes;              /**< Write requests issued to the storage. */
+  uint32_t written_bytes;       /**< Bytes written to the storage. */
+  uint32_t erases;              /**< Erased sectors. */
+  uint32_t gc_runs;             /**< Synchronous garbage collections. */
+  uint32_t header_cache_hits;   /**< Page headers found in the cache. */
+  uint32_t header_cache_misses; /**< Page headers read from the storage. */
+  uint32_t index_hits;          /**< File names found in the name index. */
+  uint32_t index_misses;        /**< File names not found in the index. */
+};
+
+/**
+ * \brief Get the storage access statistics.
+ * \param stats A pointer to a structure that receives the statistics.
+ *
+ * All counters are zero if Coffee has been built without COFFEE_STATS.
+ */
+void cfs_coffee_get_stats(struct cfs_coffee_stats *stats);
+
+/**
+ * \brief Reset the storage access statistics.
+ */
+void cfs_coffee_reset_stats(void);
+
+/**
+ * \brief Get the number of times that a sector has been erased.
+ * \param sector The sector number, counted from the start of Coffee.
+ * \return The erase count.
+ *
+ * Erase counts are stored in the first page of each sector if Coffee is
+ * built with COFFEE_SECTOR_HEADERS set to 1, which is the default when
+ * COFFEE_INCREMENTAL_GC is set to 1. They persist across reboots and
+ * formatting. Otherwise, this function returns 0.
+ */
+uint32_t cfs_coffee_get_erase_count(unsigned sector);
+
+/**
+ * \brief Take one bounded step of incremental garbage collection.
+ * \return 1 if more steps are needed, 0 if there is nothing to collect.
+ *
+ * Each step either examines the page headers of one sector or erases
+ * one sector. Sectors without active pages are selected for erasure by
+ * their share of obsolete pages and by their erase count, so that wear
+ * is spread across the storage. Without COFFEE_SECTOR_HEADERS, there are
+ * no erase counts, and sectors are selected by obsolete pages only.
+ *
+ * This function is available if Coffee is built with
+ * COFFEE_INCREMENTAL_GC set to 1. Applications may instead start
+ * coffee_gc_process, which takes steps whenever other processes are
+ * idle and sleeps until files are removed.
+ */
+int cfs_coffee_gc_step(void);
+
+PROCESS_NAME(coffee_gc_process);
+
 /** @} */
 /** @} */
 
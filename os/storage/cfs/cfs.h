@@ -173,11 +173,14 @@ int cfs_open(const char *name, int flags);
  * \brief      Close an open file.
  * \param fd   The file descriptor of the open file.
  *
+ * \return     0 on success, or -1 if data that the file system had
+ *             buffered could not be written.
+ *
  *             This function closes a file that has previously been
  *             opened with cfs_open().
  */
 #ifndef cfs_close
-void cfs_close(int fd);
+int cfs_close(int fd);
 #endif
 
 /**
@@ -153,6 +153,10 @@
 #define LOG_CONF_LEVEL_LWM2M                       LOG_LEVEL_NONE
 #endif /* LOG_CONF_LEVEL_LWM2M */
 
+#ifndef LOG_CONF_LEVEL_MQTT_SN
+#define LOG_CONF_LEVEL_MQTT_SN                     LOG_LEVEL_NONE
+#endif /* LOG_CONF_LEVEL_MQTT_SN */
+
 #ifndef LOG_CONF_LEVEL_MAIN
 #define LOG_CONF_LEVEL_MAIN                        LOG_LEVEL_INFO
 #endif /* LOG_CONF_LEVEL_MAIN */
@@ -64,6 +64,7 @@ int curr_log_level_6top = LOG_CONF_LEVEL_6TOP;
 int curr_log_level_coap = LOG_CONF_LEVEL_COAP;
 int curr_log_level_snmp = LOG_CONF_LEVEL_SNMP;
 int curr_log_level_lwm2m = LOG_CONF_LEVEL_LWM2M;
+int curr_log_level_mqtt_sn = LOG_CONF_LEVEL_MQTT_SN;
 int curr_log_level_main = LOG_CONF_LEVEL_MAIN;
 
 struct log_module all_modules[] = {
@@ -78,6 +79,7 @@ struct log_module all_modules[] = {
   {"coap", &curr_log_level_coap, LOG_CONF_LEVEL_COAP},
   {"snmp", &curr_log_level_snmp, LOG_CONF_LEVEL_SNMP},
   {"lwm2m", &curr_log_level_lwm2m, LOG_CONF_LEVEL_LWM2M},
+  {"mqtt-sn", &curr_log_level_mqtt_sn, LOG_CONF_LEVEL_MQTT_SN},
   {"main", &curr_log_level_main, LOG_CONF_LEVEL_MAIN},
   {NULL, NULL, 0},
 };
@@ -31,6 +31,7 @@
 /*---------------------------------------------------------------------------*/
 #include "contiki.h"
 #include "lib/list.h"
+#include "lib/list-index.h"
 #include "lib/stack.h"
 #include "lib/queue.h"
 #include "lib/circular-list.h"
@@ -214,6 +215,55 @@ UNIT_TEST(test_list)
   UNIT_TEST_END();
 }
 /*---------------------------------------------------------------------------*/
+static int
+element_cmp(const void *item, const void *key)
+{
+  /* The elements are sorted by their position in the array */
+  if((const demo_struct_t *)item < (const demo_struct_t *)key) {
+    return -1;
+  }
+  return (const demo_struct_t *)item > (const demo_struct_t *)key;
+}
+/*---------------------------------------------------------------------------*/
+UNIT_TEST_REGISTER(test_list_index, "Sorted list index");
+UNIT_TEST(test_list_index)
+{
+  void *found;
+  void *prev;
+  int i, length;
+
+  LIST(lst);
+  LIST_INDEX(idx, 3);
+
+  UNIT_TEST_BEGIN();
+
+  memset(elements, 0, sizeof(elements));
+  list_init(lst);
+  list_index_update(&idx, lst);
+  UNIT_TEST_ASSERT(list_index_lower_bound(&idx, lst, &elements[0],
+                                          element_cmp, &prev) == NULL);
+  UNIT_TEST_ASSERT(prev == NULL);
+
+  /* Grow the list past the index size, every other element */
+  for(length = 1; length <= ELEMENT_COUNT / 2; length++) {
+    list_add(lst, &elements[2 * (length - 1) + 1]);
+    list_index_update(&idx, lst);
+    UNIT_TEST_ASSERT(idx.count <= 3);
+    UNIT_TEST_ASSERT(idx.stride == (length + 2) / 3);
+
+    for(i = 0; i < ELEMENT_COUNT; i++) {
+      found = list_index_lower_bound(&idx, lst, &elements[i],
+                                     element_cmp, &prev);
+      /* Element i is found, or the next one in the list */
+      UNIT_TEST_ASSERT(found == (i < 2 * length ? &elements[i | 1] : NULL));
+      UNIT_TEST_ASSERT(prev == (i < 2 ? NULL :
+                                &elements[MIN((i - 2) | 1, 2 * length - 1)]));
+    }
+  }
+
+  UNIT_TEST_END();
+}
+/*---------------------------------------------------------------------------*/
 UNIT_TEST_REGISTER(test_stack, "Stack Push/Pop");
 UNIT_TEST(test_stack)
 {
@@ -1034,6 +1084,7 @@ PROCESS_THREAD(data_structure_test_process, ev, data)
   memset(elements, 0, sizeof(elements));
 
   UNIT_TEST_RUN(test_list);
+  UNIT_TEST_RUN(test_list_index);
   UNIT_TEST_RUN(test_stack);
   UNIT_TEST_RUN(test_queue);
   UNIT_TEST_RUN(test_csll);
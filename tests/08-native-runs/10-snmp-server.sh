@@ -65,6 +65,22 @@ test_handler "snmpbulkget -v2c -Cn2 -c public udp6:[$IPADDR]:161 1 1" "iso\.3\.6
 test_handler "snmpbulkget -t2 -v2c -Cr2 -c public udp6:[$IPADDR]:161 1" "iso\.3\.6\.1\.2\.1\.1\.1\.0.*iso\.3\.6\.1\.2\.1\.1\.2\.0"
 ## snmpbulkget one non-repeater and two max-repetitions - pass
 test_handler "snmpbulkget -t2 -v2c -Cn1 -Cr2 -c public udp6:[$IPADDR]:161 1 1" "iso\.3\.6\.1\.2\.1\.1\.1\.0.*iso\.3\.6\.1\.2\.1\.1\.1\.0.*iso\.3\.6\.1\.2\.1\.1\.2\.0"
+## snmpbulkget more max-repetitions than SNMP_MAX_NR_VALUES - pass
+test_handler "snmpbulkget -t2 -v2c -Cr10 -c public udp6:[$IPADDR]:161 1" "iso\.3\.6\.1\.2\.1\.1\.1\.0.*iso\.3\.6\.1\.2\.1\.1\.4\.0.*iso\.3\.6\.1\.2\.1\.1\.7\.0.*No more variables left"
+## snmpbulkwalk - pass
+test_handler "snmpbulkwalk -t2 -v2c -Cr8 -c public udp6:[$IPADDR]:161 1" "iso\.3\.6\.1\.2\.1\.1\.1\.0.*iso\.3\.6\.1\.2\.1\.1\.2\.0.*iso\.3\.6\.1\.2\.1\.1\.3\.0.*iso\.3\.6\.1\.2\.1\.1\.4\.0.*iso\.3\.6\.1\.2\.1\.1\.5\.0.*iso\.3\.6\.1\.2\.1\.1\.6\.0.*iso\.3\.6\.1\.2\.1\.1\.7\.0"
+
+## snmpbulkwalk - fewer round trips than snmpwalk over the same subtree
+compare_walks () {
+  # With -d, every request sent is dumped after a "Sending" line
+  WALK=$(snmpwalk -d -t2 -v2c -c public udp6:[$IPADDR]:161 1.3.6.1.2.1.1 2>&1 | grep -c "^Sending")
+  BULK=$(snmpbulkwalk -d -t2 -v2c -Cr8 -c public udp6:[$IPADDR]:161 1.3.6.1.2.1.1 2>&1 | grep -c "^Sending")
+  echo "snmpwalk requests $WALK, snmpbulkwalk requests $BULK"
+  if [ $BULK -ge 1 ] && [ $BULK -lt $WALK ] ; then
+    echo "snmpbulkwalk needs fewer round trips"
+  fi
+}
+test_handler compare_walks "snmpbulkwalk needs fewer round trips"
 
 ## snmpget - fail - noSuchName
 test_handler "snmpget -t2 -v2c -c public udp6:[$IPADDR]:161 1.3.6.1.2.1.1.1" ".*No Such Instance currently.*"
@@ -0,0 +1,54 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/storage/cfs-coffee
+CODE=test-coffee
+
+# Coffee uses the emulated external memory on the native platform
+echo "Starting native node"
+make -C $CODE_DIR TARGET=native > make.log 2> make.err
+$CODE_DIR/$CODE.native > $CODE.log 2> $CODE.err &
+CPID=$!
+$CODE_DIR/coffee-gc-sim.native > coffee-gc-sim.log 2> coffee-gc-sim.err &
+SPID=$!
+$CODE_DIR/coffee-log-sim.native > coffee-log-sim.log 2> coffee-log-sim.err &
+LPID=$!
+sleep 5
+
+echo "Closing native nodes"
+kill_bg $CPID
+kill_bg $SPID
+kill_bg $LPID
+
+if grep -q "ERROR" $CODE.log || ! grep -q "Coffee test finished" $CODE.log || \
+   ! grep -q "failures 0" coffee-gc-sim.log || \
+   ! grep -q "failures 0" coffee-log-sim.log ; then
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log;
+  echo "==== $CODE.err ====" ; cat $CODE.err;
+  echo "==== coffee-gc-sim.log ====" ; cat coffee-gc-sim.log;
+  echo "==== coffee-log-sim.log ====" ; cat coffee-log-sim.log;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+else
+  cat $CODE.log coffee-gc-sim.log coffee-log-sim.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log
+rm $CODE.err
+rm coffee-gc-sim.log
+rm coffee-gc-sim.err
+rm coffee-log-sim.log
+rm coffee-log-sim.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
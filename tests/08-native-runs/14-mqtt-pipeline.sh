@@ -0,0 +1,77 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/mqtt-pipeline
+CODE=mqtt-pipeline
+
+# The persistent queue of the client is kept in the working directory
+PERSIST_FILE=mqtt-pipeline
+rm -f $PERSIST_FILE
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native > make.log 2> make.err
+
+# First run: the broker stand-in drops the connection at the 10th message
+# and stops acknowledging after the 30th. The client reconnects and sends
+# the unacknowledged messages again, and is stopped with messages pending.
+echo "Starting broker stand-in and native node"
+python3 $CODE_DIR/broker-stub.py --drop-at 10 --ack-limit 30 > broker-1.log 2> broker-1.err &
+BPID=$!
+sleep 1
+sudo $CODE_DIR/$CODE.native > $CODE-1.log 2> $CODE-1.err &
+CPID=$!
+sleep 5
+
+echo "Stopping native node and broker stand-in"
+kill_bg $CPID SIGTERM
+kill_bg $BPID SIGTERM
+sleep 1
+
+# Second run: the client restores the pending messages from the file system
+# and all messages are acknowledged.
+echo "Restarting broker stand-in and native node"
+python3 $CODE_DIR/broker-stub.py > broker-2.log 2> broker-2.err &
+BPID=$!
+sleep 1
+sudo $CODE_DIR/$CODE.native > $CODE-2.log 2> $CODE-2.err &
+CPID=$!
+sleep 5
+
+echo "Stopping native node and broker stand-in"
+kill_bg $CPID SIGTERM
+kill_bg $BPID SIGTERM
+sleep 1
+
+# Success criteria:
+# * The first run reconnected and retransmitted messages with the DUP flag
+# * The second run restored messages and got all acknowledgements
+RESTORED=`sed -rn "s/^Restored ([0-9]+) messages/\1/p" $CODE-2.log`
+if grep -q "connections 2 .* duplicates [1-9]" broker-1.log && \
+   [ -n "$RESTORED" ] && [ "$RESTORED" -gt 0 ] && \
+   grep -q "MQTT pipeline finished, errors 0" $CODE-2.log ; then
+  cat broker-1.log $CODE-2.log broker-2.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE-1.log ====" ; cat $CODE-1.log;
+  echo "==== broker-1.log ====" ; cat broker-1.log broker-1.err;
+  echo "==== $CODE-2.log ====" ; cat $CODE-2.log;
+  echo "==== broker-2.log ====" ; cat broker-2.log broker-2.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE-1.log $CODE-1.err $CODE-2.log $CODE-2.err
+rm broker-1.log broker-1.err broker-2.log broker-2.err
+rm -f $PERSIST_FILE
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,53 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/mqtt-stream
+CODE=mqtt-stream
+
+# The broker stand-in publishes this many bytes to the node
+PAYLOAD_SIZE=100000
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native > make.log 2> make.err
+
+echo "Starting broker stand-in and native node"
+python3 $CONTIKI/examples/mqtt-pipeline/broker-stub.py \
+  --publish-size $PAYLOAD_SIZE > broker.log 2> broker.err &
+BPID=$!
+sleep 1
+sudo $CODE_DIR/$CODE.native > $CODE.log 2> $CODE.err &
+CPID=$!
+sleep 5
+
+echo "Stopping native node and broker stand-in"
+kill_bg $CPID SIGTERM
+kill_bg $BPID SIGTERM
+sleep 1
+
+# Success criteria:
+# * The whole payload was received in order and with the expected content
+if grep -q "Received $PAYLOAD_SIZE bytes" $CODE.log && \
+   grep -q "MQTT stream finished, errors 0" $CODE.log ; then
+  cat $CODE.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+  echo "==== broker.log ====" ; cat broker.log broker.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+rm broker.log broker.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
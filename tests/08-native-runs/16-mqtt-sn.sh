@@ -0,0 +1,53 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/mqtt-sn
+CODE=mqtt-sn-client
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native > make.log 2> make.err
+
+# The gateway stand-in does not acknowledge every 4th QoS 1 message, so that
+# the client retransmits them
+echo "Starting gateway stand-in and native node"
+python3 $CODE_DIR/gateway-stub.py --drop-every 4 > gateway.log 2> gateway.err &
+GPID=$!
+sleep 1
+sudo $CODE_DIR/$CODE.native > $CODE.log 2> $CODE.err &
+CPID=$!
+sleep 8
+
+echo "Stopping native node and gateway stand-in"
+kill_bg $CPID SIGTERM
+kill_bg $GPID SIGTERM
+sleep 1
+
+# Success criteria:
+# * The client went through its workload without errors
+# * The gateway got the QoS -1 message and the retransmitted messages, and
+#   delivered the buffered message when the client woke up
+if grep -q "MQTT-SN client finished, errors 0" $CODE.log && \
+   grep -q "qos-1 1 .* duplicates [1-9] .* wakes 1 buffered 1" gateway.log ; then
+  cat $CODE.log gateway.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+  echo "==== gateway.log ====" ; cat gateway.log gateway.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+rm gateway.log gateway.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,47 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/lwm2m-ipso-objects
+CODE=example-ipso-objects
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native > make.log 2> make.err
+
+echo "Starting native node"
+sudo $CODE_DIR/$CODE.native > $CODE.log 2> $CODE.err &
+CPID=$!
+sleep 2
+
+# The node runs without a LWM2M server. The client reads, writes and
+# observes resources of the node with the composite operations.
+echo "Running composite client"
+python3 $CODE_DIR/composite-client.py > client.log 2> client.err
+
+echo "Stopping native node"
+kill_bg $CPID SIGTERM
+sleep 1
+
+if grep -q "Composite client finished, errors 0" client.log ; then
+  cat $CODE.log client.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+  echo "==== client.log ====" ; cat client.log client.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+rm client.log client.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
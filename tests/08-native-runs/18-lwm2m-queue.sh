@@ -0,0 +1,63 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/lwm2m-ipso-objects
+CODE=example-ipso-objects
+
+# Queue Mode that holds the notifications until the regular update
+DEFINES=LWM2M_QUEUE_MODE_CONF_ENABLED=1
+DEFINES=$DEFINES,LWM2M_NOTIFICATION_QUEUE_CONF_WAKE_UP=0
+DEFINES=$DEFINES,LWM2M_QUEUE_MODE_CONF_DEFAULT_CLIENT_SLEEP_TIME=20000
+DEFINES=$DEFINES,LWM2M_QUEUE_MODE_CONF_DEFAULT_CLIENT_AWAKE_TIME=2000
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native DEFINES=$DEFINES > make.log 2> make.err
+
+# The server stand-in observes the temperature and a composite of it
+# while the node is awake. The changes held during the sleep should
+# give one notification for each observation at the next update.
+echo "Starting server stand-in"
+python3 $CODE_DIR/server-stub.py --duration 50 > server.log 2> server.err &
+SPID=$!
+sleep 1
+
+echo "Starting native node"
+sudo $CODE_DIR/$CODE.native > $CODE.log 2> $CODE.err &
+CPID=$!
+
+wait $SPID
+
+echo "Stopping native node"
+kill_bg $CPID SIGTERM
+sleep 1
+
+SUMMARY=$(grep "Server stand-in:" server.log)
+read -r REGISTRATIONS UPDATES NOTIFICATIONS COMPOSITE MAX_PER_WAKE <<< \
+  $(echo "$SUMMARY" | awk '{ print $4, $6, $8, $10, $16 }')
+
+if [ "$REGISTRATIONS" == "1" ] && [ "${UPDATES:-0}" -ge 2 ] &&
+   [ "${NOTIFICATIONS:-0}" -ge 1 ] && [ "${COMPOSITE:-0}" -ge 1 ] &&
+   [ "${MAX_PER_WAKE:-9}" -le 2 ] ; then
+  cat $CODE.log server.log > $CODE-queue.testlog
+  printf "%-32s TEST OK\n" "$CODE-queue" | tee $CODE-queue.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+  echo "==== server.log ====" ; cat server.log server.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE-queue" | tee $CODE-queue.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+rm server.log server.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,56 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/resolv-cache
+CODE=resolv-cache
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native > make.log 2> make.err
+
+# The node asks the DNS stand-in for each name once. The repeated
+# queries are answered from the cache, except for the expired record
+# of short.example.
+echo "Starting DNS stand-in"
+python3 $CODE_DIR/dns-stub.py --duration 15 > dns.log 2> dns.err &
+SPID=$!
+sleep 1
+
+echo "Starting native node"
+sudo $CODE_DIR/$CODE.native > $CODE.log 2> $CODE.err &
+CPID=$!
+
+wait $SPID
+
+echo "Stopping native node"
+kill_bg $CPID SIGTERM
+sleep 1
+
+BROKER=$(grep -c "Question: broker.example AAAA" dns.log)
+SHORT=$(grep -c "Question: short.example AAAA" dns.log)
+
+if grep -q "Resolver cache test finished, errors 0" $CODE.log &&
+   grep -q "DNS stand-in: questions 26 A 13 AAAA 13" dns.log &&
+   [ "$BROKER" == "1" ] && [ "$SHORT" == "2" ] ; then
+  cat $CODE.log dns.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+  echo "==== dns.log ====" ; cat dns.log dns.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+rm dns.log dns.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
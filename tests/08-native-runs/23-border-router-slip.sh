@@ -0,0 +1,59 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/rpl-border-router
+CODE=border-router
+
+FRAMES=20000
+
+echo "Building native border router"
+make -C $CODE_DIR -B TARGET=native > make.log 2> make.err
+
+# The radio stand-in sends its MAC address, with SLIP END and ESC bytes,
+# and then a bulk of frames that the border router counts and ignores
+echo "Starting radio stand-in"
+python3 $CODE_DIR/slip-radio-stub.py --port 60001 --frames $FRAMES \
+  --duration 12 > radio.log 2> radio.err &
+SPID=$!
+sleep 1
+
+echo "Starting native border router"
+(sleep 8; echo "?S"; sleep 2) | \
+  sudo $CODE_DIR/$CODE.native -a localhost -p 60001 fd00::1/64 \
+  > $CODE.log 2> $CODE.err &
+CPID=$!
+
+wait $SPID
+
+echo "Stopping native border router"
+kill_bg $CPID SIGTERM
+sleep 1
+
+RECEIVED=$(sed -n 's/.*frames received over SLIP: \([0-9]*\), dropped 0.*/\1/p' $CODE.log)
+
+if grep -q "fe80::212:c0db:102:304" $CODE.log &&
+   grep -q "Radio stand-in: .* mac-requests 1 sent $FRAMES" radio.log &&
+   [ -n "$RECEIVED" ] && [ "$RECEIVED" -gt "$FRAMES" ] ; then
+  cat $CODE.log radio.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+  echo "==== radio.log ====" ; cat radio.log radio.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+rm radio.log radio.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,84 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/tcp-bench
+CODE=tcp-bench
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native DEFINES=TCP_BENCH_CONF_LOSS=50 \
+  > make.log 2> make.err
+
+echo "Starting native node"
+sudo $CODE_DIR/$CODE.native > $CODE.log 2> $CODE.err &
+CPID=$!
+sleep 2
+
+# The node drops every 50th data segment that it sends or receives;
+# all the connections must deliver every byte in order
+echo "Receiving from native node"
+python3 $CODE_DIR/tcp-sink.py --port 8080 --bytes 1048576 \
+  > sink.log 2> sink.err
+python3 $CODE_DIR/tcp-sink.py --port 8081 --bytes 65536 \
+  >> sink.log 2>> sink.err
+
+echo "Sending to native node"
+python3 $CODE_DIR/tcp-source.py --port 8082 --bytes 1048576 \
+  > source.log 2> source.err
+python3 $CODE_DIR/tcp-source.py --port 8083 --bytes 65536 \
+  >> source.log 2>> source.err
+
+echo "Stopping native node"
+kill_bg $CPID SIGTERM
+sleep 1
+
+# The throughput of a port, in kB/s
+rate () {
+  sed -n "s/^TCP benchmark: port $1 .* \([0-9]*\) kB\/s.*/\1/p" $CODE.log
+}
+
+# The windowed connections must be at least twice as fast as the
+# single-segment ones, in both directions
+FAST=0
+SENT_WINDOW=$(rate 8080)
+SENT_SINGLE=$(rate 8081)
+RECEIVED_WINDOW=$(rate 8082)
+RECEIVED_SINGLE=$(rate 8083)
+if [ -n "$SENT_WINDOW" ] && [ -n "$SENT_SINGLE" ] &&
+   [ -n "$RECEIVED_WINDOW" ] && [ -n "$RECEIVED_SINGLE" ] &&
+   [ $SENT_WINDOW -ge $((SENT_SINGLE * 2)) ] &&
+   [ $RECEIVED_WINDOW -ge $((RECEIVED_SINGLE * 2)) ] ; then
+  FAST=1
+fi
+
+if [ $FAST -eq 1 ] &&
+   grep -q "Sink: port 8080 received 1048576 bytes .* errors 0" sink.log &&
+   grep -q "Sink: port 8081 received 65536 bytes .* errors 0" sink.log &&
+   grep -q "TCP benchmark: port 8080 window 8 sent 1048576 " $CODE.log &&
+   grep -q "TCP benchmark: port 8081 window 1 sent 65536 " $CODE.log &&
+   grep -q "TCP benchmark: port 8082 received 1048576 bytes .* errors 0," $CODE.log &&
+   grep -q "TCP benchmark: port 8083 received 65536 bytes .* errors 0," $CODE.log ; then
+  cat $CODE.log sink.log source.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+  echo "==== sink.log ====" ; cat sink.log sink.err;
+  echo "==== source.log ====" ; cat source.log source.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+rm sink.log sink.err
+rm source.log source.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,46 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/rpl-bench
+CODE=rpl-parent-bench
+
+# The benchmark does not need the tun interface; run it with both OFs
+for OF in 0 1; do
+  echo "Building native node, OF0 $OF"
+  make -C $CODE_DIR -B TARGET=native DEFINES=RPL_BENCH_OF0=$OF >> make.log 2>> make.err
+
+  echo "Starting native node"
+  $CODE_DIR/$CODE.native > $CODE-$OF.log 2>> $CODE.err &
+  CPID=$!
+  for i in $(seq 1 30); do
+    grep -q "RPL parent bench: done" $CODE-$OF.log && break
+    sleep 1
+  done
+  kill_bg $CPID
+  cat $CODE-$OF.log >> $CODE.log
+  rm $CODE-$OF.log
+done
+
+if [ $(grep -c "RPL parent bench: 48 neighbors, joined 1" $CODE.log) -eq 2 ] &&
+   [ $(grep -c "RPL parent bench: stale 0, mismatches 0" $CODE.log) -eq 2 ] ; then
+  grep "RPL parent bench" $CODE.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
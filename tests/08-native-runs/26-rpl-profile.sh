@@ -0,0 +1,55 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/libs/shell
+CODE=rpl-profile
+
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native > make.log 2> make.err
+
+# The node is a DAG root driven through the shell. It counts its DIOs
+# with the default Trickle parameters, then with a shorter Imin and
+# fewer doublings. It does not need the tun interface. A DAO delay that
+# does not fit in clock ticks is refused.
+echo "Running native node"
+(sleep 1; echo "rpl-set-root 1"; sleep 2; echo "rpl-stats reset"; sleep 5
+ echo "rpl-stats reset"
+ echo "rpl-profile dio 8 2 0"; echo "rpl-profile dao-delay 500"; sleep 5
+ echo "rpl-stats"; echo "rpl-profile dio 30 10 0"; echo "rpl-profile probing x"
+ echo "rpl-profile dao-delay 18446744073709600"
+ sleep 1) | $CODE_DIR/example.native > $CODE.log 2> $CODE.err &
+CPID=$!
+sleep 16
+kill_bg $CPID
+
+# DIOs sent in each period
+DIOS=$(grep -- "-- DIO    : sent" $CODE.log | sed 's/.*sent \([0-9]*\)\/.*/\1/' | tr '\n' ' ')
+echo "DIOs sent: $DIOS"
+set -- $DIOS
+
+if [ $# -eq 3 ] && [ $2 -le 2 ] && [ $3 -ge 4 ] &&
+   grep -q -- "-- DAG Trickle: Imin 8, doublings 2, redundancy 0" $CODE.log &&
+   grep -q -- "-- DAO delay: 500 ms" $CODE.log &&
+   [ $(grep -c "Value out of range" $CODE.log) -eq 2 ] &&
+   grep -q "Invalid value: x" $CODE.log ; then
+  grep -- "^--\|RPL" $CODE.log > $CODE.testlog
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
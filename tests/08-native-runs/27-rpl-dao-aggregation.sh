@@ -0,0 +1,51 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/rpl-bench/dao-aggregation
+CODE=rpl-dao-bench
+
+# The benchmark does not need the tun interface; run it without and with
+# DAO aggregation
+for AGG in 0 1; do
+  echo "Building native node, DAO aggregation $AGG"
+  make -C $CODE_DIR -B TARGET=native DEFINES=RPL_CONF_WITH_DAO_AGGREGATION=$AGG >> make.log 2>> make.err
+
+  echo "Starting native node"
+  $CODE_DIR/$CODE.native > $CODE-$AGG.log 2>> $CODE.err &
+  CPID=$!
+  for i in $(seq 1 60); do
+    grep -q "RPL DAO bench: done" $CODE-$AGG.log && break
+    sleep 1
+  done
+  kill_bg $CPID
+  cat $CODE-$AGG.log >> $CODE.log
+  rm $CODE-$AGG.log
+done
+
+# Every target reaches the parent and every child DAO is acknowledged once,
+# with fewer control packets when the DAOs are aggregated
+PACKETS=($(sed -n 's/^RPL DAO bench: \([0-9]*\) control packets.*/\1/p' $CODE.log))
+
+if [ $(grep -c "RPL DAO bench: .*joined 1" $CODE.log) -eq 2 ] &&
+   [ $(grep -c "RPL DAO bench: routes 36/36, unacked 0, lost 0" $CODE.log) -eq 2 ] &&
+   [ ${#PACKETS[@]} -eq 2 ] && [ ${PACKETS[1]} -lt ${PACKETS[0]} ] ; then
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,44 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/rpl-bench/multi-instance
+CODE=rpl-instance-bench
+
+# The benchmark does not need the tun interface
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native >> make.log 2>> make.err
+
+echo "Starting native node"
+$CODE_DIR/$CODE.native > $CODE.log 2>> $CODE.err &
+CPID=$!
+for i in $(seq 1 30); do
+  grep -q "RPL instance bench: done" $CODE.log && break
+  sleep 1
+done
+kill_bg $CPID
+
+# Both instances are joined with their own OF and parent, and packets go
+# through the instance of their DSCP, flow label or hop-by-hop option
+if grep -q "RPL instance bench: 2 instances, joined 1" $CODE.log &&
+   [ $(grep -c "RPL instance bench: .* ok$" $CODE.log) -eq 11 ] &&
+   grep -q "RPL instance bench: 0 failures" $CODE.log ; then
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0
@@ -0,0 +1,44 @@
+#!/bin/bash
+source ../utils.sh
+
+# Contiki directory
+CONTIKI=$1
+
+# Example code directory
+CODE_DIR=$CONTIKI/examples/rpl-bench/fast-repair
+CODE=rpl-repair-bench
+
+# The benchmark does not need the tun interface
+echo "Building native node"
+make -C $CODE_DIR -B TARGET=native >> make.log 2>> make.err
+
+echo "Starting native node"
+$CODE_DIR/$CODE.native > $CODE.log 2>> $CODE.err &
+CPID=$!
+for i in $(seq 1 30); do
+  grep -q "RPL repair bench: done" $CODE.log && break
+  sleep 1
+done
+kill_bg $CPID
+
+# The node switches to the backup parent after the NOACKs, and the packets
+# queued for the dead parent go to the backup parent
+if [ $(grep -c "RPL repair bench: .* ok$" $CODE.log) -eq 7 ] &&
+   grep -q "RPL repair bench: requeued 3 packets" $CODE.log &&
+   grep -q "RPL repair bench: 0 failures" $CODE.log ; then
+  printf "%-32s TEST OK\n" "$CODE" | tee $CODE.testlog;
+else
+  echo "==== make.log ====" ; cat make.log;
+  echo "==== make.err ====" ; cat make.err;
+  echo "==== $CODE.log ====" ; cat $CODE.log $CODE.err;
+
+  printf "%-32s TEST FAIL\n" "$CODE" | tee $CODE.testlog;
+fi
+
+rm make.log
+rm make.err
+rm $CODE.log $CODE.err
+
+# We do not want Make to stop -> Return 0
+# The Makefile will check if a log contains FAIL at the end
+exit 0